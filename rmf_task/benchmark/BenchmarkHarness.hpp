@@ -0,0 +1,342 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__BENCHMARK__BENCHMARKHARNESS_HPP
+#define RMF_TASK__BENCHMARK__BENCHMARKHARNESS_HPP
+
+// The measurements, JSON records and baseline checks that the planner
+// benchmarks share. This replaces the global operator new unless
+// RMF_TASK_COUNT_ALLOCATIONS is defined, so each benchmark executable must
+// include it in only one of its source files.
+
+#include <rmf_task/AllocationCounter.hpp>
+#include <rmf_task/TaskPlanner.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef RMF_TASK_COUNT_ALLOCATIONS
+namespace {
+
+//==============================================================================
+/// rmf_task already replaces operator new, so its counters are used instead
+std::size_t count_allocations()
+{
+  return rmf_task::AllocationCounter::all_threads().total_allocations();
+}
+
+} // anonymous namespace
+#else
+namespace {
+
+//==============================================================================
+/// The number of times that operator new has been called by the process
+std::atomic_size_t allocations = 0;
+
+//==============================================================================
+std::size_t count_allocations()
+{
+  return allocations.load();
+}
+
+} // anonymous namespace
+
+//==============================================================================
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size))
+    return ptr;
+
+  throw std::bad_alloc();
+}
+
+//==============================================================================
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+//==============================================================================
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+#endif // RMF_TASK_COUNT_ALLOCATIONS
+
+namespace {
+
+//==============================================================================
+/// What was measured while planning one problem with one mode
+struct Measurement
+{
+  double median_seconds = 0.0;
+  double min_seconds = 0.0;
+  double cost = 0.0;
+  bool solved = false;
+  std::size_t nodes_expanded = 0;
+  std::size_t peak_open_nodes = 0;
+  std::size_t finish_estimates = 0;
+  std::size_t travel_misses = 0;
+
+  /// The number of heap allocations made by one call to plan()
+  std::size_t allocations = 0;
+
+  /// Peak resident memory in KiB, or 0 if it cannot be measured here
+  std::size_t peak_memory_kib = 0;
+};
+
+//==============================================================================
+/// Reset the peak resident memory of the process so that the next reading
+/// only covers what happens after this call. Linux supports this since 4.0.
+void reset_peak_memory()
+{
+#ifdef __linux__
+  std::ofstream clear_refs("/proc/self/clear_refs");
+  if (clear_refs)
+    clear_refs << "5";
+#endif
+}
+
+//==============================================================================
+std::size_t peak_memory_kib()
+{
+#ifdef __linux__
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line))
+  {
+    if (line.rfind("VmHWM:", 0) != 0)
+      continue;
+
+    std::istringstream value(line.substr(6));
+    std::size_t kib = 0;
+    value >> kib;
+    return kib;
+  }
+#endif
+
+  return 0;
+}
+
+//==============================================================================
+/// Plan a problem repetitions times and measure each call to plan()
+Measurement measure(
+  const rmf_task::TaskPlanner::Configuration& config,
+  const rmf_task::TaskPlanner::Options& options,
+  const rmf_traffic::Time now,
+  const std::vector<rmf_task::State>& states,
+  const std::vector<rmf_task::ConstRequestPtr>& requests,
+  const std::size_t repetitions)
+{
+  Measurement m;
+  std::vector<double> seconds;
+  for (std::size_t i = 0; i < repetitions; ++i)
+  {
+    // A fresh planner each time so every repetition begins with a cold travel
+    // estimate cache, like the first plan of a new fleet adapter
+    rmf_task::TaskPlanner planner(config, options);
+
+    reset_peak_memory();
+    const std::size_t allocations_before = count_allocations();
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = planner.plan(now, states, requests);
+    const auto finish = std::chrono::steady_clock::now();
+    seconds.push_back(std::chrono::duration<double>(finish - start).count());
+    m.allocations = count_allocations() - allocations_before;
+
+    const auto* assignments =
+      std::get_if<rmf_task::TaskPlanner::Assignments>(&result);
+    m.solved = assignments != nullptr;
+    m.cost = assignments ? planner.compute_cost(*assignments) : 0.0;
+
+    const auto& stats = planner.statistics();
+    m.nodes_expanded = stats.nodes_expanded();
+    m.peak_open_nodes = stats.peak_open_nodes();
+    m.finish_estimates = stats.finish_estimates();
+    m.travel_misses = stats.travel_estimates().misses();
+    m.peak_memory_kib = std::max(m.peak_memory_kib, peak_memory_kib());
+  }
+
+  std::sort(seconds.begin(), seconds.end());
+  m.median_seconds = seconds[seconds.size()/2];
+  m.min_seconds = seconds.front();
+  return m;
+}
+
+//==============================================================================
+/// Write one measurement as a JSON object on a single line
+std::string to_json(
+  const std::string& problem,
+  const std::string& mode,
+  const Measurement& m)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"problem\": \"" << problem << "\""
+       << ", \"mode\": \"" << mode << "\""
+       << ", \"solved\": " << (m.solved ? "true" : "false")
+       << ", \"median_ms\": " << 1e3*m.median_seconds
+       << ", \"min_ms\": " << 1e3*m.min_seconds
+       << ", \"nodes_expanded\": " << m.nodes_expanded
+       << ", \"peak_open_nodes\": " << m.peak_open_nodes
+       << ", \"finish_estimates\": " << m.finish_estimates
+       << ", \"travel_misses\": " << m.travel_misses
+       << ", \"allocations\": " << m.allocations
+       << ", \"peak_memory_kib\": " << m.peak_memory_kib
+       << ", \"cost\": " << m.cost << "}";
+  return json.str();
+}
+
+//==============================================================================
+/// Read the flat JSON objects that to_json() writes, one per line, keyed by
+/// "<problem>/<mode>". Values are kept as the text that was written.
+using Record = std::map<std::string, std::string>;
+std::map<std::string, Record> read_json(const std::string& path)
+{
+  std::map<std::string, Record> records;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line))
+  {
+    Record record;
+    std::size_t pos = 0;
+    while ((pos = line.find('"', pos)) != std::string::npos)
+    {
+      const std::size_t key_end = line.find('"', pos + 1);
+      const std::size_t colon = line.find(':', key_end);
+      if (key_end == std::string::npos || colon == std::string::npos)
+        break;
+
+      const std::string key = line.substr(pos + 1, key_end - pos - 1);
+      std::size_t value_end = line.find_first_of(",}", colon);
+      if (value_end == std::string::npos)
+        value_end = line.size();
+
+      std::string value = line.substr(colon + 1, value_end - colon - 1);
+      value.erase(0, value.find_first_not_of(" \""));
+      value.erase(value.find_last_not_of(" \"") + 1);
+      record[key] = value;
+      pos = value_end;
+    }
+
+    if (record.count("problem") && record.count("mode"))
+      records[record["problem"] + "/" + record["mode"]] = std::move(record);
+  }
+
+  return records;
+}
+
+//==============================================================================
+/// Compare a measurement against its baseline. Each metric that grew by more
+/// than max_slowdown times is described in the returned list. Times below a
+/// millisecond are too noisy to compare and are skipped.
+std::vector<std::string> find_regressions(
+  const Record& baseline,
+  const Measurement& m,
+  const double max_slowdown)
+{
+  std::vector<std::string> regressions;
+  const auto solved = baseline.find("solved");
+  if (solved != baseline.end() && solved->second == "true" && !m.solved)
+    regressions.push_back("no longer solved");
+
+  const auto check = [&](const char* key, double value, double floor)
+    {
+      const auto it = baseline.find(key);
+      if (it == baseline.end())
+        return;
+
+      const double before = std::stod(it->second);
+      if (value > floor && value > max_slowdown * before)
+      {
+        std::ostringstream msg;
+        msg << key << " went from " << before << " to " << value;
+        regressions.push_back(msg.str());
+      }
+    };
+
+  check("median_ms", 1e3*m.median_seconds, 1.0);
+  check("nodes_expanded", m.nodes_expanded, 0.0);
+  check("finish_estimates", m.finish_estimates, 0.0);
+  check("allocations", m.allocations, 0.0);
+  return regressions;
+}
+
+//==============================================================================
+void print_header()
+{
+  std::cout << std::left << std::setw(28) << "problem"
+            << std::setw(9) << "mode"
+            << std::right << std::setw(12) << "median_ms"
+            << std::setw(12) << "min_ms"
+            << std::setw(10) << "expanded"
+            << std::setw(10) << "peak_open"
+            << std::setw(10) << "estimates"
+            << std::setw(10) << "misses"
+            << std::setw(12) << "peak_kib"
+            << std::setw(12) << "cost" << std::endl;
+}
+
+//==============================================================================
+void print_row(
+  const std::string& problem,
+  const std::string& mode,
+  const Measurement& m)
+{
+  std::cout << std::left << std::setw(28) << problem
+            << std::setw(9) << mode
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(12) << 1e3*m.median_seconds
+            << std::setw(12) << 1e3*m.min_seconds
+            << std::setw(10) << m.nodes_expanded
+            << std::setw(10) << m.peak_open_nodes
+            << std::setw(10) << m.finish_estimates
+            << std::setw(10) << m.travel_misses
+            << std::setw(12) << m.peak_memory_kib
+            << std::setw(12);
+
+  if (m.solved)
+    std::cout << m.cost << std::endl;
+  else
+    std::cout << "unsolved" << std::endl;
+}
+
+//==============================================================================
+/// Write the JSON records of a run as an array with one record per line
+void write_json(const std::string& path, const std::vector<std::string>& lines)
+{
+  std::ofstream json(path);
+  json << "[\n";
+  for (std::size_t i = 0; i < lines.size(); ++i)
+    json << "  " << lines[i] << (i + 1 < lines.size() ? ",\n" : "\n");
+  json << "]\n";
+}
+
+} // anonymous namespace
+
+#endif // RMF_TASK__BENCHMARK__BENCHMARKHARNESS_HPP
@@ -0,0 +1,343 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/BackupFileManager.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Measures how quickly BackupFileManager writes the backups of a fleet, so
+// that storage can be sized for it. Each configuration writes the same
+// sequence of backups, so runs on different machines or directories can be
+// compared. Give one --dir on tmpfs (e.g. /dev/shm) and one on a real disk to
+// tell the cost of the storage apart from the cost of the manager itself.
+
+namespace {
+
+//==============================================================================
+/// One combination of the parameters that is measured
+struct Configuration
+{
+  std::filesystem::path directory;
+  std::size_t robots = 1;
+  bool asynchronous = false;
+};
+
+//==============================================================================
+/// The parameters that every configuration shares
+struct Settings
+{
+  std::vector<std::filesystem::path> directories;
+  std::vector<std::size_t> robots = {1, 10, 50, 100, 200};
+  std::size_t writes_per_robot = 20;
+  std::size_t state_bytes = 4096;
+  rmf_task::BackupFileManager::Durability durability =
+    rmf_task::BackupFileManager::Durability::EveryWrite;
+  bool journal = false;
+};
+
+//==============================================================================
+/// What was measured for one configuration
+struct Measurement
+{
+  /// The time that Robot::write() took to return. With asynchronous writes,
+  /// this is only the time to hand the backup over to the background thread.
+  double p50_write_ms = 0.0;
+  double p99_write_ms = 0.0;
+  double max_write_ms = 0.0;
+
+  /// Backups per second, from the first write until every backup has been
+  /// flushed. Asynchronous writes may skip backups that were replaced before
+  /// they got written, which counts towards the throughput.
+  double backups_per_second = 0.0;
+
+  /// The bytes of backup state per second that were handed to the manager
+  double megabytes_per_second = 0.0;
+};
+
+//==============================================================================
+/// A JSON backup state of roughly the given size, which differs for every
+/// robot and sequence number like the backups of real tasks do
+std::string make_state(
+  const std::size_t robot,
+  const std::size_t seq,
+  const std::size_t state_bytes)
+{
+  std::string state =
+    "{\"robot\": " + std::to_string(robot)
+    + ", \"seq\": " + std::to_string(seq) + ", \"payload\": \"";
+
+  const std::size_t payload = state_bytes > state.size() + 2 ?
+    state_bytes - state.size() - 2 : 0;
+  for (std::size_t i = 0; i < payload; ++i)
+    state.push_back(static_cast<char>('a' + (i + robot + seq) % 26));
+
+  state += "\"}";
+  return state;
+}
+
+//==============================================================================
+double percentile(std::vector<double> values, const double p)
+{
+  if (values.empty())
+    return 0.0;
+
+  std::sort(values.begin(), values.end());
+  const auto index = static_cast<std::size_t>(p * (values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+//==============================================================================
+Measurement run(const Configuration& config, const Settings& settings)
+{
+  const auto root = config.directory / "rmf_task_backup_benchmark";
+  std::filesystem::remove_all(root);
+
+  // The states are made ahead of time so that only writing them is measured
+  std::vector<std::vector<rmf_task::Task::Active::Backup>> backups;
+  for (std::size_t r = 0; r < config.robots; ++r)
+  {
+    backups.emplace_back();
+    for (std::size_t w = 0; w < settings.writes_per_robot; ++w)
+    {
+      backups.back().push_back(
+        rmf_task::Task::Active::Backup::make(
+          w + 1, make_state(r, w, settings.state_bytes)));
+    }
+  }
+
+  std::vector<double> latencies;
+  latencies.reserve(config.robots * settings.writes_per_robot);
+  std::chrono::steady_clock::duration elapsed;
+  {
+    rmf_task::BackupFileManager manager(root);
+    manager.clear_on_startup();
+    manager.durability(settings.durability);
+    manager.journal(settings.journal);
+    manager.asynchronous(config.asynchronous);
+
+    const auto group = manager.make_group("fleet");
+    std::vector<std::shared_ptr<rmf_task::BackupFileManager::Robot>> robots;
+    for (std::size_t r = 0; r < config.robots; ++r)
+      robots.push_back(group->make_robot("robot_" + std::to_string(r)));
+
+    // Every robot writes its backups in turn, like a fleet adapter that
+    // checkpoints all of its tasks from one executor
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t w = 0; w < settings.writes_per_robot; ++w)
+    {
+      for (std::size_t r = 0; r < config.robots; ++r)
+      {
+        const auto before = std::chrono::steady_clock::now();
+        robots[r]->write(backups[r][w]);
+        const auto after = std::chrono::steady_clock::now();
+        latencies.push_back(
+          std::chrono::duration<double, std::milli>(after - before).count());
+      }
+    }
+
+    manager.flush();
+    elapsed = std::chrono::steady_clock::now() - start;
+  }
+
+  std::filesystem::remove_all(root);
+
+  const double seconds = std::chrono::duration<double>(elapsed).count();
+  const double count = static_cast<double>(latencies.size());
+  Measurement m;
+  m.p50_write_ms = percentile(latencies, 0.50);
+  m.p99_write_ms = percentile(latencies, 0.99);
+  m.max_write_ms = percentile(latencies, 1.0);
+  m.backups_per_second = seconds > 0.0 ? count / seconds : 0.0;
+  m.megabytes_per_second = seconds > 0.0 ?
+    count * settings.state_bytes / seconds / 1e6 : 0.0;
+  return m;
+}
+
+//==============================================================================
+/// Write one measurement as a JSON object on a single line
+std::string to_json(
+  const Configuration& config,
+  const Settings& settings,
+  const Measurement& m)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"directory\": \"" << config.directory.string() << "\""
+       << ", \"robots\": " << config.robots
+       << ", \"mode\": \"" << (config.asynchronous ? "async" : "sync") << "\""
+       << ", \"journal\": " << (settings.journal ? "true" : "false")
+       << ", \"state_bytes\": " << settings.state_bytes
+       << ", \"writes_per_robot\": " << settings.writes_per_robot
+       << ", \"p50_write_ms\": " << m.p50_write_ms
+       << ", \"p99_write_ms\": " << m.p99_write_ms
+       << ", \"max_write_ms\": " << m.max_write_ms
+       << ", \"backups_per_second\": " << m.backups_per_second
+       << ", \"megabytes_per_second\": " << m.megabytes_per_second << "}";
+  return json.str();
+}
+
+//==============================================================================
+std::vector<std::size_t> parse_list(const std::string& text)
+{
+  std::vector<std::size_t> values;
+  std::istringstream list(text);
+  std::string item;
+  while (std::getline(list, item, ','))
+    values.push_back(std::stoul(item));
+
+  return values;
+}
+
+//==============================================================================
+void print_usage(const char* program)
+{
+  std::cout
+    << "Usage: " << program << " [options]\n"
+    << "  --dir <path>          Write the backups under this directory. May\n"
+    << "                        be given more than once, e.g. for tmpfs and\n"
+    << "                        a disk (default /dev/shm and the temporary\n"
+    << "                        directory)\n"
+    << "  --robots <list>       Comma-separated fleet sizes\n"
+    << "                        (default 1,10,50,100,200)\n"
+    << "  --writes <n>          Backups written per robot (default 20)\n"
+    << "  --state-bytes <n>     Size of each backup state (default 4096)\n"
+    << "  --durability <mode>   none, every or periodic (default every)\n"
+    << "  --journal             Share one journal file between the robots\n"
+    << "  --json <path>         Also write the measurements to a JSON file\n";
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  Settings settings;
+  std::string json_path;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const auto value = [&]() -> std::string
+      {
+        if (i + 1 >= argc)
+        {
+          std::cerr << "Missing value for " << arg << std::endl;
+          std::exit(1);
+        }
+        return argv[++i];
+      };
+
+    if (arg == "--dir")
+      settings.directories.push_back(value());
+    else if (arg == "--robots")
+      settings.robots = parse_list(value());
+    else if (arg == "--writes")
+      settings.writes_per_robot = std::max<std::size_t>(1, std::stoul(value()));
+    else if (arg == "--state-bytes")
+      settings.state_bytes = std::stoul(value());
+    else if (arg == "--journal")
+      settings.journal = true;
+    else if (arg == "--json")
+      json_path = value();
+    else if (arg == "--durability")
+    {
+      using Durability = rmf_task::BackupFileManager::Durability;
+      const auto mode = value();
+      if (mode == "none")
+        settings.durability = Durability::None;
+      else if (mode == "every")
+        settings.durability = Durability::EveryWrite;
+      else if (mode == "periodic")
+        settings.durability = Durability::Periodic;
+      else
+      {
+        print_usage(argv[0]);
+        return 1;
+      }
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  if (settings.directories.empty())
+  {
+    if (std::filesystem::is_directory("/dev/shm"))
+      settings.directories.push_back("/dev/shm");
+
+    settings.directories.push_back(std::filesystem::temp_directory_path());
+  }
+
+  std::vector<std::string> json_lines;
+  std::cout << std::left << std::setw(24) << "directory"
+            << std::right << std::setw(8) << "robots"
+            << std::setw(7) << "mode"
+            << std::setw(12) << "p50_ms"
+            << std::setw(12) << "p99_ms"
+            << std::setw(12) << "max_ms"
+            << std::setw(14) << "backups/s"
+            << std::setw(10) << "MB/s" << std::endl;
+
+  for (const auto& directory : settings.directories)
+  {
+    for (const auto robots : settings.robots)
+    {
+      for (const bool asynchronous : {false, true})
+      {
+        const Configuration config{directory, robots, asynchronous};
+        const auto m = run(config, settings);
+        json_lines.push_back(to_json(config, settings, m));
+
+        std::cout << std::left << std::setw(24) << directory.string()
+                  << std::right << std::setw(8) << robots
+                  << std::setw(7) << (asynchronous ? "async" : "sync")
+                  << std::fixed << std::setprecision(3)
+                  << std::setw(12) << m.p50_write_ms
+                  << std::setw(12) << m.p99_write_ms
+                  << std::setw(12) << m.max_write_ms
+                  << std::setprecision(1)
+                  << std::setw(14) << m.backups_per_second
+                  << std::setw(10) << m.megabytes_per_second << std::endl;
+      }
+    }
+  }
+
+  if (!json_path.empty())
+  {
+    std::ofstream json(json_path);
+    json << "[\n";
+    for (std::size_t i = 0; i < json_lines.size(); ++i)
+    {
+      json << "  " << json_lines[i]
+           << (i + 1 < json_lines.size() ? ",\n" : "\n");
+    }
+    json << "]\n";
+  }
+
+  return 0;
+}
@@ -0,0 +1,341 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/CompositeData.hpp>
+#include <rmf_task/Log.hpp>
+#include <rmf_task/State.hpp>
+#include <rmf_task/VersionedString.hpp>
+
+#include <src/rmf_task/InvariantHeuristicQueue.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Microbenchmarks of the primitives that tasks and the planner use the most.
+// They give the baselines to judge changes to the storage of State, the Log,
+// VersionedString and the heuristic queue of the planner against.
+
+namespace {
+
+//==============================================================================
+/// The same fields as the built-in components of State, as a plain struct
+struct PlainState
+{
+  std::optional<std::size_t> waypoint;
+  std::optional<double> orientation;
+  std::optional<rmf_traffic::Time> time;
+  std::optional<std::size_t> dedicated_charging_waypoint;
+  std::optional<double> battery_soc;
+};
+
+//==============================================================================
+/// A component that does not have an inline slot in CompositeData
+struct CustomComponent
+{
+  std::uint64_t value;
+};
+
+//==============================================================================
+rmf_task::State make_state()
+{
+  rmf_task::State state;
+  state.waypoint(3);
+  state.orientation(0.5);
+  state.time(rmf_traffic::Time(std::chrono::seconds(100)));
+  state.dedicated_charging_waypoint(1);
+  state.battery_soc(0.8);
+  return state;
+}
+
+//==============================================================================
+PlainState make_plain_state()
+{
+  return PlainState{
+    3, 0.5, rmf_traffic::Time(std::chrono::seconds(100)), 1, 0.8};
+}
+
+//==============================================================================
+void State_copy(benchmark::State& bm)
+{
+  const auto state = make_state();
+  for (auto _ : bm)
+  {
+    auto copy = state;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(State_copy);
+
+//==============================================================================
+void PlainState_copy(benchmark::State& bm)
+{
+  const auto state = make_plain_state();
+  for (auto _ : bm)
+  {
+    auto copy = state;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+BENCHMARK(PlainState_copy);
+
+//==============================================================================
+void State_get(benchmark::State& bm)
+{
+  const auto state = make_state();
+  for (auto _ : bm)
+  {
+    benchmark::DoNotOptimize(state.waypoint());
+    benchmark::DoNotOptimize(state.orientation());
+    benchmark::DoNotOptimize(state.time());
+    benchmark::DoNotOptimize(state.dedicated_charging_waypoint());
+    benchmark::DoNotOptimize(state.battery_soc());
+  }
+}
+BENCHMARK(State_get);
+
+//==============================================================================
+void PlainState_get(benchmark::State& bm)
+{
+  const auto state = make_plain_state();
+  for (auto _ : bm)
+  {
+    benchmark::DoNotOptimize(state.waypoint);
+    benchmark::DoNotOptimize(state.orientation);
+    benchmark::DoNotOptimize(state.time);
+    benchmark::DoNotOptimize(state.dedicated_charging_waypoint);
+    benchmark::DoNotOptimize(state.battery_soc);
+  }
+}
+BENCHMARK(PlainState_get);
+
+//==============================================================================
+void State_set(benchmark::State& bm)
+{
+  auto state = make_state();
+  std::size_t i = 0;
+  for (auto _ : bm)
+  {
+    ++i;
+    state.waypoint(i);
+    state.orientation(0.5);
+    state.time(rmf_traffic::Time(std::chrono::seconds(i)));
+    state.battery_soc(0.8);
+    benchmark::DoNotOptimize(state);
+  }
+}
+BENCHMARK(State_set);
+
+//==============================================================================
+void PlainState_set(benchmark::State& bm)
+{
+  auto state = make_plain_state();
+  std::size_t i = 0;
+  for (auto _ : bm)
+  {
+    ++i;
+    state.waypoint = i;
+    state.orientation = 0.5;
+    state.time = rmf_traffic::Time(std::chrono::seconds(i));
+    state.battery_soc = 0.8;
+    benchmark::DoNotOptimize(state);
+  }
+}
+BENCHMARK(PlainState_set);
+
+//==============================================================================
+/// Overwrite a component that is already in the CompositeData
+void CompositeData_assign_inline(benchmark::State& bm)
+{
+  rmf_task::CompositeData data;
+  data.insert_or_assign(rmf_task::State::CurrentWaypoint{0});
+  std::size_t i = 0;
+  for (auto _ : bm)
+    benchmark::DoNotOptimize(
+      data.insert_or_assign(rmf_task::State::CurrentWaypoint{++i}));
+}
+BENCHMARK(CompositeData_assign_inline);
+
+//==============================================================================
+void CompositeData_assign_custom(benchmark::State& bm)
+{
+  rmf_task::CompositeData data;
+  data.insert_or_assign(CustomComponent{0});
+  std::uint64_t i = 0;
+  for (auto _ : bm)
+    benchmark::DoNotOptimize(data.insert_or_assign(CustomComponent{++i}));
+}
+BENCHMARK(CompositeData_assign_custom);
+
+//==============================================================================
+/// Insert a custom component into a fresh CompositeData each time
+void CompositeData_insert_custom(benchmark::State& bm)
+{
+  std::uint64_t i = 0;
+  for (auto _ : bm)
+  {
+    rmf_task::CompositeData data;
+    benchmark::DoNotOptimize(data.insert_or_assign(CustomComponent{++i}));
+  }
+}
+BENCHMARK(CompositeData_insert_custom);
+
+//==============================================================================
+/// Assign a custom component in a copy, which has to stop sharing the storage
+/// with the original first
+void CompositeData_assign_custom_after_copy(benchmark::State& bm)
+{
+  rmf_task::CompositeData data;
+  data.insert_or_assign(CustomComponent{0});
+  std::uint64_t i = 0;
+  for (auto _ : bm)
+  {
+    auto copy = data;
+    benchmark::DoNotOptimize(copy.insert_or_assign(CustomComponent{++i}));
+  }
+}
+BENCHMARK(CompositeData_assign_custom_after_copy);
+
+//==============================================================================
+std::shared_ptr<rmf_task::Log> shared_log;
+
+/// Push entries into one log from several threads at once. The log keeps
+/// its newest entries only, so long runs do not grow without bound.
+void Log_push(benchmark::State& bm)
+{
+  if (bm.thread_index() == 0)
+  {
+    shared_log = std::make_shared<rmf_task::Log>();
+    shared_log->retention(
+      rmf_task::Log::Retention().max_entries(std::size_t(10000)));
+  }
+
+  // The log is ready once every thread has reached the loop
+  for (auto _ : bm)
+    shared_log->info("The robot has arrived at the pickup location");
+
+  if (bm.thread_index() == 0)
+  {
+    bm.SetItemsProcessed(bm.iterations() * bm.threads());
+    shared_log.reset();
+  }
+}
+BENCHMARK(Log_push)->Threads(1)->Threads(4)->Threads(16)->UseRealTime();
+
+//==============================================================================
+/// Read a 10k-entry log with a new reader, as a monitor that has just
+/// subscribed would
+void Log_read(benchmark::State& bm)
+{
+  rmf_task::Log log;
+  for (std::size_t i = 0; i < 10000; ++i)
+    log.info("Entry number " + std::to_string(i));
+
+  const auto view = log.view();
+  for (auto _ : bm)
+  {
+    rmf_task::Log::Reader reader;
+    std::size_t bytes = 0;
+    for (const auto& entry : reader.read(view))
+      bytes += entry.text().size();
+
+    benchmark::DoNotOptimize(bytes);
+  }
+
+  bm.SetItemsProcessed(bm.iterations() * 10000);
+}
+BENCHMARK(Log_read);
+
+//==============================================================================
+/// Read a view with a reader that has not seen it yet
+void VersionedString_read_new(benchmark::State& bm)
+{
+  const rmf_task::VersionedString string("The robot is moving to the pickup");
+  const auto view = string.view();
+  for (auto _ : bm)
+  {
+    rmf_task::VersionedString::Reader reader;
+    benchmark::DoNotOptimize(reader.read(view));
+  }
+}
+BENCHMARK(VersionedString_read_new);
+
+//==============================================================================
+/// Read a view that the reader has already seen, which is what happens for
+/// most strings of an event tree that is published repeatedly
+void VersionedString_read_seen(benchmark::State& bm)
+{
+  const rmf_task::VersionedString string("The robot is moving to the pickup");
+  const auto view = string.view();
+  rmf_task::VersionedString::Reader reader;
+  reader.read(view);
+  for (auto _ : bm)
+    benchmark::DoNotOptimize(reader.read(view));
+}
+BENCHMARK(VersionedString_read_seen);
+
+//==============================================================================
+/// Stack random tasks onto the agents of an InvariantHeuristicQueue, like the
+/// planner does for the heuristic of every node. The arguments are the number
+/// of agents and the number of tasks.
+void InvariantHeuristicQueue_solve(benchmark::State& bm)
+{
+  const auto num_agents = static_cast<std::size_t>(bm.range(0));
+  const auto num_tasks = static_cast<std::size_t>(bm.range(1));
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> initial(0.0, 600.0);
+  std::uniform_real_distribution<double> start(0.0, 3600.0);
+  std::uniform_real_distribution<double> duration(10.0, 900.0);
+
+  std::vector<double> initial_values;
+  for (std::size_t i = 0; i < num_agents; ++i)
+    initial_values.push_back(initial(rng));
+
+  // The planner always adds the invariants in order of their finish times
+  std::vector<std::pair<double, double>> invariants;
+  for (std::size_t i = 0; i < num_tasks; ++i)
+  {
+    const double s = start(rng);
+    invariants.push_back({s, s + duration(rng)});
+  }
+
+  std::sort(invariants.begin(), invariants.end(),
+    [](const auto& a, const auto& b) { return a.second < b.second; });
+
+  for (auto _ : bm)
+  {
+    rmf_task::InvariantHeuristicQueue queue(initial_values);
+    for (const auto& [s, f] : invariants)
+      queue.add(s, f);
+
+    benchmark::DoNotOptimize(queue.compute_cost());
+  }
+}
+BENCHMARK(InvariantHeuristicQueue_solve)->Args({10, 200})->Args({100, 200});
+
+} // anonymous namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,528 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BenchmarkHarness.hpp"
+
+#include <rmf_task/TaskPlanner.hpp>
+#include <rmf_task/BinaryPriorityScheme.hpp>
+#include <rmf_task/requests/Clean.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/Loop.hpp>
+
+#include <rmf_traffic/agv/Graph.hpp>
+#include <rmf_traffic/agv/Planner.hpp>
+#include <rmf_traffic/agv/VehicleTraits.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_traffic/Trajectory.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+//==============================================================================
+/// A delivery request of a fixed scenario
+struct FixedDelivery
+{
+  std::size_t pickup;
+  std::size_t dropoff;
+  double start_offset_seconds;
+  bool high_priority = false;
+};
+
+//==============================================================================
+/// The parameters that one benchmark problem is generated from
+struct Problem
+{
+  std::string name;
+
+  /// The graph is a square grid with this many waypoints along each side
+  std::size_t grid_size = 5;
+
+  /// The distance in meters between neighboring waypoints of the grid
+  double edge_length = 30.0;
+
+  /// If this is not empty, the agents start at these waypoints, which are also
+  /// their chargers, instead of at random waypoints
+  std::vector<std::size_t> start_waypoints;
+
+  /// If this is not empty, these are the requests instead of random ones
+  std::vector<FixedDelivery> deliveries;
+
+  std::size_t agents = 2;
+  std::size_t requests = 6;
+
+  /// Relative weights of Delivery, Clean and Loop requests in the mix
+  double delivery_weight = 1.0;
+  double clean_weight = 1.0;
+  double loop_weight = 1.0;
+
+  /// The fraction of requests that are given a high priority
+  double high_priority = 0.0;
+
+  /// From 0.0 for a large, fully charged battery to 1.0 for a small battery
+  /// that starts close to its recharge threshold
+  double battery_tightness = 0.0;
+
+  /// Whether the optimal planner is run for this problem. Large problems are
+  /// only practical for the greedy planner.
+  bool optimal = true;
+
+  std::uint32_t seed = 42;
+};
+
+//==============================================================================
+class Generator
+{
+public:
+
+  explicit Generator(const Problem& problem)
+  : _problem(problem),
+    _rng(problem.seed)
+  {
+    const std::size_t N = problem.grid_size;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      for (std::size_t j = 0; j < N; ++j)
+      {
+        _graph.add_waypoint(
+          "benchmark_map",
+          {j*problem.edge_length, -(i*problem.edge_length)});
+      }
+    }
+
+    const auto add_bidir_lane = [&](std::size_t w0, std::size_t w1)
+      {
+        _graph.add_lane(w0, w1);
+        _graph.add_lane(w1, w0);
+      };
+
+    for (std::size_t i = 0; i < N*N; ++i)
+    {
+      if ((i+1) % N != 0)
+        add_bidir_lane(i, i+1);
+      if (i + N < N*N)
+        add_bidir_lane(i, i+N);
+    }
+  }
+
+  rmf_task::TaskPlanner::Configuration configuration()
+  {
+    using namespace rmf_battery::agv;
+
+    const auto shape = rmf_traffic::geometry::make_final_convex<
+      rmf_traffic::geometry::Circle>(1.0);
+    const rmf_traffic::Profile profile{shape, shape};
+    const rmf_traffic::agv::VehicleTraits traits(
+      {1.0, 0.7}, {0.6, 0.5}, profile);
+
+    auto planner = std::make_shared<rmf_traffic::agv::Planner>(
+      rmf_traffic::agv::Planner::Configuration{_graph, traits},
+      rmf_traffic::agv::Planner::Options{nullptr});
+
+    // A tight battery has a quarter of the capacity of a relaxed one
+    const double capacity = 40.0 * (1.0 - 0.75*_problem.battery_tightness);
+    const auto battery_system = *BatterySystem::make(24.0, capacity, 8.8);
+    const auto mechanical_system = *MechanicalSystem::make(70.0, 40.0, 0.22);
+    const auto power_system = *PowerSystem::make(20.0);
+
+    const rmf_task::Parameters parameters{
+      planner,
+      battery_system,
+      std::make_shared<SimpleMotionPowerSink>(
+        battery_system, mechanical_system),
+      std::make_shared<SimpleDevicePowerSink>(
+        battery_system, power_system)};
+
+    return rmf_task::TaskPlanner::Configuration{
+      parameters,
+      rmf_task::Constraints{0.2, 1.0, true},
+      rmf_task::BinaryPriorityScheme::make_cost_calculator()};
+  }
+
+  std::vector<rmf_task::State> initial_states(rmf_traffic::Time now)
+  {
+    // Tight batteries start just above the recharge threshold of 0.2
+    const double soc = 1.0 - 0.7*_problem.battery_tightness;
+
+    std::vector<rmf_task::State> states;
+    for (std::size_t a = 0; a < _problem.agents; ++a)
+    {
+      const std::size_t waypoint = a < _problem.start_waypoints.size() ?
+        _problem.start_waypoints[a] : random_waypoint();
+      states.push_back(
+        rmf_task::State().load_basic(
+          rmf_traffic::agv::Plan::Start{now, waypoint, 0.0},
+          waypoint, soc));
+    }
+
+    return states;
+  }
+
+  std::vector<rmf_task::ConstRequestPtr> requests(rmf_traffic::Time now)
+  {
+    std::discrete_distribution<int> kind({
+      _problem.delivery_weight,
+      _problem.clean_weight,
+      _problem.loop_weight});
+    std::bernoulli_distribution high_priority(_problem.high_priority);
+    std::uniform_int_distribution<int> start_offset(0, 600);
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t r = 0; r < _problem.deliveries.size(); ++r)
+    {
+      const auto& d = _problem.deliveries[r];
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          d.pickup, std::chrono::seconds(0),
+          d.dropoff, std::chrono::seconds(0),
+          {{}}, std::to_string(r + 1),
+          now + rmf_traffic::time::from_seconds(d.start_offset_seconds),
+          d.high_priority ?
+          rmf_task::BinaryPriorityScheme::make_high_priority() :
+          rmf_task::BinaryPriorityScheme::make_low_priority()));
+    }
+
+    if (!requests.empty())
+      return requests;
+
+    for (std::size_t r = 0; r < _problem.requests; ++r)
+    {
+      const std::string id = std::to_string(r);
+      const auto start = now + rmf_traffic::time::from_seconds(
+        start_offset(_rng));
+      const auto priority = high_priority(_rng) ?
+        rmf_task::BinaryPriorityScheme::make_high_priority() :
+        rmf_task::BinaryPriorityScheme::make_low_priority();
+
+      const std::size_t from = random_waypoint();
+      const std::size_t to = random_waypoint();
+      switch (kind(_rng))
+      {
+        case 0:
+          requests.push_back(
+            rmf_task::requests::Delivery::make(
+              from, std::chrono::seconds(10),
+              to, std::chrono::seconds(10),
+              {{}}, id, start, priority));
+          break;
+        case 1:
+          requests.push_back(
+            rmf_task::requests::Clean::make(
+              from, to, cleaning_path(from, to, start), id, start,
+              priority));
+          break;
+        default:
+          requests.push_back(
+            rmf_task::requests::Loop::make(
+              from, to, 1 + r % 3, id, start, priority));
+          break;
+      }
+    }
+
+    return requests;
+  }
+
+private:
+
+  std::size_t random_waypoint()
+  {
+    return std::uniform_int_distribution<std::size_t>(
+      0, _graph.num_waypoints() - 1)(_rng);
+  }
+
+  /// A straight cleaning pass between two waypoints at half a meter per second
+  rmf_traffic::Trajectory cleaning_path(
+    std::size_t from,
+    std::size_t to,
+    rmf_traffic::Time start) const
+  {
+    const Eigen::Vector2d p0 = _graph.get_waypoint(from).get_location();
+    const Eigen::Vector2d p1 = _graph.get_waypoint(to).get_location();
+    const double seconds = std::max(1.0, (p1 - p0).norm() / 0.5);
+
+    rmf_traffic::Trajectory path;
+    path.insert(start, {p0.x(), p0.y(), 0.0}, Eigen::Vector3d::Zero());
+    path.insert(
+      start + rmf_traffic::time::from_seconds(seconds),
+      {p1.x(), p1.y(), 0.0}, Eigen::Vector3d::Zero());
+    return path;
+  }
+
+  Problem _problem;
+  std::mt19937 _rng;
+  rmf_traffic::agv::Graph _graph;
+};
+
+//==============================================================================
+Measurement run(
+  const Problem& problem,
+  const bool greedy,
+  const std::size_t repetitions)
+{
+  Generator generator(problem);
+  const auto config = generator.configuration();
+  const auto now = std::chrono::steady_clock::now();
+  return measure(
+    config, rmf_task::TaskPlanner::Options{greedy}, now,
+    generator.initial_states(now), generator.requests(now), repetitions);
+}
+
+//==============================================================================
+std::vector<Problem> default_suite()
+{
+  std::vector<Problem> suite;
+  const auto add = [&](std::string name, auto modify)
+    {
+      Problem p;
+      p.name = std::move(name);
+      modify(p);
+      suite.push_back(p);
+    };
+
+  // The Grid World scenarios of test_TaskPlanner
+  const auto grid_world = [](Problem& p)
+    {
+      p.grid_size = 4;
+      p.edge_length = 1000.0;
+      p.agents = 2;
+      p.start_waypoints = {13, 2};
+    };
+
+  add("grid_world_3_requests", [&](Problem& p)
+    {
+      grid_world(p);
+      p.deliveries = {{0, 3, 0}, {15, 2, 0}, {7, 9, 0}};
+    });
+  add("grid_world_11_requests", [&](Problem& p)
+    {
+      grid_world(p);
+      p.deliveries = {
+        {0, 3, 0}, {15, 2, 0}, {7, 9, 0},
+        {8, 11, 50000}, {10, 0, 50000},
+        {4, 8, 60000}, {8, 14, 60000}, {5, 11, 60000}, {9, 0, 60000},
+        {1, 3, 60000}, {0, 12, 60000}};
+    });
+  add("grid_world_priority", [&](Problem& p)
+    {
+      grid_world(p);
+      p.agents = 1;
+      p.deliveries = {
+        {0, 3, 0, true}, {15, 2, 0}, {7, 9, 0}, {4, 7, 0, true}};
+    });
+  add("small_mixed", [](Problem& p)
+    {
+      p.grid_size = 4; p.agents = 2; p.requests = 5;
+    });
+  add("medium_mixed", [](Problem& p)
+    {
+      p.grid_size = 6; p.agents = 3; p.requests = 8;
+    });
+  add("medium_delivery", [](Problem& p)
+    {
+      p.grid_size = 6; p.agents = 3; p.requests = 8;
+      p.clean_weight = 0.0; p.loop_weight = 0.0;
+    });
+  add("medium_priority", [](Problem& p)
+    {
+      p.grid_size = 6; p.agents = 3; p.requests = 8; p.high_priority = 0.3;
+    });
+  add("medium_tight_battery", [](Problem& p)
+    {
+      p.grid_size = 6; p.agents = 3; p.requests = 8;
+      p.battery_tightness = 0.8;
+    });
+  add("large_grid", [](Problem& p)
+    {
+      p.grid_size = 12; p.agents = 4; p.requests = 10;
+    });
+  add("large_fleet", [](Problem& p)
+    {
+      p.grid_size = 10; p.agents = 10; p.requests = 40; p.optimal = false;
+    });
+  add("large_fleet_tight_battery", [](Problem& p)
+    {
+      p.grid_size = 10; p.agents = 10; p.requests = 40; p.optimal = false;
+      p.battery_tightness = 0.8; p.high_priority = 0.2;
+    });
+
+  return suite;
+}
+
+//==============================================================================
+void print_usage(const char* program)
+{
+  std::cout
+    << "Usage: " << program << " [options]\n"
+    << "  --filter <text>       Only run problems whose name contains text\n"
+    << "  --repetitions <n>     Plan each problem n times (default 5)\n"
+    << "  --greedy-only         Skip the optimal planner\n"
+    << "  --json <path>         Also write the measurements to a JSON file\n"
+    << "  --baseline <path>     Fail if a measurement regressed against this\n"
+    << "                        JSON file from an earlier --json run\n"
+    << "  --max-slowdown <f>    How many times worse than the baseline a\n"
+    << "                        measurement may get (default 2.0)\n"
+    << "  --custom              Run one problem described by the options below"
+    << "\n"
+    << "  --grid <n>            Waypoints along each side of the grid\n"
+    << "  --agents <n>          Number of agents\n"
+    << "  --requests <n>        Number of requests\n"
+    << "  --mix <d>:<c>:<l>     Weights of Delivery, Clean and Loop requests\n"
+    << "  --high-priority <f>   Fraction of high priority requests\n"
+    << "  --battery <f>         Battery tightness from 0.0 to 1.0\n"
+    << "  --seed <n>            Seed for the problem generator\n";
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  std::string filter;
+  std::size_t repetitions = 5;
+  bool greedy_only = false;
+  bool custom = false;
+  std::string json_path;
+  std::string baseline_path;
+  double max_slowdown = 2.0;
+  Problem custom_problem;
+  custom_problem.name = "custom";
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const auto value = [&]() -> std::string
+      {
+        if (i + 1 >= argc)
+        {
+          std::cerr << "Missing value for " << arg << std::endl;
+          std::exit(1);
+        }
+        return argv[++i];
+      };
+
+    if (arg == "--filter")
+      filter = value();
+    else if (arg == "--repetitions")
+      repetitions = std::max<std::size_t>(1, std::stoul(value()));
+    else if (arg == "--greedy-only")
+      greedy_only = true;
+    else if (arg == "--json")
+      json_path = value();
+    else if (arg == "--baseline")
+      baseline_path = value();
+    else if (arg == "--max-slowdown")
+      max_slowdown = std::stod(value());
+    else if (arg == "--custom")
+      custom = true;
+    else if (arg == "--grid")
+      custom_problem.grid_size = std::stoul(value());
+    else if (arg == "--agents")
+      custom_problem.agents = std::stoul(value());
+    else if (arg == "--requests")
+      custom_problem.requests = std::stoul(value());
+    else if (arg == "--high-priority")
+      custom_problem.high_priority = std::stod(value());
+    else if (arg == "--battery")
+      custom_problem.battery_tightness = std::stod(value());
+    else if (arg == "--seed")
+      custom_problem.seed = std::stoul(value());
+    else if (arg == "--mix")
+    {
+      char sep;
+      std::istringstream mix(value());
+      mix >> custom_problem.delivery_weight >> sep
+      >> custom_problem.clean_weight >> sep
+      >> custom_problem.loop_weight;
+    }
+    else
+    {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  const auto suite = custom ?
+    std::vector<Problem>{custom_problem} : default_suite();
+
+  std::map<std::string, Record> baseline;
+  if (!baseline_path.empty())
+  {
+    baseline = read_json(baseline_path);
+    if (baseline.empty())
+    {
+      std::cerr << "No measurements found in " << baseline_path << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::string> json_lines;
+  std::vector<std::string> regressions;
+
+  print_header();
+
+  for (const auto& problem : suite)
+  {
+    if (!filter.empty() && problem.name.find(filter) == std::string::npos)
+      continue;
+
+    for (const bool greedy : {true, false})
+    {
+      if (!greedy && (greedy_only || !problem.optimal))
+        continue;
+
+      const std::string mode = greedy ? "greedy" : "optimal";
+      const auto m = run(problem, greedy, repetitions);
+      json_lines.push_back(to_json(problem.name, mode, m));
+
+      const auto base = baseline.find(problem.name + "/" + mode);
+      if (base != baseline.end())
+      {
+        for (const auto& r : find_regressions(base->second, m, max_slowdown))
+          regressions.push_back(problem.name + " " + mode + ": " + r);
+      }
+
+      print_row(problem.name, mode, m);
+    }
+  }
+
+  if (!json_path.empty())
+    write_json(json_path, json_lines);
+
+  if (!regressions.empty())
+  {
+    std::cerr << "Regressions beyond " << max_slowdown
+              << "x of the baseline:" << std::endl;
+    for (const auto& r : regressions)
+      std::cerr << "  " << r << std::endl;
+
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BenchmarkHarness.hpp"
+
+#include <rmf_task/PlanningProblem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+
+//==============================================================================
+/// Find the captures to replay. A directory stands for every .json file in it.
+std::vector<std::filesystem::path> find_captures(
+  const std::vector<std::string>& paths)
+{
+  std::vector<std::filesystem::path> captures;
+  for (const auto& path : paths)
+  {
+    if (!std::filesystem::is_directory(path))
+    {
+      captures.push_back(path);
+      continue;
+    }
+
+    std::vector<std::filesystem::path> found;
+    for (const auto& entry : std::filesystem::directory_iterator(path))
+    {
+      if (entry.path().extension() == ".json")
+        found.push_back(entry.path());
+    }
+
+    std::sort(found.begin(), found.end());
+    captures.insert(captures.end(), found.begin(), found.end());
+  }
+
+  return captures;
+}
+
+//==============================================================================
+void print_usage(const char* program)
+{
+  std::cout
+    << "Usage: " << program << " [options] <capture>...\n"
+    << "Replay planning problems that were captured with\n"
+    << "rmf_task::PlanningProblem::serialize(). A directory stands for every\n"
+    << ".json file in it, and each file is named after its stem.\n"
+    << "  --repetitions <n>     Plan each problem n times (default 5)\n"
+    << "  --greedy              Use the greedy planner whatever was captured\n"
+    << "  --optimal             Use the optimal planner whatever was captured\n"
+    << "  --json <path>         Also write the measurements to a JSON file\n"
+    << "  --baseline <path>     Fail if a measurement regressed against this\n"
+    << "                        JSON file from an earlier --json run\n"
+    << "  --max-slowdown <f>    How many times worse than the baseline a\n"
+    << "                        measurement may get (default 2.0)\n";
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  std::size_t repetitions = 5;
+  std::optional<bool> greedy;
+  std::string json_path;
+  std::string baseline_path;
+  double max_slowdown = 2.0;
+  std::vector<std::string> paths;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const auto value = [&]() -> std::string
+      {
+        if (i + 1 >= argc)
+        {
+          std::cerr << "Missing value for " << arg << std::endl;
+          std::exit(1);
+        }
+        return argv[++i];
+      };
+
+    if (arg == "--repetitions")
+      repetitions = std::max<std::size_t>(1, std::stoul(value()));
+    else if (arg == "--greedy")
+      greedy = true;
+    else if (arg == "--optimal")
+      greedy = false;
+    else if (arg == "--json")
+      json_path = value();
+    else if (arg == "--baseline")
+      baseline_path = value();
+    else if (arg == "--max-slowdown")
+      max_slowdown = std::stod(value());
+    else if (arg.rfind("--", 0) == 0)
+    {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+    else
+      paths.push_back(arg);
+  }
+
+  const auto captures = find_captures(paths);
+  if (captures.empty())
+  {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  std::map<std::string, Record> baseline;
+  if (!baseline_path.empty())
+  {
+    baseline = read_json(baseline_path);
+    if (baseline.empty())
+    {
+      std::cerr << "No measurements found in " << baseline_path << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::string> json_lines;
+  std::vector<std::string> regressions;
+  bool failed = false;
+
+  print_header();
+
+  for (const auto& capture : captures)
+  {
+    const std::string name = capture.stem().string();
+    std::optional<rmf_task::PlanningProblem> problem;
+    try
+    {
+      std::ifstream file(capture);
+      problem = rmf_task::PlanningProblem::deserialize(
+        nlohmann::json::parse(file), std::chrono::steady_clock::now());
+    }
+    catch (const std::exception& e)
+    {
+      std::cerr << "Unable to load " << capture << ": " << e.what()
+                << std::endl;
+      failed = true;
+      continue;
+    }
+
+    auto options = problem->options();
+    if (greedy.has_value())
+      options.greedy(*greedy);
+
+    const std::string mode = options.greedy() ? "greedy" : "optimal";
+    const auto m = measure(
+      problem->configuration(), options, problem->time_now(),
+      problem->agents(), problem->requests(), repetitions);
+    json_lines.push_back(to_json(name, mode, m));
+
+    const auto base = baseline.find(name + "/" + mode);
+    if (base != baseline.end())
+    {
+      for (const auto& r : find_regressions(base->second, m, max_slowdown))
+        regressions.push_back(name + " " + mode + ": " + r);
+    }
+
+    print_row(name, mode, m);
+  }
+
+  if (!json_path.empty())
+    write_json(json_path, json_lines);
+
+  if (!regressions.empty())
+  {
+    std::cerr << "Regressions beyond " << max_slowdown
+              << "x of the baseline:" << std::endl;
+    for (const auto& r : regressions)
+      std::cerr << "  " << r << std::endl;
+
+    return 1;
+  }
+
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BenchmarkHarness.hpp"
+
+#include <rmf_task/TaskPlanner.hpp>
+#include <rmf_task/BinaryPriorityScheme.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+
+#include <rmf_traffic/agv/Graph.hpp>
+#include <rmf_traffic/agv/Planner.hpp>
+#include <rmf_traffic/agv/VehicleTraits.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+//==============================================================================
+/// The parameters of one simulated stream of delivery requests
+struct Scenario
+{
+  std::string name;
+
+  /// The graph is a square grid with this many waypoints along each side
+  std::size_t grid_size = 6;
+
+  /// The distance in meters between neighboring waypoints of the grid
+  double edge_length = 30.0;
+
+  std::size_t agents = 3;
+
+  /// The mean number of deliveries that are requested per hour. The requests
+  /// arrive as a Poisson process.
+  double arrivals_per_hour = 30.0;
+
+  /// How long requests keep arriving. The simulation then runs until every
+  /// planned assignment is finished.
+  double hours = 2.0;
+
+  /// From 0.0 for a large, fully charged battery to 1.0 for a small battery
+  /// that starts close to its recharge threshold
+  double battery_tightness = 0.0;
+
+  std::uint32_t seed = 42;
+};
+
+//==============================================================================
+/// A planner mode to compare
+struct Mode
+{
+  std::string name;
+  std::function<rmf_task::TaskPlanner::Options()> options;
+};
+
+//==============================================================================
+/// What was observed while simulating one scenario with one mode
+struct Outcome
+{
+  std::size_t requested = 0;
+  std::size_t delivered = 0;
+
+  /// Deliveries per hour, from the start of the simulation until the last
+  /// assignment was finished
+  double deliveries_per_hour = 0.0;
+
+  /// The time from the arrival of each request until it was delivered
+  double mean_lateness_s = 0.0;
+  double max_lateness_s = 0.0;
+
+  /// The share of the time of the agents that they spent without anything to
+  /// do, neither a request nor a charge
+  double idle_percent = 0.0;
+
+  std::size_t replans = 0;
+  std::size_t failed_replans = 0;
+
+  /// The processor time used by plan(), summed over all threads
+  double plan_cpu_s = 0.0;
+
+  /// The longest that any one call to plan() took
+  double max_plan_ms = 0.0;
+};
+
+//==============================================================================
+/// The grid, configuration and fleet of a scenario
+class World
+{
+public:
+
+  explicit World(const Scenario& scenario)
+  : _scenario(scenario),
+    _rng(scenario.seed)
+  {
+    const std::size_t N = scenario.grid_size;
+    for (std::size_t i = 0; i < N; ++i)
+    {
+      for (std::size_t j = 0; j < N; ++j)
+      {
+        _graph.add_waypoint(
+          "simulation_map",
+          {j*scenario.edge_length, -(i*scenario.edge_length)});
+      }
+    }
+
+    for (std::size_t i = 0; i < N*N; ++i)
+    {
+      if ((i+1) % N != 0)
+      {
+        _graph.add_lane(i, i+1);
+        _graph.add_lane(i+1, i);
+      }
+
+      if (i + N < N*N)
+      {
+        _graph.add_lane(i, i+N);
+        _graph.add_lane(i+N, i);
+      }
+    }
+  }
+
+  rmf_task::TaskPlanner::Configuration configuration() const
+  {
+    using namespace rmf_battery::agv;
+
+    const auto shape = rmf_traffic::geometry::make_final_convex<
+      rmf_traffic::geometry::Circle>(1.0);
+    const rmf_traffic::Profile profile{shape, shape};
+    const rmf_traffic::agv::VehicleTraits traits(
+      {1.0, 0.7}, {0.6, 0.5}, profile);
+
+    auto planner = std::make_shared<rmf_traffic::agv::Planner>(
+      rmf_traffic::agv::Planner::Configuration{_graph, traits},
+      rmf_traffic::agv::Planner::Options{nullptr});
+
+    // A tight battery has a quarter of the capacity of a relaxed one
+    const double capacity = 40.0 * (1.0 - 0.75*_scenario.battery_tightness);
+    const auto battery_system = *BatterySystem::make(24.0, capacity, 8.8);
+    const auto mechanical_system = *MechanicalSystem::make(70.0, 40.0, 0.22);
+    const auto power_system = *PowerSystem::make(20.0);
+
+    const rmf_task::Parameters parameters{
+      planner,
+      battery_system,
+      std::make_shared<SimpleMotionPowerSink>(
+        battery_system, mechanical_system),
+      std::make_shared<SimpleDevicePowerSink>(
+        battery_system, power_system)};
+
+    return rmf_task::TaskPlanner::Configuration{
+      parameters,
+      rmf_task::Constraints{0.2, 1.0, true},
+      rmf_task::BinaryPriorityScheme::make_cost_calculator()};
+  }
+
+  /// The agents start at spread out waypoints, which are also their chargers
+  std::vector<rmf_task::State> initial_states(rmf_traffic::Time start) const
+  {
+    const double soc = 1.0 - 0.7*_scenario.battery_tightness;
+    const std::size_t num_waypoints = _graph.num_waypoints();
+
+    std::vector<rmf_task::State> states;
+    for (std::size_t a = 0; a < _scenario.agents; ++a)
+    {
+      const std::size_t waypoint = (a * num_waypoints) / _scenario.agents;
+      states.push_back(
+        rmf_task::State().load_basic(
+          rmf_traffic::agv::Plan::Start{start, waypoint, 0.0},
+          waypoint, soc));
+    }
+
+    return states;
+  }
+
+  /// The deliveries that arrive while the scenario runs, in order of arrival
+  std::vector<rmf_task::ConstRequestPtr> arrivals(rmf_traffic::Time start)
+  {
+    std::exponential_distribution<double> gap(
+      _scenario.arrivals_per_hour / 3600.0);
+    std::uniform_int_distribution<std::size_t> waypoint(
+      0, _graph.num_waypoints() - 1);
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    double t = gap(_rng);
+    while (t < 3600.0 * _scenario.hours)
+    {
+      const std::size_t pickup = waypoint(_rng);
+      std::size_t dropoff = waypoint(_rng);
+      while (dropoff == pickup)
+        dropoff = waypoint(_rng);
+
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          pickup, std::chrono::seconds(10),
+          dropoff, std::chrono::seconds(10),
+          {{}}, std::to_string(requests.size()),
+          start + rmf_traffic::time::from_seconds(t)));
+
+      t += gap(_rng);
+    }
+
+    return requests;
+  }
+
+private:
+  Scenario _scenario;
+  std::mt19937 _rng;
+  rmf_traffic::agv::Graph _graph;
+};
+
+//==============================================================================
+/// Replan whenever a request arrives, and carry out the assignments of the
+/// latest plan as the simulated clock passes their deployment times. An
+/// assignment takes exactly as long as its model estimated, and once it has
+/// been deployed it is committed and left out of later plans.
+Outcome simulate(const Scenario& scenario, const Mode& mode)
+{
+  using Assignment = rmf_task::TaskPlanner::Assignment;
+
+  World world(scenario);
+  const auto start = std::chrono::steady_clock::now();
+  const auto arrivals = world.arrivals(start);
+  auto states = world.initial_states(start);
+  rmf_task::TaskPlanner planner(world.configuration(), mode.options());
+
+  Outcome outcome;
+  outcome.requested = arrivals.size();
+
+  std::vector<std::vector<Assignment>> plans(states.size());
+  std::map<std::string, rmf_task::ConstRequestPtr> pending;
+  double busy_s = 0.0;
+  double lateness_s = 0.0;
+  rmf_traffic::Time end = start;
+
+  // Commit every assignment that was deployed by the given time
+  const auto advance = [&](rmf_traffic::Time now)
+    {
+      for (std::size_t a = 0; a < plans.size(); ++a)
+      {
+        auto& plan = plans[a];
+        std::size_t done = 0;
+        for (; done < plan.size(); ++done)
+        {
+          const auto& assignment = plan[done];
+          if (now < assignment.deployment_time())
+            break;
+
+          const auto finish = assignment.finish_state().time().value();
+          busy_s += rmf_traffic::time::to_seconds(
+            finish - assignment.deployment_time());
+          end = std::max(end, finish);
+          states[a] = assignment.finish_state();
+
+          if (assignment.is_charging())
+            continue;
+
+          const auto& booking = *assignment.request()->booking();
+          const double lateness = rmf_traffic::time::to_seconds(
+            finish - booking.earliest_start_time());
+          lateness_s += lateness;
+          outcome.max_lateness_s = std::max(outcome.max_lateness_s, lateness);
+          ++outcome.delivered;
+          pending.erase(booking.id());
+        }
+
+        plan.erase(plan.begin(), plan.begin() + done);
+      }
+    };
+
+  for (const auto& request : arrivals)
+  {
+    const auto now = request->booking()->earliest_start_time();
+    advance(now);
+    pending[request->booking()->id()] = request;
+
+    // An agent that has nothing left to do waits where it is
+    for (std::size_t a = 0; a < plans.size(); ++a)
+    {
+      if (plans[a].empty() && states[a].time().value() < now)
+        states[a].time(now);
+    }
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    requests.reserve(pending.size());
+    for (const auto& p : pending)
+      requests.push_back(p.second);
+
+    const std::clock_t cpu_start = std::clock();
+    const auto wall_start = std::chrono::steady_clock::now();
+    const auto result = planner.plan(now, states, requests);
+    const auto wall_finish = std::chrono::steady_clock::now();
+    outcome.plan_cpu_s +=
+      static_cast<double>(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    outcome.max_plan_ms = std::max(
+      outcome.max_plan_ms,
+      1e3 * std::chrono::duration<double>(wall_finish - wall_start).count());
+    ++outcome.replans;
+
+    // When planning fails, the agents keep to their previous plans and the
+    // new request waits for the next arrival
+    const auto* assignments =
+      std::get_if<rmf_task::TaskPlanner::Assignments>(&result);
+    if (!assignments)
+    {
+      ++outcome.failed_replans;
+      continue;
+    }
+
+    plans = *assignments;
+  }
+
+  // Carry out whatever is left of the last plan
+  advance(rmf_traffic::Time::max());
+
+  const double total_s = rmf_traffic::time::to_seconds(end - start);
+  if (outcome.delivered > 0)
+    outcome.mean_lateness_s = lateness_s / outcome.delivered;
+
+  if (total_s > 0.0)
+  {
+    outcome.deliveries_per_hour = 3600.0 * outcome.delivered / total_s;
+    outcome.idle_percent = std::max(
+      0.0, 100.0 * (1.0 - busy_s / (total_s * scenario.agents)));
+  }
+
+  return outcome;
+}
+
+//==============================================================================
+std::vector<Scenario> default_suite()
+{
+  std::vector<Scenario> suite;
+  const auto add = [&](std::string name, auto modify)
+    {
+      Scenario s;
+      s.name = std::move(name);
+      modify(s);
+      suite.push_back(s);
+    };
+
+  add("light_traffic", [](Scenario& s)
+    {
+      s.grid_size = 6; s.agents = 3; s.arrivals_per_hour = 20.0;
+    });
+  add("busy_traffic", [](Scenario& s)
+    {
+      s.grid_size = 8; s.agents = 4; s.arrivals_per_hour = 60.0;
+    });
+  add("saturated", [](Scenario& s)
+    {
+      s.grid_size = 10; s.agents = 4; s.arrivals_per_hour = 120.0;
+      s.hours = 1.0;
+    });
+  add("tight_battery", [](Scenario& s)
+    {
+      s.grid_size = 6; s.agents = 3; s.arrivals_per_hour = 30.0;
+      s.battery_tightness = 0.8;
+    });
+
+  return suite;
+}
+
+//==============================================================================
+std::vector<Mode> default_modes()
+{
+  using Options = rmf_task::TaskPlanner::Options;
+  return {
+    {"greedy", []() { return Options{true}; }},
+    {"local_search", []()
+      {
+        return Options{true}.local_search_budget(
+          std::chrono::milliseconds(50));
+      }},
+    {"rolling", []()
+      {
+        return Options{false}.rolling_horizon(6, 2);
+      }},
+    {"optimal_budget", []()
+      {
+        return Options{false}.time_budget(std::chrono::milliseconds(200));
+      }}
+  };
+}
+
+//==============================================================================
+/// Write one outcome as a JSON object on a single line
+std::string to_json(
+  const std::string& scenario,
+  const std::string& mode,
+  const Outcome& o)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"problem\": \"" << scenario << "\""
+       << ", \"mode\": \"" << mode << "\""
+       << ", \"requested\": " << o.requested
+       << ", \"delivered\": " << o.delivered
+       << ", \"deliveries_per_hour\": " << o.deliveries_per_hour
+       << ", \"mean_lateness_s\": " << o.mean_lateness_s
+       << ", \"max_lateness_s\": " << o.max_lateness_s
+       << ", \"idle_percent\": " << o.idle_percent
+       << ", \"replans\": " << o.replans
+       << ", \"failed_replans\": " << o.failed_replans
+       << ", \"plan_cpu_s\": " << o.plan_cpu_s
+       << ", \"max_plan_ms\": " << o.max_plan_ms << "}";
+  return json.str();
+}
+
+//==============================================================================
+void print_outcome_header()
+{
+  std::cout << std::left << std::setw(16) << "scenario"
+            << std::setw(16) << "mode"
+            << std::right << std::setw(11) << "delivered"
+            << std::setw(10) << "per_hour"
+            << std::setw(12) << "lateness_s"
+            << std::setw(12) << "max_late_s"
+            << std::setw(8) << "idle_%"
+            << std::setw(9) << "replans"
+            << std::setw(9) << "cpu_s"
+            << std::setw(13) << "max_plan_ms" << std::endl;
+}
+
+//==============================================================================
+void print_outcome(
+  const std::string& scenario,
+  const std::string& mode,
+  const Outcome& o)
+{
+  std::cout << std::left << std::setw(16) << scenario
+            << std::setw(16) << mode
+            << std::right << std::fixed << std::setprecision(1)
+            << std::setw(11)
+            << (std::to_string(o.delivered) + "/" + std::to_string(o.requested))
+            << std::setw(10) << o.deliveries_per_hour
+            << std::setw(12) << o.mean_lateness_s
+            << std::setw(12) << o.max_lateness_s
+            << std::setw(8) << o.idle_percent
+            << std::setw(9) << o.replans
+            << std::setprecision(2)
+            << std::setw(9) << o.plan_cpu_s
+            << std::setw(13) << o.max_plan_ms << std::endl;
+}
+
+//==============================================================================
+void print_usage(const char* program)
+{
+  std::cout
+    << "Usage: " << program << " [options]\n"
+    << "Simulate a fleet that replans whenever a delivery request arrives,\n"
+    << "and compare the throughput, lateness and planning time of planner\n"
+    << "modes.\n"
+    << "  --filter <text>       Only run scenarios whose name contains text\n"
+    << "  --mode <name>         Only run this mode: greedy, local_search,\n"
+    << "                        rolling or optimal_budget\n"
+    << "  --json <path>         Also write the outcomes to a JSON file\n"
+    << "  --custom              Run one scenario described by the options below"
+    << "\n"
+    << "  --grid <n>            Waypoints along each side of the grid\n"
+    << "  --agents <n>          Number of agents\n"
+    << "  --rate <f>            Deliveries requested per hour\n"
+    << "  --hours <f>           How long requests keep arriving\n"
+    << "  --battery <f>         Battery tightness from 0.0 to 1.0\n"
+    << "  --seed <n>            Seed for the request stream\n";
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  std::string filter;
+  std::string mode_filter;
+  std::string json_path;
+  bool custom = false;
+  Scenario custom_scenario;
+  custom_scenario.name = "custom";
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const auto value = [&]() -> std::string
+      {
+        if (i + 1 >= argc)
+        {
+          std::cerr << "Missing value for " << arg << std::endl;
+          std::exit(1);
+        }
+        return argv[++i];
+      };
+
+    if (arg == "--filter")
+      filter = value();
+    else if (arg == "--mode")
+      mode_filter = value();
+    else if (arg == "--json")
+      json_path = value();
+    else if (arg == "--custom")
+      custom = true;
+    else if (arg == "--grid")
+      custom_scenario.grid_size = std::stoul(value());
+    else if (arg == "--agents")
+      custom_scenario.agents = std::stoul(value());
+    else if (arg == "--rate")
+      custom_scenario.arrivals_per_hour = std::stod(value());
+    else if (arg == "--hours")
+      custom_scenario.hours = std::stod(value());
+    else if (arg == "--battery")
+      custom_scenario.battery_tightness = std::stod(value());
+    else if (arg == "--seed")
+      custom_scenario.seed = std::stoul(value());
+    else
+    {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  const auto suite = custom ?
+    std::vector<Scenario>{custom_scenario} : default_suite();
+
+  std::vector<std::string> json_lines;
+  print_outcome_header();
+
+  for (const auto& scenario : suite)
+  {
+    if (!filter.empty() && scenario.name.find(filter) == std::string::npos)
+      continue;
+
+    for (const auto& mode : default_modes())
+    {
+      if (!mode_filter.empty() && mode.name != mode_filter)
+        continue;
+
+      const auto outcome = simulate(scenario, mode);
+      json_lines.push_back(to_json(scenario.name, mode.name, outcome));
+      print_outcome(scenario.name, mode.name, outcome);
+    }
+  }
+
+  if (!json_path.empty())
+    write_json(json_path, json_lines);
+
+  return 0;
+}
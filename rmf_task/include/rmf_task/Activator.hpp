@@ -80,6 +80,30 @@ public:
       std::function<void()> task_finished)
     >;
 
+  /// Signature for activating a task with the model that was planned for its
+  /// description. This is the same as Activate, except for the model.
+  ///
+  /// \param[in] model
+  ///   The model that was given to activate(~) for the description, e.g. the
+  ///   one carried by a TaskPlanner::Assignment, so the activator does not
+  ///   need to make it again. This is a nullptr if no model was given, or if
+  ///   the Task is being restored.
+  template<typename Description>
+  using ActivatePlanned =
+    std::function<
+    Task::ActivePtr(
+      const std::function<State()>& get_state,
+      const ConstParametersPtr& parameters,
+      const Task::ConstBookingPtr& booking,
+      const Description& description,
+      Task::ConstModelPtr model,
+      std::optional<std::string> backup_state,
+      std::function<void(Phase::ConstSnapshotPtr)> update,
+      std::function<void(Task::Active::Backup)> checkpoint,
+      std::function<void(Phase::ConstCompletedPtr)> phase_finished,
+      std::function<void()> task_finished)
+    >;
+
   /// Add a callback to convert from a Description into an active Task.
   ///
   /// \tparam Description
@@ -90,6 +114,17 @@ public:
   template<typename Description>
   void add_activator(Activate<Description> activator);
 
+  /// Add a callback to convert from a Description into an active Task, which
+  /// is given the model that was planned for the Description, if any.
+  ///
+  /// \tparam Description
+  ///   A class that implements the Request::Description interface
+  ///
+  /// \param[in] activator
+  ///   A callback that activates a Task matching the Description
+  template<typename Description>
+  void add_activator(ActivatePlanned<Description> activator);
+
   /// Activate a Task object based on a Request.
   ///
   /// \param[in] get_state
@@ -124,6 +159,47 @@ public:
     std::function<void(Phase::ConstCompletedPtr)> phase_finished,
     std::function<void()> task_finished) const;
 
+  /// Activate a Task object based on a Request, reusing a model that was
+  /// already made for its description, e.g. the one carried by a
+  /// TaskPlanner::Assignment. Activators that were added as ActivatePlanned
+  /// are given the model, so they do not need to make it again.
+  ///
+  /// \param[in] get_state
+  ///   A callback for retrieving the current state of the robot
+  ///
+  /// \param[in] parameters
+  ///   A reference to the parameters for the robot
+  ///
+  /// \param[in] request
+  ///   The task request
+  ///
+  /// \param[in] model
+  ///   The model of the description of the request. This may be a nullptr.
+  ///
+  /// \param[in] update
+  ///   A callback that will be triggered when the task has a significant update
+  ///
+  /// \param[in] checkpoint
+  ///   A callback that will be triggered when the task has reached a task
+  ///   checkpoint whose state is worth backing up.
+  ///
+  /// \param[in] phase_finished
+  ///   A callback that will be triggered whenever a task phase is finished
+  ///
+  /// \param[in] task_finished
+  ///   A callback that will be triggered when the task has finished
+  ///
+  /// \return an active, running instance of the requested task.
+  Task::ActivePtr activate(
+    const std::function<State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Request& request,
+    Task::ConstModelPtr model,
+    std::function<void(Phase::ConstSnapshotPtr)> update,
+    std::function<void(Task::Active::Backup)> checkpoint,
+    std::function<void(Phase::ConstCompletedPtr)> phase_finished,
+    std::function<void()> task_finished) const;
+
   /// Restore a Task that crashed or disconnected.
   ///
   /// \param[in] get_state
@@ -162,13 +238,53 @@ public:
     std::function<void(Phase::ConstCompletedPtr)> phase_finished,
     std::function<void()> task_finished) const;
 
+  /// Activate a batch of Task objects based on a list of Requests, e.g. the
+  /// requests that a task planner has just assigned to a robot. The callbacks
+  /// are shared by every task in the batch instead of being copied for each
+  /// one, and each call tells which request it is about.
+  ///
+  /// \param[in] get_state
+  ///   A callback for retrieving the current state of the robot
+  ///
+  /// \param[in] parameters
+  ///   A reference to the parameters for the robot
+  ///
+  /// \param[in] requests
+  ///   The task requests, in the order they should be activated
+  ///
+  /// \param[in] update
+  ///   A callback that will be triggered when a task has a significant update
+  ///
+  /// \param[in] checkpoint
+  ///   A callback that will be triggered when a task has reached a task
+  ///   checkpoint whose state is worth backing up.
+  ///
+  /// \param[in] phase_finished
+  ///   A callback that will be triggered whenever a task phase is finished
+  ///
+  /// \param[in] task_finished
+  ///   A callback that will be triggered when a task has finished
+  ///
+  /// \return the active, running instances of the requested tasks, in the
+  /// same order as the requests. An entry is a nullptr if its request could
+  /// not be activated.
+  std::vector<Task::ActivePtr> activate_batch(
+    const std::function<State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const std::vector<ConstRequestPtr>& requests,
+    std::function<void(std::size_t index, Phase::ConstSnapshotPtr)> update,
+    std::function<void(std::size_t index, Task::Active::Backup)> checkpoint,
+    std::function<void(std::size_t index, Phase::ConstCompletedPtr)>
+    phase_finished,
+    std::function<void(std::size_t index)> task_finished) const;
+
   class Implementation;
 private:
 
   /// \private
   void _add_activator(
     std::type_index type,
-    Activate<Task::Description> activator);
+    ActivatePlanned<Task::Description> activator);
 
   rmf_utils::impl_ptr<Implementation> _pimpl;
 };
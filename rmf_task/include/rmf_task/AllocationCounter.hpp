@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__ALLOCATIONCOUNTER_HPP
+#define RMF_TASK__ALLOCATIONCOUNTER_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Counts the heap allocations made by the hot paths of rmf_task, broken down
+/// by the subsystem that made them.
+///
+/// The counting is done by replacing the global operator new, so it is only
+/// compiled in when rmf_task is built with the RMF_TASK_COUNT_ALLOCATIONS
+/// CMake option. Otherwise enabled() is false and every count stays at zero.
+/// Since the replacement applies to the whole program, the allocations of
+/// any code, not just rmf_task, get counted while the option is on.
+///
+/// Each thread keeps track of which subsystem it is currently working for.
+/// Allocations made outside of any Scope are counted as Subsystem::Other.
+class AllocationCounter
+{
+public:
+
+  /// The parts of rmf_task that allocations are attributed to
+  enum class Subsystem : std::size_t
+  {
+    /// Anything that is not inside one of the scopes below
+    Other = 0,
+
+    /// The search of TaskPlanner::plan() and TaskPlanner::Session::replan()
+    Planner,
+
+    /// Planning trips that the TravelEstimator did not have cached
+    Estimator,
+
+    /// Pushing entries into a Log
+    Log,
+
+    /// Making an Event::Snapshot or Phase::Snapshot
+    Snapshot
+  };
+
+  static constexpr std::size_t NumSubsystems = 5;
+
+  /// A snapshot of the allocation counters
+  class Counts
+  {
+  public:
+
+    /// Default constructor. Every count is zero.
+    Counts();
+
+    /// The number of allocations attributed to a subsystem
+    std::size_t allocations(Subsystem subsystem) const;
+
+    /// The number of bytes requested by those allocations
+    std::size_t bytes(Subsystem subsystem) const;
+
+    /// The number of allocations of every subsystem together
+    std::size_t total_allocations() const;
+
+    /// The number of bytes of every subsystem together
+    std::size_t total_bytes() const;
+
+    /// Get the counts that were accumulated after an earlier snapshot of the
+    /// same counters was taken
+    Counts since(const Counts& earlier) const;
+
+    class Implementation;
+  private:
+    std::array<std::size_t, NumSubsystems> _allocations;
+    std::array<std::size_t, NumSubsystems> _bytes;
+  };
+
+  /// True if rmf_task was built with RMF_TASK_COUNT_ALLOCATIONS
+  static bool enabled();
+
+  /// Get the counters of the calling thread. Reading them is cheap and never
+  /// allocates.
+  static Counts this_thread();
+
+  /// Get the counters of every thread added together. Allocations that
+  /// other threads make at the same time are included, so take the
+  /// difference of two snapshots from this_thread() to measure the work of
+  /// one thread alone.
+  static Counts all_threads();
+
+  /// Attributes the allocations that the current thread makes to a subsystem
+  /// for as long as the scope lives. Scopes may be nested, and the subsystem
+  /// of the outer scope is restored when the inner one ends.
+  class Scope
+  {
+  public:
+
+    /// Begin attributing allocations to the given subsystem
+    explicit Scope(Subsystem subsystem);
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+    ~Scope();
+
+  private:
+    Subsystem _previous;
+  };
+
+  /// The subsystem that the current thread is attributing allocations to
+  static Subsystem current();
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__ALLOCATIONCOUNTER_HPP
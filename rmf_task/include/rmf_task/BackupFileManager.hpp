@@ -18,9 +18,16 @@
 #ifndef RMF_TASK__BACKUPFILEMANAGER_HPP
 #define RMF_TASK__BACKUPFILEMANAGER_HPP
 
+#include <rmf_task/Executor.hpp>
 #include <rmf_task/Task.hpp>
 
 #include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace rmf_task {
 
@@ -32,6 +39,26 @@ public:
   class Group;
   class Robot;
 
+  /// How hard the BackupFileManager should try to make sure that each backup
+  /// has reached storage before moving on. Synchronizing with storage protects
+  /// backups from a crash or power loss, but it can make each write much
+  /// slower.
+  enum class Durability : uint8_t
+  {
+    /// Leave it to the operating system to decide when backups reach storage.
+    None,
+
+    /// Synchronize every backup with storage after it is written.
+    EveryWrite,
+
+    /// Synchronize the data of every backup before it replaces the previous
+    /// one, but only synchronize the replacement itself if no other backup of
+    /// this manager has been synchronized within the sync period. A crash may
+    /// bring back an older complete backup in place of any backup that was
+    /// written since the last synchronization, but never an incomplete one.
+    Periodic
+  };
+
   /// Construct a BackupFileManager
   ///
   /// \param[in] root_directory
@@ -56,6 +83,93 @@ public:
   ///   off.
   BackupFileManager& clear_on_shutdown(bool value = true);
 
+  /// Set whether backups should be written to file by a background thread of
+  /// the executor() instead of by the thread that calls Robot::write(). While
+  /// a backup for a robot is waiting to be written, any newer backup for the
+  /// same robot will replace it, so only the latest one gets written. By
+  /// default this behavior is turned OFF.
+  ///
+  /// Errors while writing in the background cannot be thrown to the caller of
+  /// Robot::write(), so they are reported through the info logger instead.
+  ///
+  /// \param[in] value
+  ///   True if the behavior should be turned on; false if it should be turned
+  ///   off. Turning it off will wait for any backups that are still waiting to
+  ///   be written.
+  BackupFileManager& asynchronous(bool value = true);
+
+  /// Set the executor whose threads write the backups while asynchronous() is
+  /// turned on. Only one backup is written at a time, no matter how many
+  /// threads the executor has. If backups are already being written
+  /// asynchronously, this waits for the ones that are waiting to be written
+  /// before switching over.
+  ///
+  /// \param[in] executor
+  ///   The executor to use, or nullptr to use Executor::default_executor()
+  BackupFileManager& executor(ExecutorPtr executor);
+
+  /// Set whether the robots of each group should share one journal file
+  /// instead of each robot having a directory with its own backup files. The
+  /// journal is a memory-mapped file that backups get appended to, so writing
+  /// a backup does not need to create or rename any files. Once most of the
+  /// journal holds backups that have been replaced, the latest backup of each
+  /// robot is compacted into a new journal, and delta backups are folded into
+  /// the full backups that they apply to. By default this behavior is
+  /// turned OFF.
+  ///
+  /// This only affects groups that are made after it is set. Backups that
+  /// were written to a journal can only be read back while using a journal, and
+  /// the same goes for backups that were written to per-robot files.
+  ///
+  /// \param[in] value
+  ///   True if the behavior should be turned on; false if it should be turned
+  ///   off.
+  BackupFileManager& journal(bool value = true);
+
+  /// Set whether backups should be compressed with zstd before they are
+  /// stored, which saves a lot of writing for large backups, e.g. of tasks with
+  /// deeply nested phases. Each compressed backup starts with a magic header,
+  /// so Robot::read() and Group::restore_all() can read back both compressed
+  /// and uncompressed backups, however this is set. A backup is stored as it
+  /// is if compressing it would not make it any smaller. When backups are
+  /// written asynchronously, they are compressed on the background thread. By
+  /// default this behavior is turned OFF.
+  ///
+  /// Per-robot files are compressed from the next backup that is written.
+  /// Like journal(), this only affects the journals of groups that are made
+  /// after it is set. It has no effect if rmf_task was built without zstd.
+  ///
+  /// \param[in] value
+  ///   True if the behavior should be turned on; false if it should be turned
+  ///   off.
+  BackupFileManager& compression(bool value = true);
+
+  /// True if rmf_task was built with zstd, so that compression() has an
+  /// effect and compressed backups can be read.
+  static bool compression_supported();
+
+  /// Set how hard to try to make sure that backups survive a crash. When
+  /// backups are synchronized, the data of the file is synchronized before it
+  /// replaces the previous backup, and then the directory of the robot is
+  /// synchronized so that the replacement itself is not lost. When robots
+  /// share a journal, the record that gets appended is synchronized instead.
+  /// By default the policy is Durability::None.
+  ///
+  /// \param[in] policy
+  ///   The durability policy to use.
+  ///
+  /// \param[in] sync_period
+  ///   For Durability::Periodic, the shortest time to allow between two
+  ///   synchronizations. This is ignored by the other policies.
+  BackupFileManager& durability(
+    Durability policy,
+    rmf_traffic::Duration sync_period = std::chrono::milliseconds(500));
+
+  /// Wait until every backup that is waiting to be written by the background
+  /// thread has been written, e.g. before shutting down. This returns right
+  /// away if backups are not being written asynchronously.
+  void flush();
+
   /// Make a group (a.k.a. fleet) to back up.
   std::shared_ptr<Group> make_group(std::string name);
 
@@ -75,6 +189,38 @@ public:
   ///   The unique name of the robot that's being backed up
   std::shared_ptr<Robot> make_robot(std::string name);
 
+  /// The latest backup of each robot, keyed by the name of the robot
+  using Backups = std::unordered_map<std::string, std::string>;
+
+  /// Read the latest backup of every robot in this group at once, e.g. when
+  /// a fleet adapter starts up. The robots are found in storage, so there is
+  /// no need to call make_robot() for them first. The backups are read in
+  /// parallel on the threads of the executor() of the BackupFileManager.
+  /// Robots without a backup are left out. Reading a backup this way gives
+  /// the same result as Robot::read().
+  Backups restore_all() const;
+
+  /// The type that a decoder for restore_all() returns
+  template<typename Decode>
+  using Decoded =
+    std::invoke_result_t<Decode&, const std::string&, std::string>;
+
+  /// Read the latest backup of every robot in this group at once, and decode
+  /// each backup on the same thread that read it, e.g. to parse and validate
+  /// it before its task is restored. This way the decoding is spread over the
+  /// threads of the executor() too. If any decoder throws, the first exception
+  /// is rethrown here.
+  ///
+  /// \param[in] decode
+  ///   A callable that takes the name of a robot as a const std::string& and
+  ///   its backup as a std::string, and returns the decoded backup. It is
+  ///   called from several threads at once.
+  ///
+  /// \return the decoded backup of each robot, keyed by the name of the robot
+  template<typename Decode>
+  auto restore_all(Decode decode) const
+  -> std::unordered_map<std::string, Decoded<Decode>>;
+
   // TODO(MXG): Add an API for saving the task assignments of the Group. When
   // the Group is constructed/destructed, it should clear out those task
   // assignments, according to the RAII settings of its parent BackupFileManager
@@ -83,6 +229,16 @@ public:
   class Implementation;
 private:
   Group();
+
+  // The names of the robots of this group that may have a backup in storage
+  std::vector<std::string> _stored_robots() const;
+
+  // Read the backups of the named robots in parallel, and pass each one to
+  // consume along with the index of its robot
+  void _read_all(
+    const std::vector<std::string>& robots,
+    const std::function<void(std::size_t, std::string)>& consume) const;
+
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
 };
 
@@ -95,7 +251,10 @@ public:
   /// If a backup does not exist, return a nullopt.
   std::optional<std::string> read() const;
 
-  /// Write a backup to file
+  /// Write a backup to file. A delta backup is applied to the latest full
+  /// backup that was written for this robot. A journal records only the
+  /// delta, while per-robot files are written with the whole state. A delta
+  /// whose full backup was never written is ignored.
   void write(const Task::Active::Backup& backup);
 
   class Implementation;
@@ -106,4 +265,6 @@ private:
 
 } // namespace rmf_task
 
+#include <rmf_task/detail/impl_BackupFileManager.hpp>
+
 #endif // RMF_TASK__BACKUPFILEMANAGER_HPP
@@ -40,6 +40,35 @@ public:
 
   /// Use this to give the appropriate cost calculator to the task planner
   static std::shared_ptr<CostCalculator> make_cost_calculator();
+
+  /// Make a cost calculator that also weighs the makespan of the assignments,
+  /// i.e. the time from the earliest start of any assigned request until the
+  /// last one is finished. The cost becomes the total delay of the requests
+  /// plus makespan_weight times the makespan, both in seconds, so one search
+  /// can trade total lateness against how soon the whole batch is done.
+  ///
+  /// \param[in] makespan_weight
+  ///   How many seconds of total delay one second of makespan is worth. A
+  ///   weight of 0.0 gives the same costs as make_cost_calculator().
+  static std::shared_ptr<CostCalculator> make_cost_calculator(
+    double makespan_weight);
+
+  /// Make a cost calculator that can also use a stronger heuristic for the
+  /// optimal planner. The stronger heuristic relaxes the remaining requests of
+  /// a search node into a min-cost assignment of the requests to positions in
+  /// the queues of the agents, using the finish times that the planner has
+  /// already estimated for each agent. It remains a lower bound, so plans stay
+  /// optimal, and the search usually expands far fewer nodes, but each node
+  /// takes O(n^3 * agents) time to evaluate for n unassigned requests.
+  ///
+  /// \param[in] makespan_weight
+  ///   How many seconds of total delay one second of makespan is worth
+  ///
+  /// \param[in] assignment_bound
+  ///   Whether to use the stronger heuristic
+  static std::shared_ptr<CostCalculator> make_cost_calculator(
+    double makespan_weight,
+    bool assignment_bound);
 };
 
 } // namespace rmf_task
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__CALIBRATION_HPP
+#define RMF_TASK__CALIBRATION_HPP
+
+#include <rmf_task/Phase.hpp>
+
+#include <rmf_traffic/Time.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Correction factors for estimates, learned from how long the work that was
+/// estimated actually took. Each factor belongs to a type of work, e.g. the
+/// category of a PerformAction or travel_type(), between a pair of waypoints.
+/// The factor is a moving average of the actual durations divided by the
+/// estimated durations that were reported for it.
+///
+/// Reports and lookups may happen from any number of threads at once without
+/// locking, so a fleet can report completed phases while plans are underway.
+/// The table has a fixed capacity. Reports of new pairs are dropped once the
+/// table has no room for them near their hash.
+class Calibration
+{
+public:
+
+  /// The type of work that a TravelEstimator looks up the factors of trips
+  /// for. Report the phases of a robot moving between two waypoints with this.
+  static const std::string& travel_type();
+
+  /// Constructor
+  ///
+  /// \param[in] capacity
+  ///   How many pairs of waypoints the table can hold, rounded up to a power
+  ///   of two.
+  ///
+  /// \param[in] smoothing
+  ///   How much weight each new report gets in the moving average, between 0
+  ///   and 1. The first report of a pair sets its factor outright.
+  ///
+  /// \param[in] min_factor
+  ///   The least that a report can correct an estimate by
+  ///
+  /// \param[in] max_factor
+  ///   The most that a report can correct an estimate by
+  Calibration(
+    std::size_t capacity = 4096,
+    double smoothing = 0.2,
+    double min_factor = 0.5,
+    double max_factor = 4.0);
+
+  /// Report how long some estimated work actually took.
+  ///
+  /// \param[in] type
+  ///   The type of the work
+  ///
+  /// \param[in] start_waypoint
+  ///   The waypoint where the work started
+  ///
+  /// \param[in] finish_waypoint
+  ///   The waypoint where the work finished
+  ///
+  /// \param[in] estimate
+  ///   How long the work was estimated to take, without calibration
+  ///
+  /// \param[in] actual
+  ///   How long the work actually took
+  ///
+  /// \return false if the report was dropped, because the estimate was not
+  /// positive, the actual duration was negative, or the table was full.
+  bool report(
+    std::string_view type,
+    std::size_t start_waypoint,
+    std::size_t finish_waypoint,
+    rmf_traffic::Duration estimate,
+    rmf_traffic::Duration actual);
+
+  /// Report a completed phase. The estimate is the original duration estimate
+  /// of the header of its snapshot, and the actual duration is the time
+  /// between its start and finish.
+  bool report(
+    std::string_view type,
+    std::size_t start_waypoint,
+    std::size_t finish_waypoint,
+    const Phase::Completed& completed);
+
+  /// Get the factor to multiply an estimate of some work by. This is 1.0 for
+  /// work that has never been reported.
+  double factor(
+    std::string_view type,
+    std::size_t start_waypoint,
+    std::size_t finish_waypoint) const;
+
+  /// Get how many reports the factor of some work was learned from
+  std::size_t samples(
+    std::string_view type,
+    std::size_t start_waypoint,
+    std::size_t finish_waypoint) const;
+
+  /// Get how many reports were dropped because the table was full
+  std::size_t dropped() const;
+
+  /// Get a number that changes whenever a report changes a factor. Anything
+  /// that was estimated with this calibration at one version may need to be
+  /// estimated again once the version is different.
+  uint64_t version() const;
+
+  class Implementation;
+private:
+  rmf_utils::unique_impl_ptr<Implementation> _pimpl;
+};
+
+using ConstCalibrationPtr = std::shared_ptr<const Calibration>;
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__CALIBRATION_HPP
@@ -18,16 +18,39 @@
 #ifndef RMF_TASK__COMPOSITEDATA_HPP
 #define RMF_TASK__COMPOSITEDATA_HPP
 
+#include <rmf_task/detail/ComponentHolder.hpp>
+
 #include <rmf_utils/impl_ptr.hpp>
 
-#include <any>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
 #include <typeindex>
 
 namespace rmf_task {
 
+namespace detail {
+//==============================================================================
+/// Components whose slot is not negative are kept in a fixed inline slot of
+/// every CompositeData instead of in its type-erased map, so storing, reading
+/// and copying them never allocates. The slots are reserved for the built-in
+/// components of State, which specializes this template for each of them.
+template<typename T>
+struct InlineComponentSlot : std::integral_constant<int, -1> {};
+
+template<typename T>
+constexpr int inline_component_slot_v =
+  InlineComponentSlot<std::decay_t<T>>::value;
+} // namespace detail
+
 //==============================================================================
 /// A class that can store and return arbitrary data structures, as long as they
 /// are copyable.
+///
+/// Copies of a CompositeData share the storage of their custom components
+/// until one of the copies is modified, so copies that are only read from are
+/// cheap. A pointer that was returned by a non-const function must therefore
+/// not be used to modify a component after the CompositeData has been copied.
 //
 // TODO(MXG): Should this class move to rmf_utils? It is not very specific to
 // task planning or management.
@@ -38,6 +61,17 @@ public:
   /// Create an empty CompositeData
   CompositeData();
 
+  /// Copy a CompositeData. The copy shares the storage of the custom
+  /// components until either of them is modified.
+  CompositeData(const CompositeData& other);
+
+  /// Copy a CompositeData. The copy shares the storage of the custom
+  /// components until either of them is modified.
+  CompositeData& operator=(const CompositeData& other);
+
+  CompositeData(CompositeData&&) = default;
+  CompositeData& operator=(CompositeData&&) = default;
+
   /// The result of performing an insertion operation
   template<typename T>
   struct InsertResult
@@ -94,13 +128,47 @@ public:
   /// Remove all data structures from this CompositeData
   void clear();
 
+  /// The number of inline component slots
+  static constexpr std::size_t NumInlineSlots = 5;
+
   class Implementation;
 private:
-  std::any* _get(std::type_index type);
-  const std::any* _get(std::type_index type) const;
-  InsertResult<std::any> _insert(std::any value, bool or_assign);
-  bool _erase(std::type_index type);
-  rmf_utils::impl_ptr<Implementation> _pimpl;
+  template<typename T>
+  InsertResult<T> _insert_inline(T&& value, bool or_assign);
+
+  template<typename T>
+  T* _get_inline() const;
+
+  // Each component type that is not kept inline gets a dense ID the first
+  // time that it is used
+  template<typename T>
+  static std::size_t _id_of();
+  static std::size_t _register(const std::type_info& type);
+
+  detail::ComponentHolder* _get(std::size_t id) const;
+
+  // Same as _get, but first stops sharing the storage with any copies
+  detail::ComponentHolder* _get_mutable(std::size_t id);
+
+  InsertResult<detail::ComponentHolder> _insert(
+    std::size_t id,
+    detail::ComponentHolder value,
+    bool or_assign);
+  bool _erase(std::size_t id);
+
+  struct alignas(8) Slot
+  {
+    unsigned char bytes[8];
+  };
+
+  Slot _slots[NumInlineSlots] = {};
+  std::uint8_t _present = 0;
+
+  // Only created once a component without an inline slot is inserted, and
+  // shared between copies until one of them is modified. Storage that was
+  // ever shared is always duplicated before it is modified, since the other
+  // copies may be in use on other threads.
+  std::shared_ptr<Implementation> _pimpl;
 };
 
 } // namespace rmf_task
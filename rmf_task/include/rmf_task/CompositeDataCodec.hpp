@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__COMPOSITEDATACODEC_HPP
+#define RMF_TASK__COMPOSITEDATACODEC_HPP
+
+#include <rmf_task/CompositeData.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <typeindex>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Writes the components of a CompositeData, such as a State, as compact binary
+/// records and reads them back, so that states can be passed between processes
+/// without going through JSON. Each kind of component that should be written
+/// needs to be registered with add(). The components of State are registered
+/// by the constructor.
+///
+/// A record is a uint32_t size of the rest of the record, a uint8_t version of
+/// the record layout, and a uint16_t count of components. Each component is
+/// then written as its uint32_t tag, its uint16_t version, the uint32_t size of
+/// its data, and then its data. Numbers are written in the byte order of this
+/// machine, with no padding.
+///
+/// The components of State are written with these tags, all at version 1:
+///  - 1: State::CurrentWaypoint as a uint64_t
+///  - 2: State::CurrentOrientation as a double
+///  - 3: State::CurrentTime as an int64_t count of nanoseconds since the epoch
+///       of rmf_traffic::Time, so the processes need to share that clock
+///  - 4: State::DedicatedChargingPoint as a uint64_t
+///  - 5: State::CurrentBatterySoC as a double
+///  - 6: State::PayloadCapacity as a uint32_t
+class CompositeDataCodec
+{
+public:
+
+  /// Write a component onto the end of a buffer
+  template<typename T>
+  using Encoder = std::function<void(const T& component, std::string& buffer)>;
+
+  /// Read a component that was written with the given version. Return
+  /// std::nullopt if the data cannot be read, and the component will be
+  /// skipped.
+  template<typename T>
+  using Decoder = std::function<
+    std::optional<T>(std::string_view data, std::uint16_t version)>;
+
+  /// Make a codec that knows the components of State
+  CompositeDataCodec();
+
+  /// Register how to write and read a kind of component. If T was already
+  /// registered, then its old registration is replaced, e.g. to write a newer
+  /// version of it.
+  ///
+  /// \param[in] tag
+  ///   The number that identifies the kind of component in a record. The tags
+  ///   below 256 are reserved for the components of rmf_task.
+  ///
+  /// \param[in] version
+  ///   The version of the encoding that the encoder writes. Records keep the
+  ///   version that each component was written with, and pass it to the
+  ///   decoder, so that a decoder can keep reading older versions.
+  ///
+  /// \throws std::invalid_argument if the tag is already used by a different
+  /// kind of component.
+  template<typename T>
+  CompositeDataCodec& add(
+    std::uint32_t tag,
+    std::uint16_t version,
+    Encoder<T> encoder,
+    Decoder<T> decoder);
+
+  /// Write one record with every registered component that the data has onto
+  /// the end of a buffer. Components that are not registered are left out.
+  ///
+  /// \return the number of bytes that were written
+  std::size_t encode(const CompositeData& data, std::string& buffer) const;
+
+  /// Read one record from the start of some bytes into the data. Each
+  /// component of the record is inserted or assigned, and the other
+  /// components of the data are left as they were. Components whose tag is
+  /// not registered, or that their decoder cannot read, are skipped.
+  ///
+  /// \return the number of bytes that the record took up, so that the next
+  /// record can be read from right after it
+  ///
+  /// \throws std::runtime_error if the bytes do not hold a whole record.
+  std::size_t decode(std::string_view bytes, CompositeData& data) const;
+
+  class Implementation;
+private:
+  using Writer = std::function<bool(const CompositeData&, std::string&)>;
+  using Reader = std::function<
+    bool(std::string_view, std::uint16_t, CompositeData&)>;
+
+  void _add(
+    std::type_index type,
+    std::uint32_t tag,
+    std::uint16_t version,
+    Writer writer,
+    Reader reader);
+
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+//==============================================================================
+template<typename T>
+CompositeDataCodec& CompositeDataCodec::add(
+  const std::uint32_t tag,
+  const std::uint16_t version,
+  Encoder<T> encoder,
+  Decoder<T> decoder)
+{
+  _add(
+    typeid(T), tag, version,
+    [encoder = std::move(encoder)](
+      const CompositeData& data, std::string& buffer) -> bool
+    {
+      const T* component = data.get<T>();
+      if (!component)
+        return false;
+
+      encoder(*component, buffer);
+      return true;
+    },
+    [decoder = std::move(decoder)](
+      std::string_view bytes, std::uint16_t v, CompositeData& data) -> bool
+    {
+      auto component = decoder(bytes, v);
+      if (!component.has_value())
+        return false;
+
+      data.insert_or_assign(std::move(*component));
+      return true;
+    });
+
+  return *this;
+}
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__COMPOSITEDATACODEC_HPP
@@ -18,11 +18,18 @@
 #ifndef RMF_TASK__ESTIMATE_HPP
 #define RMF_TASK__ESTIMATE_HPP
 
+#include <cstdint>
+#include <future>
 #include <optional>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include <rmf_task/Calibration.hpp>
 #include <rmf_task/State.hpp>
+#include <rmf_task/Executor.hpp>
 #include <rmf_task/Parameters.hpp>
+#include <rmf_task/TraceSink.hpp>
 #include <rmf_traffic/Time.hpp>
 #include <rmf_traffic/agv/Planner.hpp>
 #include <rmf_utils/impl_ptr.hpp>
@@ -49,7 +56,11 @@ public:
   Estimate(State finish_state, rmf_traffic::Time wait_until);
 
   /// Finish state of the robot once it completes the request.
-  State finish_state() const;
+  const State& finish_state() const&;
+
+  /// Move the finish state out of an Estimate that is about to expire, e.g.
+  /// std::move(*estimate).finish_state(), to avoid copying it.
+  State finish_state() &&;
 
   /// Sets a new finish state for the robot.
   Estimate& finish_state(State new_finish_state);
@@ -100,6 +111,450 @@ public:
     const rmf_traffic::agv::Plan::Start& start,
     const rmf_traffic::agv::Plan::Goal& goal) const;
 
+  /// Estimate the cost of travelling from one start to each of several goals.
+  /// This gives the same results as calling estimate() for each goal, but
+  /// each shard of the cache is locked at most twice for the whole batch
+  /// instead of once or twice per goal.
+  ///
+  /// \param[in] start
+  ///   Where each trip starts
+  ///
+  /// \param[in] goals
+  ///   Where each trip ends
+  ///
+  /// \return one estimate for each goal, in the same order as the goals.
+  std::vector<std::optional<Result>> estimate(
+    const rmf_traffic::agv::Plan::Start& start,
+    const std::vector<rmf_traffic::agv::Plan::Goal>& goals) const;
+
+  /// Estimate the cost of travelling from each of several starts to each of
+  /// several goals.
+  ///
+  /// \return a matrix where element [i][j] is the estimate of travelling from
+  ///   starts[i] to goals[j].
+  std::vector<std::vector<std::optional<Result>>> estimate(
+    const std::vector<rmf_traffic::agv::Plan::Start>& starts,
+    const std::vector<rmf_traffic::agv::Plan::Goal>& goals) const;
+
+  /// Tell trips apart by the orientation they start with, and by the
+  /// orientation they must finish with if their goal has one. Orientations
+  /// are rounded to the nearest of the given number of bins, centered on
+  /// multiples of 2*pi/bins, and each trip is planned from the center of its
+  /// bins. This makes estimates account for turning, at the cost of up to
+  /// bins*(bins+1) cache entries per pair of waypoints.
+  ///
+  /// The default of 0 keys trips only on their start and goal waypoints, so
+  /// the first orientation that was asked for is used for every later trip
+  /// between the same waypoints. The table of precompute() is only used when
+  /// this is 0. Changing this forgets every cached estimate.
+  ///
+  /// \param[in] bins
+  ///   The number of orientation bins, or 0 to ignore orientations
+  TravelEstimator& orientation_bins(std::size_t bins);
+
+  /// Get the number of orientation bins, or 0 if orientations are ignored.
+  std::size_t orientation_bins() const;
+
+  /// Plan trips that were found to be unreachable again once they have been
+  /// cached for this long, in case the navigation graph has changed since.
+  /// The default of std::nullopt keeps them until they are forgotten.
+  ///
+  /// \param[in] lifetime
+  ///   How long to trust that a trip is unreachable
+  TravelEstimator& failed_plan_lifetime(
+    std::optional<rmf_traffic::Duration> lifetime);
+
+  /// Get how long a trip that was found to be unreachable stays cached
+  std::optional<rmf_traffic::Duration> failed_plan_lifetime() const;
+
+  /// Multipliers of the durations of trips that depend on the time of day, to
+  /// account for how much slower the robots get around a busy building. The
+  /// day is divided into buckets of equal width, and each zone of the
+  /// building has a multiplier for each bucket. A trip is slowed down by the
+  /// larger of the multipliers of the zones of its start and goal waypoints,
+  /// for the bucket of the time that it starts.
+  class Congestion
+  {
+  public:
+
+    /// Constructor
+    ///
+    /// \param[in] day_start
+    ///   Any time at which a day begins, e.g. the last midnight. The buckets
+    ///   repeat every day before and after it.
+    ///
+    /// \param[in] bucket_width
+    ///   How long each bucket lasts
+    ///
+    /// \param[in] buckets_per_day
+    ///   How many buckets make up a day, e.g. 24 for buckets of an hour
+    Congestion(
+      rmf_traffic::Time day_start,
+      rmf_traffic::Duration bucket_width,
+      std::size_t buckets_per_day);
+
+    /// Put a waypoint into a zone. Waypoints that were not put into any zone
+    /// belong to zone 0.
+    Congestion& waypoint_zone(std::size_t waypoint, std::size_t zone);
+
+    /// Set the multiplier of each bucket of the day for a zone. Buckets past
+    /// the end of the multipliers, and zones without multipliers, have a
+    /// multiplier of 1.0. Multipliers below 1.0 are raised to 1.0.
+    Congestion& zone_multipliers(
+      std::size_t zone,
+      std::vector<double> multipliers);
+
+    /// Get the multiplier of a trip that starts at the given time
+    double multiplier(
+      std::size_t start_waypoint,
+      std::size_t goal_waypoint,
+      rmf_traffic::Time start_time) const;
+
+    /// Check whether two congestion models have the same buckets, zones and
+    /// multipliers
+    bool operator==(const Congestion& other) const;
+
+    class Implementation;
+  private:
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
+  /// Slow down every estimate by a Congestion model. The multipliers are
+  /// applied to each estimate as it is looked up, so the cache, the table of
+  /// precompute(), and the files of save() keep the durations of an empty
+  /// building and stay valid when the congestion changes. The battery drain
+  /// of a trip is not scaled, since it mostly depends on the distance that
+  /// is driven. This must not be changed while other threads are using the
+  /// estimator.
+  ///
+  /// \param[in] congestion
+  ///   The congestion model, or std::nullopt for an empty building, which is
+  ///   the default
+  TravelEstimator& congestion(std::optional<Congestion> congestion);
+
+  /// Get the congestion model, if there is one
+  const std::optional<Congestion>& congestion() const;
+
+  /// Correct every estimate by the factor that a Calibration has learned for
+  /// Calibration::travel_type() between its start and goal waypoints. Like
+  /// the congestion, the factor is applied to each estimate as it is looked
+  /// up, so the estimates follow the reports that the calibration receives
+  /// while it is in use. The battery drain of a trip is not scaled. This must
+  /// not be changed while other threads are using the estimator.
+  ///
+  /// \param[in] calibration
+  ///   The calibration, or nullptr to leave the estimates uncorrected, which
+  ///   is the default
+  TravelEstimator& calibration(ConstCalibrationPtr calibration);
+
+  /// Get the calibration, if there is one
+  const ConstCalibrationPtr& calibration() const;
+
+  /// Get the generation of the estimates. It changes whenever
+  /// orientation_bins(), mode(), split_by_floor(), forget() or
+  /// update_planner() may have changed the estimates, so two equal
+  /// generations mean that the same trips get the same estimates, apart from
+  /// congestion and calibration.
+  uint64_t generation() const;
+
+  /// The ways that trips which are missing from the cache can be estimated
+  enum class Mode : uint8_t
+  {
+    /// Plan the complete trajectory of each trip with the planner of the
+    /// Parameters. This is the default.
+    Exact,
+
+    /// Find the quickest path over the lanes of the navigation graph instead
+    /// of planning a trajectory. Each lane is driven from rest to rest at the
+    /// nominal speed of the robot, or at the speed limit of the lane if that
+    /// is lower. Each change of heading costs a turn at the nominal rotational
+    /// speed, and the events of the lanes add their durations. The battery
+    /// drain is evaluated on a trajectory through the waypoints of the path.
+    /// This is orders of magnitude cheaper than planning and accurate enough
+    /// to compare assignments, but it ignores the orientation constraints of
+    /// the lanes. The trajectories that the robots follow are still planned
+    /// when their tasks are carried out.
+    Approximate
+  };
+
+  /// Choose how trips that are missing from the cache get estimated. Changing
+  /// this forgets every cached estimate, but not the table of precompute().
+  ///
+  /// \param[in] mode
+  ///   The way to estimate trips
+  TravelEstimator& mode(Mode mode);
+
+  /// Get the way that trips which are missing from the cache get estimated
+  Mode mode() const;
+
+  /// Estimate trips between floors by way of the portals between them instead
+  /// of keeping an estimate for every pair of waypoints on different floors.
+  /// The floors are the maps of the waypoints in the navigation graph, and the
+  /// portals are the waypoints at either end of a lane from one map to
+  /// another, like the lanes of a lift. The quickest trips between every pair
+  /// of portals are found once, from the trips between the portals of each
+  /// floor and the trips along the lanes between floors. After that, a trip
+  /// between floors is the quickest combination of a trip to a portal of its
+  /// start floor, a trip between portals, and a trip from a portal of its
+  /// goal floor, each of which is cached like any trip within a floor. The
+  /// cache then holds a number of entries that grows with the number of
+  /// waypoints times the number of portals instead of the square of the
+  /// number of waypoints.
+  ///
+  /// Robots are assumed to stop at each portal, so these estimates may be a
+  /// little longer than planning the whole trip. Trips that are already
+  /// cached and the table of precompute() are still used as they are. The
+  /// default is false.
+  ///
+  /// \param[in] enabled
+  ///   Whether to estimate trips between floors by way of their portals
+  TravelEstimator& split_by_floor(bool enabled);
+
+  /// Get whether trips between floors are estimated by way of their portals
+  bool split_by_floor() const;
+
+  /// Limit how many estimates the cache may hold. When the cache is full, the
+  /// estimates that have not been looked up recently are evicted to make room
+  /// for new ones. The limit is spread evenly across the shards of the cache,
+  /// so it is only approximate. The default of 0 means there is no limit.
+  /// Estimates in the table of precompute() do not count toward the limit.
+  ///
+  /// \param[in] max_entries
+  ///   The greatest number of estimates to keep, or 0 for no limit
+  TravelEstimator& capacity(std::size_t max_entries);
+
+  /// Get the greatest number of estimates that the cache may hold, or 0 if
+  /// there is no limit.
+  std::size_t capacity() const;
+
+  /// Fill a row of the cache whenever a trip is missing. Besides the trip that
+  /// was asked for, the trips from the same start waypoint to each of these
+  /// goal waypoints are planned right away, in parallel on executor(), so the
+  /// lookups from that start which usually follow will all hit the cache.
+  /// This is meant for the waypoints that the current requests go to. Goals
+  /// that are not in the navigation graph are ignored, and rows are only
+  /// filled while orientation_bins() is 0. This must not be changed while
+  /// other threads are using the estimator.
+  ///
+  /// \param[in] goals
+  ///   The goal waypoints of each row, or an empty list, which is the default,
+  ///   to only plan the trips that are asked for
+  TravelEstimator& row_goals(std::vector<std::size_t> goals);
+
+  /// Get the goal waypoints that a row of the cache is filled with
+  const std::vector<std::size_t>& row_goals() const;
+
+  /// Report each trip that has to be planned because it was not cached to a
+  /// TraceSink, as a "TravelEstimator::miss" section. This must not be changed
+  /// while other threads are using the estimator. A TaskPlanner that creates
+  /// its own estimator gives it the trace sink of its Configuration.
+  ///
+  /// \param[in] sink
+  ///   The sink to report to, or nullptr to stop tracing
+  TravelEstimator& trace_sink(TraceSinkPtr sink);
+
+  /// Get the sink that cache misses are reported to
+  const TraceSinkPtr& trace_sink() const;
+
+  /// Set the executor whose threads plan the trips of precompute() and
+  /// update_planner(). This must not be changed while other threads are using
+  /// the estimator. A TaskPlanner that creates its own estimator gives it the
+  /// executor of its Configuration.
+  ///
+  /// \param[in] executor
+  ///   The executor to use, or nullptr to use Executor::default_executor()
+  TravelEstimator& executor(ExecutorPtr executor);
+
+  /// Get the executor that was set for this estimator, if any
+  const ExecutorPtr& executor() const;
+
+  /// Check whether this estimator gives the same estimates as a new estimator
+  /// for some parameters would. Estimates only depend on the planner, the
+  /// motion sink and the ambient sink of the parameters, so an estimator and
+  /// its cache can be kept when only the battery thresholds, the cost
+  /// calculator or the finishing request of a planner change.
+  ///
+  /// \param[in] parameters
+  ///   The parameters to check against
+  bool serves(const Parameters& parameters) const;
+
+  /// Counters that describe how well the cache is working
+  class Statistics
+  {
+  public:
+
+    /// Default constructor
+    Statistics();
+
+    /// How many estimates were found in the cache or the precomputed table
+    std::size_t hits() const;
+
+    /// How many estimates had to be planned because they were not cached
+    std::size_t misses() const;
+
+    /// How many of the misses found that the goal cannot be reached
+    std::size_t failed_plans() const;
+
+    /// How many estimates were evicted to stay within the capacity
+    std::size_t evictions() const;
+
+    /// How many estimates are in the cache right now
+    std::size_t entries() const;
+
+    /// The total time spent planning the misses
+    rmf_traffic::Duration total_miss_latency() const;
+
+    /// The time that 99% of the misses were planned within. This is read from
+    /// a histogram, so it may overestimate by up to 19%.
+    rmf_traffic::Duration p99_miss_latency() const;
+
+    /// Get the counters that were accumulated after an earlier snapshot of the
+    /// same estimator was taken. entries() is kept as it is in this snapshot.
+    Statistics since(const Statistics& earlier) const;
+
+    class Implementation;
+  private:
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
+  /// Get a snapshot of the cache counters. This may be called while other
+  /// threads are using estimate().
+  Statistics statistics() const;
+
+  /// Set every counter back to zero, except for the number of entries. This
+  /// only resets a few atomic counters per shard, so it is cheap enough to do
+  /// before each planning run. If several planners share this estimator, use
+  /// Statistics::since() instead so they do not reset each other.
+  void reset_statistics() const;
+
+  /// Estimate the trips between every pair of waypoints in the navigation
+  /// graph ahead of time and keep them in a dense table. Afterwards, each call
+  /// to estimate() is a table lookup that never needs to plan. The table uses
+  /// memory proportional to the square of the number of waypoints. Trips are
+  /// planned with an orientation of zero at their start waypoint.
+  ///
+  /// This may be called while other threads are using estimate().
+  ///
+  /// \param[in] num_threads
+  ///   The greatest number of threads, including the calling thread, that
+  ///   will plan the trips. The others are taken from executor().
+  TravelEstimator& precompute(std::size_t num_threads = 1);
+
+  /// Do the same as precompute(), but keep the table in a file that is mapped
+  /// into memory, e.g. in /dev/shm, so that several processes which estimate
+  /// trips on the same navigation graph share one table. If the file already
+  /// holds a table for the same fingerprint as save() uses, it is mapped and
+  /// used right away without planning anything, and only a few of its trips
+  /// are planned again to check them. Otherwise the table is precomputed into
+  /// a new file which then replaces the old one. Processes that call this at
+  /// the same time wait for the first of them to finish the table. Once the
+  /// table is complete nothing writes to it, so reading it needs no locks.
+  ///
+  /// Sharing is only supported on Linux. When the file cannot be used, the
+  /// table is precomputed privately instead. update_planner() makes a private
+  /// copy of a shared table before it changes anything.
+  ///
+  /// \param[in] filename
+  ///   The path of the file to share the table through. A lock file is kept
+  ///   next to it.
+  ///
+  /// \param[in] num_threads
+  ///   The greatest number of threads, including the calling thread, that
+  ///   will plan the trips if the table has to be precomputed
+  ///
+  /// \return true if the table is shared through the file.
+  bool precompute_shared(
+    const std::string& filename,
+    std::size_t num_threads = 1);
+
+  /// Change the planner that trips are estimated with, e.g. because a lane has
+  /// been closed, and forget the estimates of every trip that begins at one of
+  /// the affected waypoints. If precompute() has been used, the rows of the
+  /// table for the affected waypoints will be planned again right away, and
+  /// the rest of the table will be kept. If the new planner has a different
+  /// number of waypoints, every estimate will be forgotten or replanned.
+  ///
+  /// This may be called while other threads are using estimate().
+  ///
+  /// \param[in] planner
+  ///   The new planner
+  ///
+  /// \param[in] affected_waypoints
+  ///   The start waypoints whose trips might have changed
+  ///
+  /// \param[in] num_threads
+  ///   The greatest number of threads, including the calling thread, that
+  ///   will plan the affected trips. The others are taken from executor().
+  TravelEstimator& update_planner(
+    std::shared_ptr<const rmf_traffic::agv::Planner> planner,
+    const std::vector<std::size_t>& affected_waypoints,
+    std::size_t num_threads = 1);
+
+  /// Plan trips in the background before they are needed, e.g. from the
+  /// agents to the pickup of a request, from its pickup to its dropoff, and
+  /// from its dropoff to the chargers, as soon as the request is submitted.
+  /// The trips are planned one after another by a single job on executor(),
+  /// and the misses of a later plan will already have been paid for. Trips
+  /// that are already cached or being planned are skipped, and waypoints that
+  /// are not in the navigation graph are ignored. Trips start with an
+  /// orientation of zero. A prefetch that has not finished when the estimator
+  /// is destroyed is cut short.
+  ///
+  /// This may be called while other threads are using estimate().
+  ///
+  /// \param[in] trips
+  ///   The start and goal waypoints of each trip
+  ///
+  /// \return a future that becomes ready once every trip has been planned
+  std::shared_future<void> prefetch(
+    std::vector<std::pair<std::size_t, std::size_t>> trips) const;
+
+  /// Forget the estimates that a change to the navigation graph may have made
+  /// stale, e.g. when lanes get closed, and keep the rest of the cache warm.
+  /// This forgets every trip that starts or finishes at one of the waypoints
+  /// or that went along one of the lanes, and every trip that could not be
+  /// planned, since any change may have made those reachable. Call this after
+  /// the new planner has been given to update_planner(). The table of
+  /// precompute() does not know the lanes of its trips, so it is only
+  /// refreshed by update_planner().
+  ///
+  /// Opening a lane can shorten trips that never went near it. Those are only
+  /// forgotten by update_planner(), given every waypoint that the new lane
+  /// may shorten trips from.
+  ///
+  /// This may be called while other threads are using estimate().
+  ///
+  /// \param[in] waypoints
+  ///   The waypoints whose trips might have changed
+  ///
+  /// \param[in] lanes
+  ///   The lanes whose trips might have changed
+  TravelEstimator& forget(
+    const std::vector<std::size_t>& waypoints,
+    const std::vector<std::size_t>& lanes);
+
+  /// Save every estimate that has been calculated so far to a compact binary
+  /// file, so that a later TravelEstimator can begin with a warm cache by
+  /// calling load(). The file is first written to a temporary path and then
+  /// renamed, so a crash while saving never leaves a corrupt file behind.
+  /// A std::runtime_error is thrown if the file cannot be written.
+  ///
+  /// \param[in] filename
+  ///   The path of the file to write
+  void save(const std::string& filename) const;
+
+  /// Load estimates that were saved by save(). Each file is stamped with a
+  /// fingerprint of the navigation graph, the vehicle traits and the power
+  /// sinks. If the file is missing, corrupt, or was saved for a different
+  /// fingerprint, nothing is loaded. A few of the loaded estimates are also
+  /// planned again to confirm that they are still accurate.
+  ///
+  /// \param[in] filename
+  ///   The path of the file to read
+  ///
+  /// \return true if the estimates were loaded.
+  bool load(const std::string& filename);
+
   class Implementation;
 private:
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
@@ -19,6 +19,7 @@
 #define RMF_TASK__EVENT_HPP
 
 #include <rmf_task/Log.hpp>
+#include <rmf_task/MemoryUsage.hpp>
 #include <rmf_task/VersionedString.hpp>
 
 #include <rmf_utils/impl_ptr.hpp>
@@ -127,8 +128,31 @@ public:
   /// Get more granular dependencies of this event, if any exist.
   virtual std::vector<ConstStatePtr> dependencies() const = 0;
 
+  /// A number that grows whenever anything about this event changes,
+  /// including its status, name, detail, log, and dependencies, or anything
+  /// about any of its dependencies. A publisher can remember the version that
+  /// it last published and skip everything below this event while the version
+  /// stays the same.
+  ///
+  /// The default implementation does not track changes, so it returns a new
+  /// version each time it is called, and the event will always look changed.
+  virtual uint64_t version() const;
+
+  /// Approximately how much memory this event and its dependencies hold on
+  /// to. The default implementation counts the log, name, and detail of this
+  /// event and adds up the memory_usage() of its dependencies.
+  virtual MemoryUsage memory_usage() const;
+
   // Virtual destructor
   virtual ~State() = default;
+
+protected:
+
+  /// Get a version number that is greater than any that has been given out
+  /// before. Implementations of version() should mark each of their changes
+  /// with one of these, so that versions can be compared across every event
+  /// in a tree.
+  static uint64_t new_version();
 };
 
 //==============================================================================
@@ -143,6 +167,19 @@ public:
   /// Make a snapshot of the current state of an Event
   static ConstSnapshotPtr make(const State& other);
 
+  /// Make a snapshot of the current state of an Event, reusing any part of a
+  /// previous snapshot of the same event whose version has not changed since.
+  ///
+  /// \param[in] other
+  ///   The event to take a snapshot of
+  ///
+  /// \param[in] previous
+  ///   A previous snapshot of the event. If this is a nullptr or a snapshot of
+  ///   a different event, nothing will be reused.
+  static ConstSnapshotPtr make(
+    const State& other,
+    const ConstSnapshotPtr& previous);
+
   // Documentation inherited
   uint64_t id() const final;
 
@@ -161,6 +198,14 @@ public:
   // Documentation inherited
   std::vector<ConstStatePtr> dependencies() const final;
 
+  /// The version of the event when this snapshot was made
+  uint64_t version() const final;
+
+  /// A snapshot shares its log, name, and detail with the event that it was
+  /// made from, so everything it holds on to is attributed to
+  /// MemoryUsage::Component::Snapshot, and its log is left out.
+  MemoryUsage memory_usage() const final;
+
   class Implementation;
 private:
   Snapshot();
@@ -176,6 +221,18 @@ public:
   /// Make a shared_ptr<AssignID>
   static AssignIDPtr make();
 
+  /// Make an AssignID whose first call to assign() gives back first_id, and
+  /// whose later calls get their IDs from source. This lets an event keep an
+  /// ID that was assigned to it before it was initialized, as long as it
+  /// assigns its own ID before those of its dependencies.
+  ///
+  /// \param[in] first_id
+  ///   An ID that was already assigned by source
+  ///
+  /// \param[in] source
+  ///   Where the IDs after the first one come from
+  static AssignIDPtr reuse(uint64_t first_id, AssignIDPtr source);
+
   /// Constructor
   AssignID();
 
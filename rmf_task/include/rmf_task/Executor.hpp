@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__EXECUTOR_HPP
+#define RMF_TASK__EXECUTOR_HPP
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+/// An interface for running jobs on background threads. The TaskPlanner, the
+/// TravelEstimator and the BackupFileManager post their background work to an
+/// Executor, so one set of long-lived threads can be shared between them
+/// instead of each of them starting threads of its own.
+///
+/// An implementation may be backed by any kind of thread pool, e.g. the one
+/// that an application already uses.
+class Executor
+{
+public:
+
+  /// Run a job on one of the background threads at some point. Jobs may be
+  /// run in any order and concurrently with each other. A job that throws an
+  /// exception must not stop the executor from running the rest of its jobs.
+  virtual void post(std::function<void()> job) = 0;
+
+  /// The number of background threads that run jobs, which is used as the
+  /// number of helpers for parallel_for() when no limit is given.
+  virtual std::size_t concurrency() const = 0;
+
+  /// Run job(i) for each i in [0, count) and block until all of them are
+  /// finished. The calling thread takes part in running the jobs, and helpers
+  /// are posted to this executor to take part as well, so this never waits on
+  /// a background thread that is busy with something else. That makes it safe
+  /// to call from a job that is running on this executor.
+  ///
+  /// If any job throws, the indices that have not started yet are skipped and
+  /// the first exception that was caught is rethrown here.
+  ///
+  /// \param[in] count
+  ///   The number of indices to run the job for
+  ///
+  /// \param[in] job
+  ///   The job to run for each index
+  ///
+  /// \param[in] max_threads
+  ///   The greatest number of threads, including the calling thread, that may
+  ///   run jobs at the same time. The default of 0 uses every background
+  ///   thread of this executor.
+  void parallel_for(
+    std::size_t count,
+    const std::function<void(std::size_t)>& job,
+    std::size_t max_threads = 0);
+
+  /// Make a work-stealing thread pool. Each worker thread keeps a queue of its
+  /// own, and takes jobs from the queues of other workers when its own queue
+  /// is empty. Jobs that were posted but have not run yet when the pool is
+  /// destroyed will still be run before the destructor returns.
+  ///
+  /// \param[in] num_threads
+  ///   The number of worker threads. At least one will be made.
+  ///
+  /// \param[in] cores
+  ///   The cores that the worker threads may run on, e.g. the cores of one
+  ///   NUMA node, so that the pool does not compete for caches with other
+  ///   work on the machine. Cores that the machine does not have are ignored.
+  ///   Pinning is only supported on Linux. The default of an empty list lets
+  ///   the workers run on any core.
+  static std::shared_ptr<Executor> make_thread_pool(
+    std::size_t num_threads,
+    std::vector<std::size_t> cores = {});
+
+  /// Get the executor that is used whenever no other executor has been given.
+  /// This is a work-stealing thread pool with one worker for each hardware
+  /// thread, which is made the first time that it is needed.
+  static const std::shared_ptr<Executor>& default_executor();
+
+  virtual ~Executor() = default;
+};
+
+using ExecutorPtr = std::shared_ptr<Executor>;
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__EXECUTOR_HPP
@@ -23,6 +23,7 @@
 
 #include <rmf_utils/impl_ptr.hpp>
 
+#include <functional>
 #include <string>
 
 namespace rmf_task {
@@ -47,12 +48,42 @@ public:
     std::string detail_,
     rmf_traffic::Duration estimate_);
 
+  /// Signature for a function that formats the details of a header
+  using MakeDetail = std::function<std::string()>;
+
+  /// Constructor for a header whose details are only formatted the first time
+  /// that detail() is called. Use this when the details are expensive to put
+  /// together and might never be read.
+  ///
+  /// \param[in] category_
+  ///   Category of the subject
+  ///
+  /// \param[in] make_detail_
+  ///   Formats the details about the subject. This will be called at most
+  ///   once, possibly from whichever thread first reads the details.
+  ///
+  /// \param[in] estimate_
+  ///   The original (ideal) estimate of how long the subject will last
+  Header(
+    std::string category_,
+    MakeDetail make_detail_,
+    rmf_traffic::Duration estimate_);
+
   /// Category of the subject
   const std::string& category() const;
 
   /// Details about the subject
   const std::string& detail() const;
 
+  /// True if detail() is a serialized JSON value. Headers that get nested
+  /// inside the detail of another header (e.g. by an event bundle) are nested
+  /// as JSON when this is true and as a plain string otherwise, so the detail
+  /// does not need to be test-parsed. This is false by default.
+  bool detail_is_json() const;
+
+  /// Say whether detail() is a serialized JSON value.
+  Header& detail_is_json(bool value);
+
   /// The original (ideal) estimate of how long the subject will last
   rmf_traffic::Duration original_duration_estimate() const;
 
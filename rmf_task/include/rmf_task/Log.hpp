@@ -22,7 +22,10 @@
 
 #include <functional>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include <rmf_traffic/Time.hpp>
 
@@ -39,6 +42,7 @@ public:
   class Entry;
   class View;
   class Reader;
+  class Retention;
 
   /// A computer-friendly ranking of how serious the log entry is.
   enum class Tier : uint32_t
@@ -54,7 +58,11 @@ public:
     Warning,
 
     /// A problem happened, and humans should be alerted.
-    Error
+    Error,
+
+    /// Details that are only useful while debugging. This is the least serious
+    /// tier. It comes last so that the other tiers keep their numbers.
+    Debug
   };
 
   /// Construct a log.
@@ -64,7 +72,26 @@ public:
   ///   std::chrono::system_clock::now() will be used.
   Log(std::function<rmf_traffic::Time()> clock = nullptr);
 
-  // TODO(MXG): Should we have a debug log option?
+  /// Construct a log whose storage comes from a memory resource.
+  ///
+  /// \param[in] clock
+  ///   Specify a clock for this log to use. If nullptr is given, then
+  ///   std::chrono::system_clock::now() will be used.
+  ///
+  /// \param[in] memory
+  ///   The memory resource that the chunks of entries of this log are
+  ///   allocated from, e.g. a pool that is shared by the logs of every task,
+  ///   or a resource with a fixed budget. The text of each entry still comes
+  ///   from the global heap. Entries may be pushed from several threads, so
+  ///   the resource must be safe to use from several threads, and it must
+  ///   outlive the log and every View of it. If nullptr is given, then
+  ///   std::pmr::get_default_resource() will be used.
+  Log(
+    std::function<rmf_traffic::Time()> clock,
+    std::pmr::memory_resource* memory);
+
+  /// Add a debugging entry to the log.
+  void debug(std::string text);
 
   /// Add an informational entry to the log.
   void info(std::string text);
@@ -75,9 +102,44 @@ public:
   /// Add an error to the log.
   void error(std::string text);
 
-  /// Push an entry of the specified severity.
+  /// Push an entry of the specified severity. Nothing is added if the tier is
+  /// less serious than the threshold() of this log.
   void push(Tier tier, std::string text);
 
+  /// Push an entry whose text is only formatted if the tier is at least as
+  /// serious as the threshold() of this log, e.g.
+  ///
+  /// \code
+  /// log.push_deferred(
+  ///   Log::Tier::Debug,
+  ///   [](std::size_t waypoint) { return "At " + std::to_string(waypoint); },
+  ///   waypoint);
+  /// \endcode
+  ///
+  /// \param[in] tier
+  ///   The severity of the entry
+  ///
+  /// \param[in] format
+  ///   A callable that returns the text of the entry, given the arguments
+  ///
+  /// \param[in] args
+  ///   The arguments to pass to the callable
+  template<typename Format, typename... Args>
+  void push_deferred(Tier tier, Format&& format, Args&&... args);
+
+  /// Set the least serious tier that this log keeps. Entries of less serious
+  /// tiers are not added by push(), debug(), info(), warn(), error(), or
+  /// push_deferred(). The default is Tier::Info, so debugging entries are
+  /// skipped unless they are asked for. Tier::Uninitialized keeps everything.
+  Log& threshold(Tier tier);
+
+  /// Get the least serious tier that this log keeps.
+  Tier threshold() const;
+
+  /// Check whether an entry of this tier would be kept. This is cheap enough
+  /// to call before building the text of every entry.
+  bool enabled(Tier tier) const;
+
   /// Insert an arbitrary entry into the log.
   void insert(Log::Entry entry);
 
@@ -86,11 +148,98 @@ public:
   /// is returned.
   View view() const;
 
+  /// The number of entries that have ever been added to this log, including
+  /// any that were dropped by its retention policy. This is a cheap way to
+  /// tell whether anything new has been logged.
+  uint64_t entry_count() const;
+
+  /// Approximately how many bytes the entries that this log keeps take up.
+  /// This walks through every entry that is kept.
+  std::size_t memory_usage() const;
+
+  /// Set how much of its history this log keeps. By default a log keeps every
+  /// entry that is added to it.
+  Log& retention(Retention value);
+
+  /// Get how much of its history this log keeps.
+  Retention retention() const;
+
   class Implementation;
 private:
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
 };
 
+//==============================================================================
+/// Limits on how much of its history a Log keeps, so that the memory used by a
+/// long-lived log stays flat. The oldest entries are dropped first, like in a
+/// ring buffer. Entries are dropped in chunks of 64 whenever the log is viewed
+/// or another chunk of entries fills up, so a log may briefly hold somewhat
+/// more than its limits allow. A Reader that falls behind will skip the entries
+/// that were dropped and report how many it missed through
+/// Reader::Iterable::dropped().
+///
+/// To keep the full history of a long-running task without keeping it all in
+/// memory, give the policy an archive file. Entries are then written to the
+/// end of that file as they are dropped, and a Reader can page them back in
+/// with Reader::read_archived().
+class Log::Retention
+{
+public:
+
+  /// Construct a retention policy that keeps every entry.
+  Retention();
+
+  /// Keep at least this many of the newest entries, and drop the ones before
+  /// them. Use std::nullopt to not limit the number of entries.
+  Retention& max_entries(std::optional<std::size_t> value);
+
+  /// Get the limit on the number of entries.
+  std::optional<std::size_t> max_entries() const;
+
+  /// Drop the oldest entries while the text of all the entries that are kept
+  /// adds up to more than this many bytes. Use std::nullopt to not limit the
+  /// size of the text.
+  Retention& max_bytes(std::optional<std::size_t> value);
+
+  /// Get the limit on the size of the text of the entries.
+  std::optional<std::size_t> max_bytes() const;
+
+  /// Drop entries whose timestamp is older than this, according to the clock
+  /// of the log. Use std::nullopt to not limit the age of entries.
+  Retention& max_age(std::optional<rmf_traffic::Duration> value);
+
+  /// Get the limit on the age of entries.
+  std::optional<rmf_traffic::Duration> max_age() const;
+
+  /// Append the entries that are dropped to the file at this path instead of
+  /// letting go of them for good. Each entry is written as a uint32_t size of
+  /// the rest of the record, the number of the entry as a uint64_t, and then
+  /// the entry in the Reader::Format::Binary format. The number of an entry
+  /// counts every entry that was added to the log before it, so it matches
+  /// the seq of pushed entries until the seq wraps around. The log keeps an
+  /// index from the number of every 64th entry to its place in the file, so
+  /// that it can be found again without reading the whole file.
+  ///
+  /// The file is written in the background by the threads of
+  /// Executor::default_executor(), so pushing to the log never waits for the
+  /// disk. If writing to the file fails, an error is added to the log and the
+  /// entries that are dropped after that are lost.
+  ///
+  /// Anything already in the file is kept, but only the entries that this log
+  /// archives can be paged back in. Use std::nullopt to stop archiving.
+  ///
+  /// \throws std::runtime_error from Log::retention() if the file cannot be
+  /// opened for appending.
+  Retention& archive(std::optional<std::string> path);
+
+  /// Get the path of the file that dropped entries are archived to.
+  const std::optional<std::string>& archive() const;
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
 //==============================================================================
 /// A single entry within the log.
 class Log::Entry
@@ -123,6 +272,12 @@ private:
 class Log::View
 {
 public:
+
+  /// Approximately how many bytes the entries that this view can see take up.
+  /// Those entries stay in memory for as long as the view exists, even if the
+  /// log drops them. This walks through every entry of the view.
+  std::size_t memory_usage() const;
+
   class Implementation;
 private:
   View();
@@ -154,6 +309,79 @@ public:
   /// \endcode
   Iterable read(const View& view);
 
+  /// The formats that read_into() can write entries in.
+  enum class Format : uint32_t
+  {
+    /// One JSON object per line, e.g.
+    ///
+    /// \code
+    /// {"seq":3,"tier":"warning","unix_millis_time":1650000000000,"text":"Hi"}
+    /// \endcode
+    ///
+    /// where tier is one of "uninitialized", "debug", "info", "warning", or
+    /// "error".
+    JsonLines,
+
+    /// One record per entry, made of the seq as a uint32_t, the tier as a
+    /// uint32_t, the time as an int64_t count of nanoseconds since the epoch,
+    /// the size of the text as a uint32_t, and then the bytes of the text.
+    /// Numbers are written in the byte order of this machine, with no padding.
+    Binary
+  };
+
+  /// Write every entry of a View that this Reader has not read yet onto the end
+  /// of a buffer. The text of each entry is written straight into the buffer,
+  /// so this avoids copying it into a string of its own like reading it with
+  /// read() would. The entries will count as read afterwards, just like with
+  /// read().
+  ///
+  /// \param[in] view
+  ///   The view to read
+  ///
+  /// \param[out] buffer
+  ///   The buffer to append the entries to. Its contents are kept, so the same
+  ///   buffer can be cleared and reused to avoid allocating each time.
+  ///
+  /// \param[in] format
+  ///   The format to write the entries in
+  ///
+  /// \return the number of entries that were written.
+  std::size_t read_into(
+    const View& view,
+    std::string& buffer,
+    Format format = Format::JsonLines);
+
+  /// Do the same as read_into() for several views at once, e.g. for the logs of
+  /// every event in a task. The entries of each view are written together, in
+  /// the order that the views are given.
+  ///
+  /// \return the number of entries that were written for each view.
+  std::vector<std::size_t> read_into(
+    const std::vector<View>& views,
+    std::string& buffer,
+    Format format = Format::JsonLines);
+
+  /// Page in entries of a log that this Reader skipped because they were
+  /// dropped into the archive of the log before it could read them, oldest
+  /// first. These are the entries that Iterable::dropped() counted. Each call
+  /// picks up where the last one stopped, so a long history can be read back
+  /// a page at a time without holding it all in memory at once.
+  ///
+  /// This waits for the entries that have been dropped so far to be written
+  /// to the archive. Entries that were dropped while the log had no archive
+  /// file, or that could not be written to it, cannot be paged in, and are
+  /// skipped.
+  ///
+  /// \param[in] view
+  ///   Any view of the log to page in from
+  ///
+  /// \param[in] max_entries
+  ///   The most entries to return
+  ///
+  /// \return the entries that were paged in. This is empty once every
+  /// skipped entry has been paged in.
+  std::vector<Entry> read_archived(const View& view, std::size_t max_entries);
+
   class Implementation;
 private:
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
@@ -173,6 +401,11 @@ public:
   /// Get the ending iterator of the read
   iterator end() const;
 
+  /// How many entries were dropped by the retention policy of the log before
+  /// this Reader could read them. These would have come right before the
+  /// first entry of this read.
+  std::size_t dropped() const;
+
   class Implementation;
 private:
   rmf_utils::impl_ptr<Implementation> _pimpl;
@@ -221,4 +454,6 @@ private:
 
 } // namespace rmf_task
 
+#include <rmf_task/detail/impl_Log.hpp>
+
 #endif // RMF_TASK__LOG_HPP
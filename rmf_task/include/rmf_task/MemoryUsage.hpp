@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__MEMORYUSAGE_HPP
+#define RMF_TASK__MEMORYUSAGE_HPP
+
+#include <array>
+#include <cstddef>
+
+namespace rmf_task {
+
+//==============================================================================
+/// An approximate account of the heap memory that an object holds on to,
+/// broken down by the component that holds it. The numbers are estimates from
+/// the sizes of the containers and strings involved, not measurements from the
+/// allocator, so they are meant for setting budgets and spotting growth, e.g.
+/// a log that is never trimmed, rather than for exact accounting.
+class MemoryUsage
+{
+public:
+
+  /// The parts of a task that memory is attributed to
+  enum class Component : std::size_t
+  {
+    /// The entries of logs
+    Log = 0,
+
+    /// Snapshots of events and phases that are being held on to
+    Snapshot,
+
+    /// The phases that have not begun yet
+    PendingPhases,
+
+    /// Backups that are being held on to, e.g. to generate delta backups
+    Backup,
+
+    /// Everything else, e.g. the names and details of events
+    Other
+  };
+
+  static constexpr std::size_t NumComponents = 5;
+
+  /// Default constructor. Every component is zero.
+  MemoryUsage();
+
+  /// The bytes attributed to a component
+  std::size_t bytes(Component component) const;
+
+  /// The bytes of every component together
+  std::size_t total() const;
+
+  /// Attribute more bytes to a component
+  MemoryUsage& add(Component component, std::size_t bytes);
+
+  /// Add every component of another account to this one
+  MemoryUsage& add(const MemoryUsage& other);
+
+private:
+  std::array<std::size_t, NumComponents> _bytes;
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__MEMORYUSAGE_HPP
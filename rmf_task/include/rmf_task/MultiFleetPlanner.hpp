@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__MULTIFLEETPLANNER_HPP
+#define RMF_TASK__MULTIFLEETPLANNER_HPP
+
+#include <rmf_task/TaskPlanner.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <variant>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Plans one pool of requests for several fleets at once, e.g. fleets of
+/// different robots that serve the same building. Each fleet has a
+/// TaskPlanner::Configuration of its own, so the requests are estimated with
+/// the parameters, constraints and TravelEstimator of whichever fleet would
+/// perform them.
+///
+/// This is a greedy approximation, not a joint search over the agents of every
+/// fleet. The requests are first allocated between the fleets one at a time.
+/// If the cost calculator of any fleet orders assignments by priority, then
+/// requests with a priority are allocated before the rest. Of the requests
+/// that are left, the one that costs the least for some agent of some fleet,
+/// according to the cost calculator of that fleet, is given to that fleet, the
+/// agent moves on to the state that the request leaves it in, and this
+/// repeats until every request has a fleet. Each fleet then plans its share
+/// of the requests with its own TaskPlanner, which orders them, adds charges
+/// and may hand them to different agents of the fleet than the allocation
+/// did. The plan of each fleet is as good as its TaskPlanner makes it, but a
+/// request is never moved to another fleet once the allocation is done, so
+/// the combined plan may cost more than the best plan across every fleet.
+///
+/// If a fleet fails to plan its share, that fleet is excluded and the
+/// requests are allocated again between the fleets that are left.
+///
+/// Every fleet must be able to make a model of every request, e.g. because
+/// the fleets share a navigation graph. A fleet whose agents cannot perform a
+/// request is not given it.
+class MultiFleetPlanner
+{
+public:
+
+  /// The assignments of each fleet, in the order of the configurations
+  using Assignments = std::vector<TaskPlanner::Assignments>;
+
+  using Result = std::variant<Assignments, TaskPlanner::TaskPlannerError>;
+
+  /// Constructor
+  ///
+  /// \param[in] planner_id
+  ///   Identifier of the planner of each fleet, to be used for booking
+  ///   automated requests
+  ///
+  /// \param[in] configurations
+  ///   The configuration of each fleet. An std::invalid_argument exception is
+  ///   thrown if this is empty.
+  ///
+  /// \param[in] default_options
+  ///   Default options for the planner of each fleet. These can be overriden
+  ///   each time a plan is requested.
+  MultiFleetPlanner(
+    const std::string& planner_id,
+    std::vector<TaskPlanner::Configuration> configurations,
+    TaskPlanner::Options default_options);
+
+  /// Get the number of fleets
+  std::size_t num_fleets() const;
+
+  /// Get the planner of a fleet, e.g. for its statistics() or its
+  /// travel_estimator(). An std::out_of_range exception is thrown if there is
+  /// no such fleet.
+  const TaskPlanner& fleet(std::size_t index) const;
+
+  /// Get a const reference to the default planning options
+  const TaskPlanner::Options& default_options() const;
+
+  /// Get a mutable reference to the default planning options
+  TaskPlanner::Options& default_options();
+
+  /// Generate assignments for requests among the agents of every fleet. The
+  /// default Options of this MultiFleetPlanner will be used.
+  ///
+  /// \param[in] time_now
+  ///   The current time when this plan is requested
+  ///
+  /// \param[in] agents
+  ///   The initial states of the agents of each fleet, in the order of the
+  ///   configurations. An std::invalid_argument exception is thrown if there
+  ///   are not as many of these as there are fleets.
+  ///
+  /// \param[in] requests
+  ///   The requests that need to be assigned among the agents of all fleets
+  Result plan(
+    rmf_traffic::Time time_now,
+    std::vector<std::vector<State>> agents,
+    std::vector<ConstRequestPtr> requests);
+
+  /// Generate assignments for requests among the agents of every fleet,
+  /// overriding the default options. Each fleet plans its share with these
+  /// options, so the agent indices that their callbacks report are indices
+  /// into the agents of one fleet. If a fleet fails to plan its share, it is
+  /// given no requests and the requests are allocated again between the other
+  /// fleets. An error is returned if the requests cannot be allocated between
+  /// the fleets that are left, or if every fleet has failed.
+  Result plan(
+    rmf_traffic::Time time_now,
+    std::vector<std::vector<State>> agents,
+    std::vector<ConstRequestPtr> requests,
+    TaskPlanner::Options options);
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__MULTIFLEETPLANNER_HPP
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__MULTILEVELPRIORITYSCHEME_HPP
+#define RMF_TASK__MULTILEVELPRIORITYSCHEME_HPP
+
+#include <rmf_task/Priority.hpp>
+#include <rmf_task/CostCalculator.hpp>
+
+#include <memory>
+
+namespace rmf_task {
+
+//==============================================================================
+/// A prioritization scheme with any number of priority levels, e.g. stat,
+/// urgent, routine and background requests in hospital logistics. Level 0 is
+/// the lowest level and higher levels are more important.
+///
+/// Instead of penalizing plans that put a request behind a less important one,
+/// like BinaryPriorityScheme does, the cost calculator of this scheme weighs
+/// the delay of each request by the weight of its level. The weight of each
+/// level is level_ratio times the weight of the level below it, so the planner
+/// only delays a more important request when that saves more than level_ratio
+/// times as much delay of less important requests.
+class MultiLevelPriorityScheme
+{
+public:
+
+  /// Make a priority of the given level. Level 0 gives a nullptr, so requests
+  /// without a priority are at the lowest level.
+  static std::shared_ptr<Priority> make_priority(std::size_t level);
+
+  /// Get the level of a priority. A nullptr is at level 0, and the high
+  /// priority of BinaryPriorityScheme is at level 1. Priorities of any other
+  /// scheme are also at level 1.
+  static std::size_t level(const ConstPriorityPtr& priority);
+
+  /// Make a cost calculator for this scheme.
+  ///
+  /// \param[in] num_levels
+  ///   How many levels are in use. Priorities above the top level are treated
+  ///   as the top level. This must be at least 1.
+  ///
+  /// \param[in] level_ratio
+  ///   How many seconds of delay at one level are worth one second of delay at
+  ///   the level above it. This must be at least 1.0.
+  ///
+  /// \throws std::invalid_argument if num_levels or level_ratio is too small
+  static std::shared_ptr<CostCalculator> make_cost_calculator(
+    std::size_t num_levels,
+    double level_ratio = 10.0);
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__MULTILEVELPRIORITYSCHEME_HPP
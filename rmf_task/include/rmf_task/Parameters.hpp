@@ -26,11 +26,19 @@
 
 #include <rmf_utils/impl_ptr.hpp>
 
+#include <memory>
+
 namespace rmf_task {
 
+class TravelEstimator;
+
 //==============================================================================
 /// A class that containts parameters that are common among the agents/AGVs
 /// available for performing requests
+///
+/// Copies of Parameters share their data until one of them is modified, so
+/// task models can keep a copy of the Parameters that they were made from for
+/// the cost of a single reference count.
 class Parameters
 {
 public:
@@ -95,10 +103,26 @@ public:
   Parameters& tool_sink(
     rmf_battery::ConstDevicePowerSinkPtr tool_sink);
 
+  /// Get the TravelEstimator that is shared by everything that uses these
+  /// parameters, or a nullptr if none has been set.
+  const std::shared_ptr<const TravelEstimator>& travel_estimator() const;
+
+  /// Set a TravelEstimator to be shared by everything that uses these
+  /// parameters, so that one warm cache of travel estimates serves every
+  /// TaskPlanner and every activity model that is made from them. It must
+  /// have been created with the same planner and power sinks as these
+  /// parameters. By default each TaskPlanner creates its own TravelEstimator
+  /// and activity models ask the planner directly.
+  Parameters& travel_estimator(
+    std::shared_ptr<const TravelEstimator> travel_estimator);
+
   class Implementation;
 
 private:
-  rmf_utils::impl_ptr<Implementation> _pimpl;
+  Implementation& _mutable();
+
+  // Shared between copies until one of them is modified
+  std::shared_ptr<Implementation> _pimpl;
 };
 
 //==============================================================================
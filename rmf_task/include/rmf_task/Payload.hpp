@@ -32,7 +32,8 @@ public:
 
   class Component;
 
-  /// Constructor
+  /// Constructor. The components cannot be changed afterwards, so copies of
+  /// this payload share them.
   Payload(std::vector<Component> components);
 
   /// Components in the payload
@@ -55,6 +56,10 @@ class Payload::Component
 public:
 
   /// Constructor
+  ///
+  /// Each distinct SKU and compartment name is only stored once, and every
+  /// component with that name refers to the same copy of it. Copying a
+  /// component does not copy its names.
   Component(
     std::string sku,
     uint32_t quantity,
@@ -132,6 +132,16 @@ public:
   /// Make a snapshot of an Active phase
   static ConstSnapshotPtr make(const Active& active);
 
+  /// Make a snapshot of an Active phase, reusing the snapshots of any events
+  /// in a previous snapshot of the phase that have not changed since. The cost
+  /// of this follows the number of events that changed rather than the size
+  /// of the event tree. If nothing about the phase has changed, the previous
+  /// snapshot itself is returned. Nothing is reused if the previous snapshot
+  /// belongs to a different phase.
+  static ConstSnapshotPtr make(
+    const Active& active,
+    const ConstSnapshotPtr& previous);
+
   // Documentation inherited
   ConstTagPtr tag() const final;
 
@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__PHASEDELTA_HPP
+#define RMF_TASK__PHASEDELTA_HPP
+
+#include <rmf_task/Phase.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Encodes each snapshot of a phase as the changes since the last snapshot of
+/// the same phase that it encoded, so that a publisher only sends what changed
+/// instead of the whole event tree at every update. Any event whose version()
+/// is unchanged since it was last encoded is skipped along with all of its
+/// dependencies. Of the events that did change, only the fields that changed
+/// are written: the status, the name, the detail, the IDs of the
+/// dependencies, and the log entries that are new.
+///
+/// The first time that an event is encoded, every field of it is written, so
+/// a new subscriber can be given a complete tree by a PhaseDelta that was
+/// just made or reset().
+class PhaseDelta
+{
+public:
+
+  /// The formats that encode() can write records in.
+  enum class Format : uint32_t
+  {
+    /// One JSON object per line for each event that changed, e.g.
+    ///
+    /// \code
+    /// {"phase":1,"event":3,"version":42,"status":"underway","log":1}
+    /// \endcode
+    ///
+    /// where "status", "name", "detail", "dependencies" and "log" are only
+    /// present when they changed. "dependencies" is an array of event IDs,
+    /// and "log" is the number of new log entries, which follow on the next
+    /// lines in the Log::Reader::Format::JsonLines format. status is one of
+    /// "uninitialized", "blocked", "error", "failed", "standby", "underway",
+    /// "delayed", "skipped", "canceled", "killed", or "completed".
+    JsonLines,
+
+    /// One record for each event that changed, made of the phase ID, the
+    /// event ID and the version as uint64_t, then a uint32_t with a bit set
+    /// for each field that changed: 1 for the status, 2 for the name, 4 for
+    /// the detail, 8 for the dependencies, and 16 for the log. Then comes each
+    /// field that changed, in that order: the status as a uint32_t, the name
+    /// and the detail as a uint32_t size followed by the bytes of the text,
+    /// the dependencies as a uint32_t count followed by a uint64_t ID each,
+    /// and the log as a uint32_t count followed by the entries in the
+    /// Log::Reader::Format::Binary format. Numbers are written in the byte
+    /// order of this machine, with no padding.
+    Binary
+  };
+
+  /// Constructor
+  PhaseDelta();
+
+  /// Write the changes of a snapshot onto the end of a buffer, and remember
+  /// them as encoded.
+  ///
+  /// \param[in] snapshot
+  ///   The snapshot of the phase
+  ///
+  /// \param[out] buffer
+  ///   The buffer to append the records to. Its contents are kept, so the
+  ///   same buffer can be cleared and reused to avoid allocating each time.
+  ///
+  /// \param[in] format
+  ///   The format to write the records in
+  ///
+  /// \return the number of events that a record was written for.
+  std::size_t encode(
+    const Phase::Snapshot& snapshot,
+    std::string& buffer,
+    Format format = Format::JsonLines);
+
+  /// Forget everything that was encoded, so that the next snapshot of each
+  /// phase is written in full.
+  void reset();
+
+  /// Forget what was encoded for one phase, e.g. once it is completed and
+  /// will not be encoded again.
+  void forget(Phase::Tag::Id phase);
+
+  class Implementation;
+private:
+  rmf_utils::unique_impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__PHASEDELTA_HPP
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__PLANNINGPROBLEM_HPP
+#define RMF_TASK__PLANNINGPROBLEM_HPP
+
+#include <rmf_task/TaskPlanner.hpp>
+
+#include <rmf_traffic/agv/Graph.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Everything that one call to TaskPlanner::plan() depends on, so that a plan
+/// which was slow in production can be captured and replayed offline, e.g. by
+/// the rmf_task_replay benchmark.
+///
+/// Only the parts of the tree that rmf_task provides can be captured:
+///  - the planner of the Parameters is captured as its graph waypoints, lanes
+///    and lane speed limits, and the speed and acceleration limits and
+///    footprint radius of its vehicle traits. Lane events are not captured.
+///  - the power sinks must be SimpleMotionPowerSink and SimpleDevicePowerSink.
+///  - the cost calculator must come from BinaryPriorityScheme or
+///    MultiLevelPriorityScheme.
+///  - the requests must be Delivery, Clean, Loop, ChargeBattery or
+///    PooledDelivery requests.
+///  - the finishing request must be made by a ChargeBatteryFactory or a
+///    ParkRobotFactory.
+///  - the interrupter, improvement and commitment callbacks, CPU affinity and
+///    memory resource of the options, and the travel estimator, trace sink,
+///    executor, partitioner, cluster solver and result cache of the
+///    configuration are not captured.
+class PlanningProblem
+{
+public:
+
+  /// Constructor
+  ///
+  /// \param[in] configuration
+  ///   The configuration of the TaskPlanner
+  ///
+  /// \param[in] options
+  ///   The options that plan() was given
+  ///
+  /// \param[in] time_now
+  ///   The time that plan() was given. Every other time of the problem is
+  ///   stored relative to this.
+  ///
+  /// \param[in] agents
+  ///   The initial states of the agents
+  ///
+  /// \param[in] requests
+  ///   The requests to assign
+  PlanningProblem(
+    TaskPlanner::Configuration configuration,
+    TaskPlanner::Options options,
+    rmf_traffic::Time time_now,
+    std::vector<State> agents,
+    std::vector<ConstRequestPtr> requests);
+
+  /// Get the configuration of the TaskPlanner
+  const TaskPlanner::Configuration& configuration() const;
+
+  /// Get the options of the plan
+  const TaskPlanner::Options& options() const;
+
+  /// Get the time that the plan begins at
+  rmf_traffic::Time time_now() const;
+
+  /// Get the initial states of the agents
+  const std::vector<State>& agents() const;
+
+  /// Get the requests to assign
+  const std::vector<ConstRequestPtr>& requests() const;
+
+  /// Get the hash of the graph of this problem. Problems that were captured
+  /// from the same site have the same hash as long as its graph is unchanged.
+  uint64_t graph_hash() const;
+
+  /// Hash the parts of a graph that a PlanningProblem captures
+  static uint64_t graph_hash(const rmf_traffic::agv::Graph& graph);
+
+  /// Serialize this problem into compact JSON.
+  ///
+  /// \throws std::invalid_argument if any part of the problem is of a type
+  /// that cannot be captured.
+  nlohmann::json serialize() const;
+
+  /// Rebuild a problem from the output of serialize().
+  ///
+  /// \param[in] json
+  ///   The serialized problem
+  ///
+  /// \param[in] time_now
+  ///   The time that the rebuilt problem begins at. Every other time of the
+  ///   problem keeps its offset from this.
+  ///
+  /// \throws std::runtime_error if the JSON is not a serialized problem, or if
+  /// its graph does not match its graph hash.
+  static PlanningProblem deserialize(
+    const nlohmann::json& json,
+    rmf_traffic::Time time_now);
+
+  /// Serialize a result of planning this problem, e.g. so that a worker of a
+  /// PlanningService can send it back. The requests of this problem are
+  /// referred to by their index, and any other requests of the assignments,
+  /// like the charging requests that the planner added, are serialized in
+  /// full. The models of the assignments are not captured.
+  ///
+  /// \throws std::invalid_argument if a request that the planner added is of
+  /// a type that cannot be captured.
+  nlohmann::json serialize_result(const TaskPlanner::Result& result) const;
+
+  /// Rebuild a result of planning this problem from the output of
+  /// serialize_result(). The assignments refer to the requests of this
+  /// problem, and their times keep their offsets from time_now().
+  ///
+  /// \throws std::runtime_error if the JSON is not a serialized result of a
+  /// problem like this one.
+  TaskPlanner::Result deserialize_result(const nlohmann::json& json) const;
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__PLANNINGPROBLEM_HPP
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__PLANNINGSERVICE_HPP
+#define RMF_TASK__PLANNINGSERVICE_HPP
+
+#include <rmf_task/PlanningProblem.hpp>
+
+#include <rmf_utils/impl_ptr.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+/// Plans a problem by dividing it into the clusters of a partitioner, e.g. one
+/// for each building of a site, and sharding those clusters out to workers
+/// that may run on other machines. Each cluster is sent to a worker as a
+/// serialized PlanningProblem, and each worker sends back the result of
+/// planning it with PlanningProblem::serialize_result(). The results are
+/// merged just like TaskPlanner::Configuration::partitioner() describes,
+/// and the requests that no cluster could plan are planned by the service
+/// itself.
+///
+/// The clusters are merged in the order of the partition, not in the order
+/// that they finish, so the plan does not depend on how many workers there
+/// are or which of them plans each cluster. It is as deterministic as the
+/// planning of each cluster, which needs Options::deterministic_seed() and
+/// no deadline or time budget.
+///
+/// This does not carry the subproblems between machines itself. Each Worker
+/// is a function that should send its subproblem to a process that calls
+/// PlanningService::work(), and return what that process gives back.
+class PlanningService
+{
+public:
+
+  /// A function that plans a serialized subproblem and returns the serialized
+  /// result. Each worker is only given one subproblem at a time, but
+  /// different workers are called from different threads at once. An
+  /// exception that a worker throws is rethrown by plan().
+  using Worker = std::function<nlohmann::json(const nlohmann::json&)>;
+
+  /// Constructor
+  ///
+  /// \param[in] partitioner
+  ///   Divides each problem into the clusters that are sent to the workers
+  ///
+  /// \param[in] workers
+  ///   The workers that plan the clusters. As many clusters are planned at
+  ///   once as there are workers. If this is empty, the clusters are planned
+  ///   by the service itself, as if every worker was PlanningService::work.
+  PlanningService(
+    TaskPlanner::Partitioner partitioner,
+    std::vector<Worker> workers);
+
+  /// Plan a problem that was captured with PlanningProblem::serialize().
+  ///
+  /// \param[in] problem
+  ///   The serialized problem
+  ///
+  /// \param[in] time_now
+  ///   The time to plan the problem at. Every other time of the problem keeps
+  ///   its offset from this.
+  ///
+  /// \throws std::runtime_error if the problem or one of the results of the
+  /// workers cannot be deserialized.
+  TaskPlanner::Result plan(
+    const nlohmann::json& problem,
+    rmf_traffic::Time time_now) const;
+
+  /// Plan a problem. Its configuration must be one that can be captured, as
+  /// described by PlanningProblem.
+  TaskPlanner::Result plan(const PlanningProblem& problem) const;
+
+  /// Plan a serialized subproblem with a TaskPlanner and serialize its result.
+  /// This is what a worker process should run for each subproblem that it is
+  /// given. Besides the result, the output says whether the search was
+  /// interrupted or pruned, like TaskPlanner::Statistics does.
+  static nlohmann::json work(const nlohmann::json& subproblem);
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__PLANNINGSERVICE_HPP
@@ -63,6 +63,13 @@ public:
   std::optional<double> battery_soc() const;
   State& battery_soc(double new_battery_soc);
 
+  /// The number of payload compartments that the robot can fill at once. The
+  /// planner uses this to decide how many deliveries a robot may carry
+  /// together. A robot without this component carries one at a time.
+  RMF_TASK_DEFINE_COMPONENT(uint32_t, PayloadCapacity);
+  std::optional<uint32_t> payload_capacity() const;
+  State& payload_capacity(uint32_t new_payload_capacity);
+
   /// Load the basic state components expected for the planner.
   ///
   /// \param[in] location
@@ -106,6 +113,30 @@ public:
   std::optional<rmf_traffic::agv::Plan::Start> extract_plan_start() const;
 };
 
+namespace detail {
+//==============================================================================
+// The built-in components of State are kept in inline slots
+template<>
+struct InlineComponentSlot<State::CurrentWaypoint>
+  : std::integral_constant<int, 0> {};
+
+template<>
+struct InlineComponentSlot<State::CurrentOrientation>
+  : std::integral_constant<int, 1> {};
+
+template<>
+struct InlineComponentSlot<State::CurrentTime>
+  : std::integral_constant<int, 2> {};
+
+template<>
+struct InlineComponentSlot<State::DedicatedChargingPoint>
+  : std::integral_constant<int, 3> {};
+
+template<>
+struct InlineComponentSlot<State::CurrentBatterySoC>
+  : std::integral_constant<int, 4> {};
+} // namespace detail
+
 } // namespace rmf_task
 
 #endif // RMF_TASK__AGV__STATE_HPP
@@ -21,6 +21,7 @@
 #include <rmf_task/Header.hpp>
 #include <rmf_task/Phase.hpp>
 #include <rmf_task/detail/Backup.hpp>
+#include <rmf_task/detail/DispatchIndex.hpp>
 #include <rmf_task/detail/Resume.hpp>
 #include <rmf_task/Constraints.hpp>
 #include <rmf_task/Parameters.hpp>
@@ -188,6 +189,51 @@ public:
   /// Estimate the invariant component of the task's duration
   virtual rmf_traffic::Duration invariant_duration() const = 0;
 
+  /// A lower bound on the battery state of charge that the task drains,
+  /// whatever state the robot starts it from. The TaskPlanner does not call
+  /// estimate_finish() for a state whose battery could not cover this much
+  /// drain and still stay above the threshold of the constraints, because
+  /// that estimate would fail anyway.
+  ///
+  /// The bound must never be larger than the drain that estimate_finish()
+  /// would subtract, or the planner will skip estimates that could have
+  /// succeeded. The default of 0.0 never skips an estimate.
+  virtual double min_battery_drain() const;
+
+  /// The part of an estimate that was worked out ahead of time for one
+  /// initial state, which can then be finished for any initial state that only
+  /// differs from it in time. See make_kernel().
+  class Kernel
+  {
+  public:
+
+    /// Finish the estimate for an initial state. The initial state must be
+    /// the same as the state that the kernel was made for, except for its
+    /// time. The result must be the same as what estimate_finish() of the
+    /// model would give for the initial state.
+    virtual std::optional<Estimate> estimate_finish(
+      const State& initial_state) const = 0;
+
+    virtual ~Kernel() = default;
+  };
+
+  using ConstKernelPtr = std::shared_ptr<const Kernel>;
+
+  /// Work out the parts of estimate_finish() that do not depend on the time
+  /// of the initial state, such as the travel to where the task begins and
+  /// the battery that it drains, so that they can be reused for initial
+  /// states that only differ in time. The TaskPlanner keeps the kernels that
+  /// it makes during a plan and uses them whenever an agent reaches the same
+  /// waypoint, orientation, and battery state of charge again.
+  ///
+  /// A kernel may refer to its model, so it must not outlive the model. The
+  /// default returns a nullptr, which means that the model has no such split
+  /// and estimate_finish() is always used.
+  virtual ConstKernelPtr make_kernel(
+    const State& initial_state,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const;
+
   virtual ~Model() = default;
 };
 
@@ -229,8 +275,15 @@ public:
     const State& initial_state,
     const Parameters& parameters) const = 0;
 
+  /// Get the dispatch index of the dynamic type of this description. The
+  /// Activator uses this to find the activator for this description.
+  std::size_t dispatch_index() const;
+
   // Virtual destructor
   virtual ~Description() = default;
+
+private:
+  detail::DispatchIndex::Cache _dispatch_index;
 };
 
 //==============================================================================
@@ -346,6 +399,15 @@ public:
   /// the discretion of the Task implementation.
   virtual void rewind(uint64_t phase_id) = 0;
 
+  /// Approximately how much memory this task is holding on to. This can be
+  /// checked periodically to catch tasks whose logs or snapshots keep growing.
+  ///
+  /// The default implementation adds up the memory_usage() of the final events
+  /// of the active and completed phases, along with the pending phases.
+  /// Implementations that hold on to more, e.g. earlier backups, should
+  /// override this to add it in.
+  virtual MemoryUsage memory_usage() const;
+
   // Virtual destructor
   virtual ~Active() = default;
 
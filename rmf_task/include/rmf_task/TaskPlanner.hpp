@@ -18,18 +18,26 @@
 #ifndef RMF_TASK__AGV__TASKPLANNER_HPP
 #define RMF_TASK__AGV__TASKPLANNER_HPP
 
+#include <rmf_task/AllocationCounter.hpp>
 #include <rmf_task/Request.hpp>
 #include <rmf_task/RequestFactory.hpp>
 #include <rmf_task/CostCalculator.hpp>
 #include <rmf_task/Constraints.hpp>
+#include <rmf_task/Estimate.hpp>
+#include <rmf_task/Executor.hpp>
 #include <rmf_task/Parameters.hpp>
 #include <rmf_task/State.hpp>
+#include <rmf_task/TraceSink.hpp>
 
 #include <rmf_utils/impl_ptr.hpp>
 
+#include <cstdint>
 #include <vector>
 #include <memory>
 #include <functional>
+#include <memory_resource>
+#include <optional>
+#include <string>
 #include <variant>
 
 namespace rmf_task {
@@ -39,6 +47,27 @@ class TaskPlanner
 {
 public:
 
+  /// Which cluster each agent and each request of a planning problem belongs
+  /// to, e.g. by map zone or by agent group
+  struct Partition
+  {
+    /// The cluster of each agent, in the same order as the agents
+    std::vector<std::size_t> agent_clusters;
+
+    /// The cluster of each request, in the same order as the requests
+    std::vector<std::size_t> request_clusters;
+  };
+
+  /// A function that divides the agents and requests of a call to plan() into
+  /// clusters that can be planned independently
+  using Partitioner = std::function<
+    Partition(
+      const std::vector<State>& agents,
+      const std::vector<ConstRequestPtr>& requests)>;
+
+  class ClusterSolver;
+  using ConstClusterSolverPtr = std::shared_ptr<const ClusterSolver>;
+
   /// The Configuration class contains planning parameters that are immutable
   /// for each TaskPlanner instance and should not change in between plans.
   class Configuration
@@ -78,12 +107,103 @@ public:
     /// BinaryPriorityCostCalculator is used by the planner.
     Configuration& cost_calculator(ConstCostCalculatorPtr cost_calculator);
 
+    /// Get the TravelEstimator that planners with this configuration will use
+    const ConstTravelEstimatorPtr& travel_estimator() const;
+
+    /// Set the TravelEstimator that planners with this configuration will use,
+    /// e.g. one that has been precomputed with TravelEstimator::precompute().
+    /// It must have been created with the same parameters as this
+    /// configuration. If a nullptr is passed, the travel estimator of the
+    /// Parameters is used, and if that is also a nullptr then each TaskPlanner
+    /// creates its own TravelEstimator which fills in its estimates lazily.
+    Configuration& travel_estimator(ConstTravelEstimatorPtr travel_estimator);
+
+    /// Get the sink that planners with this configuration report their
+    /// sections of work to
+    const TraceSinkPtr& trace_sink() const;
+
+    /// Set a sink that planners with this configuration will report their
+    /// sections of work to, such as each planning segment and each node
+    /// expansion. See TraceSink for the names of the sections. If a planner
+    /// creates its own TravelEstimator, the estimator reports its cache misses
+    /// to this sink as well. The default of nullptr disables tracing, which
+    /// leaves only a null check at each section.
+    Configuration& trace_sink(TraceSinkPtr sink);
+
+    /// Get the executor that planners with this configuration will use
+    const ExecutorPtr& executor() const;
+
+    /// Set the executor whose threads will run the parallel work of planners
+    /// with this configuration, such as expanding search nodes and estimating
+    /// candidates with Options::expansion_threads(). If a planner creates its
+    /// own TravelEstimator, the estimator uses this executor as well. The
+    /// default of nullptr uses Executor::default_executor().
+    ///
+    /// The parallel best-first solver and the partitioned clusters keep
+    /// threads of their own, since their workers wait for each other.
+    Configuration& executor(ExecutorPtr executor);
+
+    /// Get the partitioner that planners with this configuration will use
+    const Partitioner& partitioner() const;
+
+    /// Set a partitioner that divides each call to plan() into independent
+    /// clusters. Each cluster of agents is planned for its own requests, and
+    /// the clusters are planned concurrently by the thread that called plan()
+    /// and the threads of the executor(). Requests that belong to a cluster
+    /// without agents, or to a cluster that could not be planned, are planned
+    /// afterwards for all of the agents, beginning from where their cluster
+    /// assignments leave them. The merged assignments are only optimal
+    /// within each cluster, so TaskPlanner::statistics() reports no
+    /// suboptimality bound for them. The interrupter is only polled by the
+    /// thread that called plan(), which then stops every cluster.
+    ///
+    /// Sessions do not use the partitioner. The default of nullptr plans
+    /// every request for every agent at once.
+    Configuration& partitioner(Partitioner partitioner);
+
+    /// Get the solver that plans the clusters of the partitioner
+    const ConstClusterSolverPtr& cluster_solver() const;
+
+    /// Set a solver that plans each cluster of the partitioner instead of a
+    /// copy of this planner, e.g. one that sends the clusters to other
+    /// machines like PlanningService does. The leftover requests are still
+    /// planned by this planner. The default of nullptr plans the clusters in
+    /// this process.
+    Configuration& cluster_solver(ConstClusterSolverPtr solver);
+
+    /// Get how many results of plan() a planner with this configuration
+    /// remembers
+    std::size_t result_cache_size() const;
+
+    /// Set how many results of plan() a planner with this configuration
+    /// remembers. When plan() is given exactly the same problem as one whose
+    /// result it remembers, it returns that result right away instead of
+    /// planning again, and Statistics::cached() is true. This helps when the
+    /// same problem tends to be planned several times in a row, e.g. by
+    /// callbacks that fire together.
+    ///
+    /// A problem is only the same if it has the same time_now, the same
+    /// requests (the same objects, not only the same IDs) in the same order,
+    /// the same options, and agents whose waypoint, orientation, time,
+    /// dedicated charging waypoint, and battery state of charge are all
+    /// exactly equal. Results are not remembered if the search was
+    /// interrupted, or if the options have a deadline, a time budget, or an
+    /// improvement callback. Copies of a planner share what it remembers.
+    ///
+    /// The default of 0 does not remember any results.
+    Configuration& result_cache_size(std::size_t size);
+
     class Implementation;
 
   private:
     rmf_utils::impl_ptr<Implementation> _pimpl;
   };
 
+  class Assignment;
+
+  /// Container for assignments for each agent
+  using Assignments = std::vector<std::vector<Assignment>>;
+
   /// The Options class contains planning parameters that can change between
   /// each planning attempt.
   class Options
@@ -99,7 +219,8 @@ public:
     ///   which guarantees optimality but may take longer to solve.
     ///
     /// \param[in] interrupter
-    ///   A function that can determine whether the planning should be interrupted.
+    ///   A function that can determine whether the planning should be
+    ///   interrupted. See interrupter(std::function<bool()>).
     ///
     /// \param[in] finishing_request
     ///   A request factory that generates a tailored task for each agent/AGV
@@ -116,7 +237,17 @@ public:
     bool greedy() const;
 
     /// Set an interrupter callback that will indicate to the planner if it
-    /// should stop trying to plan
+    /// should stop trying to plan. It is polled between the requests whose
+    /// candidates are being estimated and while each search node is expanded,
+    /// so it should be cheap. It is only called from the thread that called
+    /// plan(), so it does not need to be thread-safe.
+    ///
+    /// If it fires while the optimal search is running, the most promising
+    /// node found so far is finished greedily and returned, and
+    /// TaskPlanner::statistics() will report that the plan was interrupted.
+    /// If it fires before the candidates of every request have been
+    /// estimated, there is nothing to finish and an empty set of assignments
+    /// is returned.
     Options& interrupter(std::function<bool()> interrupter);
 
     /// Get the interrupter that will be used in this Options
@@ -128,6 +259,474 @@ public:
     /// Get the request factory that will generate a finishing task
     ConstRequestFactoryPtr finishing_request() const;
 
+    /// Set the number of threads that the optimal (non-greedy) solver may use
+    /// to expand the children of each search node. A value of 0 or 1 means
+    /// that nodes will be expanded serially on the thread that called plan().
+    /// Both solvers also use these threads to estimate the initial candidates
+    /// of the requests in parallel. The assignments that get produced do not
+    /// depend on this value.
+    Options& expansion_threads(std::size_t value);
+
+    /// Get the number of threads that will be used to expand search nodes
+    std::size_t expansion_threads() const;
+
+    /// Set the number of workers for the parallel best-first solver. If this
+    /// is greater than 1 and greedy() is false, that many workers will pop and
+    /// expand search nodes at the same time while sharing one duplicate
+    /// filter. If the interrupter stops the search early, the best complete
+    /// solution found so far will be returned, and TaskPlanner::statistics()
+    /// will tell how far from optimal it might be.
+    Options& search_threads(std::size_t value);
+
+    /// Get the number of workers for the parallel best-first solver
+    std::size_t search_threads() const;
+
+    /// Set the cores that the threads of this planner may run on, e.g. the
+    /// cores of one NUMA node, so that planners of different fleets on the
+    /// same machine do not compete for the same caches. This pins the thread
+    /// that called plan() until planning is finished, as well as the workers
+    /// of search_threads() and of the partitioned clusters. The helpers of
+    /// expansion_threads() come from the Configuration's executor, so give it
+    /// an Executor::make_thread_pool() that is pinned to the same cores.
+    /// Pinning is only supported on Linux. The default of an empty list lets
+    /// the threads run on any core.
+    Options& cpu_affinity(std::vector<std::size_t> cores);
+
+    /// Get the cores that the threads of this planner may run on
+    const std::vector<std::size_t>& cpu_affinity() const;
+
+    /// Set how many bytes of memory to reserve up front for the search nodes
+    /// of each plan. The reserved memory is touched by the thread that called
+    /// plan() after it has been pinned by cpu_affinity(), so the operating
+    /// system places it on the NUMA node of those cores, and the search does
+    /// not need to pay for memory on another socket until the reserve runs
+    /// out. The default of 0 reserves nothing.
+    Options& arena_reserve(std::size_t bytes);
+
+    /// Get how many bytes are reserved up front for the search nodes
+    std::size_t arena_reserve() const;
+
+    /// Set the memory resource that the search nodes of each plan are
+    /// allocated from, e.g. a std::pmr::monotonic_buffer_resource over a
+    /// buffer with a fixed budget, or a pool of an embedding process. That
+    /// covers the nodes themselves, their assignments, and the unassigned
+    /// requests, candidates and invariants that each node holds, as well as
+    /// the arena_reserve(). The shared estimates of the candidates and any
+    /// other scratch space of the planner still come from the global heap.
+    ///
+    /// Each plan draws its memory through an arena of its own, which only
+    /// reaches for this resource from one thread at a time, and gives all of
+    /// its memory back once the plan is finished. The resource must outlive
+    /// every plan that uses it, and it must be safe to use from several
+    /// threads if several plans may use it at once. The default of nullptr
+    /// uses std::pmr::get_default_resource().
+    Options& memory_resource(std::pmr::memory_resource* resource);
+
+    /// Get the memory resource that the search nodes are allocated from
+    std::pmr::memory_resource* memory_resource() const;
+
+    /// Set a seed to make planning deterministic. Identical inputs with the
+    /// same seed then produce identical Assignments, e.g. so that several
+    /// dispatchers that bid on the same requests agree on the outcome:
+    /// * The ids of the ChargeBattery requests that the planner inserts are
+    ///   derived from the seed, the position of the charge in the Assignments
+    ///   and the number of deterministic plans that the planner has begun
+    ///   before, instead of being random. Planners that are given the same
+    ///   calls in the same order agree on the ids, while the charges of
+    ///   different calls to one planner get different ids.
+    /// * When search_threads() is greater than 1, the workers keep searching
+    ///   until the cheapest solution whose tie-breaking order comes first is
+    ///   proven, instead of returning the first cheapest solution that any
+    ///   worker happens to finish.
+    ///
+    /// Searches that get cut short by the interrupter, the deadline or the
+    /// time budget stop at a point that depends on timing, and so does
+    /// max_open_nodes() when search_threads() is greater than 1. The default
+    /// of std::nullopt gives random ids to the inserted charges.
+    Options& deterministic_seed(std::optional<std::uint64_t> seed);
+
+    /// Get the seed that makes planning deterministic, if there is one
+    std::optional<std::uint64_t> deterministic_seed() const;
+
+    /// Set how long a greedy plan may be improved by local search. The search
+    /// repeatedly applies the best move that lowers the cost of the plan, as
+    /// given by the CostCalculator of the Configuration, until no move lowers
+    /// it, the budget runs out, or the interrupter fires. The moves relocate a
+    /// request to another position in any agent's queue, swap two requests,
+    /// reverse a stretch of one agent's queue, or exchange the tails of the
+    /// queues of two agents. Charges are added in front of the requests that
+    /// would not have enough battery without one. The neighborhoods of the
+    /// moves are searched with the threads of expansion_threads(). This only
+    /// has an effect when greedy() is true. The default of std::nullopt skips
+    /// the local search.
+    Options& local_search_budget(std::optional<rmf_traffic::Duration> budget);
+
+    /// Get how long a greedy plan may be improved by local search
+    std::optional<rmf_traffic::Duration> local_search_budget() const;
+
+    /// Set the maximum number of nodes that the optimal (non-greedy) solver
+    /// may keep in its open list. A value of 0 means there is no limit.
+    /// Whenever the limit is exceeded, the most expensive nodes are discarded,
+    /// which bounds the memory of the search but means it might miss the
+    /// optimal solution, or even fail to find any solution.
+    /// TaskPlanner::statistics() reports when that might have happened. When
+    /// search_threads() is greater than 1, the limit is divided evenly
+    /// between the workers.
+    Options& max_open_nodes(std::size_t value);
+
+    /// Get the maximum number of nodes that the solver may keep open
+    std::size_t max_open_nodes() const;
+
+    /// Set whether the anytime approach should be used. This only has an
+    /// effect when greedy() is false. The anytime planner first finds the
+    /// greedy solution and then repeatedly searches again with an inflated
+    /// heuristic whose weight decreases each time, until the weight reaches
+    /// 1.0 and the solution is proven to be optimal. The best solution found
+    /// by any of the searches is returned. If the interrupter fires, the best
+    /// solution found so far is returned instead of nothing, and
+    /// TaskPlanner::statistics() will tell how far from optimal it might be.
+    Options& anytime(bool value);
+
+    /// Get whether the anytime approach will be used
+    bool anytime() const;
+
+    /// A callback that the anytime planner uses to report progress
+    ///
+    /// \param[in] assignments
+    ///   The best assignments found so far
+    ///
+    /// \param[in] cost
+    ///   The cost of the assignments
+    ///
+    /// \param[in] lower_bound
+    ///   A lower bound on the cost of the optimal assignments, according to
+    ///   the cost estimates of the planner
+    using ImprovementCallback = std::function<
+      void(const Assignments& assignments, double cost, double lower_bound)>;
+
+    /// Set a callback that will be triggered by the anytime planner each time
+    /// it finds better assignments or tightens the lower bound of the optimal
+    /// cost. A planner with a deadline() or time_budget() triggers it too. The
+    /// callback is triggered on the thread that called plan().
+    Options& improvement_callback(ImprovementCallback callback);
+
+    /// Get the callback that will be triggered by the anytime planner
+    const ImprovementCallback& improvement_callback() const;
+
+    /// A callback that reports the first assignment of an agent as soon as
+    /// the planner knows that it will not change
+    ///
+    /// \param[in] agent
+    ///   The index of the agent, in the order that the agents were given
+    ///
+    /// \param[in] assignment
+    ///   The first assignment of the agent in the plan that will be returned
+    using CommitmentCallback = std::function<
+      void(std::size_t agent, const Assignment& assignment)>;
+
+    /// Set a callback that will be triggered once for each agent that gets any
+    /// assignments, as soon as its first assignment is fixed, so that the
+    /// agent can begin to carry it out while the rest of the plan is still
+    /// being searched for. The callback is triggered on the thread that called
+    /// plan(). Unless plan() fails or returns an empty plan after it was
+    /// interrupted, the assignment that the callback is given is the first
+    /// assignment of that agent in the result of plan().
+    ///
+    /// The first assignment of an agent is fixed early when:
+    ///  - the optimal search of a single search thread finds that the same
+    ///    request comes first for that agent in its incumbent solution and in
+    ///    every open node, so that no solution it could still return would
+    ///    change it,
+    ///  - a segment of the search is finished with a request for the agent, or
+    ///  - the rolling_horizon() commits a request for the agent.
+    ///
+    /// A first assignment that is a charge is only fixed once a request comes
+    /// after it, since trailing charges are pruned. The anytime planner, the
+    /// deadline() and time_budget(), the neighborhood_search(), the
+    /// local_search_budget() and the partitioner of the Configuration can all
+    /// change a plan after the fact, so with any of them the first assignments
+    /// are only reported once the plan is finished, just before plan()
+    /// returns. The callback is not used by a Session.
+    Options& commitment_callback(CommitmentCallback callback);
+
+    /// Get the callback that reports the first assignment of each agent
+    const CommitmentCallback& commitment_callback() const;
+
+    /// Set a time by which plan() should return. When greedy() is false, the
+    /// planner first finds the greedy solution, which is never cut short, so
+    /// that there is always a plan to return. The optimal search (or the
+    /// anytime searches, if anytime() is true) then runs until it is finished
+    /// or until the deadline, and the best solution found by any of them is
+    /// returned. If there is a finishing_request(), a tenth of the remaining
+    /// time is kept for appending it to the assignments. The clock is only
+    /// read every few expansions, so the deadline may be overrun by the time
+    /// of those expansions plus the greedy solution. The deadline has no
+    /// effect when greedy() is true. TaskPlanner::statistics() reports whether
+    /// the deadline was reached as interrupted(). Pass std::nullopt to remove
+    /// the deadline.
+    Options& deadline(std::optional<rmf_traffic::Time> value);
+
+    /// Get the deadline of plan(), if there is one
+    std::optional<rmf_traffic::Time> deadline() const;
+
+    /// Set how long plan() may take, counted from when it is called. This
+    /// works the same as deadline(), and if both are set then whichever comes
+    /// first is used. Pass std::nullopt to remove the budget.
+    Options& time_budget(std::optional<rmf_traffic::Duration> value);
+
+    /// Get how long plan() may take, if there is a limit
+    std::optional<rmf_traffic::Duration> time_budget() const;
+
+    /// Plan long queues of requests with a rolling horizon. Instead of
+    /// searching over every request at once, the planner takes the horizon
+    /// requests that can be finished the soonest, plans them together, and
+    /// commits the commit_window assignments among them that are deployed the
+    /// earliest. The next window is then planned from the states that the
+    /// committed assignments leave the agents in. The candidates of the
+    /// requests that are still pending are kept from one window to the next
+    /// and only re-estimated for the agents whose states changed.
+    ///
+    /// The latency of each window is bounded by the horizon rather than by
+    /// the length of the queue, at the cost of only being optimal within each
+    /// window. TaskPlanner::statistics() reports no suboptimality bound for
+    /// these plans.
+    ///
+    /// \param[in] horizon
+    ///   How many requests are planned together. 0 turns the rolling horizon
+    ///   off, which is the default.
+    ///
+    /// \param[in] commit_window
+    ///   How many assignments are committed from each window. This is clamped
+    ///   to be at least 1 and at most the horizon.
+    Options& rolling_horizon(std::size_t horizon, std::size_t commit_window);
+
+    /// Get how many requests are planned together by the rolling horizon, or
+    /// 0 if it is turned off
+    std::size_t horizon() const;
+
+    /// Get how many assignments the rolling horizon commits from each window
+    std::size_t commit_window() const;
+
+    /// Set whether the greedy solver should assign, at each step, the request
+    /// and agent that can finish the soonest. The finish times of every
+    /// candidate are kept in a priority queue, and each step only adds the
+    /// new finish times of the agent that was just assigned, so greedy plans
+    /// of hundreds of requests take little more than the estimates of those
+    /// finish times. Otherwise the greedy solver expands every best candidate
+    /// of every request at each step and keeps the one with the lowest cost
+    /// estimate, which takes much longer but usually gives a cheaper plan.
+    /// This applies wherever the greedy solver is used, including the
+    /// solution that seeds the anytime planner. The default is false.
+    Options& greedy_by_finish_time(bool value);
+
+    /// Get whether the greedy solver assigns the earliest finish at each step
+    bool greedy_by_finish_time() const;
+
+    /// Run several randomized greedy solutions and keep the cheapest one, as
+    /// in a greedy randomized adaptive search. The first run is the regular
+    /// greedy solution. At each step of every other run, the children of all
+    /// the best candidates are expanded, and one is picked at random among
+    /// those whose cost estimates are within alpha of the range between the
+    /// cheapest and the most expensive child. The runs are spread over the
+    /// threads of expansion_threads(). Each run draws from a generator seeded
+    /// by deterministic_seed(), or by a fixed seed if there is none, and by
+    /// the index of the run, so the same inputs always give the same plan.
+    /// This applies wherever the greedy solver is used.
+    ///
+    /// \param[in] count
+    ///   How many greedy solutions to run. 0 and 1 both mean that only the
+    ///   regular greedy solution is run, which is the default.
+    ///
+    /// \param[in] alpha
+    ///   How far from the cheapest child a random pick may be, between 0.0
+    ///   for only the cheapest children and 1.0 for any child.
+    Options& greedy_restarts(std::size_t count, double alpha = 0.2);
+
+    /// Get how many greedy solutions are run
+    std::size_t greedy_restarts() const;
+
+    /// Get how far from the cheapest child the picks of the randomized greedy
+    /// solutions may be
+    double greedy_restart_alpha() const;
+
+    /// Plan large fleets with a large neighborhood search. A greedy plan is
+    /// found first. Then, until the budget runs out, part of the plan is torn
+    /// out and planned again with the optimal solver, and the new plan is kept
+    /// if the CostCalculator of the Configuration finds it cheaper. Since a
+    /// plan can only be extended from the end of each agent's queue, tearing
+    /// out a request also tears out the requests behind it in its queue. The
+    /// neighborhoods take turns choosing which requests are torn out: at
+    /// random, the requests that finish the longest after their earliest start
+    /// time, or the requests that finish around the same time as a random
+    /// request. Each search of the optimal solver is cut short at the end of
+    /// the budget, like with deadline(), so the plan is always ready in time.
+    /// The neighborhoods are seeded by deterministic_seed(), or by a fixed
+    /// seed if there is none. This takes precedence over greedy() but not
+    /// over rolling_horizon().
+    ///
+    /// \param[in] budget
+    ///   How long the search may take, counted from when plan() is called.
+    ///   The search also stops at the deadline() or time_budget() if they
+    ///   come first. Pass std::nullopt to turn the search off, which is the
+    ///   default.
+    ///
+    /// \param[in] neighborhood_size
+    ///   How many requests are torn out and planned again at a time
+    ///
+    /// \param[in] parallel_neighborhoods
+    ///   How many neighborhoods are planned again at the same time, each on a
+    ///   thread of its own. The cheapest of them is kept.
+    Options& neighborhood_search(
+      std::optional<rmf_traffic::Duration> budget,
+      std::size_t neighborhood_size = 8,
+      std::size_t parallel_neighborhoods = 1);
+
+    /// Get how long the large neighborhood search may take, if it is on
+    std::optional<rmf_traffic::Duration> neighborhood_search_budget() const;
+
+    /// Get how many requests the large neighborhood search plans again at a
+    /// time
+    std::size_t neighborhood_size() const;
+
+    /// Get how many neighborhoods are planned again at the same time
+    std::size_t parallel_neighborhoods() const;
+
+    /// Carry compatible Delivery requests together in one trip, as a
+    /// requests::PooledDelivery. Deliveries are pooled when every agent has
+    /// room for them in its State::PayloadCapacity, where each delivery takes
+    /// one compartment for each distinct compartment of its Payload, when they
+    /// may begin within the window of each other, and when visiting every
+    /// pickup and then every dropoff travels less than doing the deliveries
+    /// one after another. The assignments of the Result then hold the pooled
+    /// requests instead of the deliveries that they carry.
+    ///
+    /// \param[in] window
+    ///   How far apart the earliest start times of pooled deliveries may be.
+    ///   Pass std::nullopt to turn pooling off, which is the default.
+    Options& pool_deliveries(std::optional<rmf_traffic::Duration> window);
+
+    /// Get how far apart the earliest start times of pooled deliveries may be,
+    /// if pooling is on
+    std::optional<rmf_traffic::Duration> delivery_pooling_window() const;
+
+    /// Stop the optimal solver from exploring plans that only differ by which
+    /// of several interchangeable agents does what. Agents are interchangeable
+    /// when they start at the same waypoint with the same orientation,
+    /// dedicated charger and payload capacity, and their battery charge and
+    /// start time are within the tolerances of the first agent of their
+    /// group. Among the agents of a group that have no assignments yet, only
+    /// the first one may be given a task, so a fleet of identical idle robots
+    /// is searched as if it had one ordering. With zero tolerances the cost of
+    /// the plan is unchanged. Larger tolerances may give a slightly costlier
+    /// plan in exchange for a smaller search. The default is false.
+    ///
+    /// \param[in] value
+    ///   Whether to break the symmetry between interchangeable agents
+    ///
+    /// \param[in] soc_tolerance
+    ///   How far apart the battery charges of interchangeable agents may be,
+    ///   as a fraction of the battery capacity
+    ///
+    /// \param[in] time_tolerance
+    ///   How far apart the start times of interchangeable agents may be
+    Options& break_agent_symmetry(
+      bool value,
+      double soc_tolerance = 0.0,
+      rmf_traffic::Duration time_tolerance = rmf_traffic::Duration(0));
+
+    /// Get whether the symmetry between interchangeable agents is broken
+    bool break_agent_symmetry() const;
+
+    /// Get how far apart the battery charges of interchangeable agents may be
+    double agent_symmetry_soc_tolerance() const;
+
+    /// Get how far apart the start times of interchangeable agents may be
+    rmf_traffic::Duration agent_symmetry_time_tolerance() const;
+
+    /// Stop the optimal solver from exploring plans that only differ by the
+    /// order of interchangeable requests. Requests are interchangeable when
+    /// their bookings have the same earliest start time and priority and their
+    /// descriptions are Delivery, Loop, Clean or ChargeBattery descriptions
+    /// with the same fields. Among the unassigned requests of a group, only
+    /// the first one may be assigned, and plans that only swap requests of a
+    /// group are filtered out as duplicates, so a batch of identical requests
+    /// is searched as if it had one ordering. The cost of the plan is
+    /// unchanged. The default is false.
+    Options& break_request_symmetry(bool value);
+
+    /// Get whether the symmetry between interchangeable requests is broken
+    bool break_request_symmetry() const;
+
+    /// Let the single-threaded optimal solver discard search nodes that are
+    /// dominated by another node. Two nodes are compared when they have
+    /// assigned the same requests and every agent ends up at the same
+    /// waypoint in both. Since the rest of the plan only depends on when each
+    /// agent is free and how much charge it has left, a node is dominated when
+    /// another one has a cost so far that is no higher and lets every agent go
+    /// on no later and with no less charge. This keeps much fewer nodes open
+    /// than only discarding identical assignments. It does not apply while
+    /// some requests have a priority, since then the order of the assignments
+    /// matters too, nor to the parallel solver of search_threads(), whose
+    /// result would depend on which worker got to a node first. The default is
+    /// false.
+    Options& prune_dominated_nodes(bool value);
+
+    /// Get whether the optimal solver discards dominated search nodes
+    bool prune_dominated_nodes() const;
+
+    /// Let the charges that the planner inserts before a task that an agent
+    /// does not have the battery for stop as soon as the agent has enough
+    /// charge for that task, instead of always charging up to
+    /// Constraints::recharge_soc(). The charge that is needed is the threshold
+    /// of the Constraints, plus what the task drained when it was estimated
+    /// after a full charge, plus the margin. The full charge is kept whenever
+    /// the task cannot be done after the smaller one, e.g. because the agent
+    /// also needs charge to get back to its charger afterwards. The planner
+    /// still considers charging fully at the end of each assignment, so the
+    /// agent spends less time at its charger only when that makes the plan
+    /// cheaper.
+    ///
+    /// \param[in] margin
+    ///   How much charge, as a fraction of the battery capacity, to add to
+    ///   what the task needs. Pass std::nullopt to always charge up to the
+    ///   recharge level, which is the default.
+    Options& partial_charging(std::optional<double> margin);
+
+    /// Get how much charge is added to what a task needs when charges may stop
+    /// early, if they may
+    std::optional<double> partial_charging_margin() const;
+
+    /// Let the planner fill the time that an agent would spend waiting for
+    /// the earliest start time of its next task with a charge, when its
+    /// charger is close. The charge lasts as long as the agent can stay at
+    /// its charger and still reach the task in time, assuming that getting
+    /// from the charger to the task takes as long as getting to the charger.
+    /// The charge is only kept if the task finishes no later after it, so the
+    /// agent leaves for its next task with more charge and needs fewer trips
+    /// that are only for charging.
+    ///
+    /// \param[in] max_detour
+    ///   How long the trip to the charger may take for the charger to count
+    ///   as close. Pass std::nullopt to never charge while waiting, which is
+    ///   the default.
+    Options& opportunistic_charging(
+      std::optional<rmf_traffic::Duration> max_detour);
+
+    /// Get how long the trip to a charger may take for the agents to charge
+    /// while they wait, if they may
+    std::optional<rmf_traffic::Duration> opportunistic_charging_detour() const;
+
+    /// Time each call that the planner makes to Task::Model::estimate_finish()
+    /// and collect the latencies by the type of the model, to be read from
+    /// Statistics::estimate_profiles() once the plan is done. Each call then
+    /// also reads the clock twice. Results of profiled plans are not
+    /// remembered by the result cache, so that each of them measures its own
+    /// estimates. The default is false.
+    Options& profile_estimates(bool value);
+
+    /// Get whether the finish estimates of the planner are profiled
+    bool profile_estimates() const;
+
     class Implementation;
   private:
     rmf_utils::impl_ptr<Implementation> _pimpl;
@@ -147,10 +746,14 @@ public:
     ///
     /// \param[in] earliest_start_time
     ///   The earliest time the agent will begin exececuting this task
+    ///
+    /// \param[in] model
+    ///   The model that was made for the request while planning, if any
     Assignment(
       rmf_task::ConstRequestPtr request,
       State finish_state,
-      rmf_traffic::Time deployment_time);
+      rmf_traffic::Time deployment_time,
+      Task::ConstModelPtr model = nullptr);
 
     // Get the request of this task
     const rmf_task::ConstRequestPtr& request() const;
@@ -162,6 +765,17 @@ public:
     // this assignment
     const rmf_traffic::Time deployment_time() const;
 
+    /// Check whether the request of this assignment is a ChargeBattery
+    /// request. This is determined once when the assignment is constructed,
+    /// so it is cheaper than inspecting the description of the request.
+    bool is_charging() const;
+
+    /// Get the model that the planner made for the request of this assignment.
+    /// Give it to Activator::activate(~) so that the model does not need to be
+    /// made again when the task is activated. This may be a nullptr, e.g. for
+    /// charging tasks that the planner added.
+    const Task::ConstModelPtr& model() const;
+
     class Implementation;
 
   private:
@@ -182,10 +796,286 @@ public:
     limited_capacity
   };
 
-  /// Container for assignments for each agent
-  using Assignments = std::vector<std::vector<Assignment>>;
   using Result = std::variant<Assignments, TaskPlannerError>;
 
+  /// The assignments of every agent in one contiguous table of compact
+  /// records, ordered by agent and then by the order of the assignments, with
+  /// an offset into the table for each agent. Copies share the same table, so
+  /// a large plan can be returned, stored and passed between threads without
+  /// copying its assignments. The nested Assignments can be built from the
+  /// table whenever they are needed.
+  class FlatAssignments
+  {
+  public:
+
+    /// One assignment of an agent
+    struct Record
+    {
+      /// The index of the agent that the request is assigned to
+      std::size_t agent;
+
+      /// The request that is assigned
+      ConstRequestPtr request;
+
+      /// The time when the agent begins executing the request
+      rmf_traffic::Time deployment_time;
+
+      /// The time when the agent is expected to finish the request
+      rmf_traffic::Time finish_time;
+
+      /// The battery state of charge that the agent is expected to finish the
+      /// request with
+      double finish_soc;
+
+      /// The waypoint that the agent is expected to finish the request at
+      std::size_t finish_waypoint;
+    };
+
+    /// Make an empty table without any agents
+    FlatAssignments();
+
+    /// Make a table of some assignments
+    explicit FlatAssignments(const Assignments& assignments);
+
+    /// Get the number of agents in the table
+    std::size_t num_agents() const;
+
+    /// Get the number of assignments of all the agents together
+    std::size_t size() const;
+
+    /// Get every record of the table
+    const std::vector<Record>& records() const;
+
+    /// Get the offset of the first record of each agent, followed by the size
+    /// of the table, so the records of agent i are the ones from offsets()[i]
+    /// up to offsets()[i+1]
+    const std::vector<std::size_t>& offsets() const;
+
+    /// Get the first record of an agent
+    const Record* begin(std::size_t agent) const;
+
+    /// Get the end of the records of an agent
+    const Record* end(std::size_t agent) const;
+
+    /// Build the nested assignments of the table. The finish state of each
+    /// assignment is a copy of the initial state of its agent with the finish
+    /// time, state of charge and waypoint of its record, so anything else
+    /// about the state, such as the orientation, is carried over from the
+    /// initial state. The assignments do not hold the models that the planner
+    /// made for their requests.
+    ///
+    /// \param[in] agents
+    ///   The initial states of the agents that the assignments were planned
+    ///   for, with one state for each agent of the table
+    Assignments to_assignments(const std::vector<State>& agents) const;
+
+    class Implementation;
+
+  private:
+    // Shared between copies, since a table never changes once it is made
+    std::shared_ptr<const Implementation> _pimpl;
+  };
+
+  /// The result of plan_flat()
+  using FlatResult = std::variant<FlatAssignments, TaskPlannerError>;
+
+  /// A request that none of the agents are able to perform
+  struct InfeasibleRequest
+  {
+    /// The request that could not be assigned
+    ConstRequestPtr request;
+
+    /// Why no agent is able to perform the request
+    TaskPlannerError error;
+  };
+
+  /// Separate measures of how good a set of assignments is. The cost of the
+  /// planner folds these into one number, so these let the trade-offs of one
+  /// plan be reported without planning again with other cost weights.
+  /// Charging assignments are left out of every measure.
+  struct Objectives
+  {
+    /// The sum over all assigned requests of how long after its earliest start
+    /// time each request is finished, in seconds. This is the cost that the
+    /// default BinaryPriorityScheme cost calculator gives.
+    double total_delay = 0.0;
+
+    /// The part of total_delay that belongs to requests with a priority
+    double priority_delay = 0.0;
+
+    /// The longest delay of any assigned request, in seconds
+    double max_delay = 0.0;
+
+    /// The time from the earliest start time of any assigned request until
+    /// the last assigned request is finished
+    rmf_traffic::Duration makespan = rmf_traffic::Duration(0);
+
+    /// How many requests were assigned, not counting charging
+    std::size_t num_requests = 0;
+  };
+
+  /// The cheapest way to add one request to a set of assignments, as found by
+  /// evaluate_insertion()
+  struct Insertion
+  {
+    /// The agent whose assignments the request was added to
+    std::size_t agent;
+
+    /// The position of the request in the assignments of that agent. If a
+    /// charge had to be added in front of the request, it is right before
+    /// this position.
+    std::size_t position;
+
+    /// The assignments with the request added to them. The assignments that
+    /// come after the request are estimated again from the state that it
+    /// leaves the agent in.
+    Assignments assignments;
+
+    /// How much higher the cost of the assignments is with the request added
+    double cost_delta;
+  };
+
+  /// Information about how the most recent plan was found
+  class Statistics
+  {
+  public:
+
+    /// The latencies of the finish estimates of one type of task model, see
+    /// Options::profile_estimates()
+    class EstimateProfile
+    {
+    public:
+
+      /// The type of the models. This is the demangled name of the type
+      /// without a trailing "::Model" where the compiler can demangle it,
+      /// which for the requests of rmf_task and for rmf_task_sequence::Task
+      /// is the type whose Description made the models.
+      const std::string& type() const;
+
+      /// How many finish estimates were made
+      std::size_t calls() const;
+
+      /// The total time spent on the finish estimates
+      rmf_traffic::Duration total_latency() const;
+
+      /// The latency that the given fraction of the finish estimates, between
+      /// 0 and 1, finished within. This is read from the histogram, so it may
+      /// overestimate by up to 19%.
+      rmf_traffic::Duration percentile(double fraction) const;
+
+      /// The number of finish estimates in each bucket of the histogram. The
+      /// latencies in a bucket are longer than the limit of the bucket before
+      /// it and no longer than bucket_limit() of its own. The buckets get
+      /// about 19% wider each, so the histogram spans nanoseconds to hours.
+      const std::vector<std::size_t>& histogram() const;
+
+      /// The longest latency that gets counted in a bucket of histogram()
+      static rmf_traffic::Duration bucket_limit(std::size_t bucket);
+
+      class Implementation;
+    private:
+      EstimateProfile();
+      rmf_utils::impl_ptr<Implementation> _pimpl;
+    };
+
+    /// Default constructor
+    Statistics();
+
+    /// True if the interrupter stopped the search before it was finished. The
+    /// assignments that were returned are then not proven to be optimal.
+    bool interrupted() const;
+
+    /// True if Options::max_open_nodes() forced the search to discard nodes
+    /// that might have led to cheaper assignments. The suboptimality_bound()
+    /// accounts for the discarded nodes.
+    bool pruned() const;
+
+    /// An upper bound on the ratio between the cost of the returned
+    /// assignments and the cost of optimal assignments, according to the cost
+    /// estimates of each planning segment. A value of 1.0 means the
+    /// assignments are proven to be optimal. Infinity means that no bound is
+    /// known, e.g. because the greedy solver was used or no plan was found.
+    double suboptimality_bound() const;
+
+    /// How the travel estimator was used while planning, counted from the
+    /// start of the call to plan() or replan() until it returned. If other
+    /// planners share the same travel estimator at the same time, their
+    /// estimates are counted as well.
+    const TravelEstimator::Statistics& travel_estimates() const;
+
+    /// Every request that no agent was able to perform when plan() returned a
+    /// TaskPlannerError. The error of the plan is the error of the first of
+    /// these requests. This is empty if the plan did not fail that way.
+    const std::vector<InfeasibleRequest>& infeasible_requests() const;
+
+    /// The number of search nodes that were expanded
+    std::size_t nodes_expanded() const;
+
+    /// The number of newly generated search nodes that were discarded because
+    /// a node with the same assignments had already been generated, or that
+    /// were dominated by another node under Options::prune_dominated_nodes()
+    std::size_t nodes_filtered() const;
+
+    /// The number of newly generated search nodes that were discarded by the
+    /// optimal solver because their cost estimate could not beat the
+    /// incumbent, which is seeded with the greedy solution of each segment
+    std::size_t nodes_bounded() const;
+
+    /// The number of search nodes that were not generated because they would
+    /// give a task to an idle agent while an interchangeable agent before it
+    /// was also idle, or assign a request while an interchangeable request
+    /// before it was still unassigned. See Options::break_agent_symmetry() and
+    /// Options::break_request_symmetry().
+    std::size_t nodes_symmetric() const;
+
+    /// The largest number of search nodes that were waiting to be expanded at
+    /// the same time
+    std::size_t peak_open_nodes() const;
+
+    /// The number of times that the finish of a task was estimated, either by
+    /// Task::Model::estimate_finish() or by a Task::Model::Kernel
+    std::size_t finish_estimates() const;
+
+    /// The number of finish estimates that reused a Task::Model::Kernel which
+    /// had already been made for a state that only differed in time
+    std::size_t kernel_reuses() const;
+
+    /// The number of planning segments that were solved. Requests whose
+    /// earliest start times are far apart get split into segments that are
+    /// solved one after another.
+    std::size_t segments() const;
+
+    /// The latencies of the finish estimates, one profile for each type of
+    /// model that was estimated, ordered by their total latency from longest
+    /// to shortest. This is empty unless Options::profile_estimates() was
+    /// set.
+    const std::vector<EstimateProfile>& estimate_profiles() const;
+
+    /// The time spent estimating the initial candidates of the requests
+    rmf_traffic::Duration initialization_time() const;
+
+    /// The time spent searching for assignments
+    rmf_traffic::Duration search_time() const;
+
+    /// The time spent pruning the assignments and appending finishing requests
+    rmf_traffic::Duration finishing_time() const;
+
+    /// The heap allocations made from the start of the call to plan() or
+    /// replan() until it returned, broken down by subsystem. These are only
+    /// counted when AllocationCounter::enabled() is true. Allocations that
+    /// other threads make at the same time are counted as well.
+    const AllocationCounter::Counts& allocations() const;
+
+    /// True if the result was remembered from an earlier call to plan() with
+    /// the same problem. Every other statistic is then the same as it was for
+    /// that earlier call. See Configuration::result_cache_size().
+    bool cached() const;
+
+    class Implementation;
+  private:
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
   /// Constructor
   ///
   /// \param[in] configuration
@@ -218,6 +1108,28 @@ public:
   /// Get a const reference to configuration of this task planner
   const Configuration& configuration() const;
 
+  /// Change the configuration of this task planner, e.g. when its battery
+  /// thresholds or finishing request change, without throwing away what it
+  /// has cached for the parts that did not change. The TravelEstimator is
+  /// kept unless the new configuration gives one of its own or the current
+  /// one does not TravelEstimator::serves() the new parameters, or the
+  /// planner made it for a different trace sink or executor. The models of
+  /// the requests are kept unless the parameters change. The results of
+  /// Configuration::result_cache_size() are always forgotten.
+  ///
+  /// This must not be called while plan() is running on other threads.
+  /// Sessions that were already started keep the old configuration.
+  ///
+  /// \param[in] configuration
+  ///   The new configuration
+  TaskPlanner& configuration(Configuration configuration);
+
+  /// Get the TravelEstimator that this task planner uses. A new planner can
+  /// be given it through Configuration::travel_estimator() to start with its
+  /// cache, as long as it TravelEstimator::serves() the parameters of the new
+  /// planner.
+  const ConstTravelEstimatorPtr& travel_estimator() const;
+
   /// Get a const reference to the default planning options.
   const Options& default_options() const;
 
@@ -255,15 +1167,164 @@ public:
   /// \param[in] options
   ///   The options to use for this plan. This overrides the default Options of
   ///   the TaskPlanner instance
+  ///
+  /// Several threads may call plan() on the same TaskPlanner at once, e.g. to
+  /// evaluate bids in parallel. Each call plans in a context of its own, and
+  /// the calls only share the Configuration, the TravelEstimator and the
+  /// models of the requests, which are safe to use from several threads. The
+  /// default options must not be changed while other threads are planning.
   Result plan(
     rmf_traffic::Time time_now,
     std::vector<State> agents,
     std::vector<ConstRequestPtr> requests,
     Options options);
 
+  /// Generate assignments like plan() does, and return them as one flat
+  /// table. The nested assignments of the plan are released as soon as the
+  /// table is made, and the table can then be passed along without copying.
+  FlatResult plan_flat(
+    rmf_traffic::Time time_now,
+    std::vector<State> agents,
+    std::vector<ConstRequestPtr> requests,
+    Options options);
+
+  /// Find the cheapest place to add one request to a set of assignments, e.g.
+  /// to bid on the request in an auction between fleets. Every position in
+  /// the assignments of every agent is tried, and a charge is added in front
+  /// of the request wherever the battery would not last without one. The other
+  /// assignments keep their order, so this is much quicker than planning
+  /// again with all of the requests, but it may miss a cheaper plan that
+  /// reorders them.
+  ///
+  /// The estimates go through the travel estimator and the request models of
+  /// this planner, so the estimates that earlier plans made are reused.
+  ///
+  /// \param[in] time_now
+  ///   The current time, which is given to any charging request that is added
+  ///
+  /// \param[in] agents
+  ///   The initial states of the agents, which the first assignment of each
+  ///   agent begins from. An std::invalid_argument exception is thrown if
+  ///   there are not as many of these as there are lists of assignments.
+  ///
+  /// \param[in] current
+  ///   The assignments to add the request to, e.g. the result of plan()
+  ///
+  /// \param[in] request
+  ///   The request to add
+  ///
+  /// \return the cheapest insertion, or std::nullopt if no agent is able to
+  /// perform the request without making one of its other assignments fail.
+  std::optional<Insertion> evaluate_insertion(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const Assignments& current,
+    const ConstRequestPtr& request) const;
+
   /// Compute the cost of a set of assignments
   double compute_cost(const Assignments& assignments) const;
 
+  /// Compute the separate Objectives of a set of assignments
+  static Objectives compute_objectives(const Assignments& assignments);
+
+  /// Get the statistics of the call to plan() that finished most recently.
+  /// When several threads plan at once, the travel estimates of each call
+  /// include the estimates that the other calls made at the same time.
+  Statistics statistics() const;
+
+  /// A Session remembers the agents and requests of a planning problem
+  /// between plans. Changes are given to it one at a time, and the estimates
+  /// that each request has for each agent are kept from one replan() to the
+  /// next. Only the estimates that are affected by a change get recomputed, so
+  /// the cost of preparing a replan scales with the size of the change rather
+  /// than the size of the whole problem.
+  ///
+  /// A Session shares the travel estimate cache of the TaskPlanner that
+  /// started it, but otherwise it is independent of that TaskPlanner.
+  class Session
+  {
+  public:
+
+    /// Add a request that needs to be assigned
+    Session& add_request(ConstRequestPtr request);
+
+    /// Cancel a request so that it will not be assigned anymore
+    ///
+    /// \param[in] request_id
+    ///   The booking ID of the request to cancel
+    ///
+    /// \return true if a request with this ID was found and cancelled.
+    bool cancel_request(const std::string& request_id);
+
+    /// Update the state of one of the agents
+    ///
+    /// \param[in] agent
+    ///   The index of the agent, in the order that the agents were given to
+    ///   TaskPlanner::start_session(). An std::out_of_range exception is thrown
+    ///   if there is no agent with this index.
+    ///
+    /// \param[in] state
+    ///   The new initial state of the agent
+    Session& update_agent(std::size_t agent, State state);
+
+    /// Get the current initial states of the agents
+    const std::vector<State>& agents() const;
+
+    /// Get the requests that still need to be assigned
+    std::vector<ConstRequestPtr> requests() const;
+
+    /// Prepare the estimates of new requests and changed agents in the
+    /// background as soon as they are given to this Session, instead of
+    /// waiting for the next replan(). The preparation runs on the executor of
+    /// the Configuration. replan() waits for any preparation that is still in
+    /// progress, and then only estimates what has changed since.
+    ///
+    /// \param[in] clock
+    ///   Gives the time to prepare the estimates for. Estimates that were
+    ///   prepared for an earlier time than the time_now of replan() may need
+    ///   to be estimated again, so this should track the time that replan()
+    ///   will be called with. Passing nullptr, which is the default, stops
+    ///   the preparation.
+    Session& prepare_in_background(
+      std::function<rmf_traffic::Time()> clock);
+
+    /// Generate assignments for the current requests among the agents, using
+    /// the default Options of the TaskPlanner that started this Session.
+    ///
+    /// \param[in] time_now
+    ///   The current time when this plan is requested
+    Result replan(rmf_traffic::Time time_now);
+
+    /// Generate assignments for the current requests among the agents.
+    ///
+    /// \param[in] time_now
+    ///   The current time when this plan is requested
+    ///
+    /// \param[in] options
+    ///   The options to use for this plan
+    Result replan(rmf_traffic::Time time_now, Options options);
+
+    /// Get the statistics of the most recent call to replan()
+    const Statistics& statistics() const;
+
+    class Implementation;
+  private:
+    Session();
+    rmf_utils::unique_impl_ptr<Implementation> _pimpl;
+  };
+
+  /// Begin a Session that can incrementally replan as the agents and requests
+  /// change.
+  ///
+  /// \param[in] agents
+  ///   The initial states of the agents/AGVs that can undertake the requests
+  ///
+  /// \param[in] requests
+  ///   The initial set of requests that need to be assigned
+  Session start_session(
+    std::vector<State> agents,
+    std::vector<ConstRequestPtr> requests = {}) const;
+
   class Implementation;
 
 private:
@@ -271,6 +1332,52 @@ private:
 
 };
 
+//==============================================================================
+/// An interface for planning the clusters of a TaskPlanner::Partitioner
+/// somewhere other than in the planner that divided them.
+class TaskPlanner::ClusterSolver
+{
+public:
+
+  /// What solve() found for one cluster
+  struct Solution
+  {
+    /// The assignments of the agents of the cluster, or an error
+    Result result;
+
+    /// True if the search for the cluster was stopped before it was finished,
+    /// like Statistics::interrupted()
+    bool interrupted = false;
+
+    /// True if the search for the cluster discarded nodes that might have led
+    /// to cheaper assignments, like Statistics::pruned()
+    bool pruned = false;
+  };
+
+  /// Plan the requests of one cluster for the agents of that cluster. This is
+  /// called from up to concurrency() threads at once, each with a different
+  /// cluster. The options are those of the call to plan(), except that they
+  /// have no finishing request, since that is added once every cluster has
+  /// been merged. Their interrupter may be polled to find out whether the
+  /// call to plan() was interrupted.
+  ///
+  /// Return an empty set of assignments or an error for a cluster that could
+  /// not be planned, and its requests will be planned for every agent
+  /// afterwards. The statistics() of the planner report the plan as
+  /// interrupted or pruned if any cluster was. An exception that is thrown
+  /// here is rethrown by plan().
+  virtual Solution solve(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options) const = 0;
+
+  /// The greatest number of clusters that solve() should be given at once
+  virtual std::size_t concurrency() const = 0;
+
+  virtual ~ClusterSolver() = default;
+};
+
 } // namespace rmf_task
 
 #endif // RMF_TASK__AGV__TASKPLANNER_HPP
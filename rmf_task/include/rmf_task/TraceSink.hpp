@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__TRACESINK_HPP
+#define RMF_TASK__TRACESINK_HPP
+
+#include <memory>
+
+namespace rmf_task {
+
+//==============================================================================
+/// An interface for receiving the begin and end of the sections of work that
+/// the TaskPlanner and TravelEstimator go through, e.g. to forward them to a
+/// trace-event based timeline viewer.
+///
+/// Both functions are called on the thread that performs the section, so an
+/// implementation may use the current thread and time to build its events.
+/// Sections on the same thread are properly nested. Since the planner may
+/// work on several threads at once, implementations must be thread-safe.
+///
+/// The names are string literals, so they may be stored without copying.
+/// These names are currently used:
+///  - "make_initial_node": estimating the candidates of the requests
+///  - "greedy_solve", "solve", "parallel_solve": one planning segment
+///  - "expand": generating the children of one search node
+///  - "append_finishing_request": adding the finishing requests
+///  - "TravelEstimator::miss": planning a trip that was not cached
+class TraceSink
+{
+public:
+
+  /// A section of work has begun
+  virtual void begin(const char* name) = 0;
+
+  /// The section of work that most recently began on this thread has ended
+  virtual void end(const char* name) = 0;
+
+  virtual ~TraceSink() = default;
+};
+
+using TraceSinkPtr = std::shared_ptr<TraceSink>;
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__TRACESINK_HPP
@@ -32,7 +32,8 @@ public:
   class View;
   class Reader;
 
-  /// Construct a versioned string
+  /// Construct a versioned string. Versioned strings that are constructed with
+  /// the same initial value will share a single copy of it.
   ///
   /// \param[in] initial_value
   ///   The initial value of this versioned string
@@ -81,7 +82,8 @@ public:
   /// If this Reader has never seen this View before, then this function will
   /// return a reference to the string that the View contains. Otherwise, if
   /// this Reader has seen this View before, then this function will return a
-  /// nullptr.
+  /// nullptr. Telling whether the View has been seen before only compares
+  /// version numbers, so it is cheap to call on many unchanged strings.
   ///
   /// \param[in] view
   ///   The view that the Reader should look at
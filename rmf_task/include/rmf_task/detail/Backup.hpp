@@ -21,6 +21,7 @@
 #include <rmf_utils/impl_ptr.hpp>
 
 #include <cstddef>
+#include <optional>
 #include <string>
 
 namespace rmf_task {
@@ -42,18 +43,51 @@ public:
   ///   when restoring a Task.
   static Backup make(uint64_t seq, std::string state);
 
+  /// Make a delta Backup, which only describes how the state has changed
+  /// since an earlier full Backup. Tasks that issue deltas send a full Backup
+  /// from time to time, and each delta applies to the latest full Backup.
+  ///
+  /// \param[in] seq
+  ///   Sequence number of this Backup.
+  ///
+  /// \param[in] base_seq
+  ///   Sequence number of the full Backup that this delta applies to.
+  ///
+  /// \param[in] patch
+  ///   A JSON Patch (RFC 6902) which turns the JSON state of the full Backup
+  ///   into the current state. Use apply_delta(~) to get the current state.
+  static Backup make_delta(uint64_t seq, uint64_t base_seq, std::string patch);
+
+  /// Apply the patch of a delta Backup to the state of its full Backup.
+  ///
+  /// \param[in] base_state
+  ///   The JSON state of the full Backup that the delta applies to.
+  ///
+  /// \param[in] patch
+  ///   The state of the delta Backup.
+  ///
+  /// \return the JSON state that the delta Backup describes.
+  static std::string apply_delta(
+    const std::string& base_state,
+    const std::string& patch);
+
   /// Get the sequence number for this backup.
   uint64_t sequence() const;
 
   /// Set the sequence number for this backup.
   Backup& sequence(uint64_t seq);
 
-  /// Get the serialized state for this backup.
+  /// Get the serialized state for this backup. For a delta Backup this is the
+  /// patch to apply to the state of its full Backup.
   const std::string& state() const;
 
   /// Set the serialized state for this backup.
   Backup& state(std::string new_state);
 
+  /// If this is a delta Backup, get the sequence number of the full Backup
+  /// that it applies to. For a full Backup this is std::nullopt.
+  std::optional<uint64_t> base_sequence() const;
+
   class Implementation;
 private:
   Backup();
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__DETAIL__COMPONENTHOLDER_HPP
+#define RMF_TASK__DETAIL__COMPONENTHOLDER_HPP
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace rmf_task {
+namespace detail {
+
+//==============================================================================
+/// A type-erased holder for one copyable component of a CompositeData. Unlike
+/// std::any, it does not remember the type of its value, because CompositeData
+/// already finds each component by the ID of its type. Values that fit in its
+/// inline buffer are stored without allocating.
+class ComponentHolder
+{
+public:
+
+  /// Values up to this size are stored inline
+  static constexpr std::size_t BufferSize = 48;
+
+  template<typename T>
+  static constexpr bool fits_inline =
+    sizeof(T) <= BufferSize
+    && alignof(T) <= alignof(std::max_align_t)
+    && std::is_nothrow_move_constructible_v<T>;
+
+  /// Hold a value
+  template<typename T>
+  explicit ComponentHolder(T value)
+  : _ops(&ops_for<T>())
+  {
+    if constexpr (fits_inline<T>)
+      new (_buffer) T(std::move(value));
+    else
+      _heap = new T(std::move(value));
+  }
+
+  ComponentHolder(const ComponentHolder& other)
+  : _ops(other._ops)
+  {
+    _ops->copy(other, *this);
+  }
+
+  ComponentHolder(ComponentHolder&& other) noexcept
+  : _ops(other._ops)
+  {
+    _ops->move(other, *this);
+  }
+
+  ComponentHolder& operator=(const ComponentHolder& other)
+  {
+    if (this != &other)
+    {
+      ComponentHolder copy(other);
+      *this = std::move(copy);
+    }
+
+    return *this;
+  }
+
+  ComponentHolder& operator=(ComponentHolder&& other) noexcept
+  {
+    if (this != &other)
+    {
+      _ops->destroy(*this);
+      _ops = other._ops;
+      _ops->move(other, *this);
+    }
+
+    return *this;
+  }
+
+  ~ComponentHolder()
+  {
+    _ops->destroy(*this);
+  }
+
+  /// Get the value. T must be the type that the value was created with.
+  template<typename T>
+  T* get()
+  {
+    if constexpr (fits_inline<T>)
+      return std::launder(reinterpret_cast<T*>(_buffer));
+    else
+      return static_cast<T*>(_heap);
+  }
+
+private:
+
+  struct Ops
+  {
+    void (* copy)(const ComponentHolder& from, ComponentHolder& to);
+    void (* move)(ComponentHolder& from, ComponentHolder& to);
+    void (* destroy)(ComponentHolder& holder);
+  };
+
+  template<typename T>
+  static const Ops& ops_for()
+  {
+    static const Ops ops = {
+      [](const ComponentHolder& from, ComponentHolder& to)
+      {
+        const T& value = *const_cast<ComponentHolder&>(from).get<T>();
+        if constexpr (fits_inline<T>)
+          new (to._buffer) T(value);
+        else
+          to._heap = new T(value);
+      },
+      [](ComponentHolder& from, ComponentHolder& to)
+      {
+        if constexpr (fits_inline<T>)
+        {
+          new (to._buffer) T(std::move(*from.get<T>()));
+        }
+        else
+        {
+          // The moved-from holder is left empty
+          to._heap = from._heap;
+          from._heap = nullptr;
+        }
+      },
+      [](ComponentHolder& holder)
+      {
+        if constexpr (fits_inline<T>)
+          holder.get<T>()->~T();
+        else
+          delete holder.get<T>();
+      }
+    };
+
+    return ops;
+  }
+
+  const Ops* _ops;
+
+  union
+  {
+    alignas(std::max_align_t) unsigned char _buffer[BufferSize];
+    void* _heap;
+  };
+};
+
+} // namespace detail
+} // namespace rmf_task
+
+#endif // RMF_TASK__DETAIL__COMPONENTHOLDER_HPP
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__DETAIL__DISPATCHINDEX_HPP
+#define RMF_TASK__DETAIL__DISPATCHINDEX_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <typeindex>
+
+namespace rmf_task {
+namespace detail {
+
+//==============================================================================
+/// Gives each type that activators get registered for a small number which is
+/// unique within the process. Activators keep their callbacks in flat tables
+/// indexed by these numbers, so dispatching on the dynamic type of a
+/// description does not need to hash its type.
+class DispatchIndex
+{
+public:
+
+  /// Get the dispatch index of a type, assigning a new one if the type does
+  /// not have one yet.
+  static std::size_t of(std::type_index type);
+
+  class Cache;
+};
+
+//==============================================================================
+/// Remembers the dispatch index of the dynamic type of the object that holds
+/// it, so the index is only looked up the first time it is needed.
+class DispatchIndex::Cache
+{
+public:
+
+  Cache() = default;
+
+  // The dynamic type of a copy may be different from the original, so the
+  // index is never copied.
+  Cache(const Cache&);
+  Cache& operator=(const Cache&);
+
+  /// Get the dispatch index of the dynamic type of the object holding this
+  /// cache.
+  std::size_t get(const std::type_info& dynamic_type) const;
+
+private:
+  // Zero means the index has not been looked up yet. Otherwise this is one
+  // more than the index.
+  mutable std::atomic<std::size_t> _value{0};
+};
+
+} // namespace detail
+} // namespace rmf_task
+
+#endif // RMF_TASK__DETAIL__DISPATCHINDEX_HPP
@@ -33,6 +33,7 @@ void Activator::add_activator(Activate<Description> activator)
       const ConstParametersPtr& parameters,
       const Task::ConstBookingPtr& booking,
       const Task::Description& description,
+      Task::ConstModelPtr,
       std::optional<std::string> backup_state,
       std::function<void(Phase::ConstSnapshotPtr)> update,
       std::function<void(Task::Active::Backup)> checkpoint,
@@ -52,6 +53,38 @@ void Activator::add_activator(Activate<Description> activator)
     });
 }
 
+//==============================================================================
+template<typename Description>
+void Activator::add_activator(ActivatePlanned<Description> activator)
+{
+  _add_activator(
+    typeid(Description),
+    [activator](
+      std::function<State()> get_state,
+      const ConstParametersPtr& parameters,
+      const Task::ConstBookingPtr& booking,
+      const Task::Description& description,
+      Task::ConstModelPtr model,
+      std::optional<std::string> backup_state,
+      std::function<void(Phase::ConstSnapshotPtr)> update,
+      std::function<void(Task::Active::Backup)> checkpoint,
+      std::function<void(Phase::ConstCompletedPtr)> phase_finished,
+      std::function<void()> task_finished) -> Task::ActivePtr
+    {
+      return activator(
+        std::move(get_state),
+        parameters,
+        booking,
+        static_cast<const Description&>(description),
+        std::move(model),
+        std::move(backup_state),
+        std::move(update),
+        std::move(checkpoint),
+        std::move(phase_finished),
+        std::move(task_finished));
+    });
+}
+
 } // namespace rmf_task
 
 #endif // RMF_TASK__DETAIL__IMPL_ACTIVATOR_HPP
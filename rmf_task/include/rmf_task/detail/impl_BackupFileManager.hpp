@@ -0,0 +1,53 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__DETAIL__IMPL_BACKUPFILEMANAGER_HPP
+#define RMF_TASK__DETAIL__IMPL_BACKUPFILEMANAGER_HPP
+
+#include <rmf_task/BackupFileManager.hpp>
+
+namespace rmf_task {
+
+//==============================================================================
+template<typename Decode>
+auto BackupFileManager::Group::restore_all(Decode decode) const
+-> std::unordered_map<std::string, Decoded<Decode>>
+{
+  const auto robots = _stored_robots();
+
+  // Each thread only touches the slot of its own robot
+  std::vector<std::optional<Decoded<Decode>>> decoded(robots.size());
+  _read_all(
+    robots,
+    [&](std::size_t i, std::string backup)
+    {
+      decoded[i].emplace(decode(robots[i], std::move(backup)));
+    });
+
+  std::unordered_map<std::string, Decoded<Decode>> output;
+  for (std::size_t i = 0; i < robots.size(); ++i)
+  {
+    if (decoded[i].has_value())
+      output.emplace(robots[i], std::move(*decoded[i]));
+  }
+
+  return output;
+}
+
+} // namespace rmf_task
+
+#endif // RMF_TASK__DETAIL__IMPL_BACKUPFILEMANAGER_HPP
@@ -20,15 +20,17 @@
 
 #include <rmf_task/CompositeData.hpp>
 
+#include <new>
+
 namespace rmf_task {
 
 namespace detail {
 //==============================================================================
 template<typename T>
 CompositeData::InsertResult<T> insertion_cast(
-  CompositeData::InsertResult<std::any> result)
+  CompositeData::InsertResult<ComponentHolder> result)
 {
-  return {result.inserted, std::any_cast<T>(result.value)};
+  return {result.inserted, result.value->get<T>()};
 }
 } // namespace detail
 
@@ -36,14 +38,22 @@ CompositeData::InsertResult<T> insertion_cast(
 template<typename T>
 auto CompositeData::insert(T&& value) -> InsertResult<T>
 {
-  return detail::insertion_cast<T>(_insert(std::any(std::move(value)), false));
+  if constexpr (detail::inline_component_slot_v<T> >= 0)
+    return _insert_inline<T>(std::move(value), false);
+  else
+    return detail::insertion_cast<T>(
+      _insert(_id_of<T>(), detail::ComponentHolder(std::move(value)), false));
 }
 
 //==============================================================================
 template<typename T>
 auto CompositeData::insert_or_assign(T&& value) -> InsertResult<T>
 {
-  return detail::insertion_cast<T>(_insert(std::any(std::move(value)), true));
+  if constexpr (detail::inline_component_slot_v<T> >= 0)
+    return _insert_inline<T>(std::move(value), true);
+  else
+    return detail::insertion_cast<T>(
+      _insert(_id_of<T>(), detail::ComponentHolder(std::move(value)), true));
 }
 
 //==============================================================================
@@ -58,21 +68,91 @@ CompositeData& CompositeData::with(T&& value)
 template<typename T>
 T* CompositeData::get()
 {
-  return std::any_cast<T>(_get(typeid(T)));
+  if constexpr (detail::inline_component_slot_v<T> >= 0)
+  {
+    return _get_inline<T>();
+  }
+  else
+  {
+    detail::ComponentHolder* holder = _get_mutable(_id_of<T>());
+    return holder ? holder->get<T>() : nullptr;
+  }
 }
 
 //==============================================================================
 template<typename T>
 const T* CompositeData::get() const
 {
-  return std::any_cast<T>(_get(typeid(T)));
+  if constexpr (detail::inline_component_slot_v<T> >= 0)
+  {
+    return _get_inline<T>();
+  }
+  else
+  {
+    detail::ComponentHolder* holder = _get(_id_of<T>());
+    return holder ? holder->get<T>() : nullptr;
+  }
 }
 
 //==============================================================================
 template<typename T>
 bool CompositeData::erase()
 {
-  return _erase(typeid(T));
+  if constexpr (detail::inline_component_slot_v<T> >= 0)
+  {
+    const auto bit = std::uint8_t(1u << detail::inline_component_slot_v<T>);
+    const bool existed = _present & bit;
+    _present &= std::uint8_t(~bit);
+    return existed;
+  }
+  else
+    return _erase(_id_of<T>());
+}
+
+//==============================================================================
+template<typename T>
+std::size_t CompositeData::_id_of()
+{
+  static const std::size_t id = _register(typeid(std::decay_t<T>));
+  return id;
+}
+
+//==============================================================================
+template<typename T>
+auto CompositeData::_insert_inline(T&& value, bool or_assign)
+-> InsertResult<T>
+{
+  constexpr int slot = detail::inline_component_slot_v<T>;
+  static_assert(slot < static_cast<int>(NumInlineSlots));
+  static_assert(sizeof(T) <= sizeof(Slot) && alignof(T) <= alignof(Slot));
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(std::is_trivially_destructible_v<T>);
+
+  const auto bit = std::uint8_t(1u << slot);
+  if (_present & bit)
+  {
+    T* existing = _get_inline<T>();
+    if (or_assign)
+      *existing = std::move(value);
+
+    return {false, existing};
+  }
+
+  T* inserted = new (&_slots[slot]) T(std::move(value));
+  _present |= bit;
+  return {true, inserted};
+}
+
+//==============================================================================
+template<typename T>
+T* CompositeData::_get_inline() const
+{
+  constexpr int slot = detail::inline_component_slot_v<T>;
+  if (!(_present & (1u << slot)))
+    return nullptr;
+
+  return std::launder(
+    reinterpret_cast<T*>(const_cast<Slot*>(&_slots[slot])));
 }
 
 } // namespace rmf_task
@@ -36,13 +36,20 @@ class SimpleEventState : public Event::State
 {
 public:
 
+  /// Make a new event state
+  ///
+  /// \param[in] memory
+  ///   If given, the event state and the chunks of its log are allocated from
+  ///   this memory resource, which must outlive the event state and every
+  ///   View of its log. See Log(clock, memory).
   static std::shared_ptr<SimpleEventState> make(
     uint64_t id,
     std::string name,
     std::string detail,
     Status initial_status,
     std::vector<ConstStatePtr> dependencies = {},
-    std::function<rmf_traffic::Time()> clock = nullptr);
+    std::function<rmf_traffic::Time()> clock = nullptr,
+    std::pmr::memory_resource* memory = nullptr);
 
   // Documentation inherited
   uint64_t id() const final;
@@ -79,6 +86,12 @@ public:
   // Documentation inherited
   std::vector<ConstStatePtr> dependencies() const final;
 
+  /// Look at the dependencies without copying them. This is meant for code
+  /// that runs on every update, such as aggregating the status of the
+  /// dependencies. The reference is invalidated by the next change to the
+  /// dependencies.
+  const std::vector<ConstStatePtr>& current_dependencies() const;
+
   /// Update the dependencies
   SimpleEventState& update_dependencies(
     std::vector<ConstStatePtr> new_dependencies);
@@ -86,6 +99,10 @@ public:
   /// Add one dependency to the state
   SimpleEventState& add_dependency(ConstStatePtr new_dependency);
 
+  /// Every update to this state, every new entry in its log, and every change
+  /// to its dependencies gives it a new version.
+  uint64_t version() const final;
+
   class Implementation;
 private:
   SimpleEventState();
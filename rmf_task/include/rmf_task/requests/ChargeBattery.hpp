@@ -38,7 +38,8 @@ namespace requests {
 //==============================================================================
 /// A class that generates a Request which requires an AGV to return to its
 /// desginated charging_waypoint as specified in its agv::State and wait till
-/// its battery charges up to the recharge_soc confugred in agv::Constraints
+/// its battery charges up to the recharge_soc confugred in agv::Constraints,
+/// or up to the target_soc of its Description if it has one
 class ChargeBattery
 {
 public:
@@ -53,6 +54,15 @@ public:
     /// Generate the description for this request
     static Task::ConstDescriptionPtr make();
 
+    /// Generate the description of a charge that stops once the battery
+    /// reaches target_soc instead of the recharge_soc of the Constraints. The
+    /// TaskPlanner makes these for the charges that it plans to stop early.
+    ///
+    /// \param[in] target_soc
+    ///   The state of charge to stop at. It must be within [0.0, 1.0], or
+    ///   else std::invalid_argument is thrown.
+    static Task::ConstDescriptionPtr make(double target_soc);
+
     /// Make a charging task that will last indefinitely.
     static std::shared_ptr<Description> make_indefinite();
 
@@ -76,6 +86,10 @@ public:
     /// Should this recharge task run indefinitely?
     bool indefinite() const;
 
+    /// Get the state of charge that this charge stops at, or std::nullopt if
+    /// it charges up to the recharge_soc of the Constraints
+    std::optional<double> target_soc() const;
+
     class Implementation;
   private:
     Description();
@@ -92,10 +106,15 @@ public:
   ///
   /// \param[in] automatic
   ///   True if this request is auto-generated
+  ///
+  /// \param[in] target_soc
+  ///   The state of charge to stop at, if the charge should stop before the
+  ///   recharge_soc of the Constraints
   static ConstRequestPtr make(
     rmf_traffic::Time earliest_start_time,
     ConstPriorityPtr priority = nullptr,
-    bool automatic = true);
+    bool automatic = true,
+    std::optional<double> target_soc = std::nullopt);
 
   /// Generate a chargebattery request.
   ///
@@ -113,12 +132,17 @@ public:
   ///
   /// \param[in] automatic
   ///   True if this request is auto-generated, default value as true.
+  ///
+  /// \param[in] target_soc
+  ///   The state of charge to stop at, if the charge should stop before the
+  ///   recharge_soc of the Constraints.
   static ConstRequestPtr make(
     rmf_traffic::Time earliest_start_time,
     const std::string& requester,
     rmf_traffic::Time request_time,
     ConstPriorityPtr priority = nullptr,
-    bool automatic = true);
+    bool automatic = true,
+    std::optional<double> target_soc = std::nullopt);
 };
 
 } // namespace requests
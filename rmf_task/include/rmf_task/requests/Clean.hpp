@@ -72,6 +72,9 @@ public:
     /// Get the end waypoint in this request
     std::size_t end_waypoint() const;
 
+    /// Get the cleaning path of this request
+    const rmf_traffic::Trajectory& cleaning_path() const;
+
     class Implementation;
   private:
     Description();
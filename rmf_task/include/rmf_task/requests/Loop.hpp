@@ -52,10 +52,18 @@ public:
   public:
 
     /// Generate the description for this request
+    ///
+    /// \param[in] charge_between_loops
+    ///   If true, a loop that drains more than a full battery can hold will be
+    ///   estimated with the robot returning to its charger between loops as
+    ///   often as needed. The robot leaves from the start waypoint after it
+    ///   comes back from a loop, as late as its battery allows. If false, such
+    ///   a loop cannot be assigned.
     static Task::ConstDescriptionPtr make(
       std::size_t start_waypoint,
       std::size_t finish_waypoint,
-      std::size_t num_loops);
+      std::size_t num_loops,
+      bool charge_between_loops = false);
 
     // Documentation inherited
     Task::ConstModelPtr make_model(
@@ -76,6 +84,9 @@ public:
     /// Get the numbert of loops in this request
     std::size_t num_loops() const;
 
+    /// Check whether the robot may charge between loops
+    bool charge_between_loops() const;
+
     class Implementation;
   private:
     Description();
@@ -106,6 +117,10 @@ public:
   ///
   /// \param[in] automatic
   ///   True if this request is auto-generated
+  ///
+  /// \param[in] charge_between_loops
+  ///   True if the robot may return to its charger between loops, as in
+  ///   Description::make(). Default as false.
   static ConstRequestPtr make(
     std::size_t start_waypoint,
     std::size_t finish_waypoint,
@@ -113,7 +128,8 @@ public:
     const std::string& id,
     rmf_traffic::Time earliest_start_time,
     ConstPriorityPtr priority = nullptr,
-    bool automatic = false);
+    bool automatic = false,
+    bool charge_between_loops = false);
 
   /// Generate a loop request.
   ///
@@ -144,6 +160,10 @@ public:
   ///
   /// \param[in] automatic
   ///   True if this request is auto-generated, default as false.
+  ///
+  /// \param[in] charge_between_loops
+  ///   True if the robot may return to its charger between loops, as in
+  ///   Description::make(). Default as false.
   static ConstRequestPtr make(
     std::size_t start_waypoint,
     std::size_t finish_waypoint,
@@ -153,7 +173,8 @@ public:
     const std::string& requester,
     rmf_traffic::Time request_time,
     ConstPriorityPtr priority = nullptr,
-    bool automatic = false);
+    bool automatic = false,
+    bool charge_between_loops = false);
 };
 
 } // namespace tasks
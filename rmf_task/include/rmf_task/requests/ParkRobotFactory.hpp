@@ -69,6 +69,9 @@ public:
     std::function<rmf_traffic::Time()> time_now_cb,
     std::optional<std::size_t> parking_waypoint = std::nullopt);
 
+  /// Get the parking waypoint of this factory, if it has one
+  std::optional<std::size_t> parking_waypoint() const;
+
   /// Documentation inherited
   ConstRequestPtr make_request(const State& state) const final;
 
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef RMF_TASK__REQUESTS__POOLEDDELIVERY_HPP
+#define RMF_TASK__REQUESTS__POOLEDDELIVERY_HPP
+
+#include <vector>
+
+#include <rmf_task/Request.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+
+namespace rmf_task {
+namespace requests {
+
+//==============================================================================
+/// A class that generates a Request which carries several Delivery requests
+/// in one trip. The AGV visits the pickup of every delivery in the order they
+/// are given, and then the dropoff of every delivery in the same order, so all
+/// the items are on board at once. The TaskPlanner makes these when
+/// TaskPlanner::Options::pool_deliveries() is set.
+class PooledDelivery
+{
+public:
+
+  // Forward declare the Model for this request
+  class Model;
+
+  class Description : public Task::Description
+  {
+  public:
+
+    /// Generate the description for this request
+    ///
+    /// \param[in] deliveries
+    ///   The requests to carry together. Each one must have a
+    ///   Delivery::Description, or else std::invalid_argument is thrown.
+    static Task::ConstDescriptionPtr make(
+      std::vector<ConstRequestPtr> deliveries);
+
+    // Documentation inherited
+    Task::ConstModelPtr make_model(
+      rmf_traffic::Time earliest_start_time,
+      const Parameters& parameters) const final;
+
+    // Documentation inherited
+    Info generate_info(
+      const State& initial_state,
+      const Parameters& parameters) const final;
+
+    /// Get the requests that are carried together, in the order that they
+    /// are picked up and dropped off
+    const std::vector<ConstRequestPtr>& deliveries() const;
+
+    class Implementation;
+  private:
+    Description();
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
+  /// Generate a request that carries several deliveries together. Its ID
+  /// joins the IDs of the deliveries with "+". It may not begin before any of
+  /// the deliveries may begin, it takes the priority of the first delivery
+  /// that has one, and it is automatic only if every delivery is automatic.
+  ///
+  /// \param[in] deliveries
+  ///   The requests to carry together. Each one must have a
+  ///   Delivery::Description, or else std::invalid_argument is thrown.
+  static ConstRequestPtr make(std::vector<ConstRequestPtr> deliveries);
+};
+
+} // namespace requests
+} // namespace rmf_task
+
+#endif // RMF_TASK__REQUESTS__POOLEDDELIVERY_HPP
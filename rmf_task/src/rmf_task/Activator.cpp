@@ -17,6 +17,8 @@
 
 #include <rmf_task/Activator.hpp>
 
+#include <vector>
+
 namespace rmf_task {
 
 //==============================================================================
@@ -24,7 +26,18 @@ class Activator::Implementation
 {
 public:
 
-  std::unordered_map<std::type_index, Activate<Task::Description>> activators;
+  // Indexed by detail::DispatchIndex
+  std::vector<ActivatePlanned<Task::Description>> activators;
+
+  const ActivatePlanned<Task::Description>* find(
+    const Task::Description& desc) const
+  {
+    const auto index = desc.dispatch_index();
+    if (activators.size() <= index || !activators[index])
+      return nullptr;
+
+    return &activators[index];
+  }
 
 };
 
@@ -44,6 +57,28 @@ Task::ActivePtr Activator::activate(
   std::function<void(Task::Active::Backup)> checkpoint,
   std::function<void(Phase::ConstCompletedPtr)> phase_finished,
   std::function<void()> task_finished) const
+{
+  return activate(
+    get_state,
+    parameters,
+    request,
+    nullptr,
+    std::move(update),
+    std::move(checkpoint),
+    std::move(phase_finished),
+    std::move(task_finished));
+}
+
+//==============================================================================
+Task::ActivePtr Activator::activate(
+  const std::function<State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Request& request,
+  Task::ConstModelPtr model,
+  std::function<void(Phase::ConstSnapshotPtr)> update,
+  std::function<void(Task::Active::Backup)> checkpoint,
+  std::function<void(Phase::ConstCompletedPtr)> phase_finished,
+  std::function<void()> task_finished) const
 {
   // TODO(MXG): Should we issue some kind of error/warning to distinguish
   // between a missing description versus a description that doesn't have a
@@ -51,17 +86,16 @@ Task::ActivePtr Activator::activate(
   if (!request.description())
     return nullptr;
 
-  const auto& desc = *request.description();
-  const auto& type = typeid(desc);
-  const auto it = _pimpl->activators.find(type);
-  if (it == _pimpl->activators.end())
+  const auto* const activator = _pimpl->find(*request.description());
+  if (!activator)
     return nullptr;
 
-  return it->second(
+  return (*activator)(
     get_state,
     parameters,
     request.booking(),
     *request.description(),
+    std::move(model),
     std::nullopt,
     std::move(update),
     std::move(checkpoint),
@@ -83,17 +117,16 @@ Task::ActivePtr Activator::restore(
   if (!request.description())
     return nullptr;
 
-  const auto& desc = *request.description();
-  const auto& type = typeid(desc);
-  const auto it = _pimpl->activators.find(type);
-  if (it == _pimpl->activators.end())
+  const auto* const activator = _pimpl->find(*request.description());
+  if (!activator)
     return nullptr;
 
-  return it->second(
+  return (*activator)(
     get_state,
     parameters,
     request.booking(),
     *request.description(),
+    nullptr,
     std::move(backup_state),
     std::move(update),
     std::move(checkpoint),
@@ -101,12 +134,96 @@ Task::ActivePtr Activator::restore(
     std::move(task_finished));
 }
 
+//==============================================================================
+std::vector<Task::ActivePtr> Activator::activate_batch(
+  const std::function<State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const std::vector<ConstRequestPtr>& requests,
+  std::function<void(std::size_t index, Phase::ConstSnapshotPtr)> update,
+  std::function<void(std::size_t index, Task::Active::Backup)> checkpoint,
+  std::function<void(std::size_t index, Phase::ConstCompletedPtr)>
+  phase_finished,
+  std::function<void(std::size_t index)> task_finished) const
+{
+  // The callbacks of the whole batch live here, so each task only holds a
+  // pointer to them along with its index
+  struct Callbacks
+  {
+    std::function<void(std::size_t, Phase::ConstSnapshotPtr)> update;
+    std::function<void(std::size_t, Task::Active::Backup)> checkpoint;
+    std::function<void(std::size_t, Phase::ConstCompletedPtr)> phase_finished;
+    std::function<void(std::size_t)> task_finished;
+  };
+
+  const auto callbacks = std::make_shared<const Callbacks>(
+    Callbacks{
+      std::move(update),
+      std::move(checkpoint),
+      std::move(phase_finished),
+      std::move(task_finished)
+    });
+
+  std::vector<Task::ActivePtr> output;
+  output.reserve(requests.size());
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    const auto& request = requests[i];
+    if (!request || !request->description())
+    {
+      output.push_back(nullptr);
+      continue;
+    }
+
+    const auto* const activator = _pimpl->find(*request->description());
+    if (!activator)
+    {
+      output.push_back(nullptr);
+      continue;
+    }
+
+    output.push_back(
+      (*activator)(
+        get_state,
+        parameters,
+        request->booking(),
+        *request->description(),
+        nullptr,
+        std::nullopt,
+        [callbacks, i](Phase::ConstSnapshotPtr snapshot)
+        {
+          if (callbacks->update)
+            callbacks->update(i, std::move(snapshot));
+        },
+        [callbacks, i](Task::Active::Backup backup)
+        {
+          if (callbacks->checkpoint)
+            callbacks->checkpoint(i, std::move(backup));
+        },
+        [callbacks, i](Phase::ConstCompletedPtr phase)
+        {
+          if (callbacks->phase_finished)
+            callbacks->phase_finished(i, std::move(phase));
+        },
+        [callbacks, i]()
+        {
+          if (callbacks->task_finished)
+            callbacks->task_finished(i);
+        }));
+  }
+
+  return output;
+}
+
 //==============================================================================
 void Activator::_add_activator(
   std::type_index type,
-  Activate<Task::Description> activator)
+  ActivatePlanned<Task::Description> activator)
 {
-  _pimpl->activators.insert_or_assign(type, std::move(activator));
+  const auto index = detail::DispatchIndex::of(type);
+  if (_pimpl->activators.size() <= index)
+    _pimpl->activators.resize(index + 1);
+
+  _pimpl->activators[index] = std::move(activator);
 }
 
 } // namespace rmf_task
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "Affinity.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace rmf_task {
+
+#ifdef __linux__
+//==============================================================================
+struct AffinityScope::Previous
+{
+  cpu_set_t set;
+};
+
+//==============================================================================
+bool pin_current_thread(const std::vector<std::size_t>& cores)
+{
+  if (cores.empty())
+    return false;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  bool any = false;
+  for (const auto core : cores)
+  {
+    if (core < CPU_SETSIZE)
+    {
+      CPU_SET(core, &set);
+      any = true;
+    }
+  }
+
+  if (!any)
+    return false;
+
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+//==============================================================================
+AffinityScope::AffinityScope(const std::vector<std::size_t>& cores)
+{
+  if (cores.empty())
+    return;
+
+  auto previous = std::make_unique<Previous>();
+  CPU_ZERO(&previous->set);
+  if (pthread_getaffinity_np(
+      pthread_self(), sizeof(previous->set), &previous->set) != 0)
+  {
+    return;
+  }
+
+  if (pin_current_thread(cores))
+    _previous = std::move(previous);
+}
+
+//==============================================================================
+AffinityScope::~AffinityScope()
+{
+  if (_previous)
+  {
+    pthread_setaffinity_np(
+      pthread_self(), sizeof(_previous->set), &_previous->set);
+  }
+}
+
+#else
+//==============================================================================
+struct AffinityScope::Previous
+{
+};
+
+//==============================================================================
+bool pin_current_thread(const std::vector<std::size_t>&)
+{
+  return false;
+}
+
+//==============================================================================
+AffinityScope::AffinityScope(const std::vector<std::size_t>&)
+{
+  // Do nothing
+}
+
+//==============================================================================
+AffinityScope::~AffinityScope()
+{
+  // Do nothing
+}
+#endif
+
+} // namespace rmf_task
@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__AFFINITY_HPP
+#define SRC__RMF_TASK__AFFINITY_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+// Restrict the calling thread to run only on the given cores. Cores that the
+// machine does not have are ignored. Nothing is done if the list is empty or
+// if the platform does not support thread affinity. Returns true if the thread
+// was pinned.
+bool pin_current_thread(const std::vector<std::size_t>& cores);
+
+//==============================================================================
+// Pins the calling thread for as long as the scope exists, and then gives the
+// thread back the cores that it was allowed to run on before.
+class AffinityScope
+{
+public:
+
+  AffinityScope(const std::vector<std::size_t>& cores);
+
+  AffinityScope(const AffinityScope&) = delete;
+  AffinityScope& operator=(const AffinityScope&) = delete;
+
+  ~AffinityScope();
+
+private:
+  struct Previous;
+  std::unique_ptr<Previous> _previous;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__AFFINITY_HPP
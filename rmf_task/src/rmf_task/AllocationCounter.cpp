@@ -0,0 +1,267 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/AllocationCounter.hpp>
+
+#include <atomic>
+
+#ifdef RMF_TASK_COUNT_ALLOCATIONS
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#endif
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// These are read from inside operator new, so they must all be constant
+// initialized and must never allocate.
+using Subsystem = AllocationCounter::Subsystem;
+constexpr std::size_t N = AllocationCounter::NumSubsystems;
+
+thread_local Subsystem current_subsystem = Subsystem::Other;
+thread_local std::size_t thread_allocations[N] = {};
+thread_local std::size_t thread_bytes[N] = {};
+std::atomic_size_t global_allocations[N] = {};
+std::atomic_size_t global_bytes[N] = {};
+
+#ifdef RMF_TASK_COUNT_ALLOCATIONS
+//==============================================================================
+void count_allocation(std::size_t size)
+{
+  const auto s = static_cast<std::size_t>(current_subsystem);
+  ++thread_allocations[s];
+  thread_bytes[s] += size;
+  global_allocations[s].fetch_add(1, std::memory_order_relaxed);
+  global_bytes[s].fetch_add(size, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void* allocate_unaligned(std::size_t size)
+{
+  if (size == 0)
+    size = 1;
+
+  while (true)
+  {
+    if (void* p = std::malloc(size))
+      return p;
+
+    const auto handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+
+    handler();
+  }
+}
+
+//==============================================================================
+void* allocate(std::size_t size)
+{
+  count_allocation(size);
+  return allocate_unaligned(size);
+}
+
+//==============================================================================
+void* allocate(std::size_t size, std::align_val_t alignment)
+{
+  count_allocation(size);
+  const auto align = static_cast<std::size_t>(alignment);
+  if (align <= alignof(std::max_align_t))
+    return allocate_unaligned(size);
+
+  // aligned_alloc needs the size to be a multiple of the alignment
+  size = (std::max<std::size_t>(size, 1) + align - 1) / align * align;
+  while (true)
+  {
+    if (void* p = std::aligned_alloc(align, size))
+      return p;
+
+    const auto handler = std::get_new_handler();
+    if (!handler)
+      throw std::bad_alloc();
+
+    handler();
+  }
+}
+#endif // RMF_TASK_COUNT_ALLOCATIONS
+} // anonymous namespace
+
+//==============================================================================
+class AllocationCounter::Counts::Implementation
+{
+public:
+
+  template<typename Allocations, typename Bytes>
+  static Counts make(const Allocations& allocations, const Bytes& bytes)
+  {
+    Counts output;
+    for (std::size_t s = 0; s < N; ++s)
+    {
+      output._allocations[s] = allocations[s];
+      output._bytes[s] = bytes[s];
+    }
+
+    return output;
+  }
+};
+
+//==============================================================================
+AllocationCounter::Counts::Counts()
+: _allocations{},
+  _bytes{}
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::size_t AllocationCounter::Counts::allocations(Subsystem subsystem) const
+{
+  return _allocations[static_cast<std::size_t>(subsystem)];
+}
+
+//==============================================================================
+std::size_t AllocationCounter::Counts::bytes(Subsystem subsystem) const
+{
+  return _bytes[static_cast<std::size_t>(subsystem)];
+}
+
+//==============================================================================
+std::size_t AllocationCounter::Counts::total_allocations() const
+{
+  std::size_t total = 0;
+  for (const auto a : _allocations)
+    total += a;
+
+  return total;
+}
+
+//==============================================================================
+std::size_t AllocationCounter::Counts::total_bytes() const
+{
+  std::size_t total = 0;
+  for (const auto b : _bytes)
+    total += b;
+
+  return total;
+}
+
+//==============================================================================
+auto AllocationCounter::Counts::since(const Counts& earlier) const -> Counts
+{
+  Counts output;
+  for (std::size_t s = 0; s < N; ++s)
+  {
+    output._allocations[s] = _allocations[s] - earlier._allocations[s];
+    output._bytes[s] = _bytes[s] - earlier._bytes[s];
+  }
+
+  return output;
+}
+
+//==============================================================================
+bool AllocationCounter::enabled()
+{
+#ifdef RMF_TASK_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+//==============================================================================
+auto AllocationCounter::this_thread() -> Counts
+{
+  return Counts::Implementation::make(thread_allocations, thread_bytes);
+}
+
+//==============================================================================
+auto AllocationCounter::all_threads() -> Counts
+{
+  std::size_t allocations[N];
+  std::size_t bytes[N];
+  for (std::size_t s = 0; s < N; ++s)
+  {
+    allocations[s] = global_allocations[s].load(std::memory_order_relaxed);
+    bytes[s] = global_bytes[s].load(std::memory_order_relaxed);
+  }
+
+  return Counts::Implementation::make(allocations, bytes);
+}
+
+//==============================================================================
+AllocationCounter::Scope::Scope(Subsystem subsystem)
+: _previous(current_subsystem)
+{
+  current_subsystem = subsystem;
+}
+
+//==============================================================================
+AllocationCounter::Scope::~Scope()
+{
+  current_subsystem = _previous;
+}
+
+//==============================================================================
+auto AllocationCounter::current() -> Subsystem
+{
+  return current_subsystem;
+}
+
+} // namespace rmf_task
+
+#ifdef RMF_TASK_COUNT_ALLOCATIONS
+//==============================================================================
+// The replacements of the global allocation functions. The array and nothrow
+// forms that are not replaced here forward to these by default.
+void* operator new(std::size_t size)
+{
+  return rmf_task::allocate(size);
+}
+
+//==============================================================================
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+  return rmf_task::allocate(size, alignment);
+}
+
+//==============================================================================
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+//==============================================================================
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+//==============================================================================
+void operator delete(void* p, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+
+//==============================================================================
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept
+{
+  std::free(p);
+}
+#endif // RMF_TASK_COUNT_ALLOCATIONS
@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "AssignmentHeuristic.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// Find the cheapest way to give each row its own column with the Hungarian
+// method. The costs are in row-major order and there must be at least as many
+// columns as rows. Infinite costs mark pairs that may not be chosen. Returns
+// infinity if the rows cannot all be given a column.
+double min_cost_assignment(
+  const std::vector<double>& costs,
+  const std::size_t rows,
+  const std::size_t columns)
+{
+  constexpr double inf = std::numeric_limits<double>::infinity();
+
+  // Rows and columns are counted from 1 so that 0 can stand for "none"
+  std::vector<double> u(rows + 1, 0.0);
+  std::vector<double> v(columns + 1, 0.0);
+  std::vector<std::size_t> row_of(columns + 1, 0);
+  std::vector<std::size_t> way(columns + 1, 0);
+  std::vector<double> min_v(columns + 1);
+  std::vector<bool> used(columns + 1);
+
+  for (std::size_t i = 1; i <= rows; ++i)
+  {
+    row_of[0] = i;
+    std::size_t j0 = 0;
+    std::fill(min_v.begin(), min_v.end(), inf);
+    std::fill(used.begin(), used.end(), false);
+
+    do
+    {
+      used[j0] = true;
+      const std::size_t i0 = row_of[j0];
+      double delta = inf;
+      std::size_t j1 = 0;
+      for (std::size_t j = 1; j <= columns; ++j)
+      {
+        if (used[j])
+          continue;
+
+        const double cost = costs[(i0 - 1) * columns + (j - 1)] - u[i0] - v[j];
+        if (cost < min_v[j])
+        {
+          min_v[j] = cost;
+          way[j] = j0;
+        }
+
+        if (min_v[j] < delta)
+        {
+          delta = min_v[j];
+          j1 = j;
+        }
+      }
+
+      if (j1 == 0)
+        return inf;
+
+      for (std::size_t j = 0; j <= columns; ++j)
+      {
+        if (used[j])
+        {
+          u[row_of[j]] += delta;
+          v[j] -= delta;
+        }
+        else
+        {
+          min_v[j] -= delta;
+        }
+      }
+
+      j0 = j1;
+    } while (row_of[j0] != 0);
+
+    do
+    {
+      const std::size_t j1 = way[j0];
+      row_of[j0] = row_of[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+
+  double total = 0.0;
+  for (std::size_t j = 1; j <= columns; ++j)
+  {
+    if (row_of[j] != 0)
+      total += costs[(row_of[j] - 1) * columns + (j - 1)];
+  }
+
+  return total;
+}
+} // anonymous namespace
+
+//==============================================================================
+AssignmentHeuristic::AssignmentHeuristic(std::size_t num_agents)
+: _num_agents(num_agents)
+{
+  // Do nothing
+}
+
+//==============================================================================
+void AssignmentHeuristic::add(
+  const double earliest_start_time,
+  const double invariant_duration,
+  const std::vector<Finish>& finish_times)
+{
+  std::vector<double> row(
+    _num_agents, std::numeric_limits<double>::infinity());
+  for (const auto& [agent, finish] : finish_times)
+    row[agent] = finish;
+
+  add_row(earliest_start_time, invariant_duration, row.data());
+}
+
+//==============================================================================
+void AssignmentHeuristic::add_row(
+  const double earliest_start_time,
+  const double invariant_duration,
+  const double* finish_times)
+{
+  _earliest_start_times.push_back(earliest_start_time);
+  _invariant_durations.push_back(invariant_duration);
+  _finish_times.insert(
+    _finish_times.end(), finish_times, finish_times + _num_agents);
+}
+
+//==============================================================================
+double AssignmentHeuristic::compute_cost() const
+{
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  const std::size_t n = _earliest_start_times.size();
+  const std::size_t m = _num_agents;
+  if (n == 0)
+    return 0.0;
+
+  // The earliest time that each agent can begin the invariant portion of any
+  // of the tasks. Infinite finish times stay infinite.
+  std::vector<double> deployment(m, inf);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double* row = _finish_times.data() + i * m;
+    const double invariant = _invariant_durations[i];
+    for (std::size_t a = 0; a < m; ++a)
+      deployment[a] = std::min(deployment[a], row[a] - invariant);
+  }
+
+  // The least time that the invariant portions of k tasks can take
+  std::vector<double> shortest = _invariant_durations;
+  std::sort(shortest.begin(), shortest.end());
+  std::vector<double> in_front(n, 0.0);
+  for (std::size_t k = 1; k < n; ++k)
+    in_front[k] = in_front[k-1] + shortest[k-1];
+
+  // Each agent has one column for each position in its queue
+  const std::size_t columns = m * n;
+  std::vector<double> costs(n * columns, inf);
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    const double* row = _finish_times.data() + i * m;
+    const double invariant = _invariant_durations[i];
+    const double start = _earliest_start_times[i];
+    for (std::size_t a = 0; a < m; ++a)
+    {
+      const double finish = row[a];
+      if (finish == inf)
+        continue;
+
+      const double begin = deployment[a] + invariant;
+      double* cost = costs.data() + i * columns + a * n;
+      for (std::size_t k = 0; k < n; ++k)
+        cost[k] = std::max(finish, begin + in_front[k]) - start;
+    }
+  }
+
+  return min_cost_assignment(costs, n, columns);
+}
+
+} // namespace rmf_task
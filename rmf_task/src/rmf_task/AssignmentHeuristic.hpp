@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__ASSIGNMENTHEURISTIC_HPP
+#define SRC__RMF_TASK__ASSIGNMENTHEURISTIC_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace rmf_task {
+
+// A lower bound on the total delay of the unassigned tasks of a node, found by
+// relaxing the rest of the plan into a min-cost assignment of the tasks to the
+// positions in the queues of the agents.
+//
+// If a task is the k-th of the remaining tasks of an agent, it cannot finish
+// before the agent could finish it as its next task, and it cannot finish
+// before the agent has done the invariant portions of k tasks, starting from
+// the earliest time that the agent can begin any invariant portion. The k-1
+// tasks in front of it are bounded by the k-1 shortest invariant durations.
+// Giving each position of each queue to at most one task and solving for the
+// cheapest assignment gives a bound that accounts for both the travel of the
+// agents and the tasks having to share them.
+//
+// All times are in seconds.
+class AssignmentHeuristic
+{
+public:
+
+  // The time that an agent would finish a task if it performed it next
+  using Finish = std::pair<std::size_t, double>;
+
+  AssignmentHeuristic(std::size_t num_agents);
+
+  // Add a task along with the finish time of each agent that can perform it.
+  // Agents that are not listed cannot perform the task.
+  void add(
+    double earliest_start_time,
+    double invariant_duration,
+    const std::vector<Finish>& finish_times);
+
+  // Add a task along with the finish time of every agent, in the order of the
+  // agents. Agents that cannot perform the task have an infinite finish time.
+  void add_row(
+    double earliest_start_time,
+    double invariant_duration,
+    const double* finish_times);
+
+  // Solve the assignment. This is O(n^3 * agents) for n tasks.
+  double compute_cost() const;
+
+private:
+  // The tasks are kept as columns of plain doubles, and the finish times as a
+  // dense tasks x agents matrix, so that the minima over the agents and the
+  // rows of the cost matrix are computed by loops over contiguous memory that
+  // the compiler can vectorize.
+  std::size_t _num_agents;
+  std::vector<double> _earliest_start_times;
+  std::vector<double> _invariant_durations;
+  std::vector<double> _finish_times;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__ASSIGNMENTHEURISTIC_HPP
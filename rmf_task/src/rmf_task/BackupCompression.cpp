@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BackupCompression.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef RMF_TASK_HAS_ZSTD
+#include <zstd.h>
+#endif // RMF_TASK_HAS_ZSTD
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// The header of a compressed backup, which is followed by one zstd frame
+constexpr char CompressedMagic[4] = {'\0', 'R', 'Z', '1'};
+constexpr std::size_t CompressedHeaderSize = sizeof(CompressedMagic);
+
+// Backups are written often, so favor speed over ratio
+constexpr int CompressionLevel = 1;
+
+//==============================================================================
+bool is_compressed(const std::string& stored)
+{
+  return stored.size() >= CompressedHeaderSize
+    && stored.compare(
+    0, CompressedHeaderSize, CompressedMagic, CompressedHeaderSize) == 0;
+}
+} // anonymous namespace
+
+//==============================================================================
+bool backup_compression_supported()
+{
+#ifdef RMF_TASK_HAS_ZSTD
+  return true;
+#else
+  return false;
+#endif // RMF_TASK_HAS_ZSTD
+}
+
+//==============================================================================
+std::string compress_backup(const std::string& state)
+{
+#ifdef RMF_TASK_HAS_ZSTD
+  std::string stored(
+    CompressedHeaderSize + ZSTD_compressBound(state.size()), '\0');
+  std::memcpy(stored.data(), CompressedMagic, CompressedHeaderSize);
+  const std::size_t size = ZSTD_compress(
+    stored.data() + CompressedHeaderSize,
+    stored.size() - CompressedHeaderSize,
+    state.data(),
+    state.size(),
+    CompressionLevel);
+
+  if (ZSTD_isError(size) || CompressedHeaderSize + size >= state.size())
+    return state;
+
+  stored.resize(CompressedHeaderSize + size);
+  return stored;
+#else
+  return state;
+#endif // RMF_TASK_HAS_ZSTD
+}
+
+//==============================================================================
+std::string decompress_backup(std::string stored)
+{
+  if (!is_compressed(stored))
+    return stored;
+
+#ifdef RMF_TASK_HAS_ZSTD
+  const char* frame = stored.data() + CompressedHeaderSize;
+  const std::size_t frame_size = stored.size() - CompressedHeaderSize;
+  const auto content_size = ZSTD_getFrameContentSize(frame, frame_size);
+  if (content_size == ZSTD_CONTENTSIZE_ERROR
+    || content_size == ZSTD_CONTENTSIZE_UNKNOWN)
+  {
+    // *INDENT-OFF*
+    throw std::runtime_error(
+      "[rmf_task::decompress_backup] Compressed backup is corrupted");
+    // *INDENT-ON*
+  }
+
+  std::string state(static_cast<std::size_t>(content_size), '\0');
+  const std::size_t size = ZSTD_decompress(
+    state.data(), state.size(), frame, frame_size);
+  if (ZSTD_isError(size) || size != state.size())
+  {
+    throw std::runtime_error(
+            std::string("[rmf_task::decompress_backup] ")
+            + "Could not decompress backup: "
+            + (ZSTD_isError(size) ? ZSTD_getErrorName(size) : "wrong size"));
+  }
+
+  return state;
+#else
+  // *INDENT-OFF*
+  throw std::runtime_error(
+    "[rmf_task::decompress_backup] Backup is compressed, but rmf_task was "
+    "built without zstd");
+  // *INDENT-ON*
+#endif // RMF_TASK_HAS_ZSTD
+}
+
+} // namespace rmf_task
@@ -0,0 +1,45 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__BACKUPCOMPRESSION_HPP
+#define SRC__RMF_TASK__BACKUPCOMPRESSION_HPP
+
+#include <string>
+
+namespace rmf_task {
+
+// Backups may be compressed with zstd before they are stored. A compressed
+// backup starts with a magic header whose first byte is a null character,
+// which never begins a backup that is stored as it is, so readers can tell the
+// two apart without being told which one to expect.
+
+// True if rmf_task was built with zstd, so that backups can be compressed
+bool backup_compression_supported();
+
+// Compress a backup and put the magic header in front of it. The backup is
+// returned as it is if compression is not supported, or if compressing it
+// would not make it any smaller.
+std::string compress_backup(const std::string& state);
+
+// Undo compress_backup(). A backup without the magic header is returned as it
+// is. This throws std::runtime_error if the backup is compressed but cannot be
+// decompressed, e.g. because compression is not supported.
+std::string decompress_backup(std::string stored);
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__BACKUPCOMPRESSION_HPP
@@ -15,15 +15,354 @@
  *
 */
 
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
 #include <filesystem>
 #include <iostream>
 #include <fstream>
+#include <limits>
+#include <map>
+#include <mutex>
 #include <rmf_task/BackupFileManager.hpp>
 
+#include "BackupCompression.hpp"
+#include "BackupJournal.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <rmf_utils/Modular.hpp>
 
 namespace rmf_task {
 
+namespace {
+//==============================================================================
+// The file that holds the latest backup of a robot, and the file that a new
+// backup is written to before it replaces the old one
+const std::string BackupFileName = "backup";
+const std::string PreBackupFileName = ".backup";
+
+//==============================================================================
+// Decides which backups need to be synchronized with storage
+class SyncPolicy
+{
+public:
+
+  using Durability = BackupFileManager::Durability;
+
+  SyncPolicy(Durability durability, rmf_traffic::Duration period)
+  : _durability(durability),
+    _period(std::chrono::duration_cast<std::chrono::nanoseconds>(period)
+      .count()),
+    _last_sync(std::numeric_limits<int64_t>::min())
+  {
+    // Do nothing
+  }
+
+  // Check whether backups are ever synchronized
+  bool enabled() const
+  {
+    return _durability != Durability::None;
+  }
+
+  // Check whether the backup that is about to be written should be
+  // synchronized. For the periodic policy this also claims the sync, so that
+  // only one writer syncs per period.
+  bool due()
+  {
+    if (_durability == Durability::None)
+      return false;
+
+    if (_durability == Durability::EveryWrite)
+      return true;
+
+    const int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    int64_t last = _last_sync.load(std::memory_order_relaxed);
+    if (last != std::numeric_limits<int64_t>::min() && now - last < _period)
+      return false;
+
+    // If another writer claims this period first, leave the sync to them
+    return _last_sync.compare_exchange_strong(
+      last, now, std::memory_order_relaxed);
+  }
+
+private:
+  Durability _durability;
+  int64_t _period;
+  std::atomic<int64_t> _last_sync;
+};
+
+//==============================================================================
+[[noreturn]] void throw_errno(const std::string& what)
+{
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+//==============================================================================
+void sync_directory(const std::filesystem::path& directory)
+{
+  const int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+  if (fd < 0)
+    throw_errno("Could not open directory " + directory.string() + " to sync");
+
+  const int result = ::fsync(fd);
+  ::close(fd);
+  if (result != 0)
+    throw_errno("Could not sync directory " + directory.string());
+}
+
+//==============================================================================
+void write_backup_file(
+  const std::string& state,
+  const std::string& pre_backup_file_path,
+  const std::string& backup_file_path,
+  SyncPolicy& sync)
+{
+  const int fd = ::open(
+    pre_backup_file_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw std::runtime_error(
+            "Could not open file " + pre_backup_file_path +
+            " for pre_backup.");
+
+  std::size_t written = 0;
+  while (written < state.size())
+  {
+    const auto n = ::write(fd, state.data() + written, state.size() - written);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+
+      const int error = errno;
+      ::close(fd);
+      errno = error;
+      throw_errno("Could not write file " + pre_backup_file_path);
+    }
+
+    written += static_cast<std::size_t>(n);
+  }
+
+  // The data must reach storage before the rename, or a crash could leave
+  // an empty file in place of the previous backup. This is needed for every
+  // write that is meant to survive a crash, even when the periodic policy
+  // does not make this write durable, because the rename replaces a backup
+  // that may already have been synchronized.
+  if (sync.enabled() && ::fsync(fd) != 0)
+  {
+    const int error = errno;
+    ::close(fd);
+    errno = error;
+    throw_errno("Could not sync file " + pre_backup_file_path);
+  }
+
+  if (::close(fd) != 0)
+    throw_errno("Could not close file " + pre_backup_file_path);
+
+  std::filesystem::rename(pre_backup_file_path, backup_file_path);
+
+  // Until the directory is synchronized, a crash may bring back the previous
+  // backup, which is complete
+  if (sync.due())
+    sync_directory(std::filesystem::path(backup_file_path).parent_path());
+}
+
+//==============================================================================
+// Read the backup in the directory of a robot that does not share a journal,
+// cleaning up after a write that was interrupted
+std::optional<std::string> read_backup_file(
+  const std::filesystem::path& robot_directory,
+  const std::string& backup_file_name,
+  const std::string& pre_backup_file_name,
+  const std::function<void(const std::string&)>& log_debug)
+{
+  const std::string backup_file_path = robot_directory / backup_file_name;
+  const std::string pre_backup_file_path =
+    robot_directory / pre_backup_file_name;
+
+  if (!std::filesystem::exists(robot_directory))
+  {
+    throw std::runtime_error("[BackupFileManager::Robot::read] Directory " +
+            robot_directory.string() +
+            " missing. This should not happen.");
+  }
+
+  if (std::filesystem::is_empty(robot_directory))
+    return std::nullopt;
+
+  // Check for foreign files
+  auto directory_it = std::filesystem::directory_iterator(
+    robot_directory);
+  for (auto& p: directory_it)
+  {
+    auto filename = p.path().filename().string();
+    if (filename.compare(backup_file_name) != 0 &&
+      filename.compare(pre_backup_file_name) != 0)
+    {
+      // *INDENT-OFF*
+      throw std::runtime_error(
+        "[BackupFileManager::Robot::read] Foreign file " +
+        filename + " found. This should be removed.");
+      // *INDENT-ON*
+    }
+  }
+
+  // At this point, file is either backup_file_name, or .backup_file_name, or both
+  if (std::filesystem::exists(backup_file_path))
+  {
+    if (std::filesystem::exists(pre_backup_file_path))
+    {
+      //suspicious to have both backup files, something definitely broke in the previous run.
+      log_debug(
+        "[BackupFileManager::Robot::read] Multiple backup files found. This suggests an error with the previous backup run. Using the older edited backup file..");
+      std::filesystem::remove(pre_backup_file_path);
+    }
+
+    std::ifstream backup(backup_file_path, std::ios::in);
+    if (!backup)
+      throw std::runtime_error(
+              "Could not open file " + backup_file_path +
+              " for backup.");
+    else
+    {
+      std::stringstream buffer;
+      buffer << backup.rdbuf();
+      return std::optional(decompress_backup(buffer.str()));
+    }
+  }
+  else
+  {
+    // At this point, we either have exactly .backup, or no files at all
+    if (std::filesystem::exists(pre_backup_file_path))
+    {
+      std::filesystem::remove(pre_backup_file_path);
+    }
+
+    return std::nullopt;
+  }
+
+}
+
+//==============================================================================
+// Writes backups on the threads of an Executor. Backups are kept by the path of
+// the backup file of their robot, so a newer backup for a robot replaces an
+// older one that has not been written yet. At most one job at a time drains
+// the backups, so the files are never written concurrently.
+class AsyncWriter
+{
+public:
+
+  AsyncWriter(
+    ExecutorPtr executor,
+    std::function<void(std::string)> log_error)
+  : _executor(std::move(executor)),
+    _state(std::make_shared<State>())
+  {
+    _state->log_error = std::move(log_error);
+  }
+
+  ~AsyncWriter()
+  {
+    // Everything that is still waiting gets written before we quit. The drain
+    // job keeps the state alive, in case it is still unwinding after the last
+    // backup was written.
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    _state->done_cv.wait(lock, [&]() { return !_state->draining; });
+  }
+
+  void push(const std::string& backup_file_path, std::function<void()> write)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      _state->waiting[backup_file_path] = std::move(write);
+      if (_state->draining)
+        return;
+
+      _state->draining = true;
+    }
+
+    _executor->post([state = _state]() { drain(*state); });
+  }
+
+  // Wait until nothing is waiting to be written
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    _state->done_cv.wait(
+      lock, [&]() { return _state->waiting.empty() && !_state->writing; });
+  }
+
+  // Wait until the backup for one file has been written
+  void flush(const std::string& backup_file_path)
+  {
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    _state->done_cv.wait(
+      lock, [&]()
+      {
+        return _state->waiting.count(backup_file_path) == 0
+        && _state->writing != backup_file_path;
+      });
+  }
+
+  // Forget the backup for one file, and wait in case it is being written
+  void discard(const std::string& backup_file_path)
+  {
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    _state->waiting.erase(backup_file_path);
+    _state->done_cv.wait(
+      lock, [&]() { return _state->writing != backup_file_path; });
+  }
+
+private:
+
+  struct State
+  {
+    std::function<void(std::string)> log_error;
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    std::map<std::string, std::function<void()>> waiting;
+    std::optional<std::string> writing;
+    bool draining = false;
+  };
+
+  static void drain(State& state)
+  {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.waiting.empty())
+    {
+      auto job = state.waiting.extract(state.waiting.begin());
+      state.writing = job.key();
+      lock.unlock();
+
+      try
+      {
+        job.mapped()();
+      }
+      catch (const std::exception& e)
+      {
+        state.log_error(
+          std::string("[BackupFileManager] Failed to write backup: ")
+          + e.what());
+      }
+
+      lock.lock();
+      state.writing = std::nullopt;
+      state.done_cv.notify_all();
+    }
+
+    state.draining = false;
+    state.done_cv.notify_all();
+  }
+
+  ExecutorPtr _executor;
+  std::shared_ptr<State> _state;
+};
+} // anonymous namespace
+
 //==============================================================================
 class BackupFileManager::Implementation
 {
@@ -33,8 +372,30 @@ public:
   {
     bool clear_on_startup = false;
     bool clear_on_shutdown = true;
+    bool journal = false;
+    bool compression = false;
     std::function<void(std::string)> info_logger = nullptr;
     std::function<void(std::string)> debug_logger = nullptr;
+
+    // This is only set while backups are written asynchronously
+    std::shared_ptr<AsyncWriter> writer = nullptr;
+    ExecutorPtr executor = nullptr;
+
+    std::shared_ptr<SyncPolicy> sync = std::make_shared<SyncPolicy>(
+      Durability::None, rmf_traffic::Duration(0));
+
+    // The writer and the sync policy may be replaced while robots are writing
+    // backups on other threads, so they are only ever loaded and stored
+    // atomically
+    std::shared_ptr<AsyncWriter> load_writer() const
+    {
+      return std::atomic_load(&writer);
+    }
+
+    std::shared_ptr<SyncPolicy> load_sync() const
+    {
+      return std::atomic_load(&sync);
+    }
   };
   using ConstSettingsPtr = std::shared_ptr<const Settings>;
 
@@ -69,6 +430,11 @@ public:
     settings(std::move(settings))
   {
     std::filesystem::create_directories(this->group_directory);
+    if (this->settings->journal)
+    {
+      journal = std::make_shared<BackupJournal>(
+        this->group_directory / "journal", this->settings->compression);
+    }
   }
 
   template<typename... Args>
@@ -84,6 +450,9 @@ public:
   const std::filesystem::path group_directory;
   ConstSettingsPtr settings;
 
+  // This is only set if the robots of this group share one journal
+  std::shared_ptr<BackupJournal> journal;
+
   std::unordered_map<std::string, std::weak_ptr<Robot>> robots;
 };
 
@@ -96,14 +465,20 @@ public:
 
   Implementation(
     std::filesystem::path directory,
+    std::string name,
+    std::shared_ptr<BackupJournal> journal,
     ConstSettingsPtr settings)
   : robot_directory(std::move(directory)),
+    name(std::move(name)),
+    journal(std::move(journal)),
     settings(std::move(settings))
   {
     if (this->settings->clear_on_startup)
       this->clear_backup();
 
-    std::filesystem::create_directories(this->robot_directory);
+    // Robots that write to a journal do not need a directory of their own
+    if (!this->journal)
+      std::filesystem::create_directories(this->robot_directory);
   }
 
   template<typename... Args>
@@ -118,18 +493,36 @@ public:
 
   ~Implementation()
   {
+    if (const auto writer = settings->load_writer())
+    {
+      // Make sure that a backup which is still waiting is either written or
+      // forgotten before the files are cleared
+      if (settings->clear_on_shutdown)
+        writer->discard(backup_file_path);
+      else
+        writer->flush(backup_file_path);
+    }
+
     if (settings->clear_on_shutdown)
       clear_backup();
   }
 
   const std::filesystem::path robot_directory;
+  const std::string name;
+  const std::shared_ptr<BackupJournal> journal;
   ConstSettingsPtr settings;
   std::optional<uint64_t> last_seq;
-  const std::string backup_file_name = "backup";
-  const std::string pre_backup_file_name = ".backup";
+
+  // The latest full backup, which delta backups apply to
+  struct Base
+  {
+    uint64_t sequence;
+    std::shared_ptr<const std::string> state;
+  };
+  std::optional<Base> base;
   const std::string pre_backup_file_path = robot_directory /
-    pre_backup_file_name;
-  const std::string backup_file_path = robot_directory / backup_file_name;
+    PreBackupFileName;
+  const std::string backup_file_path = robot_directory / BackupFileName;
 
   void write_if_new(const Task::Active::Backup& backup)
   {
@@ -140,7 +533,94 @@ public:
     }
 
     last_seq = backup.sequence();
-    write(backup.state());
+    const auto base_sequence = backup.base_sequence();
+    auto write = base_sequence.has_value() ?
+      delta_writer(backup.sequence(), *base_sequence, backup.state()) :
+      full_writer(backup.sequence(), backup.state());
+
+    if (!write)
+      return;
+
+    if (const auto writer = settings->load_writer())
+    {
+      writer->push(backup_file_path, std::move(write));
+      return;
+    }
+
+    write();
+  }
+
+  std::function<void()> full_writer(uint64_t sequence, std::string state)
+  {
+    auto shared_state = std::make_shared<const std::string>(std::move(state));
+    base = Base{sequence, shared_state};
+    if (journal)
+    {
+      return [journal = journal, name = name, sync = settings->load_sync(),
+          sequence, state = std::move(shared_state)]()
+        {
+          journal->append(name, sequence, *state, sync->due());
+        };
+    }
+
+    return [pre = pre_backup_file_path, path = backup_file_path,
+        sync = settings->load_sync(), compression = settings->compression,
+        state = std::move(shared_state)]()
+      {
+        write_backup_file(
+          compression ? compress_backup(*state) : *state, pre, path, *sync);
+      };
+  }
+
+  std::function<void()> delta_writer(
+    uint64_t sequence,
+    uint64_t base_sequence,
+    std::string patch)
+  {
+    if (!base.has_value() || base->sequence != base_sequence)
+    {
+      log_info(
+        "[BackupFileManager] Ignoring a delta backup for robot [" + name
+        + "] because its full backup [" + std::to_string(base_sequence)
+        + "] was not written");
+      return nullptr;
+    }
+
+    if (journal)
+    {
+      // If the full backup never made it into the journal, e.g. because the
+      // asynchronous writer replaced it with this delta, write the whole state
+      return [journal = journal, name = name, sync = settings->load_sync(),
+          sequence, base = *base, patch = std::move(patch)]()
+        {
+          const bool sync_now = sync->due();
+          if (!journal->append_delta(
+              name, sequence, base.sequence, patch, sync_now))
+          {
+            journal->append(
+              name, sequence,
+              detail::Backup::apply_delta(*base.state, patch), sync_now);
+          }
+        };
+    }
+
+    // Per-robot files always hold the whole state
+    return [pre = pre_backup_file_path, path = backup_file_path,
+        sync = settings->load_sync(), compression = settings->compression,
+        base = *base, patch = std::move(patch)]()
+      {
+        auto state = detail::Backup::apply_delta(*base.state, patch);
+        if (compression)
+          state = compress_backup(state);
+
+        write_backup_file(state, pre, path, *sync);
+      };
+  }
+
+  void flush() const
+  {
+    if (const auto writer = settings->load_writer())
+      writer->flush(backup_file_path);
   }
 
   void log_debug(const std::string msg) const
@@ -168,23 +648,14 @@ public:
   }
 
 private:
-  void write(const std::string& state)
+  void clear_backup()
   {
-    std::ofstream pre_backup(pre_backup_file_path, std::ios::out);
-    if (!pre_backup)
-      throw std::runtime_error(
-              "Could not open file " + pre_backup_file_path +
-              " for pre_backup.");
-    else
+    if (journal)
     {
-      pre_backup << state;
-      pre_backup.close();
-      std::filesystem::rename(pre_backup_file_path, backup_file_path);
+      journal->erase(name, settings->load_sync()->due());
+      return;
     }
-  }
 
-  void clear_backup()
-  {
     if (std::filesystem::exists(robot_directory))
       std::filesystem::remove(pre_backup_file_path);
     std::filesystem::remove(backup_file_path);
@@ -218,6 +689,88 @@ BackupFileManager& BackupFileManager::clear_on_shutdown(bool value)
   return *this;
 }
 
+//==============================================================================
+BackupFileManager& BackupFileManager::asynchronous(bool value)
+{
+  auto& settings = *_pimpl->settings;
+  const auto writer = settings.load_writer();
+  if (value && !writer)
+  {
+    const auto& executor = settings.executor;
+    std::atomic_store(
+      &settings.writer,
+      std::make_shared<AsyncWriter>(
+        executor ? executor : Executor::default_executor(),
+        [logger = settings.info_logger](std::string msg)
+        {
+          if (logger)
+            logger(std::move(msg));
+          else
+            std::cout << msg << std::endl;
+        }));
+  }
+  else if (!value && writer)
+  {
+    // Backups from now on are written synchronously. The ones that are still
+    // waiting get written before this returns.
+    std::atomic_store(&settings.writer, std::shared_ptr<AsyncWriter>());
+    writer->flush();
+  }
+
+  return *this;
+}
+
+//==============================================================================
+BackupFileManager& BackupFileManager::executor(ExecutorPtr executor)
+{
+  _pimpl->settings->executor = std::move(executor);
+  if (_pimpl->settings->load_writer())
+  {
+    asynchronous(false);
+    asynchronous(true);
+  }
+
+  return *this;
+}
+
+//==============================================================================
+BackupFileManager& BackupFileManager::compression(bool value)
+{
+  _pimpl->settings->compression = value;
+  return *this;
+}
+
+//==============================================================================
+bool BackupFileManager::compression_supported()
+{
+  return backup_compression_supported();
+}
+
+//==============================================================================
+BackupFileManager& BackupFileManager::journal(bool value)
+{
+  _pimpl->settings->journal = value;
+  return *this;
+}
+
+//==============================================================================
+BackupFileManager& BackupFileManager::durability(
+  Durability policy,
+  rmf_traffic::Duration sync_period)
+{
+  std::atomic_store(
+    &_pimpl->settings->sync,
+    std::make_shared<SyncPolicy>(policy, sync_period));
+  return *this;
+}
+
+//==============================================================================
+void BackupFileManager::flush()
+{
+  if (const auto writer = _pimpl->settings->load_writer())
+    writer->flush();
+}
+
 //==============================================================================
 auto BackupFileManager::make_group(std::string name) -> std::shared_ptr<Group>
 {
@@ -253,7 +806,9 @@ auto BackupFileManager::Group::make_robot(std::string name)
   }
 
   auto robot = Robot::Implementation::make(
-    _pimpl->group_directory / std::filesystem::path(std::move(name)),
+    _pimpl->group_directory / std::filesystem::path(name),
+    name,
+    _pimpl->journal,
     _pimpl->settings);
 
   it->second = robot;
@@ -267,69 +822,92 @@ BackupFileManager::Group::Group()
 }
 
 //==============================================================================
-std::optional<std::string> BackupFileManager::Robot::read() const
+auto BackupFileManager::Group::restore_all() const -> Backups
 {
-  if (!std::filesystem::exists(_pimpl->robot_directory))
+  const auto robots = _stored_robots();
+  std::vector<std::optional<std::string>> backups(robots.size());
+  _read_all(
+    robots,
+    [&](std::size_t i, std::string backup)
+    {
+      backups[i] = std::move(backup);
+    });
+
+  Backups output;
+  for (std::size_t i = 0; i < robots.size(); ++i)
   {
-    throw std::runtime_error("[BackupFileManager::Robot::read] Directory " +
-            _pimpl->robot_directory.string() +
-            " missing. This should not happen.");
+    if (backups[i].has_value())
+      output.emplace(robots[i], std::move(*backups[i]));
   }
 
-  if (std::filesystem::is_empty(_pimpl->robot_directory))
-    return std::nullopt;
+  return output;
+}
 
-  // Check for foreign files
-  auto directory_it = std::filesystem::directory_iterator(
-    _pimpl->robot_directory);
-  for (auto& p: directory_it)
+//==============================================================================
+std::vector<std::string> BackupFileManager::Group::_stored_robots() const
+{
+  if (_pimpl->journal)
+    return _pimpl->journal->robots();
+
+  std::vector<std::string> robots;
+  for (const auto& entry :
+    std::filesystem::directory_iterator(_pimpl->group_directory))
   {
-    auto filename = p.path().filename().string();
-    if (filename.compare(_pimpl->backup_file_name) != 0 &&
-      filename.compare(_pimpl->pre_backup_file_name) != 0)
-    {
-      // *INDENT-OFF*
-      throw std::runtime_error(
-        "[BackupFileManager::Robot::read] Foreign file " +
-        filename + " found. This should be removed.");
-      // *INDENT-ON*
-    }
+    if (entry.is_directory())
+      robots.push_back(entry.path().filename().string());
   }
 
-  // At this point, file is either backup_file_name, or .backup_file_name, or both
-  if (std::filesystem::exists(_pimpl->backup_file_path))
-  {
-    if (std::filesystem::exists(_pimpl->pre_backup_file_path))
-    {
-      //suspicious to have both backup files, something definitely broke in the previous run.
-      _pimpl->log_debug(
-        "[BackupFileManager::Robot::read] Multiple backup files found. This suggests an error with the previous backup run. Using the older edited backup file..");
-      std::filesystem::remove(_pimpl->pre_backup_file_path);
-    }
+  return robots;
+}
 
-    std::ifstream backup(_pimpl->backup_file_path, std::ios::in);
-    if (!backup)
-      throw std::runtime_error(
-              "Could not open file " + _pimpl->backup_file_path +
-              " for backup.");
-    else
+//==============================================================================
+void BackupFileManager::Group::_read_all(
+  const std::vector<std::string>& robots,
+  const std::function<void(std::size_t, std::string)>& consume) const
+{
+  const auto& settings = _pimpl->settings;
+  const auto log_debug = [&settings](const std::string& msg)
     {
-      std::stringstream buffer;
-      buffer << backup.rdbuf();
-      return std::optional(buffer.str());
-    }
-  }
-  else
-  {
-    // At this point, we either have exactly .backup, or no files at all
-    if (std::filesystem::exists(_pimpl->pre_backup_file_path))
+      if (settings->debug_logger)
+        settings->debug_logger(msg);
+      else
+        std::cout << msg << std::endl;
+    };
+
+  const auto& executor = settings->executor ?
+    settings->executor : Executor::default_executor();
+  executor->parallel_for(
+    robots.size(), [&](std::size_t i)
     {
-      std::filesystem::remove(_pimpl->pre_backup_file_path);
-    }
+      // Do not read a backup while a newer one is about to replace it
+      const auto robot_directory = _pimpl->group_directory / robots[i];
+      if (const auto writer = settings->load_writer())
+        writer->flush((robot_directory / BackupFileName).string());
+
+      auto backup = _pimpl->journal ?
+        _pimpl->journal->read(robots[i]) :
+        read_backup_file(
+        robot_directory, BackupFileName, PreBackupFileName, log_debug);
+
+      if (backup.has_value())
+        consume(i, std::move(*backup));
+    });
+}
 
-    return std::nullopt;
-  }
+//==============================================================================
+std::optional<std::string> BackupFileManager::Robot::read() const
+{
+  // Do not read the file while a newer backup is about to replace it
+  _pimpl->flush();
+
+  if (_pimpl->journal)
+    return _pimpl->journal->read(_pimpl->name);
 
+  return read_backup_file(
+    _pimpl->robot_directory,
+    BackupFileName,
+    PreBackupFileName,
+    [this](const std::string& msg) { _pimpl->log_debug(msg); });
 }
 
 //==============================================================================
@@ -0,0 +1,573 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "BackupJournal.hpp"
+#include "BackupCompression.hpp"
+
+#include <rmf_task/detail/Backup.hpp>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// The journal file starts with this, followed by its records
+constexpr char FileMagic[8] = {'R', 'M', 'F', 'T', 'J', 'R', 'N', '1'};
+constexpr std::size_t FileHeaderSize = sizeof(FileMagic);
+
+// Each record is laid out as
+//   u32 magic | u32 checksum | u64 sequence | u32 kind | u32 robot name size |
+//   u32 state size | u32 reserved | robot name | state | padding
+// where the checksum covers everything after itself except the padding, and
+// the padding brings the record up to a multiple of 8 bytes.
+constexpr uint32_t RecordMagic = 0x524A4D52;
+constexpr std::size_t RecordHeaderSize = 32;
+constexpr uint32_t BackupRecord = 0;
+constexpr uint32_t ErasedRecord = 1;
+constexpr uint32_t DeltaRecord = 2;
+
+constexpr std::size_t InitialCapacity = 256 * 1024;
+
+// Compact once the file holds this many times more bytes than the latest
+// records, as long as it is at least CompactionMinBytes long
+constexpr std::size_t CompactionRatio = 4;
+constexpr std::size_t CompactionMinBytes = 1024 * 1024;
+
+//==============================================================================
+[[noreturn]] void throw_errno(const std::string& what)
+{
+  throw std::runtime_error(what + ": " + std::strerror(errno));
+}
+
+//==============================================================================
+std::size_t record_size(std::size_t name_size, std::size_t state_size)
+{
+  return (RecordHeaderSize + name_size + state_size + 7) & ~std::size_t(7);
+}
+
+//==============================================================================
+template<typename T>
+T load(const unsigned char* data)
+{
+  T value;
+  std::memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+//==============================================================================
+template<typename T>
+void store(unsigned char* data, T value)
+{
+  std::memcpy(data, &value, sizeof(T));
+}
+
+//==============================================================================
+uint32_t checksum(const unsigned char* record)
+{
+  // FNV-1a over the header after the checksum, followed by the payload
+  const std::size_t size = RecordHeaderSize - 8
+    + load<uint32_t>(record + 20) + load<uint32_t>(record + 24);
+
+  uint32_t hash = 2166136261u;
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    hash ^= record[8 + i];
+    hash *= 16777619u;
+  }
+
+  return hash;
+}
+
+//==============================================================================
+void write_record(
+  unsigned char* record,
+  std::size_t size,
+  uint32_t kind,
+  const std::string& robot,
+  uint64_t sequence,
+  const std::string& payload)
+{
+  std::memset(record, 0, size);
+  store<uint64_t>(record + 8, sequence);
+  store<uint32_t>(record + 16, kind);
+  store<uint32_t>(record + 20, static_cast<uint32_t>(robot.size()));
+  store<uint32_t>(record + 24, static_cast<uint32_t>(payload.size()));
+  std::memcpy(record + RecordHeaderSize, robot.data(), robot.size());
+  std::memcpy(
+    record + RecordHeaderSize + robot.size(), payload.data(), payload.size());
+
+  store<uint32_t>(record + 4, checksum(record));
+  store<uint32_t>(record, RecordMagic);
+}
+
+//==============================================================================
+void sync_range(unsigned char* data, std::size_t begin, std::size_t end)
+{
+  static const std::size_t page = static_cast<std::size_t>(
+    ::sysconf(_SC_PAGESIZE));
+
+  const std::size_t aligned = begin - begin % page;
+  if (::msync(data + aligned, end - aligned, MS_SYNC) != 0)
+    throw_errno("Could not sync backup journal");
+}
+} // anonymous namespace
+
+//==============================================================================
+BackupJournal::BackupJournal(
+  std::filesystem::path file_path,
+  bool compression)
+: _file_path(std::move(file_path)),
+  _compression(compression)
+{
+  _open();
+}
+
+//==============================================================================
+BackupJournal::~BackupJournal()
+{
+  _unmap();
+  if (_fd >= 0)
+    ::close(_fd);
+}
+
+//==============================================================================
+void BackupJournal::append(
+  const std::string& robot,
+  uint64_t sequence,
+  const std::string& state,
+  bool sync)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _append(robot, BackupRecord, sequence, state, sync);
+}
+
+//==============================================================================
+bool BackupJournal::append_delta(
+  const std::string& robot,
+  uint64_t sequence,
+  uint64_t base_sequence,
+  const std::string& patch,
+  bool sync)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _latest.find(robot);
+  if (it == _latest.end() || _sequence(it->second.full) != base_sequence)
+    return false;
+
+  _append(robot, DeltaRecord, sequence, patch, sync);
+  return true;
+}
+
+//==============================================================================
+void BackupJournal::erase(const std::string& robot, bool sync)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_latest.count(robot) == 0)
+    return;
+
+  _append(robot, ErasedRecord, 0, std::string(), sync);
+}
+
+//==============================================================================
+std::optional<std::string> BackupJournal::read(const std::string& robot) const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _latest.find(robot);
+  if (it == _latest.end())
+    return std::nullopt;
+
+  return _read(it->second);
+}
+
+//==============================================================================
+std::vector<std::string> BackupJournal::robots() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<std::string> output;
+  output.reserve(_latest.size());
+  for (const auto& [robot, latest] : _latest)
+    output.push_back(robot);
+
+  return output;
+}
+
+//==============================================================================
+std::size_t BackupJournal::used_bytes() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _end;
+}
+
+//==============================================================================
+void BackupJournal::_open()
+{
+  _fd = ::open(_file_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (_fd < 0)
+    throw_errno("Could not open backup journal " + _file_path.string());
+
+  struct stat info;
+  if (::fstat(_fd, &info) != 0)
+    throw_errno("Could not inspect backup journal " + _file_path.string());
+
+  std::size_t capacity = static_cast<std::size_t>(info.st_size);
+  const bool is_new = capacity == 0;
+  if (is_new)
+  {
+    capacity = InitialCapacity;
+    if (::ftruncate(_fd, static_cast<off_t>(capacity)) != 0)
+      throw_errno("Could not size backup journal " + _file_path.string());
+  }
+
+  if (capacity < FileHeaderSize)
+  {
+    throw std::runtime_error(
+            "[BackupJournal] File " + _file_path.string()
+            + " is not a backup journal.");
+  }
+
+  _map(capacity);
+  if (is_new)
+    std::memcpy(_data, FileMagic, FileHeaderSize);
+  else if (std::memcmp(_data, FileMagic, FileHeaderSize) != 0)
+  {
+    throw std::runtime_error(
+            "[BackupJournal] File " + _file_path.string()
+            + " is not a backup journal.");
+  }
+
+  _recover();
+}
+
+//==============================================================================
+void BackupJournal::_map(std::size_t capacity)
+{
+  void* data = ::mmap(
+    nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+  if (data == MAP_FAILED)
+    throw_errno("Could not map backup journal " + _file_path.string());
+
+  _data = static_cast<unsigned char*>(data);
+  _capacity = capacity;
+}
+
+//==============================================================================
+void BackupJournal::_unmap()
+{
+  if (_data)
+    ::munmap(_data, _capacity);
+
+  _data = nullptr;
+  _capacity = 0;
+}
+
+//==============================================================================
+void BackupJournal::_recover()
+{
+  std::size_t offset = FileHeaderSize;
+  while (offset + RecordHeaderSize <= _capacity)
+  {
+    const unsigned char* record = _data + offset;
+    if (load<uint32_t>(record) != RecordMagic)
+      break;
+
+    const std::size_t size = record_size(
+      load<uint32_t>(record + 20), load<uint32_t>(record + 24));
+    if (size > _capacity - offset)
+      break;
+
+    if (load<uint32_t>(record + 4) != checksum(record))
+      break;
+
+    _index(
+      std::string(
+        reinterpret_cast<const char*>(record + RecordHeaderSize),
+        load<uint32_t>(record + 20)),
+      load<uint32_t>(record + 16),
+      Record{offset, size});
+
+    offset += size;
+  }
+
+  _end = offset;
+
+  // If the last record was torn by a crash, clear out what is left of it so
+  // that it cannot be mistaken for part of a record that gets appended later
+  const auto tail = _data + _end;
+  const auto tail_size = _capacity - _end;
+  bool clean = true;
+  for (std::size_t i = 0; i < std::min(tail_size, RecordHeaderSize); ++i)
+    clean = clean && tail[i] == 0;
+
+  if (!clean)
+    std::memset(tail, 0, tail_size);
+}
+
+//==============================================================================
+void BackupJournal::_index(std::string robot, uint32_t kind, Record record)
+{
+  const auto it = _latest.find(robot);
+  if (it != _latest.end())
+  {
+    if (kind != DeltaRecord)
+      _live_bytes -= it->second.full.size;
+
+    if (it->second.delta.has_value())
+      _live_bytes -= it->second.delta->size;
+  }
+
+  if (kind == BackupRecord)
+  {
+    _latest[std::move(robot)] = Latest{record, std::nullopt};
+    _live_bytes += record.size;
+  }
+  else if (kind == DeltaRecord)
+  {
+    // A delta without a full record to apply to cannot be used
+    if (it == _latest.end())
+      return;
+
+    it->second.delta = record;
+    _live_bytes += record.size;
+  }
+  else if (it != _latest.end())
+  {
+    _latest.erase(it);
+  }
+}
+
+//==============================================================================
+void BackupJournal::_append(
+  const std::string& robot,
+  uint32_t kind,
+  uint64_t sequence,
+  const std::string& payload,
+  bool sync)
+{
+  // Erased records have no payload to compress
+  const std::string stored = _compression && kind != ErasedRecord ?
+    compress_backup(payload) : payload;
+
+  if (robot.size() > UINT32_MAX || stored.size() > UINT32_MAX)
+    throw std::runtime_error("[BackupJournal] Backup is too large to record");
+
+  const std::size_t size = record_size(robot.size(), stored.size());
+  _reserve(size);
+
+  const std::size_t offset = _end;
+  write_record(_data + offset, size, kind, robot, sequence, stored);
+  _end += size;
+  _index(robot, kind, Record{offset, size});
+
+  if (sync)
+    sync_range(_data, offset, _end);
+
+  if (_end >= CompactionMinBytes
+    && _end > CompactionRatio * (FileHeaderSize + _live_bytes))
+  {
+    _compact();
+  }
+}
+
+//==============================================================================
+void BackupJournal::_reserve(std::size_t record_size)
+{
+  if (record_size <= _capacity - _end)
+    return;
+
+  std::size_t capacity = _capacity;
+  while (record_size > capacity - _end)
+    capacity *= 2;
+
+  if (::ftruncate(_fd, static_cast<off_t>(capacity)) != 0)
+    throw_errno("Could not grow backup journal " + _file_path.string());
+
+  _unmap();
+  _map(capacity);
+}
+
+//==============================================================================
+void BackupJournal::_compact()
+{
+  // Fold each delta into its full record first, so that the size of the
+  // compacted file is known before it gets created
+  struct Folded
+  {
+    uint64_t sequence;
+    std::string state;
+  };
+
+  std::unordered_map<std::string, Folded> folded;
+  std::size_t needed = FileHeaderSize;
+  for (const auto& [robot, latest] : _latest)
+  {
+    if (latest.delta.has_value())
+    {
+      try
+      {
+        auto state = _read(latest);
+        if (_compression)
+          state = compress_backup(state);
+
+        needed += record_size(robot.size(), state.size());
+        folded[robot] = Folded{_sequence(*latest.delta), std::move(state)};
+        continue;
+      }
+      catch (const std::exception&)
+      {
+        // Keep the records as they are if the delta cannot be applied
+        needed += latest.delta->size;
+      }
+    }
+
+    needed += latest.full.size;
+  }
+
+  const auto compact_path = std::filesystem::path(
+    _file_path.string() + ".compact");
+
+  std::size_t capacity = InitialCapacity;
+  while (capacity < 2 * needed)
+    capacity *= 2;
+
+  const int fd = ::open(compact_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    throw_errno("Could not open " + compact_path.string());
+
+  if (::ftruncate(fd, static_cast<off_t>(capacity)) != 0)
+  {
+    ::close(fd);
+    throw_errno("Could not size " + compact_path.string());
+  }
+
+  void* mapped = ::mmap(
+    nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED)
+  {
+    ::close(fd);
+    throw_errno("Could not map " + compact_path.string());
+  }
+
+  unsigned char* data = static_cast<unsigned char*>(mapped);
+  std::memcpy(data, FileMagic, FileHeaderSize);
+  std::size_t end = FileHeaderSize;
+  std::size_t live_bytes = 0;
+  std::unordered_map<std::string, Latest> latest;
+  const auto copy = [&](const Record& record) -> Record
+    {
+      std::memcpy(data + end, _data + record.offset, record.size);
+      const Record output{end, record.size};
+      end += record.size;
+      live_bytes += record.size;
+      return output;
+    };
+
+  for (const auto& [robot, current] : _latest)
+  {
+    const auto folded_it = folded.find(robot);
+    if (folded_it != folded.end())
+    {
+      const auto& state = folded_it->second.state;
+      const std::size_t size = record_size(robot.size(), state.size());
+      write_record(
+        data + end, size, BackupRecord, robot,
+        folded_it->second.sequence, state);
+      latest[robot] = Latest{Record{end, size}, std::nullopt};
+      end += size;
+      live_bytes += size;
+      continue;
+    }
+
+    auto& next = latest[robot];
+    next.full = copy(current.full);
+    if (current.delta.has_value())
+      next.delta = copy(*current.delta);
+  }
+
+  // The compacted file replaces the whole history, so it always needs to
+  // reach storage before it takes the place of the old file
+  if (::msync(data, end, MS_SYNC) != 0)
+  {
+    ::munmap(data, capacity);
+    ::close(fd);
+    throw_errno("Could not sync " + compact_path.string());
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(compact_path, _file_path, ec);
+  if (ec)
+  {
+    ::munmap(data, capacity);
+    ::close(fd);
+    throw std::runtime_error(
+            "[BackupJournal] Could not replace " + _file_path.string()
+            + ": " + ec.message());
+  }
+
+  const int dir = ::open(_file_path.parent_path().c_str(), O_RDONLY);
+  if (dir >= 0)
+  {
+    ::fsync(dir);
+    ::close(dir);
+  }
+
+  _unmap();
+  ::close(_fd);
+  _fd = fd;
+  _data = data;
+  _capacity = capacity;
+  _end = end;
+  _live_bytes = live_bytes;
+  _latest = std::move(latest);
+}
+
+//==============================================================================
+uint64_t BackupJournal::_sequence(const Record& record) const
+{
+  return load<uint64_t>(_data + record.offset + 8);
+}
+
+//==============================================================================
+std::string BackupJournal::_payload(const Record& record) const
+{
+  const unsigned char* data = _data + record.offset;
+  const auto name_size = load<uint32_t>(data + 20);
+  const auto payload_size = load<uint32_t>(data + 24);
+  return decompress_backup(
+    std::string(
+      reinterpret_cast<const char*>(data + RecordHeaderSize + name_size),
+      payload_size));
+}
+
+//==============================================================================
+std::string BackupJournal::_read(const Latest& latest) const
+{
+  if (!latest.delta.has_value())
+    return _payload(latest.full);
+
+  return detail::Backup::apply_delta(
+    _payload(latest.full), _payload(*latest.delta));
+}
+
+} // namespace rmf_task
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__BACKUPJOURNAL_HPP
+#define SRC__RMF_TASK__BACKUPJOURNAL_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+// An append-only journal that holds the backups of every robot in a group in
+// one memory-mapped file. Each record is keyed by the name of its robot and
+// carries a checksum, so opening the journal after a crash recovers the latest
+// valid record of each robot and ignores a torn record at the end. A robot can
+// also have a delta record, which holds a JSON Patch for its latest full
+// record. Once most of the file is taken up by records that have been
+// replaced, the latest records are compacted into a new file that takes the
+// place of the old one, and each delta gets folded into its full record.
+class BackupJournal
+{
+public:
+
+  // Open the journal at this path, creating it if it does not exist yet. If
+  // compression is true, the backups that get appended are compressed. Both
+  // compressed and uncompressed backups can be read either way.
+  BackupJournal(std::filesystem::path file_path, bool compression = false);
+
+  BackupJournal(const BackupJournal&) = delete;
+  BackupJournal& operator=(const BackupJournal&) = delete;
+
+  ~BackupJournal();
+
+  // Append the latest backup of a robot. If sync is true, this waits until the
+  // record has reached storage.
+  void append(
+    const std::string& robot,
+    uint64_t sequence,
+    const std::string& state,
+    bool sync);
+
+  // Append a delta backup of a robot, which replaces any earlier delta. If the
+  // latest full backup of the robot does not have the sequence number
+  // base_sequence, nothing is appended and this returns false.
+  bool append_delta(
+    const std::string& robot,
+    uint64_t sequence,
+    uint64_t base_sequence,
+    const std::string& patch,
+    bool sync);
+
+  // Append a record saying that a robot has no backup anymore
+  void erase(const std::string& robot, bool sync);
+
+  // Get the latest backup of a robot, if it has one, with its delta applied
+  std::optional<std::string> read(const std::string& robot) const;
+
+  // The names of the robots that have a backup
+  std::vector<std::string> robots() const;
+
+  // The number of bytes taken up by records, including replaced ones
+  std::size_t used_bytes() const;
+
+private:
+
+  struct Record
+  {
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  struct Latest
+  {
+    Record full;
+    std::optional<Record> delta;
+  };
+
+  void _open();
+  void _map(std::size_t capacity);
+  void _unmap();
+  void _recover();
+  void _index(std::string robot, uint32_t kind, Record record);
+  void _append(
+    const std::string& robot,
+    uint32_t kind,
+    uint64_t sequence,
+    const std::string& payload,
+    bool sync);
+  void _reserve(std::size_t record_size);
+  void _compact();
+  uint64_t _sequence(const Record& record) const;
+  std::string _payload(const Record& record) const;
+  std::string _read(const Latest& latest) const;
+
+  std::filesystem::path _file_path;
+  bool _compression;
+  int _fd = -1;
+  unsigned char* _data = nullptr;
+  std::size_t _capacity = 0;
+  std::size_t _end = 0;
+  std::size_t _live_bytes = 0;
+  std::unordered_map<std::string, Latest> _latest;
+  mutable std::mutex _mutex;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__BACKUPJOURNAL_HPP
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__BATTERYDRAIN_HPP
+#define SRC__RMF_TASK__BATTERYDRAIN_HPP
+
+#include <rmf_task/Parameters.hpp>
+
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+
+#include <rmf_traffic/Route.hpp>
+
+#include <typeinfo>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+// Evaluates the battery drain of a robot for many trajectories or durations at
+// once. Ambient devices normally draw a constant power, so their drain is
+// linear in time. When the ambient sink is known to be linear, a whole batch
+// of durations costs one tight loop and one multiplication instead of a
+// virtual call per duration. Other sinks are still asked about each duration.
+class BatteryDrain
+{
+public:
+
+  // Whether the drain of a sink is known to be proportional to its run time.
+  // This is only known for the sink types of rmf_battery that draw a constant
+  // power, and not for classes derived from them, which may override how the
+  // drain is computed.
+  static bool is_linear(const rmf_battery::DevicePowerSink& sink)
+  {
+    return typeid(sink) == typeid(rmf_battery::agv::SimpleDevicePowerSink);
+  }
+
+  BatteryDrain(
+    rmf_battery::ConstMotionPowerSinkPtr motion_sink,
+    rmf_battery::ConstDevicePowerSinkPtr ambient_sink)
+  : _motion_sink(std::move(motion_sink)),
+    _ambient_sink(std::move(ambient_sink))
+  {
+    if (!_ambient_sink || !is_linear(*_ambient_sink))
+      return;
+
+    _ambient_rate = _ambient_sink->compute_change_in_charge(1.0);
+    _linear = true;
+  }
+
+  explicit BatteryDrain(const Parameters& parameters)
+  : BatteryDrain(parameters.motion_sink(), parameters.ambient_sink())
+  {
+    // Do nothing
+  }
+
+  // The drain of the ambient devices over one duration
+  double ambient(double seconds) const
+  {
+    if (_linear)
+      return _ambient_rate * seconds;
+
+    return _ambient_sink->compute_change_in_charge(seconds);
+  }
+
+  // The total drain of the ambient devices over all the durations
+  double ambient(const std::vector<double>& seconds) const
+  {
+    if (_linear)
+    {
+      double total = 0.0;
+      for (const double s : seconds)
+        total += s;
+
+      return _ambient_rate * total;
+    }
+
+    double total = 0.0;
+    for (const double s : seconds)
+      total += _ambient_sink->compute_change_in_charge(s);
+
+    return total;
+  }
+
+  // The total drain of driving along every trajectory of an itinerary
+  double motion(const std::vector<rmf_traffic::Route>& itinerary) const
+  {
+    double total = 0.0;
+    for (const auto& route : itinerary)
+      total += _motion_sink->compute_change_in_charge(route.trajectory());
+
+    return total;
+  }
+
+  double motion(const rmf_traffic::Trajectory& trajectory) const
+  {
+    return _motion_sink->compute_change_in_charge(trajectory);
+  }
+
+  const rmf_battery::ConstMotionPowerSinkPtr& motion_sink() const
+  {
+    return _motion_sink;
+  }
+
+  const rmf_battery::ConstDevicePowerSinkPtr& ambient_sink() const
+  {
+    return _ambient_sink;
+  }
+
+private:
+  rmf_battery::ConstMotionPowerSinkPtr _motion_sink;
+  rmf_battery::ConstDevicePowerSinkPtr _ambient_sink;
+  double _ambient_rate = 0.0;
+  bool _linear = false;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__BATTERYDRAIN_HPP
@@ -16,9 +16,11 @@
 */
 
 #include "BinaryPriorityCostCalculator.hpp"
+#include "AssignmentHeuristic.hpp"
 #include "InvariantHeuristicQueue.hpp"
 
-#include <rmf_task/requests/ChargeBattery.hpp>
+#include <cmath>
+#include <optional>
 
 namespace rmf_task {
 
@@ -26,9 +28,7 @@ namespace rmf_task {
 auto BinaryPriorityCostCalculator::compute_g_assignment(
   const TaskPlanner::Assignment& assignment) const -> double
 {
-  if (std::dynamic_pointer_cast<
-      const rmf_task::requests::ChargeBattery::Description>(
-      assignment.request()->description()))
+  if (assignment.is_charging())
   {
     return 0.0; // Ignore charging tasks in cost
   }
@@ -61,10 +61,10 @@ auto BinaryPriorityCostCalculator::compute_g(
   double cost = 0.0;
   for (const auto& agent : node.assigned_tasks)
   {
-    for (const auto& assignment : agent)
-    {
-      cost += compute_g_assignment(assignment.assignment);
-    }
+    agent.for_each_reverse([&](const Node::AssignmentWrapper& assignment)
+      {
+        cost += compute_g_assignment(assignment.assignment);
+      });
   }
   return cost;
 }
@@ -73,57 +73,102 @@ auto BinaryPriorityCostCalculator::compute_g(
 auto BinaryPriorityCostCalculator::compute_h(
   const Node& node, const rmf_traffic::Time time_now) const -> double
 {
-  std::vector<double> initial_queue_values(
-    node.assigned_tasks.size(), std::numeric_limits<double>::infinity());
+  InvariantHeuristicQueue queue(initial_queue_values(node, time_now));
+  // NOTE: It is crucial that we use the ordered set of unassigned_invariants
+  // here. The InvariantHeuristicQueue expects the invariant costs to be passed
+  // to it in order of smallest to largest. If that assumption is not met, then
+  // the final cost that's calculated may be invalid.
+  node.unassigned_invariants.for_each([&](const Invariant& u)
+    {
+      queue.add(u.earliest_start_time, u.earliest_finish_time);
+    });
+
+  // Both are lower bounds on the same delay, so the larger one is as well
+  if (_assignment_bound)
+    return std::max(queue.compute_cost(), compute_assignment_h(node));
+
+  return queue.compute_cost();
+}
 
-  // Determine the earliest possible time an agent can begin the invariant
-  // portion of any of its next tasks
+//==============================================================================
+auto BinaryPriorityCostCalculator::compute_assignment_h(
+  const Node& node) const -> double
+{
+  // The candidates of each unassigned task are kept up to date as the agents
+  // get assignments, so the finish times are read without estimating anything
+  // Each task fills one row of finish times, which is reset after it has been
+  // added so that the row never needs to be allocated again
+  const std::size_t num_agents = node.assigned_tasks.size();
+  AssignmentHeuristic heuristic(num_agents);
+  std::vector<double> row(num_agents, std::numeric_limits<double>::infinity());
   for (const auto& u : node.unassigned_tasks)
   {
-    const auto invariant_duration = u.second.model->invariant_duration();
-    const rmf_traffic::Time earliest_deployment_time =
-      u.second.candidates.best_finish_time()
-      - invariant_duration;
-    const double earliest_deployment_time_s =
-      rmf_traffic::time::to_seconds(
-      earliest_deployment_time.time_since_epoch());
-
-    const auto& range = u.second.candidates.best_candidates();
+    const auto& range = u.second.candidates.all_candidates();
     for (auto it = range.begin; it != range.end; ++it)
     {
-      const std::size_t candidate = it->second.candidate;
-      if (earliest_deployment_time_s < initial_queue_values[candidate])
-        initial_queue_values[candidate] = earliest_deployment_time_s;
+      row[it->candidate] =
+        rmf_traffic::time::to_seconds(it->finish_time.time_since_epoch());
     }
+
+    heuristic.add_row(
+      rmf_traffic::time::to_seconds(
+        u.second.request->booking()->earliest_start_time().time_since_epoch()),
+      rmf_traffic::time::to_seconds(u.second.model->invariant_duration()),
+      row.data());
+
+    for (auto it = range.begin; it != range.end; ++it)
+      row[it->candidate] = std::numeric_limits<double>::infinity();
   }
 
-  for (std::size_t i = 0; i < initial_queue_values.size(); ++i)
-  {
-    auto& value = initial_queue_values[i];
-    if (std::isinf(value))
+  return heuristic.compute_cost();
+}
+
+//==============================================================================
+auto BinaryPriorityCostCalculator::compute_makespan(
+  const Node& node) const -> double
+{
+  if (_makespan_weight == 0.0)
+    return 0.0;
+
+  // The node keeps the span of its assigned requests up to date as they are
+  // assigned, so only the unassigned requests need to be visited
+  std::optional<rmf_traffic::Time> earliest_start =
+    node.assigned_earliest_start;
+  std::optional<rmf_traffic::Time> latest_finish = node.assigned_latest_finish;
+  const auto include = [&](rmf_traffic::Time start, rmf_traffic::Time finish)
     {
-      // Clear out any infinity placeholders. Those candidates simply don't have
-      // any unassigned tasks that want to use it.
-      const auto& assignments = node.assigned_tasks[i];
-      if (assignments.empty())
-        value = rmf_traffic::time::to_seconds(time_now.time_since_epoch());
-      else
-        value = rmf_traffic::time::to_seconds(
-          assignments.back().assignment.finish_state()
-          .time().value().time_since_epoch());
-    }
-  }
+      if (!earliest_start.has_value() || start < *earliest_start)
+        earliest_start = start;
 
-  InvariantHeuristicQueue queue(std::move(initial_queue_values));
-  // NOTE: It is crucial that we use the ordered set of unassigned_invariants
-  // here. The InvariantHeuristicQueue expects the invariant costs to be passed
-  // to it in order of smallest to largest. If that assumption is not met, then
-  // the final cost that's calculated may be invalid.
-  for (const auto& u : node.unassigned_invariants)
+      if (!latest_finish.has_value() || *latest_finish < finish)
+        latest_finish = finish;
+    };
+
+  // None of the unassigned requests can finish sooner than their best
+  // candidate, so this stays a lower bound on the final makespan
+  for (const auto& u : node.unassigned_tasks)
   {
-    queue.add(u.earliest_start_time, u.earliest_finish_time);
+    include(
+      u.second.request->booking()->earliest_start_time(),
+      u.second.candidates.best_finish_time());
   }
-  return queue.compute_cost();
+
+  if (!earliest_start.has_value())
+    return 0.0;
+
+  return _makespan_weight * std::max(
+    0.0, rmf_traffic::time::to_seconds(*latest_finish - *earliest_start));
+}
+
+//==============================================================================
+auto BinaryPriorityCostCalculator::compute_makespan(
+  const Assignments& assignments) const -> double
+{
+  if (_makespan_weight == 0.0)
+    return 0.0;
+
+  return _makespan_weight * rmf_traffic::time::to_seconds(
+    TaskPlanner::compute_objectives(assignments).makespan);
 }
 
 //==============================================================================
@@ -138,11 +183,11 @@ bool BinaryPriorityCostCalculator::valid_assignment_priority(
   for (std::size_t i = 0; i < num_agents; ++i)
   {
     const auto& assignments = node.assigned_tasks[i];
-    for (const auto& a : assignments)
-    {
-      if (a.assignment.request()->booking()->priority() != nullptr)
-        priority_count[i] += 1;
-    }
+    assignments.for_each_reverse([&](const Node::AssignmentWrapper& a)
+      {
+        if (a.assignment.request()->booking()->priority() != nullptr)
+          priority_count[i] += 1;
+      });
   }
   // Here we check if any of the agents is not assigned a priority task
   // while others are assigned more than one
@@ -164,26 +209,23 @@ bool BinaryPriorityCostCalculator::valid_assignment_priority(
     if (agent.empty())
       continue;
 
-    auto it = agent.begin();
+    const auto order = agent.in_order();
+    auto it = order.begin();
     // We update the iterator such that the first assignment is a non-charging task
-    while (std::dynamic_pointer_cast<
-        const rmf_task::requests::ChargeBattery::Description>(
-        it->assignment.request()->description()))
+    while ((*it)->assignment.is_charging())
     {
       ++it;
-      if (it == agent.end())
+      if (it == order.end())
         return true;
     }
 
-    auto prev_priority = it->assignment.request()->booking()->priority();
+    auto prev_priority = (*it)->assignment.request()->booking()->priority();
     ++it;
-    for (; it != agent.end(); ++it)
+    for (; it != order.end(); ++it)
     {
-      if (std::dynamic_pointer_cast<
-          const rmf_task::requests::ChargeBattery::Description>(
-          it->assignment.request()->description()))
+      if ((*it)->assignment.is_charging())
         continue;
-      auto curr_priority = it->assignment.request()->booking()->priority();
+      auto curr_priority = (*it)->assignment.request()->booking()->priority();
       if ((prev_priority == nullptr) && (curr_priority != nullptr))
         return false;
 
@@ -196,21 +238,86 @@ bool BinaryPriorityCostCalculator::valid_assignment_priority(
 
 //==============================================================================
 BinaryPriorityCostCalculator::BinaryPriorityCostCalculator(
-  double priority_penalty)
-: _priority_penalty(priority_penalty)
+  double priority_penalty,
+  double makespan_weight,
+  bool assignment_bound)
+: _priority_penalty(priority_penalty),
+  _makespan_weight(makespan_weight),
+  _assignment_bound(assignment_bound)
 {
   // Do nothing
 }
 
+//==============================================================================
+double BinaryPriorityCostCalculator::priority_penalty() const
+{
+  return _priority_penalty;
+}
+
+//==============================================================================
+double BinaryPriorityCostCalculator::makespan_weight() const
+{
+  return _makespan_weight;
+}
+
+//==============================================================================
+bool BinaryPriorityCostCalculator::assignment_bound() const
+{
+  return _assignment_bound;
+}
+
 //==============================================================================
 double BinaryPriorityCostCalculator::compute_cost(
   const Node& n,
   rmf_traffic::Time time_now,
   bool check_priority) const
 {
-  const double g = compute_g(n);
-  const double h = compute_h(n, time_now);
+  return combine(
+    n, compute_g(n) + compute_makespan(n), compute_h(n, time_now),
+    check_priority);
+}
+
+//==============================================================================
+double BinaryPriorityCostCalculator::compute_weighted_cost(
+  const Node& n,
+  rmf_traffic::Time time_now,
+  bool check_priority,
+  double heuristic_weight) const
+{
+  return combine(
+    n, compute_g(n) + compute_makespan(n),
+    heuristic_weight * compute_h(n, time_now), check_priority);
+}
+
+//==============================================================================
+double BinaryPriorityCostCalculator::compute_assignment_cost(
+  const TaskPlanner::Assignment& assignment) const
+{
+  return compute_g_assignment(assignment);
+}
+
+//==============================================================================
+double BinaryPriorityCostCalculator::compute_incremental_cost(
+  const Node& n,
+  rmf_traffic::Time time_now,
+  bool check_priority,
+  double heuristic_weight) const
+{
+  const double g = n.assigned_cost;
+  assert(std::abs(g - compute_g(n)) <= 1e-6 * std::max(1.0, std::abs(g)));
 
+  return combine(
+    n, g + compute_makespan(n), heuristic_weight * compute_h(n, time_now),
+    check_priority);
+}
+
+//==============================================================================
+double BinaryPriorityCostCalculator::combine(
+  const Node& n,
+  const double g,
+  const double h,
+  const bool check_priority) const
+{
   if (check_priority)
   {
     if (!valid_assignment_priority(n))
@@ -224,7 +331,7 @@ double BinaryPriorityCostCalculator::compute_cost(
 double BinaryPriorityCostCalculator::compute_cost(
   rmf_task::TaskPlanner::Assignments assignments) const
 {
-  return compute_g(assignments);
+  return compute_g(assignments) + compute_makespan(assignments);
 }
 
 } // namespace rmf_task
@@ -28,8 +28,22 @@ class BinaryPriorityCostCalculator : public CostCalculator
 public:
 
   /// Constructor
+  ///
+  /// If assignment_bound is true, the heuristic is the larger of the invariant
+  /// queue bound and the AssignmentHeuristic bound.
   BinaryPriorityCostCalculator(
-    double priority_penalty = 10000);
+    double priority_penalty = 10000,
+    double makespan_weight = 0.0,
+    bool assignment_bound = false);
+
+  /// The cost added to a node that delays a high priority request
+  double priority_penalty() const;
+
+  /// How much the makespan of a node adds to its cost
+  double makespan_weight() const;
+
+  /// Whether the AssignmentHeuristic bound is used
+  bool assignment_bound() const;
 
   /// Documentation inherited
   double compute_cost(
@@ -37,14 +51,34 @@ public:
     rmf_traffic::Time time_now,
     bool check_priority) const final;
 
+  /// Documentation inherited
+  double compute_weighted_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const final;
+
   /// Compute the cost of assignments
   double compute_cost(
     rmf_task::TaskPlanner::Assignments assignments) const final;
 
+  /// Documentation inherited
+  double compute_assignment_cost(
+    const TaskPlanner::Assignment& assignment) const final;
+
+  /// Documentation inherited
+  double compute_incremental_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const final;
+
 private:
   using Assignments = TaskPlanner::Assignments;
 
   double _priority_penalty;
+  double _makespan_weight;
+  bool _assignment_bound;
 
   double compute_g_assignment(const TaskPlanner::Assignment& assignment) const;
 
@@ -54,8 +88,24 @@ private:
 
   double compute_h(const Node& node, const rmf_traffic::Time time_now) const;
 
+  /// A lower bound on the total delay of the unassigned tasks of the node from
+  /// a min-cost assignment of the tasks to the queues of the agents
+  double compute_assignment_h(const Node& node) const;
+
+  /// A lower bound on the makespan of any assignments that this node can lead
+  /// to, weighted by _makespan_weight
+  double compute_makespan(const Node& node) const;
+
+  double compute_makespan(const Assignments& assignments) const;
+
   bool valid_assignment_priority(const Node& node) const;
 
+  double combine(
+    const Node& node,
+    double g,
+    double h,
+    bool check_priority) const;
+
 };
 
 } // namespace rmf_task
@@ -40,4 +40,21 @@ std::shared_ptr<CostCalculator> BinaryPriorityScheme::make_cost_calculator()
   return std::make_shared<BinaryPriorityCostCalculator>();
 }
 
+//==============================================================================
+std::shared_ptr<CostCalculator> BinaryPriorityScheme::make_cost_calculator(
+  const double makespan_weight)
+{
+  return std::make_shared<BinaryPriorityCostCalculator>(
+    10000, makespan_weight);
+}
+
+//==============================================================================
+std::shared_ptr<CostCalculator> BinaryPriorityScheme::make_cost_calculator(
+  const double makespan_weight,
+  const bool assignment_bound)
+{
+  return std::make_shared<BinaryPriorityCostCalculator>(
+    10000, makespan_weight, assignment_bound);
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__BUFFERAPPEND_HPP
+#define SRC__RMF_TASK__BUFFERAPPEND_HPP
+
+#include <charconv>
+#include <cstring>
+#include <string>
+
+namespace rmf_task {
+
+// Helpers for writing records straight onto the end of a buffer, shared by
+// the encoders of Log::Reader and PhaseDelta
+
+//==============================================================================
+inline void append_json_string(const std::string& text, std::string& buffer)
+{
+  static const char* const hex = "0123456789abcdef";
+
+  buffer.push_back('"');
+  for (const char c : text)
+  {
+    switch (c)
+    {
+      case '"':
+        buffer.append("\\\"");
+        break;
+      case '\\':
+        buffer.append("\\\\");
+        break;
+      case '\n':
+        buffer.append("\\n");
+        break;
+      case '\r':
+        buffer.append("\\r");
+        break;
+      case '\t':
+        buffer.append("\\t");
+        break;
+      default:
+      {
+        const auto byte = static_cast<unsigned char>(c);
+        if (byte < 0x20)
+        {
+          buffer.append("\\u00");
+          buffer.push_back(hex[byte >> 4]);
+          buffer.push_back(hex[byte & 0xf]);
+        }
+        else
+        {
+          // Everything else, including UTF-8 sequences, can be written as-is
+          buffer.push_back(c);
+        }
+      }
+    }
+  }
+  buffer.push_back('"');
+}
+
+//==============================================================================
+template<typename T>
+void append_number(T value, std::string& buffer)
+{
+  char digits[24];
+  const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+//==============================================================================
+template<typename T>
+void append_raw(T value, std::string& buffer)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  buffer.append(bytes, sizeof(T));
+}
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__BUFFERAPPEND_HPP
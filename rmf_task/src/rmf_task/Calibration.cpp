@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/Calibration.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+class Calibration::Implementation
+{
+public:
+
+  // A slot of the table. A key of 0 means that the slot is free. Once a key
+  // is claimed it never changes, so lookups need no lock.
+  struct Slot
+  {
+    std::atomic<uint64_t> key = 0;
+    std::atomic<double> factor = 1.0;
+    std::atomic<uint32_t> samples = 0;
+  };
+
+  // How many slots after its hash a key may be placed in
+  static constexpr std::size_t MaxProbes = 32;
+
+  std::vector<Slot> slots;
+  std::size_t mask;
+  double smoothing;
+  double min_factor;
+  double max_factor;
+  std::atomic<std::size_t> dropped = 0;
+  std::atomic<uint64_t> version = 0;
+
+  Implementation(
+    std::size_t capacity,
+    double smoothing_,
+    double min_factor_,
+    double max_factor_)
+  : slots(round_up(capacity)),
+    mask(slots.size() - 1),
+    smoothing(std::clamp(smoothing_, 0.0, 1.0)),
+    min_factor(min_factor_),
+    max_factor(std::max(min_factor_, max_factor_))
+  {
+    // Do nothing
+  }
+
+  static std::size_t round_up(std::size_t capacity)
+  {
+    std::size_t size = MaxProbes;
+    while (size < capacity)
+      size *= 2;
+
+    return size;
+  }
+
+  static uint64_t hash(
+    std::string_view type,
+    std::size_t start_waypoint,
+    std::size_t finish_waypoint)
+  {
+    uint64_t seed = std::hash<std::string_view>()(type);
+    for (const uint64_t value : {start_waypoint, finish_waypoint})
+      seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+
+    // Keep 0 free to mark the empty slots
+    return seed == 0 ? 1 : seed;
+  }
+
+  // Find the slot of a key, or claim one for it if claim is true
+  Slot* find(uint64_t key, bool claim)
+  {
+    for (std::size_t i = 0; i < MaxProbes; ++i)
+    {
+      Slot& slot = slots[(key + i) & mask];
+      uint64_t current = slot.key.load(std::memory_order_acquire);
+      if (current == key)
+        return &slot;
+
+      if (current != 0)
+        continue;
+
+      if (!claim)
+        return nullptr;
+
+      if (slot.key.compare_exchange_strong(current, key,
+        std::memory_order_acq_rel) || current == key)
+      {
+        return &slot;
+      }
+    }
+
+    return nullptr;
+  }
+
+  const Slot* find(uint64_t key) const
+  {
+    return const_cast<Implementation*>(this)->find(key, false);
+  }
+};
+
+//==============================================================================
+const std::string& Calibration::travel_type()
+{
+  static const std::string type = "travel";
+  return type;
+}
+
+//==============================================================================
+Calibration::Calibration(
+  std::size_t capacity,
+  double smoothing,
+  double min_factor,
+  double max_factor)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(
+      capacity, smoothing, min_factor, max_factor))
+{
+  // Do nothing
+}
+
+//==============================================================================
+bool Calibration::report(
+  std::string_view type,
+  std::size_t start_waypoint,
+  std::size_t finish_waypoint,
+  rmf_traffic::Duration estimate,
+  rmf_traffic::Duration actual)
+{
+  if (estimate.count() <= 0 || actual.count() < 0)
+    return false;
+
+  auto* slot = _pimpl->find(
+    Implementation::hash(type, start_waypoint, finish_waypoint), true);
+  if (!slot)
+  {
+    _pimpl->dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  const double ratio = std::clamp(
+    static_cast<double>(actual.count()) / static_cast<double>(estimate.count()),
+    _pimpl->min_factor, _pimpl->max_factor);
+
+  const bool first = slot->samples.fetch_add(1, std::memory_order_relaxed) == 0;
+  double current = slot->factor.load(std::memory_order_relaxed);
+  double next;
+  do
+  {
+    next = first ? ratio : current + _pimpl->smoothing * (ratio - current);
+  } while (!slot->factor.compare_exchange_weak(
+    current, next, std::memory_order_relaxed));
+
+  _pimpl->version.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+//==============================================================================
+bool Calibration::report(
+  std::string_view type,
+  std::size_t start_waypoint,
+  std::size_t finish_waypoint,
+  const Phase::Completed& completed)
+{
+  if (!completed.snapshot() || !completed.snapshot()->tag())
+    return false;
+
+  return report(
+    type, start_waypoint, finish_waypoint,
+    completed.snapshot()->tag()->header().original_duration_estimate(),
+    completed.finish_time() - completed.start_time());
+}
+
+//==============================================================================
+double Calibration::factor(
+  std::string_view type,
+  std::size_t start_waypoint,
+  std::size_t finish_waypoint) const
+{
+  const auto* slot = _pimpl->find(
+    Implementation::hash(type, start_waypoint, finish_waypoint));
+  if (!slot || slot->samples.load(std::memory_order_relaxed) == 0)
+    return 1.0;
+
+  return slot->factor.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+std::size_t Calibration::samples(
+  std::string_view type,
+  std::size_t start_waypoint,
+  std::size_t finish_waypoint) const
+{
+  const auto* slot = _pimpl->find(
+    Implementation::hash(type, start_waypoint, finish_waypoint));
+  if (!slot)
+    return 0;
+
+  return slot->samples.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+std::size_t Calibration::dropped() const
+{
+  return _pimpl->dropped.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+uint64_t Calibration::version() const
+{
+  return _pimpl->version.load(std::memory_order_acquire);
+}
+
+} // namespace rmf_task
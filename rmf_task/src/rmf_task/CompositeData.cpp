@@ -17,7 +17,11 @@
 
 #include <rmf_task/CompositeData.hpp>
 
+#include <algorithm>
+#include <mutex>
+#include <typeindex>
 #include <unordered_map>
+#include <vector>
 
 namespace rmf_task {
 
@@ -26,59 +30,163 @@ class CompositeData::Implementation
 {
 public:
 
-  std::unordered_map<std::type_index, std::any> data;
+  // A CompositeData rarely holds more than a handful of custom components, so
+  // a linear scan of a flat vector beats hashing
+  std::vector<std::pair<std::size_t, detail::ComponentHolder>> data;
 
+  // Set when a copy of the CompositeData starts sharing this storage. It is
+  // never cleared, so a CompositeData whose copies have all been destroyed
+  // still duplicates its storage once, but ownership never depends on a
+  // reference count that other threads may be changing.
+  std::mutex mutex;
+  bool shared = false;
+
+  Implementation() = default;
+
+  Implementation(const Implementation& other)
+  : data(other.data)
+  {
+    // Do nothing
+  }
+
+  static void share(const std::shared_ptr<Implementation>& pimpl)
+  {
+    if (!pimpl)
+      return;
+
+    std::lock_guard<std::mutex> lock(pimpl->mutex);
+    pimpl->shared = true;
+  }
+
+  // Make sure that the storage is owned by only one CompositeData
+  static void make_owned(std::shared_ptr<Implementation>& pimpl)
+  {
+    {
+      std::lock_guard<std::mutex> lock(pimpl->mutex);
+      if (!pimpl->shared)
+        return;
+    }
+
+    pimpl = std::make_shared<Implementation>(*pimpl);
+  }
 };
 
 //==============================================================================
 CompositeData::CompositeData()
-: _pimpl(rmf_utils::make_impl<Implementation>())
 {
   // Do nothing
 }
 
+//==============================================================================
+CompositeData::CompositeData(const CompositeData& other)
+: _present(other._present),
+  _pimpl(other._pimpl)
+{
+  std::copy(std::begin(other._slots), std::end(other._slots), _slots);
+  Implementation::share(_pimpl);
+}
+
+//==============================================================================
+CompositeData& CompositeData::operator=(const CompositeData& other)
+{
+  if (this == &other)
+    return *this;
+
+  std::copy(std::begin(other._slots), std::end(other._slots), _slots);
+  _present = other._present;
+  _pimpl = other._pimpl;
+  Implementation::share(_pimpl);
+  return *this;
+}
+
 //==============================================================================
 void CompositeData::clear()
 {
-  _pimpl->data.clear();
+  _present = 0;
+  _pimpl = nullptr;
 }
 
 //==============================================================================
-std::any* CompositeData::_get(std::type_index type)
+std::size_t CompositeData::_register(const std::type_info& type)
 {
-  const auto it = _pimpl->data.find(type);
-  if (it == _pimpl->data.end())
+  // This is only called once for each component type, so it does not need to
+  // be fast. Keeping the registry here gives each type a single ID, even when
+  // _id_of<T>() gets instantiated in several shared libraries.
+  static std::mutex mutex;
+  static std::unordered_map<std::type_index, std::size_t> ids;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return ids.insert({std::type_index(type), ids.size()}).first->second;
+}
+
+//==============================================================================
+detail::ComponentHolder* CompositeData::_get(std::size_t id) const
+{
+  if (!_pimpl)
     return nullptr;
 
-  return &it->second;
+  for (auto& [other_id, holder] : _pimpl->data)
+  {
+    if (other_id == id)
+      return &holder;
+  }
+
+  return nullptr;
 }
 
 //==============================================================================
-const std::any* CompositeData::_get(std::type_index type) const
+detail::ComponentHolder* CompositeData::_get_mutable(std::size_t id)
 {
-  return const_cast<CompositeData*>(this)->_get(type);
+  if (!_get(id))
+    return nullptr;
+
+  Implementation::make_owned(_pimpl);
+  return _get(id);
 }
 
 //==============================================================================
-auto CompositeData::_insert(std::any value, bool or_assign)
--> InsertResult<std::any>
+auto CompositeData::_insert(
+  std::size_t id,
+  detail::ComponentHolder value,
+  bool or_assign) -> InsertResult<detail::ComponentHolder>
 {
-  if (or_assign)
+  if (auto* existing = _get_mutable(id))
   {
-    const auto insertion =
-      _pimpl->data.insert_or_assign(value.type(), std::move(value));
+    if (or_assign)
+      *existing = std::move(value);
 
-    return {insertion.second, &insertion.first->second};
+    return {false, existing};
   }
 
-  const auto insertion = _pimpl->data.insert({value.type(), std::move(value)});
-  return {insertion.second, &insertion.first->second};
+  if (!_pimpl)
+    _pimpl = std::make_shared<Implementation>();
+  else
+    Implementation::make_owned(_pimpl);
+
+  _pimpl->data.emplace_back(id, std::move(value));
+  return {true, &_pimpl->data.back().second};
 }
 
 //==============================================================================
-bool CompositeData::_erase(std::type_index type)
+bool CompositeData::_erase(std::size_t id)
 {
-  return _pimpl->data.erase(type) > 0;
+  if (!_get_mutable(id))
+    return false;
+
+  auto& data = _pimpl->data;
+  for (std::size_t i = 0; i < data.size(); ++i)
+  {
+    if (data[i].first == id)
+    {
+      if (i + 1 != data.size())
+        data[i] = std::move(data.back());
+
+      data.pop_back();
+      return true;
+    }
+  }
+
+  return false;
 }
 
 } // namespace rmf_task
@@ -0,0 +1,289 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/CompositeDataCodec.hpp>
+#include <rmf_task/State.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "BufferAppend.hpp"
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+constexpr std::uint8_t RecordLayout = 1;
+
+// The size, layout and count at the start of a record
+constexpr std::size_t RecordHeaderSize =
+  sizeof(std::uint32_t) + sizeof(std::uint8_t) + sizeof(std::uint16_t);
+
+// The tag, version and size in front of each component
+constexpr std::size_t ComponentHeaderSize =
+  sizeof(std::uint32_t) + sizeof(std::uint16_t) + sizeof(std::uint32_t);
+
+//==============================================================================
+template<typename T>
+T read_raw(const char* bytes)
+{
+  T value;
+  std::memcpy(&value, bytes, sizeof(T));
+  return value;
+}
+
+//==============================================================================
+template<typename T>
+void overwrite_raw(T value, std::string& buffer, std::size_t at)
+{
+  std::memcpy(buffer.data() + at, &value, sizeof(T));
+}
+
+//==============================================================================
+/// Register a built-in component whose value is written as one number of
+/// type Raw
+template<typename Component, typename Raw, typename ToRaw, typename FromRaw>
+void add_builtin(
+  CompositeDataCodec& codec,
+  std::uint32_t tag,
+  ToRaw to_raw,
+  FromRaw from_raw)
+{
+  codec.add<Component>(
+    tag, 1,
+    [to_raw](const Component& component, std::string& buffer)
+    {
+      append_raw<Raw>(to_raw(component), buffer);
+    },
+    [from_raw](std::string_view data, std::uint16_t)
+    -> std::optional<Component>
+    {
+      if (data.size() != sizeof(Raw))
+        return std::nullopt;
+
+      return Component(from_raw(read_raw<Raw>(data.data())));
+    });
+}
+
+} // anonymous namespace
+
+//==============================================================================
+class CompositeDataCodec::Implementation
+{
+public:
+
+  struct Entry
+  {
+    std::type_index type;
+    std::uint32_t tag;
+    std::uint16_t version;
+    Writer writer;
+    Reader reader;
+  };
+
+  // Only a handful of kinds of components are ever registered, so the entries
+  // are searched linearly instead of through a map
+  std::vector<Entry> entries;
+
+  const Entry* find(std::uint32_t tag) const
+  {
+    for (const auto& entry : entries)
+    {
+      if (entry.tag == tag)
+        return &entry;
+    }
+
+    return nullptr;
+  }
+};
+
+//==============================================================================
+CompositeDataCodec::CompositeDataCodec()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  using Time = rmf_traffic::Time;
+
+  add_builtin<State::CurrentWaypoint, std::uint64_t>(
+    *this, 1,
+    [](const State::CurrentWaypoint& c) { return c.value; },
+    [](std::uint64_t raw) { return static_cast<std::size_t>(raw); });
+
+  add_builtin<State::CurrentOrientation, double>(
+    *this, 2,
+    [](const State::CurrentOrientation& c) { return c.value; },
+    [](double raw) { return raw; });
+
+  add_builtin<State::CurrentTime, std::int64_t>(
+    *this, 3,
+    [](const State::CurrentTime& c)
+    {
+      return static_cast<std::int64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          c.value.time_since_epoch()).count());
+    },
+    [](std::int64_t raw)
+    {
+      return Time(std::chrono::duration_cast<Time::duration>(
+          std::chrono::nanoseconds(raw)));
+    });
+
+  add_builtin<State::DedicatedChargingPoint, std::uint64_t>(
+    *this, 4,
+    [](const State::DedicatedChargingPoint& c) { return c.value; },
+    [](std::uint64_t raw) { return static_cast<std::size_t>(raw); });
+
+  add_builtin<State::CurrentBatterySoC, double>(
+    *this, 5,
+    [](const State::CurrentBatterySoC& c) { return c.value; },
+    [](double raw) { return raw; });
+
+  add_builtin<State::PayloadCapacity, std::uint32_t>(
+    *this, 6,
+    [](const State::PayloadCapacity& c) { return c.value; },
+    [](std::uint32_t raw) { return raw; });
+}
+
+//==============================================================================
+std::size_t CompositeDataCodec::encode(
+  const CompositeData& data,
+  std::string& buffer) const
+{
+  const std::size_t start = buffer.size();
+  append_raw<std::uint32_t>(0, buffer);
+  append_raw<std::uint8_t>(RecordLayout, buffer);
+  append_raw<std::uint16_t>(0, buffer);
+
+  std::uint16_t count = 0;
+  for (const auto& entry : _pimpl->entries)
+  {
+    const std::size_t header = buffer.size();
+    append_raw<std::uint32_t>(entry.tag, buffer);
+    append_raw<std::uint16_t>(entry.version, buffer);
+    append_raw<std::uint32_t>(0, buffer);
+
+    if (!entry.writer(data, buffer))
+    {
+      // The data does not have this component
+      buffer.resize(header);
+      continue;
+    }
+
+    overwrite_raw<std::uint32_t>(
+      static_cast<std::uint32_t>(
+        buffer.size() - header - ComponentHeaderSize),
+      buffer, header + sizeof(std::uint32_t) + sizeof(std::uint16_t));
+    ++count;
+  }
+
+  overwrite_raw<std::uint32_t>(
+    static_cast<std::uint32_t>(buffer.size() - start - sizeof(std::uint32_t)),
+    buffer, start);
+  overwrite_raw<std::uint16_t>(
+    count, buffer, start + sizeof(std::uint32_t) + sizeof(std::uint8_t));
+
+  return buffer.size() - start;
+}
+
+//==============================================================================
+std::size_t CompositeDataCodec::decode(
+  std::string_view bytes,
+  CompositeData& data) const
+{
+  const auto fail = [](const std::string& what)
+    {
+      throw std::runtime_error(
+        "[rmf_task::CompositeDataCodec::decode] " + what);
+    };
+
+  if (bytes.size() < RecordHeaderSize)
+    fail("The bytes are too short to hold a record");
+
+  const std::size_t size =
+    sizeof(std::uint32_t) + read_raw<std::uint32_t>(bytes.data());
+  if (bytes.size() < size || size < RecordHeaderSize)
+    fail("The record is cut off");
+
+  const auto layout =
+    read_raw<std::uint8_t>(bytes.data() + sizeof(std::uint32_t));
+  if (layout != RecordLayout)
+    fail("Unknown record layout [" + std::to_string(layout) + "]");
+
+  const auto count = read_raw<std::uint16_t>(
+    bytes.data() + sizeof(std::uint32_t) + sizeof(std::uint8_t));
+
+  std::size_t at = RecordHeaderSize;
+  for (std::uint16_t i = 0; i < count; ++i)
+  {
+    if (size - at < ComponentHeaderSize)
+      fail("A component is cut off");
+
+    const char* header = bytes.data() + at;
+    const auto tag = read_raw<std::uint32_t>(header);
+    const auto version =
+      read_raw<std::uint16_t>(header + sizeof(std::uint32_t));
+    const auto length = read_raw<std::uint32_t>(
+      header + sizeof(std::uint32_t) + sizeof(std::uint16_t));
+    at += ComponentHeaderSize;
+
+    if (size - at < length)
+      fail("A component is cut off");
+
+    if (const auto* entry = _pimpl->find(tag))
+      entry->reader(bytes.substr(at, length), version, data);
+
+    at += length;
+  }
+
+  return size;
+}
+
+//==============================================================================
+void CompositeDataCodec::_add(
+  std::type_index type,
+  const std::uint32_t tag,
+  const std::uint16_t version,
+  Writer writer,
+  Reader reader)
+{
+  auto& entries = _pimpl->entries;
+  for (const auto& entry : entries)
+  {
+    if (entry.tag == tag && entry.type != type)
+    {
+      throw std::invalid_argument(
+        "[rmf_task::CompositeDataCodec::add] Tag [" + std::to_string(tag)
+        + "] is already used by a different kind of component");
+    }
+  }
+
+  Implementation::Entry fresh{
+    type, tag, version, std::move(writer), std::move(reader)};
+
+  for (auto& entry : entries)
+  {
+    if (entry.type == type)
+    {
+      entry = std::move(fresh);
+      return;
+    }
+  }
+
+  entries.push_back(std::move(fresh));
+}
+
+} // namespace rmf_task
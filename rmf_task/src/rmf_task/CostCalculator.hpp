@@ -34,10 +34,60 @@ public:
     rmf_traffic::Time time_now,
     bool check_priority) const = 0;
 
+  /// Compute the cost of a node while multiplying its estimated cost-to-go by
+  /// heuristic_weight. This is used by the anytime planner to find good
+  /// solutions quickly before proving optimality. Implementations that cannot
+  /// separate the two parts of the cost may simply ignore the weight.
+  virtual double compute_weighted_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const
+  {
+    (void)(heuristic_weight);
+    return compute_cost(n, time_now, check_priority);
+  }
+
   /// Compute the cost of assignments
   virtual double compute_cost(
     rmf_task::TaskPlanner::Assignments assignments) const = 0;
 
+  /// Compute how much a single assignment contributes to the cost of a node.
+  /// The planner accumulates this in Node::assigned_cost as it assigns and
+  /// unassigns tasks, so a child node's cost is its parent's cost terms plus
+  /// the delta of its new assignments.
+  virtual double compute_assignment_cost(
+    const TaskPlanner::Assignment& assignment) const
+  {
+    (void)(assignment);
+    return 0.0;
+  }
+
+  /// Compute the weighted cost of a node using its Node::assigned_cost instead
+  /// of visiting all of its assignments. Implementations that do not override
+  /// compute_assignment_cost() should leave this as the default, which simply
+  /// computes the cost from scratch.
+  virtual double compute_incremental_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const
+  {
+    if (heuristic_weight == 1.0)
+      return compute_cost(n, time_now, check_priority);
+
+    return compute_weighted_cost(n, time_now, check_priority, heuristic_weight);
+  }
+
+  /// Whether the cost of a node depends on the order of the priorities of the
+  /// assignments of each agent. If it does, then the planner discards children
+  /// that force a priority inversion, and does not prune dominated nodes when
+  /// any request has a priority, since dominance does not account for order.
+  virtual bool orders_priorities() const
+  {
+    return true;
+  }
+
   virtual ~CostCalculator() = default;
 };
 
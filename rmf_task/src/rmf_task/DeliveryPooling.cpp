@@ -0,0 +1,230 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "DeliveryPooling.hpp"
+
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/PooledDelivery.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_set>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+const requests::Delivery::Description* get_delivery(const Request& request)
+{
+  return dynamic_cast<const requests::Delivery::Description*>(
+    request.description().get());
+}
+
+//==============================================================================
+struct Member
+{
+  std::size_t index;
+  rmf_traffic::Time earliest_start_time;
+  const requests::Delivery::Description* delivery;
+  uint32_t compartments;
+};
+
+//==============================================================================
+// Whether carrying the group together travels less than carrying each of its
+// deliveries on its own. The waits at the pickups and dropoffs are the same
+// either way, so only the travel is compared.
+bool saves_travel(
+  const std::vector<Member>& group,
+  const TravelDuration& travel)
+{
+  const auto start = group.front().earliest_start_time;
+  rmf_traffic::Duration separate(0);
+  rmf_traffic::Duration pooled(0);
+  const auto add = [&](
+    rmf_traffic::Duration& total, std::size_t from, std::size_t to)
+    {
+      if (from == to)
+        return true;
+
+      const auto duration = travel(from, to, start);
+      if (!duration.has_value())
+        return false;
+
+      total += *duration;
+      return true;
+    };
+
+  for (std::size_t i = 0; i < group.size(); ++i)
+  {
+    const auto& d = *group[i].delivery;
+    if (!add(separate, d.pickup_waypoint(), d.dropoff_waypoint()))
+      return false;
+
+    if (i + 1 < group.size())
+    {
+      const auto& next = *group[i+1].delivery;
+      if (!add(separate, d.dropoff_waypoint(), next.pickup_waypoint()))
+        return false;
+      if (!add(pooled, d.pickup_waypoint(), next.pickup_waypoint()))
+        return false;
+      if (!add(pooled, d.dropoff_waypoint(), next.dropoff_waypoint()))
+        return false;
+    }
+  }
+
+  const auto& last = *group.back().delivery;
+  const auto& first = *group.front().delivery;
+  if (!add(pooled, last.pickup_waypoint(), first.dropoff_waypoint()))
+    return false;
+
+  return pooled < separate;
+}
+} // anonymous namespace
+
+//==============================================================================
+uint32_t payload_capacity(const std::vector<State>& agents)
+{
+  if (agents.empty())
+    return 1;
+
+  uint32_t capacity = std::numeric_limits<uint32_t>::max();
+  for (const auto& agent : agents)
+    capacity = std::min(capacity, agent.payload_capacity().value_or(1));
+
+  return capacity;
+}
+
+//==============================================================================
+uint32_t compartments(const Request& request)
+{
+  const auto* delivery = get_delivery(request);
+  if (!delivery)
+    return 0;
+
+  std::unordered_set<std::string> distinct;
+  for (const auto& component : delivery->payload().components())
+    distinct.insert(component.compartment());
+
+  return std::max<uint32_t>(1, static_cast<uint32_t>(distinct.size()));
+}
+
+//==============================================================================
+std::vector<ConstRequestPtr> pool_deliveries(
+  const std::vector<ConstRequestPtr>& requests,
+  const uint32_t capacity,
+  const rmf_traffic::Duration window,
+  const TravelDuration& travel)
+{
+  if (capacity < 2)
+    return requests;
+
+  std::vector<Member> members;
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    const auto& request = *requests[i];
+    const auto* delivery = get_delivery(request);
+    if (!delivery)
+      continue;
+
+    const uint32_t size = compartments(request);
+    if (size >= capacity)
+      continue;
+
+    members.push_back(
+      {i, request.booking()->earliest_start_time(), delivery, size});
+  }
+
+  if (members.size() < 2)
+    return requests;
+
+  std::stable_sort(members.begin(), members.end(),
+    [](const Member& a, const Member& b)
+    {
+      return a.earliest_start_time < b.earliest_start_time;
+    });
+
+  // The pooled request for the first index of each group, and nullptr for
+  // every other index that was pooled
+  std::vector<std::optional<ConstRequestPtr>> replace(requests.size());
+  const auto close = [&](std::vector<Member>& group)
+    {
+      if (group.size() > 1)
+      {
+        std::vector<ConstRequestPtr> deliveries;
+        std::size_t first = requests.size();
+        for (const auto& member : group)
+        {
+          deliveries.push_back(requests[member.index]);
+          replace[member.index] = nullptr;
+          first = std::min(first, member.index);
+        }
+
+        replace[first] = requests::PooledDelivery::make(std::move(deliveries));
+      }
+
+      group.clear();
+    };
+
+  std::vector<Member> group;
+  uint32_t load = 0;
+  for (const auto& member : members)
+  {
+    if (!group.empty())
+    {
+      const bool fits = load + member.compartments <= capacity
+        && member.earliest_start_time - group.front().earliest_start_time
+        <= window;
+
+      bool joined = false;
+      if (fits)
+      {
+        group.push_back(member);
+        joined = saves_travel(group, travel);
+        if (!joined)
+          group.pop_back();
+      }
+
+      if (joined)
+      {
+        load += member.compartments;
+        continue;
+      }
+
+      close(group);
+    }
+
+    group.push_back(member);
+    load = member.compartments;
+  }
+
+  close(group);
+
+  std::vector<ConstRequestPtr> pooled;
+  pooled.reserve(requests.size());
+  for (std::size_t i = 0; i < requests.size(); ++i)
+  {
+    if (!replace[i].has_value())
+      pooled.push_back(requests[i]);
+    else if (*replace[i])
+      pooled.push_back(std::move(*replace[i]));
+  }
+
+  return pooled;
+}
+
+} // namespace rmf_task
@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__DELIVERYPOOLING_HPP
+#define SRC__RMF_TASK__DELIVERYPOOLING_HPP
+
+#include <rmf_task/Request.hpp>
+#include <rmf_task/State.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+namespace rmf_task {
+
+// Estimate how long it takes to travel between two waypoints, or std::nullopt
+// if there is no way between them
+using TravelDuration = std::function<
+  std::optional<rmf_traffic::Duration>(
+    std::size_t from, std::size_t to, rmf_traffic::Time start)>;
+
+// The number of payload compartments that every agent can fill at once. This
+// is the least PayloadCapacity of the agents, and an agent without one counts
+// as 1.
+uint32_t payload_capacity(const std::vector<State>& agents);
+
+// The number of compartments that a request fills if it is a Delivery: one
+// for each distinct compartment of its payload, and at least 1. Other requests
+// fill 0.
+uint32_t compartments(const Request& request);
+
+// Replace groups of Delivery requests with PooledDelivery requests that carry
+// them in one trip. The deliveries are taken in order of their earliest start
+// times, and each one joins the group before it when
+//  - it may begin within the window of the first delivery of the group,
+//  - the compartments of the group still fit in the capacity, and
+//  - visiting every pickup and then every dropoff travels less than doing the
+//    deliveries one after another, including the trips from each dropoff to
+//    the next pickup.
+// A pooled request takes the place of the first delivery of its group, and
+// every other request is left where it is.
+std::vector<ConstRequestPtr> pool_deliveries(
+  const std::vector<ConstRequestPtr>& requests,
+  uint32_t capacity,
+  rmf_traffic::Duration window,
+  const TravelDuration& travel);
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__DELIVERYPOOLING_HPP
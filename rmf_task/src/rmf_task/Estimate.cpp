@@ -15,13 +15,117 @@
  *
 */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <limits>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
+#include <queue>
+#include <shared_mutex>
+#include <type_traits>
 
+#include <rmf_task/AllocationCounter.hpp>
 #include <rmf_task/Estimate.hpp>
 
+#include "BatteryDrain.hpp"
+#include "LatencyHistogram.hpp"
+#include "MappedFile.hpp"
+#include "TraceSpan.hpp"
+
 namespace rmf_task {
 
+namespace {
+//==============================================================================
+// FNV-1a, used to fingerprint the inputs that estimates depend on
+class Fingerprint
+{
+public:
+
+  template<typename T>
+  Fingerprint& add(const T& value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (const auto b : bytes)
+    {
+      _hash ^= b;
+      _hash *= 1099511628211ull;
+    }
+
+    return *this;
+  }
+
+  Fingerprint& add(const std::string& value)
+  {
+    add(value.size());
+    for (const auto c : value)
+      add(c);
+
+    return *this;
+  }
+
+  uint64_t value() const
+  {
+    return _hash;
+  }
+
+private:
+  uint64_t _hash = 14695981039346656037ull;
+};
+
+//==============================================================================
+// The layout of a saved cache file is the header below followed by
+// count records. All values are stored in the native byte order of the
+// machine, which the fingerprint also covers.
+constexpr char CacheFileMagic[8] = {'R', 'M', 'F', 'T', 'R', 'V', 'L', '2'};
+
+struct CacheFileHeader
+{
+  char magic[8];
+  uint64_t fingerprint;
+  uint64_t num_waypoints;
+  uint64_t count;
+};
+
+struct CacheFileRecord
+{
+  uint32_t start;
+  uint32_t goal;
+  uint64_t orientation;
+  uint8_t reachable;
+  int64_t duration;
+  double change_in_charge;
+};
+
+//==============================================================================
+// A table that is shared through a mapped file is this header followed by the
+// trips of the table in memory order. complete is only set once every trip
+// has been written.
+constexpr char SharedTableMagic[8] = {'R', 'M', 'F', 'T', 'S', 'H', 'M', '1'};
+
+struct SharedTableHeader
+{
+  char magic[8];
+  uint64_t fingerprint;
+  uint64_t num_waypoints;
+  uint64_t complete;
+};
+
+} // anonymous namespace
+
 //==============================================================================
 class Estimate::Implementation
 {
@@ -44,11 +148,17 @@ Estimate::Estimate(State finish_state, rmf_traffic::Time wait_until)
 }
 
 //==============================================================================
-State Estimate::finish_state() const
+const State& Estimate::finish_state() const&
 {
   return _pimpl->_finish_state;
 }
 
+//==============================================================================
+State Estimate::finish_state() &&
+{
+  return std::move(_pimpl->_finish_state);
+}
+
 //==============================================================================
 Estimate& Estimate::finish_state(State new_finish_state)
 {
@@ -89,6 +199,118 @@ public:
   double change_in_charge;
 };
 
+//==============================================================================
+class TravelEstimator::Statistics::Implementation
+{
+public:
+
+  static Implementation& get(Statistics& statistics)
+  {
+    return *statistics._pimpl;
+  }
+
+  std::size_t hits = 0;
+  std::size_t misses = 0;
+  std::size_t failed_plans = 0;
+  std::size_t evictions = 0;
+  std::size_t entries = 0;
+  rmf_traffic::Duration total_miss_latency = rmf_traffic::Duration(0);
+  std::vector<std::size_t> latencies = std::vector<std::size_t>(LatencyBuckets);
+};
+
+//==============================================================================
+TravelEstimator::Statistics::Statistics()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::size_t TravelEstimator::Statistics::hits() const
+{
+  return _pimpl->hits;
+}
+
+//==============================================================================
+std::size_t TravelEstimator::Statistics::misses() const
+{
+  return _pimpl->misses;
+}
+
+//==============================================================================
+std::size_t TravelEstimator::Statistics::failed_plans() const
+{
+  return _pimpl->failed_plans;
+}
+
+//==============================================================================
+std::size_t TravelEstimator::Statistics::evictions() const
+{
+  return _pimpl->evictions;
+}
+
+//==============================================================================
+rmf_traffic::Duration TravelEstimator::Statistics::total_miss_latency() const
+{
+  return _pimpl->total_miss_latency;
+}
+
+//==============================================================================
+rmf_traffic::Duration TravelEstimator::Statistics::p99_miss_latency() const
+{
+  std::size_t count = 0;
+  for (const auto n : _pimpl->latencies)
+    count += n;
+
+  if (count == 0)
+    return rmf_traffic::Duration(0);
+
+  const std::size_t rank = count - count / 100;
+  std::size_t seen = 0;
+  for (std::size_t i = 0; i < _pimpl->latencies.size(); ++i)
+  {
+    seen += _pimpl->latencies[i];
+    if (seen >= rank)
+      return latency_bucket_limit(i);
+  }
+
+  return latency_bucket_limit(LatencyBuckets - 1);
+}
+
+//==============================================================================
+std::size_t TravelEstimator::Statistics::entries() const
+{
+  return _pimpl->entries;
+}
+
+//==============================================================================
+auto TravelEstimator::Statistics::since(const Statistics& earlier) const
+-> Statistics
+{
+  // The counters may have been reset after the earlier snapshot was taken
+  const auto minus = [](std::size_t a, std::size_t b)
+    {
+      return a > b ? a - b : 0;
+    };
+
+  const auto& a = *_pimpl;
+  const auto& b = *earlier._pimpl;
+
+  Statistics output;
+  auto& d = *output._pimpl;
+  d.hits = minus(a.hits, b.hits);
+  d.misses = minus(a.misses, b.misses);
+  d.failed_plans = minus(a.failed_plans, b.failed_plans);
+  d.evictions = minus(a.evictions, b.evictions);
+  d.entries = a.entries;
+  d.total_miss_latency = std::max(
+    a.total_miss_latency - b.total_miss_latency, rmf_traffic::Duration(0));
+  for (std::size_t i = 0; i < LatencyBuckets; ++i)
+    d.latencies[i] = minus(a.latencies[i], b.latencies[i]);
+
+  return output;
+}
+
 //==============================================================================
 class TravelEstimator::Implementation
 {
@@ -96,67 +318,308 @@ public:
 
   Implementation(const Parameters& parameters)
   : planner(parameters.planner()),
-    motion_sink(parameters.motion_sink()),
-    ambient_sink(parameters.ambient_sink()),
-    cache(make_cache(planner))
+    drain(parameters),
+    shards(make_shards(planner))
   {
     // Do nothing
   }
 
+  ~Implementation()
+  {
+    // Skip whatever is left of the prefetches and wait for the trips that are
+    // being planned right now
+    stopping = true;
+    std::unique_lock<std::mutex> lock(prefetch_mutex);
+    prefetched.wait(lock, [&]() { return prefetching == 0; });
+  }
+
+  std::shared_future<void> prefetch(
+    std::vector<std::pair<std::size_t, std::size_t>> trips)
+  {
+    auto promise = std::make_shared<std::promise<void>>();
+    auto future = promise->get_future().share();
+    {
+      std::lock_guard<std::mutex> lock(prefetch_mutex);
+      ++prefetching;
+    }
+
+    // The trips are planned one after another by a single job, so a large
+    // prefetch does not crowd out the other work of the executor
+    const auto& pool = executor ? executor : Executor::default_executor();
+    pool->post(
+      [this, trips = std::move(trips), promise]()
+      {
+        const auto N = num_waypoints();
+        for (const auto& [start, goal] : trips)
+        {
+          if (stopping)
+            break;
+
+          if (start >= N || goal >= N)
+            continue;
+
+          try
+          {
+            estimate(
+              rmf_traffic::agv::Plan::Start(rmf_traffic::Time(), start, 0.0),
+              rmf_traffic::agv::Plan::Goal(goal));
+          }
+          catch (...)
+          {
+            // The trip will be planned again when it is looked up
+          }
+        }
+
+        promise->set_value();
+        std::lock_guard<std::mutex> lock(prefetch_mutex);
+        --prefetching;
+        prefetched.notify_all();
+      });
+
+    return future;
+  }
+
+  // Unless by_floor is false, a trip between floors that is not cached is
+  // estimated by way of the portals when split_floors is set
   std::optional<Result> estimate(
     const rmf_traffic::agv::Plan::Start& start,
-    const rmf_traffic::agv::Plan::Goal& goal) const
+    const rmf_traffic::agv::Plan::Goal& goal,
+    bool by_floor = true) const
   {
-    std::pair<Cache::iterator, bool> insertion;
+    const Key wps = key_of(start, goal);
+    auto& shard = *shards[shard_of(wps)];
     {
-      std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
-      while (!lock.try_lock()) {}
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      if (shard.table && wps.orientation == 0)
+      {
+        const auto trip = shard.table->at(wps);
+        lock.unlock();
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        if (!trip.reachable)
+          return std::nullopt;
+
+        return Result::Implementation::make(
+          trip.duration, trip.change_in_charge);
+      }
+
+      if (const auto* entry = shard.find(wps))
+      {
+        // Copy the future so that we can wait on it without holding the lock
+        auto future = entry->future;
+        lock.unlock();
+        return future.get();
+      }
+    }
 
-      Key wps{start.waypoint(), goal.waypoint()};
-      insertion = cache.insert(std::make_pair(wps, Value()));
+    if (by_floor && split_floors)
+    {
+      const auto current = get_floors();
+      if (current->crosses(start.waypoint(), goal.waypoint()))
+        return estimate_by_floor(*current, start, goal);
     }
 
-    if (!insertion.second)
-      return insertion.first->second;
+    // Claim the key by publishing a future for it. Anyone else who asks for
+    // the same key while we are calculating will wait on this future instead
+    // of calculating the same plan again.
+    std::promise<Value> promise;
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      const auto insertion = shard.insert(wps, promise.get_future().share());
+      if (!insertion.second)
+      {
+        // Someone else claimed the key right before we did
+        auto future = insertion.first;
+        lock.unlock();
+        return future.get();
+      }
+    }
 
-    auto result = calculate_result(start, goal);
+    std::optional<Result> result;
+    try
+    {
+      result = calculate_miss(shard, wps, start, goal);
+      promise.set_value(result);
+    }
+    catch (...)
     {
-      std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
-      while (!lock.try_lock()) {}
-      insertion.first->second = result;
+      // Pass the error to anyone who is already waiting, but forget the key
+      // so that a later request can try again.
+      promise.set_exception(std::current_exception());
+      {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.erase(wps);
+      }
+      throw;
     }
 
+    fill_row(start, wps);
     return result;
   }
 
+  std::vector<std::optional<Result>> estimate(
+    const rmf_traffic::agv::Plan::Start& start,
+    const std::vector<rmf_traffic::agv::Plan::Goal>& goals) const
+  {
+    std::vector<std::optional<Result>> results(goals.size());
+    std::vector<Key> keys;
+    keys.reserve(goals.size());
+    for (const auto& goal : goals)
+      keys.push_back(key_of(start, goal));
+
+    // Group the goals by shard so that each shard only gets locked once for
+    // the lookups and once more to claim any keys that were missing
+    std::vector<std::vector<std::size_t>> by_shard(NumShards);
+    for (std::size_t i = 0; i < goals.size(); ++i)
+      by_shard[shard_of(keys[i])].push_back(i);
+
+    std::vector<std::shared_future<Value>> futures(goals.size());
+    std::vector<std::size_t> missing;
+    for (std::size_t s = 0; s < NumShards; ++s)
+    {
+      if (by_shard[s].empty())
+        continue;
+
+      auto& shard = *shards[s];
+      std::shared_lock<std::shared_mutex> lock(shard.mutex);
+      for (const auto i : by_shard[s])
+      {
+        const Key& wps = keys[i];
+        if (shard.table && wps.orientation == 0)
+        {
+          shard.hits.fetch_add(1, std::memory_order_relaxed);
+          const auto& trip = shard.table->at(wps);
+          if (trip.reachable)
+          {
+            results[i] = Result::Implementation::make(
+              trip.duration, trip.change_in_charge);
+          }
+
+          continue;
+        }
+
+        if (const auto* entry = shard.find(wps))
+          futures[i] = entry->future;
+        else
+          missing.push_back(i);
+      }
+    }
+
+    if (split_floors && !missing.empty())
+    {
+      const auto current = get_floors();
+      std::vector<std::size_t> within_floor;
+      for (const auto i : missing)
+      {
+        if (current->crosses(start.waypoint(), goals[i].waypoint()))
+          results[i] = estimate_by_floor(*current, start, goals[i]);
+        else
+          within_floor.push_back(i);
+      }
+
+      missing = std::move(within_floor);
+    }
+
+    // Claim every key that was missing, in the same way that the single
+    // estimate() does, so that nothing gets calculated twice
+    std::vector<std::pair<std::size_t, std::promise<Value>>> claims;
+    std::vector<std::vector<std::size_t>> missing_by_shard(NumShards);
+    for (const auto i : missing)
+      missing_by_shard[shard_of(keys[i])].push_back(i);
+
+    for (std::size_t s = 0; s < NumShards; ++s)
+    {
+      if (missing_by_shard[s].empty())
+        continue;
+
+      auto& shard = *shards[s];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      for (const auto i : missing_by_shard[s])
+      {
+        const Key& wps = keys[i];
+        std::promise<Value> promise;
+        const auto insertion = shard.insert(wps, promise.get_future().share());
+        futures[i] = insertion.first;
+        if (insertion.second)
+          claims.emplace_back(i, std::move(promise));
+      }
+    }
+
+    std::size_t c = 0;
+    try
+    {
+      for (; c < claims.size(); ++c)
+      {
+        auto& [i, promise] = claims[c];
+        auto& shard = *shards[shard_of(keys[i])];
+        promise.set_value(calculate_miss(shard, keys[i], start, goals[i]));
+      }
+    }
+    catch (...)
+    {
+      // Fail every claim that has not been fulfilled yet and forget those
+      // keys so that later requests can try again
+      for (; c < claims.size(); ++c)
+      {
+        auto& [i, promise] = claims[c];
+        promise.set_exception(std::current_exception());
+
+        auto& shard = *shards[shard_of(keys[i])];
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.erase(keys[i]);
+      }
+      throw;
+    }
+
+    if (!claims.empty())
+      fill_row(start, keys[claims.front().first]);
+
+    for (std::size_t i = 0; i < goals.size(); ++i)
+    {
+      if (futures[i].valid())
+        results[i] = futures[i].get();
+    }
+
+    return results;
+  }
+
+  // If lanes is given, the lanes that the trip went along are added to it
   std::optional<Result> calculate_result(
     const rmf_traffic::agv::Plan::Start& start,
-    const rmf_traffic::agv::Plan::Goal& goal) const
+    const rmf_traffic::agv::Plan::Goal& goal,
+    std::vector<std::size_t>* lanes = nullptr) const
   {
-    const auto plan = planner->plan(start, goal);
+    if (mode == Mode::Approximate)
+      return approximate_result(start, goal, lanes);
+
+    const auto plan = std::atomic_load(&planner)->plan(start, goal);
     if (!plan.success())
       return std::nullopt;
 
+    if (lanes)
+    {
+      for (const auto& wp : plan->get_waypoints())
+      {
+        const auto& approach = wp.approach_lanes();
+        lanes->insert(lanes->end(), approach.begin(), approach.end());
+      }
+    }
+
     // We assume we can always compute a plan
     const auto itinerary_start_time = start.time();
-    double battery_drain = 0.0;
-    for (const auto& itinerary : plan->get_itinerary())
+    const auto& itinerary = plan->get_itinerary();
+    std::vector<double> device_seconds;
+    device_seconds.reserve(itinerary.size());
+    for (const auto& route : itinerary)
     {
-      const auto& trajectory = itinerary.trajectory();
-      const auto& finish_time = *trajectory.finish_time();
-      const rmf_traffic::Duration itinerary_duration =
-        finish_time - itinerary_start_time;
-
-      // Compute battery drain
-      const auto dSOC_motion =
-        motion_sink->compute_change_in_charge(trajectory);
-
-      const auto dSOC_device = ambient_sink->compute_change_in_charge(
-        rmf_traffic::time::to_seconds(itinerary_duration));
-
-      battery_drain += dSOC_motion + dSOC_device;
+      const auto& finish_time = *route.trajectory().finish_time();
+      device_seconds.push_back(
+        rmf_traffic::time::to_seconds(finish_time - itinerary_start_time));
     }
 
+    // Compute battery drain
+    const double battery_drain =
+      drain.motion(itinerary) + drain.ambient(device_seconds);
+
     auto duration = rmf_traffic::Duration(0);
     if (!plan->get_itinerary().empty())
     {
@@ -168,72 +631,1868 @@ public:
     return Result::Implementation::make(duration, battery_drain);
   }
 
-private:
-  std::shared_ptr<const rmf_traffic::agv::Planner> planner;
-  rmf_battery::ConstMotionPowerSinkPtr motion_sink;
-  rmf_battery::ConstDevicePowerSinkPtr ambient_sink;
+  // Search the lanes of the graph as described for Mode::Approximate. The
+  // search runs over lanes rather than waypoints, so the heading that a robot
+  // arrives with is known when the turn onto the next lane gets priced.
+  std::optional<Result> approximate_result(
+    const rmf_traffic::agv::Plan::Start& start,
+    const rmf_traffic::agv::Plan::Goal& goal,
+    std::vector<std::size_t>* lanes) const
+  {
+    const auto current = std::atomic_load(&planner);
+    const auto& graph = current->get_configuration().graph();
+    const auto& traits = current->get_configuration().vehicle_traits();
+    const double nominal_speed = traits.linear().get_nominal_velocity();
+    const double acceleration = traits.linear().get_nominal_acceleration();
+    const double turn_speed = traits.rotational().get_nominal_velocity();
+
+    const auto drive_time = [&](double length, double speed)
+      {
+        // Accelerate to the speed, cruise, and brake, or only accelerate and
+        // brake if the lane is too short to reach the speed
+        const double ramp = speed*speed / acceleration;
+        if (length >= ramp)
+          return length / speed + speed / acceleration;
+
+        return 2.0*std::sqrt(length / acceleration);
+      };
+
+    const auto turn_time = [&](double from, double to)
+      {
+        return std::abs(std::remainder(to - from, 2.0*M_PI)) / turn_speed;
+      };
+
+    const auto event_time = [](const rmf_traffic::agv::Graph::Lane::Node& n)
+      {
+        return n.event() ? rmf_traffic::time::to_seconds(n.event()->duration())
+          : 0.0;
+      };
+
+    const auto location = [&](std::size_t wp) -> Eigen::Vector2d
+      {
+        return graph.get_waypoint(wp).get_location();
+      };
+
+    // The seconds to reach the exit of each lane, and the heading and the lane
+    // that it was reached with
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+    const std::size_t num_lanes = graph.num_lanes();
+    std::vector<double> arrival(num_lanes, inf);
+    std::vector<double> heading(num_lanes, 0.0);
+    std::vector<std::size_t> previous(num_lanes, none);
+
+    using Item = std::pair<double, std::size_t>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    const auto relax = [&](
+      std::size_t lane_index,
+      double time,
+      double from_heading,
+      std::size_t from)
+      {
+        const auto& lane = graph.get_lane(lane_index);
+        const std::size_t entry = lane.entry().waypoint_index();
+        const std::size_t exit = lane.exit().waypoint_index();
+        const Eigen::Vector2d d = location(exit) - location(entry);
+        const double length = d.norm();
+        double speed = nominal_speed;
+        if (const auto limit = lane.properties().speed_limit())
+          speed = std::min(speed, *limit);
+
+        double lane_heading = from_heading;
+        double t = time + event_time(lane.entry()) + event_time(lane.exit());
+        if (length > 1e-6)
+        {
+          lane_heading = std::atan2(d.y(), d.x());
+          t += turn_time(from_heading, lane_heading)
+            + drive_time(length, speed);
+        }
+
+        if (t < arrival[lane_index])
+        {
+          arrival[lane_index] = t;
+          heading[lane_index] = lane_heading;
+          previous[lane_index] = from;
+          queue.push({t, lane_index});
+        }
+      };
+
+    const auto finish_turn = [&](double final_heading)
+      {
+        return goal.orientation() ?
+          turn_time(final_heading, *goal.orientation()) : 0.0;
+      };
+
+    double best = inf;
+    std::size_t best_lane = none;
+    if (start.waypoint() == goal.waypoint())
+      best = finish_turn(start.orientation());
+
+    for (const auto l : graph.lanes_from(start.waypoint()))
+      relax(l, 0.0, start.orientation(), none);
+
+    while (!queue.empty())
+    {
+      const auto [time, l] = queue.top();
+      queue.pop();
+      if (time > arrival[l] || time >= best)
+        continue;
+
+      const std::size_t exit = graph.get_lane(l).exit().waypoint_index();
+      if (exit == goal.waypoint())
+      {
+        const double total = time + finish_turn(heading[l]);
+        if (total < best)
+        {
+          best = total;
+          best_lane = l;
+        }
+      }
 
-  struct PairHash
+      for (const auto next : graph.lanes_from(exit))
+        relax(next, time, heading[l], l);
+    }
+
+    if (best == inf)
+      return std::nullopt;
+
+    // Follow the path back from the goal, and then drive it forward through
+    // a trajectory that stops at each waypoint
+    std::vector<std::size_t> path;
+    for (auto l = best_lane; l != none; l = previous[l])
+      path.push_back(l);
+    std::reverse(path.begin(), path.end());
+    if (lanes)
+      lanes->insert(lanes->end(), path.begin(), path.end());
+
+    rmf_traffic::Trajectory trajectory;
+    const auto insert = [&](double t, std::size_t wp, double yaw)
+      {
+        const Eigen::Vector2d p = location(wp);
+        trajectory.insert(
+          start.time() + rmf_traffic::time::from_seconds(t),
+          Eigen::Vector3d(p.x(), p.y(), yaw),
+          Eigen::Vector3d::Zero());
+      };
+
+    insert(0.0, start.waypoint(), start.orientation());
+    for (const auto l : path)
+    {
+      const auto& lane = graph.get_lane(l);
+      insert(arrival[l], lane.exit().waypoint_index(), heading[l]);
+    }
+
+    const double motion =
+      trajectory.size() > 1 ? drain.motion(trajectory) : 0.0;
+    return Result::Implementation::make(
+      rmf_traffic::time::from_seconds(best),
+      motion + drain.ambient(best));
+  }
+
+  uint64_t fingerprint() const
   {
-    PairHash(std::size_t N)
+    const auto current = std::atomic_load(&planner);
+    const auto& graph = current->get_configuration().graph();
+    const auto& traits = current->get_configuration().vehicle_traits();
+
+    Fingerprint fp;
+    fp.add(uint16_t(1)); // Detects a different byte order
+    fp.add(graph.num_waypoints());
+    for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
     {
-      _shift = std::ceil(std::log2(N));
+      const auto& wp = graph.get_waypoint(i);
+      const Eigen::Vector2d p = wp.get_location();
+      fp.add(wp.get_map_name()).add(p.x()).add(p.y());
     }
 
-    size_t operator()(const std::pair<size_t, size_t>& p) const
+    fp.add(graph.num_lanes());
+    for (std::size_t i = 0; i < graph.num_lanes(); ++i)
     {
-      return p.first + (p.second << _shift);
+      const auto& lane = graph.get_lane(i);
+      fp.add(lane.entry().waypoint_index()).add(lane.exit().waypoint_index());
     }
 
-    std::size_t _shift;
-  };
+    fp.add(traits.linear().get_nominal_velocity())
+    .add(traits.linear().get_nominal_acceleration())
+    .add(traits.rotational().get_nominal_velocity())
+    .add(traits.rotational().get_nominal_acceleration());
 
-  using Key = std::pair<size_t, size_t>;
-  using Value = std::optional<Result>;
-  using Cache = std::unordered_map<Key, std::optional<Result>, PairHash>;
-  mutable Cache cache;
+    fp.add(orientation_bins.load());
+    fp.add(mode.load());
 
-  static Cache make_cache(
-    const std::shared_ptr<const rmf_traffic::agv::Planner>& planner)
+    // The device sink can be probed directly. The motion sink depends on the
+    // trajectories, so load() spot checks some estimates to cover it.
+    fp.add(drain.ambient(3600.0));
+
+    return fp.value();
+  }
+
+  void save(const std::string& filename) const
   {
-    const auto N = planner->get_configuration().graph().num_waypoints();
-    return Cache(N, PairHash(N));
+    std::vector<CacheFileRecord> records;
+    const auto add = [&](const Key& key, const Trip& trip)
+      {
+        CacheFileRecord record{};
+        record.start = static_cast<uint32_t>(key.start);
+        record.goal = static_cast<uint32_t>(key.goal);
+        record.orientation = key.orientation;
+        record.reachable = trip.reachable;
+        record.duration = trip.duration.count();
+        record.change_in_charge = trip.change_in_charge;
+        records.push_back(record);
+      };
+
+    std::shared_ptr<const Table> table;
+    {
+      std::shared_lock<std::shared_mutex> lock(shards.front()->mutex);
+      table = shards.front()->table;
+    }
+
+    if (table)
+    {
+      // The table holds every trip, so there is no need to look further
+      for (std::size_t i = 0; i < table->N; ++i)
+      {
+        for (std::size_t j = 0; j < table->N; ++j)
+          add({i, j, 0}, table->at({i, j, 0}));
+      }
+    }
+    else
+    {
+      for (const auto& shard : shards)
+      {
+        std::shared_lock<std::shared_mutex> lock(shard->mutex);
+        for (const auto& [key, entry] : shard->cache)
+        {
+          const auto& future = entry.future;
+          // Skip the entries that are still being calculated
+          if (future.wait_for(std::chrono::seconds(0))
+            != std::future_status::ready)
+            continue;
+
+          try
+          {
+            const auto value = future.get();
+            Trip trip;
+            trip.reachable = value.has_value();
+            if (value.has_value())
+            {
+              trip.duration = value->duration();
+              trip.change_in_charge = value->change_in_charge();
+            }
+
+            add(key, trip);
+          }
+          catch (...)
+          {
+            // The calculation of this entry failed, so there is nothing to
+            // save for it
+          }
+        }
+      }
+    }
+
+    CacheFileHeader header{};
+    std::memcpy(header.magic, CacheFileMagic, sizeof(header.magic));
+    header.fingerprint = fingerprint();
+    header.num_waypoints = num_waypoints();
+    header.count = records.size();
+
+    const std::string temp_filename = filename + ".tmp";
+    std::ofstream file(temp_filename, std::ios::out | std::ios::binary);
+    if (!file)
+    {
+      throw std::runtime_error(
+              "[TravelEstimator::save] Could not open file " + temp_filename
+              + " for writing.");
+    }
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(
+      reinterpret_cast<const char*>(records.data()),
+      records.size() * sizeof(CacheFileRecord));
+    file.close();
+    if (!file)
+    {
+      throw std::runtime_error(
+              "[TravelEstimator::save] Failed to write file " + temp_filename);
+    }
+
+    std::filesystem::rename(temp_filename, filename);
   }
 
-  mutable std::mutex mutex;
-};
+  bool load(const std::string& filename)
+  {
+    std::ifstream file(filename, std::ios::in | std::ios::binary);
+    if (!file)
+      return false;
 
-//==============================================================================
-TravelEstimator::TravelEstimator(const Parameters& parameters)
-: _pimpl(rmf_utils::make_unique_impl<Implementation>(parameters))
-{
-  // Do nothing
-}
+    CacheFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+      return false;
 
-//==============================================================================
-rmf_traffic::Duration TravelEstimator::Result::duration() const
-{
-  return _pimpl->duration;
-}
+    const auto N = num_waypoints();
+    if (std::memcmp(header.magic, CacheFileMagic, sizeof(header.magic)) != 0
+      || header.fingerprint != fingerprint()
+      || header.num_waypoints != N
+      || header.count > N*N)
+      return false;
 
-//==============================================================================
-double TravelEstimator::Result::change_in_charge() const
-{
-  return _pimpl->change_in_charge;
-}
+    std::vector<CacheFileRecord> records(header.count);
+    if (!file.read(
+        reinterpret_cast<char*>(records.data()),
+        records.size() * sizeof(CacheFileRecord)))
+      return false;
 
-//==============================================================================
-TravelEstimator::Result::Result()
-{
-  // Do nothing
-}
+    const auto bins = orientation_bins.load();
+    const uint64_t max_orientation = bins == 0 ? 0 : bins*(bins + 1);
+    for (const auto& r : records)
+    {
+      if (r.start >= N || r.goal >= N || r.orientation > max_orientation)
+        return false;
+    }
 
-//==============================================================================
-auto TravelEstimator::estimate(
-  const rmf_traffic::agv::Plan::Start& start,
-  const rmf_traffic::agv::Plan::Goal& goal) const -> std::optional<Result>
-{
-  return _pimpl->estimate(start, goal);
+    const auto to_value = [](const CacheFileRecord& r) -> Value
+      {
+        if (!r.reachable)
+          return std::nullopt;
+
+        return Result::Implementation::make(
+          rmf_traffic::Duration(r.duration), r.change_in_charge);
+      };
+
+    // Plan a few of the trips again to catch changes that the fingerprint
+    // cannot see, e.g. in the motion power sink
+    const std::size_t num_checks = std::min<std::size_t>(3, records.size());
+    for (std::size_t i = 0; i < num_checks; ++i)
+    {
+      const auto& r = records[i * records.size() / num_checks];
+      const auto actual = calculate_trip(
+        {r.start, r.goal, r.orientation},
+        rmf_traffic::agv::Plan::Start(rmf_traffic::Time(), r.start, 0.0),
+        rmf_traffic::agv::Plan::Goal(r.goal));
+      const auto saved = to_value(r);
+      if (actual.has_value() != saved.has_value())
+        return false;
+
+      if (actual.has_value()
+        && (actual->duration() != saved->duration()
+        || std::abs(actual->change_in_charge() - saved->change_in_charge())
+        > 1e-9))
+        return false;
+    }
+
+    for (const auto& r : records)
+    {
+      const Key key{r.start, r.goal, r.orientation};
+      std::promise<Value> promise;
+      promise.set_value(to_value(r));
+
+      auto& shard = *shards[shard_of(key)];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      shard.insert(key, promise.get_future().share());
+      if (!r.reachable)
+        shard.record(key, {}, false, std::chrono::steady_clock::now());
+    }
+
+    return true;
+  }
+
+  void set_orientation_bins(std::size_t bins)
+  {
+    orientation_bins = bins;
+    const auto N = num_waypoints();
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->clear(N);
+    }
+  }
+
+  std::size_t get_orientation_bins() const
+  {
+    return orientation_bins;
+  }
+
+  bool serves(const Parameters& parameters) const
+  {
+    return std::atomic_load(&planner) == parameters.planner()
+      && drain.motion_sink() == parameters.motion_sink()
+      && drain.ambient_sink() == parameters.ambient_sink();
+  }
+
+  void set_mode(Mode new_mode)
+  {
+    mode = new_mode;
+    const auto N = num_waypoints();
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->clear(N);
+    }
+
+    forget_floors();
+  }
+
+  Mode get_mode() const
+  {
+    return mode;
+  }
+
+  void set_capacity(std::size_t max_entries)
+  {
+    capacity = max_entries;
+    const std::size_t per_shard = max_entries == 0 ?
+      std::numeric_limits<std::size_t>::max() :
+      (max_entries + NumShards - 1) / NumShards;
+
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->set_capacity(per_shard);
+    }
+  }
+
+  std::size_t get_capacity() const
+  {
+    return capacity;
+  }
+
+  TraceSinkPtr trace_sink = nullptr;
+  ExecutorPtr executor = nullptr;
+  std::vector<std::size_t> row_goals;
+
+  void reset_statistics() const
+  {
+    for (auto& shard : shards)
+    {
+      shard->hits = 0;
+      shard->misses = 0;
+      shard->failed_plans = 0;
+      shard->evictions = 0;
+      shard->total_miss_latency = 0;
+      for (auto& n : shard->latencies)
+        n = 0;
+    }
+  }
+
+  Statistics statistics() const
+  {
+    Statistics output;
+    auto& stats = Statistics::Implementation::get(output);
+    for (const auto& shard : shards)
+    {
+      stats.hits += shard->hits.load(std::memory_order_relaxed);
+      stats.misses += shard->misses.load(std::memory_order_relaxed);
+      stats.failed_plans +=
+        shard->failed_plans.load(std::memory_order_relaxed);
+      stats.evictions += shard->evictions.load(std::memory_order_relaxed);
+      stats.total_miss_latency += rmf_traffic::Duration(
+        shard->total_miss_latency.load(std::memory_order_relaxed));
+      for (std::size_t i = 0; i < LatencyBuckets; ++i)
+      {
+        stats.latencies[i] +=
+          shard->latencies[i].load(std::memory_order_relaxed);
+      }
+
+      std::shared_lock<std::shared_mutex> lock(shard->mutex);
+      stats.entries += shard->cache.size();
+    }
+
+    return output;
+  }
+
+  void precompute(std::size_t num_threads)
+  {
+    const auto N = num_waypoints();
+    auto trips = std::make_shared<Table>(N);
+    std::vector<std::size_t> rows(N);
+    for (std::size_t i = 0; i < N; ++i)
+      rows[i] = i;
+
+    fill_rows(*trips, rows, num_threads);
+    publish(std::move(trips));
+  }
+
+  bool precompute_shared(const std::string& filename, std::size_t num_threads)
+  {
+    static_assert(std::is_trivially_copyable_v<Trip>);
+    const FileLock lock(filename + ".lock");
+    if (!lock.locked())
+    {
+      precompute(num_threads);
+      return false;
+    }
+
+    const auto N = num_waypoints();
+    const auto fp = fingerprint();
+    const std::size_t size = sizeof(SharedTableHeader) + N*N*sizeof(Trip);
+    const auto trips_of = [](const MappedFile& file)
+      {
+        return reinterpret_cast<Trip*>(
+          static_cast<char*>(file.data()) + sizeof(SharedTableHeader));
+      };
+
+    if (const auto file = MappedFile::open(filename))
+    {
+      const auto& header =
+        *static_cast<const SharedTableHeader*>(file->data());
+      if (file->size() == size
+        && std::memcmp(header.magic, SharedTableMagic, sizeof(header.magic))
+        == 0
+        && header.fingerprint == fp
+        && header.num_waypoints == N
+        && header.complete == 1)
+      {
+        auto trips = std::make_shared<Table>(N, trips_of(*file), file);
+        if (spot_check(*trips))
+        {
+          publish(std::move(trips));
+          return true;
+        }
+      }
+    }
+
+    // Write the table to a new file and then rename it, so that processes
+    // which have mapped an outdated table keep reading a consistent one
+    const std::string temp_filename = filename + ".tmp";
+    const auto file = MappedFile::create(temp_filename, size);
+    if (!file)
+    {
+      precompute(num_threads);
+      return false;
+    }
+
+    auto trips = std::make_shared<Table>(N, trips_of(*file), file);
+    std::vector<std::size_t> rows(N);
+    for (std::size_t i = 0; i < N; ++i)
+      rows[i] = i;
+
+    fill_rows(*trips, rows, num_threads);
+
+    auto& header = *static_cast<SharedTableHeader*>(file->data());
+    std::memcpy(header.magic, SharedTableMagic, sizeof(header.magic));
+    header.fingerprint = fp;
+    header.num_waypoints = N;
+    header.complete = 1;
+
+    std::error_code ec;
+    std::filesystem::rename(temp_filename, filename, ec);
+    publish(std::move(trips));
+    return !ec;
+  }
+
+  void update_planner(
+    std::shared_ptr<const rmf_traffic::agv::Planner> new_planner,
+    const std::vector<std::size_t>& affected_waypoints,
+    std::size_t num_threads)
+  {
+    const auto old_N = num_waypoints();
+    std::atomic_store(&planner, std::move(new_planner));
+    const auto N = num_waypoints();
+    forget_floors();
+
+    std::shared_ptr<const Table> old_table;
+    {
+      std::shared_lock<std::shared_mutex> lock(shards.front()->mutex);
+      old_table = shards.front()->table;
+    }
+
+    if (N != old_N)
+    {
+      // The keys of the old estimates do not refer to the same waypoints
+      // anymore, so nothing can be kept.
+      for (auto& shard : shards)
+      {
+        std::unique_lock<std::shared_mutex> lock(shard->mutex);
+        shard->clear(N);
+        shard->table = nullptr;
+      }
+
+      if (old_table)
+        precompute(num_threads);
+
+      return;
+    }
+
+    const std::unordered_set<std::size_t> affected(
+      affected_waypoints.begin(), affected_waypoints.end());
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->erase_if([&](const Key& key, const Entry&)
+        {
+          return affected.count(key.start) > 0;
+        });
+    }
+
+    if (old_table)
+    {
+      auto trips = std::make_shared<Table>(*old_table);
+      fill_rows(*trips, affected_waypoints, num_threads);
+      publish(std::move(trips));
+    }
+  }
+
+  void forget(
+    const std::vector<std::size_t>& waypoints,
+    const std::vector<std::size_t>& lanes)
+  {
+    const std::unordered_set<std::size_t> wps(
+      waypoints.begin(), waypoints.end());
+    const std::unordered_set<std::size_t> closed(lanes.begin(), lanes.end());
+    forget_floors();
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->erase_if([&](const Key& key, const Entry& entry)
+        {
+          if (entry.failed_at != 0 || wps.count(key.start)
+            || wps.count(key.goal))
+            return true;
+
+          for (const auto lane : entry.lanes)
+          {
+            if (closed.count(lane))
+              return true;
+          }
+
+          return false;
+        });
+    }
+  }
+
+  void set_failed_plan_lifetime(
+    std::optional<rmf_traffic::Duration> lifetime)
+  {
+    failed_plan_lifetime = lifetime;
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->failed_lifetime = lifetime.has_value() ?
+        std::chrono::duration_cast<std::chrono::nanoseconds>(*lifetime)
+        .count() : -1;
+    }
+  }
+
+  std::optional<rmf_traffic::Duration> failed_plan_lifetime;
+
+  // Scale an estimate by the congestion at the time that its trip starts and
+  // by the calibration of its trip
+  std::optional<Result> adjusted(
+    std::optional<Result> result,
+    const rmf_traffic::agv::Plan::Start& start,
+    const rmf_traffic::agv::Plan::Goal& goal) const
+  {
+    if (!result.has_value() || (!congestion.has_value() && !calibration))
+      return result;
+
+    double multiplier = 1.0;
+    if (congestion.has_value())
+    {
+      multiplier *= congestion->multiplier(
+        start.waypoint(), goal.waypoint(), start.time());
+    }
+
+    if (calibration)
+    {
+      multiplier *= calibration->factor(
+        Calibration::travel_type(), start.waypoint(), goal.waypoint());
+    }
+
+    if (multiplier == 1.0)
+      return result;
+
+    return Result::Implementation::make(
+      std::chrono::duration_cast<rmf_traffic::Duration>(
+        result->duration() * multiplier),
+      result->change_in_charge());
+  }
+
+  std::optional<Congestion> congestion;
+
+  ConstCalibrationPtr calibration;
+
+  std::atomic_bool split_floors = false;
+
+  // Bumped by every change that may change the estimates
+  std::atomic<uint64_t> generation = 0;
+
+  // Forget the floors of split_by_floor() so that they get built again from
+  // the current planner and estimates
+  void forget_floors()
+  {
+    std::lock_guard<std::mutex> lock(floors_mutex);
+    std::atomic_store(&floors, std::shared_ptr<const Floors>());
+  }
+
+private:
+  // The number of prefetch jobs that have not finished yet
+  std::mutex prefetch_mutex;
+  std::condition_variable prefetched;
+  std::size_t prefetching = 0;
+  std::atomic_bool stopping = false;
+
+  std::shared_ptr<const rmf_traffic::agv::Planner> planner;
+  std::atomic_size_t capacity = 0;
+  std::atomic_size_t orientation_bins = 0;
+  std::atomic<Mode> mode = Mode::Exact;
+  BatteryDrain drain;
+
+  // The orientation is always 0 unless orientation_bins is set. Then it is 1
+  // plus the start orientation bin times (orientation_bins + 1), plus 0 if
+  // the goal has no orientation or 1 plus the goal orientation bin.
+  struct Key
+  {
+    std::size_t start;
+    std::size_t goal;
+    std::size_t orientation;
+
+    bool operator==(const Key& other) const
+    {
+      return start == other.start && goal == other.goal
+        && orientation == other.orientation;
+    }
+  };
+
+  struct KeyHash
+  {
+    KeyHash(std::size_t N)
+    {
+      _shift = std::ceil(std::log2(N));
+    }
+
+    size_t operator()(const Key& key) const
+    {
+      return (key.start + (key.goal << _shift))
+        ^ (key.orientation * 0x9E3779B97F4A7C15ull);
+    }
+
+    std::size_t _shift;
+  };
+  using Value = std::optional<Result>;
+
+  // A cached estimate. The referenced flag is set by lookups, which only hold
+  // a shared lock, so it needs to be atomic.
+  struct Entry
+  {
+    Entry(std::shared_future<Value> future_, std::size_t slot_)
+    : future(std::move(future_)),
+      slot(slot_)
+    {
+      // Do nothing
+    }
+
+    std::shared_future<Value> future;
+
+    // Where the key of this entry sits in the ring of its shard
+    std::size_t slot;
+
+    mutable std::atomic_bool referenced = false;
+
+    // The lanes that the trip went along, once it has been planned
+    std::vector<std::size_t> lanes;
+
+    // When the trip was found to be unreachable, in nanoseconds of the steady
+    // clock, or 0 if it was reachable or has not been planned yet
+    int64_t failed_at = 0;
+  };
+
+  using Cache = std::unordered_map<Key, Entry, KeyHash>;
+
+  // A dense table of the trips between every pair of waypoints
+  struct Trip
+  {
+    bool reachable = false;
+    rmf_traffic::Duration duration = rmf_traffic::Duration(0);
+    double change_in_charge = 0.0;
+  };
+
+  // The trips are either owned by the table or stored in a file that is
+  // mapped into memory, which the table keeps mapped. Copies always own their
+  // trips.
+  struct Table
+  {
+    Table(std::size_t N_)
+    : N(N_),
+      owned(N_*N_),
+      trips(owned.data())
+    {
+      // Do nothing
+    }
+
+    Table(std::size_t N_, Trip* trips_, std::shared_ptr<MappedFile> file_)
+    : N(N_),
+      trips(trips_),
+      file(std::move(file_))
+    {
+      // Do nothing
+    }
+
+    Table(const Table& other)
+    : N(other.N),
+      owned(other.trips, other.trips + other.N*other.N),
+      trips(owned.data())
+    {
+      // Do nothing
+    }
+
+    Trip& at(const Key& key)
+    {
+      return trips[index_of(key)];
+    }
+
+    const Trip& at(const Key& key) const
+    {
+      return trips[index_of(key)];
+    }
+
+    std::size_t index_of(const Key& key) const
+    {
+      if (key.start >= N || key.goal >= N)
+        throw std::out_of_range("[TravelEstimator] Waypoint out of range");
+
+      return key.start*N + key.goal;
+    }
+
+    std::size_t N;
+    std::vector<Trip> owned;
+    Trip* trips;
+    std::shared_ptr<MappedFile> file;
+  };
+
+  // The floors of the navigation graph and the portals between them, which
+  // are built on the first trip between floors once split_floors is set
+  struct Floors
+  {
+    // The floor of each waypoint
+    std::vector<std::size_t> floor_of;
+
+    // The waypoint of each portal
+    std::vector<std::size_t> portals;
+
+    // The portals of each floor
+    std::vector<std::vector<std::size_t>> portals_on_floor;
+
+    // The quickest trip from each portal to each portal, one row per portal
+    std::vector<Trip> between;
+
+    bool crosses(std::size_t start, std::size_t goal) const
+    {
+      return start < floor_of.size() && goal < floor_of.size()
+        && floor_of[start] != floor_of[goal];
+    }
+  };
+
+  // Guards the building of floors, which is published with atomic stores so
+  // that lookups need no lock
+  mutable std::mutex floors_mutex;
+  mutable std::shared_ptr<const Floors> floors;
+
+  // The cache is split into shards that are locked independently, so callers
+  // on different threads rarely wait for each other. Lookups only need a
+  // shared lock, which lets any number of them proceed at once.
+  //
+  // When the cache has a capacity, each shard evicts its entries with the
+  // CLOCK policy: a hand sweeps over the ring of keys, clearing the referenced
+  // flag of each entry it passes and evicting the first entry whose flag was
+  // already clear. Entries that are still being calculated are never evicted.
+  //
+  // Every shard refers to the same table. Keeping a reference in each shard
+  // lets a lookup find the table under the shard lock that it takes anyway,
+  // instead of contending on one shared reference.
+  struct Shard
+  {
+    Shard(std::size_t N)
+    : cache(N / NumShards + 1, KeyHash(N))
+    {
+      // Do nothing
+    }
+
+    // Find an entry and count the lookup. Requires at least a shared lock.
+    const Entry* find(const Key& key)
+    {
+      const auto it = cache.find(key);
+      if (it == cache.end() || expired(it->second))
+        return nullptr;
+
+      it->second.referenced.store(true, std::memory_order_relaxed);
+      hits.fetch_add(1, std::memory_order_relaxed);
+      return &it->second;
+    }
+
+    // Insert a future for a key unless the key is already present. Returns the
+    // future for the key and whether it was inserted. Requires a unique lock.
+    std::pair<std::shared_future<Value>, bool> insert(
+      const Key& key,
+      std::shared_future<Value> future)
+    {
+      auto it = cache.find(key);
+      if (it != cache.end() && expired(it->second))
+      {
+        // Plan the unreachable trip again
+        remove_slot(it->second.slot);
+        cache.erase(it);
+        it = cache.end();
+      }
+
+      if (it != cache.end())
+      {
+        it->second.referenced.store(true, std::memory_order_relaxed);
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return {it->second.future, false};
+      }
+
+      misses.fetch_add(1, std::memory_order_relaxed);
+      while (cache.size() >= capacity && evict_one())
+      {
+        // Keep evicting
+      }
+
+      cache.try_emplace(key, future, ring.size());
+      ring.push_back(key);
+      return {std::move(future), true};
+    }
+
+    // Remember what the planning of a key found, unless the key has been
+    // forgotten in the meantime. Requires a unique lock.
+    void record(
+      const Key& key,
+      std::vector<std::size_t> trip_lanes,
+      bool reachable,
+      std::chrono::steady_clock::time_point finish)
+    {
+      const auto it = cache.find(key);
+      if (it == cache.end())
+        return;
+
+      it->second.lanes = std::move(trip_lanes);
+      if (!reachable)
+      {
+        // Never 0, so that it cannot be mistaken for a reachable trip
+        it->second.failed_at =
+          std::max<int64_t>(1, finish.time_since_epoch().count());
+      }
+    }
+
+    // Whether an entry is an unreachable trip that has outlived
+    // failed_lifetime. Requires at least a shared lock.
+    bool expired(const Entry& entry) const
+    {
+      if (entry.failed_at == 0 || failed_lifetime < 0)
+        return false;
+
+      const auto now =
+        std::chrono::steady_clock::now().time_since_epoch().count();
+      return now - entry.failed_at > failed_lifetime;
+    }
+
+    // Forget every entry that matches the predicate. Requires a unique lock.
+    template<typename Predicate>
+    void erase_if(const Predicate& predicate)
+    {
+      std::vector<Key> forget;
+      for (const auto& [key, entry] : cache)
+      {
+        if (predicate(key, entry))
+          forget.push_back(key);
+      }
+
+      for (const auto& key : forget)
+        erase(key);
+    }
+
+    // Requires a unique lock
+    void erase(const Key& key)
+    {
+      const auto it = cache.find(key);
+      if (it == cache.end())
+        return;
+
+      remove_slot(it->second.slot);
+      cache.erase(it);
+    }
+
+    // Requires a unique lock
+    void clear(std::size_t N)
+    {
+      cache = Cache(N / NumShards + 1, KeyHash(N));
+      ring.clear();
+      hand = 0;
+    }
+
+    // Requires a unique lock
+    void set_capacity(std::size_t new_capacity)
+    {
+      capacity = new_capacity;
+      while (cache.size() > capacity && evict_one())
+      {
+        // Keep evicting
+      }
+    }
+
+    std::shared_mutex mutex;
+    Cache cache;
+    std::shared_ptr<const Table> table;
+
+    // The keys of the cache in the order that the CLOCK hand visits them
+    std::vector<Key> ring;
+    std::size_t hand = 0;
+    std::size_t capacity = std::numeric_limits<std::size_t>::max();
+
+    // In nanoseconds, or negative if unreachable trips are kept forever
+    int64_t failed_lifetime = -1;
+
+    std::atomic_size_t hits = 0;
+    std::atomic_size_t misses = 0;
+    std::atomic_size_t failed_plans = 0;
+    std::atomic_size_t evictions = 0;
+
+    // In nanoseconds
+    std::atomic<int64_t> total_miss_latency = 0;
+    std::array<std::atomic_size_t, LatencyBuckets> latencies = {};
+
+  private:
+
+    bool evict_one()
+    {
+      // Two sweeps are enough to clear every referenced flag and then reach
+      // an entry whose flag is clear, unless every entry is still pending.
+      for (std::size_t step = 0; step < 2*ring.size(); ++step)
+      {
+        if (hand >= ring.size())
+          hand = 0;
+
+        const auto it = cache.find(ring[hand]);
+        auto& entry = it->second;
+        if (entry.referenced.exchange(false, std::memory_order_relaxed)
+          || entry.future.wait_for(std::chrono::seconds(0))
+          != std::future_status::ready)
+        {
+          ++hand;
+          continue;
+        }
+
+        remove_slot(hand);
+        cache.erase(it);
+        evictions.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+
+      return false;
+    }
+
+    // Take a key out of the ring by moving the last key into its slot
+    void remove_slot(std::size_t slot)
+    {
+      if (slot + 1 != ring.size())
+      {
+        ring[slot] = ring.back();
+        cache.at(ring[slot]).slot = slot;
+      }
+
+      ring.pop_back();
+    }
+  };
+
+  static constexpr std::size_t NumShards = 32;
+  using Shards = std::vector<std::unique_ptr<Shard>>;
+  Shards shards;
+
+  static std::size_t shard_of(const Key& key)
+  {
+    // Multiplying by an odd constant spreads neighboring start waypoints
+    // across all the shards.
+    return (key.start * 2654435761u + key.goal + key.orientation * 40503u)
+      % NumShards;
+  }
+
+  static Shards make_shards(
+    const std::shared_ptr<const rmf_traffic::agv::Planner>& planner)
+  {
+    const auto N = planner->get_configuration().graph().num_waypoints();
+    Shards shards;
+    shards.reserve(NumShards);
+    for (std::size_t i = 0; i < NumShards; ++i)
+      shards.push_back(std::make_unique<Shard>(N));
+
+    return shards;
+  }
+
+  // Plan a trip that was missing from the cache and count how long it took
+  std::optional<Result> calculate_miss(
+    Shard& shard,
+    const Key& key,
+    const rmf_traffic::agv::Plan::Start& start,
+    const rmf_traffic::agv::Plan::Goal& goal) const
+  {
+    const TraceSpan span(trace_sink.get(), "TravelEstimator::miss");
+    const AllocationCounter::Scope scope(
+      AllocationCounter::Subsystem::Estimator);
+    const auto begin = std::chrono::steady_clock::now();
+    std::vector<std::size_t> lanes;
+    auto result = calculate_trip(key, start, goal, &lanes);
+    const auto finish = std::chrono::steady_clock::now();
+    const auto latency =
+      std::chrono::duration_cast<rmf_traffic::Duration>(finish - begin);
+
+    if (!result.has_value())
+      shard.failed_plans.fetch_add(1, std::memory_order_relaxed);
+
+    {
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      shard.record(key, std::move(lanes), result.has_value(), finish);
+    }
+
+    shard.total_miss_latency.fetch_add(
+      latency.count(), std::memory_order_relaxed);
+    shard.latencies[latency_bucket(latency)].fetch_add(
+      1, std::memory_order_relaxed);
+
+    return result;
+  }
+
+  // Plan the trips from the start of a miss to each of the row goals that are
+  // not cached yet. The keys are claimed in the same way as estimate() does,
+  // so no trip gets planned twice. A trip that fails to plan is forgotten
+  // again, so that it can be retried the next time that it is asked for.
+  void fill_row(
+    const rmf_traffic::agv::Plan::Start& start,
+    const Key& missed) const
+  {
+    if (row_goals.empty() || missed.orientation != 0)
+      return;
+
+    // The floors are not built from here, since fill_row() may be called
+    // while they are being built
+    const auto current_floors =
+      split_floors ? std::atomic_load(&floors) : nullptr;
+    const auto N = num_waypoints();
+    std::vector<std::pair<Key, std::promise<Value>>> claims;
+    for (const auto goal : row_goals)
+    {
+      const Key key{start.waypoint(), goal, 0};
+      if (goal >= N || goal == missed.goal)
+        continue;
+
+      if (current_floors && current_floors->crosses(start.waypoint(), goal))
+        continue;
+
+      auto& shard = *shards[shard_of(key)];
+      std::unique_lock<std::shared_mutex> lock(shard.mutex);
+      if (shard.table || shard.cache.count(key))
+        continue;
+
+      std::promise<Value> promise;
+      shard.insert(key, promise.get_future().share());
+      claims.emplace_back(key, std::move(promise));
+    }
+
+    const auto& pool = executor ? executor : Executor::default_executor();
+    pool->parallel_for(
+      claims.size(), [&](std::size_t c)
+      {
+        auto& [key, promise] = claims[c];
+        auto& shard = *shards[shard_of(key)];
+        try
+        {
+          promise.set_value(calculate_miss(
+            shard, key, start, rmf_traffic::agv::Plan::Goal(key.goal)));
+        }
+        catch (...)
+        {
+          promise.set_exception(std::current_exception());
+          std::unique_lock<std::shared_mutex> lock(shard.mutex);
+          shard.erase(key);
+        }
+      });
+  }
+
+  std::shared_ptr<const Floors> get_floors() const
+  {
+    if (auto current = std::atomic_load(&floors))
+      return current;
+
+    std::lock_guard<std::mutex> lock(floors_mutex);
+    auto current = std::atomic_load(&floors);
+    if (!current)
+    {
+      current = build_floors();
+      std::atomic_store(&floors, current);
+    }
+
+    return current;
+  }
+
+  // Group the waypoints by their maps, find the portals at either end of the
+  // lanes between maps, and find the quickest trip between each pair of
+  // portals with Dijkstra's algorithm over the trips along the lanes between
+  // floors and the trips between the portals of each floor. Every trip is
+  // estimated with by_floor set to false, so this never waits on itself.
+  std::shared_ptr<const Floors> build_floors() const
+  {
+    const auto current = std::atomic_load(&planner);
+    const auto& graph = current->get_configuration().graph();
+    auto output = std::make_shared<Floors>();
+
+    std::unordered_map<std::string, std::size_t> floor_ids;
+    output->floor_of.reserve(graph.num_waypoints());
+    for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+    {
+      const auto insertion = floor_ids.insert(
+        {graph.get_waypoint(i).get_map_name(), floor_ids.size()});
+      output->floor_of.push_back(insertion.first->second);
+    }
+    output->portals_on_floor.resize(floor_ids.size());
+
+    std::unordered_map<std::size_t, std::size_t> portal_of;
+    const auto add_portal = [&](std::size_t wp)
+      {
+        const auto insertion = portal_of.insert({wp, output->portals.size()});
+        if (insertion.second)
+        {
+          output->portals_on_floor[output->floor_of[wp]].push_back(
+            output->portals.size());
+          output->portals.push_back(wp);
+        }
+
+        return insertion.first->second;
+      };
+
+    std::vector<std::pair<std::size_t, std::size_t>> crossings;
+    for (std::size_t l = 0; l < graph.num_lanes(); ++l)
+    {
+      const auto& lane = graph.get_lane(l);
+      const std::size_t entry = lane.entry().waypoint_index();
+      const std::size_t exit = lane.exit().waypoint_index();
+      if (output->floor_of[entry] != output->floor_of[exit])
+        crossings.emplace_back(add_portal(entry), add_portal(exit));
+    }
+
+    struct Edge
+    {
+      std::size_t to;
+      Result trip;
+    };
+
+    const std::size_t P = output->portals.size();
+    std::vector<std::vector<Edge>> edges(P);
+    const auto add_edge = [&](std::size_t from, std::size_t to)
+      {
+        auto trip = estimate(
+          rmf_traffic::agv::Plan::Start(
+            rmf_traffic::Time(), output->portals[from], 0.0),
+          rmf_traffic::agv::Plan::Goal(output->portals[to]), false);
+
+        if (trip.has_value())
+          edges[from].push_back({to, std::move(*trip)});
+      };
+
+    for (const auto& [from, to] : crossings)
+      add_edge(from, to);
+
+    for (const auto& on_floor : output->portals_on_floor)
+    {
+      for (const auto from : on_floor)
+      {
+        for (const auto to : on_floor)
+        {
+          if (from != to)
+            add_edge(from, to);
+        }
+      }
+    }
+
+    using QueueEntry = std::pair<rmf_traffic::Duration, std::size_t>;
+    output->between.resize(P*P);
+    for (std::size_t s = 0; s < P; ++s)
+    {
+      Trip* row = output->between.data() + s*P;
+      row[s].reachable = true;
+
+      std::vector<bool> done(P, false);
+      std::priority_queue<QueueEntry, std::vector<QueueEntry>,
+        std::greater<QueueEntry>> queue;
+      queue.push({rmf_traffic::Duration(0), s});
+      while (!queue.empty())
+      {
+        const auto [duration, p] = queue.top();
+        queue.pop();
+        if (done[p])
+          continue;
+
+        done[p] = true;
+        for (const auto& edge : edges[p])
+        {
+          const auto arrival = duration + edge.trip.duration();
+          auto& next = row[edge.to];
+          if (next.reachable && next.duration <= arrival)
+            continue;
+
+          next.reachable = true;
+          next.duration = arrival;
+          next.change_in_charge =
+            row[p].change_in_charge + edge.trip.change_in_charge();
+          queue.push({arrival, edge.to});
+        }
+      }
+    }
+
+    return output;
+  }
+
+  // Estimate a trip between floors as the quickest combination of a trip to a
+  // portal of its start floor, the quickest trip between portals, and a trip
+  // from a portal of its goal floor. Robots leave each portal facing along
+  // orientation zero, like the trips of prefetch().
+  std::optional<Result> estimate_by_floor(
+    const Floors& current,
+    const rmf_traffic::agv::Plan::Start& start,
+    const rmf_traffic::agv::Plan::Goal& goal) const
+  {
+    const auto& departures =
+      current.portals_on_floor[current.floor_of[start.waypoint()]];
+    const auto& arrivals =
+      current.portals_on_floor[current.floor_of[goal.waypoint()]];
+    const std::size_t P = current.portals.size();
+
+    std::vector<std::optional<Result>> to_portal;
+    to_portal.reserve(departures.size());
+    for (const auto p : departures)
+    {
+      to_portal.push_back(
+        estimate(
+          start,
+          rmf_traffic::agv::Plan::Goal(current.portals[p]), false));
+    }
+
+    Trip best;
+    for (const auto q : arrivals)
+    {
+      const auto from_portal = estimate(
+        rmf_traffic::agv::Plan::Start(start.time(), current.portals[q], 0.0),
+        goal, false);
+      if (!from_portal.has_value())
+        continue;
+
+      for (std::size_t i = 0; i < departures.size(); ++i)
+      {
+        const auto& middle = current.between[departures[i]*P + q];
+        if (!to_portal[i].has_value() || !middle.reachable)
+          continue;
+
+        const auto duration = to_portal[i]->duration() + middle.duration
+          + from_portal->duration();
+        if (best.reachable && best.duration <= duration)
+          continue;
+
+        best.reachable = true;
+        best.duration = duration;
+        best.change_in_charge = to_portal[i]->change_in_charge()
+          + middle.change_in_charge + from_portal->change_in_charge();
+      }
+    }
+
+    if (!best.reachable)
+      return std::nullopt;
+
+    return Result::Implementation::make(best.duration, best.change_in_charge);
+  }
+
+  Key key_of(
+    const rmf_traffic::agv::Plan::Start& start,
+    const rmf_traffic::agv::Plan::Goal& goal) const
+  {
+    const std::size_t bins = orientation_bins;
+    if (bins == 0)
+      return {start.waypoint(), goal.waypoint(), 0};
+
+    const std::size_t goal_code =
+      goal.orientation() ? 1 + bin_of(*goal.orientation(), bins) : 0;
+
+    return {
+      start.waypoint(),
+      goal.waypoint(),
+      1 + bin_of(start.orientation(), bins)*(bins + 1) + goal_code
+    };
+  }
+
+  // Round an orientation to the nearest of the bins, which are centered on
+  // multiples of 2*pi/bins
+  static std::size_t bin_of(double orientation, std::size_t bins)
+  {
+    const double turn = 2.0*M_PI;
+    double a = std::fmod(orientation, turn);
+    if (a < 0.0)
+      a += turn;
+
+    return static_cast<std::size_t>(std::round(a / turn * bins)) % bins;
+  }
+
+  // When orientations are distinguished, every trip of a key is planned from
+  // the centers of its bins, so the estimate does not depend on which caller
+  // happened to ask for the key first.
+  std::optional<Result> calculate_trip(
+    const Key& key,
+    rmf_traffic::agv::Plan::Start start,
+    rmf_traffic::agv::Plan::Goal goal,
+    std::vector<std::size_t>* lanes = nullptr) const
+  {
+    const std::size_t bins = orientation_bins;
+    if (key.orientation == 0 || bins == 0)
+      return calculate_result(start, goal, lanes);
+
+    const double step = 2.0*M_PI / bins;
+    const std::size_t code = key.orientation - 1;
+    start.orientation(step * (code / (bins + 1)));
+
+    const std::size_t goal_code = code % (bins + 1);
+    if (goal_code == 0)
+      goal = rmf_traffic::agv::Plan::Goal(key.goal);
+    else
+      goal = rmf_traffic::agv::Plan::Goal(key.goal, step * (goal_code - 1));
+
+    return calculate_result(start, goal, lanes);
+  }
+
+  std::size_t num_waypoints() const
+  {
+    return std::atomic_load(&planner)->get_configuration()
+      .graph().num_waypoints();
+  }
+
+  void publish(std::shared_ptr<const Table> trips)
+  {
+    for (auto& shard : shards)
+    {
+      std::unique_lock<std::shared_mutex> lock(shard->mutex);
+      shard->table = trips;
+    }
+  }
+
+  // Plan a few of the trips of a table again to catch changes that the
+  // fingerprint cannot see, e.g. in the motion power sink
+  bool spot_check(const Table& trips) const
+  {
+    const std::size_t count = trips.N*trips.N;
+    const std::size_t num_checks = std::min<std::size_t>(3, count);
+    for (std::size_t i = 0; i < num_checks; ++i)
+    {
+      const std::size_t index = i * count / num_checks;
+      const Key key{index / trips.N, index % trips.N, 0};
+      const auto& saved = trips.at(key);
+      const auto actual = calculate_result(
+        rmf_traffic::agv::Plan::Start(rmf_traffic::Time(), key.start, 0.0),
+        rmf_traffic::agv::Plan::Goal(key.goal));
+      if (actual.has_value() != saved.reachable)
+        return false;
+
+      if (actual.has_value()
+        && (actual->duration() != saved.duration
+        || std::abs(actual->change_in_charge() - saved.change_in_charge)
+        > 1e-9))
+        return false;
+    }
+
+    return true;
+  }
+
+  // Plan every trip that begins at one of the rows, spreading the rows across
+  // the threads
+  void fill_rows(
+    Table& trips,
+    const std::vector<std::size_t>& rows,
+    std::size_t num_threads) const
+  {
+    const auto& pool = executor ? executor : Executor::default_executor();
+    pool->parallel_for(
+      rows.size(), [&](std::size_t i)
+      {
+        const std::size_t row = rows[i];
+        for (std::size_t col = 0; col < trips.N; ++col)
+        {
+          const auto result = calculate_result(
+            rmf_traffic::agv::Plan::Start(rmf_traffic::Time(), row, 0.0),
+            rmf_traffic::agv::Plan::Goal(col));
+
+          auto& trip = trips.at({row, col, 0});
+          trip.reachable = result.has_value();
+          if (result.has_value())
+          {
+            trip.duration = result->duration();
+            trip.change_in_charge = result->change_in_charge();
+          }
+        }
+      }, std::max<std::size_t>(1, num_threads));
+  }
+};
+
+//==============================================================================
+TravelEstimator::TravelEstimator(const Parameters& parameters)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(parameters))
+{
+  // Do nothing
+}
+
+//==============================================================================
+rmf_traffic::Duration TravelEstimator::Result::duration() const
+{
+  return _pimpl->duration;
+}
+
+//==============================================================================
+double TravelEstimator::Result::change_in_charge() const
+{
+  return _pimpl->change_in_charge;
+}
+
+//==============================================================================
+TravelEstimator::Result::Result()
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto TravelEstimator::estimate(
+  const rmf_traffic::agv::Plan::Start& start,
+  const rmf_traffic::agv::Plan::Goal& goal) const -> std::optional<Result>
+{
+  return _pimpl->adjusted(_pimpl->estimate(start, goal), start, goal);
+}
+
+//==============================================================================
+auto TravelEstimator::estimate(
+  const rmf_traffic::agv::Plan::Start& start,
+  const std::vector<rmf_traffic::agv::Plan::Goal>& goals) const
+-> std::vector<std::optional<Result>>
+{
+  auto results = _pimpl->estimate(start, goals);
+  if (_pimpl->congestion.has_value() || _pimpl->calibration)
+  {
+    for (std::size_t i = 0; i < goals.size(); ++i)
+      results[i] = _pimpl->adjusted(std::move(results[i]), start, goals[i]);
+  }
+
+  return results;
+}
+
+//==============================================================================
+auto TravelEstimator::estimate(
+  const std::vector<rmf_traffic::agv::Plan::Start>& starts,
+  const std::vector<rmf_traffic::agv::Plan::Goal>& goals) const
+-> std::vector<std::vector<std::optional<Result>>>
+{
+  std::vector<std::vector<std::optional<Result>>> results;
+  results.reserve(starts.size());
+  for (const auto& start : starts)
+    results.push_back(estimate(start, goals));
+
+  return results;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::orientation_bins(std::size_t bins)
+{
+  _pimpl->set_orientation_bins(bins);
+  _pimpl->generation.fetch_add(1, std::memory_order_release);
+  return *this;
+}
+
+//==============================================================================
+std::size_t TravelEstimator::orientation_bins() const
+{
+  return _pimpl->get_orientation_bins();
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::failed_plan_lifetime(
+  std::optional<rmf_traffic::Duration> lifetime)
+{
+  _pimpl->set_failed_plan_lifetime(lifetime);
+  return *this;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration>
+TravelEstimator::failed_plan_lifetime() const
+{
+  return _pimpl->failed_plan_lifetime;
+}
+
+//==============================================================================
+class TravelEstimator::Congestion::Implementation
+{
+public:
+
+  rmf_traffic::Time day_start;
+  rmf_traffic::Duration bucket_width;
+  std::size_t buckets_per_day;
+  std::unordered_map<std::size_t, std::size_t> zones = {};
+  std::unordered_map<std::size_t, std::vector<double>> multipliers = {};
+
+  double zone_multiplier(std::size_t waypoint, std::size_t bucket) const
+  {
+    const auto zone = zones.find(waypoint);
+    const auto it = multipliers.find(zone == zones.end() ? 0 : zone->second);
+    if (it == multipliers.end() || it->second.size() <= bucket)
+      return 1.0;
+
+    return it->second[bucket];
+  }
+};
+
+//==============================================================================
+TravelEstimator::Congestion::Congestion(
+  rmf_traffic::Time day_start,
+  rmf_traffic::Duration bucket_width,
+  std::size_t buckets_per_day)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{
+        day_start,
+        std::max(bucket_width, rmf_traffic::Duration(1)),
+        std::max<std::size_t>(buckets_per_day, 1)
+      }))
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto TravelEstimator::Congestion::waypoint_zone(
+  std::size_t waypoint,
+  std::size_t zone) -> Congestion&
+{
+  _pimpl->zones[waypoint] = zone;
+  return *this;
+}
+
+//==============================================================================
+auto TravelEstimator::Congestion::zone_multipliers(
+  std::size_t zone,
+  std::vector<double> multipliers) -> Congestion&
+{
+  for (auto& m : multipliers)
+    m = std::max(m, 1.0);
+
+  _pimpl->multipliers[zone] = std::move(multipliers);
+  return *this;
+}
+
+//==============================================================================
+double TravelEstimator::Congestion::multiplier(
+  std::size_t start_waypoint,
+  std::size_t goal_waypoint,
+  rmf_traffic::Time start_time) const
+{
+  // The time of day wraps around, including for times before day_start
+  const auto width = _pimpl->bucket_width.count();
+  const auto day = width * static_cast<rmf_traffic::Duration::rep>(
+    _pimpl->buckets_per_day);
+  auto offset = (start_time - _pimpl->day_start).count() % day;
+  if (offset < 0)
+    offset += day;
+
+  const auto bucket = static_cast<std::size_t>(offset / width);
+  return std::max(
+    _pimpl->zone_multiplier(start_waypoint, bucket),
+    _pimpl->zone_multiplier(goal_waypoint, bucket));
+}
+
+//==============================================================================
+bool TravelEstimator::Congestion::operator==(const Congestion& other) const
+{
+  const auto& a = *_pimpl;
+  const auto& b = *other._pimpl;
+  return a.day_start == b.day_start
+    && a.bucket_width == b.bucket_width
+    && a.buckets_per_day == b.buckets_per_day
+    && a.zones == b.zones
+    && a.multipliers == b.multipliers;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::congestion(
+  std::optional<Congestion> congestion)
+{
+  _pimpl->congestion = std::move(congestion);
+  return *this;
+}
+
+//==============================================================================
+auto TravelEstimator::congestion() const -> const std::optional<Congestion>&
+{
+  return _pimpl->congestion;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::calibration(ConstCalibrationPtr calibration)
+{
+  _pimpl->calibration = std::move(calibration);
+  return *this;
+}
+
+//==============================================================================
+const ConstCalibrationPtr& TravelEstimator::calibration() const
+{
+  return _pimpl->calibration;
+}
+
+//==============================================================================
+uint64_t TravelEstimator::generation() const
+{
+  return _pimpl->generation.load(std::memory_order_acquire);
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::mode(Mode mode)
+{
+  _pimpl->set_mode(mode);
+  _pimpl->generation.fetch_add(1, std::memory_order_release);
+  return *this;
+}
+
+//==============================================================================
+auto TravelEstimator::mode() const -> Mode
+{
+  return _pimpl->get_mode();
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::split_by_floor(bool enabled)
+{
+  _pimpl->split_floors = enabled;
+  _pimpl->generation.fetch_add(1, std::memory_order_release);
+  return *this;
+}
+
+//==============================================================================
+bool TravelEstimator::split_by_floor() const
+{
+  return _pimpl->split_floors;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::capacity(std::size_t max_entries)
+{
+  _pimpl->set_capacity(max_entries);
+  return *this;
+}
+
+//==============================================================================
+std::size_t TravelEstimator::capacity() const
+{
+  return _pimpl->get_capacity();
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::row_goals(std::vector<std::size_t> goals)
+{
+  _pimpl->row_goals = std::move(goals);
+  return *this;
+}
+
+//==============================================================================
+const std::vector<std::size_t>& TravelEstimator::row_goals() const
+{
+  return _pimpl->row_goals;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::trace_sink(TraceSinkPtr sink)
+{
+  _pimpl->trace_sink = std::move(sink);
+  return *this;
+}
+
+//==============================================================================
+const TraceSinkPtr& TravelEstimator::trace_sink() const
+{
+  return _pimpl->trace_sink;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::executor(ExecutorPtr executor)
+{
+  _pimpl->executor = std::move(executor);
+  return *this;
+}
+
+//==============================================================================
+const ExecutorPtr& TravelEstimator::executor() const
+{
+  return _pimpl->executor;
+}
+
+//==============================================================================
+bool TravelEstimator::serves(const Parameters& parameters) const
+{
+  return _pimpl->serves(parameters);
+}
+
+//==============================================================================
+auto TravelEstimator::statistics() const -> Statistics
+{
+  return _pimpl->statistics();
+}
+
+//==============================================================================
+void TravelEstimator::reset_statistics() const
+{
+  _pimpl->reset_statistics();
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::precompute(std::size_t num_threads)
+{
+  _pimpl->precompute(num_threads);
+  return *this;
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::forget(
+  const std::vector<std::size_t>& waypoints,
+  const std::vector<std::size_t>& lanes)
+{
+  _pimpl->forget(waypoints, lanes);
+  _pimpl->generation.fetch_add(1, std::memory_order_release);
+  return *this;
+}
+
+//==============================================================================
+std::shared_future<void> TravelEstimator::prefetch(
+  std::vector<std::pair<std::size_t, std::size_t>> trips) const
+{
+  return _pimpl->prefetch(std::move(trips));
+}
+
+//==============================================================================
+bool TravelEstimator::precompute_shared(
+  const std::string& filename,
+  std::size_t num_threads)
+{
+  return _pimpl->precompute_shared(filename, num_threads);
+}
+
+//==============================================================================
+void TravelEstimator::save(const std::string& filename) const
+{
+  _pimpl->save(filename);
+}
+
+//==============================================================================
+bool TravelEstimator::load(const std::string& filename)
+{
+  return _pimpl->load(filename);
+}
+
+//==============================================================================
+TravelEstimator& TravelEstimator::update_planner(
+  std::shared_ptr<const rmf_traffic::agv::Planner> planner,
+  const std::vector<std::size_t>& affected_waypoints,
+  std::size_t num_threads)
+{
+  _pimpl->update_planner(std::move(planner), affected_waypoints, num_threads);
+  _pimpl->generation.fetch_add(1, std::memory_order_release);
+  return *this;
 }
 
 } // namespace rmf_task
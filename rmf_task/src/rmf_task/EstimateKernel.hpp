@@ -0,0 +1,310 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__ESTIMATEKERNEL_HPP
+#define SRC__RMF_TASK__ESTIMATEKERNEL_HPP
+
+#include <rmf_task/Constraints.hpp>
+#include <rmf_task/Estimate.hpp>
+#include <rmf_task/State.hpp>
+#include <rmf_task/Task.hpp>
+
+#include "BatteryDrain.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+
+namespace rmf_task {
+
+//==============================================================================
+// The basic components of a State that the request models estimate with. They
+// are read out of the State once, so an estimate does not have to check an
+// optional every time it needs one of them. Reading throws
+// std::bad_optional_access if a component is missing, just like the models
+// did when they read each component on its own. The only exception is the
+// dedicated charging waypoint. A robot without one cannot be sent to charge,
+// but it can still carry out requests, and there is no charger that it would
+// need to get back to afterwards.
+struct BasicState
+{
+  rmf_traffic::Time time;
+  std::size_t waypoint;
+  double orientation;
+  std::optional<std::size_t> charging_waypoint;
+  double battery_soc;
+
+  static BasicState read(const State& state)
+  {
+    return BasicState{
+      state.time().value(),
+      state.waypoint().value(),
+      state.orientation().value(),
+      state.dedicated_charging_waypoint(),
+      state.battery_soc().value()
+    };
+  }
+
+  // The state of the robot once it has moved to a new location, with the
+  // same charging waypoint as this one
+  State moved_to(
+    const rmf_traffic::agv::Plan::Start& location,
+    double new_battery_soc) const
+  {
+    State state;
+    state.load(location).battery_soc(new_battery_soc);
+    if (charging_waypoint.has_value())
+      state.dedicated_charging_waypoint(*charging_waypoint);
+
+    return state;
+  }
+
+  rmf_traffic::agv::Plan::Start plan_start() const
+  {
+    return rmf_traffic::agv::Plan::Start(time, waypoint, orientation);
+  }
+};
+
+//==============================================================================
+// The invariant parts of a request where the robot travels to a start
+// waypoint, spends a fixed amount of time and battery there, and finishes at an
+// end waypoint.
+struct FixedRequest
+{
+  std::size_t start_waypoint;
+  std::size_t end_waypoint;
+  rmf_traffic::Time earliest_start_time;
+  rmf_traffic::Duration invariant_duration;
+  double invariant_battery_drain;
+  const BatteryDrain& drain;
+};
+
+//==============================================================================
+// The parts of estimating a FixedRequest that do not depend on the time of the
+// initial state: the travel to the start waypoint, the charge that is left
+// after it, and the charge that it takes to retreat from the end waypoint to
+// the charger.
+struct FixedRequestTravel
+{
+  rmf_traffic::Duration variant_duration;
+  double battery_soc;
+  double retreat_drain;
+};
+
+//==============================================================================
+// Estimate the travel of a FixedRequest. This is std::nullopt if the request
+// cannot be performed from the initial state, whatever its time is.
+template<bool DrainBattery>
+std::optional<FixedRequestTravel> travel_fixed_request(
+  const FixedRequest& request,
+  const BasicState& initial,
+  const double battery_threshold,
+  const TravelEstimator& travel_estimator)
+{
+  FixedRequestTravel result{
+    rmf_traffic::Duration(0), initial.battery_soc, 0.0};
+
+  // Factor in battery drain while moving to start waypoint of task
+  if (initial.waypoint != request.start_waypoint)
+  {
+    const auto travel = travel_estimator.estimate(
+      initial.plan_start(), request.start_waypoint);
+
+    if (!travel.has_value())
+      return std::nullopt;
+
+    result.variant_duration = travel->duration();
+    if constexpr (DrainBattery)
+      result.battery_soc -= travel->change_in_charge();
+
+    if (result.battery_soc <= battery_threshold)
+      return std::nullopt;
+  }
+
+  if constexpr (DrainBattery)
+  {
+    // The charge that the robot needs to head back to its charger
+    const auto& charger = initial.charging_waypoint;
+    if (charger.has_value() && request.end_waypoint != *charger)
+    {
+      const auto travel = travel_estimator.estimate(
+        rmf_traffic::agv::Plan::Start(
+          initial.time, request.end_waypoint, initial.orientation),
+        *charger);
+
+      if (!travel.has_value())
+        return std::nullopt;
+
+      result.retreat_drain = travel->change_in_charge();
+    }
+  }
+
+  return result;
+}
+
+//==============================================================================
+// Finish the estimate of a FixedRequest from its travel, for an initial state
+// that begins at initial.time
+template<bool DrainBattery>
+std::optional<Estimate> finish_fixed_request(
+  const FixedRequest& request,
+  const FixedRequestTravel& travel,
+  const BasicState& initial,
+  const double battery_threshold)
+{
+  const rmf_traffic::Time wait_until = std::max(
+    initial.time, request.earliest_start_time - travel.variant_duration);
+
+  const rmf_traffic::agv::Plan::Start finish{
+    wait_until + travel.variant_duration + request.invariant_duration,
+    request.end_waypoint,
+    initial.orientation};
+
+  double battery_soc = travel.battery_soc;
+  if constexpr (DrainBattery)
+  {
+    // Factor in battery drain while waiting to move to start waypoint. If a
+    // robot is initially at a charging waypoint, it is assumed to be
+    // continually charging
+    if (wait_until > initial.time
+      && initial.waypoint != initial.charging_waypoint)
+    {
+      battery_soc -= request.drain.ambient(
+        rmf_traffic::time::to_seconds(wait_until - initial.time));
+
+      if (battery_soc <= battery_threshold)
+        return std::nullopt;
+    }
+
+    battery_soc -= request.invariant_battery_drain;
+    if (battery_soc <= battery_threshold)
+      return std::nullopt;
+
+    // Check if the robot has enough charge to head back to nearest charger
+    if (battery_soc - travel.retreat_drain <= battery_threshold)
+      return std::nullopt;
+  }
+
+  return Estimate(
+    initial.moved_to(finish, battery_soc),
+    wait_until);
+}
+
+//==============================================================================
+// Estimate the finish of a FixedRequest. This is specialized on whether the
+// battery is drained, so the version without drain carries none of the battery
+// arithmetic and the version with drain has no branches on the constraint.
+template<bool DrainBattery>
+std::optional<Estimate> estimate_fixed_request(
+  const FixedRequest& request,
+  const BasicState& initial,
+  const double battery_threshold,
+  const TravelEstimator& travel_estimator)
+{
+  const auto travel = travel_fixed_request<DrainBattery>(
+    request, initial, battery_threshold, travel_estimator);
+
+  if (!travel.has_value())
+    return std::nullopt;
+
+  return finish_fixed_request<DrainBattery>(
+    request, *travel, initial, battery_threshold);
+}
+
+//==============================================================================
+// The Task::Model::Kernel of a FixedRequest. It refers to the BatteryDrain of
+// its model.
+template<bool DrainBattery>
+class FixedRequestKernel : public Task::Model::Kernel
+{
+public:
+
+  FixedRequestKernel(
+    const FixedRequest& request,
+    const BasicState& initial,
+    const double battery_threshold,
+    const TravelEstimator& travel_estimator)
+  : _request(request),
+    _initial(initial),
+    _battery_threshold(battery_threshold),
+    _travel(travel_fixed_request<DrainBattery>(
+        request, initial, battery_threshold, travel_estimator))
+  {
+    // Do nothing
+  }
+
+  std::optional<Estimate> estimate_finish(
+    const State& initial_state) const final
+  {
+    if (!_travel.has_value())
+      return std::nullopt;
+
+    auto initial = _initial;
+    initial.time = initial_state.time().value();
+    return finish_fixed_request<DrainBattery>(
+      _request, *_travel, initial, _battery_threshold);
+  }
+
+private:
+  FixedRequest _request;
+  BasicState _initial;
+  double _battery_threshold;
+  std::optional<FixedRequestTravel> _travel;
+};
+
+//==============================================================================
+// Read the initial state once and run the specialization of the kernel that
+// matches the constraints
+inline std::optional<Estimate> estimate_fixed_request(
+  const FixedRequest& request,
+  const State& initial_state,
+  const Constraints& constraints,
+  const TravelEstimator& travel_estimator)
+{
+  const auto initial = BasicState::read(initial_state);
+  if (constraints.drain_battery())
+  {
+    return estimate_fixed_request<true>(
+      request, initial, constraints.threshold_soc(), travel_estimator);
+  }
+
+  return estimate_fixed_request<false>(
+    request, initial, constraints.threshold_soc(), travel_estimator);
+}
+
+//==============================================================================
+// Make the Task::Model::Kernel of a FixedRequest for an initial state
+inline Task::Model::ConstKernelPtr make_fixed_request_kernel(
+  const FixedRequest& request,
+  const State& initial_state,
+  const Constraints& constraints,
+  const TravelEstimator& travel_estimator)
+{
+  const auto initial = BasicState::read(initial_state);
+  if (constraints.drain_battery())
+  {
+    return std::make_shared<FixedRequestKernel<true>>(
+      request, initial, constraints.threshold_soc(), travel_estimator);
+  }
+
+  return std::make_shared<FixedRequestKernel<false>>(
+    request, initial, constraints.threshold_soc(), travel_estimator);
+}
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__ESTIMATEKERNEL_HPP
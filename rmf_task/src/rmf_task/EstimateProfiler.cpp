@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "EstimateProfiler.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#if __has_include(<cxxabi.h>)
+#include <cxxabi.h>
+#endif
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// The name of a type of model, without the "::Model" that the models of the
+// built-in descriptions are named with
+std::string profile_type(const std::type_info& type)
+{
+  std::string name = type.name();
+#if __has_include(<cxxabi.h>)
+  int status = 0;
+  const std::unique_ptr<char, decltype(&std::free)> demangled(
+    abi::__cxa_demangle(type.name(), nullptr, nullptr, &status), &std::free);
+  if (status == 0 && demangled)
+    name = demangled.get();
+#endif
+
+  const std::string suffix = "::Model";
+  if (name.size() > suffix.size()
+    && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+    name.resize(name.size() - suffix.size());
+
+  return name;
+}
+} // anonymous namespace
+
+//==============================================================================
+class TaskPlanner::Statistics::EstimateProfile::Implementation
+{
+public:
+
+  std::string type;
+  std::size_t calls = 0;
+  rmf_traffic::Duration total_latency = rmf_traffic::Duration(0);
+  std::vector<std::size_t> histogram = std::vector<std::size_t>(LatencyBuckets);
+
+  static EstimateProfile make(Implementation impl)
+  {
+    EstimateProfile profile;
+    *profile._pimpl = std::move(impl);
+    return profile;
+  }
+};
+
+//==============================================================================
+TaskPlanner::Statistics::EstimateProfile::EstimateProfile()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+const std::string& TaskPlanner::Statistics::EstimateProfile::type() const
+{
+  return _pimpl->type;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::EstimateProfile::calls() const
+{
+  return _pimpl->calls;
+}
+
+//==============================================================================
+rmf_traffic::Duration
+TaskPlanner::Statistics::EstimateProfile::total_latency() const
+{
+  return _pimpl->total_latency;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Statistics::EstimateProfile::percentile(
+  double fraction) const
+{
+  if (_pimpl->calls == 0)
+    return rmf_traffic::Duration(0);
+
+  const auto target = static_cast<std::size_t>(
+    std::ceil(std::clamp(fraction, 0.0, 1.0) * _pimpl->calls));
+  std::size_t seen = 0;
+  for (std::size_t i = 0; i < _pimpl->histogram.size(); ++i)
+  {
+    seen += _pimpl->histogram[i];
+    if (seen >= std::max<std::size_t>(target, 1))
+      return latency_bucket_limit(i);
+  }
+
+  return latency_bucket_limit(LatencyBuckets - 1);
+}
+
+//==============================================================================
+const std::vector<std::size_t>&
+TaskPlanner::Statistics::EstimateProfile::histogram() const
+{
+  return _pimpl->histogram;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Statistics::EstimateProfile::bucket_limit(
+  std::size_t bucket)
+{
+  return latency_bucket_limit(bucket);
+}
+
+//==============================================================================
+void EstimateProfiler::record(
+  const Task::Model& model,
+  rmf_traffic::Duration latency)
+{
+  const std::type_info& type = typeid(model);
+  const std::size_t start = type.hash_code();
+  for (std::size_t i = 0; i < Capacity; ++i)
+  {
+    Slot& slot = _slots[(start + i) % Capacity];
+    const std::type_info* current = slot.type.load(std::memory_order_acquire);
+    if (!current)
+    {
+      if (!slot.type.compare_exchange_strong(
+          current, &type, std::memory_order_acq_rel))
+      {
+        // Another thread claimed the slot first, maybe for the same type
+        if (*current != type)
+          continue;
+      }
+    }
+    else if (*current != type)
+    {
+      continue;
+    }
+
+    slot.calls.fetch_add(1, std::memory_order_relaxed);
+    slot.total_ns.fetch_add(latency.count(), std::memory_order_relaxed);
+    slot.histogram[latency_bucket(latency)].fetch_add(
+      1, std::memory_order_relaxed);
+    return;
+  }
+}
+
+//==============================================================================
+auto EstimateProfiler::profiles() const
+-> std::vector<TaskPlanner::Statistics::EstimateProfile>
+{
+  using EstimateProfile = TaskPlanner::Statistics::EstimateProfile;
+  std::vector<EstimateProfile::Implementation> found;
+  for (const auto& slot : _slots)
+  {
+    const auto* type = slot.type.load(std::memory_order_acquire);
+    if (!type)
+      continue;
+
+    EstimateProfile::Implementation profile;
+    profile.type = profile_type(*type);
+    profile.calls = slot.calls.load(std::memory_order_relaxed);
+    profile.total_latency = rmf_traffic::Duration(
+      slot.total_ns.load(std::memory_order_relaxed));
+    for (std::size_t i = 0; i < LatencyBuckets; ++i)
+      profile.histogram[i] = slot.histogram[i].load(std::memory_order_relaxed);
+
+    found.push_back(std::move(profile));
+  }
+
+  std::sort(found.begin(), found.end(),
+    [](const auto& a, const auto& b)
+    {
+      return a.total_latency > b.total_latency;
+    });
+
+  std::vector<EstimateProfile> profiles;
+  profiles.reserve(found.size());
+  for (auto& profile : found)
+  {
+    profiles.push_back(
+      EstimateProfile::Implementation::make(std::move(profile)));
+  }
+
+  return profiles;
+}
+
+} // namespace rmf_task
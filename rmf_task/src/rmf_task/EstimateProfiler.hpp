@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__ESTIMATEPROFILER_HPP
+#define SRC__RMF_TASK__ESTIMATEPROFILER_HPP
+
+#include <rmf_task/Task.hpp>
+#include <rmf_task/TaskPlanner.hpp>
+
+#include "LatencyHistogram.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <typeinfo>
+#include <vector>
+
+namespace rmf_task {
+
+//==============================================================================
+// Collects the latencies of finish estimates by the dynamic type of the model
+// that made them, for Options::profile_estimates(). Estimates may be recorded
+// from any number of threads at once without locking. There are only a few
+// types of models, so they are kept in a small table, and the estimates of
+// any types beyond its capacity are not recorded.
+class EstimateProfiler
+{
+public:
+
+  // Time an estimate of the model, if there is a profiler
+  template<typename Estimate>
+  static auto time(
+    EstimateProfiler* profiler,
+    const Task::Model& model,
+    Estimate&& estimate) -> decltype(estimate())
+  {
+    if (!profiler)
+      return estimate();
+
+    const auto start = std::chrono::steady_clock::now();
+    auto result = estimate();
+    profiler->record(model, std::chrono::steady_clock::now() - start);
+    return result;
+  }
+
+  void record(const Task::Model& model, rmf_traffic::Duration latency);
+
+  std::vector<TaskPlanner::Statistics::EstimateProfile> profiles() const;
+
+private:
+
+  struct Slot
+  {
+    std::atomic<const std::type_info*> type = nullptr;
+    std::atomic_size_t calls = 0;
+    std::atomic<int64_t> total_ns = 0;
+    std::array<std::atomic_size_t, LatencyBuckets> histogram = {};
+  };
+
+  static constexpr std::size_t Capacity = 32;
+  std::array<Slot, Capacity> _slots;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__ESTIMATEPROFILER_HPP
@@ -16,22 +16,58 @@
 */
 
 #include <rmf_task/Event.hpp>
+#include <rmf_task/AllocationCounter.hpp>
+
+#include <atomic>
+#include <optional>
+#include <unordered_map>
 
 namespace rmf_task {
 
 namespace {
 //==============================================================================
 std::vector<Event::ConstStatePtr> snapshot_dependencies(
-  const std::vector<Event::ConstStatePtr>& queue)
+  const std::vector<Event::ConstStatePtr>& queue,
+  const std::vector<Event::ConstStatePtr>& previous)
 {
+  // Previous snapshots of the dependencies, so that the ones which have not
+  // changed can be reused. Dependencies almost always keep their positions,
+  // so the previous snapshot at the same position is checked first, and the
+  // lookup table is only built if that ever misses.
+  std::unordered_map<uint64_t, Event::ConstSnapshotPtr> reusable;
+  bool reusable_ready = false;
+  const auto find_previous =
+    [&](std::size_t i, uint64_t id) -> Event::ConstSnapshotPtr
+    {
+      if (i < previous.size() && previous[i]->id() == id)
+        return std::dynamic_pointer_cast<const Event::Snapshot>(previous[i]);
+
+      if (!reusable_ready)
+      {
+        reusable_ready = true;
+        for (const auto& p : previous)
+        {
+          auto snapshot = std::dynamic_pointer_cast<const Event::Snapshot>(p);
+          if (snapshot)
+            reusable.insert({snapshot->id(), std::move(snapshot)});
+        }
+      }
+
+      const auto it = reusable.find(id);
+      return it == reusable.end() ? nullptr : it->second;
+    };
+
   // NOTE(MXG): This implementation is using recursion. That should be fine
   // since I don't expect much depth in the trees of dependencies, but we may
   // want to revisit this and implement it as a queue instead if we ever find
   // a use-case with deep recursion.
   std::vector<Event::ConstStatePtr> output;
   output.reserve(queue.size());
-  for (const auto& c : queue)
-    output.push_back(Event::Snapshot::make(*c));
+  for (std::size_t i = 0; i < queue.size(); ++i)
+  {
+    const auto& c = queue[i];
+    output.push_back(Event::Snapshot::make(*c, find_previous(i, c->id())));
+  }
 
   return output;
 }
@@ -76,6 +112,42 @@ bool Event::State::finished() const
   }
 }
 
+//==============================================================================
+uint64_t Event::State::version() const
+{
+  return new_version();
+}
+
+//==============================================================================
+MemoryUsage Event::State::memory_usage() const
+{
+  using Component = MemoryUsage::Component;
+  MemoryUsage usage;
+  usage.add(Component::Log, log().memory_usage());
+
+  VersionedString::Reader reader;
+  for (const auto& s : {name(), detail()})
+  {
+    if (const auto text = reader.read(s))
+      usage.add(Component::Other, text->capacity());
+  }
+
+  for (const auto& dep : dependencies())
+  {
+    if (dep)
+      usage.add(dep->memory_usage());
+  }
+
+  return usage;
+}
+
+//==============================================================================
+uint64_t Event::State::new_version()
+{
+  static std::atomic_uint64_t next = 0;
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
 //==============================================================================
 class Event::Snapshot::Implementation
 {
@@ -87,12 +159,30 @@ public:
   VersionedString::View detail;
   Log::View log;
   std::vector<ConstStatePtr> dependencies;
+  uint64_t version;
 
 };
 
 //==============================================================================
 auto Event::Snapshot::make(const State& other) -> ConstSnapshotPtr
 {
+  return make(other, nullptr);
+}
+
+//==============================================================================
+auto Event::Snapshot::make(
+  const State& other,
+  const ConstSnapshotPtr& previous) -> ConstSnapshotPtr
+{
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Snapshot);
+
+  // The version is read first, so that any change which happens while the
+  // snapshot is being made gives the event a newer version than this one
+  const auto version = other.version();
+  const bool same_event = previous && previous->id() == other.id();
+  if (same_event && previous->version() == version)
+    return previous;
+
   Snapshot output;
   output._pimpl = rmf_utils::make_impl<Implementation>(
     Implementation{
@@ -101,7 +191,10 @@ auto Event::Snapshot::make(const State& other) -> ConstSnapshotPtr
       other.name(),
       other.detail(),
       other.log(),
-      snapshot_dependencies(other.dependencies())
+      snapshot_dependencies(
+        other.dependencies(),
+        same_event ? previous->dependencies() : std::vector<ConstStatePtr>()),
+      version
     });
 
   return std::make_shared<Snapshot>(std::move(output));
@@ -143,6 +236,27 @@ std::vector<Event::ConstStatePtr> Event::Snapshot::dependencies() const
   return _pimpl->dependencies;
 }
 
+//==============================================================================
+uint64_t Event::Snapshot::version() const
+{
+  return _pimpl->version;
+}
+
+//==============================================================================
+MemoryUsage Event::Snapshot::memory_usage() const
+{
+  std::size_t bytes = sizeof(Snapshot) + sizeof(Implementation)
+    + _pimpl->dependencies.capacity() * sizeof(ConstStatePtr);
+
+  for (const auto& dep : _pimpl->dependencies)
+  {
+    if (dep)
+      bytes += dep->memory_usage().total();
+  }
+
+  return MemoryUsage().add(MemoryUsage::Component::Snapshot, bytes);
+}
+
 //==============================================================================
 Event::Snapshot::Snapshot()
 {
@@ -154,6 +268,8 @@ class Event::AssignID::Implementation
 {
 public:
   mutable uint64_t next_id = 0;
+  mutable std::optional<uint64_t> first_id;
+  AssignIDPtr source;
 };
 
 //==============================================================================
@@ -162,6 +278,17 @@ Event::AssignIDPtr Event::AssignID::make()
   return std::make_shared<AssignID>();
 }
 
+//==============================================================================
+Event::AssignIDPtr Event::AssignID::reuse(
+  const uint64_t first_id,
+  AssignIDPtr source)
+{
+  auto assign_id = std::make_shared<AssignID>();
+  assign_id->_pimpl->first_id = first_id;
+  assign_id->_pimpl->source = std::move(source);
+  return assign_id;
+}
+
 //==============================================================================
 Event::AssignID::AssignID()
 : _pimpl(rmf_utils::make_unique_impl<Implementation>())
@@ -172,6 +299,16 @@ Event::AssignID::AssignID()
 //==============================================================================
 uint64_t Event::AssignID::assign() const
 {
+  if (_pimpl->first_id.has_value())
+  {
+    const auto id = *_pimpl->first_id;
+    _pimpl->first_id = std::nullopt;
+    return id;
+  }
+
+  if (_pimpl->source)
+    return _pimpl->source->assign();
+
   return _pimpl->next_id++;
 }
 
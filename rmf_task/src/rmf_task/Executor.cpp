@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/Executor.hpp>
+
+#include "Affinity.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// The state of one call to parallel_for(). Helpers keep it alive with a
+// shared_ptr, because a helper may only get to run after the batch has already
+// been finished by the other threads.
+struct Batch
+{
+  const std::function<void(std::size_t)>* job;
+  std::size_t count;
+  std::atomic_size_t next = 0;
+  std::atomic_size_t done = 0;
+  std::atomic_bool failed = false;
+
+  std::mutex mutex;
+  std::condition_variable finished;
+  std::exception_ptr error;
+
+  void run()
+  {
+    std::size_t i;
+    while ((i = next.fetch_add(1)) < count)
+    {
+      if (!failed)
+      {
+        try
+        {
+          (*job)(i);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          if (!error)
+            error = std::current_exception();
+          failed = true;
+        }
+      }
+
+      if (done.fetch_add(1) + 1 == count)
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.notify_all();
+      }
+    }
+  }
+};
+
+//==============================================================================
+class WorkStealingPool : public Executor
+{
+public:
+
+  WorkStealingPool(std::size_t num_threads, std::vector<std::size_t> cores)
+  : _cores(std::move(cores))
+  {
+    num_threads = std::max<std::size_t>(1, num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i)
+      _queues.push_back(std::make_unique<Queue>());
+
+    for (std::size_t i = 0; i < num_threads; ++i)
+      _workers.emplace_back([this, i]() { _work(i); });
+  }
+
+  ~WorkStealingPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_sleep_mutex);
+      _stop = true;
+    }
+    _wake.notify_all();
+
+    for (auto& worker : _workers)
+      worker.join();
+  }
+
+  void post(std::function<void()> job) final
+  {
+    // A job that is posted by one of the workers goes onto the queue of that
+    // worker, where it will probably still be in the cache when it runs.
+    const std::size_t q = (_current_pool == this) ?
+      _current_worker : _next_queue.fetch_add(1) % _queues.size();
+
+    {
+      auto& queue = *_queues[q];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.jobs.push_back(std::move(job));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_sleep_mutex);
+      ++_pending;
+    }
+    _wake.notify_one();
+  }
+
+  std::size_t concurrency() const final
+  {
+    return _workers.size();
+  }
+
+private:
+
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  // Take the newest job of our own queue, or else the oldest job of another
+  // worker's queue
+  bool _take(std::size_t index, std::function<void()>& job)
+  {
+    const std::size_t N = _queues.size();
+    for (std::size_t k = 0; k < N; ++k)
+    {
+      auto& queue = *_queues[(index + k) % N];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (queue.jobs.empty())
+        continue;
+
+      if (k == 0)
+      {
+        job = std::move(queue.jobs.back());
+        queue.jobs.pop_back();
+      }
+      else
+      {
+        job = std::move(queue.jobs.front());
+        queue.jobs.pop_front();
+      }
+
+      return true;
+    }
+
+    return false;
+  }
+
+  void _work(std::size_t index)
+  {
+    _current_pool = this;
+    _current_worker = index;
+    pin_current_thread(_cores);
+
+    while (true)
+    {
+      std::function<void()> job;
+      if (_take(index, job))
+      {
+        {
+          std::lock_guard<std::mutex> lock(_sleep_mutex);
+          --_pending;
+        }
+
+        try
+        {
+          job();
+        }
+        catch (...)
+        {
+          // A failing job must not take its worker down with it
+        }
+
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(_sleep_mutex);
+      _wake.wait(lock, [&]() { return _stop || _pending > 0; });
+      if (_stop && _pending == 0)
+        return;
+    }
+  }
+
+  static thread_local const WorkStealingPool* _current_pool;
+  static thread_local std::size_t _current_worker;
+
+  std::vector<std::size_t> _cores;
+  std::vector<std::unique_ptr<Queue>> _queues;
+  std::vector<std::thread> _workers;
+  std::atomic_size_t _next_queue = 0;
+
+  std::mutex _sleep_mutex;
+  std::condition_variable _wake;
+  std::size_t _pending = 0;
+  bool _stop = false;
+};
+
+//==============================================================================
+thread_local const WorkStealingPool* WorkStealingPool::_current_pool = nullptr;
+thread_local std::size_t WorkStealingPool::_current_worker = 0;
+
+} // anonymous namespace
+
+//==============================================================================
+void Executor::parallel_for(
+  std::size_t count,
+  const std::function<void(std::size_t)>& job,
+  std::size_t max_threads)
+{
+  if (count == 0)
+    return;
+
+  if (max_threads == 0)
+    max_threads = concurrency() + 1;
+
+  const std::size_t helpers = std::min(count, max_threads) - 1;
+  if (helpers == 0)
+  {
+    for (std::size_t i = 0; i < count; ++i)
+      job(i);
+
+    return;
+  }
+
+  auto batch = std::make_shared<Batch>();
+  batch->job = &job;
+  batch->count = count;
+
+  for (std::size_t i = 0; i < helpers; ++i)
+    post([batch]() { batch->run(); });
+
+  batch->run();
+
+  {
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->finished.wait(lock, [&]() { return batch->done == count; });
+  }
+
+  if (batch->error)
+    std::rethrow_exception(batch->error);
+}
+
+//==============================================================================
+std::shared_ptr<Executor> Executor::make_thread_pool(
+  std::size_t num_threads,
+  std::vector<std::size_t> cores)
+{
+  return std::make_shared<WorkStealingPool>(num_threads, std::move(cores));
+}
+
+//==============================================================================
+const std::shared_ptr<Executor>& Executor::default_executor()
+{
+  static const std::shared_ptr<Executor> executor =
+    make_thread_pool(std::thread::hardware_concurrency());
+
+  return executor;
+}
+
+} // namespace rmf_task
@@ -17,6 +17,9 @@
 
 #include <rmf_task/Header.hpp>
 
+#include <atomic>
+#include <mutex>
+
 namespace rmf_task {
 
 //==============================================================================
@@ -24,9 +27,73 @@ class Header::Implementation
 {
 public:
 
+  Implementation(
+    std::string category_,
+    std::string detail_,
+    MakeDetail make_detail_,
+    rmf_traffic::Duration duration_)
+  : category(std::move(category_)),
+    detail(std::move(detail_)),
+    make_detail(std::move(make_detail_)),
+    formatted(!make_detail),
+    duration(duration_)
+  {
+    // Do nothing
+  }
+
+  Implementation(const Implementation& other)
+  : category(other.category),
+    duration(other.duration),
+    detail_is_json(other.detail_is_json)
+  {
+    std::lock_guard<std::mutex> lock(other.mutex);
+    detail = other.detail;
+    make_detail = other.make_detail;
+    formatted = other.formatted.load(std::memory_order_relaxed);
+  }
+
+  Implementation& operator=(const Implementation& other)
+  {
+    if (this == &other)
+      return *this;
+
+    category = other.category;
+    duration = other.duration;
+    detail_is_json = other.detail_is_json;
+
+    std::scoped_lock lock(mutex, other.mutex);
+    detail = other.detail;
+    make_detail = other.make_detail;
+    formatted = other.formatted.load(std::memory_order_relaxed);
+    return *this;
+  }
+
+  const std::string& get_detail() const
+  {
+    if (formatted.load(std::memory_order_acquire))
+      return detail;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!formatted.load(std::memory_order_relaxed))
+    {
+      detail = make_detail();
+      make_detail = nullptr;
+      formatted.store(true, std::memory_order_release);
+    }
+
+    return detail;
+  }
+
   std::string category;
-  std::string detail;
+
+  // The detail is formatted by make_detail the first time that it is read
+  mutable std::string detail;
+  mutable MakeDetail make_detail;
+  mutable std::atomic_bool formatted;
+  mutable std::mutex mutex;
+
   rmf_traffic::Duration duration;
+  bool detail_is_json = false;
 
 };
 
@@ -36,9 +103,18 @@ Header::Header(
   std::string detail_,
   rmf_traffic::Duration estimate_)
 : _pimpl(rmf_utils::make_impl<Implementation>(
-      Implementation{
-        std::move(category_), std::move(detail_), estimate_
-      }))
+      std::move(category_), std::move(detail_), nullptr, estimate_))
+{
+  // Do nothing
+}
+
+//==============================================================================
+Header::Header(
+  std::string category_,
+  MakeDetail make_detail_,
+  rmf_traffic::Duration estimate_)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      std::move(category_), std::string(), std::move(make_detail_), estimate_))
 {
   // Do nothing
 }
@@ -52,7 +128,20 @@ const std::string& Header::category() const
 //==============================================================================
 const std::string& Header::detail() const
 {
-  return _pimpl->detail;
+  return _pimpl->get_detail();
+}
+
+//==============================================================================
+bool Header::detail_is_json() const
+{
+  return _pimpl->detail_is_json;
+}
+
+//==============================================================================
+Header& Header::detail_is_json(bool value)
+{
+  _pimpl->detail_is_json = value;
+  return *this;
 }
 
 //==============================================================================
@@ -16,8 +16,10 @@
 */
 
 #include "InvariantHeuristicQueue.hpp"
+#include "internal_task_planning.hpp"
 
 #include <cassert>
+#include <cmath>
 #include <algorithm>
 
 namespace rmf_task {
@@ -27,56 +29,103 @@ InvariantHeuristicQueue::InvariantHeuristicQueue(
   std::vector<double> initial_values)
 {
   assert(!initial_values.empty());
-  std::sort(initial_values.begin(), initial_values.end());
 
-  for (const auto value : initial_values)
-    _stacks.push_back({{0, value}});
+  // A sorted vector is already a valid min-heap
+  std::sort(initial_values.begin(), initial_values.end());
+  _ends = std::move(initial_values);
 }
 
 //==============================================================================
 void InvariantHeuristicQueue::add(
   const double earliest_start_time, const double earliest_finish_time)
 {
-  double prev_end_value = _stacks[0].back().end;
-  double new_end_value = prev_end_value +
+  const double prev_end_value = _ends.front();
+  const double new_end_value = prev_end_value +
     (earliest_finish_time - earliest_start_time);
-  _stacks[0].push_back({earliest_start_time, new_end_value});
 
-  // Find the largest stack that is still smaller than the current front
-  const auto next_it = _stacks.begin() + 1;
-  auto end_it = next_it;
-  for (; end_it != _stacks.end(); ++end_it)
+  // Set lower bound of 0 to account for case where optimistically calculated
+  // end time is smaller than earliest start time
+  _cost += std::max(0.0, new_end_value - earliest_start_time);
+
+  // Sift the new end value of the front stack down to its place in the heap.
+  // Since the front was the smallest value, this is correct whether the new
+  // value is larger or smaller than it.
+  const std::size_t N = _ends.size();
+  std::size_t i = 0;
+  while (true)
   {
-    if (new_end_value <= end_it->back().end)
+    std::size_t child = 2*i + 1;
+    if (child >= N)
       break;
-  }
 
-  if (next_it != end_it)
-  {
-    // Rotate the vector elements to move the front stack to its new place
-    // in the order
-    std::rotate(_stacks.begin(), next_it, end_it);
+    if (child + 1 < N && _ends[child + 1] < _ends[child])
+      ++child;
+
+    if (new_end_value <= _ends[child])
+      break;
+
+    _ends[i] = _ends[child];
+    i = child;
   }
+
+  _ends[i] = new_end_value;
 }
 
 //==============================================================================
 double InvariantHeuristicQueue::compute_cost() const
 {
-  double total_cost = 0.0;
-  for (const auto& stack : _stacks)
+  // NOTE: The initial values of the stacks are not part of this cost because
+  // they are already accounted for by g(n) and the variant component of h(n)
+  return _cost;
+}
+
+//==============================================================================
+std::vector<double> initial_queue_values(
+  const Node& node,
+  const rmf_traffic::Time time_now)
+{
+  std::vector<double> values(
+    node.assigned_tasks.size(), std::numeric_limits<double>::infinity());
+
+  // Determine the earliest possible time an agent can begin the invariant
+  // portion of any of its next tasks
+  for (const auto& u : node.unassigned_tasks)
+  {
+    const auto invariant_duration = u.second.model->invariant_duration();
+    const rmf_traffic::Time earliest_deployment_time =
+      u.second.candidates.best_finish_time()
+      - invariant_duration;
+    const double earliest_deployment_time_s =
+      rmf_traffic::time::to_seconds(
+      earliest_deployment_time.time_since_epoch());
+
+    const auto& range = u.second.candidates.best_candidates();
+    for (auto it = range.begin; it != range.end; ++it)
+    {
+      const std::size_t candidate = it->candidate;
+      if (earliest_deployment_time_s < values[candidate])
+        values[candidate] = earliest_deployment_time_s;
+    }
+  }
+
+  for (std::size_t i = 0; i < values.size(); ++i)
   {
-    // NOTE: We start iterating from i=1 because i=0 represents a component of
-    // the cost that is already accounted for by g(n) and the variant
-    // component of h(n)
-    for (std::size_t i = 1; i < stack.size(); ++i)
+    auto& value = values[i];
+    if (std::isinf(value))
     {
-      // Set lower bound of 0 to account for case where optimistically calculated
-      // end time is smaller than earliest start time
-      total_cost += std::max(0.0, (stack[i].end - stack[i].start));
+      // Clear out any infinity placeholders. Those candidates simply don't have
+      // any unassigned tasks that want to use it.
+      const auto& assignments = node.assigned_tasks[i];
+      if (assignments.empty())
+        value = rmf_traffic::time::to_seconds(time_now.time_since_epoch());
+      else
+        value = rmf_traffic::time::to_seconds(
+          assignments.back().assignment.finish_state()
+          .time().value().time_since_epoch());
     }
   }
 
-  return total_cost;
+  return values;
 }
 
 } // namespace rmf_task
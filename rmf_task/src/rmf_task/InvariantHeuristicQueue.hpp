@@ -15,6 +15,8 @@
  *
 */
 
+#include <rmf_traffic/Time.hpp>
+
 #include <vector>
 
 #ifndef SRC__RMF_TASK__INVARIANTHEURISTICQUEUE_HPP
@@ -22,10 +24,17 @@
 
 namespace rmf_task {
 
+struct Node;
+
 // Sorts and distributes tasks among agents based on the earliest finish time
 // possible for each task (i.e. not accounting for any variant costs). Guaranteed
 // to underestimate actual cost when the earliest start times for each task are
 // similar (enforced by the segmentation_threshold).
+//
+// Each task is stacked onto whichever agent currently finishes earliest. Only
+// the finish times of the agents are needed for that, so they are kept in a
+// binary min-heap and the cost is accumulated as tasks are added, which makes
+// add() O(log agents).
 class InvariantHeuristicQueue
 {
 public:
@@ -37,10 +46,18 @@ public:
   double compute_cost() const;
 
 private:
-  struct element { double start; double end; };
-  std::vector<std::vector<element>> _stacks;
+  // A min-heap of the finish time of each agent's stack
+  std::vector<double> _ends;
+  double _cost = 0.0;
 };
 
+// The earliest time at which each agent of a node can begin the invariant
+// portion of any of its next tasks, to use as the initial values of an
+// InvariantHeuristicQueue for the node
+std::vector<double> initial_queue_values(
+  const Node& node,
+  rmf_traffic::Time time_now);
+
 } // namespace rmf_task
 
 #endif // SRC__RMF_TASK__INVARIANTHEURISTICQUEUE_HPP
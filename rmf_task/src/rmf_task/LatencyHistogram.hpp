@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__LATENCYHISTOGRAM_HPP
+#define SRC__RMF_TASK__LATENCYHISTOGRAM_HPP
+
+#include <rmf_traffic/Time.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace rmf_task {
+
+//==============================================================================
+// Latencies are counted in a histogram with four buckets per doubling of
+// nanoseconds, so percentiles can be read back within about 19%.
+constexpr std::size_t LatencyBuckets = 4*48;
+
+//==============================================================================
+inline std::size_t latency_bucket(rmf_traffic::Duration latency)
+{
+  const auto ns = latency.count();
+  if (ns <= 1)
+    return 0;
+
+  const auto bucket = static_cast<std::size_t>(4.0 * std::log2(ns));
+  return std::min(bucket, LatencyBuckets - 1);
+}
+
+//==============================================================================
+// The longest latency that gets counted in a bucket
+inline rmf_traffic::Duration latency_bucket_limit(std::size_t bucket)
+{
+  return rmf_traffic::Duration(
+    static_cast<int64_t>(std::ceil(std::exp2((bucket + 1) / 4.0))));
+}
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__LATENCYHISTOGRAM_HPP
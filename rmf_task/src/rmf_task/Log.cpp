@@ -16,27 +16,928 @@
 */
 
 #include <rmf_task/Log.hpp>
-
+#include <rmf_task/AllocationCounter.hpp>
+#include <rmf_task/Executor.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <optional>
+#include <memory>
+#include <memory_resource>
 #include <mutex>
+#include <new>
 #include <stdexcept>
-#include <list>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
+
+#include "BufferAppend.hpp"
 
 namespace rmf_task {
 
+namespace {
+//==============================================================================
+void append_binary(const Log::Entry& entry, std::string& buffer);
+
+//==============================================================================
+// Appends records to the archive file of a log on the threads of an Executor,
+// so that dropping chunks never has to wait for the disk. Records are written
+// in the order that they are given, since at most one thread at a time writes
+// the records that are queued. If the file stops taking records, the failure
+// is reported once and every record after it is discarded, since the index of
+// the log would no longer match what is in the file.
+class ArchiveWriter
+{
+public:
+
+  ArchiveWriter(
+    std::string path,
+    std::function<void(std::string)> report,
+    ExecutorPtr executor)
+  : _executor(std::move(executor)),
+    _state(std::make_shared<State>())
+  {
+    _state->path = std::move(path);
+    _state->file.open(_state->path, std::ios::binary | std::ios::app);
+    if (!_state->file.is_open())
+    {
+      // *INDENT-OFF*
+      throw std::runtime_error(
+        "[Log::retention] Unable to open archive file [" + _state->path + "]");
+      // *INDENT-ON*
+    }
+
+    _state->report = std::move(report);
+
+    // Anything that is not a regular file, like a pipe, starts out empty
+    std::error_code ec;
+    const auto size = std::filesystem::file_size(_state->path, ec);
+    _state->size = ec ? 0 : static_cast<uint64_t>(size);
+    _state->written.store(_state->size, std::memory_order_relaxed);
+  }
+
+  ArchiveWriter(const ArchiveWriter&) = delete;
+  ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+  ~ArchiveWriter()
+  {
+    // Everything that is still queued gets written before we quit. A drain
+    // job that has not run yet keeps the state alive and finds nothing to do.
+    sync();
+  }
+
+  const std::string& path() const
+  {
+    return _state->path;
+  }
+
+  // Queue records to be written, and get where in the file they will begin.
+  // This only ever waits for another call to append() or for a writer to take
+  // the queue, never for the file.
+  uint64_t append(std::string records)
+  {
+    uint64_t offset = 0;
+    {
+      std::lock_guard<std::mutex> lock(_state->mutex);
+      offset = _state->size;
+      _state->size += records.size();
+      _state->queue.push_back(std::move(records));
+      if (_state->draining)
+        return offset;
+
+      _state->draining = true;
+    }
+
+    _executor->post([state = _state]() { drain(*state); });
+    return offset;
+  }
+
+  // Wait until everything that was appended before this call has been written.
+  // If no executor thread has taken the queue yet, it is written on this
+  // thread, so waiting never depends on a free executor thread.
+  void sync() const
+  {
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    while (true)
+    {
+      write_queued(*_state, lock);
+      if (_state->queue.empty() && !_state->busy)
+        return;
+
+      _state->idle.wait(lock);
+    }
+  }
+
+  // How much of the file has been written and flushed
+  uint64_t written() const
+  {
+    return _state->written.load(std::memory_order_acquire);
+  }
+
+private:
+
+  struct State
+  {
+    std::string path;
+    std::ofstream file;
+    std::function<void(std::string)> report;
+    bool failed = false;
+    std::atomic<uint64_t> written = 0;
+
+    // Everything below is guarded by the mutex. The size includes the records
+    // that are still queued.
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::vector<std::string> queue;
+    uint64_t size = 0;
+    bool busy = false;
+    bool draining = false;
+  };
+
+  static void drain(State& state)
+  {
+    std::unique_lock<std::mutex> lock(state.mutex);
+    write_queued(state, lock);
+    state.draining = false;
+  }
+
+  // Write whatever is queued until the queue is empty, unless another thread
+  // is already writing, in which case that thread will write it instead
+  static void write_queued(State& state, std::unique_lock<std::mutex>& lock)
+  {
+    while (!state.busy && !state.queue.empty())
+    {
+      std::vector<std::string> records;
+      records.swap(state.queue);
+      state.busy = true;
+      lock.unlock();
+
+      if (!state.failed)
+      {
+        uint64_t size = 0;
+        for (const auto& r : records)
+        {
+          state.file.write(r.data(), static_cast<std::streamsize>(r.size()));
+          size += r.size();
+        }
+
+        if (state.file.flush())
+        {
+          state.written.fetch_add(size, std::memory_order_release);
+        }
+        else
+        {
+          state.failed = true;
+          state.report(
+            "[Log::retention] Unable to write to archive file [" + state.path
+            + "]. Entries that are dropped from now on are lost.");
+        }
+      }
+
+      lock.lock();
+      state.busy = false;
+      state.idle.notify_all();
+    }
+  }
+
+  ExecutorPtr _executor;
+  std::shared_ptr<State> _state;
+};
+
+//==============================================================================
+// An append-only store of log entries. Entries are kept in fixed-size chunks
+// that are linked together, so a push only allocates when a chunk fills up,
+// and entries that are next to each other in the log are next to each other
+// in memory.
+//
+// Pushing is lock-free, so several threads can log at once without waiting
+// for each other. Each push claims the next slot with one atomic increment,
+// builds its entry in that slot, and then marks the slot as ready. Slots may
+// become ready out of order, so publish() only ever exposes the longest run
+// of ready slots from the start of the store. Like a std::list, the store
+// never moves an entry once it has been added, so positions stay valid while
+// new entries are pushed, and a reader may walk up to the last published
+// entry while other threads append after it.
+//
+// Once every slot of a chunk has been published, the chunk is owned by the
+// chunk before it, so holding on to any published chunk keeps every chunk
+// after it alive. The store only holds on to the oldest chunk that its
+// retention policy still allows, and views hold on to the oldest chunk that
+// they can see through a ChunkPin, so dropping old chunks never pulls entries
+// out from under a view that is still being read.
+//
+// A push may still be walking through a chunk that has just been dropped, so
+// dropped chunks are only let go of once every push that started before they
+// were dropped has finished. Each push registers itself with the current of
+// two epochs, and dropping chunks moves the store to the other epoch, so the
+// store only has to wait for the pushes of the previous epoch to drain.
+//
+// If the retention policy has an archive file, each chunk is turned into
+// records just before it is dropped, and an ArchiveWriter appends them to the
+// file in the background. The store remembers where in the file each chunk
+// begins so that readers can find its entries again.
+//
+// Chunks are allocated from the memory resource of the store.
+class EntryStore
+{
+public:
+
+  static constexpr std::size_t ChunkSize = 64;
+
+  class Chunk
+  {
+  public:
+
+    Chunk(uint64_t first_, Chunk* previous_)
+    : first(first_),
+      previous(previous_)
+    {
+      for (auto& ready : _ready)
+        ready.store(false, std::memory_order_relaxed);
+    }
+
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    const Log::Entry& operator[](std::size_t i) const
+    {
+      return *std::launder(reinterpret_cast<const Log::Entry*>(&_slots[i]));
+    }
+
+    ~Chunk()
+    {
+      for (std::size_t i = 0; i < ChunkSize; ++i)
+      {
+        if (_ready[i].load(std::memory_order_acquire))
+          std::launder(reinterpret_cast<Log::Entry*>(&_slots[i]))->~Entry();
+      }
+
+      // Release the chunks after this one that nothing else is holding on to
+      // one at a time, so that a long log does not recurse through every chunk
+      // when it is destroyed. Chunks are only ever released while holding the
+      // publishing mutex, so nothing can be sharing them while we check.
+      std::shared_ptr<Chunk> next = std::move(_successor);
+      while (next && next.use_count() == 1)
+        next = std::move(next->_successor);
+    }
+
+    // The index in the store of the first slot of this chunk
+    const uint64_t first;
+
+    // The chunk before this one, or nullptr for the first chunk. This is only
+    // followed by pushes looking for the chunk of their own slot, which is
+    // never dropped, so it does not matter if it dangles once older chunks
+    // have been dropped.
+    Chunk* const previous;
+
+  private:
+    friend class EntryStore;
+
+    using Slot =
+      std::aligned_storage_t<sizeof(Log::Entry), alignof(Log::Entry)>;
+    std::array<Slot, ChunkSize> _slots;
+    std::array<std::atomic_bool, ChunkSize> _ready;
+    std::atomic<Chunk*> _next = nullptr;
+
+    // These are only used by publish() while it holds the publishing mutex.
+    // The successor is set once every slot of this chunk has been published,
+    // and from then on it owns the next chunk.
+    std::shared_ptr<Chunk> _successor;
+    std::size_t _bytes = 0;
+    std::optional<rmf_traffic::Time> _newest;
+  };
+
+  // The position of one entry in the store
+  struct Position
+  {
+    const Chunk* chunk;
+    std::size_t index;
+
+    const Log::Entry& operator*() const
+    {
+      return (*chunk)[index];
+    }
+
+    const Log::Entry* operator->() const
+    {
+      return &(*chunk)[index];
+    }
+
+    // Move to the next entry. This must not be called on the last entry that
+    // has been published.
+    Position& operator++()
+    {
+      if (++index == ChunkSize)
+      {
+        chunk = chunk->_next.load(std::memory_order_acquire);
+        index = 0;
+      }
+
+      return *this;
+    }
+
+    bool operator==(const Position& other) const
+    {
+      return chunk == other.chunk && index == other.index;
+    }
+
+    // How many entries came before this one since the store was created,
+    // including any that have been dropped
+    uint64_t number() const
+    {
+      return chunk->first + index;
+    }
+  };
+
+  // Destroys a chunk and gives its memory back to the resource it came from
+  struct ChunkDeleter
+  {
+    std::pmr::memory_resource* memory;
+
+    void operator()(Chunk* chunk) const
+    {
+      chunk->~Chunk();
+      memory->deallocate(chunk, sizeof(Chunk), alignof(Chunk));
+    }
+  };
+
+  using UniqueChunk = std::unique_ptr<Chunk, ChunkDeleter>;
+
+  // What a view can see of the store
+  struct Snapshot
+  {
+    // The oldest chunk that is still kept. Holding on to this keeps every
+    // published entry after it alive as well.
+    std::shared_ptr<const Chunk> oldest;
+
+    // The last entry that has been published, or nullopt if the store is empty
+    std::optional<Position> last;
+  };
+
+  EntryStore(
+    std::function<rmf_traffic::Time()> clock,
+    std::pmr::memory_resource* memory)
+  : _clock(std::move(clock)),
+    _memory(memory ? memory : std::pmr::get_default_resource()),
+    _head(share(make_chunk(0, nullptr))),
+    _frontier{_head, 0}
+  {
+    _tail.store(_head.get(), std::memory_order_relaxed);
+  }
+
+  EntryStore(const EntryStore&) = delete;
+  EntryStore& operator=(const EntryStore&) = delete;
+
+  ~EntryStore()
+  {
+    // The writer may still report a failure into this store, so it has to be
+    // finished first
+    close_archive();
+
+    // Chunks that have not been fully published yet are not owned by the
+    // chunk before them, so they have to be freed here
+    Chunk* chunk = _frontier.chunk->_next.load(std::memory_order_acquire);
+    while (chunk)
+    {
+      Chunk* next = chunk->_next.load(std::memory_order_acquire);
+      ChunkDeleter{_memory}(chunk);
+      chunk = next;
+    }
+  }
+
+  // Append the entry returned by make(index), where index counts every entry
+  // that was pushed before this one. This never blocks. Once the slot has been
+  // claimed, it must be filled, so make() must not throw.
+  template<typename MakeEntry>
+  void push(MakeEntry&& make)
+  {
+    const unsigned epoch = enter_epoch();
+    const uint64_t index = _claimed.fetch_add(1, std::memory_order_relaxed);
+    Chunk* chunk = chunk_for(index);
+    const std::size_t i = index - chunk->first;
+    new (&chunk->_slots[i]) Log::Entry(make(index));
+    chunk->_ready[i].store(true, std::memory_order_release);
+    _active[epoch].fetch_sub(1, std::memory_order_release);
+
+    if (i + 1 == ChunkSize)
+    {
+      // Apply the retention policy each time a chunk fills up, so the memory
+      // of a log that is never viewed stays bounded too. If another thread is
+      // already publishing, it will take care of this.
+      std::unique_lock<std::mutex> lock(_publish_mutex, std::try_to_lock);
+      if (lock.owns_lock())
+        publish_locked();
+    }
+  }
+
+  // The number of slots that have been claimed so far
+  uint64_t claimed() const
+  {
+    return _claimed.load(std::memory_order_acquire);
+  }
+
+  // Extend the published run of entries over every slot that has become ready
+  // since the last call, drop whatever the retention policy no longer allows,
+  // and get what a view can see.
+  Snapshot publish() const
+  {
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    publish_locked();
+
+    if (!_last.has_value())
+      return Snapshot{_head, std::nullopt};
+
+    return Snapshot{_head, Position{_last->chunk.get(), _last->index}};
+  }
+
+  // Where the archived entries of a chunk can be found
+  struct ArchiveSpan
+  {
+    std::string path;
+
+    // Where in the file the chunk begins
+    uint64_t offset;
+
+    // How much of the file has been written by this store. Records after this
+    // may still be getting written.
+    uint64_t end;
+  };
+
+  void retention(Log::Retention value)
+  {
+    // The writer of an earlier file finishes what it was given outside of the
+    // lock, so that views are not held up by the disk
+    std::shared_ptr<ArchiveWriter> previous;
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    if (value.archive() != _retention.archive())
+    {
+      std::shared_ptr<ArchiveWriter> archive;
+      if (value.archive().has_value())
+      {
+        archive = std::make_shared<ArchiveWriter>(
+          *value.archive(),
+          [this](std::string text) { report(std::move(text)); },
+          Executor::default_executor());
+      }
+
+      // Entries that went into an earlier file are no longer indexed
+      previous = std::move(_archive);
+      _archive = std::move(archive);
+      _archive_index.clear();
+    }
+
+    _retention = std::move(value);
+    publish_locked();
+  }
+
+  bool archiving() const
+  {
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    return _archive != nullptr;
+  }
+
+  // Find the archived chunk that holds the entry with the given number, or the
+  // first archived chunk if that entry came before it. This waits for the
+  // chunks that have been dropped so far to be written.
+  std::optional<ArchiveSpan> locate(uint64_t number) const
+  {
+    std::shared_ptr<ArchiveWriter> archive;
+    {
+      std::lock_guard<std::mutex> lock(_publish_mutex);
+      archive = _archive;
+    }
+
+    if (!archive)
+      return std::nullopt;
+
+    archive->sync();
+
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    if (_archive != archive || _archive_index.empty())
+      return std::nullopt;
+
+    auto it = std::upper_bound(
+      _archive_index.begin(), _archive_index.end(), number,
+      [](uint64_t n, const IndexEntry& entry) { return n < entry.first; });
+    if (it != _archive_index.begin())
+      --it;
+
+    return ArchiveSpan{archive->path(), it->offset, archive->written()};
+  }
+
+  Log::Retention retention() const
+  {
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    return _retention;
+  }
+
+  // Let go of a chunk that was given out by publish()
+  void release(std::shared_ptr<const Chunk>& chunk) const
+  {
+    std::lock_guard<std::mutex> lock(_publish_mutex);
+    chunk.reset();
+  }
+
+private:
+
+  void publish_locked() const
+  {
+    while (_frontier.chunk->_ready[_frontier.index].load(
+        std::memory_order_acquire))
+    {
+      const auto& entry = (*_frontier.chunk)[_frontier.index];
+      _frontier.chunk->_bytes += entry.text().size();
+      _bytes += entry.text().size();
+
+      auto& newest = _frontier.chunk->_newest;
+      if (!newest.has_value() || *newest < entry.time())
+        newest = entry.time();
+
+      _last = _frontier;
+      if (_frontier.index + 1 < ChunkSize)
+      {
+        ++_frontier.index;
+        continue;
+      }
+
+      // The next chunk may not exist yet if nothing has been pushed into it
+      Chunk* next = _frontier.chunk->_next.load(std::memory_order_acquire);
+      if (!next)
+      {
+        next = link_after(_frontier.chunk.get());
+      }
+
+      _frontier.chunk->_successor = share(UniqueChunk(next, {_memory}));
+      _frontier = Frontier{_frontier.chunk->_successor, 0};
+    }
+
+    drop_old_chunks();
+  }
+
+  // Drop the oldest chunks while the retention policy does not allow them.
+  // The chunk that holds the last published entry is never dropped, so there
+  // is always something left for a view to see.
+  void drop_old_chunks() const
+  {
+    if (!_last.has_value())
+      return;
+
+    const auto max_entries = _retention.max_entries();
+    const auto max_bytes = _retention.max_bytes();
+    const auto max_age = _retention.max_age();
+    const auto now = max_age.has_value() ?
+      std::optional<rmf_traffic::Time>(_clock()) : std::nullopt;
+
+    const uint64_t published = _last->chunk->first + _last->index + 1;
+    while (_head != _last->chunk)
+    {
+      const uint64_t kept = published - _head->first;
+      const bool too_many = max_entries.has_value()
+        && kept - ChunkSize >= *max_entries;
+      const bool too_big = max_bytes.has_value() && _bytes > *max_bytes;
+      const bool too_old = now.has_value()
+        && _head->_newest.has_value()
+        && *_head->_newest < *now - *max_age;
+
+      if (!too_many && !too_big && !too_old)
+        break;
+
+      archive_locked(*_head);
+      _bytes -= _head->_bytes;
+      _dropped.push_back(_head);
+      _head = _head->_successor;
+    }
+
+    // Make sure that pushes from now on will not start looking for their
+    // chunk from one that has been dropped
+    Chunk* tail = _tail.load(std::memory_order_acquire);
+    while (tail->first < _head->first
+      && !_tail.compare_exchange_weak(
+        tail, _head.get(), std::memory_order_acq_rel))
+    {
+      // Keep trying
+    }
+
+    release_dropped_chunks();
+  }
+
+  // Append every entry of a chunk that is about to be dropped to the archive
+  void archive_locked(const Chunk& chunk) const
+  {
+    if (!_archive)
+      return;
+
+    std::string buffer;
+    for (std::size_t i = 0; i < ChunkSize; ++i)
+    {
+      const std::size_t start = buffer.size();
+      append_raw<uint32_t>(0, buffer);
+      append_raw<uint64_t>(chunk.first + i, buffer);
+      append_binary(chunk[i], buffer);
+
+      const auto size =
+        static_cast<uint32_t>(buffer.size() - start - sizeof(uint32_t));
+      std::memcpy(&buffer[start], &size, sizeof(size));
+    }
+
+    const uint64_t offset = _archive->append(std::move(buffer));
+    _archive_index.push_back({chunk.first, offset});
+  }
+
+  // Add an error to the log from the archive writer
+  void report(std::string text);
+
+  // Wait for the archive writer to finish what it was given and stop it
+  void close_archive()
+  {
+    std::shared_ptr<ArchiveWriter> archive;
+    {
+      std::lock_guard<std::mutex> lock(_publish_mutex);
+      archive = std::move(_archive);
+    }
+
+    archive.reset();
+  }
+
+  // Register a push with the current epoch and return the epoch. The
+  // registration and the check of the epoch that follows it are sequentially
+  // consistent, and so are the change of the epoch and the check of the
+  // registrations in release_dropped_chunks(). Either the push sees the new
+  // epoch or the release sees the push, but never neither, which could happen
+  // if a store were allowed to be reordered after the load that follows it.
+  unsigned enter_epoch() const
+  {
+    while (true)
+    {
+      const unsigned epoch = _epoch.load(std::memory_order_seq_cst);
+      _active[epoch].fetch_add(1, std::memory_order_seq_cst);
+      if (_epoch.load(std::memory_order_seq_cst) == epoch)
+        return epoch;
+
+      // The epoch changed before we registered, so the store might not wait
+      // for us
+      _active[epoch].fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  // Let go of the chunks that were dropped once no push can be looking at them
+  void release_dropped_chunks() const
+  {
+    const unsigned epoch = _epoch.load(std::memory_order_seq_cst);
+    if (!_draining.empty())
+    {
+      if (_active[epoch ^ 1].load(std::memory_order_seq_cst) != 0)
+        return;
+
+      _draining.clear();
+    }
+
+    if (_dropped.empty())
+      return;
+
+    // Any push that registers after the epoch changes will see the tail that
+    // was moved past the dropped chunks
+    _draining.swap(_dropped);
+    _epoch.store(epoch ^ 1, std::memory_order_seq_cst);
+    if (_active[epoch].load(std::memory_order_seq_cst) == 0)
+      _draining.clear();
+  }
+
+  // Find the chunk that holds the slot with the given index, adding chunks to
+  // the end of the store if they do not exist yet
+  Chunk* chunk_for(uint64_t index) const
+  {
+    Chunk* chunk = _tail.load(std::memory_order_acquire);
+
+    // A thread that claimed its slot a while ago may find that other threads
+    // have already moved the tail past its chunk
+    while (index < chunk->first)
+      chunk = chunk->previous;
+
+    while (index >= chunk->first + ChunkSize)
+    {
+      Chunk* next = chunk->_next.load(std::memory_order_acquire);
+      chunk = next ? next : link_after(chunk);
+    }
+
+    return chunk;
+  }
+
+  // Make sure that a chunk follows the given one and return it. When several
+  // threads race to do this, one of them wins and the rest use its chunk.
+  Chunk* link_after(Chunk* chunk) const
+  {
+    Chunk* expected = nullptr;
+    auto fresh = make_chunk(chunk->first + ChunkSize, chunk);
+    if (!chunk->_next.compare_exchange_strong(
+        expected, fresh.get(), std::memory_order_acq_rel))
+    {
+      return expected;
+    }
+
+    // The tail is only a hint for where to start looking, but it must never
+    // move backwards, or it could end up on a chunk that has been dropped
+    Chunk* tail = _tail.load(std::memory_order_acquire);
+    while (tail->first < fresh->first
+      && !_tail.compare_exchange_weak(
+        tail, fresh.get(), std::memory_order_acq_rel))
+    {
+      // Keep trying
+    }
+
+    return fresh.release();
+  }
+
+  UniqueChunk make_chunk(uint64_t first, Chunk* previous) const
+  {
+    void* memory = _memory->allocate(sizeof(Chunk), alignof(Chunk));
+    return UniqueChunk(new (memory) Chunk(first, previous), {_memory});
+  }
+
+  // The control block comes from the same resource as the chunk
+  std::shared_ptr<Chunk> share(UniqueChunk chunk) const
+  {
+    return std::shared_ptr<Chunk>(
+      chunk.release(), ChunkDeleter{_memory},
+      std::pmr::polymorphic_allocator<Chunk>(_memory));
+  }
+
+  struct Frontier
+  {
+    std::shared_ptr<Chunk> chunk;
+    std::size_t index;
+  };
+
+  std::function<rmf_traffic::Time()> _clock;
+  std::pmr::memory_resource* _memory;
+
+  mutable std::atomic<Chunk*> _tail = nullptr;
+  std::atomic_uint64_t _claimed = 0;
+  mutable std::atomic_uint _epoch = 0;
+  mutable std::array<std::atomic_uint64_t, 2> _active = {0, 0};
+
+  // Everything below is guarded by the publishing mutex. The head is the
+  // oldest chunk that is kept, the frontier is the first slot that has not
+  // been published yet, and the last is the last slot that has been.
+  mutable std::mutex _publish_mutex;
+  mutable std::shared_ptr<Chunk> _head;
+  mutable Frontier _frontier;
+  mutable std::optional<Frontier> _last;
+  mutable std::size_t _bytes = 0;
+  Log::Retention _retention;
+
+  // Chunks that were dropped during the current epoch, and chunks that were
+  // dropped before it, which are released once every push of the previous
+  // epoch is done
+  mutable std::vector<std::shared_ptr<Chunk>> _dropped;
+  mutable std::vector<std::shared_ptr<Chunk>> _draining;
+
+  // What appends dropped chunks to the archive file, and where each chunk that
+  // was given to it begins in the file. These are also guarded by the
+  // publishing mutex.
+  struct IndexEntry
+  {
+    uint64_t first;
+    uint64_t offset;
+  };
+
+  std::shared_ptr<ArchiveWriter> _archive;
+  mutable std::vector<IndexEntry> _archive_index;
+};
+
+//==============================================================================
+// Keeps a store alive along with one of its chunks, and therefore every entry
+// from the start of that chunk onwards. The chunk is let go of through the
+// store so that it is never freed while the store is publishing.
+class ChunkPin
+{
+public:
+
+  ChunkPin(
+    std::shared_ptr<const EntryStore> store_,
+    std::shared_ptr<const EntryStore::Chunk> chunk_)
+  : store(std::move(store_)),
+    chunk(std::move(chunk_))
+  {
+    // Do nothing
+  }
+
+  ChunkPin(const ChunkPin&) = default;
+  ChunkPin(ChunkPin&&) = default;
+
+  ChunkPin& operator=(const ChunkPin& other)
+  {
+    ChunkPin copy(other);
+    std::swap(store, copy.store);
+    std::swap(chunk, copy.chunk);
+    return *this;
+  }
+
+  ChunkPin& operator=(ChunkPin&& other)
+  {
+    ChunkPin moved(std::move(other));
+    std::swap(store, moved.store);
+    std::swap(chunk, moved.chunk);
+    return *this;
+  }
+
+  ~ChunkPin()
+  {
+    if (chunk)
+      store->release(chunk);
+  }
+
+  std::shared_ptr<const EntryStore> store;
+  std::shared_ptr<const EntryStore::Chunk> chunk;
+};
+
+//==============================================================================
+// Rank the tiers from least to most serious. Debug comes after Error in the
+// enum so that the other tiers keep their numbers.
+uint32_t seriousness(Log::Tier tier)
+{
+  switch (tier)
+  {
+    case Log::Tier::Debug:
+      return 1;
+    case Log::Tier::Info:
+      return 2;
+    case Log::Tier::Warning:
+      return 3;
+    case Log::Tier::Error:
+      return 4;
+    default:
+      return 0;
+  }
+}
+
+//==============================================================================
+const char* tier_name(Log::Tier tier)
+{
+  switch (tier)
+  {
+    case Log::Tier::Info:
+      return "info";
+    case Log::Tier::Warning:
+      return "warning";
+    case Log::Tier::Error:
+      return "error";
+    case Log::Tier::Debug:
+      return "debug";
+    default:
+      return "uninitialized";
+  }
+}
+
+//==============================================================================
+void append_json_line(const Log::Entry& entry, std::string& buffer)
+{
+  const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(
+    entry.time().time_since_epoch()).count();
+
+  buffer.append("{\"seq\":");
+  append_number(entry.seq(), buffer);
+  buffer.append(",\"tier\":\"");
+  buffer.append(tier_name(entry.tier()));
+  buffer.append("\",\"unix_millis_time\":");
+  append_number(millis, buffer);
+  buffer.append(",\"text\":");
+  append_json_string(entry.text(), buffer);
+  buffer.append("}\n");
+}
+
+//==============================================================================
+void append_binary(const Log::Entry& entry, std::string& buffer)
+{
+  append_raw<uint32_t>(entry.seq(), buffer);
+  append_raw<uint32_t>(static_cast<uint32_t>(entry.tier()), buffer);
+  append_raw<int64_t>(
+    std::chrono::duration_cast<std::chrono::nanoseconds>(
+      entry.time().time_since_epoch()).count(), buffer);
+  append_raw<uint32_t>(static_cast<uint32_t>(entry.text().size()), buffer);
+  buffer.append(entry.text());
+}
+} // anonymous namespace
+
 //==============================================================================
 class Log::Implementation
 {
 public:
   std::function<rmf_traffic::Time()> clock;
-  std::shared_ptr<std::list<Log::Entry>> entries;
-  mutable std::mutex mutex;
-  uint32_t seq = 0;
+  std::shared_ptr<EntryStore> entries;
+  std::atomic<Tier> threshold = Tier::Info;
 
-  Implementation(std::function<rmf_traffic::Time()> clock_)
-  : clock(std::move(clock_)),
-    entries(std::make_shared<std::list<Log::Entry>>())
+  Implementation(
+    std::function<rmf_traffic::Time()> clock_,
+    std::pmr::memory_resource* memory = nullptr)
+  : clock(std::move(clock_))
   {
     if (!clock)
     {
@@ -48,6 +949,8 @@ public:
               std::chrono::system_clock::now().time_since_epoch()));
         };
     }
+
+    entries = std::make_shared<EntryStore>(clock, memory);
   }
 
 };
@@ -75,6 +978,11 @@ public:
     return output;
   }
 
+  static void set_seq(Entry& entry, uint32_t seq)
+  {
+    entry._pimpl->seq = seq;
+  }
+
   Tier tier;
   uint32_t seq;
   rmf_traffic::Time time;
@@ -82,6 +990,31 @@ public:
 
 };
 
+namespace {
+//==============================================================================
+void EntryStore::report(std::string text)
+{
+  auto entry = Log::Entry::Implementation::make(
+    Log::Tier::Error, 0, _clock(), std::move(text));
+  push(
+    [&](uint64_t index)
+    {
+      Log::Entry::Implementation::set_seq(entry, static_cast<uint32_t>(index));
+      return std::move(entry);
+    });
+}
+} // anonymous namespace
+
+//==============================================================================
+class Log::Retention::Implementation
+{
+public:
+  std::optional<std::size_t> max_entries;
+  std::optional<std::size_t> max_bytes;
+  std::optional<rmf_traffic::Duration> max_age;
+  std::optional<std::string> archive;
+};
+
 //==============================================================================
 class Log::View::Implementation
 {
@@ -91,20 +1024,18 @@ public:
   {
     View output;
 
-    if (log._pimpl->entries->empty())
-    {
-      output._pimpl = rmf_utils::make_impl<Implementation>(
-        Implementation{log._pimpl->entries, std::nullopt, std::nullopt});
-    }
-    else
-    {
-      output._pimpl = rmf_utils::make_impl<Implementation>(
-        Implementation{
-          log._pimpl->entries,
-          log._pimpl->entries->cbegin(),
-          --log._pimpl->entries->cend()
-        });
-    }
+    auto snapshot = log._pimpl->entries->publish();
+    std::optional<EntryStore::Position> begin;
+    if (snapshot.last.has_value())
+      begin = EntryStore::Position{snapshot.oldest.get(), 0};
+
+    output._pimpl = rmf_utils::make_impl<Implementation>(
+      Implementation{
+        log._pimpl->entries,
+        ChunkPin(log._pimpl->entries, std::move(snapshot.oldest)),
+        begin,
+        snapshot.last
+      });
 
     return output;
   }
@@ -114,15 +1045,41 @@ public:
     return *view._pimpl;
   }
 
-  std::shared_ptr<const std::list<Log::Entry>> shared;
+  std::shared_ptr<const EntryStore> shared;
 
-  /// begin is the iterator for the first entry in the entire log
-  std::optional<std::list<Log::Entry>::const_iterator> begin;
+  /// oldest keeps every entry of this view alive, even if the log drops them
+  ChunkPin oldest;
 
-  /// last is the iterator for the last entry that will be provided by this
+  /// begin is the position of the first entry that the log still kept when
+  /// this view was made
+  std::optional<EntryStore::Position> begin;
+
+  /// last is the position of the last entry that will be provided by this
   /// view. This is NOT the usual end() iterator, but instead it is one-before
   /// the usual end() iterator.
-  std::optional<std::list<Log::Entry>::const_iterator> last;
+  std::optional<EntryStore::Position> last;
+
+  std::size_t memory_usage() const
+  {
+    if (!begin.has_value() || !last.has_value())
+      return 0;
+
+    // Each entry is one slot of a chunk, plus its implementation and text
+    const std::size_t entries = last->number() - begin->number() + 1;
+    const std::size_t chunks =
+      (last->chunk->first - begin->chunk->first) / EntryStore::ChunkSize + 1;
+
+    std::size_t text = 0;
+    for (auto it = *begin; ; ++it)
+    {
+      text += it->text().size();
+      if (it == *last)
+        break;
+    }
+
+    return chunks * sizeof(EntryStore::Chunk)
+      + entries * sizeof(Entry::Implementation) + text;
+  }
 };
 
 //==============================================================================
@@ -132,8 +1089,19 @@ public:
 
   struct Memory
   {
-    std::weak_ptr<const std::list<Log::Entry>> weak;
-    std::optional<std::list<Log::Entry>::const_iterator> last;
+    std::weak_ptr<const EntryStore> weak;
+
+    /// The number of the next entry that this reader has not read yet
+    uint64_t next = 0;
+
+    /// The last entry that this reader read. This is only valid while next is
+    /// not older than the beginning of the view being read, because only then
+    /// is its chunk being kept alive by that view.
+    std::optional<EntryStore::Position> last;
+
+    /// The ranges of entry numbers that were archived before this reader
+    /// could read them, and have not been paged in yet
+    std::vector<std::pair<uint64_t, uint64_t>> archived;
 
     Memory()
     {
@@ -144,27 +1112,48 @@ public:
   std::unordered_map<const void*, Memory> memories;
 
   Iterable read(const View& view);
+
+  std::size_t read_into(
+    const View& view,
+    std::string& buffer,
+    Format format);
+
+  std::vector<Entry> read_archived(const View& view, std::size_t max_entries);
+
+  // Collect the entries of an archive that fall within [range.first,
+  // range.second), reading from the given span of the file. The range is moved
+  // past the entries that were collected, or past its end if the rest of it is
+  // not in the archive.
+  static void read_archive(
+    const EntryStore::ArchiveSpan& span,
+    std::pair<uint64_t, uint64_t>& range,
+    std::size_t max_entries,
+    std::vector<Entry>& entries);
 };
 
 //==============================================================================
 class Log::Reader::Iterable::Implementation
 {
 public:
-  using base_iterator = std::list<Log::Entry>::const_iterator;
-  std::shared_ptr<const std::list<Log::Entry>> shared;
+  using base_iterator = EntryStore::Position;
+  std::shared_ptr<const EntryStore> shared;
+  std::optional<ChunkPin> oldest;
   std::optional<iterator> begin;
+  std::size_t dropped = 0;
 
   static Log::Reader::Iterable make(
-    std::shared_ptr<const std::list<Log::Entry>> shared,
+    std::shared_ptr<const EntryStore> shared,
+    std::optional<ChunkPin> oldest,
     std::optional<base_iterator> begin,
-    std::optional<base_iterator> last);
+    std::optional<base_iterator> last,
+    std::size_t dropped);
 };
 
 //==============================================================================
 class Log::Reader::Iterable::iterator::Implementation
 {
 public:
-  using base_iterator = std::list<Log::Entry>::const_iterator;
+  using base_iterator = EntryStore::Position;
   base_iterator it;
   base_iterator last;
 
@@ -185,13 +1174,17 @@ public:
 
 //==============================================================================
 Log::Reader::Iterable Log::Reader::Iterable::Implementation::make(
-  std::shared_ptr<const std::list<Log::Entry>> shared,
+  std::shared_ptr<const EntryStore> shared,
+  std::optional<ChunkPin> oldest,
   std::optional<base_iterator> begin,
-  std::optional<base_iterator> last_in_view)
+  std::optional<base_iterator> last_in_view,
+  std::size_t dropped)
 {
   Iterable iterable;
   iterable._pimpl = rmf_utils::make_impl<Implementation>();
   iterable._pimpl->shared = std::move(shared);
+  iterable._pimpl->oldest = std::move(oldest);
+  iterable._pimpl->dropped = dropped;
   if (begin.has_value())
   {
     iterable._pimpl->begin =
@@ -211,50 +1204,178 @@ auto Log::Reader::Implementation::read(const View& view) -> Iterable
   const auto& v = View::Implementation::get(view);
   const auto it = memories.insert({v.shared.get(), Memory()}).first;
   auto& memory = it->second;
-  if (memory.weak.lock())
+  if (!memory.weak.lock())
   {
-    if (!memory.last.has_value())
-    {
-      memory.last = v.begin;
-    }
-    else if (v.last.has_value())
+    // Reset this memory, because it points at an expired log whose memory
+    // address is being recycled.
+    memory = Memory();
+    memory.weak = v.shared;
+  }
+
+  if (!v.last.has_value() || memory.next > v.last->number())
+  {
+    // Either the view is empty, or this reader has already read everything
+    // in it, so we will return an empty iterable.
+    return Iterable::Implementation::make(
+      v.shared, std::nullopt, std::nullopt, std::nullopt, 0);
+  }
+
+  std::optional<EntryStore::Position> begin;
+  std::size_t dropped = 0;
+  if (memory.next <= v.begin->number())
+  {
+    // Anything between the last read and the beginning of this view was
+    // dropped by the retention policy of the log before we could read it.
+    dropped = static_cast<std::size_t>(v.begin->number() - memory.next);
+    begin = v.begin;
+
+    if (dropped > 0 && v.shared->archiving())
     {
-      if ((*memory.last)->seq() >= (*v.last)->seq())
-      {
-        // If the last memory of this reader is more recent than this view, then
-        // we will return an empty iterable.
-        return Iterable::Implementation::make(
-          v.shared, std::nullopt, std::nullopt);
-      }
+      auto& archived = memory.archived;
+      if (!archived.empty() && archived.back().second == memory.next)
+        archived.back().second = v.begin->number();
       else
-      {
-        // If the last memory of this reader is behind the last value in the
-        // view, then we will move it forward by one.
-        ++(*memory.last);
-      }
+        archived.push_back({memory.next, v.begin->number()});
     }
+  }
+  else
+  {
+    // The last entry we read is still in this view, so we will move forward
+    // from it by one.
+    begin = memory.last;
+    ++(*begin);
+  }
+
+  memory.next = v.last->number() + 1;
+  memory.last = v.last;
+
+  return Iterable::Implementation::make(
+    v.shared, v.oldest, begin, v.last, dropped);
+}
+
+//==============================================================================
+std::size_t Log::Reader::Implementation::read_into(
+  const View& view,
+  std::string& buffer,
+  Format format)
+{
+  const auto iterable = read(view);
+
+  // Grow the buffer once for everything that will be written. The JSON
+  // fields take less than 100 bytes on top of the text, unless the text has
+  // characters that need to be escaped.
+  const std::size_t overhead = Format::Binary == format ?
+    3*sizeof(uint32_t) + sizeof(int64_t) : 100;
+  std::size_t count = 0;
+  std::size_t size = 0;
+  for (const auto& entry : iterable)
+  {
+    size += overhead + entry.text().size();
+    ++count;
+  }
+
+  buffer.reserve(buffer.size() + size);
+  for (const auto& entry : iterable)
+  {
+    if (Format::Binary == format)
+      append_binary(entry, buffer);
     else
+      append_json_line(entry, buffer);
+  }
+
+  return count;
+}
+
+//==============================================================================
+void Log::Reader::Implementation::read_archive(
+  const EntryStore::ArchiveSpan& span,
+  std::pair<uint64_t, uint64_t>& range,
+  std::size_t max_entries,
+  std::vector<Entry>& entries)
+{
+  std::ifstream file(span.path, std::ios::binary);
+  file.seekg(static_cast<std::streamoff>(span.offset));
+
+  uint64_t offset = span.offset;
+  const auto take = [&](auto& value) -> bool
     {
-      // The view is missing a "last" value, meaning it's an empty view.
-      // TODO(MXG): We should write explicit unit tests for this.
-      return Iterable::Implementation::make(
-        v.shared, std::nullopt, std::nullopt);
+      return static_cast<bool>(
+        file.read(reinterpret_cast<char*>(&value), sizeof(value)));
+    };
+
+  while (offset < span.end && max_entries > 0)
+  {
+    uint32_t size = 0;
+    uint64_t number = 0;
+    if (!take(size) || !take(number))
+      break;
+
+    offset += sizeof(size) + size;
+    if (number < range.first)
+    {
+      file.seekg(static_cast<std::streamoff>(offset));
+      continue;
     }
+
+    if (number >= range.second)
+      break;
+
+    uint32_t seq = 0;
+    uint32_t tier = 0;
+    int64_t nanos = 0;
+    uint32_t text_size = 0;
+    if (!take(seq) || !take(tier) || !take(nanos) || !take(text_size))
+      break;
+
+    std::string text(text_size, '\0');
+    if (!file.read(text.data(), text_size))
+      break;
+
+    entries.push_back(
+      Entry::Implementation::make(
+        static_cast<Tier>(tier), seq,
+        rmf_traffic::Time(std::chrono::nanoseconds(nanos)),
+        std::move(text)));
+    range.first = number + 1;
+    --max_entries;
   }
-  else
+
+  if (max_entries > 0)
   {
-    // Reset this memory, because it points at an expired list whose memory
-    // address is being recycled.
-    memory.weak = v.shared;
-    memory.last = v.begin;
+    // The rest of the range is not in the archive
+    range.first = range.second;
   }
+}
 
-  auto iterable = Iterable::Implementation::make(
-    v.shared, memory.last, v.last);
+//==============================================================================
+auto Log::Reader::Implementation::read_archived(
+  const View& view,
+  std::size_t max_entries) -> std::vector<Entry>
+{
+  std::vector<Entry> entries;
+  const auto& v = View::Implementation::get(view);
+  const auto it = memories.find(v.shared.get());
+  if (it == memories.end() || it->second.weak.lock() != v.shared)
+    return entries;
 
-  memory.last = v.last;
+  auto& archived = it->second.archived;
+  while (!archived.empty() && entries.size() < max_entries)
+  {
+    auto& range = archived.front();
+    if (const auto span = v.shared->locate(range.first))
+    {
+      read_archive(*span, range, max_entries - entries.size(), entries);
+    }
+    else
+    {
+      range.first = range.second;
+    }
 
-  return iterable;
+    if (range.first >= range.second)
+      archived.erase(archived.begin());
+  }
+
+  return entries;
 }
 
 //==============================================================================
@@ -264,6 +1385,21 @@ Log::Log(std::function<rmf_traffic::Time()> clock)
   // Do nothing
 }
 
+//==============================================================================
+Log::Log(
+  std::function<rmf_traffic::Time()> clock,
+  std::pmr::memory_resource* memory)
+: _pimpl(rmf_utils::make_unique_impl<Implementation>(std::move(clock), memory))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void Log::debug(std::string text)
+{
+  push(Tier::Debug, std::move(text));
+}
+
 //==============================================================================
 void Log::info(std::string text)
 {
@@ -293,25 +1429,82 @@ void Log::push(Tier tier, std::string text)
     // *INDENT-ON*
   }
 
-  std::lock_guard<std::mutex> lock(_pimpl->mutex);
-  _pimpl->entries->emplace_back(
-    Entry::Implementation::make(
-      tier, _pimpl->seq++, _pimpl->clock(), std::move(text)));
+  if (!enabled(tier))
+    return;
+
+  // The sequence number counts every entry before this one, whether it was
+  // pushed or inserted, so entries always appear in the order of their seq.
+  // It wraps around to 0 when it overflows.
+  // The entry is made before its slot is claimed, so nothing can throw
+  // between claiming the slot and filling it.
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Log);
+  auto entry = Entry::Implementation::make(
+    tier, 0, _pimpl->clock(), std::move(text));
+  _pimpl->entries->push(
+    [&](uint64_t index)
+    {
+      Entry::Implementation::set_seq(entry, static_cast<uint32_t>(index));
+      return std::move(entry);
+    });
 }
 
 //==============================================================================
 void Log::insert(Log::Entry entry)
 {
-  _pimpl->entries->emplace_back(std::move(entry));
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Log);
+  _pimpl->entries->push([&](uint64_t) { return std::move(entry); });
 }
 
 //==============================================================================
 Log::View Log::view() const
 {
-  std::lock_guard<std::mutex> lock(_pimpl->mutex);
   return View::Implementation::make(*this);
 }
 
+//==============================================================================
+uint64_t Log::entry_count() const
+{
+  return _pimpl->entries->claimed();
+}
+
+//==============================================================================
+std::size_t Log::memory_usage() const
+{
+  return view().memory_usage();
+}
+
+//==============================================================================
+Log& Log::threshold(Tier tier)
+{
+  _pimpl->threshold.store(tier, std::memory_order_relaxed);
+  return *this;
+}
+
+//==============================================================================
+auto Log::threshold() const -> Tier
+{
+  return _pimpl->threshold.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+bool Log::enabled(Tier tier) const
+{
+  return seriousness(tier) >= seriousness(threshold());
+}
+
+//==============================================================================
+Log& Log::retention(Retention value)
+{
+  _pimpl->entries->retention(std::move(value));
+  return *this;
+}
+
+//==============================================================================
+auto Log::retention() const -> Retention
+{
+  return _pimpl->entries->retention();
+}
+
 //==============================================================================
 auto Log::Entry::tier() const -> Tier
 {
@@ -342,6 +1535,74 @@ Log::Entry::Entry()
   // Do nothing
 }
 
+//==============================================================================
+Log::Retention::Retention()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto Log::Retention::max_entries(std::optional<std::size_t> value)
+-> Retention&
+{
+  _pimpl->max_entries = value;
+  return *this;
+}
+
+//==============================================================================
+std::optional<std::size_t> Log::Retention::max_entries() const
+{
+  return _pimpl->max_entries;
+}
+
+//==============================================================================
+auto Log::Retention::max_bytes(std::optional<std::size_t> value)
+-> Retention&
+{
+  _pimpl->max_bytes = value;
+  return *this;
+}
+
+//==============================================================================
+std::optional<std::size_t> Log::Retention::max_bytes() const
+{
+  return _pimpl->max_bytes;
+}
+
+//==============================================================================
+auto Log::Retention::max_age(std::optional<rmf_traffic::Duration> value)
+-> Retention&
+{
+  _pimpl->max_age = value;
+  return *this;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration> Log::Retention::max_age() const
+{
+  return _pimpl->max_age;
+}
+
+//==============================================================================
+auto Log::Retention::archive(std::optional<std::string> path) -> Retention&
+{
+  _pimpl->archive = std::move(path);
+  return *this;
+}
+
+//==============================================================================
+const std::optional<std::string>& Log::Retention::archive() const
+{
+  return _pimpl->archive;
+}
+
+//==============================================================================
+std::size_t Log::View::memory_usage() const
+{
+  return _pimpl->memory_usage();
+}
+
 //==============================================================================
 Log::View::View()
 {
@@ -361,6 +1622,36 @@ auto Log::Reader::read(const View& view) -> Iterable
   return _pimpl->read(view);
 }
 
+//==============================================================================
+std::size_t Log::Reader::read_into(
+  const View& view,
+  std::string& buffer,
+  Format format)
+{
+  return _pimpl->read_into(view, buffer, format);
+}
+
+//==============================================================================
+std::vector<std::size_t> Log::Reader::read_into(
+  const std::vector<View>& views,
+  std::string& buffer,
+  Format format)
+{
+  std::vector<std::size_t> counts;
+  counts.reserve(views.size());
+  for (const auto& view : views)
+    counts.push_back(_pimpl->read_into(view, buffer, format));
+
+  return counts;
+}
+
+//==============================================================================
+auto Log::Reader::read_archived(const View& view, std::size_t max_entries)
+-> std::vector<Entry>
+{
+  return _pimpl->read_archived(view, max_entries);
+}
+
 //==============================================================================
 auto Log::Reader::Iterable::begin() const -> iterator
 {
@@ -373,6 +1664,12 @@ auto Log::Reader::Iterable::end() const -> iterator
   return iterator::Implementation::end();
 }
 
+//==============================================================================
+std::size_t Log::Reader::Iterable::dropped() const
+{
+  return _pimpl->dropped;
+}
+
 //==============================================================================
 auto Log::Reader::Iterable::iterator::operator*() const -> const Entry&
 {
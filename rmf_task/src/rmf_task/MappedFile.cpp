@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "MappedFile.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rmf_task {
+
+#ifdef __linux__
+//==============================================================================
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& filename)
+{
+  const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return nullptr;
+
+  struct stat info;
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+  {
+    ::close(fd);
+    return nullptr;
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+  // The mapping stays valid after the descriptor is closed
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  return std::shared_ptr<MappedFile>(new MappedFile(data, size));
+}
+
+//==============================================================================
+std::shared_ptr<MappedFile> MappedFile::create(
+  const std::string& filename,
+  std::size_t size)
+{
+  if (size == 0)
+    return nullptr;
+
+  const int fd = ::open(
+    filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return nullptr;
+
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+  {
+    ::close(fd);
+    return nullptr;
+  }
+
+  void* data = ::mmap(
+    nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+    return nullptr;
+
+  return std::shared_ptr<MappedFile>(new MappedFile(data, size));
+}
+
+//==============================================================================
+MappedFile::~MappedFile()
+{
+  ::munmap(_data, _size);
+}
+
+//==============================================================================
+FileLock::FileLock(const std::string& filename)
+{
+  const int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return;
+
+  if (::flock(fd, LOCK_EX) != 0)
+  {
+    ::close(fd);
+    return;
+  }
+
+  _fd = fd;
+}
+
+//==============================================================================
+FileLock::~FileLock()
+{
+  if (_fd >= 0)
+  {
+    ::flock(_fd, LOCK_UN);
+    ::close(_fd);
+  }
+}
+#else
+//==============================================================================
+std::shared_ptr<MappedFile> MappedFile::open(const std::string&)
+{
+  return nullptr;
+}
+
+//==============================================================================
+std::shared_ptr<MappedFile> MappedFile::create(const std::string&, std::size_t)
+{
+  return nullptr;
+}
+
+//==============================================================================
+MappedFile::~MappedFile()
+{
+  // Nothing was mapped
+}
+
+//==============================================================================
+FileLock::FileLock(const std::string&)
+{
+  // Locking is not supported, so locked() stays false
+}
+
+//==============================================================================
+FileLock::~FileLock()
+{
+  // Do nothing
+}
+#endif
+
+//==============================================================================
+MappedFile::MappedFile(void* data, std::size_t size)
+: _data(data),
+  _size(size)
+{
+  // Do nothing
+}
+
+} // namespace rmf_task
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__MAPPEDFILE_HPP
+#define SRC__RMF_TASK__MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace rmf_task {
+
+//==============================================================================
+// A file that is mapped into memory with a shared mapping, so every process
+// that maps the same file sees the same pages. Mapping is only supported on
+// Linux. On other platforms, and whenever the file cannot be opened or mapped,
+// the factories return nullptr.
+class MappedFile
+{
+public:
+
+  // Map an existing file for reading
+  static std::shared_ptr<MappedFile> open(const std::string& filename);
+
+  // Create or truncate a file of the given size, filled with zeros, and map
+  // it for reading and writing
+  static std::shared_ptr<MappedFile> create(
+    const std::string& filename,
+    std::size_t size);
+
+  void* data() const
+  {
+    return _data;
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+private:
+  MappedFile(void* data, std::size_t size);
+
+  void* _data;
+  std::size_t _size;
+};
+
+//==============================================================================
+// Holds an exclusive advisory lock on a file for as long as it exists. The
+// file is created if it does not exist yet. Other processes that lock the same
+// file wait until this lock is released.
+class FileLock
+{
+public:
+
+  explicit FileLock(const std::string& filename);
+
+  // Whether the lock was acquired
+  bool locked() const
+  {
+    return _fd >= 0;
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+  ~FileLock();
+
+private:
+  int _fd = -1;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__MAPPEDFILE_HPP
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/MemoryUsage.hpp>
+
+namespace rmf_task {
+
+//==============================================================================
+MemoryUsage::MemoryUsage()
+: _bytes{}
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::size_t MemoryUsage::bytes(Component component) const
+{
+  return _bytes[static_cast<std::size_t>(component)];
+}
+
+//==============================================================================
+std::size_t MemoryUsage::total() const
+{
+  std::size_t total = 0;
+  for (const auto b : _bytes)
+    total += b;
+
+  return total;
+}
+
+//==============================================================================
+MemoryUsage& MemoryUsage::add(Component component, std::size_t bytes)
+{
+  _bytes[static_cast<std::size_t>(component)] += bytes;
+  return *this;
+}
+
+//==============================================================================
+MemoryUsage& MemoryUsage::add(const MemoryUsage& other)
+{
+  for (std::size_t c = 0; c < NumComponents; ++c)
+    _bytes[c] += other._bytes[c];
+
+  return *this;
+}
+
+} // namespace rmf_task
@@ -0,0 +1,364 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/MultiFleetPlanner.hpp>
+#include <rmf_task/BinaryPriorityScheme.hpp>
+#include <rmf_task/requests/ChargeBattery.hpp>
+
+#include "CostCalculator.hpp"
+#include "internal_task_planning.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+namespace rmf_task {
+
+//==============================================================================
+class MultiFleetPlanner::Implementation
+{
+public:
+
+  std::string planner_id;
+  std::vector<TaskPlanner> fleets;
+  TaskPlanner::Options default_options;
+
+  // The estimates of one request for the agents of one fleet
+  struct Bids
+  {
+    Task::ConstModelPtr model;
+    std::vector<std::shared_ptr<const Candidates::Entry>> entries;
+  };
+
+  std::shared_ptr<const Candidates::Entry> estimate(
+    std::size_t fleet,
+    std::size_t agent,
+    rmf_traffic::Time time_now,
+    const State& state,
+    const Task::Model& model,
+    const Task::Model& charging_model,
+    TaskPlanner::TaskPlannerError& error) const
+  {
+    const auto& planner = fleets[fleet];
+    const auto& config = planner.configuration();
+    return Candidates::estimate(
+      agent, time_now, state, config.constraints(), config.parameters(),
+      model, *planner.travel_estimator(), planner_id, error, nullptr,
+      &charging_model);
+  }
+
+  // The cost of giving a request to an agent of a fleet, according to the
+  // cost calculator of that fleet
+  static double cost(
+    const CostCalculator& cost_calculator,
+    const ConstRequestPtr& request,
+    const Candidates::Entry& entry)
+  {
+    return cost_calculator.compute_assignment_cost(
+      TaskPlanner::Assignment(request, entry.state, entry.wait_until));
+  }
+
+  // Give each request to a fleet greedily. Requests with a priority are given
+  // out before the rest if any fleet orders its assignments by priority. Of
+  // the requests that are left, the one whose assignment to some agent costs
+  // the least is given to that agent's fleet, and the agent moves on to the
+  // state that the request leaves it in. Excluded fleets are given nothing.
+  std::variant<std::vector<std::size_t>, TaskPlanner::TaskPlannerError>
+  allocate(
+    rmf_traffic::Time time_now,
+    const std::vector<std::vector<State>>& agents,
+    const std::vector<ConstRequestPtr>& requests,
+    const std::vector<bool>& excluded) const
+  {
+    const std::size_t num_fleets = fleets.size();
+    std::vector<Task::ConstModelPtr> charging_models;
+    std::vector<ConstCostCalculatorPtr> cost_calculators;
+    bool orders_priorities = false;
+    for (const auto& planner : fleets)
+    {
+      const auto& config = planner.configuration();
+      charging_models.push_back(
+        requests::ChargeBattery::Description::make()->make_model(
+          rmf_traffic::Time(), config.parameters()));
+
+      cost_calculators.push_back(
+        config.cost_calculator() ? config.cost_calculator() :
+        BinaryPriorityScheme::make_cost_calculator());
+      orders_priorities =
+        orders_priorities || cost_calculators.back()->orders_priorities();
+    }
+
+    std::vector<bool> prioritized(requests.size(), false);
+    if (orders_priorities)
+    {
+      for (std::size_t r = 0; r < requests.size(); ++r)
+        prioritized[r] = requests[r]->booking()->priority() != nullptr;
+    }
+
+    // bids[r][f] holds the estimates of request r for the agents of fleet f
+    std::vector<std::vector<Bids>> bids(requests.size());
+    std::vector<std::size_t> allocation(requests.size(), num_fleets);
+    for (std::size_t r = 0; r < requests.size(); ++r)
+    {
+      const auto& request = requests[r];
+      const auto earliest_start_time = std::max(
+        time_now, request->booking()->earliest_start_time());
+
+      TaskPlanner::TaskPlannerError error =
+        TaskPlanner::TaskPlannerError::limited_capacity;
+      std::optional<double> best;
+      for (std::size_t f = 0; f < num_fleets; ++f)
+      {
+        Bids fleet_bids;
+        if (excluded[f])
+        {
+          bids[r].push_back(std::move(fleet_bids));
+          continue;
+        }
+
+        fleet_bids.model = request->description()->make_model(
+          earliest_start_time, fleets[f].configuration().parameters());
+
+        for (std::size_t a = 0; a < agents[f].size(); ++a)
+        {
+          auto entry = estimate(
+            f, a, time_now, agents[f][a], *fleet_bids.model,
+            *charging_models[f], error);
+
+          if (entry)
+          {
+            const double c = cost(*cost_calculators[f], request, *entry);
+            if (!best.has_value() || c < *best)
+            {
+              best = c;
+              allocation[r] = f;
+            }
+          }
+
+          fleet_bids.entries.push_back(std::move(entry));
+        }
+
+        bids[r].push_back(std::move(fleet_bids));
+      }
+
+      if (!best.has_value())
+        return error;
+    }
+
+    // Until a request is chosen, allocation holds the fleet that it was first
+    // estimated best for. That fleet keeps any request that no agent can
+    // perform anymore once the others have moved on, since its TaskPlanner
+    // may still fit it in by charging or reordering.
+    std::vector<bool> chosen(requests.size(), false);
+    auto states = agents;
+    for (std::size_t n = 0; n < requests.size(); ++n)
+    {
+      std::optional<std::pair<bool, double>> best;
+      std::size_t best_request = 0;
+      std::size_t best_fleet = 0;
+      std::size_t best_agent = 0;
+      for (std::size_t r = 0; r < requests.size(); ++r)
+      {
+        if (chosen[r])
+          continue;
+
+        for (std::size_t f = 0; f < num_fleets; ++f)
+        {
+          const auto& entries = bids[r][f].entries;
+          for (std::size_t a = 0; a < entries.size(); ++a)
+          {
+            if (!entries[a])
+              continue;
+
+            // Prioritized requests come first, whatever they cost
+            const std::pair<bool, double> rank{
+              !prioritized[r],
+              cost(*cost_calculators[f], requests[r], *entries[a])};
+            if (!best.has_value() || rank < *best)
+            {
+              best = rank;
+              best_request = r;
+              best_fleet = f;
+              best_agent = a;
+            }
+          }
+        }
+      }
+
+      if (!best.has_value())
+        break;
+
+      chosen[best_request] = true;
+      allocation[best_request] = best_fleet;
+      states[best_fleet][best_agent] =
+        bids[best_request][best_fleet].entries[best_agent]->state;
+
+      // Only the estimates of the agent that moved on are out of date
+      for (std::size_t r = 0; r < requests.size(); ++r)
+      {
+        if (chosen[r])
+          continue;
+
+        auto& fleet_bids = bids[r][best_fleet];
+        TaskPlanner::TaskPlannerError error;
+        fleet_bids.entries[best_agent] = estimate(
+          best_fleet, best_agent, time_now, states[best_fleet][best_agent],
+          *fleet_bids.model, *charging_models[best_fleet], error);
+      }
+    }
+
+    return allocation;
+  }
+};
+
+//==============================================================================
+MultiFleetPlanner::MultiFleetPlanner(
+  const std::string& planner_id,
+  std::vector<TaskPlanner::Configuration> configurations,
+  TaskPlanner::Options default_options)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{planner_id, {}, default_options}))
+{
+  if (configurations.empty())
+  {
+    throw std::invalid_argument(
+      "[rmf_task::MultiFleetPlanner::MultiFleetPlanner] At least one "
+      "fleet configuration is needed");
+  }
+
+  _pimpl->fleets.reserve(configurations.size());
+  for (auto& configuration : configurations)
+  {
+    _pimpl->fleets.emplace_back(
+      planner_id, std::move(configuration), default_options);
+  }
+}
+
+//==============================================================================
+std::size_t MultiFleetPlanner::num_fleets() const
+{
+  return _pimpl->fleets.size();
+}
+
+//==============================================================================
+const TaskPlanner& MultiFleetPlanner::fleet(std::size_t index) const
+{
+  return _pimpl->fleets.at(index);
+}
+
+//==============================================================================
+const TaskPlanner::Options& MultiFleetPlanner::default_options() const
+{
+  return _pimpl->default_options;
+}
+
+//==============================================================================
+TaskPlanner::Options& MultiFleetPlanner::default_options()
+{
+  return _pimpl->default_options;
+}
+
+//==============================================================================
+auto MultiFleetPlanner::plan(
+  rmf_traffic::Time time_now,
+  std::vector<std::vector<State>> agents,
+  std::vector<ConstRequestPtr> requests) -> Result
+{
+  return plan(
+    time_now,
+    std::move(agents),
+    std::move(requests),
+    _pimpl->default_options);
+}
+
+//==============================================================================
+auto MultiFleetPlanner::plan(
+  rmf_traffic::Time time_now,
+  std::vector<std::vector<State>> agents,
+  std::vector<ConstRequestPtr> requests,
+  TaskPlanner::Options options) -> Result
+{
+  const std::size_t num_fleets = _pimpl->fleets.size();
+  if (agents.size() != num_fleets)
+  {
+    throw std::invalid_argument(
+      "[rmf_task::MultiFleetPlanner::plan] The agents of "
+      + std::to_string(agents.size()) + " fleets were given to a "
+      "planner of " + std::to_string(num_fleets) + " fleets");
+  }
+
+  // A fleet that fails to plan its share is excluded, and the requests are
+  // allocated again between the fleets that are left
+  std::vector<bool> excluded(num_fleets, false);
+  std::size_t remaining = 0;
+  for (const auto& fleet_agents : agents)
+  {
+    if (!fleet_agents.empty())
+      ++remaining;
+  }
+
+  while (true)
+  {
+    auto allocation = _pimpl->allocate(time_now, agents, requests, excluded);
+    if (const auto* error =
+      std::get_if<TaskPlanner::TaskPlannerError>(&allocation))
+    {
+      return *error;
+    }
+
+    const auto& fleet_of = std::get<std::vector<std::size_t>>(allocation);
+    std::vector<std::vector<ConstRequestPtr>> shares(num_fleets);
+    for (std::size_t r = 0; r < requests.size(); ++r)
+      shares[fleet_of[r]].push_back(requests[r]);
+
+    Assignments assignments;
+    assignments.reserve(num_fleets);
+    std::optional<std::size_t> failed;
+    std::optional<TaskPlanner::TaskPlannerError> error;
+    for (std::size_t f = 0; f < num_fleets; ++f)
+    {
+      if (agents[f].empty() || excluded[f])
+      {
+        assignments.emplace_back(agents[f].size());
+        continue;
+      }
+
+      auto result = _pimpl->fleets[f].plan(
+        time_now, agents[f], std::move(shares[f]), options);
+
+      if (auto* e = std::get_if<TaskPlanner::TaskPlannerError>(&result))
+      {
+        failed = f;
+        error = *e;
+        break;
+      }
+
+      assignments.push_back(
+        std::move(std::get<TaskPlanner::Assignments>(result)));
+    }
+
+    if (!failed.has_value())
+      return assignments;
+
+    excluded[*failed] = true;
+    if (--remaining == 0)
+      return *error;
+  }
+}
+
+} // namespace rmf_task
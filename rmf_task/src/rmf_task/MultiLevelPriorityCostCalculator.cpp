@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "MultiLevelPriorityCostCalculator.hpp"
+#include "InvariantHeuristicQueue.hpp"
+
+#include <rmf_task/MultiLevelPriorityScheme.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <optional>
+
+namespace rmf_task {
+
+//==============================================================================
+MultiLevelPriorityCostCalculator::MultiLevelPriorityCostCalculator(
+  std::vector<double> level_weights)
+: _level_weights(std::move(level_weights))
+{
+  assert(!_level_weights.empty());
+}
+
+//==============================================================================
+const std::vector<double>&
+MultiLevelPriorityCostCalculator::level_weights() const
+{
+  return _level_weights;
+}
+
+//==============================================================================
+std::size_t MultiLevelPriorityCostCalculator::level(
+  const Request& request) const
+{
+  return std::min(
+    MultiLevelPriorityScheme::level(request.booking()->priority()),
+    _level_weights.size() - 1);
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_g(const Node& node) const
+{
+  double cost = 0.0;
+  for (const auto& agent : node.assigned_tasks)
+  {
+    agent.for_each_reverse([&](const Node::AssignmentWrapper& assignment)
+      {
+        cost += compute_assignment_cost(assignment.assignment);
+      });
+  }
+
+  return cost;
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_h(
+  const Node& node, const rmf_traffic::Time time_now) const
+{
+  if (node.unassigned_tasks.empty())
+    return 0.0;
+
+  // Each bucket starts from the same queue, so the initial values are only
+  // sorted once
+  const InvariantHeuristicQueue start(initial_queue_values(node, time_now));
+  std::vector<std::optional<InvariantHeuristicQueue>> buckets(
+    _level_weights.size());
+
+  // The invariants are visited in order of their earliest finish time, so the
+  // invariants of each bucket are also added in that order, which is what the
+  // InvariantHeuristicQueue expects
+  node.unassigned_invariants.for_each([&](const Invariant& u)
+    {
+      const auto* task = node.unassigned_tasks.find(u.task_id);
+      const std::size_t l = task ? level(*task->second.request) : 0;
+      auto& bucket = buckets[l];
+      if (!bucket.has_value())
+        bucket.emplace(start);
+
+      bucket->add(u.earliest_start_time, u.earliest_finish_time);
+    });
+
+  // The requests of each level can finish no sooner than they could without
+  // the requests of the other levels, so each bucket is a lower bound on the
+  // delay of its own level
+  double h = 0.0;
+  for (std::size_t l = 0; l < buckets.size(); ++l)
+  {
+    if (buckets[l].has_value())
+      h += _level_weights[l] * buckets[l]->compute_cost();
+  }
+
+  return h;
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_cost(
+  const Node& n,
+  rmf_traffic::Time time_now,
+  bool) const
+{
+  return compute_g(n) + compute_h(n, time_now);
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_weighted_cost(
+  const Node& n,
+  rmf_traffic::Time time_now,
+  bool,
+  double heuristic_weight) const
+{
+  return compute_g(n) + heuristic_weight * compute_h(n, time_now);
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_cost(
+  rmf_task::TaskPlanner::Assignments assignments) const
+{
+  double cost = 0.0;
+  for (const auto& agent : assignments)
+  {
+    for (const auto& assignment : agent)
+      cost += compute_assignment_cost(assignment);
+  }
+
+  return cost;
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_assignment_cost(
+  const TaskPlanner::Assignment& assignment) const
+{
+  if (assignment.is_charging())
+    return 0.0;
+
+  const auto& request = *assignment.request();
+  return _level_weights[level(request)] * rmf_traffic::time::to_seconds(
+    assignment.finish_state().time().value()
+    - request.booking()->earliest_start_time());
+}
+
+//==============================================================================
+double MultiLevelPriorityCostCalculator::compute_incremental_cost(
+  const Node& n,
+  rmf_traffic::Time time_now,
+  bool,
+  double heuristic_weight) const
+{
+  const double g = n.assigned_cost;
+  assert(std::abs(g - compute_g(n)) <= 1e-6 * std::max(1.0, std::abs(g)));
+
+  return g + heuristic_weight * compute_h(n, time_now);
+}
+
+//==============================================================================
+bool MultiLevelPriorityCostCalculator::orders_priorities() const
+{
+  return false;
+}
+
+} // namespace rmf_task
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__MULTILEVELPRIORITYCOSTCALCULATOR_HPP
+#define SRC__RMF_TASK__MULTILEVELPRIORITYCOSTCALCULATOR_HPP
+
+#include "CostCalculator.hpp"
+
+#include <vector>
+
+namespace rmf_task {
+
+// Cost calculator of the multi-level prioritization scheme. The cost of a node
+// is the delay of each of its requests weighted by the level of the request.
+class MultiLevelPriorityCostCalculator : public CostCalculator
+{
+public:
+
+  /// Constructor
+  ///
+  /// level_weights holds the weight of each level, starting from level 0. It
+  /// must not be empty.
+  MultiLevelPriorityCostCalculator(std::vector<double> level_weights);
+
+  /// The weight of each level
+  const std::vector<double>& level_weights() const;
+
+  /// The level of a request, limited to the top level of this calculator
+  std::size_t level(const Request& request) const;
+
+  /// Documentation inherited
+  double compute_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority) const final;
+
+  /// Documentation inherited
+  double compute_weighted_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const final;
+
+  /// Compute the cost of assignments
+  double compute_cost(
+    rmf_task::TaskPlanner::Assignments assignments) const final;
+
+  /// Documentation inherited
+  double compute_assignment_cost(
+    const TaskPlanner::Assignment& assignment) const final;
+
+  /// Documentation inherited
+  double compute_incremental_cost(
+    const Node& n,
+    rmf_traffic::Time time_now,
+    bool check_priority,
+    double heuristic_weight) const final;
+
+  /// Documentation inherited
+  bool orders_priorities() const final;
+
+private:
+  std::vector<double> _level_weights;
+
+  double compute_g(const Node& node) const;
+
+  /// A lower bound on the weighted delay of the unassigned tasks of the node.
+  /// The tasks are split into one bucket per level, and each bucket gets its
+  /// own InvariantHeuristicQueue, so the bound costs the same to compute no
+  /// matter how many levels there are.
+  double compute_h(const Node& node, rmf_traffic::Time time_now) const;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__MULTILEVELPRIORITYCOSTCALCULATOR_HPP
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/MultiLevelPriorityScheme.hpp>
+
+#include "BinaryPriority.hpp"
+#include "MultiLevelPriority.hpp"
+#include "MultiLevelPriorityCostCalculator.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace rmf_task {
+
+//==============================================================================
+std::shared_ptr<Priority> MultiLevelPriorityScheme::make_priority(
+  const std::size_t level)
+{
+  if (level == 0)
+    return nullptr;
+
+  return std::make_shared<MultiLevelPriority>(level);
+}
+
+//==============================================================================
+std::size_t MultiLevelPriorityScheme::level(const ConstPriorityPtr& priority)
+{
+  if (!priority)
+    return 0;
+
+  if (const auto* p = dynamic_cast<const MultiLevelPriority*>(priority.get()))
+    return p->level();
+
+  if (const auto* p = dynamic_cast<const BinaryPriority*>(priority.get()))
+    return p->value();
+
+  return 1;
+}
+
+//==============================================================================
+std::shared_ptr<CostCalculator> MultiLevelPriorityScheme::make_cost_calculator(
+  const std::size_t num_levels,
+  const double level_ratio)
+{
+  if (num_levels == 0)
+  {
+    throw std::invalid_argument(
+      "[rmf_task::MultiLevelPriorityScheme::make_cost_calculator] "
+      "num_levels must be at least 1");
+  }
+
+  if (!(level_ratio >= 1.0) || !std::isfinite(level_ratio))
+  {
+    throw std::invalid_argument(
+      "[rmf_task::MultiLevelPriorityScheme::make_cost_calculator] "
+      "level_ratio must be finite and at least 1.0, but it is ["
+      + std::to_string(level_ratio) + "]");
+  }
+
+  std::vector<double> weights(num_levels, 1.0);
+  for (std::size_t l = 1; l < num_levels; ++l)
+    weights[l] = weights[l-1] * level_ratio;
+
+  return std::make_shared<MultiLevelPriorityCostCalculator>(
+    std::move(weights));
+}
+
+} // namespace rmf_task
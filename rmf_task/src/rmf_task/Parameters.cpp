@@ -28,6 +28,7 @@ public:
   rmf_battery::ConstMotionPowerSinkPtr motion_sink;
   rmf_battery::ConstDevicePowerSinkPtr ambient_sink;
   rmf_battery::ConstDevicePowerSinkPtr tool_sink;
+  std::shared_ptr<const TravelEstimator> travel_estimator = nullptr;
 };
 
 //==============================================================================
@@ -37,18 +38,28 @@ Parameters::Parameters(
   rmf_battery::ConstMotionPowerSinkPtr motion_sink,
   rmf_battery::ConstDevicePowerSinkPtr ambient_sink,
   rmf_battery::ConstDevicePowerSinkPtr tool_sink)
-: _pimpl(rmf_utils::make_impl<Implementation>(
+: _pimpl(std::make_shared<Implementation>(
       Implementation{
         std::move(planner),
         battery_system,
         std::move(motion_sink),
         std::move(ambient_sink),
-        std::move(tool_sink)
+        std::move(tool_sink),
+        nullptr
       }))
 {
   // Do nothing
 }
 
+//==============================================================================
+auto Parameters::_mutable() -> Implementation&
+{
+  if (_pimpl.use_count() > 1)
+    _pimpl = std::make_shared<Implementation>(*_pimpl);
+
+  return *_pimpl;
+}
+
 //==============================================================================
 const rmf_battery::agv::BatterySystem&
 Parameters::battery_system() const
@@ -60,7 +71,7 @@ Parameters::battery_system() const
 auto Parameters::battery_system(
   rmf_battery::agv::BatterySystem battery_system) -> Parameters&
 {
-  _pimpl->battery_system = battery_system;
+  _mutable().battery_system = battery_system;
   return *this;
 }
 
@@ -75,7 +86,7 @@ Parameters::motion_sink() const
 auto Parameters::motion_sink(
   rmf_battery::ConstMotionPowerSinkPtr motion_sink) -> Parameters&
 {
-  _pimpl->motion_sink = std::move(motion_sink);
+  _mutable().motion_sink = std::move(motion_sink);
   return *this;
 }
 
@@ -90,7 +101,7 @@ Parameters::ambient_sink() const
 auto Parameters::ambient_sink(
   rmf_battery::ConstDevicePowerSinkPtr ambient_sink) -> Parameters&
 {
-  _pimpl->ambient_sink = std::move(ambient_sink);
+  _mutable().ambient_sink = std::move(ambient_sink);
   return *this;
 }
 
@@ -105,7 +116,7 @@ Parameters::planner() const
 auto Parameters::planner(
   std::shared_ptr<const rmf_traffic::agv::Planner> planner) -> Parameters&
 {
-  _pimpl->planner = std::move(planner);
+  _mutable().planner = std::move(planner);
   return *this;
 }
 
@@ -120,7 +131,22 @@ Parameters::tool_sink() const
 auto Parameters::tool_sink(
   rmf_battery::ConstDevicePowerSinkPtr tool_sink) -> Parameters&
 {
-  _pimpl->tool_sink = std::move(tool_sink);
+  _mutable().tool_sink = std::move(tool_sink);
+  return *this;
+}
+
+//==============================================================================
+const std::shared_ptr<const TravelEstimator>&
+Parameters::travel_estimator() const
+{
+  return _pimpl->travel_estimator;
+}
+
+//==============================================================================
+auto Parameters::travel_estimator(
+  std::shared_ptr<const TravelEstimator> travel_estimator) -> Parameters&
+{
+  _mutable().travel_estimator = std::move(travel_estimator);
   return *this;
 }
 
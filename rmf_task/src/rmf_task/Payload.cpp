@@ -15,27 +15,57 @@
  *
 */
 
-#include <unordered_map>
-#include <unordered_set>
+#include <algorithm>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <unordered_set>
 
 #include <rmf_task/Payload.hpp>
 
 namespace rmf_task {
 
+namespace {
+//==============================================================================
+// Every distinct SKU and compartment name is stored once for the life of the
+// program. Components refer to their names through pointers into this table,
+// which stay valid as it grows, so copying or comparing a name never touches
+// its characters.
+const std::string* intern(std::string name)
+{
+  static std::mutex mutex;
+  static std::unordered_set<std::string> names;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  return &*names.insert(std::move(name)).first;
+}
+
+//==============================================================================
+std::size_t count_distinct(std::vector<const std::string*>& names)
+{
+  std::sort(names.begin(), names.end());
+  return static_cast<std::size_t>(
+    std::unique(names.begin(), names.end()) - names.begin());
+}
+} // anonymous namespace
+
 //==============================================================================
 class Payload::Implementation
 {
 public:
 
-  std::vector<Component> components;
+  // Payloads cannot be modified after they are made, so copies share their
+  // components
+  std::shared_ptr<const std::vector<Component>> components;
 
 };
 
 //==============================================================================
 Payload::Payload(std::vector<Component> components)
 : _pimpl(rmf_utils::make_impl<Implementation>(
-      Implementation{std::move(components)}))
+      Implementation{
+        std::make_shared<const std::vector<Component>>(std::move(components))
+      }))
 {
   // Do nothing
 }
@@ -43,53 +73,49 @@ Payload::Payload(std::vector<Component> components)
 //==============================================================================
 auto Payload::components() const -> const std::vector<Component>&
 {
-  return _pimpl->components;
+  return *_pimpl->components;
 }
 
 //==============================================================================
 std::string Payload::brief(const std::string& compartment_prefix) const
 {
-  std::unordered_map<std::string, std::size_t> item_quantities;
-  std::unordered_set<std::string> compartments;
+  const auto& components = *_pimpl->components;
+  if (components.empty())
+    return "nothing";
 
-  for (const auto& component : _pimpl->components)
+  std::vector<const std::string*> skus;
+  std::vector<const std::string*> compartments;
+  skus.reserve(components.size());
+  compartments.reserve(components.size());
+  std::size_t total_quantity = 0;
+  for (const auto& component : components)
   {
-    auto it = item_quantities.insert({component.sku(), 0}).first;
-    it->second += component.quantity();
-
-    compartments.insert(component.compartment());
+    skus.push_back(&component.sku());
+    compartments.push_back(&component.compartment());
+    total_quantity += component.quantity();
   }
 
-  if (item_quantities.empty())
-    return "nothing";
+  const std::size_t num_types = count_distinct(skus);
+  const std::size_t num_compartments = count_distinct(compartments);
 
   std::stringstream ss;
-  if (item_quantities.size() == 1)
+  if (num_types == 1)
   {
-    const auto it = item_quantities.cbegin();
-    const auto& type = it->first;
-    const auto quantity = it->second;
-    ss << quantity << " of [" << type << "]";
+    ss << total_quantity << " of [" << *skus.front() << "]";
   }
   else
   {
-    const auto num_types = item_quantities.size();
-    std::size_t total_quantity = 0;
-    for (const auto& item : item_quantities)
-      total_quantity += item.second;
-
     ss << num_types << " types of items (" << total_quantity << " total units)";
   }
 
-  if (compartments.size() == 1)
+  if (num_compartments == 1)
   {
-    const auto it = compartments.cbegin();
-    ss << " " << compartment_prefix << " [" << *it << "]";
+    ss << " " << compartment_prefix << " [" << *compartments.front() << "]";
   }
   else
   {
-    const auto quantity = compartments.size();
-    ss << " " << compartment_prefix << " " << quantity << " compartments";
+    ss << " " << compartment_prefix << " " << num_compartments
+       << " compartments";
   }
 
   return ss.str();
@@ -100,9 +126,10 @@ class Payload::Component::Implementation
 {
 public:
 
-  std::string sku;
+  // Both names are interned
+  const std::string* sku;
   uint32_t quantity;
-  std::string compartment;
+  const std::string* compartment;
 
 };
 
@@ -113,9 +140,9 @@ Payload::Component::Component(
   std::string compartment)
 : _pimpl(rmf_utils::make_impl<Implementation>(
       Implementation{
-        std::move(sku),
+        intern(std::move(sku)),
         quantity,
-        std::move(compartment)
+        intern(std::move(compartment))
       }))
 {
   // Do nothing
@@ -124,7 +151,7 @@ Payload::Component::Component(
 //==============================================================================
 const std::string& Payload::Component::sku() const
 {
-  return _pimpl->sku;
+  return *_pimpl->sku;
 }
 
 //==============================================================================
@@ -136,7 +163,7 @@ uint32_t Payload::Component::quantity() const
 //==============================================================================
 const std::string& Payload::Component::compartment() const
 {
-  return _pimpl->compartment;
+  return *_pimpl->compartment;
 }
 
 } // namespace rmf_task
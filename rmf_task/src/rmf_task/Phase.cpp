@@ -16,6 +16,7 @@
 */
 
 #include <rmf_task/Phase.hpp>
+#include <rmf_task/AllocationCounter.hpp>
 
 namespace rmf_task {
 
@@ -109,12 +110,42 @@ public:
 //==============================================================================
 Phase::ConstSnapshotPtr Phase::Snapshot::make(const Active& active)
 {
+  return make(active, nullptr);
+}
+
+//==============================================================================
+Phase::ConstSnapshotPtr Phase::Snapshot::make(
+  const Active& active,
+  const ConstSnapshotPtr& previous)
+{
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Snapshot);
+
+  // Event IDs are only unique within a phase, so nothing can be reused from
+  // the snapshot of a different phase
+  Event::ConstSnapshotPtr previous_event;
+  const auto& tag = active.tag();
+  if (previous && tag && previous->tag() && previous->tag()->id() == tag->id())
+  {
+    previous_event = std::dynamic_pointer_cast<const Event::Snapshot>(
+      previous->final_event());
+  }
+
+  auto final_event =
+    Event::Snapshot::make(*active.final_event(), previous_event);
+  const auto estimated_remaining_time = active.estimate_remaining_time();
+  if (previous_event && final_event == previous_event
+    && previous->estimate_remaining_time() == estimated_remaining_time)
+  {
+    // Nothing about the phase has changed since the previous snapshot
+    return previous;
+  }
+
   Snapshot output;
   output._pimpl = rmf_utils::make_impl<Implementation>(
     Implementation{
-      active.tag(),
-      Event::Snapshot::make(*active.final_event()),
-      active.estimate_remaining_time()
+      tag,
+      std::move(final_event),
+      estimated_remaining_time
     });
 
   return std::make_shared<Snapshot>(std::move(output));
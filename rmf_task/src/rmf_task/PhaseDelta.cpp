@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/PhaseDelta.hpp>
+
+#include <unordered_map>
+#include <vector>
+
+#include "BufferAppend.hpp"
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+const char* status_name(Event::Status status)
+{
+  switch (status)
+  {
+    case Event::Status::Blocked:
+      return "blocked";
+    case Event::Status::Error:
+      return "error";
+    case Event::Status::Failed:
+      return "failed";
+    case Event::Status::Standby:
+      return "standby";
+    case Event::Status::Underway:
+      return "underway";
+    case Event::Status::Delayed:
+      return "delayed";
+    case Event::Status::Skipped:
+      return "skipped";
+    case Event::Status::Canceled:
+      return "canceled";
+    case Event::Status::Killed:
+      return "killed";
+    case Event::Status::Completed:
+      return "completed";
+    default:
+      return "uninitialized";
+  }
+}
+
+//==============================================================================
+enum Changed : uint32_t
+{
+  StatusChanged = 1,
+  NameChanged = 2,
+  DetailChanged = 4,
+  DependenciesChanged = 8,
+  LogChanged = 16
+};
+
+//==============================================================================
+void append_binary_text(const std::string& text, std::string& buffer)
+{
+  append_raw<uint32_t>(static_cast<uint32_t>(text.size()), buffer);
+  buffer.append(text);
+}
+
+} // anonymous namespace
+
+//==============================================================================
+class PhaseDelta::Implementation
+{
+public:
+
+  // What was last encoded about an event
+  struct Encoded
+  {
+    uint64_t version;
+    Event::Status status;
+    std::vector<uint64_t> dependencies;
+  };
+
+  // Everything that was encoded about one phase. The readers remember which
+  // names, details and log entries have been written already.
+  struct PhaseState
+  {
+    VersionedString::Reader strings;
+    Log::Reader logs;
+    std::unordered_map<uint64_t, Encoded> events;
+  };
+
+  std::unordered_map<Phase::Tag::Id, PhaseState> phases;
+
+  // Reused between events so that encoding does not allocate once it is warm
+  std::string log_buffer;
+  std::vector<uint64_t> dependency_ids;
+
+  std::size_t encode(
+    Phase::Tag::Id phase_id,
+    PhaseState& phase,
+    const Event::State& event,
+    std::string& buffer,
+    Format format)
+  {
+    const auto version = event.version();
+    auto it = phase.events.find(event.id());
+    const bool is_new = it == phase.events.end();
+    if (!is_new && it->second.version == version)
+      return 0;
+
+    if (is_new)
+    {
+      it = phase.events.insert(
+        {event.id(), Encoded{version, event.status(), {}}}).first;
+    }
+
+    auto& encoded = it->second;
+    encoded.version = version;
+
+    uint32_t changed = is_new ? StatusChanged | DependenciesChanged : 0;
+    const auto status = event.status();
+    if (status != encoded.status)
+    {
+      encoded.status = status;
+      changed |= StatusChanged;
+    }
+
+    const auto name = phase.strings.read(event.name());
+    if (name)
+      changed |= NameChanged;
+
+    const auto detail = phase.strings.read(event.detail());
+    if (detail)
+      changed |= DetailChanged;
+
+    const auto dependencies = event.dependencies();
+    dependency_ids.clear();
+    for (const auto& dep : dependencies)
+    {
+      if (dep)
+        dependency_ids.push_back(dep->id());
+    }
+
+    if (dependency_ids != encoded.dependencies)
+    {
+      encoded.dependencies = dependency_ids;
+      changed |= DependenciesChanged;
+    }
+
+    log_buffer.clear();
+    const auto log_count = phase.logs.read_into(
+      event.log(), log_buffer,
+      format == Format::Binary ?
+      Log::Reader::Format::Binary : Log::Reader::Format::JsonLines);
+    if (log_count > 0)
+      changed |= LogChanged;
+
+    std::size_t count = 0;
+    if (changed)
+    {
+      ++count;
+      if (format == Format::Binary)
+      {
+        append_raw<uint64_t>(phase_id, buffer);
+        append_raw<uint64_t>(event.id(), buffer);
+        append_raw<uint64_t>(version, buffer);
+        append_raw<uint32_t>(changed, buffer);
+        if (changed & StatusChanged)
+          append_raw<uint32_t>(static_cast<uint32_t>(status), buffer);
+        if (changed & NameChanged)
+          append_binary_text(*name, buffer);
+        if (changed & DetailChanged)
+          append_binary_text(*detail, buffer);
+        if (changed & DependenciesChanged)
+        {
+          append_raw<uint32_t>(
+            static_cast<uint32_t>(encoded.dependencies.size()), buffer);
+          for (const auto id : encoded.dependencies)
+            append_raw<uint64_t>(id, buffer);
+        }
+        if (changed & LogChanged)
+          append_raw<uint32_t>(static_cast<uint32_t>(log_count), buffer);
+      }
+      else
+      {
+        buffer.append("{\"phase\":");
+        append_number(phase_id, buffer);
+        buffer.append(",\"event\":");
+        append_number(event.id(), buffer);
+        buffer.append(",\"version\":");
+        append_number(version, buffer);
+        if (changed & StatusChanged)
+        {
+          buffer.append(",\"status\":\"");
+          buffer.append(status_name(status));
+          buffer.push_back('"');
+        }
+        if (changed & NameChanged)
+        {
+          buffer.append(",\"name\":");
+          append_json_string(*name, buffer);
+        }
+        if (changed & DetailChanged)
+        {
+          buffer.append(",\"detail\":");
+          append_json_string(*detail, buffer);
+        }
+        if (changed & DependenciesChanged)
+        {
+          buffer.append(",\"dependencies\":[");
+          for (std::size_t i = 0; i < encoded.dependencies.size(); ++i)
+          {
+            if (i > 0)
+              buffer.push_back(',');
+            append_number(encoded.dependencies[i], buffer);
+          }
+          buffer.push_back(']');
+        }
+        if (changed & LogChanged)
+        {
+          buffer.append(",\"log\":");
+          append_number(log_count, buffer);
+        }
+        buffer.append("}\n");
+      }
+
+      buffer.append(log_buffer);
+    }
+
+    // The dependencies are encoded after this event, so that a reader always
+    // learns about an event from its parent before its own record
+    for (const auto& dep : dependencies)
+    {
+      if (dep)
+        count += encode(phase_id, phase, *dep, buffer, format);
+    }
+
+    return count;
+  }
+};
+
+//==============================================================================
+PhaseDelta::PhaseDelta()
+: _pimpl(rmf_utils::make_unique_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::size_t PhaseDelta::encode(
+  const Phase::Snapshot& snapshot,
+  std::string& buffer,
+  Format format)
+{
+  const auto& tag = snapshot.tag();
+  const auto event = snapshot.final_event();
+  if (!tag || !event)
+    return 0;
+
+  const auto phase_id = tag->id();
+  return _pimpl->encode(
+    phase_id, _pimpl->phases[phase_id], *event, buffer, format);
+}
+
+//==============================================================================
+void PhaseDelta::reset()
+{
+  _pimpl->phases.clear();
+}
+
+//==============================================================================
+void PhaseDelta::forget(Phase::Tag::Id phase)
+{
+  _pimpl->phases.erase(phase);
+}
+
+} // namespace rmf_task
@@ -0,0 +1,1181 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/PlanningProblem.hpp>
+
+#include <rmf_task/requests/ChargeBattery.hpp>
+#include <rmf_task/requests/ChargeBatteryFactory.hpp>
+#include <rmf_task/requests/Clean.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/Loop.hpp>
+#include <rmf_task/requests/ParkRobotFactory.hpp>
+#include <rmf_task/requests/PooledDelivery.hpp>
+
+#include <rmf_battery/agv/MechanicalSystem.hpp>
+#include <rmf_battery/agv/PowerSystem.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+
+#include <rmf_traffic/geometry/Circle.hpp>
+
+#include "BinaryPriority.hpp"
+#include "BinaryPriorityCostCalculator.hpp"
+#include "MultiLevelPriority.hpp"
+#include "MultiLevelPriorityCostCalculator.hpp"
+
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// The version of the serialized format. Increment it whenever the format
+// changes so that old captures are rejected instead of misread.
+constexpr int FormatVersion = 1;
+
+// Bits of the flags of a serialized waypoint
+constexpr uint32_t ChargerFlag = 1;
+constexpr uint32_t ParkingFlag = 2;
+constexpr uint32_t HoldingFlag = 4;
+constexpr uint32_t PassthroughFlag = 8;
+
+//==============================================================================
+// FNV-1a, used to hash the graph of a problem
+class Fingerprint
+{
+public:
+
+  template<typename T>
+  Fingerprint& add(const T& value)
+  {
+    static_assert(std::is_trivially_copyable_v<T>);
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    for (const auto b : bytes)
+    {
+      _hash ^= b;
+      _hash *= 1099511628211ull;
+    }
+
+    return *this;
+  }
+
+  Fingerprint& add(const std::string& value)
+  {
+    add(value.size());
+    for (const auto c : value)
+      add(c);
+
+    return *this;
+  }
+
+  uint64_t value() const
+  {
+    return _hash;
+  }
+
+private:
+  uint64_t _hash = 14695981039346656037ull;
+};
+
+//==============================================================================
+int64_t to_ns(rmf_traffic::Duration duration)
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+//==============================================================================
+rmf_traffic::Duration from_ns(int64_t ns)
+{
+  return std::chrono::duration_cast<rmf_traffic::Duration>(
+    std::chrono::nanoseconds(ns));
+}
+
+//==============================================================================
+nlohmann::json optional_ns(const std::optional<rmf_traffic::Duration>& value)
+{
+  return value.has_value() ? nlohmann::json(to_ns(*value)) : nlohmann::json();
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration> optional_duration(
+  const nlohmann::json& value)
+{
+  if (value.is_null())
+    return std::nullopt;
+
+  return from_ns(value.get<int64_t>());
+}
+
+//==============================================================================
+std::string to_hex(uint64_t value)
+{
+  std::ostringstream hex;
+  hex << std::hex << std::setw(16) << std::setfill('0') << value;
+  return hex.str();
+}
+
+//==============================================================================
+uint32_t waypoint_flags(const rmf_traffic::agv::Graph::Waypoint& wp)
+{
+  return (wp.is_charger() ? ChargerFlag : 0)
+    | (wp.is_parking_spot() ? ParkingFlag : 0)
+    | (wp.is_holding_point() ? HoldingFlag : 0)
+    | (wp.is_passthrough_point() ? PassthroughFlag : 0);
+}
+
+//==============================================================================
+nlohmann::json serialize_graph(const rmf_traffic::agv::Graph& graph)
+{
+  // Waypoints and lanes are stored as arrays instead of objects since a site
+  // can have thousands of them
+  nlohmann::json waypoints = nlohmann::json::array();
+  for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+  {
+    const auto& wp = graph.get_waypoint(i);
+    const auto& p = wp.get_location();
+    const std::string* name = wp.name();
+    waypoints.push_back(
+      {wp.get_map_name(), p.x(), p.y(), waypoint_flags(wp),
+        name ? nlohmann::json(*name) : nlohmann::json()});
+  }
+
+  nlohmann::json lanes = nlohmann::json::array();
+  for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+  {
+    const auto& lane = graph.get_lane(i);
+    const auto speed_limit = lane.properties().speed_limit();
+    lanes.push_back(
+      {lane.entry().waypoint_index(), lane.exit().waypoint_index(),
+        speed_limit.has_value() ? nlohmann::json(*speed_limit) :
+        nlohmann::json()});
+  }
+
+  return {{"waypoints", std::move(waypoints)}, {"lanes", std::move(lanes)}};
+}
+
+//==============================================================================
+rmf_traffic::agv::Graph deserialize_graph(const nlohmann::json& json)
+{
+  rmf_traffic::agv::Graph graph;
+  for (const auto& w : json.at("waypoints"))
+  {
+    auto& wp = graph.add_waypoint(
+      w.at(0).get<std::string>(),
+      {w.at(1).get<double>(), w.at(2).get<double>()});
+
+    const auto flags = w.at(3).get<uint32_t>();
+    wp.set_charger(flags & ChargerFlag);
+    wp.set_parking_spot(flags & ParkingFlag);
+    wp.set_holding_point(flags & HoldingFlag);
+    wp.set_passthrough_point(flags & PassthroughFlag);
+
+    if (!w.at(4).is_null())
+      graph.add_key(w.at(4).get<std::string>(), wp.index());
+  }
+
+  for (const auto& l : json.at("lanes"))
+  {
+    rmf_traffic::agv::Graph::Lane::Properties properties;
+    if (!l.at(2).is_null())
+      properties.speed_limit(l.at(2).get<double>());
+
+    graph.add_lane(
+      l.at(0).get<std::size_t>(), l.at(1).get<std::size_t>(), properties);
+  }
+
+  return graph;
+}
+
+//==============================================================================
+nlohmann::json serialize_traits(const rmf_traffic::agv::VehicleTraits& traits)
+{
+  const auto& profile = traits.profile();
+  const auto radius = [](const auto& shape)
+    {
+      return shape ?
+        nlohmann::json(shape->get_characteristic_length()) : nlohmann::json();
+    };
+
+  return {
+    {"linear", {
+        traits.linear().get_nominal_velocity(),
+        traits.linear().get_nominal_acceleration()}},
+    {"rotational", {
+        traits.rotational().get_nominal_velocity(),
+        traits.rotational().get_nominal_acceleration()}},
+    {"footprint", radius(profile.footprint())},
+    {"vicinity", radius(profile.vicinity())}
+  };
+}
+
+//==============================================================================
+rmf_traffic::agv::VehicleTraits deserialize_traits(const nlohmann::json& json)
+{
+  using rmf_traffic::agv::VehicleTraits;
+  const auto limits = [&](const char* key)
+    {
+      const auto& l = json.at(key);
+      return VehicleTraits::Limits(
+        l.at(0).get<double>(), l.at(1).get<double>());
+    };
+
+  // Footprints are captured as circles of their characteristic length
+  const auto circle = [&](const char* key)
+    -> rmf_traffic::geometry::FinalConvexShapePtr
+    {
+      const auto& r = json.at(key);
+      if (r.is_null())
+        return nullptr;
+
+      return rmf_traffic::geometry::make_final_convex<
+        rmf_traffic::geometry::Circle>(r.get<double>());
+    };
+
+  return VehicleTraits(
+    limits("linear"),
+    limits("rotational"),
+    rmf_traffic::Profile(circle("footprint"), circle("vicinity")));
+}
+
+//==============================================================================
+nlohmann::json serialize_parameters(const Parameters& parameters)
+{
+  using namespace rmf_battery::agv;
+
+  const auto* motion = dynamic_cast<const SimpleMotionPowerSink*>(
+    parameters.motion_sink().get());
+  const auto* ambient = dynamic_cast<const SimpleDevicePowerSink*>(
+    parameters.ambient_sink().get());
+  if (!motion || !ambient)
+  {
+    throw std::invalid_argument(
+      "[rmf_task::PlanningProblem::serialize] Only SimpleMotionPowerSink and "
+      "SimpleDevicePowerSink can be captured");
+  }
+
+  nlohmann::json tool;
+  if (parameters.tool_sink())
+  {
+    const auto* sink = dynamic_cast<const SimpleDevicePowerSink*>(
+      parameters.tool_sink().get());
+    if (!sink)
+    {
+      throw std::invalid_argument(
+        "[rmf_task::PlanningProblem::serialize] Only a SimpleDevicePowerSink "
+        "can be captured as the tool sink");
+    }
+
+    tool = sink->power_system().nominal_power();
+  }
+
+  const auto& battery = parameters.battery_system();
+  const auto& mechanical = motion->mechanical_system();
+  const auto& planner = parameters.planner()->get_configuration();
+  return {
+    {"graph", serialize_graph(planner.graph())},
+    {"traits", serialize_traits(planner.vehicle_traits())},
+    {"battery", {
+        battery.nominal_voltage(),
+        battery.capacity(),
+        battery.charging_current()}},
+    {"mechanical", {
+        mechanical.mass(),
+        mechanical.moment_of_inertia(),
+        mechanical.friction_coefficient()}},
+    {"ambient_power", ambient->power_system().nominal_power()},
+    {"tool_power", std::move(tool)}
+  };
+}
+
+//==============================================================================
+template<typename T>
+T require(const std::optional<T>& value, const char* what)
+{
+  if (!value.has_value())
+  {
+    throw std::runtime_error(
+      std::string("[rmf_task::PlanningProblem::deserialize] Invalid ") + what);
+  }
+
+  return *value;
+}
+
+//==============================================================================
+Parameters deserialize_parameters(const nlohmann::json& json)
+{
+  using namespace rmf_battery::agv;
+
+  const auto& b = json.at("battery");
+  const auto battery = require(
+    BatterySystem::make(
+      b.at(0).get<double>(), b.at(1).get<double>(), b.at(2).get<double>()),
+    "battery system");
+
+  const auto& m = json.at("mechanical");
+  const auto mechanical = require(
+    MechanicalSystem::make(
+      m.at(0).get<double>(), m.at(1).get<double>(), m.at(2).get<double>()),
+    "mechanical system");
+
+  const auto device_sink = [&](const nlohmann::json& power)
+    -> rmf_battery::ConstDevicePowerSinkPtr
+    {
+      if (power.is_null())
+        return nullptr;
+
+      return std::make_shared<SimpleDevicePowerSink>(
+        battery, require(PowerSystem::make(power.get<double>()), "power"));
+    };
+
+  auto planner = std::make_shared<rmf_traffic::agv::Planner>(
+    rmf_traffic::agv::Planner::Configuration{
+      deserialize_graph(json.at("graph")),
+      deserialize_traits(json.at("traits"))},
+    rmf_traffic::agv::Planner::Options{nullptr});
+
+  return Parameters(
+    std::move(planner),
+    battery,
+    std::make_shared<SimpleMotionPowerSink>(battery, mechanical),
+    device_sink(json.at("ambient_power")),
+    device_sink(json.at("tool_power")));
+}
+
+//==============================================================================
+nlohmann::json serialize_cost(const ConstCostCalculatorPtr& cost_calculator)
+{
+  const auto* multi_level =
+    dynamic_cast<const MultiLevelPriorityCostCalculator*>(
+    cost_calculator.get());
+  if (multi_level)
+  {
+    return {
+      {"type", "multi_level"},
+      {"level_weights", multi_level->level_weights()}
+    };
+  }
+
+  const auto* binary = dynamic_cast<const BinaryPriorityCostCalculator*>(
+    cost_calculator.get());
+  if (!binary)
+  {
+    throw std::invalid_argument(
+      "[rmf_task::PlanningProblem::serialize] Only the cost calculators of "
+      "BinaryPriorityScheme and MultiLevelPriorityScheme can be captured");
+  }
+
+  return {
+    {"priority_penalty", binary->priority_penalty()},
+    {"makespan_weight", binary->makespan_weight()},
+    {"assignment_bound", binary->assignment_bound()}
+  };
+}
+
+//==============================================================================
+ConstCostCalculatorPtr deserialize_cost(const nlohmann::json& json)
+{
+  // Captures from before multi-level priorities have no type
+  if (json.value("type", "binary") == "multi_level")
+  {
+    auto weights = json.at("level_weights").get<std::vector<double>>();
+    if (weights.empty())
+    {
+      throw std::runtime_error(
+        "[rmf_task::PlanningProblem::deserialize] A multi-level cost "
+        "calculator needs at least one level");
+    }
+
+    return std::make_shared<MultiLevelPriorityCostCalculator>(
+      std::move(weights));
+  }
+
+  return std::make_shared<BinaryPriorityCostCalculator>(
+    json.at("priority_penalty").get<double>(),
+    json.at("makespan_weight").get<double>(),
+    json.at("assignment_bound").get<bool>());
+}
+
+//==============================================================================
+nlohmann::json serialize_finishing_request(
+  const ConstRequestFactoryPtr& factory)
+{
+  if (!factory)
+    return nullptr;
+
+  if (const auto* charge =
+    dynamic_cast<const requests::ChargeBatteryFactory*>(factory.get()))
+    return {{"type", "charge_battery"}, {"indefinite", charge->indefinite()}};
+
+  if (const auto* park =
+    dynamic_cast<const requests::ParkRobotFactory*>(factory.get()))
+  {
+    const auto waypoint = park->parking_waypoint();
+    return {
+      {"type", "park"},
+      {"waypoint", waypoint.has_value() ?
+        nlohmann::json(*waypoint) : nlohmann::json()}
+    };
+  }
+
+  throw std::invalid_argument(
+    "[rmf_task::PlanningProblem::serialize] Only a ChargeBatteryFactory or a "
+    "ParkRobotFactory can be captured as the finishing request");
+}
+
+//==============================================================================
+ConstRequestFactoryPtr deserialize_finishing_request(
+  const nlohmann::json& json)
+{
+  if (json.is_null())
+    return nullptr;
+
+  const auto type = json.at("type").get<std::string>();
+  if (type == "charge_battery")
+  {
+    auto charge = std::make_shared<requests::ChargeBatteryFactory>();
+    charge->set_indefinite(json.at("indefinite").get<bool>());
+    return charge;
+  }
+
+  if (type == "park")
+  {
+    const auto& waypoint = json.at("waypoint");
+    return std::make_shared<requests::ParkRobotFactory>(
+      waypoint.is_null() ?
+      std::nullopt : std::optional<std::size_t>(waypoint.get<std::size_t>()));
+  }
+
+  throw std::runtime_error(
+    "[rmf_task::PlanningProblem::deserialize] Unknown finishing request ["
+    + type + "]");
+}
+
+//==============================================================================
+nlohmann::json serialize_options(
+  const TaskPlanner::Options& options,
+  const rmf_traffic::Time time_now)
+{
+  const auto deadline = options.deadline();
+  const auto margin = options.partial_charging_margin();
+  return {
+    {"greedy", options.greedy()},
+    {"finishing_request",
+      serialize_finishing_request(options.finishing_request())},
+    {"expansion_threads", options.expansion_threads()},
+    {"search_threads", options.search_threads()},
+    {"arena_reserve", options.arena_reserve()},
+    {"deterministic_seed", options.deterministic_seed().has_value() ?
+      nlohmann::json(*options.deterministic_seed()) : nlohmann::json()},
+    {"local_search_budget", optional_ns(options.local_search_budget())},
+    {"max_open_nodes", options.max_open_nodes()},
+    {"anytime", options.anytime()},
+    {"deadline", deadline.has_value() ?
+      nlohmann::json(to_ns(*deadline - time_now)) : nlohmann::json()},
+    {"time_budget", optional_ns(options.time_budget())},
+    {"horizon", options.horizon()},
+    {"commit_window", options.commit_window()},
+    {"greedy_by_finish_time", options.greedy_by_finish_time()},
+    {"greedy_restarts", options.greedy_restarts()},
+    {"greedy_restart_alpha", options.greedy_restart_alpha()},
+    {"neighborhood_search_budget",
+      optional_ns(options.neighborhood_search_budget())},
+    {"neighborhood_size", options.neighborhood_size()},
+    {"parallel_neighborhoods", options.parallel_neighborhoods()},
+    {"delivery_pooling_window",
+      optional_ns(options.delivery_pooling_window())},
+    {"break_agent_symmetry", options.break_agent_symmetry()},
+    {"agent_symmetry_soc_tolerance", options.agent_symmetry_soc_tolerance()},
+    {"agent_symmetry_time_tolerance",
+      to_ns(options.agent_symmetry_time_tolerance())},
+    {"break_request_symmetry", options.break_request_symmetry()},
+    {"prune_dominated_nodes", options.prune_dominated_nodes()},
+    {"partial_charging_margin", margin.has_value() ?
+      nlohmann::json(*margin) : nlohmann::json()},
+    {"opportunistic_charging_detour",
+      optional_ns(options.opportunistic_charging_detour())}
+  };
+}
+
+//==============================================================================
+TaskPlanner::Options deserialize_options(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  TaskPlanner::Options options(
+    json.at("greedy").get<bool>(),
+    nullptr,
+    deserialize_finishing_request(json.at("finishing_request")));
+
+  // Captures from before an option was added do not have its key, so those
+  // options fall back on their defaults
+  const TaskPlanner::Options defaults(false, nullptr, nullptr);
+  const auto optional_value = [&json](const std::string& key)
+    {
+      return json.value(key, nlohmann::json());
+    };
+
+  const auto& seed = json.at("deterministic_seed");
+  const auto margin = optional_value("partial_charging_margin");
+  const auto deadline = optional_duration(json.at("deadline"));
+  options
+  .expansion_threads(json.at("expansion_threads").get<std::size_t>())
+  .search_threads(json.at("search_threads").get<std::size_t>())
+  .arena_reserve(json.at("arena_reserve").get<std::size_t>())
+  .deterministic_seed(
+    seed.is_null() ?
+    std::nullopt : std::optional<std::uint64_t>(seed.get<std::uint64_t>()))
+  .local_search_budget(optional_duration(json.at("local_search_budget")))
+  .max_open_nodes(json.at("max_open_nodes").get<std::size_t>())
+  .anytime(json.at("anytime").get<bool>())
+  .deadline(
+    deadline.has_value() ?
+    std::optional<rmf_traffic::Time>(time_now + *deadline) : std::nullopt)
+  .time_budget(optional_duration(json.at("time_budget")))
+  .rolling_horizon(
+    json.at("horizon").get<std::size_t>(),
+    json.at("commit_window").get<std::size_t>())
+  .greedy_by_finish_time(json.at("greedy_by_finish_time").get<bool>())
+  .greedy_restarts(
+    json.at("greedy_restarts").get<std::size_t>(),
+    json.at("greedy_restart_alpha").get<double>())
+  .neighborhood_search(
+    optional_duration(json.at("neighborhood_search_budget")),
+    json.at("neighborhood_size").get<std::size_t>(),
+    json.at("parallel_neighborhoods").get<std::size_t>())
+  .pool_deliveries(optional_duration(json.at("delivery_pooling_window")))
+  .break_agent_symmetry(
+    json.value("break_agent_symmetry", defaults.break_agent_symmetry()),
+    json.value(
+      "agent_symmetry_soc_tolerance",
+      defaults.agent_symmetry_soc_tolerance()),
+    from_ns(
+      json.value(
+        "agent_symmetry_time_tolerance",
+        to_ns(defaults.agent_symmetry_time_tolerance()))))
+  .break_request_symmetry(
+    json.value("break_request_symmetry", defaults.break_request_symmetry()))
+  .prune_dominated_nodes(
+    json.value("prune_dominated_nodes", defaults.prune_dominated_nodes()))
+  .partial_charging(
+    margin.is_null() ?
+    std::nullopt : std::optional<double>(margin.get<double>()))
+  .opportunistic_charging(
+    optional_duration(optional_value("opportunistic_charging_detour")));
+
+  return options;
+}
+
+//==============================================================================
+nlohmann::json serialize_state(
+  const State& state,
+  const rmf_traffic::Time time_now)
+{
+  // Only the components that the planner reads are captured
+  nlohmann::json json = nlohmann::json::object();
+  if (const auto waypoint = state.waypoint())
+    json["waypoint"] = *waypoint;
+  if (const auto orientation = state.orientation())
+    json["orientation"] = *orientation;
+  if (const auto time = state.time())
+    json["time"] = to_ns(*time - time_now);
+  if (const auto charger = state.dedicated_charging_waypoint())
+    json["charger"] = *charger;
+  if (const auto soc = state.battery_soc())
+    json["soc"] = *soc;
+  if (const auto capacity = state.payload_capacity())
+    json["payload_capacity"] = *capacity;
+
+  return json;
+}
+
+//==============================================================================
+State deserialize_state(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  State state;
+  if (json.contains("waypoint"))
+    state.waypoint(json["waypoint"].get<std::size_t>());
+  if (json.contains("orientation"))
+    state.orientation(json["orientation"].get<double>());
+  if (json.contains("time"))
+    state.time(time_now + from_ns(json["time"].get<int64_t>()));
+  if (json.contains("charger"))
+    state.dedicated_charging_waypoint(json["charger"].get<std::size_t>());
+  if (json.contains("soc"))
+    state.battery_soc(json["soc"].get<double>());
+  if (json.contains("payload_capacity"))
+    state.payload_capacity(json["payload_capacity"].get<uint32_t>());
+
+  return state;
+}
+
+//==============================================================================
+nlohmann::json serialize_booking(
+  const Task::Booking& booking,
+  const rmf_traffic::Time time_now)
+{
+  nlohmann::json json = {
+    {"id", booking.id()},
+    {"start", to_ns(booking.earliest_start_time() - time_now)},
+    {"priority", booking.priority() ?
+      booking.priority()->serialize() : nlohmann::json()},
+    {"automatic", booking.automatic()}
+  };
+
+  if (const auto requester = booking.requester())
+    json["requester"] = *requester;
+  if (const auto request_time = booking.request_time())
+    json["request_time"] = to_ns(*request_time - time_now);
+
+  const auto labels = booking.labels();
+  if (!labels.empty())
+    json["labels"] = labels;
+
+  return json;
+}
+
+//==============================================================================
+ConstPriorityPtr deserialize_priority(const nlohmann::json& json)
+{
+  if (json.is_null())
+    return nullptr;
+
+  const auto type = json.at("type").get<std::string>();
+  if (type == "multi_level")
+  {
+    return std::make_shared<MultiLevelPriority>(
+      json.at("value").get<std::size_t>());
+  }
+
+  if (type != "binary")
+  {
+    throw std::runtime_error(
+      "[rmf_task::PlanningProblem::deserialize] Unknown priority [" + type
+      + "]");
+  }
+
+  return std::make_shared<BinaryPriority>(json.at("value").get<std::size_t>());
+}
+
+//==============================================================================
+Task::ConstBookingPtr deserialize_booking(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  const auto id = json.at("id").get<std::string>();
+  const auto start = time_now + from_ns(json.at("start").get<int64_t>());
+  auto priority = deserialize_priority(json.at("priority"));
+  const bool automatic = json.at("automatic").get<bool>();
+  const auto labels = json.value("labels", std::vector<std::string>());
+
+  if (json.contains("requester"))
+  {
+    return std::make_shared<Task::Booking>(
+      id, start, std::move(priority),
+      json["requester"].get<std::string>(),
+      time_now + from_ns(json.value("request_time", int64_t(0))),
+      automatic, labels);
+  }
+
+  return std::make_shared<Task::Booking>(
+    id, start, std::move(priority), automatic, labels);
+}
+
+//==============================================================================
+nlohmann::json serialize_request(
+  const Request& request,
+  const rmf_traffic::Time time_now);
+
+//==============================================================================
+nlohmann::json serialize_description(
+  const Task::Description& description,
+  const rmf_traffic::Time time_now)
+{
+  using namespace requests;
+  if (const auto* d = dynamic_cast<const Delivery::Description*>(&description))
+  {
+    nlohmann::json payload = nlohmann::json::array();
+    for (const auto& c : d->payload().components())
+      payload.push_back({c.sku(), c.quantity(), c.compartment()});
+
+    return {
+      {"type", "delivery"},
+      {"pickup", d->pickup_waypoint()},
+      {"pickup_wait", to_ns(d->pickup_wait())},
+      {"dispenser", d->pickup_from_dispenser()},
+      {"dropoff", d->dropoff_waypoint()},
+      {"dropoff_wait", to_ns(d->dropoff_wait())},
+      {"ingestor", d->dropoff_to_ingestor()},
+      {"payload", std::move(payload)}
+    };
+  }
+
+  if (const auto* c = dynamic_cast<const Clean::Description*>(&description))
+  {
+    // The times of the path are kept relative to time_now like the rest
+    nlohmann::json path = nlohmann::json::array();
+    const auto& trajectory = c->cleaning_path();
+    for (const auto& wp : trajectory)
+    {
+      const Eigen::Vector3d p = wp.position();
+      const Eigen::Vector3d v = wp.velocity();
+      path.push_back(
+        {to_ns(wp.time() - time_now), p.x(), p.y(), p.z(), v.x(), v.y(),
+          v.z()});
+    }
+
+    return {
+      {"type", "clean"},
+      {"start", c->start_waypoint()},
+      {"end", c->end_waypoint()},
+      {"path", std::move(path)}
+    };
+  }
+
+  if (const auto* l = dynamic_cast<const Loop::Description*>(&description))
+  {
+    return {
+      {"type", "loop"},
+      {"start", l->start_waypoint()},
+      {"finish", l->finish_waypoint()},
+      {"loops", l->num_loops()},
+      {"charge_between_loops", l->charge_between_loops()}
+    };
+  }
+
+  if (const auto* c =
+    dynamic_cast<const ChargeBattery::Description*>(&description))
+  {
+    const auto target = c->target_soc();
+    return {
+      {"type", "charge_battery"},
+      {"indefinite", c->indefinite()},
+      {"target_soc", target.has_value() ?
+        nlohmann::json(*target) : nlohmann::json()}
+    };
+  }
+
+  if (const auto* p =
+    dynamic_cast<const PooledDelivery::Description*>(&description))
+  {
+    nlohmann::json deliveries = nlohmann::json::array();
+    for (const auto& delivery : p->deliveries())
+      deliveries.push_back(serialize_request(*delivery, time_now));
+
+    return {{"type", "pooled_delivery"}, {"deliveries", deliveries}};
+  }
+
+  throw std::invalid_argument(
+    "[rmf_task::PlanningProblem::serialize] A request has a description "
+    "type that cannot be captured");
+}
+
+//==============================================================================
+nlohmann::json serialize_request(
+  const Request& request,
+  const rmf_traffic::Time time_now)
+{
+  auto json = serialize_description(*request.description(), time_now);
+  json["booking"] = serialize_booking(*request.booking(), time_now);
+  return json;
+}
+
+//==============================================================================
+ConstRequestPtr deserialize_request(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now);
+
+//==============================================================================
+Task::ConstDescriptionPtr deserialize_description(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  using namespace requests;
+  const auto type = json.at("type").get<std::string>();
+  if (type == "delivery")
+  {
+    std::vector<Payload::Component> components;
+    for (const auto& c : json.at("payload"))
+    {
+      components.emplace_back(
+        c.at(0).get<std::string>(),
+        c.at(1).get<uint32_t>(),
+        c.at(2).get<std::string>());
+    }
+
+    return Delivery::Description::make(
+      json.at("pickup").get<std::size_t>(),
+      from_ns(json.at("pickup_wait").get<int64_t>()),
+      json.at("dropoff").get<std::size_t>(),
+      from_ns(json.at("dropoff_wait").get<int64_t>()),
+      Payload(std::move(components)),
+      json.at("dispenser").get<std::string>(),
+      json.at("ingestor").get<std::string>());
+  }
+
+  if (type == "clean")
+  {
+    rmf_traffic::Trajectory path;
+    for (const auto& wp : json.at("path"))
+    {
+      path.insert(
+        time_now + from_ns(wp.at(0).get<int64_t>()),
+        {wp.at(1).get<double>(), wp.at(2).get<double>(),
+          wp.at(3).get<double>()},
+        {wp.at(4).get<double>(), wp.at(5).get<double>(),
+          wp.at(6).get<double>()});
+    }
+
+    return Clean::Description::make(
+      json.at("start").get<std::size_t>(),
+      json.at("end").get<std::size_t>(),
+      path);
+  }
+
+  if (type == "loop")
+  {
+    return Loop::Description::make(
+      json.at("start").get<std::size_t>(),
+      json.at("finish").get<std::size_t>(),
+      json.at("loops").get<std::size_t>(),
+      json.at("charge_between_loops").get<bool>());
+  }
+
+  if (type == "charge_battery")
+  {
+    if (json.at("indefinite").get<bool>())
+      return ChargeBattery::Description::make_indefinite();
+
+    // Captures from before charges had targets do not have the key
+    const auto target = json.value("target_soc", nlohmann::json());
+    if (!target.is_null())
+      return ChargeBattery::Description::make(target.get<double>());
+
+    return ChargeBattery::Description::make();
+  }
+
+  if (type == "pooled_delivery")
+  {
+    std::vector<ConstRequestPtr> deliveries;
+    for (const auto& delivery : json.at("deliveries"))
+      deliveries.push_back(deserialize_request(delivery, time_now));
+
+    return PooledDelivery::Description::make(std::move(deliveries));
+  }
+
+  throw std::runtime_error(
+    "[rmf_task::PlanningProblem::deserialize] Unknown request type [" + type
+    + "]");
+}
+
+//==============================================================================
+ConstRequestPtr deserialize_request(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  return std::make_shared<Request>(
+    deserialize_booking(json.at("booking"), time_now),
+    deserialize_description(json, time_now));
+}
+
+} // anonymous namespace
+
+//==============================================================================
+class PlanningProblem::Implementation
+{
+public:
+
+  TaskPlanner::Configuration configuration;
+  TaskPlanner::Options options;
+  rmf_traffic::Time time_now;
+  std::vector<State> agents;
+  std::vector<ConstRequestPtr> requests;
+};
+
+//==============================================================================
+PlanningProblem::PlanningProblem(
+  TaskPlanner::Configuration configuration,
+  TaskPlanner::Options options,
+  rmf_traffic::Time time_now,
+  std::vector<State> agents,
+  std::vector<ConstRequestPtr> requests)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{
+        std::move(configuration),
+        std::move(options),
+        time_now,
+        std::move(agents),
+        std::move(requests)
+      }))
+{
+  // Do nothing
+}
+
+//==============================================================================
+const TaskPlanner::Configuration& PlanningProblem::configuration() const
+{
+  return _pimpl->configuration;
+}
+
+//==============================================================================
+const TaskPlanner::Options& PlanningProblem::options() const
+{
+  return _pimpl->options;
+}
+
+//==============================================================================
+rmf_traffic::Time PlanningProblem::time_now() const
+{
+  return _pimpl->time_now;
+}
+
+//==============================================================================
+const std::vector<State>& PlanningProblem::agents() const
+{
+  return _pimpl->agents;
+}
+
+//==============================================================================
+const std::vector<ConstRequestPtr>& PlanningProblem::requests() const
+{
+  return _pimpl->requests;
+}
+
+//==============================================================================
+uint64_t PlanningProblem::graph_hash() const
+{
+  return graph_hash(
+    _pimpl->configuration.parameters().planner()->get_configuration().graph());
+}
+
+//==============================================================================
+uint64_t PlanningProblem::graph_hash(const rmf_traffic::agv::Graph& graph)
+{
+  Fingerprint fingerprint;
+  fingerprint.add(graph.num_waypoints());
+  for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+  {
+    const auto& wp = graph.get_waypoint(i);
+    const std::string* name = wp.name();
+    fingerprint
+    .add(wp.get_map_name())
+    .add(wp.get_location().x())
+    .add(wp.get_location().y())
+    .add(waypoint_flags(wp))
+    .add(name != nullptr)
+    .add(name ? *name : std::string());
+  }
+
+  fingerprint.add(graph.num_lanes());
+  for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+  {
+    const auto& lane = graph.get_lane(i);
+    const auto speed_limit = lane.properties().speed_limit();
+    fingerprint
+    .add(lane.entry().waypoint_index())
+    .add(lane.exit().waypoint_index())
+    .add(speed_limit.has_value())
+    .add(speed_limit.value_or(0.0));
+  }
+
+  return fingerprint.value();
+}
+
+//==============================================================================
+nlohmann::json PlanningProblem::serialize() const
+{
+  const auto& config = _pimpl->configuration;
+  const auto& constraints = config.constraints();
+  const auto time_now = _pimpl->time_now;
+
+  nlohmann::json agents = nlohmann::json::array();
+  for (const auto& agent : _pimpl->agents)
+    agents.push_back(serialize_state(agent, time_now));
+
+  nlohmann::json requests = nlohmann::json::array();
+  for (const auto& request : _pimpl->requests)
+    requests.push_back(serialize_request(*request, time_now));
+
+  return {
+    {"version", FormatVersion},
+    {"graph_hash", to_hex(graph_hash())},
+    {"parameters", serialize_parameters(config.parameters())},
+    {"constraints", {
+        constraints.threshold_soc(),
+        constraints.recharge_soc(),
+        constraints.drain_battery()}},
+    {"cost", serialize_cost(config.cost_calculator())},
+    {"options", serialize_options(_pimpl->options, time_now)},
+    {"agents", std::move(agents)},
+    {"requests", std::move(requests)}
+  };
+}
+
+//==============================================================================
+PlanningProblem PlanningProblem::deserialize(
+  const nlohmann::json& json,
+  const rmf_traffic::Time time_now)
+{
+  if (!json.is_object() || json.value("version", 0) != FormatVersion)
+  {
+    throw std::runtime_error(
+      "[rmf_task::PlanningProblem::deserialize] Not a planning problem of "
+      "version " + std::to_string(FormatVersion));
+  }
+
+  try
+  {
+    auto parameters = deserialize_parameters(json.at("parameters"));
+    const auto hash = to_hex(
+      graph_hash(parameters.planner()->get_configuration().graph()));
+    if (hash != json.at("graph_hash").get<std::string>())
+    {
+      throw std::runtime_error(
+        "[rmf_task::PlanningProblem::deserialize] The graph does not match "
+        "its hash");
+    }
+
+    const auto& c = json.at("constraints");
+    TaskPlanner::Configuration configuration(
+      std::move(parameters),
+      Constraints(
+        c.at(0).get<double>(), c.at(1).get<double>(), c.at(2).get<bool>()),
+      deserialize_cost(json.at("cost")));
+
+    std::vector<State> agents;
+    for (const auto& agent : json.at("agents"))
+      agents.push_back(deserialize_state(agent, time_now));
+
+    std::vector<ConstRequestPtr> requests;
+    for (const auto& request : json.at("requests"))
+      requests.push_back(deserialize_request(request, time_now));
+
+    return PlanningProblem(
+      std::move(configuration),
+      deserialize_options(json.at("options"), time_now),
+      time_now,
+      std::move(agents),
+      std::move(requests));
+  }
+  catch (const nlohmann::json::exception& e)
+  {
+    throw std::runtime_error(
+      std::string("[rmf_task::PlanningProblem::deserialize] Malformed "
+      "planning problem: ") + e.what());
+  }
+}
+
+//==============================================================================
+nlohmann::json PlanningProblem::serialize_result(
+  const TaskPlanner::Result& result) const
+{
+  if (const auto* error = std::get_if<TaskPlanner::TaskPlannerError>(&result))
+    return {{"error", static_cast<int>(*error)}};
+
+  const auto time_now = _pimpl->time_now;
+  std::unordered_map<const Request*, std::size_t> indices;
+  for (std::size_t i = 0; i < _pimpl->requests.size(); ++i)
+    indices.insert({_pimpl->requests[i].get(), i});
+
+  nlohmann::json agents = nlohmann::json::array();
+  for (const auto& agent : std::get<TaskPlanner::Assignments>(result))
+  {
+    nlohmann::json assignments = nlohmann::json::array();
+    for (const auto& assignment : agent)
+    {
+      const auto it = indices.find(assignment.request().get());
+      assignments.push_back(
+        {
+          {"request", it != indices.end() ?
+            nlohmann::json(it->second) :
+            serialize_request(*assignment.request(), time_now)},
+          {"finish", serialize_state(assignment.finish_state(), time_now)},
+          {"deployment", to_ns(assignment.deployment_time() - time_now)}
+        });
+    }
+
+    agents.push_back(std::move(assignments));
+  }
+
+  return {{"assignments", std::move(agents)}};
+}
+
+//==============================================================================
+TaskPlanner::Result PlanningProblem::deserialize_result(
+  const nlohmann::json& json) const
+{
+  const auto time_now = _pimpl->time_now;
+  const auto& requests = _pimpl->requests;
+  try
+  {
+    if (json.contains("error"))
+    {
+      return static_cast<TaskPlanner::TaskPlannerError>(
+        json.at("error").get<int>());
+    }
+
+    TaskPlanner::Assignments assignments;
+    for (const auto& agent : json.at("assignments"))
+    {
+      auto& output = assignments.emplace_back();
+      for (const auto& assignment : agent)
+      {
+        const auto& r = assignment.at("request");
+        ConstRequestPtr request;
+        if (r.is_number_unsigned())
+        {
+          const auto index = r.get<std::size_t>();
+          if (index >= requests.size())
+          {
+            throw std::runtime_error(
+              "[rmf_task::PlanningProblem::deserialize_result] Request ["
+              + std::to_string(index) + "] is not in a problem of ["
+              + std::to_string(requests.size()) + "] requests");
+          }
+
+          request = requests[index];
+        }
+        else
+        {
+          request = deserialize_request(r, time_now);
+        }
+
+        output.emplace_back(
+          std::move(request),
+          deserialize_state(assignment.at("finish"), time_now),
+          time_now + from_ns(assignment.at("deployment").get<int64_t>()));
+      }
+    }
+
+    return assignments;
+  }
+  catch (const nlohmann::json::exception& e)
+  {
+    throw std::runtime_error(
+      std::string("[rmf_task::PlanningProblem::deserialize_result] Malformed "
+      "result: ") + e.what());
+  }
+}
+
+} // namespace rmf_task
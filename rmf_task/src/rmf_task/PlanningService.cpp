@@ -0,0 +1,173 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/PlanningService.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace rmf_task {
+
+namespace {
+//==============================================================================
+// Plans each cluster by serializing it and handing it to whichever worker is
+// idle. Each worker is only given one cluster at a time.
+class WorkerSolver : public TaskPlanner::ClusterSolver
+{
+public:
+
+  WorkerSolver(
+    TaskPlanner::Configuration configuration_,
+    std::vector<PlanningService::Worker> workers_)
+  : configuration(std::move(configuration_)),
+    workers(std::move(workers_))
+  {
+    for (std::size_t i = 0; i < workers.size(); ++i)
+      idle.push_back(i);
+  }
+
+  Solution solve(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const std::vector<ConstRequestPtr>& requests,
+    const TaskPlanner::Options& options) const final
+  {
+    // The deliveries were already pooled before the problem was divided
+    auto subproblem_options = options;
+    subproblem_options.pool_deliveries(std::nullopt);
+    const PlanningProblem subproblem(
+      configuration, subproblem_options, time_now, agents, requests);
+    const auto serialized = subproblem.serialize();
+
+    std::size_t worker;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      became_idle.wait(lock, [&]() { return !idle.empty(); });
+      worker = idle.back();
+      idle.pop_back();
+    }
+
+    nlohmann::json result;
+    try
+    {
+      result = workers[worker](serialized);
+    }
+    catch (...)
+    {
+      release(worker);
+      throw;
+    }
+
+    release(worker);
+    return Solution{
+      subproblem.deserialize_result(result),
+      result.value("interrupted", false),
+      result.value("pruned", false)
+    };
+  }
+
+  std::size_t concurrency() const final
+  {
+    return workers.size();
+  }
+
+private:
+
+  void release(std::size_t worker) const
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      idle.push_back(worker);
+    }
+    became_idle.notify_one();
+  }
+
+  TaskPlanner::Configuration configuration;
+  std::vector<PlanningService::Worker> workers;
+
+  mutable std::mutex mutex;
+  mutable std::condition_variable became_idle;
+  mutable std::vector<std::size_t> idle;
+};
+} // anonymous namespace
+
+//==============================================================================
+class PlanningService::Implementation
+{
+public:
+
+  TaskPlanner::Partitioner partitioner;
+  std::vector<Worker> workers;
+};
+
+//==============================================================================
+PlanningService::PlanningService(
+  TaskPlanner::Partitioner partitioner,
+  std::vector<Worker> workers)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{
+        std::move(partitioner),
+        std::move(workers)
+      }))
+{
+  if (_pimpl->workers.empty())
+    _pimpl->workers.push_back(&PlanningService::work);
+}
+
+//==============================================================================
+TaskPlanner::Result PlanningService::plan(
+  const nlohmann::json& problem,
+  const rmf_traffic::Time time_now) const
+{
+  return plan(PlanningProblem::deserialize(problem, time_now));
+}
+
+//==============================================================================
+TaskPlanner::Result PlanningService::plan(const PlanningProblem& problem) const
+{
+  auto configuration = problem.configuration();
+  configuration
+  .partitioner(_pimpl->partitioner)
+  .cluster_solver(
+    std::make_shared<WorkerSolver>(problem.configuration(), _pimpl->workers));
+
+  TaskPlanner planner(std::move(configuration), problem.options());
+  return planner.plan(problem.time_now(), problem.agents(), problem.requests());
+}
+
+//==============================================================================
+nlohmann::json PlanningService::work(const nlohmann::json& subproblem)
+{
+  // Times are relative to time_now in both the subproblem and its result, so
+  // the clock of this machine is only used for the deadlines of the search
+  const auto problem = PlanningProblem::deserialize(
+    subproblem, std::chrono::steady_clock::now());
+
+  TaskPlanner planner(problem.configuration(), problem.options());
+  auto result = problem.serialize_result(
+    planner.plan(problem.time_now(), problem.agents(), problem.requests()));
+
+  // The planner that merges the clusters reports whether any was interrupted
+  // or pruned
+  const auto statistics = planner.statistics();
+  result["interrupted"] = statistics.interrupted();
+  result["pruned"] = statistics.pruned();
+  return result;
+}
+
+} // namespace rmf_task
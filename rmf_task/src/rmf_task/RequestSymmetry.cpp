@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "RequestSymmetry.hpp"
+
+#include <rmf_task/requests/ChargeBattery.hpp>
+#include <rmf_task/requests/Clean.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/Loop.hpp>
+
+namespace rmf_task {
+
+namespace {
+
+//==============================================================================
+bool same_priority(const ConstPriorityPtr& a, const ConstPriorityPtr& b)
+{
+  if (!a || !b)
+    return !a && !b;
+
+  return a->serialize() == b->serialize();
+}
+
+//==============================================================================
+bool same_payload(const Payload& a, const Payload& b)
+{
+  const auto& ca = a.components();
+  const auto& cb = b.components();
+  if (ca.size() != cb.size())
+    return false;
+
+  for (std::size_t i = 0; i < ca.size(); ++i)
+  {
+    if (ca[i].sku() != cb[i].sku()
+      || ca[i].quantity() != cb[i].quantity()
+      || ca[i].compartment() != cb[i].compartment())
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+bool same_path(
+  const rmf_traffic::Trajectory& a,
+  const rmf_traffic::Trajectory& b)
+{
+  if (a.size() != b.size())
+    return false;
+
+  auto it_a = a.begin();
+  auto it_b = b.begin();
+  for (; it_a != a.end(); ++it_a, ++it_b)
+  {
+    if (it_a->time() != it_b->time()
+      || it_a->position() != it_b->position()
+      || it_a->velocity() != it_b->velocity())
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================================
+bool same_description(const Task::Description& a, const Task::Description& b)
+{
+  using namespace requests;
+  if (const auto* da = dynamic_cast<const Delivery::Description*>(&a))
+  {
+    const auto* db = dynamic_cast<const Delivery::Description*>(&b);
+    return db
+      && da->pickup_waypoint() == db->pickup_waypoint()
+      && da->pickup_wait() == db->pickup_wait()
+      && da->pickup_from_dispenser() == db->pickup_from_dispenser()
+      && da->dropoff_waypoint() == db->dropoff_waypoint()
+      && da->dropoff_wait() == db->dropoff_wait()
+      && da->dropoff_to_ingestor() == db->dropoff_to_ingestor()
+      && same_payload(da->payload(), db->payload());
+  }
+
+  if (const auto* ca = dynamic_cast<const Clean::Description*>(&a))
+  {
+    const auto* cb = dynamic_cast<const Clean::Description*>(&b);
+    return cb
+      && ca->start_waypoint() == cb->start_waypoint()
+      && ca->end_waypoint() == cb->end_waypoint()
+      && same_path(ca->cleaning_path(), cb->cleaning_path());
+  }
+
+  if (const auto* la = dynamic_cast<const Loop::Description*>(&a))
+  {
+    const auto* lb = dynamic_cast<const Loop::Description*>(&b);
+    return lb
+      && la->start_waypoint() == lb->start_waypoint()
+      && la->finish_waypoint() == lb->finish_waypoint()
+      && la->num_loops() == lb->num_loops()
+      && la->charge_between_loops() == lb->charge_between_loops();
+  }
+
+  if (const auto* ca = dynamic_cast<const ChargeBattery::Description*>(&a))
+  {
+    const auto* cb = dynamic_cast<const ChargeBattery::Description*>(&b);
+    return cb
+      && ca->indefinite() == cb->indefinite()
+      && ca->target_soc() == cb->target_soc();
+  }
+
+  return false;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+bool interchangeable(const Request& a, const Request& b)
+{
+  const auto& booking_a = *a.booking();
+  const auto& booking_b = *b.booking();
+  if (booking_a.earliest_start_time() != booking_b.earliest_start_time()
+    || !same_priority(booking_a.priority(), booking_b.priority()))
+    return false;
+
+  return same_description(*a.description(), *b.description());
+}
+
+} // namespace rmf_task
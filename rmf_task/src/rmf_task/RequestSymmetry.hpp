@@ -0,0 +1,35 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__REQUESTSYMMETRY_HPP
+#define SRC__RMF_TASK__REQUESTSYMMETRY_HPP
+
+#include <rmf_task/Request.hpp>
+
+namespace rmf_task {
+
+// Whether the planner may treat two requests as interchangeable, i.e. whether
+// swapping them in any plan leaves its cost unchanged. This holds when their
+// bookings have the same earliest start time and priority and their
+// descriptions are of the same built-in type with the same fields. Requests
+// with descriptions of any other type are never interchangeable, since their
+// fields cannot be compared.
+bool interchangeable(const Request& a, const Request& b);
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__REQUESTSYMMETRY_HPP
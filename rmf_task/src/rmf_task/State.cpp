@@ -109,6 +109,22 @@ State& State::battery_soc(double new_battery_soc)
   return *this;
 }
 
+//==============================================================================
+std::optional<uint32_t> State::payload_capacity() const
+{
+  if (const auto* c = get<PayloadCapacity>())
+    return c->value;
+
+  return std::nullopt;
+}
+
+//==============================================================================
+State& State::payload_capacity(uint32_t new_payload_capacity)
+{
+  with<PayloadCapacity>(new_payload_capacity);
+  return *this;
+}
+
 //==============================================================================
 State& State::load_basic(
   const rmf_traffic::agv::Plan::Start& input_location,
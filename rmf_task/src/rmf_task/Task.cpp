@@ -153,6 +153,62 @@ const Header& Task::Tag::header() const
   return _pimpl->header;
 }
 
+//==============================================================================
+double Task::Model::min_battery_drain() const
+{
+  return 0.0;
+}
+
+//==============================================================================
+auto Task::Model::make_kernel(
+  const State&,
+  const Constraints&,
+  const TravelEstimator&) const -> ConstKernelPtr
+{
+  return nullptr;
+}
+
+//==============================================================================
+std::size_t Task::Description::dispatch_index() const
+{
+  return _dispatch_index.get(typeid(*this));
+}
+
+//==============================================================================
+MemoryUsage Task::Active::memory_usage() const
+{
+  using Component = MemoryUsage::Component;
+  MemoryUsage usage;
+  for (const auto& completed : completed_phases())
+  {
+    if (completed && completed->snapshot())
+    {
+      if (const auto event = completed->snapshot()->final_event())
+        usage.add(event->memory_usage());
+    }
+  }
+
+  if (const auto active = active_phase())
+  {
+    if (const auto event = active->final_event())
+      usage.add(event->memory_usage());
+  }
+
+  for (const auto& pending : pending_phases())
+  {
+    std::size_t bytes = sizeof(Phase::Pending);
+    if (const auto& tag = pending.tag())
+    {
+      bytes += tag->header().category().capacity()
+        + tag->header().detail().capacity();
+    }
+
+    usage.add(Component::PendingPhases, bytes);
+  }
+
+  return usage;
+}
+
 //==============================================================================
 Task::Active::Resume Task::Active::make_resumer(std::function<void()> callback)
 {
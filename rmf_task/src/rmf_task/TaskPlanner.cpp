@@ -15,18 +15,40 @@
  *
 */
 
+#include <rmf_task/AllocationCounter.hpp>
 #include <rmf_task/Estimate.hpp>
 #include <rmf_task/State.hpp>
 #include <rmf_task/BinaryPriorityScheme.hpp>
 #include <rmf_task/requests/ChargeBattery.hpp>
 
+#include "Affinity.hpp"
 #include "BinaryPriorityCostCalculator.hpp"
+#include "DeliveryPooling.hpp"
+#include "EstimateProfiler.hpp"
+#include "RequestSymmetry.hpp"
+#include "ThreadPool.hpp"
+#include "TraceSpan.hpp"
 
 #include <rmf_traffic/Time.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <exception>
+#include <iomanip>
 #include <limits>
-#include <queue>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 #include <string_view>
+#include <thread>
+#include <unordered_set>
 
 namespace rmf_task {
 
@@ -38,6 +60,12 @@ public:
   Parameters parameters;
   Constraints constraints;
   ConstCostCalculatorPtr cost_calculator;
+  ConstTravelEstimatorPtr travel_estimator = nullptr;
+  TraceSinkPtr trace_sink = nullptr;
+  Partitioner partitioner = nullptr;
+  ConstClusterSolverPtr cluster_solver = nullptr;
+  ExecutorPtr executor = nullptr;
+  std::size_t result_cache_size = 0;
 };
 
 //==============================================================================
@@ -98,6 +126,92 @@ auto TaskPlanner::Configuration::cost_calculator(
   return *this;
 }
 
+//==============================================================================
+const ConstTravelEstimatorPtr&
+TaskPlanner::Configuration::travel_estimator() const
+{
+  return _pimpl->travel_estimator;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::travel_estimator(
+  ConstTravelEstimatorPtr travel_estimator) -> Configuration&
+{
+  _pimpl->travel_estimator = std::move(travel_estimator);
+  return *this;
+}
+
+//==============================================================================
+const TraceSinkPtr& TaskPlanner::Configuration::trace_sink() const
+{
+  return _pimpl->trace_sink;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::trace_sink(TraceSinkPtr sink)
+-> Configuration&
+{
+  _pimpl->trace_sink = std::move(sink);
+  return *this;
+}
+
+//==============================================================================
+const ExecutorPtr& TaskPlanner::Configuration::executor() const
+{
+  return _pimpl->executor;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::executor(ExecutorPtr executor)
+-> Configuration&
+{
+  _pimpl->executor = std::move(executor);
+  return *this;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::partitioner() const -> const Partitioner&
+{
+  return _pimpl->partitioner;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::partitioner(Partitioner partitioner)
+-> Configuration&
+{
+  _pimpl->partitioner = std::move(partitioner);
+  return *this;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::cluster_solver() const
+-> const ConstClusterSolverPtr&
+{
+  return _pimpl->cluster_solver;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::cluster_solver(ConstClusterSolverPtr solver)
+-> Configuration&
+{
+  _pimpl->cluster_solver = std::move(solver);
+  return *this;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Configuration::result_cache_size() const
+{
+  return _pimpl->result_cache_size;
+}
+
+//==============================================================================
+auto TaskPlanner::Configuration::result_cache_size(std::size_t size)
+-> Configuration&
+{
+  _pimpl->result_cache_size = size;
+  return *this;
+}
+
 //==============================================================================
 class TaskPlanner::Options::Implementation
 {
@@ -106,6 +220,39 @@ public:
   bool greedy;
   std::function<bool()> interrupter;
   ConstRequestFactoryPtr finishing_request;
+  std::size_t expansion_threads = 1;
+  std::size_t search_threads = 1;
+  std::vector<std::size_t> cpu_affinity = {};
+  std::size_t arena_reserve = 0;
+  std::pmr::memory_resource* memory_resource = nullptr;
+  std::optional<std::uint64_t> deterministic_seed = std::nullopt;
+  std::optional<rmf_traffic::Duration> local_search_budget = std::nullopt;
+  std::size_t max_open_nodes = 0;
+  bool anytime = false;
+  ImprovementCallback improvement_callback = nullptr;
+  CommitmentCallback commitment_callback = nullptr;
+  std::optional<rmf_traffic::Time> deadline = std::nullopt;
+  std::optional<rmf_traffic::Duration> time_budget = std::nullopt;
+  std::size_t horizon = 0;
+  std::size_t commit_window = 0;
+  bool greedy_by_finish_time = false;
+  std::size_t greedy_restarts = 0;
+  double greedy_restart_alpha = 0.2;
+  std::optional<rmf_traffic::Duration> neighborhood_search_budget =
+    std::nullopt;
+  std::size_t neighborhood_size = 8;
+  std::size_t parallel_neighborhoods = 1;
+  std::optional<rmf_traffic::Duration> delivery_pooling_window = std::nullopt;
+  bool break_agent_symmetry = false;
+  double agent_symmetry_soc_tolerance = 0.0;
+  rmf_traffic::Duration agent_symmetry_time_tolerance =
+    rmf_traffic::Duration(0);
+  bool break_request_symmetry = false;
+  bool prune_dominated_nodes = false;
+  std::optional<double> partial_charging_margin = std::nullopt;
+  std::optional<rmf_traffic::Duration> opportunistic_charging_detour =
+    std::nullopt;
+  bool profile_estimates = false;
 };
 
 //==============================================================================
@@ -165,944 +312,6062 @@ ConstRequestFactoryPtr TaskPlanner::Options::finishing_request() const
 }
 
 //==============================================================================
-class TaskPlanner::Assignment::Implementation
+auto TaskPlanner::Options::expansion_threads(std::size_t value) -> Options&
 {
-public:
+  _pimpl->expansion_threads = value;
+  return *this;
+}
 
-  rmf_task::ConstRequestPtr request;
-  State state;
-  rmf_traffic::Time deployment_time;
-};
+//==============================================================================
+std::size_t TaskPlanner::Options::expansion_threads() const
+{
+  return _pimpl->expansion_threads;
+}
 
 //==============================================================================
-TaskPlanner::Assignment::Assignment(
-  rmf_task::ConstRequestPtr request,
-  State state,
-  rmf_traffic::Time deployment_time)
-: _pimpl(rmf_utils::make_impl<Implementation>(
-      Implementation{
-        std::move(request),
-        std::move(state),
-        deployment_time
-      }))
+auto TaskPlanner::Options::search_threads(std::size_t value) -> Options&
 {
-  // Do nothing
+  _pimpl->search_threads = value;
+  return *this;
 }
 
 //==============================================================================
-const rmf_task::ConstRequestPtr& TaskPlanner::Assignment::request() const
+std::size_t TaskPlanner::Options::search_threads() const
 {
-  return _pimpl->request;
+  return _pimpl->search_threads;
 }
 
 //==============================================================================
-const State& TaskPlanner::Assignment::finish_state() const
+auto TaskPlanner::Options::cpu_affinity(std::vector<std::size_t> cores)
+-> Options&
 {
-  return _pimpl->state;
+  _pimpl->cpu_affinity = std::move(cores);
+  return *this;
 }
 
 //==============================================================================
-const rmf_traffic::Time TaskPlanner::Assignment::deployment_time() const
+const std::vector<std::size_t>& TaskPlanner::Options::cpu_affinity() const
 {
-  return _pimpl->deployment_time;
+  return _pimpl->cpu_affinity;
 }
 
 //==============================================================================
+auto TaskPlanner::Options::arena_reserve(std::size_t bytes) -> Options&
+{
+  _pimpl->arena_reserve = bytes;
+  return *this;
+}
 
-namespace {
+//==============================================================================
+std::size_t TaskPlanner::Options::arena_reserve() const
+{
+  return _pimpl->arena_reserve;
+}
 
-// ============================================================================
-// The type of filter used for solving the task assignment problem
-enum class FilterType
+//==============================================================================
+auto TaskPlanner::Options::memory_resource(
+  std::pmr::memory_resource* resource) -> Options&
 {
-  Passthrough,
-  Trie,
-  Hash
-};
+  _pimpl->memory_resource = resource;
+  return *this;
+}
 
-// ============================================================================
-class Filter
+//==============================================================================
+std::pmr::memory_resource* TaskPlanner::Options::memory_resource() const
 {
-public:
+  return _pimpl->memory_resource;
+}
 
-  Filter(FilterType type, const std::size_t N_tasks)
-  : _type(type),
-    _set(N_tasks, AssignmentHash(N_tasks))
-  {
-    // Do nothing
-  }
+//==============================================================================
+auto TaskPlanner::Options::deterministic_seed(std::optional<std::uint64_t> seed)
+-> Options&
+{
+  _pimpl->deterministic_seed = seed;
+  return *this;
+}
 
-  bool ignore(const Node& node);
+//==============================================================================
+std::optional<std::uint64_t> TaskPlanner::Options::deterministic_seed() const
+{
+  return _pimpl->deterministic_seed;
+}
 
-private:
+//==============================================================================
+auto TaskPlanner::Options::local_search_budget(
+  std::optional<rmf_traffic::Duration> budget) -> Options&
+{
+  _pimpl->local_search_budget = budget;
+  return *this;
+}
 
-  struct TaskTable;
+//==============================================================================
+std::optional<rmf_traffic::Duration>
+TaskPlanner::Options::local_search_budget() const
+{
+  return _pimpl->local_search_budget;
+}
 
-  struct AgentTable
-  {
-    std::unordered_map<std::size_t, std::unique_ptr<TaskTable>> agent;
-  };
+//==============================================================================
+auto TaskPlanner::Options::max_open_nodes(std::size_t value) -> Options&
+{
+  _pimpl->max_open_nodes = value;
+  return *this;
+}
 
-  struct TaskTable
-  {
-    std::unordered_map<std::size_t, std::unique_ptr<AgentTable>> task;
-  };
+//==============================================================================
+std::size_t TaskPlanner::Options::max_open_nodes() const
+{
+  return _pimpl->max_open_nodes;
+}
 
-  struct AssignmentHash
-  {
-    AssignmentHash(std::size_t N)
-    {
-      // We add 1 to N because
-      _shift = std::ceil(std::log2(N+1));
-    }
+//==============================================================================
+auto TaskPlanner::Options::anytime(bool value) -> Options&
+{
+  _pimpl->anytime = value;
+  return *this;
+}
 
-    std::size_t operator()(const Node::AssignedTasks& assignments) const
-    {
-      std::size_t output = 0;
-      std::size_t count = 0;
-      for (const auto& a : assignments)
-      {
-        for (const auto& s : a)
-        {
-          // We add 1 to the task_id to differentiate between task_id == 0 and
-          // a task being unassigned.
-          const std::size_t id = s.internal_id + 1;
-          output += id << (_shift * (count++));
-        }
-      }
+//==============================================================================
+bool TaskPlanner::Options::anytime() const
+{
+  return _pimpl->anytime;
+}
 
-      return output;
-    }
+//==============================================================================
+auto TaskPlanner::Options::improvement_callback(ImprovementCallback callback)
+-> Options&
+{
+  _pimpl->improvement_callback = std::move(callback);
+  return *this;
+}
 
-    std::size_t _shift;
-  };
+//==============================================================================
+auto TaskPlanner::Options::improvement_callback() const
+-> const ImprovementCallback&
+{
+  return _pimpl->improvement_callback;
+}
 
-  struct AssignmentEqual
-  {
-    bool operator()(
-      const Node::AssignedTasks& A, const Node::AssignedTasks& B) const
-    {
-      if (A.size() != B.size())
-        return false;
+//==============================================================================
+auto TaskPlanner::Options::commitment_callback(CommitmentCallback callback)
+-> Options&
+{
+  _pimpl->commitment_callback = std::move(callback);
+  return *this;
+}
 
-      for (std::size_t i = 0; i < A.size(); ++i)
-      {
-        const auto& a = A[i];
-        const auto& b = B[i];
+//==============================================================================
+auto TaskPlanner::Options::commitment_callback() const
+-> const CommitmentCallback&
+{
+  return _pimpl->commitment_callback;
+}
 
-        if (a.size() != b.size())
-          return false;
+//==============================================================================
+auto TaskPlanner::Options::deadline(std::optional<rmf_traffic::Time> value)
+-> Options&
+{
+  _pimpl->deadline = value;
+  return *this;
+}
 
-        for (std::size_t j = 0; j < a.size(); ++j)
-        {
-          if (a[j].internal_id != b[j].internal_id)
-          {
-            return false;
-          }
-        }
-      }
+//==============================================================================
+std::optional<rmf_traffic::Time> TaskPlanner::Options::deadline() const
+{
+  return _pimpl->deadline;
+}
 
-      return true;
-    }
-  };
+//==============================================================================
+auto TaskPlanner::Options::time_budget(
+  std::optional<rmf_traffic::Duration> value) -> Options&
+{
+  _pimpl->time_budget = value;
+  return *this;
+}
 
-  using Set = std::unordered_set<Node::AssignedTasks, AssignmentHash,
-      AssignmentEqual>;
+//==============================================================================
+std::optional<rmf_traffic::Duration> TaskPlanner::Options::time_budget() const
+{
+  return _pimpl->time_budget;
+}
 
-  FilterType _type;
-  AgentTable _root;
-  Set _set;
-};
+//==============================================================================
+auto TaskPlanner::Options::rolling_horizon(
+  std::size_t horizon,
+  std::size_t commit_window) -> Options&
+{
+  _pimpl->horizon = horizon;
+  _pimpl->commit_window = commit_window;
+  return *this;
+}
 
-bool Filter::ignore(const Node& node)
+//==============================================================================
+std::size_t TaskPlanner::Options::horizon() const
 {
-  if (_type == FilterType::Passthrough)
-    return false;
+  return _pimpl->horizon;
+}
 
-  if (_type == FilterType::Hash)
-    return !_set.insert(node.assigned_tasks).second;
+//==============================================================================
+std::size_t TaskPlanner::Options::commit_window() const
+{
+  return _pimpl->commit_window;
+}
 
-  bool new_node = false;
+//==============================================================================
+auto TaskPlanner::Options::greedy_by_finish_time(bool value) -> Options&
+{
+  _pimpl->greedy_by_finish_time = value;
+  return *this;
+}
 
-  AgentTable* agent_table = &_root;
-  std::size_t a = 0;
-  std::size_t t = 0;
-  while (a < node.assigned_tasks.size())
-  {
-    const auto& current_agent = node.assigned_tasks.at(a);
+//==============================================================================
+bool TaskPlanner::Options::greedy_by_finish_time() const
+{
+  return _pimpl->greedy_by_finish_time;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::greedy_restarts(std::size_t count, double alpha)
+-> Options&
+{
+  _pimpl->greedy_restarts = count;
+  _pimpl->greedy_restart_alpha = std::clamp(alpha, 0.0, 1.0);
+  return *this;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Options::greedy_restarts() const
+{
+  return _pimpl->greedy_restarts;
+}
+
+//==============================================================================
+double TaskPlanner::Options::greedy_restart_alpha() const
+{
+  return _pimpl->greedy_restart_alpha;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::neighborhood_search(
+  std::optional<rmf_traffic::Duration> budget,
+  std::size_t neighborhood_size,
+  std::size_t parallel_neighborhoods) -> Options&
+{
+  _pimpl->neighborhood_search_budget = budget;
+  _pimpl->neighborhood_size = std::max<std::size_t>(1, neighborhood_size);
+  _pimpl->parallel_neighborhoods =
+    std::max<std::size_t>(1, parallel_neighborhoods);
+  return *this;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration>
+TaskPlanner::Options::neighborhood_search_budget() const
+{
+  return _pimpl->neighborhood_search_budget;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Options::neighborhood_size() const
+{
+  return _pimpl->neighborhood_size;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Options::parallel_neighborhoods() const
+{
+  return _pimpl->parallel_neighborhoods;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::pool_deliveries(
+  std::optional<rmf_traffic::Duration> window) -> Options&
+{
+  _pimpl->delivery_pooling_window = window;
+  return *this;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration>
+TaskPlanner::Options::delivery_pooling_window() const
+{
+  return _pimpl->delivery_pooling_window;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::break_agent_symmetry(
+  bool value,
+  double soc_tolerance,
+  rmf_traffic::Duration time_tolerance) -> Options&
+{
+  _pimpl->break_agent_symmetry = value;
+  _pimpl->agent_symmetry_soc_tolerance = std::max(0.0, soc_tolerance);
+  _pimpl->agent_symmetry_time_tolerance =
+    std::max(rmf_traffic::Duration(0), time_tolerance);
+  return *this;
+}
+
+//==============================================================================
+bool TaskPlanner::Options::break_agent_symmetry() const
+{
+  return _pimpl->break_agent_symmetry;
+}
+
+//==============================================================================
+double TaskPlanner::Options::agent_symmetry_soc_tolerance() const
+{
+  return _pimpl->agent_symmetry_soc_tolerance;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Options::agent_symmetry_time_tolerance()
+const
+{
+  return _pimpl->agent_symmetry_time_tolerance;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::break_request_symmetry(bool value) -> Options&
+{
+  _pimpl->break_request_symmetry = value;
+  return *this;
+}
+
+//==============================================================================
+bool TaskPlanner::Options::break_request_symmetry() const
+{
+  return _pimpl->break_request_symmetry;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::prune_dominated_nodes(bool value) -> Options&
+{
+  _pimpl->prune_dominated_nodes = value;
+  return *this;
+}
+
+//==============================================================================
+bool TaskPlanner::Options::prune_dominated_nodes() const
+{
+  return _pimpl->prune_dominated_nodes;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::partial_charging(std::optional<double> margin)
+-> Options&
+{
+  if (margin.has_value())
+    margin = std::max(0.0, *margin);
+
+  _pimpl->partial_charging_margin = margin;
+  return *this;
+}
+
+//==============================================================================
+std::optional<double> TaskPlanner::Options::partial_charging_margin() const
+{
+  return _pimpl->partial_charging_margin;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::opportunistic_charging(
+  std::optional<rmf_traffic::Duration> max_detour) -> Options&
+{
+  _pimpl->opportunistic_charging_detour = max_detour;
+  return *this;
+}
+
+//==============================================================================
+std::optional<rmf_traffic::Duration>
+TaskPlanner::Options::opportunistic_charging_detour() const
+{
+  return _pimpl->opportunistic_charging_detour;
+}
+
+//==============================================================================
+auto TaskPlanner::Options::profile_estimates(bool value) -> Options&
+{
+  _pimpl->profile_estimates = value;
+  return *this;
+}
+
+//==============================================================================
+bool TaskPlanner::Options::profile_estimates() const
+{
+  return _pimpl->profile_estimates;
+}
+
+//==============================================================================
+class TaskPlanner::Assignment::Implementation
+{
+public:
+
+  rmf_task::ConstRequestPtr request;
+  State state;
+  rmf_traffic::Time deployment_time;
+  bool is_charging;
+  Task::ConstModelPtr model;
+};
+
+//==============================================================================
+namespace {
+bool is_charging_request(const ConstRequestPtr& request)
+{
+  return request && static_cast<bool>(
+    std::dynamic_pointer_cast<
+      const rmf_task::requests::ChargeBattery::Description>(
+      request->description()));
+}
+} // anonymous namespace
+
+//==============================================================================
+TaskPlanner::Assignment::Assignment(
+  rmf_task::ConstRequestPtr request,
+  State state,
+  rmf_traffic::Time deployment_time,
+  Task::ConstModelPtr model)
+: _pimpl(rmf_utils::make_impl<Implementation>(
+      Implementation{
+        request,
+        std::move(state),
+        deployment_time,
+        is_charging_request(request),
+        std::move(model)
+      }))
+{
+  // Do nothing
+}
+
+//==============================================================================
+const rmf_task::ConstRequestPtr& TaskPlanner::Assignment::request() const
+{
+  return _pimpl->request;
+}
+
+//==============================================================================
+const State& TaskPlanner::Assignment::finish_state() const
+{
+  return _pimpl->state;
+}
+
+//==============================================================================
+const rmf_traffic::Time TaskPlanner::Assignment::deployment_time() const
+{
+  return _pimpl->deployment_time;
+}
+
+//==============================================================================
+bool TaskPlanner::Assignment::is_charging() const
+{
+  return _pimpl->is_charging;
+}
+
+//==============================================================================
+const Task::ConstModelPtr& TaskPlanner::Assignment::model() const
+{
+  return _pimpl->model;
+}
+
+//==============================================================================
+class TaskPlanner::FlatAssignments::Implementation
+{
+public:
+
+  std::vector<Record> records;
+  std::vector<std::size_t> offsets;
+};
+
+//==============================================================================
+TaskPlanner::FlatAssignments::FlatAssignments()
+: _pimpl(std::make_shared<Implementation>(Implementation{{}, {0}}))
+{
+  // Do nothing
+}
+
+//==============================================================================
+TaskPlanner::FlatAssignments::FlatAssignments(const Assignments& assignments)
+{
+  auto table = std::make_shared<Implementation>();
+  std::size_t size = 0;
+  for (const auto& agent : assignments)
+    size += agent.size();
+
+  table->records.reserve(size);
+  table->offsets.reserve(assignments.size() + 1);
+  for (std::size_t i = 0; i < assignments.size(); ++i)
+  {
+    table->offsets.push_back(table->records.size());
+    for (const auto& a : assignments[i])
+    {
+      const auto& state = a.finish_state();
+      table->records.push_back(
+        Record{
+          i,
+          a.request(),
+          a.deployment_time(),
+          state.time().value(),
+          state.battery_soc().value(),
+          state.waypoint().value()
+        });
+    }
+  }
+  table->offsets.push_back(table->records.size());
+
+  _pimpl = std::move(table);
+}
+
+//==============================================================================
+std::size_t TaskPlanner::FlatAssignments::num_agents() const
+{
+  return _pimpl->offsets.size() - 1;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::FlatAssignments::size() const
+{
+  return _pimpl->records.size();
+}
+
+//==============================================================================
+auto TaskPlanner::FlatAssignments::records() const -> const std::vector<Record>&
+{
+  return _pimpl->records;
+}
+
+//==============================================================================
+const std::vector<std::size_t>& TaskPlanner::FlatAssignments::offsets() const
+{
+  return _pimpl->offsets;
+}
+
+//==============================================================================
+auto TaskPlanner::FlatAssignments::begin(std::size_t agent) const
+-> const Record*
+{
+  return _pimpl->records.data() + _pimpl->offsets.at(agent);
+}
+
+//==============================================================================
+auto TaskPlanner::FlatAssignments::end(std::size_t agent) const
+-> const Record*
+{
+  return _pimpl->records.data() + _pimpl->offsets.at(agent + 1);
+}
+
+//==============================================================================
+auto TaskPlanner::FlatAssignments::to_assignments(
+  const std::vector<State>& agents) const -> Assignments
+{
+  if (agents.size() != num_agents())
+  {
+    throw std::runtime_error(
+      "[TaskPlanner::FlatAssignments::to_assignments] Given ["
+      + std::to_string(agents.size()) + "] initial states for a table of ["
+      + std::to_string(num_agents()) + "] agents");
+  }
+
+  Assignments assignments(num_agents());
+  for (std::size_t i = 0; i < assignments.size(); ++i)
+  {
+    auto& agent = assignments[i];
+    agent.reserve(end(i) - begin(i));
+    for (const Record* r = begin(i); r != end(i); ++r)
+    {
+      State state = agents[i];
+      state.time(r->finish_time);
+      state.battery_soc(r->finish_soc);
+      state.waypoint(r->finish_waypoint);
+      agent.emplace_back(r->request, std::move(state), r->deployment_time);
+    }
+  }
+
+  return assignments;
+}
+
+//==============================================================================
+class TaskPlanner::Statistics::Implementation
+{
+public:
+
+  bool interrupted = false;
+  bool pruned = false;
+  double suboptimality_bound = 1.0;
+  TravelEstimator::Statistics travel_estimates;
+  std::vector<InfeasibleRequest> infeasible_requests;
+  std::size_t nodes_expanded = 0;
+  std::size_t nodes_filtered = 0;
+  std::size_t nodes_bounded = 0;
+  std::size_t nodes_symmetric = 0;
+  std::size_t peak_open_nodes = 0;
+  std::size_t finish_estimates = 0;
+  std::size_t kernel_reuses = 0;
+  std::size_t segments = 0;
+  rmf_traffic::Duration initialization_time = rmf_traffic::Duration(0);
+  rmf_traffic::Duration search_time = rmf_traffic::Duration(0);
+  rmf_traffic::Duration finishing_time = rmf_traffic::Duration(0);
+  std::vector<EstimateProfile> estimate_profiles;
+  AllocationCounter::Counts allocations;
+  bool cached = false;
+
+  static Implementation& get(Statistics& statistics)
+  {
+    return *statistics._pimpl;
+  }
+
+  void record_segment(double cost, double lower_bound)
+  {
+    double bound = std::numeric_limits<double>::infinity();
+    if (cost <= lower_bound)
+      bound = 1.0;
+    else if (lower_bound > 0.0)
+      bound = cost / lower_bound;
+
+    suboptimality_bound = std::max(suboptimality_bound, bound);
+  }
+};
+
+//==============================================================================
+TaskPlanner::Statistics::Statistics()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+bool TaskPlanner::Statistics::interrupted() const
+{
+  return _pimpl->interrupted;
+}
+
+//==============================================================================
+bool TaskPlanner::Statistics::pruned() const
+{
+  return _pimpl->pruned;
+}
+
+//==============================================================================
+double TaskPlanner::Statistics::suboptimality_bound() const
+{
+  return _pimpl->suboptimality_bound;
+}
+
+//==============================================================================
+auto TaskPlanner::Statistics::travel_estimates() const
+-> const TravelEstimator::Statistics&
+{
+  return _pimpl->travel_estimates;
+}
+
+//==============================================================================
+auto TaskPlanner::Statistics::infeasible_requests() const
+-> const std::vector<InfeasibleRequest>&
+{
+  return _pimpl->infeasible_requests;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::nodes_expanded() const
+{
+  return _pimpl->nodes_expanded;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::nodes_filtered() const
+{
+  return _pimpl->nodes_filtered;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::nodes_bounded() const
+{
+  return _pimpl->nodes_bounded;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::nodes_symmetric() const
+{
+  return _pimpl->nodes_symmetric;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::peak_open_nodes() const
+{
+  return _pimpl->peak_open_nodes;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::finish_estimates() const
+{
+  return _pimpl->finish_estimates;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::kernel_reuses() const
+{
+  return _pimpl->kernel_reuses;
+}
+
+//==============================================================================
+std::size_t TaskPlanner::Statistics::segments() const
+{
+  return _pimpl->segments;
+}
+
+//==============================================================================
+auto TaskPlanner::Statistics::estimate_profiles() const
+-> const std::vector<EstimateProfile>&
+{
+  return _pimpl->estimate_profiles;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Statistics::initialization_time() const
+{
+  return _pimpl->initialization_time;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Statistics::search_time() const
+{
+  return _pimpl->search_time;
+}
+
+//==============================================================================
+rmf_traffic::Duration TaskPlanner::Statistics::finishing_time() const
+{
+  return _pimpl->finishing_time;
+}
+
+//==============================================================================
+auto TaskPlanner::Statistics::allocations() const
+-> const AllocationCounter::Counts&
+{
+  return _pimpl->allocations;
+}
+
+//==============================================================================
+bool TaskPlanner::Statistics::cached() const
+{
+  return _pimpl->cached;
+}
+
+//==============================================================================
+
+namespace {
+
+// ============================================================================
+// The type of filter used for solving the task assignment problem
+enum class FilterType
+{
+  Passthrough,
+  Trie,
+  Hash,
+
+  // Compare the Zobrist keys that the nodes keep of their assignments
+  Zobrist
+};
+
+// ============================================================================
+// An open-addressing set of the assignment keys that a search has seen
+class AssignmentKeySet
+{
+public:
+
+  AssignmentKeySet(const std::size_t expected_size)
+  {
+    std::size_t capacity = 16;
+    while (capacity < 2*expected_size)
+      capacity *= 2;
+
+    _slots.resize(capacity);
+  }
+
+  // Returns true if the key was not in the set before
+  bool insert(const AssignmentKey& key)
+  {
+    // An all-zero key marks an empty slot, so we track it separately
+    if (key == AssignmentKey())
+    {
+      const bool inserted = !_has_zero;
+      _has_zero = true;
+      return inserted;
+    }
+
+    if (2*(_size + 1) > _slots.size())
+      _grow();
+
+    if (!_place(key))
+      return false;
+
+    ++_size;
+    return true;
+  }
+
+private:
+
+  // Returns false if the key is already present
+  bool _place(const AssignmentKey& key)
+  {
+    const std::size_t mask = _slots.size() - 1;
+    for (std::size_t i = key.low & mask;; i = (i + 1) & mask)
+    {
+      auto& slot = _slots[i];
+      if (slot == key)
+        return false;
+
+      if (slot == AssignmentKey())
+      {
+        slot = key;
+        return true;
+      }
+    }
+  }
+
+  void _grow()
+  {
+    std::vector<AssignmentKey> old_slots(2*_slots.size());
+    std::swap(old_slots, _slots);
+    for (const auto& key : old_slots)
+    {
+      if (!(key == AssignmentKey()))
+        _place(key);
+    }
+  }
+
+  std::vector<AssignmentKey> _slots;
+  std::size_t _size = 0;
+  bool _has_zero = false;
+};
+
+// ============================================================================
+class Filter
+{
+public:
+
+  Filter(FilterType type, const std::size_t N_tasks)
+  : _type(type),
+    _set(N_tasks, AssignmentHash(N_tasks)),
+    _keys(type == FilterType::Zobrist ? N_tasks : 0)
+  {
+    // Do nothing
+  }
+
+  bool ignore(const Node& node);
+
+  std::size_t hash(const Node& node) const
+  {
+    // The low bits of the Zobrist key pick the slot in the key set, so the
+    // high bits are used here to keep them independent.
+    if (_type == FilterType::Zobrist)
+      return node.assignment_key.high;
+
+    return _set.hash_function()(node.assigned_tasks);
+  }
+
+private:
+
+  struct TaskTable;
+
+  struct AgentTable
+  {
+    std::unordered_map<std::size_t, std::unique_ptr<TaskTable>> agent;
+  };
+
+  struct TaskTable
+  {
+    std::unordered_map<std::size_t, std::unique_ptr<AgentTable>> task;
+  };
+
+  struct AssignmentHash
+  {
+    AssignmentHash(std::size_t N)
+    {
+      // We add 1 to N because
+      _shift = std::ceil(std::log2(N+1));
+    }
+
+    std::size_t operator()(const Node::AssignedTasks& assignments) const
+    {
+      std::size_t output = 0;
+      std::size_t count = 0;
+      for (const auto& a : assignments)
+      {
+        // The order of the shifts does not matter for the hash as long as it
+        // is consistent, so we walk each list from its back, which is the
+        // cheap direction for a shared assignment list.
+        a.for_each_reverse([&](const Node::AssignmentWrapper& s)
+          {
+            // We add 1 to the task_id to differentiate between task_id == 0
+            // and a task being unassigned.
+            const std::size_t id = s.internal_id + 1;
+            output += id << (_shift * (count++));
+          });
+      }
+
+      return output;
+    }
+
+    std::size_t _shift;
+  };
+
+  struct AssignmentEqual
+  {
+    bool operator()(
+      const Node::AssignedTasks& A, const Node::AssignedTasks& B) const
+    {
+      if (A.size() != B.size())
+        return false;
+
+      for (std::size_t i = 0; i < A.size(); ++i)
+      {
+        const auto& a = A[i];
+        const auto& b = B[i];
+
+        if (a.size() != b.size())
+          return false;
+
+        const auto a_order = a.in_order();
+        const auto b_order = b.in_order();
+        for (std::size_t j = 0; j < a_order.size(); ++j)
+        {
+          if (a_order[j]->internal_id != b_order[j]->internal_id)
+          {
+            return false;
+          }
+        }
+      }
+
+      return true;
+    }
+  };
+
+  using Set = std::unordered_set<Node::AssignedTasks, AssignmentHash,
+      AssignmentEqual>;
+
+  FilterType _type;
+  AgentTable _root;
+  Set _set;
+  AssignmentKeySet _keys;
+};
+
+bool Filter::ignore(const Node& node)
+{
+  if (_type == FilterType::Passthrough)
+    return false;
+
+  if (_type == FilterType::Hash)
+    return !_set.insert(node.assigned_tasks).second;
+
+  if (_type == FilterType::Zobrist)
+    return !_keys.insert(node.assignment_key);
+
+  bool new_node = false;
+
+  AgentTable* agent_table = &_root;
+  std::size_t a = 0;
+  std::size_t t = 0;
+  std::vector<const Node::AssignmentWrapper*> current_agent;
+  if (!node.assigned_tasks.empty())
+    current_agent = node.assigned_tasks.front().in_order();
+
+  while (a < node.assigned_tasks.size())
+  {
+    if (t < current_agent.size())
+    {
+      const auto& task_id = current_agent[t]->internal_id;
+      const auto agent_insertion = agent_table->agent.insert({a, nullptr});
+      if (agent_insertion.second)
+        agent_insertion.first->second = std::make_unique<TaskTable>();
+
+      auto* task_table = agent_insertion.first->second.get();
+
+      const auto task_insertion = task_table->task.insert({task_id, nullptr});
+      if (task_insertion.second)
+      {
+        new_node = true;
+        task_insertion.first->second = std::make_unique<AgentTable>();
+      }
+
+      agent_table = task_insertion.first->second.get();
+      ++t;
+    }
+    else
+    {
+      t = 0;
+      ++a;
+      if (a < node.assigned_tasks.size())
+        current_agent = node.assigned_tasks[a].in_order();
+    }
+  }
+
+  return !new_node;
+}
+
+// ============================================================================
+// A hash filter that can be shared by several search workers. Nodes are
+// distributed across independently locked shards according to the hash of
+// their assignments, so workers only contend when they touch the same shard.
+class ConcurrentFilter
+{
+public:
+
+  ConcurrentFilter(const std::size_t N_tasks, const std::size_t N_shards)
+  {
+    _shards.reserve(N_shards);
+    for (std::size_t i = 0; i < N_shards; ++i)
+      _shards.push_back(std::make_unique<Shard>(N_tasks));
+  }
+
+  bool ignore(const Node& node)
+  {
+    auto& shard = *_shards[_shards.front()->filter.hash(node) % _shards.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.filter.ignore(node);
+  }
+
+private:
+
+  struct Shard
+  {
+    Shard(const std::size_t N_tasks)
+    : filter(FilterType::Zobrist, N_tasks)
+    {
+      // Do nothing
+    }
+
+    std::mutex mutex;
+    Filter filter;
+  };
+
+  std::vector<std::unique_ptr<Shard>> _shards;
+};
+
+// ============================================================================
+// A filter for the single-threaded optimal search which, besides discarding
+// duplicate assignments, discards nodes that are dominated by another node of
+// the same group. A group holds the nodes that have assigned the same tasks
+// and whose agents end at the same waypoints. Only the Pareto front of each
+// group is kept, where a node is better when its cost so far is no higher and
+// each of its agents is free no later and has no less charge. A node that is
+// already open when a better one comes along is marked as superseded, so the
+// search can drop it once it is popped.
+class DominanceFilter
+{
+public:
+
+  DominanceFilter(
+    const std::size_t N_tasks,
+    const std::vector<State>& initial_states,
+    const bool enabled)
+  : _filter(FilterType::Zobrist, N_tasks),
+    _initial_states(initial_states),
+    _enabled(enabled)
+  {
+    // Do nothing
+  }
+
+  bool ignore(const Node& node)
+  {
+    if (_filter.ignore(node))
+      return true;
+
+    if (!_enabled)
+      return false;
+
+    // The end of the unassigned tasks is marked so that the waypoints that
+    // follow cannot be mistaken for task IDs
+    Group group;
+    for (const auto& u : node.unassigned_tasks)
+      group.push_back(u.first);
+    group.push_back(std::numeric_limits<std::size_t>::max());
+
+    Entry entry{node.assignment_key, node.assigned_cost, {}};
+    entry.values.reserve(2*node.assigned_tasks.size());
+    for (std::size_t i = 0; i < node.assigned_tasks.size(); ++i)
+    {
+      const auto& assignments = node.assigned_tasks[i];
+      const State& state = assignments.empty() ?
+        _initial_states[i] : assignments.back().assignment.finish_state();
+
+      group.push_back(
+        state.waypoint().value_or(std::numeric_limits<std::size_t>::max()));
+      entry.values.push_back(
+        rmf_traffic::time::to_seconds(state.time()->time_since_epoch()));
+      entry.values.push_back(-state.battery_soc().value_or(0.0));
+    }
+
+    auto& front = _fronts[std::move(group)];
+    for (const auto& other : front)
+    {
+      if (dominates(other, entry))
+        return true;
+    }
+
+    const auto dominated = std::remove_if(front.begin(), front.end(),
+        [&](const Entry& other)
+        {
+          if (!dominates(entry, other))
+            return false;
+
+          _superseded.insert(other.key);
+          return true;
+        });
+    front.erase(dominated, front.end());
+    front.push_back(std::move(entry));
+    return false;
+  }
+
+  // Returns true once for each node that was let through by ignore() and has
+  // since been dominated by a node that came after it
+  bool superseded(const Node& node)
+  {
+    return _enabled && _superseded.erase(node.assignment_key) > 0;
+  }
+
+private:
+
+  // The IDs of the unassigned tasks in increasing order, followed by the last
+  // waypoint of each agent
+  using Group = std::vector<std::size_t>;
+
+  struct GroupHash
+  {
+    std::size_t operator()(const Group& group) const
+    {
+      std::size_t seed = group.size();
+      for (const auto value : group)
+        seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+
+      return seed;
+    }
+  };
+
+  struct KeyHash
+  {
+    std::size_t operator()(const AssignmentKey& key) const
+    {
+      return key.low;
+    }
+  };
+
+  struct Entry
+  {
+    AssignmentKey key;
+    double cost;
+
+    // The time that each agent is free, followed by its negated charge, so
+    // that lower values are better throughout
+    std::vector<double> values;
+  };
+
+  static bool dominates(const Entry& a, const Entry& b)
+  {
+    if (b.cost < a.cost)
+      return false;
+
+    for (std::size_t i = 0; i < a.values.size(); ++i)
+    {
+      if (b.values[i] < a.values[i])
+        return false;
+    }
+
+    return true;
+  }
+
+  Filter _filter;
+  const std::vector<State>& _initial_states;
+  bool _enabled;
+  std::unordered_map<Group, std::vector<Entry>, GroupHash> _fronts;
+  std::unordered_set<AssignmentKey, KeyHash> _superseded;
+};
+
+// ============================================================================
+// The open list of a search. If it is given a capacity, it never holds more
+// than that many nodes: whenever the capacity is exceeded, the most expensive
+// quarter of the nodes gets discarded. The lowest cost estimate among the
+// discarded nodes is remembered, since nothing cheaper than that can be
+// proven anymore.
+//
+// The nodes are ordered by a pairing heap whose entries refer to each other
+// by 32-bit slot indices and hold a copy of the cost estimate and assignment
+// key of their node. Comparisons never have to follow a node pointer, and a
+// push only links one entry into the root, so the heap stays in a few compact
+// arrays instead of shuffling node pointers around.
+class OpenQueue
+{
+public:
+
+  // A capacity of 0 means that the queue is unbounded
+  OpenQueue(std::size_t capacity = 0)
+  : _capacity(capacity)
+  {
+    // Do nothing
+  }
+
+  bool empty() const
+  {
+    return _root == None;
+  }
+
+  const ConstNodePtr& top() const
+  {
+    return _nodes[_root];
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  void pop()
+  {
+    const uint32_t old_root = _root;
+    _root = _merge_children(_entries[old_root].child);
+    _release(old_root);
+  }
+
+  void push(ConstNodePtr node)
+  {
+    const uint32_t slot = _acquire(std::move(node));
+    _root = _meld(_root, slot);
+
+    if (_capacity > 0 && _size > _capacity)
+      _trim();
+  }
+
+  // The lowest cost estimate of any node that was discarded, or infinity if
+  // nothing has been discarded
+  double pruned_cost() const
+  {
+    return _pruned_cost;
+  }
+
+  // Visit the open nodes in no particular order until f returns false
+  template<typename F>
+  void for_each(F&& f) const
+  {
+    for (const auto& node : _nodes)
+    {
+      if (node && !f(*node))
+        return;
+    }
+  }
+
+private:
+
+  static constexpr uint32_t None = std::numeric_limits<uint32_t>::max();
+
+  struct Entry
+  {
+    double cost_estimate;
+    AssignmentKey assignment_key;
+    uint32_t child;
+    uint32_t sibling;
+  };
+
+  // The same order as LowestCostEstimate, with the top of the heap first
+  bool _before(uint32_t a, uint32_t b) const
+  {
+    const auto& x = _entries[a];
+    const auto& y = _entries[b];
+    if (x.cost_estimate != y.cost_estimate)
+      return x.cost_estimate < y.cost_estimate;
+
+    return x.assignment_key < y.assignment_key;
+  }
+
+  uint32_t _acquire(ConstNodePtr node)
+  {
+    const Entry entry{node->cost_estimate, node->assignment_key, None, None};
+    ++_size;
+    if (!_free.empty())
+    {
+      const uint32_t slot = _free.back();
+      _free.pop_back();
+      _entries[slot] = entry;
+      _nodes[slot] = std::move(node);
+      return slot;
+    }
+
+    _entries.push_back(entry);
+    _nodes.push_back(std::move(node));
+    return static_cast<uint32_t>(_nodes.size() - 1);
+  }
+
+  void _release(uint32_t slot)
+  {
+    _nodes[slot] = nullptr;
+    _free.push_back(slot);
+    --_size;
+  }
+
+  // Make the heap with the later top a child of the other one
+  uint32_t _meld(uint32_t a, uint32_t b)
+  {
+    if (a == None)
+      return b;
+
+    if (b == None)
+      return a;
+
+    if (_before(b, a))
+      std::swap(a, b);
+
+    _entries[b].sibling = _entries[a].child;
+    _entries[a].child = b;
+    return a;
+  }
+
+  // The two-pass merge of a list of siblings: meld them in pairs from left to
+  // right, and then meld the pairs from right to left
+  uint32_t _merge_children(uint32_t first)
+  {
+    _pairs.clear();
+    while (first != None)
+    {
+      const uint32_t a = first;
+      const uint32_t b = _entries[a].sibling;
+      _entries[a].sibling = None;
+      if (b == None)
+      {
+        _pairs.push_back(a);
+        break;
+      }
+
+      first = _entries[b].sibling;
+      _entries[b].sibling = None;
+      _pairs.push_back(_meld(a, b));
+    }
+
+    uint32_t root = None;
+    for (std::size_t i = _pairs.size(); i-- > 0; )
+      root = _meld(_pairs[i], root);
+
+    return root;
+  }
+
+  void _trim()
+  {
+    // Discarding a quarter of the nodes at a time keeps the amortized cost of
+    // each push constant.
+    const std::size_t keep = std::max<std::size_t>(1, _capacity - _capacity/4);
+    std::vector<uint32_t> live;
+    live.reserve(_size);
+    for (uint32_t slot = 0; slot < _nodes.size(); ++slot)
+    {
+      if (_nodes[slot])
+        live.push_back(slot);
+    }
+
+    std::nth_element(
+      live.begin(), live.begin() + keep, live.end(),
+      [&](uint32_t a, uint32_t b) { return _before(a, b); });
+
+    for (auto it = live.begin() + keep; it != live.end(); ++it)
+    {
+      _pruned_cost = std::min(_pruned_cost, _entries[*it].cost_estimate);
+      _release(*it);
+    }
+
+    // Rebuild the heap from the nodes that were kept
+    _root = None;
+    for (auto it = live.begin(); it != live.begin() + keep; ++it)
+    {
+      _entries[*it].child = None;
+      _entries[*it].sibling = None;
+      _root = _meld(_root, *it);
+    }
+  }
+
+  std::size_t _capacity;
+  std::vector<Entry> _entries;
+  std::vector<ConstNodePtr> _nodes;
+  std::vector<uint32_t> _free;
+  std::vector<uint32_t> _pairs;
+  uint32_t _root = None;
+  std::size_t _size = 0;
+  double _pruned_cost = std::numeric_limits<double>::infinity();
+};
+
+// ============================================================================
+const rmf_traffic::Duration segmentation_threshold =
+  rmf_traffic::time::from_seconds(1.0);
+
+} // anonymous namespace
+
+// ============================================================================
+class TaskPlanner::Implementation
+{
+public:
+  Configuration config;
+  Options default_options;
+  ConstTravelEstimatorPtr travel_estimator;
+  std::string planner_id;
+  bool check_priority = false;
+  bool greedy_by_finish_time = false;
+
+  // The Options::greedy_restarts() of the plan that is in progress, and the
+  // threads that the restarts are spread over
+  std::size_t greedy_restarts = 0;
+  double greedy_restart_alpha = 0.0;
+  ThreadPool* greedy_pool = nullptr;
+
+  // Whether the optimal solver of the plan that is in progress discards
+  // dominated nodes, see Options::prune_dominated_nodes()
+  bool prune_dominated_nodes = false;
+
+  // The Options::partial_charging_margin() and
+  // Options::opportunistic_charging_detour() of the plan that is in progress
+  std::optional<double> partial_charging_margin = std::nullopt;
+  std::optional<rmf_traffic::Duration> opportunistic_charging_detour =
+    std::nullopt;
+
+  // For each agent of the segment that is being solved, the interchangeable
+  // agent before it, if Options::break_agent_symmetry() found one
+  std::vector<std::optional<std::size_t>> symmetric_predecessors = {};
+
+  // For each internal ID of the segment that is being solved, the
+  // interchangeable request before it, if Options::break_request_symmetry()
+  // found one, and the first request of its group, which stands in for the
+  // whole group in the keys of the nodes
+  std::vector<std::optional<std::size_t>> request_predecessors = {};
+  std::vector<std::size_t> request_representatives = {};
+  ConstCostCalculatorPtr cost_calculator = nullptr;
+  std::shared_ptr<ThreadPool> expansion_pool = nullptr;
+  NodeArena* arena = nullptr;
+  Statistics statistics = Statistics();
+  double heuristic_weight = 1.0;
+
+  // The models of the requests that this planner has seen, which are shared
+  // with copies of the planner since their parameters are the same
+  std::shared_ptr<ModelCache> model_cache = std::make_shared<ModelCache>();
+
+  // The results of recent calls to plan(), which are shared with copies of
+  // the planner since their configuration is the same
+  std::shared_ptr<ResultCache> result_cache =
+    config.result_cache_size() > 0 ?
+    std::make_shared<ResultCache>(config.result_cache_size()) : nullptr;
+
+  // A ChargeBattery model estimates from whatever state it is given, so one
+  // model serves every charge that this planner considers, whatever its start
+  // time or charger. A charging request is only made once a charge is
+  // assigned.
+  Task::ConstModelPtr charging_model =
+    rmf_task::requests::ChargeBattery::Description::make()->make_model(
+    rmf_traffic::Time(), config.parameters());
+
+  // Charges that the search assigns are provisional. Most of them are thrown
+  // away with the nodes that hold them, so they share one description and
+  // take their ids from a counter. Only the charges that make it into the
+  // returned Assignments become full ChargeBattery requests.
+  Task::ConstDescriptionPtr provisional_charge =
+    rmf_task::requests::ChargeBattery::Description::make();
+  std::shared_ptr<std::atomic_size_t> provisional_charges =
+    std::make_shared<std::atomic_size_t>(0);
+
+  // The Options::deterministic_seed() of the plan that is in progress
+  std::optional<std::uint64_t> deterministic_seed;
+
+  // Counts the deterministic plans that this planner has begun, so that the
+  // charges of different plans get different ids even when they are at the
+  // same positions. Copies of the planner share the counter.
+  std::shared_ptr<std::atomic_uint64_t> seeded_plans =
+    std::make_shared<std::atomic_uint64_t>(0);
+
+  // The number of the deterministic plan that is in progress
+  std::uint64_t seeded_plan = 0;
+
+  // The first assignments that have been reported to the
+  // Options::commitment_callback() of the plan that is in progress
+  struct Commitments
+  {
+    Options::CommitmentCallback callback;
+    std::vector<bool> reported;
+
+    // Whether the search of the current segment may report the first
+    // assignment of each agent, which is only the case while the agent has
+    // nothing assigned from earlier segments
+    std::vector<bool> searching;
+
+    void report(std::size_t agent, const Assignment& assignment)
+    {
+      reported[agent] = true;
+      callback(agent, assignment);
+    }
+
+    // Report the first assignment of every agent of a finished plan that has
+    // not been reported yet
+    void report_remaining(const Result& result)
+    {
+      const auto* assignments = std::get_if<Assignments>(&result);
+      if (!assignments)
+        return;
+
+      for (std::size_t i = 0; i < assignments->size(); ++i)
+      {
+        const auto& agent = (*assignments)[i];
+        if (!reported[i] && !agent.empty())
+          report(i, agent.front());
+      }
+    }
+  };
+
+  // Only set while the plan in progress can fix first assignments early, see
+  // Options::commitment_callback()
+  Commitments* commitments = nullptr;
+
+  // The kernels that the models made during the plan() or replan() call that
+  // is in progress. Each call starts a cache of its own, so that no kernel
+  // outlives the models of the call.
+  std::shared_ptr<KernelCache> kernel_cache = nullptr;
+
+  // Collects the latencies of the finish estimates of the plan() or replan()
+  // call that is in progress under Options::profile_estimates(). Copies of
+  // the planner share it.
+  std::shared_ptr<EstimateProfiler> estimate_profiler = nullptr;
+
+  // Kernels reuse the durations of one start time for every other start time,
+  // so they would hide the congestion of the travel estimator, if it has any.
+  std::shared_ptr<KernelCache> make_kernel_cache() const
+  {
+    if (travel_estimator->congestion().has_value())
+      return nullptr;
+
+    return std::make_shared<KernelCache>();
+  }
+
+  // Counters of the plan() or replan() call that is in progress. They are all
+  // atomic because nodes may be expanded and phases may be timed on several
+  // threads at once. Copying a planner does not copy its counters.
+  struct Counters
+  {
+    // The number of ticks of an rmf_traffic::Duration
+    using AtomicDuration = std::atomic<rmf_traffic::Duration::rep>;
+
+    std::atomic_size_t nodes_expanded = 0;
+    std::atomic_size_t nodes_filtered = 0;
+    std::atomic_size_t nodes_bounded = 0;
+    std::atomic_size_t nodes_symmetric = 0;
+    std::atomic_size_t peak_open_nodes = 0;
+    std::atomic_size_t finish_estimates = 0;
+    std::atomic_size_t kernel_reuses = 0;
+    std::atomic_size_t segments = 0;
+    AtomicDuration initialization_time = 0;
+    AtomicDuration search_time = 0;
+    AtomicDuration finishing_time = 0;
+    AllocationCounter::Counts allocations_before;
+
+    Counters() = default;
+
+    Counters(const Counters&)
+    {
+      // Do nothing
+    }
+
+    Counters& operator=(const Counters&)
+    {
+      return *this;
+    }
+
+    void reset()
+    {
+      nodes_expanded = 0;
+      nodes_filtered = 0;
+      nodes_bounded = 0;
+      nodes_symmetric = 0;
+      peak_open_nodes = 0;
+      finish_estimates = 0;
+      kernel_reuses = 0;
+      segments = 0;
+      initialization_time = 0;
+      search_time = 0;
+      finishing_time = 0;
+      allocations_before = AllocationCounter::all_threads();
+    }
+
+    void count(std::atomic_size_t& counter, std::size_t n = 1)
+    {
+      counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static void add(AtomicDuration& total, rmf_traffic::Duration duration)
+    {
+      total.fetch_add(duration.count(), std::memory_order_relaxed);
+    }
+
+    static rmf_traffic::Duration load(const AtomicDuration& total)
+    {
+      return rmf_traffic::Duration(total.load(std::memory_order_relaxed));
+    }
+
+    void observe_open_nodes(std::size_t n)
+    {
+      auto peak = peak_open_nodes.load(std::memory_order_relaxed);
+      while (peak < n && !peak_open_nodes.compare_exchange_weak(
+          peak, n, std::memory_order_relaxed))
+      {
+        // Try again
+      }
+    }
+  };
+
+  Counters counters = Counters();
+
+  // The statistics of the plan() call that finished most recently. Each call
+  // plans with a copy of this planner, so the statistics are published here
+  // under a mutex once the call is finished. Copying a planner does not copy
+  // what it has published.
+  struct Published
+  {
+    mutable std::mutex mutex;
+    Statistics statistics;
+
+    Published() = default;
+
+    Published(const Published&)
+    {
+      // Do nothing
+    }
+
+    Published& operator=(const Published&)
+    {
+      return *this;
+    }
+  };
+
+  Published published = Published();
+
+  // Polls the interrupter of the plan() or replan() call that is in progress.
+  // Once the interrupter fires, every later poll is true without calling it
+  // again. Only the thread that called plan() calls the interrupter, since it
+  // is not required to be thread-safe, but any thread can see that it fired.
+  // Copying a planner does not copy the interruption.
+  struct Interruption
+  {
+    // The deadline is checked once every this many polls so that the clock is
+    // not read from the hot loops of the search
+    static constexpr std::size_t DeadlinePollInterval = 32;
+
+    std::function<bool()> interrupter;
+    std::optional<rmf_traffic::Time> deadline;
+    std::size_t polls = 0;
+    std::thread::id caller;
+    std::atomic_bool fired = false;
+
+    // Whether the interrupter itself fired, rather than the deadline. This
+    // survives resume(), so one search of a plan cannot forget that the
+    // caller asked an earlier search of the same plan to stop.
+    std::atomic_bool interrupter_fired = false;
+
+    Interruption() = default;
+
+    Interruption(const Interruption&)
+    {
+      // Do nothing
+    }
+
+    Interruption& operator=(const Interruption&)
+    {
+      return *this;
+    }
+
+    void start(
+      std::function<bool()> value,
+      std::optional<rmf_traffic::Time> deadline_ = std::nullopt)
+    {
+      interrupter = std::move(value);
+      deadline = deadline_;
+      polls = 0;
+      caller = std::this_thread::get_id();
+      fired = false;
+      interrupter_fired = false;
+    }
+
+    // Start another search of the same plan with a new interrupter and
+    // deadline. If the interrupter of the plan already fired, the search is
+    // interrupted right away unless it is given no interrupter at all.
+    void resume(
+      std::function<bool()> value,
+      std::optional<rmf_traffic::Time> deadline_ = std::nullopt)
+    {
+      const bool stopped = value && interrupter_fired;
+      interrupter = std::move(value);
+      deadline = deadline_;
+      polls = 0;
+      caller = std::this_thread::get_id();
+      fired = stopped;
+    }
+
+    bool operator()()
+    {
+      if (fired.load(std::memory_order_relaxed))
+        return true;
+
+      if (std::this_thread::get_id() != caller)
+        return false;
+
+      if (deadline.has_value() && ++polls % DeadlinePollInterval == 0
+        && *deadline <= std::chrono::steady_clock::now())
+      {
+        fired = true;
+        return true;
+      }
+
+      if (!interrupter || !interrupter())
+        return false;
+
+      interrupter_fired = true;
+      fired = true;
+      return true;
+    }
+  };
+
+  Interruption interruption = Interruption();
+
+  // Adds the time that it is alive to a phase duration
+  //
+  // A phase that begins while another one is being timed on the same thread
+  // only counts toward its own total, so the totals never overlap.
+  struct PhaseTimer
+  {
+    PhaseTimer(Counters::AtomicDuration& total_)
+    : total(total_),
+      parent(current())
+    {
+      current() = this;
+    }
+
+    PhaseTimer(const PhaseTimer&) = delete;
+    PhaseTimer& operator=(const PhaseTimer&) = delete;
+
+    ~PhaseTimer()
+    {
+      const auto elapsed = std::chrono::duration_cast<rmf_traffic::Duration>(
+        std::chrono::steady_clock::now() - start);
+      Counters::add(total, elapsed - nested);
+      if (parent)
+        parent->nested += elapsed;
+
+      current() = parent;
+    }
+
+    static PhaseTimer*& current()
+    {
+      thread_local PhaseTimer* timer = nullptr;
+      return timer;
+    }
+
+    Counters::AtomicDuration& total;
+    PhaseTimer* parent;
+    rmf_traffic::Duration nested = rmf_traffic::Duration(0);
+    std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  };
+
+  static constexpr std::string_view DefaultTaskPlannerName = "task_planner";
+
+  static ConstTravelEstimatorPtr make_travel_estimator(
+    const Configuration& config)
+  {
+    if (config.travel_estimator())
+      return config.travel_estimator();
+
+    if (config.parameters().travel_estimator())
+      return config.parameters().travel_estimator();
+
+    auto estimator = std::make_shared<TravelEstimator>(config.parameters());
+    estimator->trace_sink(config.trace_sink());
+    estimator->executor(config.executor());
+    return estimator;
+  }
+
+  // Whether a new configuration leaves the estimates of the travel estimator
+  // of this planner as they are
+  bool keeps_travel_estimator(const Configuration& new_config) const
+  {
+    if (new_config.travel_estimator()
+      || new_config.parameters().travel_estimator())
+      return make_travel_estimator(new_config) == travel_estimator;
+
+    return travel_estimator->serves(new_config.parameters())
+      && new_config.trace_sink() == config.trace_sink()
+      && new_config.executor() == config.executor();
+  }
+
+  // Whether the models of requests made with one set of parameters are the
+  // same as those made with another
+  static bool same_models(const Parameters& a, const Parameters& b)
+  {
+    const auto& battery_a = a.battery_system();
+    const auto& battery_b = b.battery_system();
+    return a.planner() == b.planner()
+      && a.motion_sink() == b.motion_sink()
+      && a.ambient_sink() == b.ambient_sink()
+      && a.tool_sink() == b.tool_sink()
+      && battery_a.capacity() == battery_b.capacity()
+      && battery_a.nominal_voltage() == battery_b.nominal_voltage()
+      && battery_a.charging_current() == battery_b.charging_current();
+  }
+
+  TraceSink* trace_sink() const
+  {
+    return config.trace_sink().get();
+  }
+
+  const ExecutorPtr& executor() const
+  {
+    if (config.executor())
+      return config.executor();
+
+    return Executor::default_executor();
+  }
+
+  // Begin a plan() or replan() call. A deterministic plan takes the next
+  // number from the counter of the planner, so two planners that are given
+  // the same calls in the same order still agree on their charge ids.
+  void begin_seeded_plan(const Options& options)
+  {
+    if (options.deterministic_seed().has_value())
+      seeded_plan = seeded_plans->fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Make the charging request of the charge at the given position of an
+  // agent's assignments. In a deterministic plan its id is derived from the
+  // seed, the number of the plan and that position. A charge that was planned
+  // to stop early is given its target.
+  ConstRequestPtr make_charging_request(
+    rmf_traffic::Time start_time,
+    rmf_traffic::Time time_now,
+    std::size_t agent,
+    std::size_t position,
+    std::optional<double> target_soc = std::nullopt)
+  {
+    if (!deterministic_seed.has_value())
+    {
+      return rmf_task::requests::ChargeBattery::make(
+        start_time,
+        planner_id,
+        time_now,
+        nullptr,
+        true,
+        target_soc);
+    }
+
+    const auto plan_seed =
+      AssignmentKey::of(seeded_plan, 0, *deterministic_seed).low;
+    const auto key = AssignmentKey::of(agent, position, plan_seed);
+    std::ostringstream id;
+    id << "Charge" << std::hex << std::setfill('0') << std::setw(16) << key.low;
+    return std::make_shared<Request>(
+      std::make_shared<const Task::Booking>(
+        id.str(), start_time, nullptr, planner_id, time_now, true),
+      target_soc.has_value() ?
+      rmf_task::requests::ChargeBattery::Description::make(*target_soc) :
+      rmf_task::requests::ChargeBattery::Description::make());
+  }
+
+  // Get the target of a charge that was planned to stop before the recharge
+  // level, as partial and opportunistic charges are. Provisional charges all
+  // share one description, so the target is read from where the charge was
+  // estimated to finish.
+  std::optional<double> charge_target(const Assignment& charge) const
+  {
+    const auto soc = charge.finish_state().battery_soc();
+    if (!soc.has_value()
+      || *soc >= config.constraints().recharge_soc() - 1e-3)
+      return std::nullopt;
+
+    return *soc;
+  }
+
+  ConstRequestPtr make_provisional_charge(rmf_traffic::Time start_time)
+  {
+    const auto n = provisional_charges->fetch_add(1, std::memory_order_relaxed);
+    return std::make_shared<Request>(
+      std::make_shared<const Task::Booking>(
+        "Charge#" + std::to_string(n), start_time, nullptr, true),
+      provisional_charge);
+  }
+
+  // Replace the provisional charges of the assignments with full charging
+  // requests. Assignments that have already been finalized are left alone.
+  void finalize_charges(Assignments& assignments, rmf_traffic::Time time_now)
+  {
+    for (std::size_t i = 0; i < assignments.size(); ++i)
+    {
+      auto& agent = assignments[i];
+      for (std::size_t j = 0; j < agent.size(); ++j)
+      {
+        auto& a = agent[j];
+        if (a.request()->description() != provisional_charge)
+          continue;
+
+        a = Assignment(
+          make_charging_request(
+            a.request()->booking()->earliest_start_time(), time_now, i, j,
+            charge_target(a)),
+          a.finish_state(),
+          a.deployment_time());
+      }
+    }
+  }
+
+  void finalize_charges(Result& result, rmf_traffic::Time time_now)
+  {
+    if (auto* assignments = std::get_if<Assignments>(&result))
+      finalize_charges(*assignments, time_now);
+  }
+
+  // Report the first assignment of each agent whose assignments hold any
+  // request, since those can no longer be pruned or changed. A provisional
+  // charge that comes first is finalized in place, so that the request that
+  // was reported is the one that gets returned.
+  void report_first_assignments(
+    Assignments& assignments,
+    rmf_traffic::Time time_now)
+  {
+    if (!commitments)
+      return;
+
+    for (std::size_t i = 0; i < assignments.size(); ++i)
+    {
+      auto& agent = assignments[i];
+      if (commitments->reported[i])
+        continue;
+
+      const bool has_request = std::any_of(agent.begin(), agent.end(),
+          [](const Assignment& a) { return !a.is_charging(); });
+      if (!has_request)
+        continue;
+
+      auto& first = agent.front();
+      if (first.request()->description() == provisional_charge)
+      {
+        first = Assignment(
+          make_charging_request(
+            first.request()->booking()->earliest_start_time(), time_now, i, 0,
+            charge_target(first)),
+          first.finish_state(),
+          first.deployment_time());
+      }
+
+      commitments->report(i, first);
+    }
+  }
+
+  // Report the first assignment of every agent that the incumbent and every
+  // open node of solve() agree on. The optimal search only ever appends to
+  // the assignments of a node, so whichever node solve() returns will begin
+  // with the same assignment for those agents.
+  void report_agreed_assignments(
+    const OpenQueue& queue,
+    const Node& incumbent,
+    std::vector<std::size_t>& reported)
+  {
+    std::vector<std::pair<std::size_t, std::size_t>> agreed;
+    for (std::size_t a = 0; a < incumbent.assigned_tasks.size(); ++a)
+    {
+      const auto& agent = incumbent.assigned_tasks[a];
+      if (!commitments->searching[a] || agent.empty())
+        continue;
+
+      const auto& first = agent.front();
+      if (!first.assignment.is_charging())
+        agreed.push_back({a, first.internal_id});
+    }
+
+    queue.for_each([&](const Node& node)
+      {
+        agreed.erase(
+          std::remove_if(agreed.begin(), agreed.end(),
+          [&](const auto& entry)
+          {
+            const auto& agent = node.assigned_tasks[entry.first];
+            return agent.empty() || agent.front().internal_id != entry.second;
+          }),
+          agreed.end());
+
+        return !agreed.empty();
+      });
+
+    for (const auto& entry : agreed)
+    {
+      const std::size_t a = entry.first;
+      commitments->searching[a] = false;
+      commitments->report(a, incumbent.assigned_tasks[a].front().assignment);
+      reported.push_back(a);
+    }
+  }
+
+  // Prune the assignments in place, since they can be large
+  void prune_assignments(TaskPlanner::Assignments& assignments)
+  {
+    for (std::size_t a = 0; a < assignments.size(); ++a)
+    {
+      if (assignments[a].empty())
+        continue;
+
+      // Remove charging task at end of assignments if any
+      // TODO(YV): Remove this after fixing the planner
+      if (assignments[a].back().is_charging())
+        assignments[a].pop_back();
+    }
+  }
+
+  // The requests are made one agent at a time, since the factory may not be
+  // safe to use from several threads. The agents are independent of each other
+  // after that, so their finishing requests are estimated in parallel.
+  void append_finishing_request(
+    const RequestFactory& factory,
+    TaskPlanner::Assignments& complete_assignments,
+    rmf_traffic::Time time_now,
+    ThreadPool* pool)
+  {
+    const TraceSpan span(trace_sink(), "append_finishing_request");
+    std::vector<ConstRequestPtr> requests(complete_assignments.size());
+    for (std::size_t i = 0; i < complete_assignments.size(); ++i)
+    {
+      const auto& agent = complete_assignments[i];
+      if (!agent.empty())
+        requests[i] = factory.make_request(agent.back().finish_state());
+    }
+
+    const auto append = [&](std::size_t i)
+      {
+        if (requests[i])
+        {
+          append_finishing_request(
+            requests[i], complete_assignments[i], i, time_now);
+        }
+      };
+
+    if (pool && requests.size() > 1)
+    {
+      pool->parallel_for(requests.size(), append);
+    }
+    else
+    {
+      for (std::size_t i = 0; i < requests.size(); ++i)
+        append(i);
+    }
+  }
+
+  void append_finishing_request(
+    const ConstRequestPtr& request,
+    std::vector<Assignment>& agent,
+    std::size_t i,
+    rmf_traffic::Time time_now)
+  {
+    const auto& state = agent.back().finish_state();
+
+    // TODO(YV) Currently we are unable to recursively call complete_solve()
+    // here as the prune_assignments() function will remove any ChargeBattery
+    // requests at the back of the assignments. But the finishing factory
+    // could be a ChargeBattery request and hence this approach does not work.
+    // When we fix the logic with unnecessary ChargeBattery tasks, we should
+    // revist making this a recursive call.
+    auto model = request->description()->make_model(
+      state.time().value(),
+      config.parameters());
+    auto estimate = estimate_finish(*model, state);
+    if (estimate.has_value())
+    {
+      agent.push_back(
+        Assignment
+        {
+          request,
+          std::move(*estimate).finish_state(),
+          estimate.value().wait_until(),
+          model
+        });
+      return;
+    }
+
+    // Insufficient battery to perform the finishing request. We check if
+    // adding a ChargeBattery task before will allow for it to be performed
+    const auto charge_battery_estimate =
+      estimate_finish(*charging_model, state);
+    if (!charge_battery_estimate.has_value())
+      return;
+
+    model = request->description()->make_model(
+      charge_battery_estimate.value().finish_state().time().value(),
+      config.parameters());
+    estimate = estimate_finish(
+      *model, charge_battery_estimate.value().finish_state());
+    if (!estimate.has_value())
+      return;
+
+    // Append the ChargeBattery and finishing request
+    const auto start_time = state.time().value();
+    agent.push_back(
+      Assignment{
+        make_charging_request(start_time, time_now, i, agent.size()),
+        charge_battery_estimate.value().finish_state(),
+        charge_battery_estimate.value().wait_until()
+      });
+    agent.push_back(
+      Assignment
+      {
+        request,
+        estimate.value().finish_state(),
+        estimate.value().wait_until(),
+        model
+      });
+  }
+
+  // If pending_tasks is provided, it must hold one PendingTask for each of
+  // the requests, estimated from initial_states at time_now. The first
+  // planning segment will then be built from those instead of estimating
+  // every request from scratch.
+  Result complete_solve(
+    rmf_traffic::Time time_now,
+    std::vector<State>& initial_states,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options,
+    const std::vector<std::shared_ptr<const PendingTask>>* pending_tasks =
+    nullptr)
+  {
+    deterministic_seed = options.deterministic_seed();
+    if (options.horizon() > 0)
+    {
+      return rolling_solve(
+        time_now, initial_states, requests, options, pending_tasks,
+        options.greedy() ? std::nullopt : search_deadline(options));
+    }
+
+    // The other planners may still change a plan after its segments are
+    // finished, so they only report first assignments once plan() is done
+    if (options.neighborhood_search_budget().has_value())
+    {
+      commitments = nullptr;
+      return neighborhood_solve(
+        time_now, initial_states, requests, options, pending_tasks);
+    }
+
+    if (!options.greedy())
+    {
+      // A planner with a deadline seeds itself with the greedy solution, just
+      // like the anytime planner, so that it always has a plan to return.
+      const auto deadline = search_deadline(options);
+      if (options.anytime() || deadline.has_value())
+      {
+        commitments = nullptr;
+        return anytime_solve(
+          time_now, initial_states, requests, options, pending_tasks,
+          deadline);
+      }
+    }
+
+    if (options.greedy() && options.local_search_budget().has_value())
+      commitments = nullptr;
+
+    return segmented_solve(
+      time_now, initial_states, requests, options, pending_tasks,
+      std::nullopt);
+  }
+
+  // Plan the requests one window at a time. Each window holds the pending
+  // requests that can be finished the soonest, and segmented_solve() plans
+  // them together. Only the earliest assignments of the window are committed
+  // before the next window is planned from the states that they leave the
+  // agents in. The candidates of the requests that remain pending are kept
+  // between windows and only re-estimated for agents whose states changed.
+  Result rolling_solve(
+    rmf_traffic::Time time_now,
+    std::vector<State> states,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options,
+    const std::vector<std::shared_ptr<const PendingTask>>* initial_pending,
+    const std::optional<rmf_traffic::Time> deadline)
+  {
+    const std::size_t horizon = options.horizon();
+    const std::size_t commit =
+      std::clamp<std::size_t>(options.commit_window(), 1, horizon);
+    ThreadPool* pool = get_expansion_pool(options);
+
+    statistics = Statistics();
+    interruption.start(options.interrupter());
+
+    TaskPlannerError error;
+    std::vector<std::shared_ptr<PendingTask>> pending;
+    if (initial_pending)
+    {
+      for (const auto& p : *initial_pending)
+        pending.push_back(std::make_shared<PendingTask>(*p));
+    }
+    else
+    {
+      PhaseTimer timer{counters.initialization_time};
+      const TraceSpan span(trace_sink(), "make_initial_node");
+      auto pending_tasks = make_pending_tasks(
+        states, requests, time_now, pool, error, true);
+      if (!pending_tasks.has_value())
+      {
+        if (!interruption.fired)
+          return error;
+
+        Statistics::Implementation::get(statistics).interrupted = true;
+        return {};
+      }
+
+      pending = std::move(*pending_tasks);
+    }
+
+    // The windows do not append the finishing request. That happens once
+    // every window is committed.
+    auto window_options = options;
+    window_options.finishing_request(nullptr);
+
+    Assignments complete_assignments(states.size());
+    bool interrupted = false;
+    bool pruned = false;
+    while (!pending.empty())
+    {
+      // Once the caller asks to stop, only what was committed is kept
+      if (interruption.interrupter_fired)
+      {
+        interrupted = true;
+        break;
+      }
+
+      std::stable_sort(pending.begin(), pending.end(),
+        [](const auto& a, const auto& b)
+        {
+          return a->candidates.best_finish_time()
+          < b->candidates.best_finish_time();
+        });
+
+      const std::size_t window_size = std::min(horizon, pending.size());
+      const std::vector<std::shared_ptr<const PendingTask>> window(
+        pending.begin(), pending.begin() + window_size);
+      std::vector<ConstRequestPtr> window_requests;
+      for (const auto& p : window)
+        window_requests.push_back(p->request);
+
+      // Once the deadline has passed, the remaining windows are only planned
+      // greedily
+      if (deadline.has_value() && *deadline <= std::chrono::steady_clock::now())
+        window_options.greedy(true);
+
+      // Nothing is fixed until it is committed, so the window does not
+      // report any first assignments itself
+      auto window_states = states;
+      auto* const window_commitments = commitments;
+      commitments = nullptr;
+      auto result = segmented_solve(
+        time_now, window_states, window_requests, window_options, &window,
+        window_options.greedy() ? std::nullopt : deadline, true);
+      commitments = window_commitments;
+      interrupted = interrupted || statistics.interrupted();
+      pruned = pruned || statistics.pruned();
+
+      const auto* assignments = std::get_if<Assignments>(&result);
+      if (assignments && assignments->empty()
+        && interruption.interrupter_fired)
+      {
+        // The caller stopped this window before it found anything, but what
+        // the earlier windows committed is still kept
+        interrupted = true;
+        break;
+      }
+
+      if (!assignments || assignments->empty())
+        return result;
+
+      // Commit every assignment that is deployed no later than the earliest
+      // commit assignments of this window
+      std::vector<rmf_traffic::Time> deployments;
+      for (const auto& agent : *assignments)
+      {
+        for (const auto& a : agent)
+        {
+          if (!a.is_charging())
+            deployments.push_back(a.deployment_time());
+        }
+      }
+
+      if (deployments.empty())
+        return result;
+
+      const std::size_t last = std::min(commit, deployments.size()) - 1;
+      std::nth_element(
+        deployments.begin(), deployments.begin() + last, deployments.end());
+      const rmf_traffic::Time cutoff = deployments[last];
+
+      std::unordered_set<const Request*> committed;
+      std::vector<std::size_t> changed_agents;
+      for (std::size_t i = 0; i < assignments->size(); ++i)
+      {
+        bool changed = false;
+        for (const auto& a : (*assignments)[i])
+        {
+          if (cutoff < a.deployment_time())
+            break;
+
+          complete_assignments[i].push_back(a);
+          states[i] = a.finish_state();
+          changed = true;
+          if (!a.is_charging())
+            committed.insert(a.request().get());
+        }
+
+        if (changed)
+          changed_agents.push_back(i);
+      }
+
+      report_first_assignments(complete_assignments, time_now);
+
+      pending.erase(
+        std::remove_if(pending.begin(), pending.end(),
+        [&](const auto& p) { return committed.count(p->request.get()) > 0; }),
+        pending.end());
+
+      // Re-estimate the remaining requests for the agents that moved on
+      PhaseTimer timer{counters.initialization_time};
+      if (const auto update_error = update_pending_tasks(
+          pending, changed_agents, states, time_now, pool))
+        return *update_error;
+    }
+
+    PhaseTimer finishing_timer{counters.finishing_time};
+    prune_assignments(complete_assignments);
+    if (options.finishing_request())
+    {
+      append_finishing_request(
+        *options.finishing_request(), complete_assignments, time_now,
+        get_expansion_pool(options));
+    }
+
+    // Committing one window at a time means the plan as a whole is not
+    // proven to be optimal
+    statistics = Statistics();
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.interrupted = interrupted;
+    stats.pruned = pruned;
+    stats.record_segment(std::numeric_limits<double>::infinity(), 0.0);
+
+    return complete_assignments;
+  }
+
+  // Add the search counters of a copy of this planner to the counters of this
+  // one
+  void merge_counters(const Implementation& planner)
+  {
+    counters.count(counters.nodes_expanded, planner.counters.nodes_expanded);
+    counters.count(counters.nodes_filtered, planner.counters.nodes_filtered);
+    counters.count(counters.nodes_bounded, planner.counters.nodes_bounded);
+    counters.count(
+      counters.nodes_symmetric, planner.counters.nodes_symmetric);
+    counters.count(
+      counters.finish_estimates, planner.counters.finish_estimates);
+    counters.observe_open_nodes(planner.counters.peak_open_nodes);
+    counters.count(counters.segments, planner.counters.segments);
+    Counters::add(
+      counters.initialization_time,
+      Counters::load(planner.counters.initialization_time));
+    Counters::add(
+      counters.search_time, Counters::load(planner.counters.search_time));
+    Counters::add(
+      counters.finishing_time,
+      Counters::load(planner.counters.finishing_time));
+  }
+
+  // The state of one call to run_interruptible(). Helpers keep it alive with
+  // a shared_ptr, because a helper may only get to run after the calling
+  // thread has already finished every job.
+  struct InterruptibleBatch
+  {
+    const std::function<void(std::size_t)>* job;
+    std::size_t count;
+    std::atomic_size_t next = 0;
+    std::size_t done = 0;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    bool run_next()
+    {
+      const std::size_t i = next++;
+      if (i >= count)
+        return false;
+
+      (*job)(i);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (++done == count)
+        finished.notify_all();
+
+      return true;
+    }
+  };
+
+  // How often the calling thread of run_interruptible() polls the interrupter
+  // while it waits for the other threads to finish their jobs
+  static constexpr std::chrono::milliseconds InterrupterPollPeriod =
+    std::chrono::milliseconds(1);
+
+  // Run job(i) for each i in [0, count) on the executor of this planner, with
+  // up to max_threads threads including the calling thread, and block until
+  // every job is finished. The jobs must not throw. The calling thread takes
+  // part in running the jobs, and while it waits for the rest of them it
+  // polls the interrupter on their behalf, since the interrupter does not
+  // need to be thread-safe. Once the interrupter fires, stop is set.
+  void run_interruptible(
+    std::size_t count,
+    std::size_t max_threads,
+    const std::function<void(std::size_t)>& job,
+    const std::function<bool()>& interrupter,
+    std::atomic_bool& stop)
+  {
+    if (count == 0)
+      return;
+
+    auto batch = std::make_shared<InterruptibleBatch>();
+    batch->job = &job;
+    batch->count = count;
+
+    const std::size_t helpers =
+      std::min(count, std::max<std::size_t>(1, max_threads)) - 1;
+    for (std::size_t i = 0; i < helpers; ++i)
+      executor()->post([batch]() { while (batch->run_next()) {} });
+
+    while (batch->run_next())
+    {
+      // Keep going
+    }
+
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    while (batch->done < count)
+    {
+      if (!interrupter || stop)
+      {
+        batch->finished.wait(lock, [&]() { return batch->done == count; });
+        break;
+      }
+
+      batch->finished.wait_for(lock, InterrupterPollPeriod);
+      if (batch->done == count)
+        break;
+
+      lock.unlock();
+      if (interrupter())
+        stop = true;
+      lock.lock();
+    }
+  }
+
+  // Plan each cluster of the partition with a copy of this planner, or with
+  // the cluster solver of the configuration, all at once, and merge their
+  // assignments. The requests that no cluster could plan are then planned
+  // for every agent.
+  Result partitioned_solve(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options)
+  {
+    const auto partition = config.partitioner()(agents, requests);
+    if (partition.agent_clusters.size() != agents.size()
+      || partition.request_clusters.size() != requests.size())
+    {
+      throw std::runtime_error(
+        "[TaskPlanner::plan] The partitioner gave clusters for ["
+        + std::to_string(partition.agent_clusters.size()) + "] agents and ["
+        + std::to_string(partition.request_clusters.size())
+        + "] requests, but there are [" + std::to_string(agents.size())
+        + "] agents and [" + std::to_string(requests.size()) + "] requests");
+    }
+
+    struct Cluster
+    {
+      std::vector<std::size_t> agents;
+      std::vector<std::size_t> requests;
+      std::optional<Result> result;
+      bool interrupted = false;
+      bool pruned = false;
+    };
+
+    std::map<std::size_t, Cluster> cluster_map;
+    for (std::size_t a = 0; a < agents.size(); ++a)
+      cluster_map[partition.agent_clusters[a]].agents.push_back(a);
+    for (std::size_t r = 0; r < requests.size(); ++r)
+      cluster_map[partition.request_clusters[r]].requests.push_back(r);
+
+    std::vector<Cluster*> clusters;
+    std::vector<std::size_t> leftover_requests;
+    for (auto& [id, cluster] : cluster_map)
+    {
+      if (cluster.agents.empty())
+      {
+        leftover_requests.insert(
+          leftover_requests.end(),
+          cluster.requests.begin(), cluster.requests.end());
+      }
+      else if (!cluster.requests.empty())
+      {
+        clusters.push_back(&cluster);
+      }
+    }
+
+    // The interrupter does not need to be thread-safe, so only the thread
+    // that called plan() calls it, either from its own cluster or while it
+    // waits for the others
+    const auto& interrupter = options.interrupter();
+    const auto caller = std::this_thread::get_id();
+    std::atomic_bool stop = false;
+    auto cluster_options = options;
+    cluster_options.finishing_request(nullptr);
+    if (interrupter)
+    {
+      cluster_options.interrupter(
+        [&stop, &interrupter, caller]()
+        {
+          if (!stop && std::this_thread::get_id() == caller && interrupter())
+            stop = true;
+
+          return stop.load();
+        });
+    }
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    const auto& solver = config.cluster_solver();
+    std::vector<Implementation> planners;
+    if (!solver)
+    {
+      planners.reserve(clusters.size());
+      for (std::size_t c = 0; c < clusters.size(); ++c)
+        planners.push_back(*this);
+    }
+
+    const std::function<void(std::size_t)> work = [&](std::size_t c)
+      {
+        const AllocationCounter::Scope scope(
+          AllocationCounter::Subsystem::Planner);
+        try
+        {
+          auto& cluster = *clusters[c];
+          std::vector<State> cluster_states;
+          for (const auto a : cluster.agents)
+            cluster_states.push_back(agents[a]);
+
+          std::vector<ConstRequestPtr> cluster_requests;
+          for (const auto r : cluster.requests)
+            cluster_requests.push_back(requests[r]);
+
+          if (solver)
+          {
+            auto solution = solver->solve(
+              time_now, cluster_states, cluster_requests, cluster_options);
+            cluster.result = std::move(solution.result);
+            cluster.interrupted = solution.interrupted;
+            cluster.pruned = solution.pruned;
+          }
+          else
+          {
+            auto& planner = planners[c];
+            cluster.result = planner.complete_solve(
+              time_now, cluster_states, cluster_requests, cluster_options);
+            cluster.interrupted = planner.statistics.interrupted();
+            cluster.pruned = planner.statistics.pruned();
+          }
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error)
+            error = std::current_exception();
+        }
+      };
+
+    const std::size_t concurrency = solver ?
+      solver->concurrency() : executor()->concurrency() + 1;
+    run_interruptible(clusters.size(), concurrency, work, interrupter, stop);
+
+    if (error)
+      std::rethrow_exception(error);
+
+    // Merge the clusters back into the order of the original agents
+    Assignments merged(agents.size());
+    bool interrupted = stop;
+    bool pruned = false;
+    for (std::size_t c = 0; c < clusters.size(); ++c)
+    {
+      auto& cluster = *clusters[c];
+      if (!planners.empty())
+        merge_counters(planners[c]);
+      interrupted = interrupted || cluster.interrupted;
+      pruned = pruned || cluster.pruned;
+
+      auto* assignments = std::get_if<Assignments>(&*cluster.result);
+      if (!assignments || assignments->empty())
+      {
+        leftover_requests.insert(
+          leftover_requests.end(),
+          cluster.requests.begin(), cluster.requests.end());
+        continue;
+      }
+
+      if (assignments->size() != cluster.agents.size())
+      {
+        throw std::runtime_error(
+          "[TaskPlanner::plan] The cluster solver gave assignments for ["
+          + std::to_string(assignments->size()) + "] agents to a cluster of ["
+          + std::to_string(cluster.agents.size()) + "] agents");
+      }
+
+      for (std::size_t i = 0; i < cluster.agents.size(); ++i)
+        merged[cluster.agents[i]] = std::move((*assignments)[i]);
+
+      if (solver)
+      {
+        // The solver named the charging requests that it added after the
+        // agents of its own cluster, so they are made provisional again to be
+        // named after the agents of the whole problem like the rest
+        std::unordered_set<const Request*> given;
+        for (const auto r : cluster.requests)
+          given.insert(requests[r].get());
+
+        for (const auto a : cluster.agents)
+        {
+          for (auto& assignment : merged[a])
+          {
+            if (!assignment.is_charging()
+              || given.count(assignment.request().get()))
+              continue;
+
+            assignment = Assignment(
+              make_provisional_charge(
+                assignment.request()->booking()->earliest_start_time()),
+              assignment.finish_state(),
+              assignment.deployment_time());
+          }
+        }
+      }
+    }
+
+    std::vector<InfeasibleRequest> infeasible_requests;
+    if (!leftover_requests.empty())
+    {
+      std::sort(leftover_requests.begin(), leftover_requests.end());
+      std::vector<State> states = agents;
+      for (std::size_t a = 0; a < agents.size(); ++a)
+      {
+        if (!merged[a].empty())
+          states[a] = merged[a].back().finish_state();
+      }
+
+      std::vector<ConstRequestPtr> leftovers;
+      for (const auto r : leftover_requests)
+        leftovers.push_back(requests[r]);
+
+      auto leftover_options = options;
+      leftover_options.finishing_request(nullptr);
+      auto result = complete_solve(
+        time_now, states, leftovers, leftover_options);
+      interrupted = interrupted || statistics.interrupted();
+      pruned = pruned || statistics.pruned();
+      infeasible_requests = statistics.infeasible_requests();
+
+      auto* assignments = std::get_if<Assignments>(&result);
+      if (!assignments)
+        return result;
+
+      for (std::size_t a = 0; a < assignments->size(); ++a)
+      {
+        auto& leftover = (*assignments)[a];
+        merged[a].insert(
+          merged[a].end(),
+          std::make_move_iterator(leftover.begin()),
+          std::make_move_iterator(leftover.end()));
+      }
+    }
+
+    PhaseTimer finishing_timer{counters.finishing_time};
+    prune_assignments(merged);
+    if (options.finishing_request())
+    {
+      append_finishing_request(
+        *options.finishing_request(), merged, time_now,
+        get_expansion_pool(options));
+    }
+
+    statistics = Statistics();
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.interrupted = interrupted;
+    stats.pruned = pruned;
+    stats.infeasible_requests = std::move(infeasible_requests);
+    stats.record_segment(std::numeric_limits<double>::infinity(), 0.0);
+
+    return merged;
+  }
+
+  // The ways that the large neighborhood search chooses the requests that it
+  // tears out of a plan
+  enum class Destroy : std::size_t
+  {
+    Random = 0,
+    Worst,
+    Related,
+    Count
+  };
+
+  // Choose which requests to tear out of the plan for one neighborhood. The
+  // requests behind a chosen request in its agent's queue get torn out with
+  // it, so the choice is given as the number of assignments that each agent
+  // keeps. Seeds whose queues would tear out more than size requests are
+  // passed over.
+  static std::vector<std::size_t> choose_neighborhood(
+    const Assignments& plan,
+    Destroy destroy,
+    std::size_t size,
+    std::mt19937_64& rng)
+  {
+    struct Item
+    {
+      std::size_t agent;
+      std::size_t index;
+      double score;
+    };
+
+    std::vector<Item> items;
+    for (std::size_t a = 0; a < plan.size(); ++a)
+    {
+      for (std::size_t i = 0; i < plan[a].size(); ++i)
+      {
+        if (!plan[a][i].is_charging())
+          items.push_back({a, i, 0.0});
+      }
+    }
+
+    std::vector<std::size_t> keep;
+    keep.reserve(plan.size());
+    for (const auto& queue : plan)
+      keep.push_back(queue.size());
+
+    if (items.empty())
+      return keep;
+
+    const auto finish = [&](const Item& item)
+      {
+        return rmf_traffic::time::to_seconds(
+          plan[item.agent][item.index].finish_state().time()->
+          time_since_epoch());
+      };
+
+    std::shuffle(items.begin(), items.end(), rng);
+    if (destroy == Destroy::Worst)
+    {
+      for (auto& item : items)
+      {
+        const auto& assignment = plan[item.agent][item.index];
+        item.score = -(finish(item) - rmf_traffic::time::to_seconds(
+          assignment.request()->booking()->earliest_start_time()
+          .time_since_epoch()));
+      }
+    }
+    else if (destroy == Destroy::Related)
+    {
+      const double seed = finish(items.front());
+      for (auto& item : items)
+        item.score = std::abs(finish(item) - seed);
+    }
+
+    std::stable_sort(items.begin(), items.end(),
+      [](const Item& a, const Item& b) { return a.score < b.score; });
+
+    // The number of requests that each agent would tear out if it only kept
+    // its first i assignments
+    const auto torn_out = [&](std::size_t agent, std::size_t i)
+      {
+        std::size_t count = 0;
+        for (std::size_t k = i; k < plan[agent].size(); ++k)
+        {
+          if (!plan[agent][k].is_charging())
+            ++count;
+        }
+
+        return count;
+      };
+
+    std::size_t removed = 0;
+    for (const auto& item : items)
+    {
+      if (removed >= size)
+        break;
+
+      if (keep[item.agent] <= item.index)
+        continue;
+
+      const std::size_t more = torn_out(item.agent, item.index)
+        - torn_out(item.agent, keep[item.agent]);
+      if (removed > 0 && removed + more > size)
+        continue;
+
+      keep[item.agent] = item.index;
+      removed += more;
+    }
+
+    return keep;
+  }
+
+  // Find a greedy plan and then improve it with a large neighborhood search
+  // until the budget of the options runs out. Each neighborhood is planned
+  // again by a copy of this planner with the optimal solver, whose search is
+  // cut short at the end of the budget.
+  Result neighborhood_solve(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& initial_states,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options,
+    const std::vector<std::shared_ptr<const PendingTask>>* pending_tasks)
+  {
+    auto deadline =
+      std::chrono::steady_clock::now() + *options.neighborhood_search_budget();
+    if (const auto d = search_deadline(options); d && *d < deadline)
+      deadline = *d;
+
+    auto initial_options = options;
+    initial_options
+    .neighborhood_search(std::nullopt)
+    .greedy(true)
+    .finishing_request(nullptr);
+
+    std::vector<State> states = initial_states;
+    auto result = complete_solve(
+      time_now, states, requests, initial_options, pending_tasks);
+    auto* initial = std::get_if<Assignments>(&result);
+    if (!initial || initial->empty() || statistics.interrupted())
+      return result;
+
+    auto infeasible_requests = statistics.infeasible_requests();
+    const bool pruned = statistics.pruned();
+    const auto& calculator = *cost_calculator;
+    Assignments plan = std::move(*initial);
+    double cost = calculator.compute_cost(plan);
+
+    // Each repair is an optimal search over a small problem. The clusters
+    // cannot call the interrupter because it does not need to be thread-safe,
+    // so this thread polls it for them.
+    std::atomic_bool stop = false;
+    const std::size_t parallel = options.parallel_neighborhoods();
+    auto repair_options = options;
+    repair_options
+    .neighborhood_search(std::nullopt)
+    .rolling_horizon(0, 0)
+    .greedy(false)
+    .anytime(false)
+    .finishing_request(nullptr)
+    .improvement_callback(nullptr)
+    .time_budget(std::nullopt)
+    .deadline(deadline)
+    .interrupter([&stop]() { return stop.load(); });
+    if (parallel > 1)
+      repair_options.expansion_threads(1).search_threads(1);
+
+    struct Neighborhood
+    {
+      std::vector<std::size_t> keep;
+      std::optional<Assignments> plan;
+      double cost = std::numeric_limits<double>::infinity();
+    };
+
+    const std::uint64_t seed = deterministic_seed.value_or(0);
+    const auto& interrupter = options.interrupter();
+    std::vector<Implementation> planners(parallel, *this);
+    std::size_t iteration = 0;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+      if (interrupter && interrupter())
+      {
+        stop = true;
+        break;
+      }
+
+      std::vector<Neighborhood> neighborhoods(parallel);
+      for (std::size_t n = 0; n < parallel; ++n)
+      {
+        const std::size_t k = iteration * parallel + n;
+        std::mt19937_64 rng(seed + k * 0x9e3779b97f4a7c15ull);
+        const auto destroy = static_cast<Destroy>(
+          k % static_cast<std::size_t>(Destroy::Count));
+        neighborhoods[n].keep = choose_neighborhood(
+          plan, destroy, options.neighborhood_size(), rng);
+      }
+
+      // With no requests left to tear out, no neighborhood can improve the
+      // plan any further
+      const bool empty = std::all_of(
+        neighborhoods.begin(), neighborhoods.end(),
+        [&](const Neighborhood& neighborhood)
+        {
+          for (std::size_t a = 0; a < plan.size(); ++a)
+          {
+            if (neighborhood.keep[a] < plan[a].size())
+              return false;
+          }
+
+          return true;
+        });
+      if (empty)
+        break;
+
+      const auto repair = [&](std::size_t n)
+        {
+          const AllocationCounter::Scope scope(
+            AllocationCounter::Subsystem::Planner);
+          auto& neighborhood = neighborhoods[n];
+          std::vector<State> sub_states = initial_states;
+          std::vector<ConstRequestPtr> sub_requests;
+          for (std::size_t a = 0; a < plan.size(); ++a)
+          {
+            const std::size_t keep = neighborhood.keep[a];
+            if (keep > 0)
+              sub_states[a] = plan[a][keep-1].finish_state();
+
+            for (std::size_t i = keep; i < plan[a].size(); ++i)
+            {
+              if (!plan[a][i].is_charging())
+                sub_requests.push_back(plan[a][i].request());
+            }
+          }
+
+          if (sub_requests.empty())
+            return;
+
+          auto& planner = planners[n];
+          const auto sub_result = planner.complete_solve(
+            time_now, sub_states, sub_requests, repair_options);
+          const auto* repaired = std::get_if<Assignments>(&sub_result);
+          if (!repaired || repaired->size() != plan.size()
+            || !planner.statistics.infeasible_requests().empty())
+            return;
+
+          Assignments candidate(plan.size());
+          std::size_t assigned = 0;
+          for (std::size_t a = 0; a < plan.size(); ++a)
+          {
+            candidate[a].assign(
+              plan[a].begin(), plan[a].begin() + neighborhood.keep[a]);
+            for (const auto& assignment : (*repaired)[a])
+            {
+              if (!assignment.is_charging())
+                ++assigned;
+
+              const auto& request = assignment.request();
+              if (!assignment.is_charging()
+                || request->description() == provisional_charge
+                || !request->booking()->automatic())
+              {
+                candidate[a].push_back(assignment);
+                continue;
+              }
+
+              // The repair may have finalized its charges at their positions
+              // in the smaller problem, which are taken by the kept
+              // assignments of this plan. They become provisional again so
+              // that they are finalized at their positions in the whole plan.
+              candidate[a].emplace_back(
+                make_provisional_charge(
+                  request->booking()->earliest_start_time()),
+                assignment.finish_state(),
+                assignment.deployment_time());
+            }
+          }
+
+          if (assigned != sub_requests.size())
+            return;
+
+          neighborhood.cost = calculator.compute_cost(candidate);
+          neighborhood.plan = std::move(candidate);
+        };
+
+      if (parallel == 1)
+      {
+        repair(0);
+      }
+      else
+      {
+        std::atomic_size_t finished = 0;
+        std::vector<std::thread> threads;
+        for (std::size_t n = 0; n < parallel; ++n)
+        {
+          threads.emplace_back(
+            [&, n]()
+            {
+              repair(n);
+              ++finished;
+            });
+        }
+
+        while (finished < parallel)
+        {
+          if (interrupter && !stop && interrupter())
+            stop = true;
+
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        for (auto& thread : threads)
+          thread.join();
+      }
+
+      // Keep the cheapest neighborhood, preferring the earliest one on ties so
+      // the outcome does not depend on the threads
+      const Neighborhood* best = nullptr;
+      for (const auto& neighborhood : neighborhoods)
+      {
+        if (neighborhood.plan.has_value()
+          && neighborhood.cost < cost - 1e-9
+          && (!best || neighborhood.cost < best->cost))
+          best = &neighborhood;
+      }
+
+      if (best)
+      {
+        plan = *best->plan;
+        cost = best->cost;
+      }
+
+      if (stop)
+        break;
+
+      ++iteration;
+    }
+
+    for (const auto& planner : planners)
+      merge_counters(planner);
+
+    PhaseTimer finishing_timer{counters.finishing_time};
+    if (options.finishing_request())
+    {
+      append_finishing_request(
+        *options.finishing_request(), plan, time_now,
+        get_expansion_pool(options));
+    }
+
+    statistics = Statistics();
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.interrupted = stop;
+    stats.pruned = pruned;
+    stats.infeasible_requests = std::move(infeasible_requests);
+    stats.record_segment(std::numeric_limits<double>::infinity(), 0.0);
+
+    return plan;
+  }
+
+  // Get the pool for expanding nodes and estimating candidates, or nullptr if
+  // the options only use the calling thread
+  ThreadPool* get_expansion_pool(const Options& options)
+  {
+    if (options.expansion_threads() <= 1)
+      return nullptr;
+
+    if (!expansion_pool
+      || expansion_pool->size() != options.expansion_threads())
+    {
+      expansion_pool = std::make_shared<ThreadPool>(
+        executor(), options.expansion_threads());
+    }
+
+    return expansion_pool.get();
+  }
+
+  // The time by which the optimal search should stop, if the options give a
+  // deadline or a time budget. When there is a finishing request, a tenth of
+  // the remaining time is kept for appending it onto the assignments.
+  static std::optional<rmf_traffic::Time> search_deadline(
+    const Options& options)
+  {
+    const auto now = std::chrono::steady_clock::now();
+    auto deadline = options.deadline();
+    if (options.time_budget().has_value())
+    {
+      const auto budget_deadline = now + *options.time_budget();
+      if (!deadline.has_value() || budget_deadline < *deadline)
+        deadline = budget_deadline;
+    }
+
+    if (deadline.has_value() && options.finishing_request() && now < *deadline)
+      *deadline -= (*deadline - now) / 10;
+
+    return deadline;
+  }
+
+  // Solve the problem one segment at a time, where each segment only assigns
+  // the requests that can begin before the segmentation threshold. The search
+  // is interrupted at the deadline if one is given. A search that continues a
+  // plan which already began resumes its interruption instead of starting
+  // it over.
+  Result segmented_solve(
+    rmf_traffic::Time time_now,
+    std::vector<State>& initial_states,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options,
+    const std::vector<std::shared_ptr<const PendingTask>>* pending_tasks,
+    std::optional<rmf_traffic::Time> deadline,
+    bool resume_interruption = false)
+  {
+    const auto& finishing_request = options.finishing_request();
+    const bool greedy = options.greedy();
+    if (resume_interruption)
+      interruption.resume(options.interrupter(), deadline);
+    else
+      interruption.start(options.interrupter(), deadline);
+
+    // The initial states are replaced by the finish states of each segment,
+    // but the local search needs the states that the whole plan starts from
+    const std::vector<State> plan_states =
+      greedy && options.local_search_budget().has_value() ?
+      initial_states : std::vector<State>();
+
+    // Pin the thread before the arena is made, so its reserve gets touched
+    // on the NUMA node of the pinned cores
+    const AffinityScope affinity(options.cpu_affinity());
+
+    // The initial candidates of the requests are estimated with the same
+    // threads that expand the search nodes, whichever solver is used.
+    ThreadPool* initialization_pool = get_expansion_pool(options);
+
+    ThreadPool* pool = greedy ? nullptr : initialization_pool;
+
+    statistics = Statistics();
+
+    // Every node of this plan is allocated from one arena which is released
+    // in bulk when planning is finished. It must outlive all the nodes below.
+    const bool concurrent = pool || options.search_threads() > 1
+      || (initialization_pool && options.greedy_restarts() > 1);
+    NodeArena node_arena(
+      concurrent, options.arena_reserve(), options.memory_resource());
+    arena = &node_arena;
+    struct ArenaReset
+    {
+      NodeArena*& arena;
+      ~ArenaReset() { arena = nullptr; }
+    } arena_reset{arena};
+
+    cost_calculator = config.cost_calculator() ? config.cost_calculator() :
+      rmf_task::BinaryPriorityScheme::make_cost_calculator();
+
+    greedy_by_finish_time = options.greedy_by_finish_time();
+    greedy_restarts = options.greedy_restarts();
+    greedy_restart_alpha = options.greedy_restart_alpha();
+    greedy_pool = initialization_pool;
+
+    // Also check if a high priority task exists among the requests.
+    // If so the cost function for a node will be modified accordingly.
+    // Cost calculators that weigh each request by its own priority do not
+    // need that.
+    check_priority = false;
+    if (cost_calculator->orders_priorities())
+    {
+      for (const auto& request : requests)
+      {
+        if (request->booking()->priority())
+        {
+          check_priority = true;
+          break;
+        }
+      }
+    }
+
+    // The priority of an assignment depends on what came before it on the
+    // same agent, which the dominance between nodes does not account for
+    prune_dominated_nodes = options.prune_dominated_nodes() && !check_priority;
+    partial_charging_margin = options.partial_charging_margin();
+    opportunistic_charging_detour = options.opportunistic_charging_detour();
+
+    TaskPlannerError error;
+    ConstNodePtr node;
+    {
+      PhaseTimer timer{counters.initialization_time};
+      const TraceSpan span(trace_sink(), "make_initial_node");
+      node = pending_tasks ?
+        make_initial_node(initial_states, *pending_tasks, time_now) :
+        make_initial_node(
+        initial_states, requests, time_now, initialization_pool, error, true);
+    }
+
+    if (!node && interruption.fired)
+    {
+      Statistics::Implementation::get(statistics).interrupted = true;
+      return {};
+    }
+
+    if (!node)
+      return error;
+
+    TaskPlanner::Assignments complete_assignments;
+    complete_assignments.resize(node->assigned_tasks.size());
+
+    while (node)
+    {
+      counters.count(counters.segments);
+      {
+        PhaseTimer timer{counters.search_time};
+        symmetric_predecessors.clear();
+        if (!greedy && options.break_agent_symmetry())
+        {
+          symmetric_predecessors =
+            find_symmetric_predecessors(initial_states, options);
+        }
+
+        request_predecessors.clear();
+        request_representatives.clear();
+        if (!greedy && options.break_request_symmetry())
+          find_interchangeable_requests(*node);
+
+        if (greedy)
+        {
+          node = greedy_solve(node, initial_states, time_now);
+          Statistics::Implementation::get(statistics).record_segment(
+            std::numeric_limits<double>::infinity(), 0.0);
+        }
+        else if (options.search_threads() > 1)
+        {
+          node = parallel_solve(node, initial_states,
+              requests.size(), time_now, options.search_threads(),
+              options.max_open_nodes(), options.cpu_affinity());
+        }
+        else
+        {
+          if (commitments)
+          {
+            for (std::size_t i = 0; i < complete_assignments.size(); ++i)
+            {
+              commitments->searching[i] = !commitments->reported[i]
+                && complete_assignments[i].empty();
+            }
+          }
+
+          node = solve(node, initial_states,
+              requests.size(), time_now, pool,
+              options.max_open_nodes());
+        }
+      }
+
+      if (!node)
+      {
+        return {};
+      }
+
+      PhaseTimer finishing_timer{counters.finishing_time};
+
+      // Collect the assignments of the segment without the charge at the back
+      // of each agent, if there is one, and carry each agent on from the end
+      // of its last assignment. The candidates of the remaining requests are
+      // only re-estimated for the agents that the segment assigned anything
+      // to, since the rest are still where the segment began.
+      std::vector<std::size_t> changed_agents;
+      assert(complete_assignments.size() == node->assigned_tasks.size());
+      for (std::size_t i = 0; i < complete_assignments.size(); ++i)
+      {
+        const auto new_assignments = node->assigned_tasks[i].in_order();
+        if (new_assignments.empty())
+          continue;
+
+        std::size_t count = new_assignments.size();
+        if (new_assignments.back()->assignment.is_charging())
+          --count;
+
+        auto& all_assignments = complete_assignments[i];
+        for (std::size_t k = 0; k < count; ++k)
+          all_assignments.push_back(new_assignments[k]->assignment);
+
+        if (count > 0)
+          initial_states[i] = all_assignments.back().finish_state();
+
+        changed_agents.push_back(i);
+      }
+
+      report_first_assignments(complete_assignments, time_now);
+
+      if (node->unassigned_tasks.empty())
+      {
+        prune_assignments(complete_assignments);
+        break;
+      }
+
+      // The remaining requests keep the models of this segment
+      std::vector<PendingTask> pending;
+      pending.reserve(node->unassigned_tasks.size());
+      for (const auto& u : node->unassigned_tasks)
+        pending.push_back(u.second);
+
+      {
+        PhaseTimer timer{counters.initialization_time};
+        const TraceSpan span(trace_sink(), "make_initial_node");
+        const auto update_error = update_pending_tasks(
+          pending, changed_agents, initial_states, time_now,
+          initialization_pool);
+        if (update_error.has_value())
+          return *update_error;
+
+        node = make_initial_node(initial_states, std::move(pending), time_now);
+      }
+    }
+
+    if (greedy && options.local_search_budget().has_value())
+    {
+      PhaseTimer timer{counters.search_time};
+      local_search(
+        complete_assignments, plan_states,
+        *options.local_search_budget(), initialization_pool);
+    }
+
+    // If a finishing_request is present, accommodate the request at the end of
+    // the assignments for each agent
+    PhaseTimer finishing_timer{counters.finishing_time};
+    if (finishing_request != nullptr)
+    {
+      append_finishing_request(
+        *finishing_request,
+        complete_assignments,
+        time_now,
+        initialization_pool);
+    }
+
+    return complete_assignments;
+  }
+
+  // The heuristic weights of the successive searches of the anytime planner.
+  // The last weight must be 1.0 so that the final search is optimal.
+  static constexpr std::array<double, 4> AnytimeWeights = {3.0, 2.0, 1.5, 1.0};
+
+  // Find the greedy solution first and then improve on it with one search
+  // for each weight, until the searches are finished, interrupted or out of
+  // time. Without the anytime option, this is used for plans with a deadline
+  // and it only runs the optimal search after the greedy one.
+  Result anytime_solve(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& initial_states,
+    const std::vector<ConstRequestPtr>& requests,
+    const Options& options,
+    const std::vector<std::shared_ptr<const PendingTask>>* pending_tasks,
+    const std::optional<rmf_traffic::Time> deadline)
+  {
+    const auto& interrupter = options.interrupter();
+    const auto& callback = options.improvement_callback();
+    const auto weights = options.anytime() ?
+      std::vector<double>(AnytimeWeights.begin(), AnytimeWeights.end()) :
+      std::vector<double>{1.0};
+
+    struct WeightReset
+    {
+      double& weight;
+      ~WeightReset() { weight = 1.0; }
+    } weight_reset{heuristic_weight};
+
+    const auto search = [&](bool greedy, double weight) -> Result
+      {
+        auto search_options = options;
+        search_options.anytime(false).greedy(greedy);
+
+        // The greedy seed is always finished so there is something to return
+        if (greedy)
+          search_options.interrupter(nullptr);
+        heuristic_weight = weight;
+        auto states = initial_states;
+        return segmented_solve(
+          time_now, states, requests, search_options, pending_tasks,
+          greedy ? std::nullopt : deadline);
+      };
+
+    // The greedy solution gives us something to return right away
+    auto result = search(true, 1.0);
+    const auto* greedy_assignments = std::get_if<Assignments>(&result);
+    if (!greedy_assignments)
+      return result;
+
+    Assignments best = *greedy_assignments;
+    double best_cost = cost_calculator->compute_cost(best);
+    double lower_bound = 0.0;
+    bool interrupted = false;
+    bool pruned = false;
+    if (callback)
+    {
+      finalize_charges(best, time_now);
+      callback(best, best_cost, lower_bound);
+    }
+
+    for (const double weight : weights)
+    {
+      const bool out_of_time = deadline.has_value()
+        && *deadline <= std::chrono::steady_clock::now();
+      if (out_of_time || (interrupter && interrupter()))
+      {
+        interrupted = true;
+        break;
+      }
+
+      result = search(false, weight);
+      pruned = pruned || statistics.pruned();
+
+      // An interrupted search still returns assignments, which might be better
+      // than the best so far even though they are not bounded
+      const bool search_interrupted = statistics.interrupted();
+      interrupted = interrupted || search_interrupted;
+
+      const auto* assignments = std::get_if<Assignments>(&result);
+      if (!assignments || assignments->empty())
+      {
+        if (search_interrupted)
+          break;
+
+        continue;
+      }
+
+      const double cost = cost_calculator->compute_cost(*assignments);
+      bool improved = false;
+      if (cost < best_cost)
+      {
+        best = *assignments;
+        best_cost = cost;
+        improved = true;
+      }
+
+      // A search with weight w finds a solution whose cost is no more than w
+      // times the optimal cost
+      const double bound = statistics.suboptimality_bound();
+      if (std::isfinite(bound) && lower_bound < cost / bound)
+      {
+        lower_bound = std::min(cost / bound, best_cost);
+        improved = true;
+      }
+
+      if (improved && callback)
+      {
+        finalize_charges(best, time_now);
+        callback(best, best_cost, lower_bound);
+      }
+
+      if (search_interrupted)
+        break;
+    }
+
+    statistics = Statistics();
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.interrupted = interrupted;
+    stats.pruned = pruned;
+    stats.record_segment(best_cost, lower_bound);
+
+    return best;
+  }
+
+  // Start counting the statistics of a plan() or replan() call. The returned
+  // snapshot of the travel estimator should be given to record_statistics().
+  TravelEstimator::Statistics begin_statistics(const Options& options)
+  {
+    counters.reset();
+    estimate_profiler = options.profile_estimates() ?
+      std::make_shared<EstimateProfiler>() : nullptr;
+    return travel_estimator->statistics();
+  }
+
+  // Record the statistics of the plan() or replan() call that began with the
+  // given snapshot of the travel estimator
+  void record_statistics(const TravelEstimator::Statistics& travel_before)
+  {
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.travel_estimates =
+      travel_estimator->statistics().since(travel_before);
+    stats.nodes_expanded = counters.nodes_expanded;
+    stats.nodes_filtered = counters.nodes_filtered;
+    stats.nodes_bounded = counters.nodes_bounded;
+    stats.nodes_symmetric = counters.nodes_symmetric;
+    stats.peak_open_nodes = counters.peak_open_nodes;
+    stats.finish_estimates = counters.finish_estimates;
+    stats.kernel_reuses = counters.kernel_reuses;
+    stats.segments = counters.segments;
+    stats.initialization_time = Counters::load(counters.initialization_time);
+    stats.search_time = Counters::load(counters.search_time);
+    stats.finishing_time = Counters::load(counters.finishing_time);
+    if (estimate_profiler)
+      stats.estimate_profiles = estimate_profiler->profiles();
+    stats.allocations =
+      AllocationCounter::all_threads().since(counters.allocations_before);
+  }
+
+  // The candidates of each request are estimated independently, so they are
+  // spread across the pool if one is given. Every infeasible request gets
+  // recorded in the statistics, and error is set to the error of the first.
+  // If interruptible is true, the interrupter is polled between requests and
+  // nullptr is returned once it fires.
+  ConstNodePtr make_initial_node(
+    std::vector<State> initial_states,
+    std::vector<ConstRequestPtr> requests,
+    rmf_traffic::Time time_now,
+    ThreadPool* pool,
+    TaskPlannerError& error,
+    bool interruptible)
+  {
+    auto pending_tasks = make_pending_tasks(
+      initial_states, requests, time_now, pool, error, interruptible);
+    if (!pending_tasks.has_value())
+      return nullptr;
+
+    return make_initial_node(
+      initial_states,
+      std::vector<std::shared_ptr<const PendingTask>>(
+        pending_tasks->begin(), pending_tasks->end()),
+      time_now);
+  }
+
+  // Estimate the candidates of each request as described for
+  // make_initial_node(). Returns std::nullopt if any request is infeasible or
+  // the estimation was interrupted.
+  std::optional<std::vector<std::shared_ptr<PendingTask>>> make_pending_tasks(
+    const std::vector<State>& initial_states,
+    const std::vector<ConstRequestPtr>& requests,
+    rmf_traffic::Time time_now,
+    ThreadPool* pool,
+    TaskPlannerError& error,
+    bool interruptible)
+  {
+    std::vector<std::shared_ptr<PendingTask>> pending_tasks(requests.size());
+    model_cache->prune();
+    std::vector<TaskPlannerError> errors(requests.size());
+    const auto make_pending_task = [&](std::size_t i)
+      {
+        if (interruptible && interruption())
+          return;
+
+        pending_tasks[i] = PendingTask::make(
+          time_now,
+          initial_states,
+          config.constraints(),
+          config.parameters(),
+          requests[i],
+          *travel_estimator,
+          planner_id,
+          errors[i],
+          &counters.finish_estimates,
+          model_cache.get(),
+          charging_model.get(),
+          estimate_profiler.get());
+      };
+
+    if (pool && requests.size() > 1)
+    {
+      pool->parallel_for(requests.size(), make_pending_task);
+    }
+    else
+    {
+      for (std::size_t i = 0; i < requests.size(); ++i)
+        make_pending_task(i);
+    }
+
+    if (interruptible && interruption.fired)
+      return std::nullopt;
+
+    auto& infeasible_requests =
+      Statistics::Implementation::get(statistics).infeasible_requests;
+    infeasible_requests.clear();
+    for (std::size_t i = 0; i < requests.size(); ++i)
+    {
+      if (!pending_tasks[i])
+        infeasible_requests.push_back({requests[i], errors[i]});
+    }
+
+    if (!infeasible_requests.empty())
+    {
+      error = infeasible_requests.front().error;
+      return std::nullopt;
+    }
+
+    return pending_tasks;
+  }
+
+  static PendingTask& pending_task(PendingTask& task)
+  {
+    return task;
+  }
+
+  static PendingTask& pending_task(const std::shared_ptr<PendingTask>& task)
+  {
+    return *task;
+  }
+
+  // Re-estimate the candidates of the pending tasks for the agents whose
+  // states changed, spread across the pool if one is given. Every request
+  // that no agent can perform anymore gets recorded in the statistics, and
+  // the error of the first one is returned.
+  template<typename PendingTasks>
+  std::optional<TaskPlannerError> update_pending_tasks(
+    PendingTasks& pending,
+    const std::vector<std::size_t>& changed_agents,
+    const std::vector<State>& states,
+    rmf_traffic::Time time_now,
+    ThreadPool* pool)
+  {
+    std::vector<TaskPlannerError> errors(pending.size());
+    std::vector<char> feasible(pending.size(), true);
+    const auto update = [&](std::size_t p)
+      {
+        for (const std::size_t agent : changed_agents)
+        {
+          if (!pending_task(pending[p]).update_agent(
+              agent, time_now, states[agent], config.constraints(),
+              config.parameters(), *travel_estimator, planner_id,
+              errors[p], &counters.finish_estimates, charging_model.get(),
+              estimate_profiler.get()))
+          {
+            feasible[p] = false;
+            return;
+          }
+        }
+      };
+
+    if (pool && pending.size() > 1 && !changed_agents.empty())
+    {
+      pool->parallel_for(pending.size(), update);
+    }
+    else
+    {
+      for (std::size_t p = 0; p < pending.size(); ++p)
+        update(p);
+    }
+
+    auto& infeasible_requests =
+      Statistics::Implementation::get(statistics).infeasible_requests;
+    infeasible_requests.clear();
+    for (std::size_t p = 0; p < pending.size(); ++p)
+    {
+      if (!feasible[p])
+      {
+        infeasible_requests.push_back(
+          {pending_task(pending[p]).request, errors[p]});
+      }
+    }
+
+    if (!infeasible_requests.empty())
+      return infeasible_requests.front().error;
+
+    return std::nullopt;
+  }
+
+  ConstNodePtr make_initial_node(
+    const std::vector<State>& initial_states,
+    const std::vector<std::shared_ptr<const PendingTask>>& pending_tasks,
+    rmf_traffic::Time time_now)
+  {
+    std::vector<PendingTask> tasks;
+    tasks.reserve(pending_tasks.size());
+    for (const auto& pending_task : pending_tasks)
+      tasks.push_back(*pending_task);
+
+    return make_initial_node(initial_states, std::move(tasks), time_now);
+  }
+
+  // Make an initial node that takes ownership of the pending tasks
+  ConstNodePtr make_initial_node(
+    const std::vector<State>& initial_states,
+    std::vector<PendingTask> pending_tasks,
+    rmf_traffic::Time time_now)
+  {
+    auto initial_node = arena->make_node();
+
+    initial_node->assigned_tasks.resize(initial_states.size());
+
+    for (auto& pending_task : pending_tasks)
+    {
+      // Generate a unique internal id for the request. Currently, multiple
+      // requests with the same string id will be assigned different internal ids
+      std::size_t internal_id = initial_node->get_available_internal_id();
+      initial_node->unassigned_tasks.insert(
+        {
+          internal_id,
+          std::move(pending_task)
+        });
+    }
+
+    initial_node->cost_estimate = estimate_cost(*initial_node, time_now);
+
+    initial_node->sort_invariants();
+
+    initial_node->latest_time =
+      [&]() -> rmf_traffic::Time
+      {
+        rmf_traffic::Time latest = rmf_traffic::Time::min();
+        for (const auto& s : initial_states)
+        {
+          if (latest < s.time().value())
+            latest = s.time().value();
+        }
+
+        return latest;
+      } ();
+
+    rmf_traffic::Time wait_until = rmf_traffic::Time::max();
+
+    for (const auto& u : initial_node->unassigned_tasks)
+    {
+      const auto& range = u.second.candidates.best_candidates();
+      for (auto it = range.begin; it != range.end; ++it)
+      {
+        if (it->wait_until < wait_until)
+          wait_until = it->wait_until;
+      }
+    }
+
+    if (initial_node->latest_time < wait_until)
+      initial_node->latest_time = wait_until;
+
+    return initial_node;
+  }
+
+  std::optional<Estimate> estimate_finish(
+    const Task::Model& model,
+    const State& state)
+  {
+    // Skip estimates that are bound to fail because the battery cannot cover
+    // the least that the task will drain. When the battery is running low this
+    // is the outcome for most of the remaining tasks of a candidate.
+    const auto& constraints = config.constraints();
+    if (constraints.drain_battery())
+    {
+      const auto battery_soc = state.battery_soc();
+      if (battery_soc.has_value()
+        && *battery_soc - model.min_battery_drain()
+        <= constraints.threshold_soc())
+      {
+        return std::nullopt;
+      }
+    }
+
+    counters.count(counters.finish_estimates);
+    return EstimateProfiler::time(estimate_profiler.get(), model,
+        [&]() -> std::optional<Estimate>
+        {
+          if (kernel_cache)
+          {
+            const auto kernel = kernel_cache->get(
+              model, state, constraints, *travel_estimator,
+              &counters.kernel_reuses);
+
+            if (kernel)
+              return kernel->estimate_finish(state);
+          }
+
+          return model.estimate_finish(state, constraints, *travel_estimator);
+        });
+  }
+
+  // Estimate a charge that stops once the agent has just enough for a task,
+  // along with the task after it, under Options::partial_charging(). A task
+  // drains as much whatever charge it begins with, so its estimate after a
+  // full charge tells how much charge it needs. The task is estimated again
+  // after the smaller charge since it may also need the charge to get back to
+  // the charger afterwards. Returns std::nullopt if the full charge should be
+  // kept.
+  std::optional<std::pair<Estimate, Estimate>> estimate_partial_charge(
+    const Task::Model& model,
+    const State& state,
+    const Estimate& full_charge,
+    const Estimate& full_finish)
+  {
+    const auto& constraints = config.constraints();
+    const double full_soc = full_charge.finish_state().battery_soc().value();
+    const double drain =
+      full_soc - full_finish.finish_state().battery_soc().value();
+    const double target =
+      constraints.threshold_soc() + drain + *partial_charging_margin;
+    if (target >= full_soc - 1e-3)
+      return std::nullopt;
+
+    Constraints partial_constraints = constraints;
+    partial_constraints.recharge_soc(target);
+    counters.count(counters.finish_estimates);
+    auto charge = EstimateProfiler::time(
+      estimate_profiler.get(), *charging_model,
+      [&]()
+      {
+        return charging_model->estimate_finish(
+          state, partial_constraints, *travel_estimator);
+      });
+    if (!charge.has_value())
+      return std::nullopt;
+
+    auto finish = estimate_finish(model, charge->finish_state());
+    if (!finish.has_value())
+      return std::nullopt;
+
+    return std::make_pair(std::move(*charge), std::move(*finish));
+  }
+
+  // Estimate a charge that fills the idle time before the task of an entry,
+  // along with the task after it, under Options::opportunistic_charging().
+  // Returns std::nullopt if the charger is too far, if there is no time to
+  // charge, or if the task would finish any later after the charge.
+  std::optional<std::pair<Estimate, Estimate>> estimate_opportunistic_charge(
+    const Candidates::Entry& entry,
+    const Task::Model& model)
+  {
+    const State& previous = entry.previous_state;
+    const auto charger = previous.dedicated_charging_waypoint();
+    const auto plan_start = previous.extract_plan_start();
+    const auto battery_soc = previous.battery_soc();
+    if (!charger.has_value() || !plan_start.has_value()
+      || !battery_soc.has_value())
+      return std::nullopt;
+
+    const auto& constraints = config.constraints();
+    if (*battery_soc >= constraints.recharge_soc() - 1e-3)
+      return std::nullopt;
+
+    rmf_traffic::Duration detour(0);
+    double arrival_soc = *battery_soc;
+    if (plan_start->waypoint() != *charger)
+    {
+      const auto travel = travel_estimator->estimate(
+        *plan_start, rmf_traffic::agv::Plan::Goal(*charger));
+      if (!travel.has_value() || *opportunistic_charging_detour
+        < travel->duration())
+        return std::nullopt;
+
+      detour = travel->duration();
+      if (constraints.drain_battery())
+        arrival_soc -= travel->change_in_charge();
+    }
+
+    const auto charging_time =
+      entry.wait_until - plan_start->time() - 2*detour;
+    if (charging_time <= rmf_traffic::Duration(0))
+      return std::nullopt;
+
+    // Charging is linear in time, as in the ChargeBattery model
+    const auto& battery = config.parameters().battery_system();
+    const double target = std::min(
+      constraints.recharge_soc(),
+      arrival_soc + rmf_traffic::time::to_seconds(charging_time)
+      * battery.charging_current() / (3600.0 * battery.capacity()));
+
+    Constraints charging_constraints = constraints;
+    charging_constraints.recharge_soc(target);
+    counters.count(counters.finish_estimates);
+    auto charge = EstimateProfiler::time(
+      estimate_profiler.get(), *charging_model,
+      [&]()
+      {
+        return charging_model->estimate_finish(
+          previous, charging_constraints, *travel_estimator);
+      });
+    if (!charge.has_value())
+      return std::nullopt;
+
+    auto finish = estimate_finish(model, charge->finish_state());
+    if (!finish.has_value()
+      || entry.state.time().value() < finish->finish_state().time().value())
+      return std::nullopt;
+
+    return std::make_pair(std::move(*charge), std::move(*finish));
+  }
+
+  double estimate_cost(const Node& node, rmf_traffic::Time time_now) const
+  {
+    return cost_calculator->compute_incremental_cost(
+      node, time_now, check_priority, heuristic_weight);
+  }
+
+  // Append an assignment to a node while keeping its assigned_cost up to date
+  void assign(
+    Node& node,
+    std::size_t agent,
+    Node::AssignmentWrapper assignment) const
+  {
+    node.assigned_cost +=
+      cost_calculator->compute_assignment_cost(assignment.assignment);
+    const auto key = key_id(assignment.internal_id);
+    node.assign(agent, std::move(assignment), key);
+  }
+
+  // Remove the last assignment of an agent while keeping the assigned_cost of
+  // the node up to date
+  void unassign_last(Node& node, std::size_t agent) const
+  {
+    const auto& last = node.assigned_tasks[agent].back();
+    node.assigned_cost -=
+      cost_calculator->compute_assignment_cost(last.assignment);
+    node.unassign_last(agent, key_id(last.internal_id));
+  }
+
+  // The ID that an assignment is keyed by in the nodes of the current segment
+  std::size_t key_id(std::size_t internal_id) const
+  {
+    return internal_id < request_representatives.size() ?
+      request_representatives[internal_id] : internal_id;
+  }
+
+  rmf_traffic::Time get_latest_time(const Node& node)
+  {
+    rmf_traffic::Time latest = rmf_traffic::Time::min();
+    for (const auto& a : node.assigned_tasks)
+    {
+      if (a.empty())
+        continue;
+
+      const auto finish_time =
+        a.back().assignment.finish_state().time().value();
+
+      if (latest < finish_time)
+        latest = finish_time;
+    }
+
+    assert(latest > rmf_traffic::Time::min());
+    return latest;
+  }
+
+  ConstNodePtr expand_candidate(
+    const Candidates::Entry& entry,
+    const Node::UnassignedTasks::value_type& u,
+    const ConstNodePtr& parent,
+    rmf_traffic::Time time_now)
+  {
+    if (parent->latest_time + segmentation_threshold < entry.wait_until)
+    {
+
+      // No need to assign task as timeline is not relevant
+      return nullptr;
+    }
+
+    auto new_node = arena->make_node(*parent);
+
+    // A charge and the estimate of the task after it, if the idle time before
+    // the task is filled with a charge
+    std::optional<std::pair<Estimate, Estimate>> opportunistic;
+
+    // Assign the unassigned task after checking for implicit charging requests
+    if (entry.require_charge_battery)
+    {
+      // Check if a battery task already precedes the latest assignment
+      const auto& assignments = new_node->assigned_tasks[entry.candidate];
+      if (assignments.empty() || !assignments.back().assignment.is_charging())
+      {
+        // The entry normally holds the charge that it was estimated after
+        auto battery_estimate = entry.charge_battery;
+        if (!battery_estimate.has_value())
+        {
+          battery_estimate =
+            estimate_finish(*charging_model, entry.previous_state);
+        }
+
+        if (battery_estimate.has_value())
+        {
+          assign(
+            *new_node,
+            entry.candidate,
+            Node::AssignmentWrapper
+            { u.first,
+              Assignment
+              {
+                make_provisional_charge(entry.previous_state.time().value()),
+                std::move(*battery_estimate).finish_state(),
+                battery_estimate.value().wait_until()
+              }
+            }
+          );
+        }
+      }
+    }
+    else if (opportunistic_charging_detour.has_value())
+    {
+      const auto& assignments = new_node->assigned_tasks[entry.candidate];
+      if (assignments.empty() || !assignments.back().assignment.is_charging())
+        opportunistic = estimate_opportunistic_charge(entry, *u.second.model);
+    }
+
+    if (opportunistic.has_value())
+    {
+      auto& [charge, finish] = *opportunistic;
+      assign(
+        *new_node,
+        entry.candidate,
+        Node::AssignmentWrapper{u.first,
+          Assignment{
+            make_provisional_charge(entry.previous_state.time().value()),
+            std::move(charge).finish_state(),
+            charge.wait_until()}});
+
+      assign(
+        *new_node,
+        entry.candidate,
+        Node::AssignmentWrapper{u.first,
+          Assignment{
+            u.second.request, std::move(finish).finish_state(),
+            finish.wait_until(), u.second.model}});
+    }
+    else
+    {
+      assign(
+        *new_node,
+        entry.candidate,
+        Node::AssignmentWrapper{u.first,
+          Assignment{
+            u.second.request, entry.state, entry.wait_until, u.second.model}});
+    }
+
+    // The candidate goes on from the end of the task, which has more charge
+    // than entry.state when a charge was fitted in before it
+    const State& finish_state =
+      new_node->assigned_tasks[entry.candidate].back().assignment
+      .finish_state();
+
+    // Erase the assigned task from unassigned tasks
+    new_node->pop_unassigned(u.first);
+
+    // Update states of unassigned tasks for the candidate. A task that the
+    // candidate no longer has the battery for is estimated after a charge
+    // instead. The charge is estimated at most once for all of those tasks,
+    // and their entries keep it so that it can be assigned along with them.
+    std::optional<Estimate> charge_battery;
+    bool charge_estimated = false;
+    for (auto& new_u : new_node->unassigned_tasks)
+    {
+      auto finish =
+        estimate_finish(*new_u.second.model, finish_state);
+
+      if (finish.has_value())
+      {
+        new_u.second.candidates.update_candidate(
+          entry.candidate,
+          std::move(*finish).finish_state(),
+          finish.value().wait_until(),
+          finish_state,
+          false);
+        continue;
+      }
+
+      if (!charge_estimated)
+      {
+        charge_battery = estimate_finish(*charging_model, finish_state);
+        charge_estimated = true;
+      }
+
+      if (!charge_battery.has_value())
+      {
+        // Agent cannot make it back to the charger
+        return nullptr;
+      }
+
+      auto charged_finish = estimate_finish(
+        *new_u.second.model, charge_battery->finish_state());
+      if (!charged_finish.has_value())
+      {
+        // We should stop expanding this node
+        return nullptr;
+      }
 
-    if (t < current_agent.size())
-    {
-      const auto& task_id = current_agent[t].internal_id;
-      const auto agent_insertion = agent_table->agent.insert({a, nullptr});
-      if (agent_insertion.second)
-        agent_insertion.first->second = std::make_unique<TaskTable>();
+      if (partial_charging_margin.has_value())
+      {
+        auto partial = estimate_partial_charge(
+          *new_u.second.model, finish_state, *charge_battery, *charged_finish);
+        if (partial.has_value())
+        {
+          new_u.second.candidates.update_candidate(
+            entry.candidate,
+            std::move(partial->second).finish_state(),
+            partial->second.wait_until(),
+            finish_state,
+            true,
+            std::move(partial->first));
+          continue;
+        }
+      }
 
-      auto* task_table = agent_insertion.first->second.get();
+      new_u.second.candidates.update_candidate(
+        entry.candidate,
+        std::move(*charged_finish).finish_state(),
+        charged_finish.value().wait_until(),
+        finish_state,
+        true,
+        charge_battery);
+    }
 
-      const auto task_insertion = task_table->task.insert({task_id, nullptr});
-      if (task_insertion.second)
+    // Update the cost estimate for new_node
+    new_node->cost_estimate = estimate_cost(*new_node, time_now);
+    new_node->latest_time = get_latest_time(*new_node);
+
+    return new_node;
+  }
+
+  ConstNodePtr expand_charger(
+    ConstNodePtr parent,
+    const std::size_t agent,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    auto new_node = arena->make_node(*parent);
+    // Assign charging task to an agent
+    State state = initial_states[agent];
+    auto& assignments = new_node->assigned_tasks[agent];
+
+    // If the assignment set for a candidate is empty we do not want to add a
+    // charging task as this is taken care of in expand_candidate(). Without this
+    // step there is chance for the planner to get stuck in an infinite loop when
+    // a charging task is required before any other task can be assigned.
+    if (assignments.empty())
+      return nullptr;
+
+    if (!assignments.empty())
+    {
+      if (assignments.back().assignment.is_charging())
+        return nullptr;
+      state = assignments.back().assignment.finish_state();
+    }
+
+    auto estimate = estimate_finish(*charging_model, state);
+    if (estimate.has_value())
+    {
+      assign(
+        *new_node,
+        agent,
+        Node::AssignmentWrapper
+        {
+          new_node->get_available_internal_id(true),
+          Assignment
+          {
+            make_provisional_charge(state.time().value()),
+            estimate.value().finish_state(),
+            estimate.value().wait_until()
+          }
+        });
+      for (auto& new_u : new_node->unassigned_tasks)
       {
-        new_node = true;
-        task_insertion.first->second = std::make_unique<AgentTable>();
+        auto finish =
+          estimate_finish(*new_u.second.model, estimate.value().finish_state());
+        if (finish.has_value())
+        {
+          new_u.second.candidates.update_candidate(
+            agent,
+            std::move(*finish).finish_state(),
+            finish.value().wait_until(),
+            state,
+            false);
+        }
+        else
+        {
+          return nullptr;
+        }
       }
 
-      agent_table = task_insertion.first->second.get();
-      ++t;
+      new_node->cost_estimate = estimate_cost(*new_node, time_now);
+      new_node->latest_time = get_latest_time(*new_node);
+      return new_node;
+    }
+
+    return nullptr;
+  }
+
+  ConstNodePtr greedy_solve(
+    ConstNodePtr node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    const TraceSpan span(trace_sink(), "greedy_solve");
+    if (greedy_restarts > 1)
+      return restarted_greedy_solve(node, initial_states, time_now);
+
+    return single_greedy_solve(node, initial_states, time_now);
+  }
+
+  ConstNodePtr single_greedy_solve(
+    ConstNodePtr node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    if (greedy_by_finish_time)
+      return earliest_finish_solve(node, initial_states, time_now);
+
+    while (!finished(*node))
+    {
+      counters.count(counters.nodes_expanded);
+      node = greedy_step(node, initial_states, time_now);
+      assert(node);
+    }
+
+    return node;
+  }
+
+  // The greedy solver of Options::greedy_restarts(). The first run is the
+  // regular greedy solution so the result is never worse than that, and the
+  // others pick randomly among the cheapest children at each step.
+  ConstNodePtr restarted_greedy_solve(
+    const ConstNodePtr& node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    const std::uint64_t seed = deterministic_seed.value_or(0);
+    std::vector<ConstNodePtr> results(greedy_restarts);
+    const auto run = [&](std::size_t k)
+      {
+        if (k == 0)
+        {
+          results[k] = single_greedy_solve(node, initial_states, time_now);
+          return;
+        }
+
+        std::mt19937_64 rng(seed + k * 0x9e3779b97f4a7c15ull);
+        ConstNodePtr n = node;
+        while (!finished(*n))
+        {
+          counters.count(counters.nodes_expanded);
+          n = randomized_greedy_step(n, initial_states, time_now, rng);
+          assert(n);
+        }
+
+        results[k] = std::move(n);
+      };
+
+    if (greedy_pool)
+    {
+      greedy_pool->parallel_for(results.size(), run);
     }
     else
     {
-      t = 0;
-      ++a;
+      for (std::size_t k = 0; k < results.size(); ++k)
+        run(k);
+    }
+
+    // Ties go to the earliest run so the choice does not depend on timing
+    ConstNodePtr best = results.front();
+    for (const auto& result : results)
+    {
+      if (result->cost_estimate < best->cost_estimate)
+        best = result;
+    }
+
+    return best;
+  }
+
+  // Pick a random child among the ones whose cost estimates are within
+  // greedy_restart_alpha of the range of cost estimates of all the children
+  // that greedy_step() would consider
+  ConstNodePtr randomized_greedy_step(
+    const ConstNodePtr& node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now,
+    std::mt19937_64& rng)
+  {
+    std::vector<ConstNodePtr> children;
+    for (const auto& u : node->unassigned_tasks)
+    {
+      const auto& range = u.second.candidates.best_candidates();
+      for (auto it = range.begin; it != range.end; ++it)
+      {
+        if (auto n = expand_candidate(*it->entry, u, node, time_now))
+          children.push_back(std::move(n));
+      }
+    }
+
+    // Only the regular step knows how to insert the charges that are needed
+    // when no child can be expanded
+    if (children.empty())
+      return greedy_step(node, initial_states, time_now);
+
+    double lowest = std::numeric_limits<double>::infinity();
+    double highest = -std::numeric_limits<double>::infinity();
+    for (const auto& child : children)
+    {
+      lowest = std::min(lowest, child->cost_estimate);
+      highest = std::max(highest, child->cost_estimate);
+    }
+
+    const double threshold =
+      lowest + greedy_restart_alpha * (highest - lowest);
+    std::vector<std::size_t> restricted;
+    for (std::size_t i = 0; i < children.size(); ++i)
+    {
+      if (children[i]->cost_estimate <= threshold)
+        restricted.push_back(i);
+    }
+
+    std::uniform_int_distribution<std::size_t> pick(0, restricted.size() - 1);
+    return children[restricted[pick(rng)]];
+  }
+
+  // Expand every best candidate of every unassigned task and return the child
+  // with the lowest cost estimate. If none of them can be expanded because an
+  // agent ran out of charge, a charge is inserted into its queue instead.
+  ConstNodePtr greedy_step(
+    const ConstNodePtr& node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    ConstNodePtr next_node = nullptr;
+    for (const auto& u : node->unassigned_tasks)
+    {
+      const auto& range = u.second.candidates.best_candidates();
+      for (auto it = range.begin; it != range.end; ++it)
+      {
+        if (auto n = expand_candidate(*it->entry, u, node, time_now))
+        {
+          if (!next_node || (n->cost_estimate < next_node->cost_estimate))
+          {
+            next_node = std::move(n);
+          }
+        }
+        else
+        {
+          // expand_candidate returned nullptr either due to start time
+          // segmentation or insufficient charge to return to its charger.
+          // For the later case, we aim to backtrack and assign a charging
+          // task to the agent.
+          if (node->latest_time + segmentation_threshold >
+            it->wait_until)
+          {
+            auto parent_node = arena->make_node(*node);
+            const auto candidate = it->candidate;
+            while (!parent_node->assigned_tasks[candidate].empty())
+            {
+              unassign_last(*parent_node, candidate);
+              auto new_charge_node = expand_charger(
+                parent_node,
+                candidate,
+                initial_states,
+                time_now);
+              if (new_charge_node)
+              {
+                next_node = std::move(new_charge_node);
+                break;
+              }
+            }
+          }
+        }
+      }
+    }
+
+    return next_node;
+  }
+
+  // The greedy solver of Options::greedy_by_finish_time(). The finish time of
+  // every candidate of every unassigned task is kept in a min-heap. Assigning
+  // a task only changes the candidates of one agent, so instead of removing
+  // the outdated finish times of that agent, each agent has a version that is
+  // bumped when it gets assigned, and the heap entries of older versions are
+  // skipped when they reach the top.
+  ConstNodePtr earliest_finish_solve(
+    ConstNodePtr node,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now)
+  {
+    struct Pick
+    {
+      rmf_traffic::Time finish_time;
+      std::size_t task;
+      std::size_t candidate;
+      std::size_t version;
+    };
+
+    // Ties are broken by task and then by agent so that the plan does not
+    // depend on the order of the heap
+    const auto later = [](const Pick& a, const Pick& b)
+      {
+        if (a.finish_time != b.finish_time)
+          return a.finish_time > b.finish_time;
+
+        if (a.task != b.task)
+          return a.task > b.task;
+
+        return a.candidate > b.candidate;
+      };
+
+    std::vector<Pick> heap;
+    std::vector<Pick> deferred;
+    std::vector<std::size_t> versions(node->assigned_tasks.size(), 0);
+
+    const auto push = [&](const Node& n, std::optional<std::size_t> agent)
+      {
+        for (const auto& u : n.unassigned_tasks)
+        {
+          const auto range = u.second.candidates.all_candidates();
+          for (auto it = range.begin; it != range.end; ++it)
+          {
+            if (agent.has_value() && it->candidate != *agent)
+              continue;
+
+            heap.push_back(
+              Pick{
+                it->finish_time,
+                u.first,
+                it->candidate,
+                versions[it->candidate]
+              });
+            std::push_heap(heap.begin(), heap.end(), later);
+          }
+        }
+      };
+
+    push(*node, std::nullopt);
+    while (!finished(*node))
+    {
+      counters.count(counters.nodes_expanded);
+      ConstNodePtr next_node = nullptr;
+      std::optional<std::size_t> assigned_agent;
+      while (!heap.empty())
+      {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const Pick pick = heap.back();
+        heap.pop_back();
+
+        if (pick.version != versions[pick.candidate])
+          continue;
+
+        const auto* u = node->unassigned_tasks.find(pick.task);
+        if (!u)
+          continue;
+
+        const auto range = u->second.candidates.all_candidates();
+        auto it = range.begin;
+        while (it != range.end && it->candidate != pick.candidate)
+          ++it;
+
+        if (it == range.end)
+          continue;
+
+        next_node = expand_candidate(*it->entry, *u, node, time_now);
+        if (next_node)
+        {
+          assigned_agent = pick.candidate;
+          break;
+        }
+
+        // The task may only be deployable once the timeline has moved on, so
+        // it is offered again after the next assignment
+        deferred.push_back(pick);
+      }
+
+      if (next_node)
+      {
+        ++versions[*assigned_agent];
+        node = std::move(next_node);
+        for (const auto& pick : deferred)
+        {
+          heap.push_back(pick);
+          std::push_heap(heap.begin(), heap.end(), later);
+        }
+
+        deferred.clear();
+        push(*node, *assigned_agent);
+        continue;
+      }
+
+      // Nothing could be assigned as it is, which happens when an agent needs
+      // to charge before its next task. The regular greedy step inserts the
+      // charge, and the heap is rebuilt since any agent may have changed.
+      node = greedy_step(node, initial_states, time_now);
+      assert(node);
+      heap.clear();
+      deferred.clear();
+      for (auto& version : versions)
+        ++version;
+
+      push(*node, std::nullopt);
+    }
+
+    return node;
+  }
+
+  // Group the agents that are interchangeable under
+  // Options::break_agent_symmetry() and chain each agent to the one before it
+  // in its group. The tolerances are measured from the first agent of each
+  // group so that a group cannot drift through a series of small differences.
+  static std::vector<std::optional<std::size_t>> find_symmetric_predecessors(
+    const std::vector<State>& states,
+    const Options& options)
+  {
+    const double soc_tolerance = options.agent_symmetry_soc_tolerance();
+    const auto time_tolerance = options.agent_symmetry_time_tolerance();
+    const auto interchangeable = [&](const State& a, const State& b)
+      {
+        if (!a.waypoint().has_value() || !a.time().has_value()
+          || !a.battery_soc().has_value())
+          return false;
+
+        if (a.waypoint() != b.waypoint()
+          || a.orientation() != b.orientation()
+          || a.dedicated_charging_waypoint()
+          != b.dedicated_charging_waypoint()
+          || a.payload_capacity() != b.payload_capacity()
+          || !b.time().has_value() || !b.battery_soc().has_value())
+          return false;
+
+        const auto dt = *a.time() > *b.time() ?
+          *a.time() - *b.time() : *b.time() - *a.time();
+        return dt <= time_tolerance
+          && std::abs(*a.battery_soc() - *b.battery_soc()) <= soc_tolerance;
+      };
+
+    struct Group
+    {
+      std::size_t first;
+      std::size_t last;
+    };
+
+    std::vector<Group> groups;
+    std::vector<std::optional<std::size_t>> predecessors(states.size());
+    for (std::size_t i = 0; i < states.size(); ++i)
+    {
+      bool grouped = false;
+      for (auto& group : groups)
+      {
+        if (interchangeable(states[group.first], states[i]))
+        {
+          predecessors[i] = group.last;
+          group.last = i;
+          grouped = true;
+          break;
+        }
+      }
+
+      if (!grouped)
+        groups.push_back({i, i});
+    }
+
+    return predecessors;
+  }
+
+  // Group the unassigned requests of the initial node of a segment that are
+  // interchangeable and chain each request to the one before it in its group.
+  // Requests are compared to the first request of each group.
+  void find_interchangeable_requests(const Node& node)
+  {
+    std::size_t size = 0;
+    for (const auto& u : node.unassigned_tasks)
+      size = std::max(size, u.first + 1);
+
+    request_predecessors.assign(size, std::nullopt);
+    request_representatives.resize(size);
+    for (std::size_t i = 0; i < size; ++i)
+      request_representatives[i] = i;
+
+    struct Group
+    {
+      const Request* first_request;
+      std::size_t first;
+      std::size_t last;
+    };
+
+    std::vector<Group> groups;
+    for (const auto& u : node.unassigned_tasks)
+    {
+      const auto& request = *u.second.request;
+      bool grouped = false;
+      for (auto& group : groups)
+      {
+        if (interchangeable(*group.first_request, request))
+        {
+          request_predecessors[u.first] = group.last;
+          request_representatives[u.first] = group.first;
+          group.last = u.first;
+          grouped = true;
+          break;
+        }
+      }
+
+      if (!grouped)
+        groups.push_back({&request, u.first, u.first});
+    }
+  }
+
+  // A request may only be assigned once the interchangeable request before it
+  // has been assigned, since otherwise the child only swaps the two requests
+  // of a sibling.
+  bool is_symmetric(
+    const Node& parent,
+    const Node::UnassignedTasks::value_type& u) const
+  {
+    if (u.first >= request_predecessors.size())
+      return false;
+
+    const auto& predecessor = request_predecessors[u.first];
+    return predecessor.has_value()
+      && parent.unassigned_tasks.find(*predecessor) != nullptr;
+  }
+
+  // An idle agent may only be given its first task once the interchangeable
+  // agent before it has one, since otherwise the child only swaps the plans
+  // of the two agents of a sibling.
+  bool is_symmetric(const Node& parent, std::size_t agent) const
+  {
+    if (symmetric_predecessors.empty())
+      return false;
+
+    const auto& predecessor = symmetric_predecessors[agent];
+    return predecessor.has_value()
+      && parent.assigned_tasks[agent].empty()
+      && parent.assigned_tasks[*predecessor].empty();
+  }
+
+  // A best candidate is only skipped for being symmetric if the agent before
+  // it is among the same best candidates, so the first agent of a group that
+  // can finish the task the soonest always keeps its child. This matters when
+  // the tolerances let one agent of a group finish sooner than the others.
+  bool is_symmetric(
+    const Node& parent,
+    const Candidates::Range& range,
+    std::size_t agent) const
+  {
+    if (!is_symmetric(parent, agent))
+      return false;
+
+    const auto predecessor = *symmetric_predecessors[agent];
+    for (auto it = range.begin; it != range.end; ++it)
+    {
+      if (it->entry->candidate == predecessor)
+        return true;
     }
+
+    return false;
   }
 
-  return !new_node;
-}
+  template<typename FilterT>
+  std::vector<ConstNodePtr> expand(
+    ConstNodePtr parent,
+    FilterT& filter,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now,
+    ThreadPool* pool)
+  {
+    const TraceSpan span(trace_sink(), "expand");
+    counters.count(counters.nodes_expanded);
+    if (pool)
+      return parallel_expand(parent, filter, initial_states, time_now, *pool);
 
-// ============================================================================
-const rmf_traffic::Duration segmentation_threshold =
-  rmf_traffic::time::from_seconds(1.0);
+    std::vector<ConstNodePtr> new_nodes;
+    new_nodes.reserve(
+      parent->unassigned_tasks.size() + parent->assigned_tasks.size());
+    for (const auto& u : parent->unassigned_tasks)
+    {
+      // The children found so far are returned once the search is interrupted
+      // so that the caller can stop without waiting for the whole expansion
+      if (interruption())
+        return new_nodes;
 
-} // anonymous namespace
+      const auto& range = u.second.candidates.best_candidates();
+      const bool symmetric_request = is_symmetric(*parent, u);
+      for (auto it = range.begin; it != range.end; it++)
+      {
+        if (symmetric_request
+          || is_symmetric(*parent, range, it->entry->candidate))
+        {
+          counters.count(counters.nodes_symmetric);
+          continue;
+        }
 
-// ============================================================================
-class TaskPlanner::Implementation
-{
-public:
-  Configuration config;
-  Options default_options;
-  ConstTravelEstimatorPtr travel_estimator;
-  std::string planner_id;
-  bool check_priority = false;
-  ConstCostCalculatorPtr cost_calculator = nullptr;
+        auto new_node = expand_candidate(*it->entry, u, parent, time_now);
+        if (!new_node)
+          continue;
 
-  static constexpr std::string_view DefaultTaskPlannerName = "task_planner";
+        if (filter.ignore(*new_node))
+        {
+          counters.count(counters.nodes_filtered);
+          continue;
+        }
 
-  ConstRequestPtr make_charging_request(
-    rmf_traffic::Time start_time,
-    rmf_traffic::Time time_now)
-  {
-    return rmf_task::requests::ChargeBattery::make(
-      start_time,
-      planner_id,
-      time_now,
-      nullptr,
-      true);
-  }
+        new_nodes.push_back(std::move(new_node));
+      }
+    }
 
-  TaskPlanner::Assignments prune_assignments(
-    TaskPlanner::Assignments& assignments)
-  {
-    for (std::size_t a = 0; a < assignments.size(); ++a)
+    // Assign charging task to each robot
+    for (std::size_t i = 0; i < parent->assigned_tasks.size(); ++i)
     {
-      if (assignments[a].empty())
+      if (is_symmetric(*parent, i))
+      {
+        counters.count(counters.nodes_symmetric);
         continue;
+      }
 
-      // Remove charging task at end of assignments if any
-      // TODO(YV): Remove this after fixing the planner
-      if (std::dynamic_pointer_cast<
-          const rmf_task::requests::ChargeBattery::Description>(
-          assignments[a].back().request()->description()))
-        assignments[a].pop_back();
+      if (auto new_node = expand_charger(
+          parent, i, initial_states, time_now))
+        new_nodes.push_back(std::move(new_node));
     }
 
-    return assignments;
+    return new_nodes;
   }
 
-  ConstNodePtr prune_assignments(ConstNodePtr parent)
+  // Produces exactly the same children in the same order as the serial branch
+  // of expand(). The children are estimated concurrently, but the filter is
+  // only applied afterwards, following the serial visiting order, so that the
+  // filter sees the same sequence of nodes either way.
+  template<typename FilterT>
+  std::vector<ConstNodePtr> parallel_expand(
+    const ConstNodePtr& parent,
+    FilterT& filter,
+    const std::vector<State>& initial_states,
+    rmf_traffic::Time time_now,
+    ThreadPool& pool)
   {
-    auto node = std::make_shared<Node>(*parent);
+    struct CandidateJob
+    {
+      const Candidates::Entry* entry;
+      const Node::UnassignedTasks::value_type* u;
+    };
 
-    for (auto& agent : node->assigned_tasks)
+    std::vector<CandidateJob> candidate_jobs;
+    for (const auto& u : parent->unassigned_tasks)
     {
-      if (agent.empty())
-        continue;
+      const auto& range = u.second.candidates.best_candidates();
+      const bool symmetric_request = is_symmetric(*parent, u);
+      for (auto it = range.begin; it != range.end; it++)
+      {
+        if (symmetric_request
+          || is_symmetric(*parent, range, it->entry->candidate))
+        {
+          counters.count(counters.nodes_symmetric);
+          continue;
+        }
 
-      if (std::dynamic_pointer_cast<
-          const rmf_task::requests::ChargeBattery::Description>(
-          agent.back().assignment.request()->description()))
-        agent.pop_back();
+        candidate_jobs.push_back({it->entry.get(), &u});
+      }
     }
 
-    return node;
-  }
+    const std::size_t num_candidates = candidate_jobs.size();
+    const std::size_t num_agents = parent->assigned_tasks.size();
+    std::vector<ConstNodePtr> children(num_candidates + num_agents);
 
-  void append_finishing_request(
-    const RequestFactory& factory,
-    TaskPlanner::Assignments& complete_assignments,
-    rmf_traffic::Time time_now)
-  {
-    for (auto& agent : complete_assignments)
+    pool.parallel_for(
+      children.size(),
+      [&](std::size_t i)
+      {
+        if (i < num_candidates)
+        {
+          const auto& job = candidate_jobs[i];
+          children[i] =
+            expand_candidate(*job.entry, *job.u, parent, time_now);
+        }
+        else if (is_symmetric(*parent, i - num_candidates))
+        {
+          counters.count(counters.nodes_symmetric);
+        }
+        else
+        {
+          children[i] = expand_charger(
+            parent, i - num_candidates, initial_states, time_now);
+        }
+      });
+
+    std::vector<ConstNodePtr> new_nodes;
+    new_nodes.reserve(children.size());
+    for (std::size_t i = 0; i < children.size(); ++i)
     {
-      if (agent.empty())
+      auto& child = children[i];
+      if (!child)
+        continue;
+
+      if (i < num_candidates && filter.ignore(*child))
       {
+        counters.count(counters.nodes_filtered);
         continue;
       }
 
-      const auto& state = agent.back().finish_state();
-      const auto request = factory.make_request(state);
+      new_nodes.push_back(std::move(child));
+    }
 
-      // TODO(YV) Currently we are unable to recursively call complete_solve()
-      // here as the prune_assignments() function will remove any ChargeBattery
-      // requests at the back of the assignments. But the finishing factory
-      // could be a ChargeBattery request and hence this approach does not work.
-      // When we fix the logic with unnecessary ChargeBattery tasks, we should
-      // revist making this a recursive call.
-      auto model = request->description()->make_model(
-        state.time().value(),
-        config.parameters());
-      auto estimate = model->estimate_finish(
-        state, config.constraints(), *travel_estimator);
-      if (estimate.has_value())
-      {
-        agent.push_back(
-          Assignment
-          {
-            request,
-            estimate.value().finish_state(),
-            estimate.value().wait_until()
-          });
-      }
-      else
+    return new_nodes;
+  }
+
+  bool finished(const Node& node)
+  {
+    for (const auto& u : node.unassigned_tasks)
+    {
+      const auto range = u.second.candidates.best_candidates();
+      for (auto it = range.begin; it != range.end; ++it)
       {
-        // Insufficient battery to perform the finishing request. We check if
-        // adding a ChargeBattery task before will allow for it to be performed
-        const auto charging_request =
-          make_charging_request(state.time().value(), time_now);
-        const auto charge_battery_model =
-          charging_request->description()->make_model(
-          state.time().value(),
-          config.parameters());
-        const auto charge_battery_estimate =
-          charge_battery_model->estimate_finish(
-          state, config.constraints(), *travel_estimator);
-        if (charge_battery_estimate.has_value())
-        {
-          model = request->description()->make_model(
-            charge_battery_estimate.value().finish_state().time().value(),
-            config.parameters());
-          estimate = model->estimate_finish(
-            charge_battery_estimate.value().finish_state(),
-            config.constraints(),
-            *travel_estimator);
-          if (estimate.has_value())
-          {
-            // Append the ChargeBattery and finishing request
-            agent.push_back(
-              Assignment{
-                charging_request,
-                charge_battery_estimate.value().finish_state(),
-                charge_battery_estimate.value().wait_until()
-              });
-            agent.push_back(
-              Assignment
-              {
-                request,
-                estimate.value().finish_state(),
-                estimate.value().wait_until()
-              });
-          }
-        }
+        const auto wait_time = it->wait_until;
+        if (wait_time <= node.latest_time + segmentation_threshold)
+          return false;
       }
     }
+
+    return true;
   }
 
-  Result complete_solve(
+  // How much cheaper than the incumbent a node must be estimated to be before
+  // the optimal solvers consider it
+  static constexpr double IncumbentEpsilon = 1e-6;
+
+  // A best-first search with branch and bound. The greedy solution of the
+  // segment is the first incumbent, and no child is queued unless its cost
+  // estimate is below the incumbent. Once the most promising open node cannot
+  // beat the incumbent, the incumbent is proven to be optimal.
+  ConstNodePtr solve(
+    ConstNodePtr initial_node,
+    const std::vector<State>& initial_states,
+    const std::size_t num_tasks,
     rmf_traffic::Time time_now,
-    std::vector<State>& initial_states,
-    const std::vector<ConstRequestPtr>& requests,
-    const std::function<bool()> interrupter,
-    ConstRequestFactoryPtr finishing_request,
-    bool greedy)
+    ThreadPool* pool,
+    const std::size_t max_open_nodes)
   {
+    const TraceSpan span(trace_sink(), "solve");
+    const ConstNodePtr incumbent =
+      greedy_solve(initial_node, initial_states, time_now);
+    const double incumbent_cost = incumbent ?
+      incumbent->cost_estimate : std::numeric_limits<double>::infinity();
+    const double bound = incumbent_cost - IncumbentEpsilon;
+
+    OpenQueue priority_queue(max_open_nodes);
+    priority_queue.push(std::move(initial_node));
+    counters.observe_open_nodes(priority_queue.size());
 
-    cost_calculator = config.cost_calculator() ? config.cost_calculator() :
-      rmf_task::BinaryPriorityScheme::make_cost_calculator();
+    DominanceFilter filter{num_tasks, initial_states, prune_dominated_nodes};
+    ConstNodePtr top = nullptr;
 
-    // Also check if a high priority task exists among the requests.
-    // If so the cost function for a node will be modified accordingly.
-    for (const auto& request : requests)
+    // The agents whose first assignments were reported during this search.
+    // The open nodes are scanned for agreed first assignments less and less
+    // often as the queue grows, so the scans stay a small share of the work.
+    std::vector<std::size_t> reported;
+    std::size_t iterations = 0;
+    std::size_t next_scan = 64;
+    const auto keeps_reported = [&](const Node& node)
+      {
+        return std::all_of(reported.begin(), reported.end(),
+            [&](std::size_t a)
+            {
+              const auto& agent = node.assigned_tasks[a];
+              return !agent.empty() && agent.front().internal_id
+              == incumbent->assigned_tasks[a].front().internal_id;
+            });
+      };
+
+    while (!priority_queue.empty())
     {
-      if (request->booking()->priority())
+      if (interruption())
       {
-        check_priority = true;
+        auto& stats = Statistics::Implementation::get(statistics);
+        stats.interrupted = true;
+        stats.record_segment(std::numeric_limits<double>::infinity(), 0.0);
+
+        // Keep the work done so far by greedily finishing the most promising
+        // open node, unless the incumbent is still better. The greedy solver
+        // may backtrack over a reported assignment, in which case the
+        // incumbent is kept as well.
+        auto finished_top =
+          greedy_solve(priority_queue.top(), initial_states, time_now);
+        if (incumbent && (!finished_top
+          || LowestCostEstimate()(finished_top, incumbent)
+          || !keeps_reported(*finished_top)))
+          return incumbent;
+
+        return finished_top;
+      }
+
+      top = priority_queue.top();
+
+      // Every open node is at least as costly as the top one, so none of them
+      // can beat the incumbent
+      if (top->cost_estimate >= bound)
         break;
+
+      if (commitments && incumbent && ++iterations == next_scan)
+      {
+        next_scan *= 2;
+        report_agreed_assignments(priority_queue, *incumbent, reported);
+      }
+
+      // Pop the top of the priority queue
+      priority_queue.pop();
+
+      // A node that has been dominated since it was opened cannot lead to
+      // anything better than the node that dominated it
+      if (filter.superseded(*top))
+      {
+        counters.count(counters.nodes_filtered);
+        continue;
+      }
+
+      // Check if unassigned tasks is empty -> solution found
+      if (finished(*top))
+      {
+        // A weighted search only guarantees to be within heuristic_weight of
+        // the optimal cost, and any discarded node might have been cheaper.
+        auto& stats = Statistics::Implementation::get(statistics);
+        const double pruned_cost = priority_queue.pruned_cost();
+        if (pruned_cost < top->cost_estimate)
+          stats.pruned = true;
+
+        stats.record_segment(
+          top->cost_estimate,
+          std::min(top->cost_estimate, pruned_cost) / heuristic_weight);
+        return top;
+      }
+
+      // Apply possible actions to expand the node
+      const auto new_nodes = expand(
+        top, filter, initial_states, time_now, pool);
+
+      // Add copies and with a newly assigned task to queue
+      for (const auto& n : new_nodes)
+      {
+        if (n->cost_estimate < bound)
+          priority_queue.push(n);
+        else
+          counters.count(counters.nodes_bounded);
       }
+
+      counters.observe_open_nodes(priority_queue.size());
     }
 
-    TaskPlannerError error;
-    auto node = make_initial_node(
-      initial_states, requests, time_now, error);
-    if (!node)
-      return error;
+    auto& stats = Statistics::Implementation::get(statistics);
+    const double pruned_cost = priority_queue.pruned_cost();
+    if (pruned_cost < incumbent_cost)
+      stats.pruned = true;
 
-    TaskPlanner::Assignments complete_assignments;
-    complete_assignments.resize(node->assigned_tasks.size());
+    if (incumbent)
+    {
+      stats.record_segment(
+        incumbent_cost,
+        std::min(incumbent_cost, pruned_cost) / heuristic_weight);
+    }
 
-    while (node)
+    return incumbent;
+  }
+
+  // A best-first search where several workers pop and expand nodes at once.
+  // Each worker keeps its own open list and steals the most promising node of
+  // another worker whenever its own list runs dry. Because the first finished
+  // node to be popped is not necessarily optimal while other workers are still
+  // expanding cheaper nodes, the best finished node is kept as an incumbent
+  // and the search only stops once no open node could lead to anything
+  // cheaper than it.
+  ConstNodePtr parallel_solve(
+    ConstNodePtr initial_node,
+    const std::vector<State>& initial_states,
+    const std::size_t num_tasks,
+    rmf_traffic::Time time_now,
+    const std::size_t num_workers,
+    const std::size_t max_open_nodes,
+    const std::vector<std::size_t>& cores)
+  {
+    const TraceSpan span(trace_sink(), "parallel_solve");
+    struct OpenList
     {
-      if (greedy)
-        node = greedy_solve(node, initial_states, time_now);
-      else
-        node = solve(node, initial_states,
-            requests.size(), time_now, interrupter);
+      std::mutex mutex;
+      OpenQueue queue;
+    };
+
+    // The node budget is divided evenly between the workers
+    const std::size_t capacity = max_open_nodes == 0 ? 0 :
+      std::max<std::size_t>(1, max_open_nodes / num_workers);
+    std::vector<OpenList> open(num_workers);
+    for (auto& list : open)
+      list.queue = OpenQueue(capacity);
+    ConcurrentFilter filter{num_tasks, 4*num_workers};
+
+    // The number of nodes that are either waiting in an open list or being
+    // expanded by a worker. The search is exhausted when this reaches zero.
+    std::atomic_size_t pending = 0;
+    std::atomic_bool stop = false;
+    bool interrupted = false;
+
+    // Workers that find every open list empty block until another worker
+    // pushes a node, the search runs out of nodes or it is stopped. Each
+    // wake-up bumps wake_version so that a waiting worker can tell whether
+    // anything happened since it last looked at the open lists.
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+    std::size_t wake_version = 0;
+    std::atomic_size_t idle_workers = 0;
+    const auto notify = [&]()
+      {
+        {
+          std::lock_guard<std::mutex> lock(wake_mutex);
+          ++wake_version;
+        }
+        wake.notify_all();
+      };
+
+    // The greedy solution of the segment is the first incumbent
+    std::mutex incumbent_mutex;
+    ConstNodePtr incumbent =
+      greedy_solve(initial_node, initial_states, time_now);
+    std::atomic<double> incumbent_cost = incumbent ?
+      incumbent->cost_estimate : std::numeric_limits<double>::infinity();
+
+    std::mutex error_mutex;
+    std::exception_ptr error;
+
+    // Whether a node might still lead to a better solution than the
+    // incumbent. A deterministic plan also keeps the nodes that cost as much
+    // as the incumbent, since one of them might lead to a solution that comes
+    // first in the tie-breaking order.
+    const bool deterministic = deterministic_seed.has_value();
+    const auto promising = [&](const Node& node)
+      {
+        return node.cost_estimate < incumbent_cost - IncumbentEpsilon
+          || (deterministic && node.cost_estimate <= incumbent_cost);
+      };
 
-      if (!node)
+    const auto push = [&](std::size_t worker, ConstNodePtr node)
       {
-        return {};
-      }
+        counters.observe_open_nodes(++pending);
+        {
+          std::lock_guard<std::mutex> lock(open[worker].mutex);
+          open[worker].queue.push(std::move(node));
+        }
 
-      // Here we prune assignments to remove any charging tasks at the back of
-      // the assignment list
-      node = prune_assignments(node);
-      assert(complete_assignments.size() == node->assigned_tasks.size());
-      for (std::size_t i = 0; i < complete_assignments.size(); ++i)
+        // A worker counts itself idle before it looks at the open lists, so
+        // either it finds this node or it is woken up for it
+        if (idle_workers > 0)
+          notify();
+      };
+
+    const auto pop = [&](std::size_t worker) -> ConstNodePtr
       {
-        auto& all_assignments = complete_assignments[i];
-        const auto& new_assignments = node->assigned_tasks[i];
-        for (const auto& a : new_assignments)
         {
-          all_assignments.push_back(a.assignment);
+          std::lock_guard<std::mutex> lock(open[worker].mutex);
+          auto& queue = open[worker].queue;
+          if (!queue.empty())
+          {
+            auto top = queue.top();
+            queue.pop();
+            return top;
+          }
         }
-      }
 
-      if (node->unassigned_tasks.empty())
+        // Steal the most promising node from the other workers
+        std::size_t victim = worker;
+        double best_cost = std::numeric_limits<double>::infinity();
+        for (std::size_t i = 0; i < open.size(); ++i)
+        {
+          if (i == worker)
+            continue;
+
+          std::lock_guard<std::mutex> lock(open[i].mutex);
+          const auto& queue = open[i].queue;
+          if (!queue.empty() && queue.top()->cost_estimate < best_cost)
+          {
+            best_cost = queue.top()->cost_estimate;
+            victim = i;
+          }
+        }
+
+        if (victim == worker)
+          return nullptr;
+
+        std::lock_guard<std::mutex> lock(open[victim].mutex);
+        auto& queue = open[victim].queue;
+        if (queue.empty())
+          return nullptr;
+
+        auto top = queue.top();
+        queue.pop();
+        return top;
+      };
+
+    const auto work = [&](std::size_t worker)
       {
-        auto pruned_assignments = prune_assignments(complete_assignments);
-        if (finishing_request != nullptr)
+        try
         {
-          append_finishing_request(
-            *finishing_request,
-            pruned_assignments,
-            time_now);
+          while (!stop)
+          {
+            if (interruption())
+            {
+              interrupted = true;
+              stop = true;
+              notify();
+              break;
+            }
+
+            ++idle_workers;
+            std::size_t seen;
+            {
+              std::lock_guard<std::mutex> lock(wake_mutex);
+              seen = wake_version;
+            }
+
+            const auto top = pop(worker);
+            if (!top)
+            {
+              if (pending == 0)
+              {
+                --idle_workers;
+                break;
+              }
+
+              std::unique_lock<std::mutex> lock(wake_mutex);
+              wake.wait(lock, [&]()
+                {
+                  return wake_version != seen || stop || pending == 0;
+                });
+              --idle_workers;
+              continue;
+            }
+
+            --idle_workers;
+
+            if (promising(*top))
+            {
+              if (finished(*top))
+              {
+                std::lock_guard<std::mutex> lock(incumbent_mutex);
+                if (!incumbent || LowestCostEstimate()(incumbent, top))
+                {
+                  incumbent = top;
+                  incumbent_cost = top->cost_estimate;
+                }
+              }
+              else
+              {
+                auto new_nodes = expand(
+                  top, filter, initial_states, time_now, nullptr);
+
+                for (auto& n : new_nodes)
+                {
+                  if (promising(*n))
+                    push(worker, std::move(n));
+                  else
+                    counters.count(counters.nodes_bounded);
+                }
+              }
+            }
+
+            if (--pending == 0)
+              notify();
+          }
+        }
+        catch (...)
+        {
+          {
+            std::lock_guard<std::mutex> lock(error_mutex);
+            if (!error)
+              error = std::current_exception();
+          }
+
+          stop = true;
+          notify();
         }
+      };
 
-        return pruned_assignments;
-      }
+    push(0, std::move(initial_node));
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < num_workers; ++i)
+    {
+      threads.emplace_back(
+        [&work, &cores, i]()
+        {
+          const AllocationCounter::Scope scope(
+            AllocationCounter::Subsystem::Planner);
+          pin_current_thread(cores);
+          work(i);
+        });
+    }
+
+    work(0);
+
+    for (auto& thread : threads)
+      thread.join();
+
+    if (error)
+      std::rethrow_exception(error);
 
-      std::vector<ConstRequestPtr> new_tasks;
-      for (const auto& u : node->unassigned_tasks)
-        new_tasks.push_back(u.second.request);
-
-      // copy final state estimates
-      std::vector<State> estimates;
-      rmf_traffic::agv::Plan::Start empty_new_location{
-        time_now, 0, 0.0};
-      estimates.resize(
-        node->assigned_tasks.size(),
-        State().load_basic(empty_new_location, 0, 0.0));
-      for (std::size_t i = 0; i < node->assigned_tasks.size(); ++i)
-      {
-        const auto& assignments = node->assigned_tasks[i];
-        if (assignments.empty())
-          estimates[i] = initial_states[i];
-        else
-          estimates[i] = assignments.back().assignment.finish_state();
+    // Every node that could still lead to a cheaper solution is waiting in an
+    // open list, so the cheapest of them bounds the optimal cost from below.
+    double lower_bound = incumbent_cost;
+    double pruned_cost = std::numeric_limits<double>::infinity();
+    ConstNodePtr best_open = nullptr;
+    for (auto& list : open)
+    {
+      if (!list.queue.empty())
+      {
+        const auto& top = list.queue.top();
+        lower_bound = std::min(lower_bound, top->cost_estimate);
+        if (!best_open || LowestCostEstimate()(best_open, top))
+          best_open = top;
       }
 
-      node = make_initial_node(
-        estimates, new_tasks, time_now, error);
-      if (!node)
-        return error;
-      initial_states = estimates;
+      pruned_cost = std::min(pruned_cost, list.queue.pruned_cost());
     }
 
-    // If a finishing_request is present, accommodate the request at the end of
-    // the assignments for each agent
-    if (finishing_request != nullptr)
+    auto& stats = Statistics::Implementation::get(statistics);
+    stats.interrupted = stats.interrupted || interrupted;
+    if (pruned_cost < incumbent_cost)
+      stats.pruned = true;
+
+    lower_bound = std::min(lower_bound, pruned_cost);
+    stats.record_segment(incumbent_cost, lower_bound / heuristic_weight);
+
+    // If the search was interrupted before any solution was finished, keep
+    // the work done so far by greedily finishing the most promising open node
+    if (interrupted && !incumbent && best_open)
+      return greedy_solve(best_open, initial_states, time_now);
+
+    return incumbent;
+  }
+
+  // The model to re-estimate an existing assignment with
+  Task::ConstModelPtr model_of(const Assignment& assignment)
+  {
+    if (assignment.model())
+      return assignment.model();
+
+    if (assignment.is_charging())
+      return charging_model;
+
+    const auto& request = assignment.request();
+    return model_cache->get(
+      request, request->booking()->earliest_start_time(), config.parameters());
+  }
+
+  // Estimate the request after the given state, with a provisional charge
+  // before it if the battery would not last otherwise. The assignments are
+  // appended to output. Returns false if the request cannot be performed from
+  // the state.
+  bool append_estimate(
+    std::vector<Assignment>& output,
+    const ConstRequestPtr& request,
+    const Task::ConstModelPtr& model,
+    const State& state)
+  {
+    if (auto estimate = estimate_finish(*model, state))
     {
-      append_finishing_request(
-        *finishing_request,
-        complete_assignments,
-        time_now);
+      output.emplace_back(
+        request,
+        std::move(*estimate).finish_state(),
+        estimate->wait_until(),
+        model);
+      return true;
     }
 
-    return complete_assignments;
+    auto charge = estimate_finish(*charging_model, state);
+    if (!charge.has_value())
+      return false;
+
+    auto estimate = estimate_finish(*model, charge->finish_state());
+    if (!estimate.has_value())
+      return false;
+
+    output.emplace_back(
+      make_provisional_charge(state.time().value()),
+      charge->finish_state(),
+      charge->wait_until());
+    output.emplace_back(
+      request,
+      std::move(*estimate).finish_state(),
+      estimate->wait_until(),
+      model);
+    return true;
   }
 
-  ConstNodePtr make_initial_node(
-    std::vector<State> initial_states,
-    std::vector<ConstRequestPtr> requests,
-    rmf_traffic::Time time_now,
-    TaskPlannerError& error)
+  // Insert the request at one position of an agent's assignments and
+  // re-estimate the assignments that come after it. Once an assignment
+  // finishes in the same state as before, the rest are kept as they were.
+  std::optional<std::vector<Assignment>> insert(
+    const std::vector<Assignment>& current,
+    const State& initial_state,
+    std::size_t position,
+    const ConstRequestPtr& request,
+    const Task::ConstModelPtr& model)
   {
-    auto initial_node = std::make_shared<Node>();
+    std::vector<Assignment> output(
+      current.begin(), current.begin() + position);
+    const auto& start = position == 0 ?
+      initial_state : current[position-1].finish_state();
 
-    initial_node->assigned_tasks.resize(initial_states.size());
+    if (!append_estimate(output, request, model, start))
+      return std::nullopt;
 
-    for (const auto& request : requests)
+    for (std::size_t i = position; i < current.size(); ++i)
     {
-      // Generate a unique internal id for the request. Currently, multiple
-      // requests with the same string id will be assigned different internal ids
-      std::size_t internal_id = initial_node->get_available_internal_id();
-      const auto pending_task = PendingTask::make(
-        time_now,
-        initial_states,
-        config.constraints(),
-        config.parameters(),
-        request,
-        *travel_estimator,
-        planner_id,
-        error);
+      const auto& previous = current[i].finish_state();
+      const auto& state = output.back().finish_state();
+      if (state.time() == previous.time()
+        && state.waypoint() == previous.waypoint()
+        && state.battery_soc() == previous.battery_soc())
+      {
+        output.insert(output.end(), current.begin() + i, current.end());
+        return output;
+      }
 
-      if (!pending_task)
-        return nullptr;
+      const auto model_i = model_of(current[i]);
+      auto estimate = estimate_finish(*model_i, state);
+      if (!estimate.has_value())
+        return std::nullopt;
 
-      initial_node->unassigned_tasks.insert(
-        {
-          internal_id,
-          *pending_task
-        });
+      output.emplace_back(
+        current[i].request(),
+        std::move(*estimate).finish_state(),
+        estimate->wait_until(),
+        model_i);
     }
 
-    initial_node->cost_estimate = cost_calculator->compute_cost(
-      *initial_node, time_now, check_priority);
-
-    initial_node->sort_invariants();
+    return output;
+  }
 
-    initial_node->latest_time =
-      [&]() -> rmf_traffic::Time
-      {
-        rmf_traffic::Time latest = rmf_traffic::Time::min();
-        for (const auto& s : initial_states)
-        {
-          if (latest < s.time().value())
-            latest = s.time().value();
-        }
+  std::optional<Insertion> evaluate_insertion(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const Assignments& current,
+    const ConstRequestPtr& request)
+  {
+    if (agents.size() != current.size())
+    {
+      throw std::invalid_argument(
+        "[TaskPlanner::evaluate_insertion] There are ["
+        + std::to_string(agents.size()) + "] agents but assignments for ["
+        + std::to_string(current.size()) + "] agents");
+    }
 
-        return latest;
-      } ();
+    const auto calculator = config.cost_calculator() ?
+      config.cost_calculator() :
+      rmf_task::BinaryPriorityScheme::make_cost_calculator();
 
-    rmf_traffic::Time wait_until = rmf_traffic::Time::max();
+    const auto model = model_cache->get(
+      request, request->booking()->earliest_start_time(), config.parameters());
+    const double base_cost = calculator->compute_cost(current);
 
-    for (const auto& u : initial_node->unassigned_tasks)
+    std::optional<Insertion> best;
+    Assignments candidate = current;
+    for (std::size_t a = 0; a < current.size(); ++a)
     {
-      const auto& range = u.second.candidates.best_candidates();
-      for (auto it = range.begin; it != range.end; ++it)
+      for (std::size_t p = 0; p <= current[a].size(); ++p)
       {
-        if (it->second.wait_until < wait_until)
-          wait_until = it->second.wait_until;
+        auto inserted = insert(current[a], agents[a], p, request, model);
+        if (!inserted.has_value())
+          continue;
+
+        const std::size_t position =
+          inserted->size() == current[a].size() + 2 ? p + 1 : p;
+
+        candidate[a] = std::move(*inserted);
+        const double delta = calculator->compute_cost(candidate) - base_cost;
+        if (!best.has_value() || delta < best->cost_delta)
+          best = Insertion{a, position, candidate, delta};
+
+        candidate[a] = current[a];
       }
     }
 
-    if (initial_node->latest_time < wait_until)
-      initial_node->latest_time = wait_until;
+    if (best.has_value())
+      finalize_charges(best->assignments, time_now);
 
-    return initial_node;
+    return best;
   }
 
-  rmf_traffic::Time get_latest_time(const Node& node)
+  // The requests of one agent in the order that the local search has given
+  // them, along with the assignments that they were estimated into
+  struct Route
   {
-    rmf_traffic::Time latest = rmf_traffic::Time::min();
-    for (const auto& a : node.assigned_tasks)
+    struct Item
     {
-      if (a.empty())
-        continue;
+      ConstRequestPtr request;
+      Task::ConstModelPtr model;
+    };
 
-      const auto finish_time =
-        a.back().assignment.finish_state().time().value();
+    std::vector<Item> items;
+    std::vector<Assignment> assignments;
 
-      if (latest < finish_time)
-        latest = finish_time;
+    // The number of assignments up to and including each item. This is more
+    // than the item's index when charges were added in front of items.
+    std::vector<std::size_t> ends;
+  };
+
+  // Estimate the items of a route from the given item onwards. The
+  // assignments of the items in front of it are kept. Returns false if one of
+  // the items cannot be performed.
+  bool estimate_route(
+    Route& route,
+    const State& initial_state,
+    std::size_t from)
+  {
+    from = std::min(from, route.ends.size());
+    const std::size_t keep = from == 0 ? 0 : route.ends[from-1];
+    route.assignments.erase(
+      route.assignments.begin() + keep, route.assignments.end());
+    route.ends.resize(from);
+
+    for (std::size_t i = from; i < route.items.size(); ++i)
+    {
+      const auto& item = route.items[i];
+      const State& state = route.assignments.empty() ?
+        initial_state : route.assignments.back().finish_state();
+      if (!append_estimate(route.assignments, item.request, item.model, state))
+        return false;
+
+      route.ends.push_back(route.assignments.size());
     }
 
-    assert(latest > rmf_traffic::Time::min());
-    return latest;
+    return true;
   }
 
-  ConstNodePtr expand_candidate(
-    const Candidates::Map::const_iterator& it,
-    const Node::UnassignedTasks::value_type& u,
-    const ConstNodePtr& parent,
-    Filter* filter,
-    rmf_traffic::Time time_now)
+  // The best change to at most two routes that was found in one neighborhood
+  struct Move
   {
-    const auto& entry = it->second;
-    const auto& constraints = config.constraints();
+    double cost = std::numeric_limits<double>::infinity();
+    std::size_t a = 0;
+    std::size_t b = 0;
+    std::optional<Route> route_a;
+    std::optional<Route> route_b;
+  };
 
-    if (parent->latest_time + segmentation_threshold < entry.wait_until)
-    {
+  // Search one kind of move that starts from agent a. The neighborhoods are:
+  // 0 - relocate an item of a to any position of any route
+  // 1 - swap an item of a with an item of a or of a later route
+  // 2 - reverse a stretch of the items of a
+  // 3 - exchange the tail of a with the tail of a later route
+  Move search_neighborhood(
+    std::size_t neighborhood,
+    std::size_t a,
+    const std::vector<Route>& routes,
+    const std::vector<State>& agents,
+    const CostCalculator& calculator,
+    double current_cost,
+    const std::function<bool()>& stop)
+  {
+    Move best;
+    best.cost = current_cost;
 
-      // No need to assign task as timeline is not relevant
-      return nullptr;
-    }
+    Assignments candidate;
+    candidate.reserve(routes.size());
+    for (const auto& route : routes)
+      candidate.push_back(route.assignments);
 
-    auto new_node = std::make_shared<Node>(*parent);
+    const auto consider = [&](std::size_t b, Route& ra, Route* rb)
+      {
+        candidate[a] = ra.assignments;
+        if (rb)
+          candidate[b] = rb->assignments;
 
-    // Assign the unassigned task after checking for implicit charging requests
-    if (entry.require_charge_battery)
+        const double cost = calculator.compute_cost(candidate);
+        if (cost < best.cost - 1e-9)
+        {
+          best.cost = cost;
+          best.a = a;
+          best.b = b;
+          best.route_a = ra;
+          best.route_b = rb ? std::optional<Route>(*rb) : std::nullopt;
+        }
+
+        candidate[a] = routes[a].assignments;
+        if (rb)
+          candidate[b] = routes[b].assignments;
+      };
+
+    const auto& from = routes[a];
+    const std::size_t n = from.items.size();
+    if (neighborhood == 0)
     {
-      // Check if a battery task already precedes the latest assignment
-      auto& assignments = new_node->assigned_tasks[entry.candidate];
-      if (assignments.empty() || !std::dynamic_pointer_cast<
-          const rmf_task::requests::ChargeBattery::Description>(
-          assignments.back().assignment.request()->description()))
-      {
-        auto charge_battery = make_charging_request(
-          entry.previous_state.time().value(), time_now);
-        const auto charge_battery_model =
-          charge_battery->description()->make_model(
-          charge_battery->booking()->earliest_start_time(),
-          config.parameters());
-        auto battery_estimate = charge_battery_model->estimate_finish(
-          entry.previous_state, constraints, *travel_estimator);
-        if (battery_estimate.has_value())
+      for (std::size_t i = 0; i < n && !stop(); ++i)
+      {
+        Route removed = from;
+        removed.items.erase(removed.items.begin() + i);
+        for (std::size_t b = 0; b < routes.size(); ++b)
         {
-          assignments.push_back(
-            Node::AssignmentWrapper
-            { u.first,
-              Assignment
-              {
-                charge_battery,
-                battery_estimate.value().finish_state(),
-                battery_estimate.value().wait_until()
-              }
+          if (b == a)
+          {
+            for (std::size_t j = 0; j < n; ++j)
+            {
+              if (j == i)
+                continue;
+
+              Route ra = removed;
+              ra.items.insert(ra.items.begin() + j, from.items[i]);
+              if (estimate_route(ra, agents[a], std::min(i, j)))
+                consider(a, ra, nullptr);
             }
-          );
+
+            continue;
+          }
+
+          Route ra = removed;
+          if (!estimate_route(ra, agents[a], i))
+            continue;
+
+          for (std::size_t j = 0; j <= routes[b].items.size(); ++j)
+          {
+            Route rb = routes[b];
+            rb.items.insert(rb.items.begin() + j, from.items[i]);
+            if (estimate_route(rb, agents[b], j))
+              consider(b, ra, &rb);
+          }
         }
       }
     }
-    new_node->assigned_tasks[entry.candidate].push_back(
-      Node::AssignmentWrapper{u.first,
-        Assignment{u.second.request, entry.state, entry.wait_until}});
-
-    // Erase the assigned task from unassigned tasks
-    new_node->pop_unassigned(u.first);
-
-    // Update states of unassigned tasks for the candidate
-    bool add_charger = false;
-    for (auto& new_u : new_node->unassigned_tasks)
+    else if (neighborhood == 1)
     {
-      const auto finish =
-        new_u.second.model->estimate_finish(
-        entry.state, constraints, *travel_estimator);
-
-      if (finish.has_value())
+      for (std::size_t i = 0; i < n && !stop(); ++i)
       {
-        new_u.second.candidates.update_candidate(
-          entry.candidate,
-          finish.value().finish_state(),
-          finish.value().wait_until(),
-          entry.state,
-          false);
+        for (std::size_t b = a; b < routes.size(); ++b)
+        {
+          const std::size_t first = b == a ? i + 1 : 0;
+          for (std::size_t j = first; j < routes[b].items.size(); ++j)
+          {
+            Route ra = from;
+            if (b == a)
+            {
+              std::swap(ra.items[i], ra.items[j]);
+              if (estimate_route(ra, agents[a], i))
+                consider(a, ra, nullptr);
+
+              continue;
+            }
+
+            Route rb = routes[b];
+            std::swap(ra.items[i], rb.items[j]);
+            if (estimate_route(ra, agents[a], i)
+              && estimate_route(rb, agents[b], j))
+              consider(b, ra, &rb);
+          }
+        }
       }
-      else
+    }
+    else if (neighborhood == 2)
+    {
+      for (std::size_t i = 0; i < n && !stop(); ++i)
       {
-        // TODO(YV): Revisit this strategy
-        // auto battery_estimate =
-        //   config->charge_battery_request()->estimate_finish(entry.state, constraints);
-        // if (battery_estimate.has_value())
-        // {
-        //   auto new_finish =
-        //     new_u.second.request->estimate_finish(
-        //       battery_estimate.value().finish_state(),
-        //       constraints);
-        //   assert(new_finish.has_value());
-        //   new_u.second.candidates.update_candidate(
-        //     entry.candidate,
-        //     new_finish.value().finish_state(),
-        //     new_finish.value().wait_until());
-        // }
-        // else
-        // {
-        //   // Unable to reach charger
-        //   return nullptr;
-        // }
-
-        add_charger = true;
-        break;
+        for (std::size_t j = i + 2; j <= n; ++j)
+        {
+          Route ra = from;
+          std::reverse(ra.items.begin() + i, ra.items.begin() + j);
+          if (estimate_route(ra, agents[a], i))
+            consider(a, ra, nullptr);
+        }
       }
     }
-
-    if (add_charger)
+    else
     {
-      auto charge_battery = make_charging_request(
-        entry.state.time().value(), time_now);
-
-      const auto charge_battery_model =
-        charge_battery->description()->make_model(
-        charge_battery->booking()->earliest_start_time(),
-        config.parameters());
-      auto battery_estimate = charge_battery_model->estimate_finish(
-        entry.state, constraints, *travel_estimator);
-      if (battery_estimate.has_value())
+      for (std::size_t b = a + 1; b < routes.size() && !stop(); ++b)
       {
-        new_node->assigned_tasks[entry.candidate].push_back(
-          { new_node->get_available_internal_id(true),
-            Assignment
-            {
-              charge_battery,
-              battery_estimate.value().finish_state(),
-              battery_estimate.value().wait_until()
-            }});
-        for (auto& new_u : new_node->unassigned_tasks)
+        const auto& other = routes[b];
+        for (std::size_t i = 0; i <= n; ++i)
         {
-          const auto finish =
-            new_u.second.model->estimate_finish(
-            battery_estimate.value().finish_state(),
-            constraints, *travel_estimator);
-          if (finish.has_value())
-          {
-            new_u.second.candidates.update_candidate(
-              entry.candidate, finish.value().finish_state(),
-              finish.value().wait_until(), entry.state, false);
-          }
-          else
+          for (std::size_t j = 0; j <= other.items.size(); ++j)
           {
-            // We should stop expanding this node
-            return nullptr;
+            if (i == n && j == other.items.size())
+              continue;
+
+            Route ra = from;
+            Route rb = other;
+            ra.items.resize(i);
+            ra.items.insert(
+              ra.items.end(), other.items.begin() + j, other.items.end());
+            rb.items.resize(j);
+            rb.items.insert(
+              rb.items.end(), from.items.begin() + i, from.items.end());
+
+            if (estimate_route(ra, agents[a], i)
+              && estimate_route(rb, agents[b], j))
+              consider(b, ra, &rb);
           }
         }
-
       }
-      else
+    }
+
+    return best;
+  }
+
+  static constexpr std::size_t NumNeighborhoods = 4;
+
+  // Improve a greedy plan with local search until no move lowers its cost or
+  // the budget runs out. The assignments are left alone if they cannot be
+  // improved.
+  void local_search(
+    Assignments& assignments,
+    const std::vector<State>& agents,
+    rmf_traffic::Duration budget,
+    ThreadPool* pool)
+  {
+    const TraceSpan span(trace_sink(), "local_search");
+    const auto deadline = std::chrono::steady_clock::now() + budget;
+    const auto& calculator = *cost_calculator;
+
+    // Charges get added wherever they are needed, so only the requests are
+    // moved around
+    std::vector<Route> routes(assignments.size());
+    for (std::size_t a = 0; a < assignments.size(); ++a)
+    {
+      for (const auto& assignment : assignments[a])
       {
-        // Agent cannot make it back to the charger
-        return nullptr;
+        if (assignment.is_charging())
+          continue;
+
+        routes[a].items.push_back({assignment.request(), model_of(assignment)});
       }
+
+      if (!estimate_route(routes[a], agents[a], 0))
+        return;
     }
 
-    // Update the cost estimate for new_node
-    new_node->cost_estimate = cost_calculator->compute_cost(
-      *new_node, time_now, check_priority);
-    new_node->latest_time = get_latest_time(*new_node);
+    const auto collect = [&]()
+      {
+        Assignments output;
+        output.reserve(routes.size());
+        for (const auto& route : routes)
+          output.push_back(route.assignments);
 
-    // Apply filter
-    if (filter && filter->ignore(*new_node))
+        return output;
+      };
+
+    double cost = calculator.compute_cost(collect());
+    if (cost >= calculator.compute_cost(assignments))
     {
-      return nullptr;
+      // Estimating the requests again without the charges of the greedy plan
+      // must not make the plan worse than it was
+      cost = calculator.compute_cost(assignments);
+    }
+    else
+    {
+      assignments = collect();
     }
 
-    return new_node;
+    const std::function<bool()> stop = [&]()
+      {
+        return interruption.fired.load(std::memory_order_relaxed)
+          || deadline <= std::chrono::steady_clock::now();
+      };
+
+    const std::size_t num_jobs = NumNeighborhoods * routes.size();
+    std::vector<Move> moves(num_jobs);
+    while (!interruption() && !stop())
+    {
+      const auto job = [&](std::size_t k)
+        {
+          moves[k] = search_neighborhood(
+            k % NumNeighborhoods, k / NumNeighborhoods,
+            routes, agents, calculator, cost, stop);
+        };
+
+      if (pool)
+        pool->parallel_for(num_jobs, job);
+      else
+        for (std::size_t k = 0; k < num_jobs; ++k)
+          job(k);
 
+      // Take the cheapest move, preferring the earliest job on ties so the
+      // outcome does not depend on the threads
+      const Move* best = nullptr;
+      for (const auto& move : moves)
+      {
+        if (move.route_a.has_value() && (!best || move.cost < best->cost))
+          best = &move;
+      }
+
+      if (!best)
+        break;
+
+      routes[best->a] = *best->route_a;
+      if (best->route_b.has_value())
+        routes[best->b] = *best->route_b;
+
+      cost = best->cost;
+      assignments = collect();
+    }
   }
 
-  ConstNodePtr expand_charger(
-    ConstNodePtr parent,
-    const std::size_t agent,
-    const std::vector<State>& initial_states,
-    rmf_traffic::Time time_now)
+};
+
+// ============================================================================
+class TaskPlanner::Session::Implementation
+{
+public:
+
+  struct Request
   {
-    auto new_node = std::make_shared<Node>(*parent);
-    // Assign charging task to an agent
-    State state = initial_states[agent];
-    auto& assignments = new_node->assigned_tasks[agent];
+    ConstRequestPtr request;
 
-    // If the assignment set for a candidate is empty we do not want to add a
-    // charging task as this is taken care of in expand_candidate(). Without this
-    // step there is chance for the planner to get stuck in an infinite loop when
-    // a charging task is required before any other task can be assigned.
-    if (assignments.empty())
-      return nullptr;
+    // The estimates of this request for each agent, or nullptr if they have
+    // not been computed yet
+    std::shared_ptr<PendingTask> pending_task;
 
-    if (!assignments.empty())
-    {
-      if (std::dynamic_pointer_cast<
-          const rmf_task::requests::ChargeBattery::Description>(
-          assignments.back().assignment.request()->description()))
-        return nullptr;
-      state = assignments.back().assignment.finish_state();
-    }
+    // The earliest start time that the estimates were computed for
+    rmf_traffic::Time earliest_start_time;
+  };
 
-    auto charge_battery = make_charging_request(state.time().value(), time_now);
-    const auto charge_battery_model =
-      charge_battery->description()->make_model(
-      charge_battery->booking()->earliest_start_time(),
-      config.parameters());
-    auto estimate = charge_battery_model->estimate_finish(
-      state, config.constraints(), *travel_estimator);
-    if (estimate.has_value())
+  TaskPlanner::Implementation planner;
+  std::vector<State> agents;
+  std::vector<Request> requests;
+
+  // The agents whose states changed since the last successful replan
+  std::vector<bool> changed_agents;
+
+  static Session make(
+    const TaskPlanner::Implementation& planner,
+    std::vector<State> agents,
+    std::vector<ConstRequestPtr> requests)
+  {
+    Session session;
+    session._pimpl = rmf_utils::make_unique_impl<Implementation>(
+      Implementation{planner, std::move(agents), {}, {}});
+
+    auto& impl = *session._pimpl;
+    impl.planner.statistics = Statistics();
+    impl.changed_agents.resize(impl.agents.size(), false);
+    for (auto& request : requests)
+      impl.requests.push_back({std::move(request), nullptr, {}});
+
+    return session;
+  }
+
+  // Bring the estimates of every request up to date with the current agent
+  // states. Only the estimates of new requests, of requests whose earliest
+  // start time moved, and of agents that changed get recomputed. Estimates are
+  // never modified in place, so a copy of the requests can be brought up to
+  // date without affecting the original.
+  std::optional<TaskPlannerError> update_estimates(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& current_agents,
+    std::vector<Request>& current_requests,
+    std::vector<bool>& current_changes)
+  {
+    const auto& config = planner.config;
+    for (auto& r : current_requests)
     {
-      new_node->assigned_tasks[agent].push_back(
-        Node::AssignmentWrapper
-        {
-          new_node->get_available_internal_id(true),
-          Assignment
-          {
-            charge_battery,
-            estimate.value().finish_state(),
-            estimate.value().wait_until()
-          }
-        });
-      for (auto& new_u : new_node->unassigned_tasks)
-      {
-        const auto finish =
-          new_u.second.model->estimate_finish(
-          estimate.value().finish_state(),
-          config.constraints(), *travel_estimator);
-        if (finish.has_value())
-        {
-          new_u.second.candidates.update_candidate(
-            agent,
-            finish.value().finish_state(),
-            finish.value().wait_until(),
-            state,
-            false);
-        }
-        else
+      const auto earliest_start_time = std::max(
+        time_now, r.request->booking()->earliest_start_time());
+
+      TaskPlannerError error;
+      if (!r.pending_task || r.earliest_start_time != earliest_start_time)
+      {
+        r.pending_task = PendingTask::make(
+          time_now,
+          current_agents,
+          config.constraints(),
+          config.parameters(),
+          r.request,
+          *planner.travel_estimator,
+          planner.planner_id,
+          error,
+          &planner.counters.finish_estimates,
+          planner.model_cache.get(),
+          planner.charging_model.get(),
+          planner.estimate_profiler.get());
+
+        r.earliest_start_time = earliest_start_time;
+        if (!r.pending_task)
+          return error;
+
+        continue;
+      }
+
+      std::shared_ptr<PendingTask> updated;
+      for (std::size_t i = 0; i < current_agents.size(); ++i)
+      {
+        if (!current_changes[i])
+          continue;
+
+        if (!updated)
+          updated = std::make_shared<PendingTask>(*r.pending_task);
+
+        const bool feasible = updated->update_agent(
+          i,
+          time_now,
+          current_agents[i],
+          config.constraints(),
+          config.parameters(),
+          *planner.travel_estimator,
+          planner.planner_id,
+          error,
+          &planner.counters.finish_estimates,
+          planner.charging_model.get(),
+          planner.estimate_profiler.get());
+
+        if (!feasible)
         {
-          return nullptr;
+          r.pending_task = nullptr;
+          return error;
         }
       }
 
-      new_node->cost_estimate = cost_calculator->compute_cost(
-        *new_node, time_now, check_priority);
-      new_node->latest_time = get_latest_time(*new_node);
-      return new_node;
+      if (updated)
+        r.pending_task = std::move(updated);
     }
 
-    return nullptr;
+    std::fill(current_changes.begin(), current_changes.end(), false);
+    return std::nullopt;
   }
 
-  ConstNodePtr greedy_solve(
-    ConstNodePtr node,
-    const std::vector<State>& initial_states,
-    rmf_traffic::Time time_now)
+  std::optional<TaskPlannerError> update_estimates(rmf_traffic::Time time_now)
   {
-    while (!finished(*node))
+    return update_estimates(time_now, agents, requests, changed_agents);
+  }
+
+  // Note that the session has changed. Returns true if a preparation job
+  // needs to be posted, which must be done after the mutex is unlocked in
+  // case the executor runs the job right away.
+  bool schedule_preparation(const std::unique_lock<std::mutex>&)
+  {
+    if (!background->clock)
+      return false;
+
+    if (background->running)
     {
-      ConstNodePtr next_node = nullptr;
-      for (const auto& u : node->unassigned_tasks)
+      background->rerun = true;
+      return false;
+    }
+
+    background->running = true;
+    return true;
+  }
+
+  void post_preparation()
+  {
+    planner.executor()->post([this]() { prepare(); });
+  }
+
+  // Bring a copy of the estimates up to date while the mutex is unlocked, and
+  // keep the result if the session did not change in a way that invalidates
+  // it. Repeat for as long as changes keep arriving.
+  void prepare()
+  {
+    std::unique_lock<std::mutex> lock(background->mutex);
+    do
+    {
+      background->rerun = false;
+      if (!background->clock)
+        break;
+
+      const auto time_now = background->clock();
+      const auto version = background->agents_version;
+      const auto current_agents = agents;
+      const auto original = requests;
+      auto prepared = requests;
+      auto current_changes = changed_agents;
+      lock.unlock();
+
+      // Errors are left for replan() to report
+      bool succeeded = false;
+      try
       {
-        const auto& range = u.second.candidates.best_candidates();
-        for (auto it = range.begin; it != range.end; ++it)
-        {
-          if (auto n = expand_candidate(
-              it, u, node, nullptr, time_now))
-          {
-            if (!next_node || (n->cost_estimate < next_node->cost_estimate))
-            {
-              next_node = std::move(n);
-            }
-          }
-          else
-          {
-            // expand_candidate returned nullptr either due to start time
-            // segmentation or insufficient charge to return to its charger.
-            // For the later case, we aim to backtrack and assign a charging
-            // task to the agent.
-            if (node->latest_time + segmentation_threshold >
-              it->second.wait_until)
-            {
-              auto parent_node = std::make_shared<Node>(*node);
-              while (!parent_node->assigned_tasks[it->second.candidate].empty())
-              {
-                parent_node->assigned_tasks[it->second.candidate].pop_back();
-                auto new_charge_node = expand_charger(
-                  parent_node,
-                  it->second.candidate,
-                  initial_states,
-                  time_now);
-                if (new_charge_node)
-                {
-                  next_node = std::move(new_charge_node);
-                  break;
-                }
-              }
-            }
-          }
-        }
+        succeeded = !update_estimates(
+          time_now, current_agents, prepared, current_changes);
+      }
+      catch (...)
+      {
+        // Do nothing
       }
 
-      node = next_node;
-      assert(node);
-    }
+      lock.lock();
+      if (succeeded && version == background->agents_version)
+        commit_preparation(original, prepared);
+    } while (background->rerun);
 
-    return node;
+    background->running = false;
+    background->finished.notify_all();
   }
 
-  std::vector<ConstNodePtr> expand(
-    ConstNodePtr parent,
-    Filter& filter,
-    const std::vector<State>& initial_states,
-    rmf_traffic::Time time_now)
+  // Keep the prepared estimates of the requests whose estimates have not
+  // changed since the preparation began. Requests are only ever appended or
+  // erased, so the current requests appear in the same order as the prepared
+  // ones.
+  void commit_preparation(
+    const std::vector<Request>& original,
+    const std::vector<Request>& prepared)
   {
-    std::vector<ConstNodePtr> new_nodes;
-    new_nodes.reserve(
-      parent->unassigned_tasks.size() + parent->assigned_tasks.size());
-    for (const auto& u : parent->unassigned_tasks)
+    bool complete = true;
+    std::size_t j = 0;
+    for (auto& current : requests)
     {
-      const auto& range = u.second.candidates.best_candidates();
-      for (auto it = range.begin; it != range.end; it++)
+      while (j < prepared.size() && prepared[j].request != current.request)
+        ++j;
+
+      if (j < prepared.size()
+        && current.pending_task == original[j].pending_task
+        && current.earliest_start_time == original[j].earliest_start_time)
       {
-        if (auto new_node = expand_candidate(
-            it, u, parent, &filter, time_now))
-          new_nodes.push_back(std::move(new_node));
+        current.pending_task = prepared[j].pending_task;
+        current.earliest_start_time = prepared[j].earliest_start_time;
+        ++j;
+        continue;
       }
-    }
 
-    // Assign charging task to each robot
-    for (std::size_t i = 0; i < parent->assigned_tasks.size(); ++i)
-    {
-      if (auto new_node = expand_charger(
-          parent, i, initial_states, time_now))
-        new_nodes.push_back(std::move(new_node));
+      // Requests without estimates get estimated for every agent anyway
+      if (current.pending_task)
+        complete = false;
     }
 
-    return new_nodes;
+    if (complete)
+      std::fill(changed_agents.begin(), changed_agents.end(), false);
   }
 
-  bool finished(const Node& node)
+  Result replan(rmf_traffic::Time time_now, const Options& options)
   {
-    for (const auto& u : node.unassigned_tasks)
     {
-      const auto range = u.second.candidates.best_candidates();
-      for (auto it = range.begin; it != range.end; ++it)
-      {
-        const auto wait_time = it->second.wait_until;
-        if (wait_time <= node.latest_time + segmentation_threshold)
-          return false;
-      }
+      std::unique_lock<std::mutex> lock(background->mutex);
+      background->wait(lock);
     }
 
-    return true;
+    const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Planner);
+    const auto travel_before = planner.begin_statistics(options);
+    planner.begin_seeded_plan(options);
+    planner.statistics = Statistics();
+    planner.kernel_cache = planner.make_kernel_cache();
+    std::optional<TaskPlannerError> error;
+    {
+      TaskPlanner::Implementation::PhaseTimer timer{
+        planner.counters.initialization_time};
+      error = update_estimates(time_now);
+    }
+
+    if (error)
+    {
+      planner.record_statistics(travel_before);
+      return *error;
+    }
+
+    std::vector<ConstRequestPtr> current_requests;
+    std::vector<std::shared_ptr<const PendingTask>> pending_tasks;
+    current_requests.reserve(requests.size());
+    pending_tasks.reserve(requests.size());
+    for (const auto& r : requests)
+    {
+      current_requests.push_back(r.request);
+      pending_tasks.push_back(r.pending_task);
+    }
+
+    auto initial_states = agents;
+    auto result = planner.complete_solve(
+      time_now, initial_states, current_requests, options, &pending_tasks);
+    planner.finalize_charges(result, time_now);
+
+    planner.record_statistics(travel_before);
+    return result;
   }
 
-  ConstNodePtr solve(
-    ConstNodePtr initial_node,
-    const std::vector<State>& initial_states,
-    const std::size_t num_tasks,
-    rmf_traffic::Time time_now,
-    std::function<bool()> interrupter)
+  // The state of prepare_in_background(). The mutex guards the agents, the
+  // requests and the changed agents while a preparation job may be running.
+  struct Background
   {
-    using PriorityQueue = std::priority_queue<
-      ConstNodePtr,
-      std::vector<ConstNodePtr>,
-      LowestCostEstimate>;
+    std::function<rmf_traffic::Time()> clock;
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool running = false;
+    bool rerun = false;
 
-    PriorityQueue priority_queue;
-    priority_queue.push(std::move(initial_node));
+    // Incremented whenever an agent is updated, so a preparation that used an
+    // old state of the agent can be discarded
+    std::size_t agents_version = 0;
 
-    Filter filter{FilterType::Hash, num_tasks};
-    ConstNodePtr top = nullptr;
+    void wait(std::unique_lock<std::mutex>& lock)
+    {
+      finished.wait(lock, [&]() { return !running; });
+    }
 
-    while (!priority_queue.empty() && !(interrupter && interrupter()))
+    ~Background()
     {
-      top = priority_queue.top();
+      std::unique_lock<std::mutex> lock(mutex);
+      wait(lock);
+    }
+  };
 
-      // Pop the top of the priority queue
-      priority_queue.pop();
+  // This is declared last so that it is destroyed first, which waits for any
+  // preparation job that still uses the rest of the session.
+  std::unique_ptr<Background> background = std::make_unique<Background>();
+};
 
-      // Check if unassigned tasks is empty -> solution found
-      if (finished(*top))
+// ============================================================================
+TaskPlanner::Session::Session()
+{
+  // Do nothing
+}
+
+// ============================================================================
+auto TaskPlanner::Session::add_request(ConstRequestPtr request) -> Session&
+{
+  std::unique_lock<std::mutex> lock(_pimpl->background->mutex);
+  _pimpl->requests.push_back({std::move(request), nullptr, {}});
+  const bool post = _pimpl->schedule_preparation(lock);
+  lock.unlock();
+
+  if (post)
+    _pimpl->post_preparation();
+
+  return *this;
+}
+
+// ============================================================================
+bool TaskPlanner::Session::cancel_request(const std::string& request_id)
+{
+  std::unique_lock<std::mutex> lock(_pimpl->background->mutex);
+  auto& requests = _pimpl->requests;
+  const auto it = std::find_if(requests.begin(), requests.end(),
+      [&](const Implementation::Request& r)
       {
-        return top;
-      }
+        return r.request->booking()->id() == request_id;
+      });
 
-      // Apply possible actions to expand the node
-      const auto new_nodes = expand(
-        top, filter, initial_states, time_now);
+  if (it == requests.end())
+    return false;
 
-      // Add copies and with a newly assigned task to queue
-      for (const auto& n : new_nodes)
-        priority_queue.push(n);
-    }
+  // The remaining estimates stay valid, so nothing needs to be prepared
+  requests.erase(it);
+  return true;
+}
 
-    return nullptr;
+// ============================================================================
+auto TaskPlanner::Session::update_agent(std::size_t agent, State state)
+-> Session&
+{
+  if (agent >= _pimpl->agents.size())
+  {
+    throw std::out_of_range(
+      "[TaskPlanner::Session::update_agent] Agent index ["
+      + std::to_string(agent) + "] is out of range for a session with ["
+      + std::to_string(_pimpl->agents.size()) + "] agents");
   }
 
-};
+  std::unique_lock<std::mutex> lock(_pimpl->background->mutex);
+  _pimpl->agents[agent] = std::move(state);
+  _pimpl->changed_agents[agent] = true;
+  ++_pimpl->background->agents_version;
+  const bool post = _pimpl->schedule_preparation(lock);
+  lock.unlock();
+
+  if (post)
+    _pimpl->post_preparation();
+
+  return *this;
+}
+
+// ============================================================================
+auto TaskPlanner::Session::agents() const -> const std::vector<State>&
+{
+  return _pimpl->agents;
+}
+
+// ============================================================================
+std::vector<ConstRequestPtr> TaskPlanner::Session::requests() const
+{
+  std::unique_lock<std::mutex> lock(_pimpl->background->mutex);
+  std::vector<ConstRequestPtr> output;
+  output.reserve(_pimpl->requests.size());
+  for (const auto& r : _pimpl->requests)
+    output.push_back(r.request);
+
+  return output;
+}
+
+// ============================================================================
+auto TaskPlanner::Session::prepare_in_background(
+  std::function<rmf_traffic::Time()> clock) -> Session&
+{
+  std::unique_lock<std::mutex> lock(_pimpl->background->mutex);
+  _pimpl->background->clock = std::move(clock);
+  const bool post = _pimpl->schedule_preparation(lock);
+  lock.unlock();
+
+  if (post)
+    _pimpl->post_preparation();
+
+  return *this;
+}
+
+// ============================================================================
+auto TaskPlanner::Session::replan(rmf_traffic::Time time_now) -> Result
+{
+  return _pimpl->replan(time_now, _pimpl->planner.default_options);
+}
+
+// ============================================================================
+auto TaskPlanner::Session::replan(rmf_traffic::Time time_now, Options options)
+-> Result
+{
+  return _pimpl->replan(time_now, options);
+}
+
+// ============================================================================
+auto TaskPlanner::Session::statistics() const -> const Statistics&
+{
+  return _pimpl->planner.statistics;
+}
 
 // ============================================================================
 TaskPlanner::TaskPlanner(
@@ -1112,7 +6377,7 @@ TaskPlanner::TaskPlanner(
       Implementation{
         configuration,
         default_options,
-        std::make_shared<TravelEstimator>(configuration.parameters()),
+        Implementation::make_travel_estimator(configuration),
         std::string(Implementation::DefaultTaskPlannerName)
       }))
 {
@@ -1128,7 +6393,7 @@ TaskPlanner::TaskPlanner(
       Implementation{
         configuration,
         default_options,
-        std::make_shared<TravelEstimator>(configuration.parameters()),
+        Implementation::make_travel_estimator(configuration),
         planner_id
       }))
 {
@@ -1141,13 +6406,11 @@ auto TaskPlanner::plan(
   std::vector<State> agents,
   std::vector<ConstRequestPtr> requests) -> Result
 {
-  return _pimpl->complete_solve(
+  return plan(
     time_now,
-    agents,
-    requests,
-    _pimpl->default_options.interrupter(),
-    _pimpl->default_options.finishing_request(),
-    _pimpl->default_options.greedy());
+    std::move(agents),
+    std::move(requests),
+    _pimpl->default_options);
 }
 
 // ============================================================================
@@ -1157,13 +6420,130 @@ auto TaskPlanner::plan(
   std::vector<ConstRequestPtr> requests,
   Options options) -> Result
 {
-  return _pimpl->complete_solve(
-    time_now,
-    agents,
-    requests,
-    options.interrupter(),
-    options.finishing_request(),
-    options.greedy());
+  // Each call plans with a copy of the planner so that calls on different
+  // threads do not share any state of the search. The copies share the
+  // travel estimator, the model cache and the charge counter, which are all
+  // safe to use from several threads.
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Planner);
+  auto& published = _pimpl->published;
+  const auto& result_cache = _pimpl->result_cache;
+  auto key = result_cache ?
+    ResultCache::make_key(
+    time_now, agents, requests, options, *_pimpl->travel_estimator) :
+    std::nullopt;
+  if (key.has_value())
+  {
+    if (auto cached = result_cache->find(*key))
+    {
+      auto& [result, statistics] = *cached;
+      Statistics::Implementation::get(statistics).cached = true;
+      {
+        std::lock_guard<std::mutex> lock(published.mutex);
+        published.statistics = std::move(statistics);
+      }
+
+      if (const auto& callback = options.commitment_callback())
+      {
+        Implementation::Commitments commitments{
+          callback, std::vector<bool>(agents.size(), false), {}};
+        commitments.report_remaining(result);
+      }
+
+      return std::move(result);
+    }
+  }
+
+  // A partitioned plan is merged from the plans of its clusters, so its first
+  // assignments are only reported once it is finished
+  std::optional<Implementation::Commitments> commitments;
+  if (const auto& callback = options.commitment_callback())
+  {
+    commitments = Implementation::Commitments{
+      callback,
+      std::vector<bool>(agents.size(), false),
+      std::vector<bool>(agents.size(), false)};
+  }
+
+  Implementation context = *_pimpl;
+  if (commitments.has_value() && !context.config.partitioner())
+    context.commitments = &*commitments;
+
+  context.kernel_cache = context.make_kernel_cache();
+  const auto travel_before = context.begin_statistics(options);
+  context.begin_seeded_plan(options);
+
+  // The cache remembers the requests that were given, so the pooled requests
+  // are kept apart from them
+  auto planned = requests;
+  if (const auto window = options.delivery_pooling_window())
+  {
+    const auto& travel_estimator = *context.travel_estimator;
+    const TravelDuration travel =
+      [&travel_estimator](
+      std::size_t from, std::size_t to, rmf_traffic::Time start)
+      -> std::optional<rmf_traffic::Duration>
+      {
+        const auto estimate = travel_estimator.estimate(
+          rmf_traffic::agv::Plan::Start(start, from, 0.0), to);
+        if (!estimate.has_value())
+          return std::nullopt;
+
+        return estimate->duration();
+      };
+
+    planned = pool_deliveries(
+      requests, payload_capacity(agents), *window, travel);
+  }
+
+  auto result = context.config.partitioner() ?
+    context.partitioned_solve(time_now, agents, planned, options) :
+    context.complete_solve(time_now, agents, planned, options);
+  context.finalize_charges(result, time_now);
+  context.commitments = nullptr;
+
+  context.record_statistics(travel_before);
+  if (key.has_value() && !context.statistics.interrupted())
+  {
+    result_cache->insert(
+      std::move(*key), requests, result, context.statistics);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(published.mutex);
+    published.statistics = std::move(context.statistics);
+  }
+
+  if (commitments.has_value())
+    commitments->report_remaining(result);
+
+  return result;
+}
+
+// ============================================================================
+auto TaskPlanner::plan_flat(
+  rmf_traffic::Time time_now,
+  std::vector<State> agents,
+  std::vector<ConstRequestPtr> requests,
+  Options options) -> FlatResult
+{
+  const auto result = plan(
+    time_now, std::move(agents), std::move(requests), std::move(options));
+  if (const auto* error = std::get_if<TaskPlannerError>(&result))
+    return *error;
+
+  return FlatAssignments(std::get<Assignments>(result));
+}
+
+// ============================================================================
+auto TaskPlanner::evaluate_insertion(
+  rmf_traffic::Time time_now,
+  const std::vector<State>& agents,
+  const Assignments& current,
+  const ConstRequestPtr& request) const -> std::optional<Insertion>
+{
+  const AllocationCounter::Scope scope(AllocationCounter::Subsystem::Planner);
+  Implementation context = *_pimpl;
+  return context.evaluate_insertion(time_now, agents, current, request);
 }
 
 // ============================================================================
@@ -1177,6 +6557,67 @@ auto TaskPlanner::compute_cost(const Assignments& assignments) const -> double
   return cost_calculator->compute_cost(assignments);
 }
 
+// ============================================================================
+auto TaskPlanner::compute_objectives(const Assignments& assignments)
+-> Objectives
+{
+  Objectives objectives;
+  std::optional<rmf_traffic::Time> earliest_start;
+  std::optional<rmf_traffic::Time> latest_finish;
+  for (const auto& agent : assignments)
+  {
+    for (const auto& a : agent)
+    {
+      if (a.is_charging())
+        continue;
+
+      const auto& booking = *a.request()->booking();
+      const auto finish = a.finish_state().time().value();
+      const double delay = rmf_traffic::time::to_seconds(
+        finish - booking.earliest_start_time());
+
+      objectives.total_delay += delay;
+      if (booking.priority())
+        objectives.priority_delay += delay;
+
+      objectives.max_delay = std::max(objectives.max_delay, delay);
+      ++objectives.num_requests;
+
+      if (!earliest_start.has_value() ||
+        booking.earliest_start_time() < *earliest_start)
+        earliest_start = booking.earliest_start_time();
+
+      if (!latest_finish.has_value() || *latest_finish < finish)
+        latest_finish = finish;
+    }
+  }
+
+  if (earliest_start.has_value())
+  {
+    objectives.makespan = std::max(
+      rmf_traffic::Duration(0), *latest_finish - *earliest_start);
+  }
+
+  return objectives;
+}
+
+// ============================================================================
+auto TaskPlanner::statistics() const -> Statistics
+{
+  const auto& published = _pimpl->published;
+  std::lock_guard<std::mutex> lock(published.mutex);
+  return published.statistics;
+}
+
+// ============================================================================
+auto TaskPlanner::start_session(
+  std::vector<State> agents,
+  std::vector<ConstRequestPtr> requests) const -> Session
+{
+  return Session::Implementation::make(
+    *_pimpl, std::move(agents), std::move(requests));
+}
+
 // ============================================================================
 const rmf_task::TaskPlanner::Configuration& TaskPlanner::configuration()
 const
@@ -1184,6 +6625,37 @@ const
   return _pimpl->config;
 }
 
+// ============================================================================
+TaskPlanner& TaskPlanner::configuration(Configuration configuration)
+{
+  auto& impl = *_pimpl;
+  if (!impl.keeps_travel_estimator(configuration))
+  {
+    impl.travel_estimator =
+      Implementation::make_travel_estimator(configuration);
+  }
+
+  if (!Implementation::same_models(
+      impl.config.parameters(), configuration.parameters()))
+  {
+    impl.model_cache = std::make_shared<ModelCache>();
+    impl.charging_model =
+      rmf_task::requests::ChargeBattery::Description::make()->make_model(
+      rmf_traffic::Time(), configuration.parameters());
+  }
+
+  impl.result_cache = configuration.result_cache_size() > 0 ?
+    std::make_shared<ResultCache>(configuration.result_cache_size()) : nullptr;
+  impl.config = std::move(configuration);
+  return *this;
+}
+
+// ============================================================================
+auto TaskPlanner::travel_estimator() const -> const ConstTravelEstimatorPtr&
+{
+  return _pimpl->travel_estimator;
+}
+
 // ============================================================================
 auto TaskPlanner::default_options() const -> const Options&
 {
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "ThreadPool.hpp"
+
+#include <rmf_task/AllocationCounter.hpp>
+
+#include <algorithm>
+
+namespace rmf_task {
+
+//==============================================================================
+ThreadPool::ThreadPool(ExecutorPtr executor, std::size_t num_threads)
+: _executor(std::move(executor)),
+  _num_threads(std::max<std::size_t>(1, num_threads))
+{
+  // Do nothing
+}
+
+//==============================================================================
+std::size_t ThreadPool::size() const
+{
+  return _num_threads;
+}
+
+//==============================================================================
+void ThreadPool::parallel_for(
+  std::size_t count,
+  const std::function<void(std::size_t)>& job)
+{
+  // The helpers count their allocations towards the subsystem of the caller
+  const auto subsystem = AllocationCounter::current();
+  _executor->parallel_for(
+    count,
+    [&job, subsystem](std::size_t i)
+    {
+      const AllocationCounter::Scope scope(subsystem);
+      job(i);
+    },
+    _num_threads);
+}
+
+} // namespace rmf_task
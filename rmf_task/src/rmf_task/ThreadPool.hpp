@@ -0,0 +1,52 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__THREADPOOL_HPP
+#define SRC__RMF_TASK__THREADPOOL_HPP
+
+#include <rmf_task/Executor.hpp>
+
+namespace rmf_task {
+
+//==============================================================================
+// A limit on how many threads of an Executor may run one batch of independent
+// jobs at a time. The thread that calls parallel_for() participates in running
+// the batch, so a pool of size N posts N-1 helpers to the executor.
+class ThreadPool
+{
+public:
+
+  ThreadPool(ExecutorPtr executor, std::size_t num_threads);
+
+  // The total number of threads that run jobs, including the calling thread
+  std::size_t size() const;
+
+  // Run job(i) for each i in [0, count). Each index is visited at most once.
+  // This blocks until every job is finished. If any job throws, the first
+  // exception that was caught is rethrown here after the batch finishes.
+  void parallel_for(
+    std::size_t count,
+    const std::function<void(std::size_t)>& job);
+
+private:
+  ExecutorPtr _executor;
+  std::size_t _num_threads;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__THREADPOOL_HPP
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK__TRACESPAN_HPP
+#define SRC__RMF_TASK__TRACESPAN_HPP
+
+#include <rmf_task/TraceSink.hpp>
+
+namespace rmf_task {
+
+//==============================================================================
+// Reports the section of work that it lives for to a TraceSink. Without a
+// sink, this costs one branch when it is created and one when it is destroyed.
+class TraceSpan
+{
+public:
+
+  TraceSpan(TraceSink* sink, const char* name)
+  : _sink(sink),
+    _name(name)
+  {
+    if (_sink)
+      _sink->begin(_name);
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  ~TraceSpan()
+  {
+    if (_sink)
+      _sink->end(_name);
+  }
+
+private:
+  TraceSink* _sink;
+  const char* _name;
+};
+
+} // namespace rmf_task
+
+#endif // SRC__RMF_TASK__TRACESPAN_HPP
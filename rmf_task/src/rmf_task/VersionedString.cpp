@@ -17,17 +17,97 @@
 
 #include <rmf_task/VersionedString.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string_view>
 #include <unordered_map>
 
 namespace rmf_task {
 
+namespace {
+//==============================================================================
+// A pool of the initial values of versioned strings, so that the many events
+// which are given the same name or detail will share one copy of it. The pool
+// only holds weak references, and each string removes itself from the pool
+// when the last versioned string that uses it lets go of it.
+class InternedStrings
+{
+public:
+
+  using ValuePtr = std::shared_ptr<const std::string>;
+
+  static InternedStrings& get()
+  {
+    // This is never destroyed, so that strings which outlive the other static
+    // objects of the program can still remove themselves from it
+    static InternedStrings* const pool = new InternedStrings;
+    return *pool;
+  }
+
+  ValuePtr intern(std::string value)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _strings.find(value);
+    if (it != _strings.end())
+    {
+      if (auto existing = it->second.lock())
+        return existing;
+
+      // The last user of this string is letting go of it right now, so we
+      // will replace it with a fresh copy
+      _strings.erase(it);
+    }
+
+    ValuePtr interned(
+      new std::string(std::move(value)),
+      [this](const std::string* s) { release(s); });
+
+    _strings.insert({*interned, interned});
+    return interned;
+  }
+
+private:
+
+  void release(const std::string* s)
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      const auto it = _strings.find(*s);
+
+      // The entry may already belong to a fresh copy of the same text
+      if (it != _strings.end() && it->first.data() == s->data())
+        _strings.erase(it);
+    }
+
+    delete s;
+  }
+
+  std::mutex _mutex;
+
+  // The keys view the strings that the values point to
+  std::unordered_map<std::string_view, std::weak_ptr<const std::string>>
+  _strings;
+};
+
+//==============================================================================
+// Every versioned string and every new version of one gets a number that has
+// never been used before, so a reader only needs to remember the last number
+// it saw for each versioned string to know whether the value has changed.
+uint64_t next_version()
+{
+  static std::atomic_uint64_t counter = 0;
+  return counter.fetch_add(1, std::memory_order_relaxed);
+}
+} // anonymous namespace
+
 //==============================================================================
 class VersionedString::Implementation
 {
 public:
 
   Implementation(std::string initial_value)
-  : value(std::make_shared<std::string>(std::move(initial_value)))
+  : value(InternedStrings::get().intern(std::move(initial_value)))
   {
     // Do nothing
   }
@@ -35,10 +115,9 @@ public:
   using ValuePtr = std::shared_ptr<const std::string>;
   ValuePtr value;
 
-  // The token is used to uniquely identify this VersionedString.
-  struct Token {};
-  using TokenPtr = std::shared_ptr<const Token>;
-  TokenPtr token = std::make_shared<Token>();
+  // The first version number of a versioned string also identifies it
+  uint64_t id = next_version();
+  uint64_t version = id;
 
   View make_view() const;
 };
@@ -49,15 +128,15 @@ class VersionedString::View::Implementation
 public:
 
   using ValuePtr = VersionedString::Implementation::ValuePtr;
-  using TokenPtr = VersionedString::Implementation::TokenPtr;
 
-  static View make(ValuePtr value, TokenPtr token)
+  static View make(ValuePtr value, uint64_t id, uint64_t version)
   {
     View output;
     output._pimpl = rmf_utils::make_impl<Implementation>(
       Implementation{
         std::move(value),
-        std::move(token)
+        id,
+        version
       });
 
     return output;
@@ -69,7 +148,8 @@ public:
   }
 
   ValuePtr value;
-  TokenPtr token;
+  uint64_t id;
+  uint64_t version;
 
 };
 
@@ -79,55 +159,67 @@ class VersionedString::Reader::Implementation
 public:
 
   using ValuePtr = VersionedString::Implementation::ValuePtr;
-  using WeakValuePtr = ValuePtr::weak_type;
 
-  using Token = VersionedString::Implementation::Token;
-  using TokenPtr = VersionedString::Implementation::TokenPtr;
-  using WeakTokenPtr = TokenPtr::weak_type;
+  // The memories are swept for forgotten strings whenever there are at least
+  // this many of them, and at least twice as many as the last sweep left
+  static constexpr std::size_t MinSweepSize = 256;
 
   struct Memory
   {
-    WeakValuePtr last_value;
-    WeakTokenPtr token;
+    uint64_t version;
 
-    Memory()
-    {
-      // Do nothing
-    }
+    // The value of that version. Once nothing holds it anymore, neither the
+    // versioned string nor any View can give this version to the reader
+    // again, so the memory can be forgotten without ever reading a duplicate.
+    std::weak_ptr<const std::string> value;
   };
 
-  std::unordered_map<const Token*, Memory> memories;
+  // The last version that was read of each versioned string
+  std::unordered_map<uint64_t, Memory> memories;
+  std::size_t sweep_size = MinSweepSize;
 
   ValuePtr read(const View& view)
   {
     const auto& v = View::Implementation::get(view);
-    const auto it = memories.insert({v.token.get(), Memory()}).first;
-    auto& memory = it->second;
-    if (memory.token.lock())
+    const auto inserted = memories.insert({v.id, Memory{v.version, v.value}});
+    if (!inserted.second)
     {
-      // If we can successfully lock the memory token, then we do remember this
-      // same versioned string.
-      if (const auto last_value = memory.last_value.lock())
-      {
-        if (last_value == v.value)
-        {
-          // If our memory of the last_value is still valid and matches with the
-          // value that we are receiving now, then this value is a duplicate.
-          return nullptr;
-        }
-      }
+      // Version numbers are never reused, so if this matches what we read
+      // last time, then this value is a duplicate. This check does not need
+      // to touch the value itself.
+      if (inserted.first->second.version == v.version)
+        return nullptr;
+
+      inserted.first->second = Memory{v.version, v.value};
+    }
+    else if (memories.size() >= sweep_size)
+    {
+      sweep();
     }
 
-    memory.token = v.token;
-    memory.last_value = v.value;
     return v.value;
   }
+
+  // Forget the strings that can no longer be read, so that a reader which
+  // sees many short-lived strings does not keep growing
+  void sweep()
+  {
+    for (auto it = memories.begin(); it != memories.end(); )
+    {
+      if (it->second.value.expired())
+        it = memories.erase(it);
+      else
+        ++it;
+    }
+
+    sweep_size = std::max(MinSweepSize, 2 * memories.size());
+  }
 };
 
 //==============================================================================
 auto VersionedString::Implementation::make_view() const -> View
 {
-  return VersionedString::View::Implementation::make(value, token);
+  return VersionedString::View::Implementation::make(value, id, version);
 }
 
 //==============================================================================
@@ -141,6 +233,7 @@ VersionedString::VersionedString(std::string initial_value)
 void VersionedString::update(std::string new_value)
 {
   _pimpl->value = std::make_shared<std::string>(std::move(new_value));
+  _pimpl->version = next_version();
 }
 
 //==============================================================================
@@ -17,6 +17,8 @@
 
 #include <rmf_task/detail/Backup.hpp>
 
+#include <nlohmann/json.hpp>
+
 namespace rmf_task {
 namespace detail {
 
@@ -26,6 +28,7 @@ class Backup::Implementation
 public:
   uint64_t sequence;
   std::string state;
+  std::optional<uint64_t> base_sequence = std::nullopt;
 };
 
 //==============================================================================
@@ -38,6 +41,26 @@ Backup Backup::make(uint64_t seq, std::string state)
   return output;
 }
 
+//==============================================================================
+Backup Backup::make_delta(uint64_t seq, uint64_t base_seq, std::string patch)
+{
+  Backup output;
+  output._pimpl = rmf_utils::make_impl<Implementation>(
+    Implementation{seq, std::move(patch), base_seq});
+
+  return output;
+}
+
+//==============================================================================
+std::string Backup::apply_delta(
+  const std::string& base_state,
+  const std::string& patch)
+{
+  return nlohmann::json::parse(base_state)
+    .patch(nlohmann::json::parse(patch))
+    .dump();
+}
+
 //==============================================================================
 uint64_t Backup::sequence() const
 {
@@ -64,6 +87,12 @@ Backup& Backup::state(std::string new_state)
   return *this;
 }
 
+//==============================================================================
+std::optional<uint64_t> Backup::base_sequence() const
+{
+  return _pimpl->base_sequence;
+}
+
 //==============================================================================
 Backup::Backup()
 {
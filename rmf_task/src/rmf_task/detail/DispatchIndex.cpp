@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/detail/DispatchIndex.hpp>
+
+#include <mutex>
+#include <unordered_map>
+
+namespace rmf_task {
+namespace detail {
+
+//==============================================================================
+std::size_t DispatchIndex::of(std::type_index type)
+{
+  static std::mutex mutex;
+  static std::unordered_map<std::type_index, std::size_t> indices;
+
+  std::lock_guard lock(mutex);
+  return indices.insert({type, indices.size()}).first->second;
+}
+
+//==============================================================================
+DispatchIndex::Cache::Cache(const Cache&)
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto DispatchIndex::Cache::operator=(const Cache&) -> Cache&
+{
+  return *this;
+}
+
+//==============================================================================
+std::size_t DispatchIndex::Cache::get(const std::type_info& dynamic_type) const
+{
+  const auto value = _value.load(std::memory_order_relaxed);
+  if (value > 0)
+    return value - 1;
+
+  const auto index = DispatchIndex::of(dynamic_type);
+  _value.store(index + 1, std::memory_order_relaxed);
+  return index;
+}
+
+} // namespace detail
+} // namespace rmf_task
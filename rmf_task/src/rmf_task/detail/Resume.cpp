@@ -41,12 +41,8 @@ Resume::Resume()
 //==============================================================================
 void Resume::Implementation::trigger() const
 {
-  std::lock_guard<std::recursive_mutex> lock(mutex);
-  if (!called)
-  {
-    called = true;
+  if (!called.exchange(true, std::memory_order_acq_rel))
     callback();
-  }
 }
 
 //==============================================================================
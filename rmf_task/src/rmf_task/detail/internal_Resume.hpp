@@ -21,8 +21,8 @@
 
 #include <rmf_task/detail/Resume.hpp>
 
+#include <atomic>
 #include <functional>
-#include <mutex>
 
 namespace rmf_task {
 namespace detail {
@@ -34,13 +34,13 @@ public:
 
   std::function<void()> callback;
 
-  // We use a recursive mutex in case triggering the callback leads to a chain
-  // that causes the Resume object to be triggered again or destroyed. We have
-  // no way to prevent such a behavior from the implementation here, but we can
-  // at least ensure that it does not cause a deadlock or an infinitely
-  // recursive loop.
-  mutable std::recursive_mutex mutex;
-  mutable bool called = false;
+  // Only the first trigger gets to run the callback. Triggering the callback
+  // may lead to a chain that triggers this Resume object again or destroys
+  // it. We have no way to prevent such a behavior from the implementation
+  // here, but claiming the flag before the callback runs ensures that it does
+  // not cause an infinitely recursive loop, and no lock is held that could
+  // deadlock.
+  mutable std::atomic_bool called = false;
 
   void trigger() const;
 
@@ -17,6 +17,8 @@
 
 #include <rmf_task/events/SimpleEventState.hpp>
 
+#include <algorithm>
+
 namespace rmf_task {
 namespace events {
 
@@ -32,6 +34,12 @@ public:
   Log log;
   std::vector<Event::ConstStatePtr> dependencies;
 
+  // The version of the last change to the fields above. Entries are added to
+  // the log without going through this class, so new ones are noticed by
+  // comparing the number of entries when the version is checked.
+  mutable uint64_t version;
+  mutable uint64_t log_entries = 0;
+
 };
 
 //==============================================================================
@@ -41,7 +49,8 @@ std::shared_ptr<SimpleEventState> SimpleEventState::make(
   std::string detail,
   Event::Status initial_status,
   std::vector<Event::ConstStatePtr> dependencies,
-  std::function<rmf_traffic::Time()> clock)
+  std::function<rmf_traffic::Time()> clock,
+  std::pmr::memory_resource* memory)
 {
   SimpleEventState output;
   output._pimpl = rmf_utils::make_unique_impl<Implementation>(
@@ -50,10 +59,18 @@ std::shared_ptr<SimpleEventState> SimpleEventState::make(
       initial_status,
       std::move(name),
       std::move(detail),
-      Log(std::move(clock)),
-      std::move(dependencies)
+      Log(std::move(clock), memory),
+      std::move(dependencies),
+      new_version()
     });
 
+  if (memory)
+  {
+    return std::allocate_shared<SimpleEventState>(
+      std::pmr::polymorphic_allocator<SimpleEventState>(memory),
+      std::move(output));
+  }
+
   return std::make_shared<SimpleEventState>(std::move(output));
 }
 
@@ -67,6 +84,7 @@ uint64_t SimpleEventState::id() const
 SimpleEventState& SimpleEventState::modify_id(uint64_t new_id)
 {
   _pimpl->id = new_id;
+  _pimpl->version = new_version();
   return *this;
 }
 
@@ -79,7 +97,12 @@ Event::Status SimpleEventState::status() const
 //==============================================================================
 SimpleEventState& SimpleEventState::update_status(Event::Status new_status)
 {
-  _pimpl->status = new_status;
+  if (_pimpl->status != new_status)
+  {
+    _pimpl->status = new_status;
+    _pimpl->version = new_version();
+  }
+
   return *this;
 }
 
@@ -93,6 +116,7 @@ VersionedString::View SimpleEventState::name() const
 SimpleEventState& SimpleEventState::update_name(std::string new_name)
 {
   _pimpl->name.update(std::move(new_name));
+  _pimpl->version = new_version();
   return *this;
 }
 
@@ -106,6 +130,7 @@ VersionedString::View SimpleEventState::detail() const
 SimpleEventState& SimpleEventState::update_detail(std::string new_detail)
 {
   _pimpl->detail.update(std::move(new_detail));
+  _pimpl->version = new_version();
   return *this;
 }
 
@@ -127,21 +152,49 @@ std::vector<Event::ConstStatePtr> SimpleEventState::dependencies() const
   return _pimpl->dependencies;
 }
 
+//==============================================================================
+auto SimpleEventState::current_dependencies() const
+-> const std::vector<ConstStatePtr>&
+{
+  return _pimpl->dependencies;
+}
+
 //==============================================================================
 SimpleEventState& SimpleEventState::update_dependencies(
   std::vector<ConstStatePtr> new_dependencies)
 {
-  _pimpl->dependencies = new_dependencies;
+  _pimpl->dependencies = std::move(new_dependencies);
+  _pimpl->version = new_version();
   return *this;
 }
 
 //==============================================================================
 SimpleEventState& SimpleEventState::add_dependency(ConstStatePtr new_dependency)
 {
-  _pimpl->dependencies.push_back(new_dependency);
+  _pimpl->dependencies.push_back(std::move(new_dependency));
+  _pimpl->version = new_version();
   return *this;
 }
 
+//==============================================================================
+uint64_t SimpleEventState::version() const
+{
+  const uint64_t log_entries = _pimpl->log.entry_count();
+  if (log_entries != _pimpl->log_entries)
+  {
+    _pimpl->log_entries = log_entries;
+    _pimpl->version = new_version();
+  }
+
+  // Every version comes from the same counter, so the newest change anywhere
+  // in the tree below this state has the greatest version
+  uint64_t version = _pimpl->version;
+  for (const auto& dependency : _pimpl->dependencies)
+    version = std::max(version, dependency->version());
+
+  return version;
+}
+
 //==============================================================================
 SimpleEventState::SimpleEventState()
 {
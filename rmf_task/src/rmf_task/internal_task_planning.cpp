@@ -21,23 +21,45 @@
 namespace rmf_task {
 
 // ============================================================================
-void Candidates::update_map()
+Candidates::Candidates(Candidates::Slots slots)
+: _slots(std::move(slots))
 {
-  for (auto it = _value_map.begin(); it != _value_map.end(); ++it)
-  {
-    const auto c = it->second.candidate;
-    if (_candidate_map.size() <= c)
-      _candidate_map.resize(c+1);
+  std::stable_sort(
+    _slots.begin(), _slots.end(),
+    [](const Slot& a, const Slot& b)
+    {
+      return a.finish_time < b.finish_time;
+    });
 
-    _candidate_map[c] = it;
-  }
+  _update_best();
+}
+
+// ============================================================================
+void Candidates::_reorder(std::size_t position)
+{
+  Slot slot = std::move(_slots[position]);
+  _slots.erase(_slots.begin() + position);
+
+  const auto it = std::upper_bound(
+    _slots.begin(), _slots.end(), slot.finish_time,
+    [](const rmf_traffic::Time t, const Slot& s)
+    {
+      return t < s.finish_time;
+    });
+
+  _slots.insert(it, std::move(slot));
+  _update_best();
 }
 
 // ============================================================================
-Candidates::Candidates(Candidates::Map candidate_values)
-: _value_map(std::move(candidate_values))
+void Candidates::_update_best()
 {
-  update_map();
+  _num_best = 0;
+  while (_num_best < _slots.size()
+    && _slots[_num_best].finish_time == _slots.front().finish_time)
+  {
+    ++_num_best;
+  }
 }
 
 // ============================================================================
@@ -46,58 +68,178 @@ void Candidates::update_candidate(
   State state,
   rmf_traffic::Time wait_until,
   State previous_state,
-  bool require_charge_battery)
+  bool require_charge_battery,
+  std::optional<Estimate> charge_battery)
 {
-  const auto it = _candidate_map.at(candidate);
-  _value_map.erase(it);
-  _candidate_map[candidate] =
-    _value_map.insert(
-    {
-      state.time().value(),
+  replace_candidate(
+    candidate,
+    std::make_shared<Entry>(
       Entry{
         candidate,
-        state,
+        std::move(state),
         wait_until,
-        previous_state,
-        require_charge_battery}
-    });
+        std::move(previous_state),
+        require_charge_battery,
+        std::move(charge_battery)
+      }));
 }
 
 // ============================================================================
-rmf_traffic::Time Candidates::best_finish_time() const
+void Candidates::replace_candidate(
+  std::size_t candidate,
+  std::shared_ptr<const Entry> entry)
 {
-  assert(!_value_map.empty());
-  return _value_map.begin()->first;
+  // The candidate might not have an entry yet
+  std::size_t position = 0;
+  while (position < _slots.size() && _slots[position].candidate != candidate)
+    ++position;
+
+  if (!entry)
+  {
+    if (position < _slots.size())
+    {
+      _slots.erase(_slots.begin() + position);
+      _update_best();
+    }
+
+    return;
+  }
+
+  const auto finish_time = entry->state.time().value();
+  const auto wait_until = entry->wait_until;
+  if (position == _slots.size())
+    _slots.push_back(Slot{finish_time, wait_until, candidate, nullptr});
+
+  auto& slot = _slots[position];
+  slot.finish_time = finish_time;
+  slot.wait_until = wait_until;
+  slot.entry = std::move(entry);
+  _reorder(position);
 }
 
 // ============================================================================
-Candidates::Range Candidates::best_candidates() const
+bool Candidates::empty() const
 {
-  assert(!_value_map.empty());
+  return _slots.empty();
+}
 
-  Range range;
-  range.begin = _value_map.begin();
-  auto it = range.begin;
-  while (it->first == range.begin->first)
-    ++it;
+// ============================================================================
+rmf_traffic::Time Candidates::best_finish_time() const
+{
+  assert(!_slots.empty());
+  return _slots.front().finish_time;
+}
 
-  range.end = it;
-  return range;
+// ============================================================================
+Candidates::Range Candidates::best_candidates() const
+{
+  assert(!_slots.empty());
+  return Range{_slots.begin(), _slots.begin() + _num_best};
 }
 
 // ============================================================================
-Candidates& Candidates::operator=(const Candidates& other)
+Candidates::Range Candidates::all_candidates() const
 {
-  _value_map = other._value_map;
-  update_map();
-  return *this;
+  return Range{_slots.begin(), _slots.end()};
 }
 
 // ============================================================================
-Candidates::Candidates(const Candidates& other)
+std::shared_ptr<const Candidates::Entry> Candidates::estimate(
+  std::size_t candidate,
+  const rmf_traffic::Time start_time,
+  const State& state,
+  const Constraints& constraints,
+  const Parameters& parameters,
+  const Task::Model& task_model,
+  const TravelEstimator& travel_estimator,
+  const std::string& planner_id,
+  TaskPlanner::TaskPlannerError& error,
+  std::atomic_size_t* finish_estimates,
+  const Task::Model* charging_model,
+  EstimateProfiler* profiler)
 {
-  _value_map = other._value_map;
-  update_map();
+  const auto count_estimate = [finish_estimates]()
+    {
+      if (finish_estimates)
+        finish_estimates->fetch_add(1, std::memory_order_relaxed);
+    };
+
+  count_estimate();
+  auto finish = EstimateProfiler::time(profiler, task_model,
+      [&]()
+      {
+        return task_model.estimate_finish(
+          state, constraints, travel_estimator);
+      });
+  if (finish.has_value())
+  {
+    return std::make_shared<Entry>(
+      Entry{
+        candidate,
+        std::move(*finish).finish_state(),
+        finish.value().wait_until(),
+        state,
+        false});
+  }
+
+  Task::ConstModelPtr battery_model;
+  if (!charging_model)
+  {
+    auto charge_battery = requests::ChargeBattery::make(
+      start_time,
+      planner_id,
+      start_time,
+      nullptr,
+      true);
+    battery_model = charge_battery->description()->make_model(
+      start_time,
+      parameters);
+    charging_model = battery_model.get();
+  }
+
+  count_estimate();
+  auto battery_estimate = EstimateProfiler::time(profiler, *charging_model,
+      [&]()
+      {
+        return charging_model->estimate_finish(
+          state, constraints, travel_estimator);
+      });
+  if (battery_estimate.has_value())
+  {
+    count_estimate();
+    auto new_finish = EstimateProfiler::time(profiler, task_model,
+        [&]()
+        {
+          return task_model.estimate_finish(
+            battery_estimate.value().finish_state(),
+            constraints,
+            travel_estimator);
+        });
+    if (new_finish.has_value())
+    {
+      return std::make_shared<Entry>(
+        Entry{
+          candidate,
+          std::move(*new_finish).finish_state(),
+          new_finish.value().wait_until(),
+          state,
+          true,
+          std::move(battery_estimate)});
+    }
+
+    error = TaskPlanner::TaskPlannerError::limited_capacity;
+    return nullptr;
+  }
+
+  // Control reaches here either if estimate_finish() was
+  // called on initial state with full battery or low battery such that
+  // agent is unable to make it back to the charger
+  if (state.battery_soc() >= constraints.recharge_soc() - 1e-3)
+    error = TaskPlanner::TaskPlannerError::limited_capacity;
+  else
+    error = TaskPlanner::TaskPlannerError::low_battery;
+
+  return nullptr;
 }
 
 // ============================================================================
@@ -109,85 +251,76 @@ std::shared_ptr<Candidates> Candidates::make(
   const Task::Model& task_model,
   const TravelEstimator& travel_estimator,
   const std::string& planner_id,
-  TaskPlanner::TaskPlannerError& error)
+  TaskPlanner::TaskPlannerError& error,
+  std::atomic_size_t* finish_estimates,
+  const Task::Model* charging_model,
+  EstimateProfiler* profiler)
 {
-  Map initial_map;
+  Slots initial_slots;
+  initial_slots.reserve(initial_states.size());
   for (std::size_t i = 0; i < initial_states.size(); ++i)
   {
-    const auto& state = initial_states[i];
-    const auto finish = task_model.estimate_finish(
-      state, constraints, travel_estimator);
-    if (finish.has_value())
+    auto entry = estimate(i, start_time, initial_states[i], constraints,
+        parameters, task_model, travel_estimator, planner_id, error,
+        finish_estimates, charging_model, profiler);
+    if (entry)
     {
-      initial_map.insert({
-          finish.value().finish_state().time().value(),
-          Entry{
-            i,
-            finish.value().finish_state(),
-            finish.value().wait_until(),
-            state,
-            false}});
-    }
-    else
-    {
-      auto charge_battery = requests::ChargeBattery::make(
-        start_time,
-        planner_id,
-        start_time,
-        nullptr,
-        true);
-      const auto battery_model = charge_battery->description()->make_model(
-        start_time,
-        parameters);
-      auto battery_estimate =
-        battery_model->estimate_finish(
-        state, constraints, travel_estimator);
-      if (battery_estimate.has_value())
-      {
-        auto new_finish = task_model.estimate_finish(
-          battery_estimate.value().finish_state(),
-          constraints,
-          travel_estimator);
-        if (new_finish.has_value())
-        {
-          initial_map.insert(
-            {new_finish.value().finish_state().time().value(),
-              Entry{
-                i,
-                new_finish.value().finish_state(),
-                new_finish.value().wait_until(),
-                state,
-                true}});
-        }
-        else
-        {
-          error = TaskPlanner::TaskPlannerError::limited_capacity;
-        }
-
-      }
-      else
-      {
-        // Control reaches here either if estimate_finish() was
-        // called on initial state with full battery or low battery such that
-        // agent is unable to make it back to the charger
-        if (state.battery_soc() >= constraints.recharge_soc() - 1e-3)
-          error = TaskPlanner::TaskPlannerError::limited_capacity;
-        else
-          error = TaskPlanner::TaskPlannerError::low_battery;
-      }
+      const auto finish_time = entry->state.time().value();
+      const auto wait_until = entry->wait_until;
+      initial_slots.push_back(
+        Slot{finish_time, wait_until, i, std::move(entry)});
     }
   }
 
-  if (initial_map.empty())
+  if (initial_slots.empty())
   {
     return nullptr;
   }
 
   std::shared_ptr<Candidates> candidates(
-    new Candidates(std::move(initial_map)));
+    new Candidates(std::move(initial_slots)));
   return candidates;
 }
 
+// ============================================================================
+NodeArena::NodeArena(
+  bool concurrent,
+  std::size_t reserve,
+  std::pmr::memory_resource* upstream)
+: _reserved(upstream ? upstream : std::pmr::get_default_resource())
+{
+  upstream = _reserved.get_allocator().resource();
+  if (reserve > 0)
+  {
+    // The bytes are zeroed, which touches every page right here
+    _reserved.resize(reserve);
+    _buffer.emplace(_reserved.data(), reserve, upstream);
+  }
+  else
+  {
+    _buffer.emplace(upstream);
+  }
+
+  if (concurrent)
+    _pool = std::make_unique<std::pmr::synchronized_pool_resource>(&*_buffer);
+  else
+    _pool = std::make_unique<std::pmr::unsynchronized_pool_resource>(&*_buffer);
+}
+
+// ============================================================================
+NodePtr NodeArena::make_node()
+{
+  const Node::Allocator allocator(_pool.get());
+  return std::allocate_shared<Node>(allocator, allocator);
+}
+
+// ============================================================================
+NodePtr NodeArena::make_node(const Node& parent)
+{
+  const Node::Allocator allocator(_pool.get());
+  return std::allocate_shared<Node>(allocator, parent, allocator);
+}
+
 // ============================================================================
 PendingTask::PendingTask(ConstRequestPtr request_,
   Task::ConstModelPtr model_,
@@ -199,6 +332,352 @@ PendingTask::PendingTask(ConstRequestPtr request_,
 
 }
 
+// ============================================================================
+Task::ConstModelPtr ModelCache::get(
+  const ConstRequestPtr& request,
+  const rmf_traffic::Time earliest_start_time,
+  const Parameters& parameters)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const auto it = _entries.find(request.get());
+    if (it != _entries.end()
+      && it->second.earliest_start_time == earliest_start_time
+      && it->second.request.lock() == request)
+    {
+      return it->second.model;
+    }
+  }
+
+  // The model is made without holding the lock since it may be expensive
+  auto model = request->description()->make_model(
+    earliest_start_time, parameters);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  _entries[request.get()] = Entry{request, earliest_start_time, model};
+  return model;
+}
+
+// ============================================================================
+void ModelCache::prune()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto it = _entries.begin(); it != _entries.end(); )
+  {
+    if (it->second.request.expired())
+      it = _entries.erase(it);
+    else
+      ++it;
+  }
+}
+
+// ============================================================================
+std::size_t ModelCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+// ============================================================================
+Task::Model::ConstKernelPtr KernelCache::get(
+  const Task::Model& model,
+  const State& initial_state,
+  const Constraints& constraints,
+  const TravelEstimator& travel_estimator,
+  std::atomic_size_t* reuses)
+{
+  const auto waypoint = initial_state.waypoint();
+  const auto orientation = initial_state.orientation();
+  const auto charging_waypoint = initial_state.dedicated_charging_waypoint();
+  const auto battery_soc = initial_state.battery_soc();
+  if (!waypoint.has_value() || !orientation.has_value()
+    || !charging_waypoint.has_value() || !battery_soc.has_value()
+    || !initial_state.time().has_value())
+    return nullptr;
+
+  const Key key{
+    &model, *waypoint, *orientation, *charging_waypoint, *battery_soc};
+  auto& shard = _shards[Hash()(key) % NumShards];
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const auto it = shard.kernels.find(key);
+    if (it != shard.kernels.end())
+    {
+      if (reuses && it->second)
+        reuses->fetch_add(1, std::memory_order_relaxed);
+
+      return it->second;
+    }
+  }
+
+  // The kernel is made without holding the lock since it estimates travel
+  auto kernel = model.make_kernel(
+    initial_state, constraints, travel_estimator);
+
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  return shard.kernels.emplace(key, std::move(kernel)).first->second;
+}
+
+// ============================================================================
+std::size_t KernelCache::size() const
+{
+  std::size_t total = 0;
+  for (const auto& shard : _shards)
+  {
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    total += shard.kernels.size();
+  }
+
+  return total;
+}
+
+// ============================================================================
+bool KernelCache::Key::operator==(const Key& other) const
+{
+  return model == other.model
+    && waypoint == other.waypoint
+    && orientation == other.orientation
+    && charging_waypoint == other.charging_waypoint
+    && battery_soc == other.battery_soc;
+}
+
+// ============================================================================
+std::size_t KernelCache::Hash::operator()(const Key& key) const
+{
+  std::size_t seed = std::hash<const Task::Model*>()(key.model);
+  const auto combine = [&seed](std::size_t value)
+    {
+      seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    };
+
+  combine(key.waypoint);
+  combine(std::hash<double>()(key.orientation));
+  combine(key.charging_waypoint);
+  combine(std::hash<double>()(key.battery_soc));
+  return seed;
+}
+
+// ============================================================================
+bool ResultCache::Agent::operator==(const Agent& other) const
+{
+  return waypoint == other.waypoint
+    && orientation == other.orientation
+    && time == other.time
+    && charging_waypoint == other.charging_waypoint
+    && battery_soc == other.battery_soc
+    && payload_capacity == other.payload_capacity;
+}
+
+// ============================================================================
+bool ResultCache::Key::operator==(const Key& other) const
+{
+  return time_now == other.time_now
+    && agents == other.agents
+    && requests == other.requests
+    && greedy == other.greedy
+    && finishing_request == other.finishing_request
+    && search_threads == other.search_threads
+    && deterministic_seed == other.deterministic_seed
+    && local_search_budget == other.local_search_budget
+    && max_open_nodes == other.max_open_nodes
+    && anytime == other.anytime
+    && horizon == other.horizon
+    && commit_window == other.commit_window
+    && delivery_pooling_window == other.delivery_pooling_window
+    && break_agent_symmetry == other.break_agent_symmetry
+    && agent_symmetry_soc_tolerance == other.agent_symmetry_soc_tolerance
+    && agent_symmetry_time_tolerance == other.agent_symmetry_time_tolerance
+    && break_request_symmetry == other.break_request_symmetry
+    && prune_dominated_nodes == other.prune_dominated_nodes
+    && partial_charging_margin == other.partial_charging_margin
+    && opportunistic_charging_detour == other.opportunistic_charging_detour
+    && greedy_by_finish_time == other.greedy_by_finish_time
+    && greedy_restarts == other.greedy_restarts
+    && greedy_restart_alpha == other.greedy_restart_alpha
+    && neighborhood_search_budget == other.neighborhood_search_budget
+    && neighborhood_size == other.neighborhood_size
+    && parallel_neighborhoods == other.parallel_neighborhoods
+    && congestion == other.congestion
+    && calibration == other.calibration
+    && calibration_version == other.calibration_version
+    && travel_generation == other.travel_generation;
+}
+
+// ============================================================================
+auto ResultCache::make_key(
+  const rmf_traffic::Time time_now,
+  const std::vector<State>& agents,
+  const std::vector<ConstRequestPtr>& requests,
+  const TaskPlanner::Options& options,
+  const TravelEstimator& travel_estimator) -> std::optional<Key>
+{
+  // A search that is cut short by the clock may find a different result each
+  // time, an improvement callback expects to hear about every search, and a
+  // profiled search should measure its own estimates
+  if (options.deadline().has_value() || options.time_budget().has_value()
+    || options.improvement_callback() || options.profile_estimates())
+    return std::nullopt;
+
+  Key key{
+    time_now,
+    {},
+    {},
+    options.greedy(),
+    options.finishing_request().get(),
+    options.search_threads(),
+    options.deterministic_seed(),
+    options.local_search_budget(),
+    options.max_open_nodes(),
+    options.anytime(),
+    options.horizon(),
+    options.commit_window(),
+    options.delivery_pooling_window(),
+    options.break_agent_symmetry(),
+    options.agent_symmetry_soc_tolerance(),
+    options.agent_symmetry_time_tolerance(),
+    options.break_request_symmetry(),
+    options.prune_dominated_nodes(),
+    options.partial_charging_margin(),
+    options.opportunistic_charging_detour(),
+    options.greedy_by_finish_time(),
+    options.greedy_restarts(),
+    options.greedy_restart_alpha(),
+    options.neighborhood_search_budget(),
+    options.neighborhood_size(),
+    options.parallel_neighborhoods(),
+    travel_estimator.congestion(),
+    travel_estimator.calibration().get(),
+    travel_estimator.calibration() ?
+    travel_estimator.calibration()->version() : 0,
+    travel_estimator.generation()
+  };
+
+  key.agents.reserve(agents.size());
+  for (const auto& state : agents)
+  {
+    key.agents.push_back(
+      Agent{
+        state.waypoint(),
+        state.orientation(),
+        state.time(),
+        state.dedicated_charging_waypoint(),
+        state.battery_soc(),
+        state.payload_capacity()
+      });
+  }
+
+  key.requests.reserve(requests.size());
+  for (const auto& request : requests)
+    key.requests.push_back(request.get());
+
+  return key;
+}
+
+// ============================================================================
+ResultCache::ResultCache(std::size_t capacity)
+: _capacity(capacity)
+{
+  // Do nothing
+}
+
+// ============================================================================
+auto ResultCache::find(const Key& key)
+-> std::optional<std::pair<TaskPlanner::Result, TaskPlanner::Statistics>>
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto it = _lookup.find(key);
+  if (it == _lookup.end())
+    return std::nullopt;
+
+  const auto entry = it->second;
+  for (const auto& request : entry->requests)
+  {
+    if (request.expired())
+    {
+      _lookup.erase(it);
+      _entries.erase(entry);
+      return std::nullopt;
+    }
+  }
+
+  _entries.splice(_entries.begin(), _entries, entry);
+  return std::make_pair(entry->result, entry->statistics);
+}
+
+// ============================================================================
+void ResultCache::insert(
+  Key key,
+  const std::vector<ConstRequestPtr>& requests,
+  TaskPlanner::Result result,
+  TaskPlanner::Statistics statistics)
+{
+  if (_capacity == 0)
+    return;
+
+  std::vector<std::weak_ptr<const Request>> weak_requests(
+    requests.begin(), requests.end());
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  const auto existing = _lookup.find(key);
+  if (existing != _lookup.end())
+  {
+    _entries.erase(existing->second);
+    _lookup.erase(existing);
+  }
+
+  _entries.push_front(
+    Entry{
+      key,
+      std::move(weak_requests),
+      std::move(result),
+      std::move(statistics)
+    });
+  _lookup.emplace(std::move(key), _entries.begin());
+
+  while (_entries.size() > _capacity)
+  {
+    _lookup.erase(_entries.back().key);
+    _entries.pop_back();
+  }
+}
+
+// ============================================================================
+std::size_t ResultCache::size() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _entries.size();
+}
+
+// ============================================================================
+std::size_t ResultCache::Hash::operator()(const Key& key) const
+{
+  std::size_t seed = 0;
+  const auto combine = [&seed](std::size_t value)
+    {
+      seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+    };
+
+  combine(std::hash<rmf_traffic::Time::rep>()(
+      key.time_now.time_since_epoch().count()));
+
+  for (const auto& agent : key.agents)
+  {
+    combine(agent.waypoint.value_or(std::numeric_limits<std::size_t>::max()));
+    if (agent.time.has_value())
+    {
+      combine(std::hash<rmf_traffic::Time::rep>()(
+          agent.time->time_since_epoch().count()));
+    }
+
+    combine(std::hash<double>()(agent.battery_soc.value_or(-1.0)));
+  }
+
+  for (const auto* request : key.requests)
+    combine(std::hash<const Request*>()(request));
+
+  return seed;
+}
+
 // ============================================================================
 std::shared_ptr<PendingTask> PendingTask::make(
   const rmf_traffic::Time start_time,
@@ -208,16 +687,22 @@ std::shared_ptr<PendingTask> PendingTask::make(
   const ConstRequestPtr request_,
   const TravelEstimator& travel_estimator,
   const std::string& planner_id,
-  TaskPlanner::TaskPlannerError& error)
+  TaskPlanner::TaskPlannerError& error,
+  std::atomic_size_t* finish_estimates,
+  ModelCache* models,
+  const Task::Model* charging_model,
+  EstimateProfiler* profiler)
 {
   const auto earliest_start_time = std::max(
     start_time,
     request_->booking()->earliest_start_time());
-  const auto model = request_->description()->make_model(
-    earliest_start_time, parameters);
+  const auto model = models ?
+    models->get(request_, earliest_start_time, parameters) :
+    request_->description()->make_model(earliest_start_time, parameters);
 
   const auto candidates = Candidates::make(start_time, initial_states,
-      constraints, parameters, *model, travel_estimator, planner_id, error);
+      constraints, parameters, *model, travel_estimator, planner_id, error,
+      finish_estimates, charging_model, profiler);
 
   if (!candidates)
     return nullptr;
@@ -227,4 +712,27 @@ std::shared_ptr<PendingTask> PendingTask::make(
   return pending_task;
 }
 
+// ============================================================================
+bool PendingTask::update_agent(
+  std::size_t agent,
+  const rmf_traffic::Time start_time,
+  const State& state,
+  const Constraints& constraints,
+  const Parameters& parameters,
+  const TravelEstimator& travel_estimator,
+  const std::string& planner_id,
+  TaskPlanner::TaskPlannerError& error,
+  std::atomic_size_t* finish_estimates,
+  const Task::Model* charging_model,
+  EstimateProfiler* profiler)
+{
+  candidates.replace_candidate(
+    agent,
+    Candidates::estimate(agent, start_time, state, constraints, parameters,
+    *model, travel_estimator, planner_id, error, finish_estimates,
+    charging_model, profiler));
+
+  return !candidates.empty();
+}
+
 } // namespace rmf_task
@@ -20,11 +20,25 @@
 
 #include <rmf_task/TaskPlanner.hpp>
 
+#include "EstimateProfiler.hpp"
+
+#include <cassert>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <unordered_map>
 #include <limits>
+#include <list>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace rmf_task {
 
@@ -45,6 +59,112 @@ struct InvariantLess
   }
 };
 
+// ============================================================================
+// The invariants of the unassigned tasks of a node, ordered by their earliest
+// finish time. The ordering is computed once for the initial node and shared
+// by all of its descendants, which only keep track of which invariants are
+// still unassigned. That makes copying the set a copy of one bit per task,
+// and erasing an invariant by its task ID a constant time operation.
+class InvariantSet
+{
+public:
+
+  using Allocator = std::pmr::polymorphic_allocator<std::byte>;
+
+  InvariantSet() = default;
+  InvariantSet(const InvariantSet&) = default;
+  InvariantSet& operator=(const InvariantSet&) = default;
+
+  explicit InvariantSet(Allocator allocator)
+  : _present(allocator)
+  {
+    // Do nothing
+  }
+
+  InvariantSet(const InvariantSet& other, Allocator allocator)
+  : _order(other._order),
+    _present(other._present, allocator),
+    _size(other._size)
+  {
+    // Do nothing
+  }
+
+  // Replace the contents of the set
+  void assign(std::vector<Invariant> invariants)
+  {
+    auto order = std::make_shared<Order>();
+    std::stable_sort(invariants.begin(), invariants.end(), InvariantLess());
+
+    std::size_t max_id = 0;
+    for (const auto& invariant : invariants)
+      max_id = std::max(max_id, invariant.task_id);
+
+    order->position_of_task.resize(
+      invariants.empty() ? 0 : max_id + 1, NoPosition);
+    for (std::size_t i = 0; i < invariants.size(); ++i)
+      order->position_of_task[invariants[i].task_id] = i;
+
+    order->sorted = std::move(invariants);
+    _present.assign(order->sorted.size(), true);
+    _size = order->sorted.size();
+    _order = std::move(order);
+  }
+
+  // Erase the invariant of a task. Returns false if it was not in the set.
+  bool erase(std::size_t task_id)
+  {
+    if (!_order || task_id >= _order->position_of_task.size())
+      return false;
+
+    const std::size_t position = _order->position_of_task[task_id];
+    if (position == NoPosition || !_present[position])
+      return false;
+
+    _present[position] = false;
+    --_size;
+    return true;
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  bool empty() const
+  {
+    return _size == 0;
+  }
+
+  // Visit the invariants in order of their earliest finish time
+  template<typename F>
+  void for_each(F&& f) const
+  {
+    if (!_order)
+      return;
+
+    for (std::size_t i = 0; i < _present.size(); ++i)
+    {
+      if (_present[i])
+        f(_order->sorted[i]);
+    }
+  }
+
+private:
+
+  static constexpr std::size_t NoPosition =
+    std::numeric_limits<std::size_t>::max();
+
+  struct Order
+  {
+    std::vector<Invariant> sorted;
+    std::vector<std::size_t> position_of_task;
+  };
+
+  std::shared_ptr<const Order> _order;
+  std::pmr::vector<bool> _present;
+  std::size_t _size = 0;
+};
+
 // ============================================================================
 class Candidates
 {
@@ -57,17 +177,36 @@ public:
     rmf_traffic::Time wait_until;
     State previous_state;
     bool require_charge_battery = false;
+
+    // The charge that the task is estimated after when require_charge_battery
+    // is true, estimated from previous_state
+    std::optional<Estimate> charge_battery = std::nullopt;
+  };
+
+  // The finish time and wait time of each entry are kept next to its handle
+  // so that the best candidates can be found and filtered without touching
+  // the States. Entries are immutable and shared between the copies of a
+  // Candidates, so copying one does not copy any States.
+  struct Slot
+  {
+    rmf_traffic::Time finish_time;
+    rmf_traffic::Time wait_until;
+    std::size_t candidate;
+    std::shared_ptr<const Entry> entry;
   };
 
-  // Map finish time to Entry
-  using Map = std::multimap<rmf_traffic::Time, Entry>;
+  // Slots are kept in a contiguous vector ordered by finish time. Slots with
+  // equal finish times stay in the order that they were inserted in. The
+  // candidates of a search node draw their slots from the memory of the node.
+  using Slots = std::pmr::vector<Slot>;
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
 
   // We may have more than one best candidate so we store their iterators in
   // a Range
   struct Range
   {
-    Map::const_iterator begin;
-    Map::const_iterator end;
+    Slots::const_iterator begin;
+    Slots::const_iterator end;
   };
 
   static std::shared_ptr<Candidates> make(
@@ -78,15 +217,49 @@ public:
     const Task::Model& task_model,
     const TravelEstimator& travel_estimator,
     const std::string& planner_id,
-    TaskPlanner::TaskPlannerError& error);
+    TaskPlanner::TaskPlannerError& error,
+    std::atomic_size_t* finish_estimates = nullptr,
+    const Task::Model* charging_model = nullptr,
+    EstimateProfiler* profiler = nullptr);
+
+  // Estimate the entry of one candidate that begins from the given state. If
+  // the candidate cannot perform the task, error is set and nullptr is
+  // returned. If finish_estimates is given, it gets incremented for each call
+  // to Task::Model::estimate_finish(). If charging_model is given, it is used
+  // to estimate a charge before the task instead of making a new charging
+  // request and model. If profiler is given, it times each of the calls.
+  static std::shared_ptr<const Entry> estimate(
+    std::size_t candidate,
+    const rmf_traffic::Time start_time,
+    const State& state,
+    const Constraints& constraints,
+    const Parameters& parameters,
+    const Task::Model& task_model,
+    const TravelEstimator& travel_estimator,
+    const std::string& planner_id,
+    TaskPlanner::TaskPlannerError& error,
+    std::atomic_size_t* finish_estimates = nullptr,
+    const Task::Model* charging_model = nullptr,
+    EstimateProfiler* profiler = nullptr);
 
-  Candidates(const Candidates& other);
-  Candidates& operator=(const Candidates& other);
+  Candidates(const Candidates&) = default;
+  Candidates& operator=(const Candidates&) = default;
   Candidates(Candidates&&) = default;
   Candidates& operator=(Candidates&&) = default;
 
+  // Copy the candidates into slots that draw from the given allocator
+  Candidates(const Candidates& other, const allocator_type& allocator)
+  : _slots(other._slots, allocator),
+    _num_best(other._num_best)
+  {
+    // Do nothing
+  }
+
   Range best_candidates() const;
 
+  // Every candidate that is able to perform the task, ordered by finish time
+  Range all_candidates() const;
+
   rmf_traffic::Time best_finish_time() const;
 
   void update_candidate(
@@ -94,16 +267,241 @@ public:
     State state,
     rmf_traffic::Time wait_until,
     State previous_state,
-    bool require_charge_battery);
+    bool require_charge_battery,
+    std::optional<Estimate> charge_battery = std::nullopt);
+
+  // Replace the entry of a candidate, whether or not the candidate currently
+  // has one. Passing a nullptr removes the candidate.
+  void replace_candidate(
+    std::size_t candidate,
+    std::shared_ptr<const Entry> entry);
+
+  bool empty() const;
+
+private:
+  Slots _slots;
+
+  // The number of slots at the front of _slots that share the best finish
+  // time
+  std::size_t _num_best = 0;
+
+  Candidates(Slots slots);
+
+  // Move the slot at the given position to where its finish time belongs,
+  // after any other slots with the same finish time.
+  void _reorder(std::size_t position);
+
+  void _update_best();
+
+};
+
+// ============================================================================
+// Remembers the Task::Model of each request, so that a request which gets
+// planned many times before it begins only has its model made once. A model
+// depends on the earliest start time that it was made for, so each request
+// keeps the model of the last earliest start time that it was asked for.
+// Entries are dropped by prune() once their requests have been destroyed.
+// The cache belongs to one planner, so the Parameters of its models never
+// change. It can be used from several threads at once.
+class ModelCache
+{
+public:
+
+  Task::ConstModelPtr get(
+    const ConstRequestPtr& request,
+    rmf_traffic::Time earliest_start_time,
+    const Parameters& parameters);
+
+  // Drop the entries of requests that no longer exist
+  void prune();
+
+  std::size_t size() const;
+
+private:
+
+  struct Entry
+  {
+    std::weak_ptr<const Request> request;
+    rmf_traffic::Time earliest_start_time;
+    Task::ConstModelPtr model;
+  };
+
+  mutable std::mutex _mutex;
+  std::unordered_map<const Request*, Entry> _entries;
+};
+
+// ============================================================================
+// Remembers the Task::Model::Kernel that each model made for each initial
+// state during one plan, keyed by every basic component of the state except
+// its time. Agents often reach the same waypoint with the same charge at
+// different times, e.g. after a charge or when the battery is not drained, and
+// then only the cheap time shift of the kernel is left to do. Kernels may
+// refer to their models, so the cache must not outlive the models that it is
+// used with. It can be used from several threads at once.
+class KernelCache
+{
+public:
+
+  // Get the kernel of a model for an initial state, making it if it has not
+  // been made yet. This is a nullptr if the model does not make kernels or
+  // the state is missing one of its basic components. If reuses is given, it
+  // gets incremented each time a kernel that was already made is returned.
+  Task::Model::ConstKernelPtr get(
+    const Task::Model& model,
+    const State& initial_state,
+    const Constraints& constraints,
+    const TravelEstimator& travel_estimator,
+    std::atomic_size_t* reuses = nullptr);
+
+  std::size_t size() const;
+
+private:
+
+  struct Key
+  {
+    const Task::Model* model;
+    std::size_t waypoint;
+    double orientation;
+    std::size_t charging_waypoint;
+    double battery_soc;
+
+    bool operator==(const Key& other) const;
+  };
+
+  struct Hash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  static constexpr std::size_t NumShards = 16;
+
+  struct Shard
+  {
+    mutable std::mutex mutex;
+    std::unordered_map<Key, Task::Model::ConstKernelPtr, Hash> kernels;
+  };
+
+  std::array<Shard, NumShards> _shards;
+};
+
+// ============================================================================
+// Remembers the results of recent calls to plan(), so that a problem which is
+// planned again without any change gets the same result without a search. Two
+// problems are the same when their time_now, the built-in components of every
+// agent State, the requests and the options that shape the search are all
+// exactly equal. Like the ModelCache, requests are compared by identity, so a
+// request that gets made again is a different request, even with the same ID.
+// The least recently used results are dropped once the cache is full. It can
+// be used from several threads at once.
+class ResultCache
+{
+public:
+
+  // The built-in components of the State of an agent
+  struct Agent
+  {
+    std::optional<std::size_t> waypoint;
+    std::optional<double> orientation;
+    std::optional<rmf_traffic::Time> time;
+    std::optional<std::size_t> charging_waypoint;
+    std::optional<double> battery_soc;
+    std::optional<uint32_t> payload_capacity;
+
+    bool operator==(const Agent& other) const;
+  };
+
+  struct Key
+  {
+    rmf_traffic::Time time_now;
+    std::vector<Agent> agents;
+    std::vector<const Request*> requests;
+    bool greedy;
+    const RequestFactory* finishing_request;
+    std::size_t search_threads;
+    std::optional<std::uint64_t> deterministic_seed;
+    std::optional<rmf_traffic::Duration> local_search_budget;
+    std::size_t max_open_nodes;
+    bool anytime;
+    std::size_t horizon;
+    std::size_t commit_window;
+    std::optional<rmf_traffic::Duration> delivery_pooling_window;
+    bool break_agent_symmetry;
+    double agent_symmetry_soc_tolerance;
+    rmf_traffic::Duration agent_symmetry_time_tolerance;
+    bool break_request_symmetry;
+    bool prune_dominated_nodes;
+    std::optional<double> partial_charging_margin;
+    std::optional<rmf_traffic::Duration> opportunistic_charging_detour;
+    bool greedy_by_finish_time;
+    std::size_t greedy_restarts;
+    double greedy_restart_alpha;
+    std::optional<rmf_traffic::Duration> neighborhood_search_budget;
+    std::size_t neighborhood_size;
+    std::size_t parallel_neighborhoods;
+
+    // The travel estimates are slowed down by the congestion that the travel
+    // estimator has when the problem is planned
+    std::optional<TravelEstimator::Congestion> congestion;
+
+    // The calibration of the travel estimator, and its version when the
+    // problem is planned
+    const Calibration* calibration;
+    uint64_t calibration_version;
+
+    // The generation of the travel estimates when the problem is planned
+    uint64_t travel_generation;
+
+    bool operator==(const Key& other) const;
+  };
+
+  // Make the key of a problem, or std::nullopt if the result of the problem
+  // depends on more than the problem itself, e.g. on how much time the search
+  // is given, and so should not be remembered.
+  static std::optional<Key> make_key(
+    rmf_traffic::Time time_now,
+    const std::vector<State>& agents,
+    const std::vector<ConstRequestPtr>& requests,
+    const TaskPlanner::Options& options,
+    const TravelEstimator& travel_estimator);
+
+  ResultCache(std::size_t capacity);
+
+  // Get the result and statistics that were remembered for a problem
+  std::optional<std::pair<TaskPlanner::Result, TaskPlanner::Statistics>>
+  find(const Key& key);
+
+  void insert(
+    Key key,
+    const std::vector<ConstRequestPtr>& requests,
+    TaskPlanner::Result result,
+    TaskPlanner::Statistics statistics);
+
+  std::size_t size() const;
 
 private:
-  Map _value_map;
-  std::vector<Map::iterator> _candidate_map;
 
-  Candidates(Map candidate_values);
+  struct Hash
+  {
+    std::size_t operator()(const Key& key) const;
+  };
+
+  struct Entry
+  {
+    Key key;
+
+    // A request that has been destroyed may have its address reused by a new
+    // request, so the key only matches while every request is still alive.
+    std::vector<std::weak_ptr<const Request>> requests;
+    TaskPlanner::Result result;
+    TaskPlanner::Statistics statistics;
+  };
 
-  void update_map();
+  using List = std::list<Entry>;
 
+  std::size_t _capacity;
+  mutable std::mutex _mutex;
+  List _entries;
+  std::unordered_map<Key, List::iterator, Hash> _lookup;
 };
 
 // ============================================================================
@@ -119,7 +517,42 @@ public:
     const ConstRequestPtr request_,
     const TravelEstimator& travel_estimator,
     const std::string& planner_id,
-    TaskPlanner::TaskPlannerError& error);
+    TaskPlanner::TaskPlannerError& error,
+    std::atomic_size_t* finish_estimates = nullptr,
+    ModelCache* models = nullptr,
+    const Task::Model* charging_model = nullptr,
+    EstimateProfiler* profiler = nullptr);
+
+  // Re-estimate the candidate entry of an agent whose initial state has
+  // changed. Returns false if no agent is able to perform this task anymore.
+  bool update_agent(
+    std::size_t agent,
+    const rmf_traffic::Time start_time,
+    const State& state,
+    const Constraints& constraints,
+    const Parameters& parameters,
+    const TravelEstimator& travel_estimator,
+    const std::string& planner_id,
+    TaskPlanner::TaskPlannerError& error,
+    std::atomic_size_t* finish_estimates = nullptr,
+    const Task::Model* charging_model = nullptr,
+    EstimateProfiler* profiler = nullptr);
+
+  PendingTask(const PendingTask&) = default;
+  PendingTask(PendingTask&&) = default;
+  PendingTask& operator=(const PendingTask&) = default;
+  PendingTask& operator=(PendingTask&&) = default;
+
+  // Copy a pending task whose candidates draw from the given allocator
+  PendingTask(
+    const PendingTask& other,
+    const Candidates::allocator_type& allocator)
+  : request(other.request),
+    model(other.model),
+    candidates(other.candidates, allocator)
+  {
+    // Do nothing
+  }
 
   rmf_task::ConstRequestPtr request;
   Task::ConstModelPtr model;
@@ -133,18 +566,409 @@ private:
 };
 
 // ============================================================================
-struct Node
+struct AssignmentWrapper
+{
+  std::size_t internal_id;
+  TaskPlanner::Assignment assignment;
+};
+
+// ============================================================================
+// A persistent list of the assignments of one agent. Each element links back
+// to the element before it, so when a search node is copied its children share
+// every assignment of the parent and only store the ones that they append.
+class AssignmentList
 {
-  struct AssignmentWrapper
+public:
+
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  AssignmentList() = default;
+
+  explicit AssignmentList(const allocator_type& allocator)
+  : _memory(allocator.resource())
+  {
+    // Do nothing
+  }
+
+  AssignmentList(const AssignmentList& other) = default;
+  AssignmentList(AssignmentList&& other) = default;
+  AssignmentList& operator=(const AssignmentList& other) = default;
+  AssignmentList& operator=(AssignmentList&& other) = default;
+
+  AssignmentList(const AssignmentList& other, const allocator_type& allocator)
+  : _back(other._back),
+    _memory(allocator.resource())
+  {
+    // Do nothing
+  }
+
+  AssignmentList(AssignmentList&& other, const allocator_type& allocator)
+  : _back(std::move(other._back)),
+    _memory(allocator.resource())
   {
-    std::size_t internal_id;
-    TaskPlanner::Assignment assignment;
+    // Do nothing
+  }
+
+  bool empty() const
+  {
+    return !_back;
+  }
+
+  std::size_t size() const
+  {
+    return _back ? _back->size : 0;
+  }
+
+  const AssignmentWrapper& back() const
+  {
+    assert(_back);
+    return _back->value;
+  }
+
+  // Get the first assignment, which takes a walk along the whole list
+  const AssignmentWrapper& front() const
+  {
+    assert(_back);
+    const Link* link = _back.get();
+    while (link->previous)
+      link = link->previous.get();
+
+    return link->value;
+  }
+
+  void push_back(AssignmentWrapper value)
+  {
+    const std::size_t size = this->size() + 1;
+    _back = std::allocate_shared<Link>(
+      std::pmr::polymorphic_allocator<Link>(_memory),
+      Link{std::move(value), std::move(_back), size});
+  }
+
+  void pop_back()
+  {
+    assert(_back);
+    _back = _back->previous;
+  }
+
+  // Visit the assignments in reverse order, starting from the last one
+  template<typename F>
+  void for_each_reverse(F&& f) const
+  {
+    for (const Link* link = _back.get(); link; link = link->previous.get())
+      f(link->value);
+  }
+
+  // Get the assignments ordered from the first to the last
+  std::vector<const AssignmentWrapper*> in_order() const
+  {
+    std::vector<const AssignmentWrapper*> output(size());
+    std::size_t i = output.size();
+    for_each_reverse([&](const AssignmentWrapper& a) { output[--i] = &a; });
+    return output;
+  }
+
+private:
+  struct Link
+  {
+    AssignmentWrapper value;
+    std::shared_ptr<const Link> previous;
+    std::size_t size;
+  };
+
+  std::shared_ptr<const Link> _back;
+  std::pmr::memory_resource* _memory = std::pmr::get_default_resource();
+};
+
+// ============================================================================
+// A 128-bit Zobrist key of the assignments of a node. Every combination of
+// agent, position in the agent's list, and task ID has its own pseudo-random
+// key, and the key of a node is the exclusive-or of the keys of all of its
+// assignments. That allows the key to be updated in constant time whenever an
+// assignment is appended or removed.
+struct AssignmentKey
+{
+  std::uint64_t low = 0;
+  std::uint64_t high = 0;
+
+  static AssignmentKey of(
+    std::size_t agent,
+    std::size_t position,
+    std::size_t internal_id)
+  {
+    const std::uint64_t seed = mix(mix(agent) ^ position) ^ internal_id;
+    return AssignmentKey{mix(seed), mix(seed ^ 0xd1b54a32d192ed03ull)};
+  }
+
+  bool operator==(const AssignmentKey& other) const
+  {
+    return low == other.low && high == other.high;
+  }
+
+  bool operator<(const AssignmentKey& other) const
+  {
+    return low < other.low || (low == other.low && high < other.high);
+  }
+
+  AssignmentKey& operator^=(const AssignmentKey& other)
+  {
+    low ^= other.low;
+    high ^= other.high;
+    return *this;
+  }
+
+private:
+  // The splitmix64 finalizer
+  static std::uint64_t mix(std::uint64_t x)
+  {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+  }
+};
+
+// ============================================================================
+// The pending tasks of a node that have not been assigned yet, keyed by their
+// internal IDs. The tasks are kept in a dense vector indexed by internal ID and
+// a bitset marks which of them are still unassigned. Copying a node does not
+// rehash anything, iterating only visits the set bits, and the tasks are always
+// visited in the order of their internal IDs, so ties between them are broken
+// the same way with every standard library.
+class UnassignedTasks
+{
+public:
+
+  using value_type = std::pair<std::size_t, PendingTask>;
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+  template<typename Owner, typename Value>
+  class Iterator
+  {
+  public:
+
+    Iterator(Owner* owner, std::size_t index)
+    : _owner(owner),
+      _index(index)
+    {
+      // Do nothing
+    }
+
+    Value& operator*() const
+    {
+      return *_owner->_slots[_index];
+    }
+
+    Value* operator->() const
+    {
+      return &**this;
+    }
+
+    Iterator& operator++()
+    {
+      _index = _owner->_next(_index + 1);
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const
+    {
+      return _index == other._index;
+    }
+
+    bool operator!=(const Iterator& other) const
+    {
+      return _index != other._index;
+    }
+
+  private:
+    Owner* _owner;
+    std::size_t _index;
   };
 
-  using AssignedTasks = std::vector<std::vector<AssignmentWrapper>>;
-  using UnassignedTasks =
-    std::unordered_map<std::size_t, PendingTask>;
-  using InvariantSet = std::multiset<Invariant, InvariantLess>;
+  using iterator = Iterator<UnassignedTasks, value_type>;
+  using const_iterator = Iterator<const UnassignedTasks, const value_type>;
+
+  UnassignedTasks() = default;
+  UnassignedTasks(const UnassignedTasks&) = default;
+  UnassignedTasks& operator=(const UnassignedTasks&) = default;
+
+  explicit UnassignedTasks(const allocator_type& allocator)
+  : _slots(allocator),
+    _bits(allocator)
+  {
+    // Do nothing
+  }
+
+  // The candidates of the tasks are copied into the allocator as well, since
+  // every node updates them for the agent that it assigns a task to
+  UnassignedTasks(
+    const UnassignedTasks& other,
+    const allocator_type& allocator)
+  : _slots(allocator),
+    _bits(other._bits, allocator),
+    _size(other._size)
+  {
+    _slots.reserve(other._slots.size());
+    for (const auto& slot : other._slots)
+    {
+      if (!slot.has_value())
+      {
+        _slots.emplace_back();
+        continue;
+      }
+
+      _slots.emplace_back(
+        std::in_place, slot->first, PendingTask(slot->second, allocator));
+    }
+  }
+
+  // Add a task under its internal ID, unless that ID is already unassigned
+  void insert(value_type task)
+  {
+    const std::size_t id = task.first;
+    if (_slots.size() <= id)
+    {
+      _slots.resize(id + 1);
+      _bits.resize(id / 64 + 1, 0);
+    }
+
+    if (_slots[id].has_value())
+      return;
+
+    _slots[id] = std::move(task);
+    _bits[id / 64] |= std::uint64_t(1) << (id % 64);
+    ++_size;
+  }
+
+  // Remove the task of an internal ID. Returns the number of tasks removed.
+  std::size_t erase(std::size_t id)
+  {
+    if (_slots.size() <= id || !_slots[id].has_value())
+      return 0;
+
+    _slots[id].reset();
+    _bits[id / 64] &= ~(std::uint64_t(1) << (id % 64));
+    --_size;
+    return 1;
+  }
+
+  // The task of an internal ID, or nullptr if it is not unassigned
+  const value_type* find(std::size_t id) const
+  {
+    if (_slots.size() <= id || !_slots[id].has_value())
+      return nullptr;
+
+    return &*_slots[id];
+  }
+
+  bool empty() const
+  {
+    return _size == 0;
+  }
+
+  std::size_t size() const
+  {
+    return _size;
+  }
+
+  iterator begin()
+  {
+    return iterator(this, _next(0));
+  }
+
+  iterator end()
+  {
+    return iterator(this, _slots.size());
+  }
+
+  const_iterator begin() const
+  {
+    return const_iterator(this, _next(0));
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator(this, _slots.size());
+  }
+
+private:
+
+  // The index of the lowest set bit of a word that is not zero
+  static std::size_t _lowest_bit(std::uint64_t word)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<std::size_t>(__builtin_ctzll(word));
+#else
+    std::size_t bit = 0;
+    while ((word & 1) == 0)
+    {
+      word >>= 1;
+      ++bit;
+    }
+    return bit;
+#endif
+  }
+
+  // The first unassigned internal ID that is not less than id, or the number
+  // of slots if there is none
+  std::size_t _next(std::size_t id) const
+  {
+    std::size_t w = id / 64;
+    if (w >= _bits.size())
+      return _slots.size();
+
+    std::uint64_t word = _bits[w] & (~std::uint64_t(0) << (id % 64));
+    while (word == 0)
+    {
+      if (++w == _bits.size())
+        return _slots.size();
+
+      word = _bits[w];
+    }
+
+    return w * 64 + _lowest_bit(word);
+  }
+
+  std::pmr::vector<std::optional<value_type>> _slots;
+  std::pmr::vector<std::uint64_t> _bits;
+  std::size_t _size = 0;
+};
+
+// ============================================================================
+struct Node
+{
+  using AssignmentWrapper = rmf_task::AssignmentWrapper;
+  using Allocator = std::pmr::polymorphic_allocator<std::byte>;
+  using AssignedTasks = std::pmr::vector<AssignmentList>;
+  using UnassignedTasks = rmf_task::UnassignedTasks;
+  using InvariantSet = rmf_task::InvariantSet;
+
+  Node() = default;
+  Node(const Node&) = default;
+
+  // Create an empty node whose containers draw from the given allocator
+  explicit Node(Allocator allocator)
+  : assigned_tasks(allocator),
+    unassigned_tasks(allocator),
+    unassigned_invariants(allocator)
+  {
+    // Do nothing
+  }
+
+  // Copy a node into containers that draw from the given allocator
+  Node(const Node& other, Allocator allocator)
+  : assigned_tasks(other.assigned_tasks, allocator),
+    unassigned_tasks(other.unassigned_tasks, allocator),
+    cost_estimate(other.cost_estimate),
+    latest_time(other.latest_time),
+    unassigned_invariants(other.unassigned_invariants, allocator),
+    next_available_internal_id(other.next_available_internal_id),
+    assignment_key(other.assignment_key),
+    assigned_cost(other.assigned_cost),
+    assigned_earliest_start(other.assigned_earliest_start),
+    assigned_latest_finish(other.assigned_latest_finish)
+  {
+    // Do nothing
+  }
 
   AssignedTasks assigned_tasks;
   UnassignedTasks unassigned_tasks;
@@ -153,6 +977,79 @@ struct Node
   InvariantSet unassigned_invariants;
   std::size_t next_available_internal_id = 1;
 
+  // The Zobrist key of assigned_tasks. Use assign() and unassign_last() to
+  // modify assigned_tasks so that this stays up to date. Each assignment is
+  // keyed by the ID that the planner gives for it, which is the first of its
+  // interchangeable requests when the planner breaks request symmetry, so
+  // that nodes which only swap interchangeable requests share a key.
+  AssignmentKey assignment_key;
+
+  // The sum of CostCalculator::compute_assignment_cost() over assigned_tasks.
+  // The planner updates this whenever it assigns or unassigns a task, so the
+  // cost of a child can be computed without visiting all of its assignments.
+  double assigned_cost = 0.0;
+
+  // The earliest start time and the latest finish time of the requests in
+  // assigned_tasks, not counting charges, which span the makespan of the
+  // assignments so far. Use assign() and unassign_last() to modify
+  // assigned_tasks so that these stay up to date.
+  std::optional<rmf_traffic::Time> assigned_earliest_start;
+  std::optional<rmf_traffic::Time> assigned_latest_finish;
+
+  // Append an assignment to the list of an agent, keyed by key_id
+  void assign(
+    std::size_t agent,
+    AssignmentWrapper assignment,
+    std::size_t key_id)
+  {
+    auto& assignments = assigned_tasks[agent];
+    assignment_key ^= AssignmentKey::of(agent, assignments.size(), key_id);
+    include_in_span(assignment.assignment);
+    assignments.push_back(std::move(assignment));
+  }
+
+  // Remove the last assignment from the list of an agent, which was keyed by
+  // key_id when it was assigned
+  void unassign_last(std::size_t agent, std::size_t key_id)
+  {
+    auto& assignments = assigned_tasks[agent];
+    assignment_key ^= AssignmentKey::of(
+      agent, assignments.size() - 1, key_id);
+    const bool charging = assignments.back().assignment.is_charging();
+    assignments.pop_back();
+
+    // Only the greedy solver backtracks, so the span is simply walked again
+    if (!charging)
+    {
+      assigned_earliest_start = std::nullopt;
+      assigned_latest_finish = std::nullopt;
+      for (const auto& agent_assignments : assigned_tasks)
+      {
+        agent_assignments.for_each_reverse(
+          [&](const AssignmentWrapper& wrapper)
+          {
+            include_in_span(wrapper.assignment);
+          });
+      }
+    }
+  }
+
+  void include_in_span(const TaskPlanner::Assignment& assignment)
+  {
+    if (assignment.is_charging())
+      return;
+
+    const auto start = assignment.request()->booking()->earliest_start_time();
+    if (!assigned_earliest_start.has_value()
+      || start < *assigned_earliest_start)
+      assigned_earliest_start = start;
+
+    const auto finish = assignment.finish_state().time().value();
+    if (!assigned_latest_finish.has_value()
+      || *assigned_latest_finish < finish)
+      assigned_latest_finish = finish;
+  }
+
   // ID 0 is reserved for charging tasks
   std::size_t get_available_internal_id(bool charging_task = false)
   {
@@ -161,7 +1058,8 @@ struct Node
 
   void sort_invariants()
   {
-    unassigned_invariants.clear();
+    std::vector<Invariant> invariants;
+    invariants.reserve(unassigned_tasks.size());
     for (const auto& u : unassigned_tasks)
     {
       double earliest_start_time = rmf_traffic::time::to_seconds(
@@ -171,32 +1069,23 @@ struct Node
       double earliest_finish_time = earliest_start_time
         + rmf_traffic::time::to_seconds(invariant_duration);
 
-      unassigned_invariants.insert(
+      invariants.push_back(
         Invariant{
           u.first,
           earliest_start_time,
           earliest_finish_time
         });
     }
+
+    unassigned_invariants.assign(std::move(invariants));
   }
 
   void pop_unassigned(std::size_t task_id)
   {
     unassigned_tasks.erase(task_id);
 
-    bool popped_invariant = false;
-    InvariantSet::iterator erase_it;
-    for (auto it = unassigned_invariants.begin();
-      it != unassigned_invariants.end(); ++it)
-    {
-      if (it->task_id == task_id)
-      {
-        popped_invariant = true;
-        erase_it = it;
-        break;
-      }
-    }
-    unassigned_invariants.erase(erase_it);
+    [[maybe_unused]] const bool popped_invariant =
+      unassigned_invariants.erase(task_id);
     assert(popped_invariant);
   }
 };
@@ -205,11 +1094,47 @@ using NodePtr = std::shared_ptr<Node>;
 using ConstNodePtr = std::shared_ptr<const Node>;
 
 // ============================================================================
+// The memory that all the nodes of one plan() call are allocated from. Freed
+// blocks get recycled by a pool, and everything is returned to the system in
+// bulk when the arena is destroyed, so no node may outlive its arena.
+class NodeArena
+{
+public:
+
+  // If concurrent is true, nodes may be allocated from several threads at once.
+  // If reserve is not zero, that many bytes are allocated up front and touched
+  // by the calling thread, so the operating system backs them with memory of
+  // the NUMA node that the calling thread is running on. The memory of the
+  // arena comes from the upstream resource, or from the default resource if
+  // that is nullptr.
+  NodeArena(
+    bool concurrent,
+    std::size_t reserve = 0,
+    std::pmr::memory_resource* upstream = nullptr);
+
+  NodePtr make_node();
+
+  NodePtr make_node(const Node& parent);
+
+private:
+  std::pmr::vector<std::byte> _reserved;
+  std::optional<std::pmr::monotonic_buffer_resource> _buffer;
+  std::unique_ptr<std::pmr::memory_resource> _pool;
+};
+
+// ============================================================================
+// Orders nodes for a max-heap so that the node with the lowest cost estimate is
+// on top. Nodes with equal cost estimates are ordered by their assignment keys,
+// so ties are broken by what the nodes hold rather than by the order in which
+// they happened to be pushed.
 struct LowestCostEstimate
 {
-  bool operator()(const ConstNodePtr& a, const ConstNodePtr& b)
+  bool operator()(const ConstNodePtr& a, const ConstNodePtr& b) const
   {
-    return b->cost_estimate < a->cost_estimate;
+    if (a->cost_estimate != b->cost_estimate)
+      return b->cost_estimate < a->cost_estimate;
+
+    return b->assignment_key < a->assignment_key;
   }
 };
 
@@ -18,9 +18,12 @@
 #include <string>
 #include <sstream>
 #include <random>
+#include <stdexcept>
 
 #include <rmf_task/requests/ChargeBattery.hpp>
 
+#include "../EstimateKernel.hpp"
+
 namespace rmf_task {
 namespace requests {
 
@@ -60,20 +63,24 @@ public:
 
   Model(
     const rmf_traffic::Time earliest_start_time,
-    Parameters parameters);
+    Parameters parameters,
+    std::optional<double> target_soc);
 
 private:
   rmf_traffic::Time _earliest_start_time;
   Parameters _parameters;
+  std::optional<double> _target_soc;
   rmf_traffic::Duration _invariant_duration;
 };
 
 //==============================================================================
 ChargeBattery::Model::Model(
   const rmf_traffic::Time earliest_start_time,
-  Parameters parameters)
+  Parameters parameters,
+  std::optional<double> target_soc)
 : _earliest_start_time(earliest_start_time),
-  _parameters(parameters)
+  _parameters(parameters),
+  _target_soc(target_soc)
 {
   _invariant_duration = rmf_traffic::time::from_seconds(0.0);
 }
@@ -91,34 +98,38 @@ ChargeBattery::Model::estimate_finish(
   // segmentation threshold, causing `solve` to return. This may cause an
   // infinite loop as a new identical charging task is added in each call to
   // `solve` before returning.
-  const auto recharge_soc = task_planning_constraints.recharge_soc();
-  if (initial_state.battery_soc() >= recharge_soc - 1e-3
-    && initial_state.waypoint().value()
-    == initial_state.dedicated_charging_waypoint().value())
+  const auto initial = BasicState::read(initial_state);
+  if (!initial.charging_waypoint.has_value())
+    return std::nullopt;
+
+  const std::size_t charger = *initial.charging_waypoint;
+  const auto recharge_soc =
+    _target_soc.value_or(task_planning_constraints.recharge_soc());
+  if (initial.battery_soc >= recharge_soc - 1e-3
+    && initial.waypoint == charger)
   {
     return std::nullopt;
   }
 
   // Compute time taken to reach charging waypoint from current location
   rmf_traffic::agv::Plan::Start final_plan_start{
-    initial_state.time().value(),
-    initial_state.dedicated_charging_waypoint().value(),
-    initial_state.orientation().value()};
+    initial.time,
+    charger,
+    initial.orientation};
 
   auto state = State().load_basic(
     std::move(final_plan_start),
-    initial_state.dedicated_charging_waypoint().value(),
-    initial_state.battery_soc().value());
+    charger,
+    initial.battery_soc);
 
-  double battery_soc = initial_state.battery_soc().value();
+  double battery_soc = initial.battery_soc;
   rmf_traffic::Duration variant_duration(0);
 
-  if (initial_state.waypoint() != initial_state.dedicated_charging_waypoint())
+  if (initial.waypoint != charger)
   {
     const auto travel = travel_estimator.estimate(
-      initial_state.extract_plan_start().value(),
-      rmf_traffic::agv::Plan::Goal(
-        initial_state.dedicated_charging_waypoint().value()));
+      initial.plan_start(),
+      rmf_traffic::agv::Plan::Goal(charger));
 
     if (!travel.has_value())
       return std::nullopt;
@@ -144,7 +155,7 @@ ChargeBattery::Model::estimate_finish(
     (3600 * delta_soc * _parameters.battery_system().capacity()) /
     _parameters.battery_system().charging_current();
 
-  const rmf_traffic::Time wait_until = initial_state.time().value();
+  const rmf_traffic::Time wait_until = initial.time;
   state.time(
     wait_until + variant_duration +
     rmf_traffic::time::from_seconds(time_to_charge));
@@ -165,6 +176,7 @@ class ChargeBattery::Description::Implementation
 {
 public:
   bool indefinite = false;
+  std::optional<double> target_soc;
 };
 
 //==============================================================================
@@ -175,6 +187,22 @@ Task::ConstDescriptionPtr ChargeBattery::Description::make()
   return description;
 }
 
+//==============================================================================
+Task::ConstDescriptionPtr ChargeBattery::Description::make(double target_soc)
+{
+  if (target_soc < 0.0 || 1.0 < target_soc)
+  {
+    throw std::invalid_argument(
+      "[rmf_task::requests::ChargeBattery::Description::make] The target "
+      "state of charge [" + std::to_string(target_soc) + "] is outside of "
+      "[0.0, 1.0]");
+  }
+
+  std::shared_ptr<Description> description(new Description);
+  description->_pimpl->target_soc = target_soc;
+  return description;
+}
+
 //==============================================================================
 auto ChargeBattery::Description::make_indefinite()
 -> std::shared_ptr<Description>
@@ -198,7 +226,8 @@ Task::ConstModelPtr ChargeBattery::Description::make_model(
 {
   return std::make_shared<ChargeBattery::Model>(
     earliest_start_time,
-    parameters);
+    parameters,
+    _pimpl->target_soc);
 }
 
 //==============================================================================
@@ -224,11 +253,18 @@ bool ChargeBattery::Description::indefinite() const
   return _pimpl->indefinite;
 }
 
+//==============================================================================
+std::optional<double> ChargeBattery::Description::target_soc() const
+{
+  return _pimpl->target_soc;
+}
+
 //==============================================================================
 ConstRequestPtr ChargeBattery::make(
   rmf_traffic::Time earliest_start_time,
   ConstPriorityPtr priority,
-  bool automatic)
+  bool automatic,
+  std::optional<double> target_soc)
 {
   const std::string id = "Charge" + generate_uuid();
   Task::ConstBookingPtr booking =
@@ -237,7 +273,8 @@ ConstRequestPtr ChargeBattery::make(
     earliest_start_time,
     std::move(priority),
     automatic);
-  const auto description = Description::make();
+  const auto description = target_soc.has_value() ?
+    Description::make(*target_soc) : Description::make();
   return std::make_shared<Request>(
     std::move(booking),
     std::move(description));
@@ -249,7 +286,8 @@ ConstRequestPtr ChargeBattery::make(
   const std::string& requester,
   rmf_traffic::Time request_time,
   ConstPriorityPtr priority,
-  bool automatic)
+  bool automatic,
+  std::optional<double> target_soc)
 {
   const std::string id = "Charge" + generate_uuid();
   Task::ConstBookingPtr booking =
@@ -260,7 +298,8 @@ ConstRequestPtr ChargeBattery::make(
     requester,
     request_time,
     automatic);
-  const auto description = Description::make();
+  const auto description = target_soc.has_value() ?
+    Description::make(*target_soc) : Description::make();
   return std::make_shared<Request>(
     std::move(booking),
     std::move(description));
@@ -19,6 +19,9 @@
 
 #include <rmf_task/requests/Clean.hpp>
 
+#include "../BatteryDrain.hpp"
+#include "../EstimateKernel.hpp"
+
 namespace rmf_task {
 namespace requests {
 
@@ -34,6 +37,13 @@ public:
 
   rmf_traffic::Duration invariant_duration() const final;
 
+  double min_battery_drain() const final;
+
+  ConstKernelPtr make_kernel(
+    const State& initial_state,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const final;
+
   Model(
     const rmf_traffic::Time earliest_start_time,
     const Parameters& parameters,
@@ -44,11 +54,14 @@ public:
 private:
   rmf_traffic::Time _earliest_start_time;
   Parameters _parameters;
+  BatteryDrain _drain;
   std::size_t _start_waypoint;
   std::size_t _end_waypoint;
 
   rmf_traffic::Duration _invariant_duration;
   double _invariant_battery_drain;
+
+  FixedRequest _fixed_request() const;
 };
 
 //==============================================================================
@@ -60,6 +73,7 @@ Clean::Model::Model(
   std::size_t end_waypoint)
 : _earliest_start_time(earliest_start_time),
   _parameters(parameters),
+  _drain(parameters),
   _start_waypoint(start_waypoint),
   _end_waypoint(end_waypoint)
 {
@@ -71,11 +85,9 @@ Clean::Model::Model(
     cleaning_finish_time - cleaning_start_time;
 
   // Compute battery drain over invariant path
-  const double dSOC_motion =
-    _parameters.motion_sink()->compute_change_in_charge(cleaning_path);
+  const double dSOC_motion = _drain.motion(cleaning_path);
   const double dSOC_ambient =
-    _parameters.ambient_sink()->compute_change_in_charge(
-    rmf_traffic::time::to_seconds(_invariant_duration));
+    _drain.ambient(rmf_traffic::time::to_seconds(_invariant_duration));
   const double dSOC_cleaning =
     _parameters.tool_sink()->compute_change_in_charge(
     rmf_traffic::time::to_seconds(_invariant_duration));
@@ -89,106 +101,52 @@ std::optional<rmf_task::Estimate> Clean::Model::estimate_finish(
   const Constraints& task_planning_constraints,
   const TravelEstimator& travel_estimator) const
 {
-  rmf_traffic::agv::Plan::Start final_plan_start{
-    initial_state.time().value(),
-    _end_waypoint,
-    initial_state.orientation().value()};
-
-  auto state = State().load_basic(
-    std::move(final_plan_start),
-    initial_state.dedicated_charging_waypoint().value(),
-    initial_state.battery_soc().value());
-
-  rmf_traffic::Duration variant_duration(0);
-  rmf_traffic::Duration end_duration(0);
-
-  double battery_soc = initial_state.battery_soc().value();
-  const bool drain_battery = task_planning_constraints.drain_battery();
-  const auto& ambient_sink = *_parameters.ambient_sink();
-
-  if (initial_state.waypoint() != _start_waypoint)
-  {
-    const auto travel = travel_estimator.estimate(
-      initial_state.extract_plan_start().value(),
-      _start_waypoint);
-
-    if (!travel.has_value())
-      return std::nullopt;
-
-    variant_duration = travel->duration();
-    if (drain_battery)
-      battery_soc = battery_soc - travel->change_in_charge();
-
-    if (battery_soc <= task_planning_constraints.threshold_soc())
-      return std::nullopt;
-  }
-
-  if (_start_waypoint != _end_waypoint)
-  {
-    // TODO(YV) Account for battery drain and duration when robot moves from
-    // end of cleaning trajectory to its end_waypoint. We currently define the
-    // end_waypoint near the start_waypoint in the nav graph for minimum error
-  }
-
-  const rmf_traffic::Time ideal_start = _earliest_start_time - variant_duration;
-  const rmf_traffic::Time wait_until =
-    initial_state.time().value() > ideal_start ?
-    initial_state.time().value() : ideal_start;
-
-  // Factor in battery drain while waiting to move to start waypoint. If a robot
-  // is initially at a charging waypoint, it is assumed to be continually charging
-  if (drain_battery && wait_until > initial_state.time().value() &&
-    initial_state.waypoint()
-    != initial_state.dedicated_charging_waypoint().value())
-  {
-    rmf_traffic::Duration wait_duration(
-      wait_until - initial_state.time().value());
-    const double dSOC_ambient = ambient_sink.compute_change_in_charge(
-      rmf_traffic::time::to_seconds(wait_duration));
-    battery_soc = battery_soc - dSOC_ambient;
-
-    if (battery_soc <= task_planning_constraints.threshold_soc())
-    {
-      return std::nullopt;
-    }
-  }
+  // TODO(YV) Account for battery drain and duration when robot moves from
+  // end of cleaning trajectory to its end_waypoint. We currently define the
+  // end_waypoint near the start_waypoint in the nav graph for minimum error
+  return estimate_fixed_request(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
+}
 
-  // Factor in invariants
-  state.time(
-    wait_until + variant_duration + _invariant_duration + end_duration);
+//==============================================================================
+rmf_traffic::Duration Clean::Model::invariant_duration() const
+{
+  return _invariant_duration;
+}
 
-  if (drain_battery)
-  {
-    battery_soc -= _invariant_battery_drain;
-    if (battery_soc <= task_planning_constraints.threshold_soc())
-      return std::nullopt;
-
-    // Check if the robot has enough charge to head back to nearest charger
-    if (_end_waypoint != state.dedicated_charging_waypoint().value())
-    {
-      const auto travel = travel_estimator.estimate(
-        state.extract_plan_start().value(),
-        state.dedicated_charging_waypoint().value());
-
-      if (!travel.has_value())
-        return std::nullopt;
-
-      const double retreat_battery_drain = travel->change_in_charge();
-      const double threshold = task_planning_constraints.threshold_soc();
-      if (battery_soc - retreat_battery_drain <= threshold)
-        return std::nullopt;
-    }
-
-    state.battery_soc(battery_soc);
-  }
+//==============================================================================
+double Clean::Model::min_battery_drain() const
+{
+  return _invariant_battery_drain;
+}
 
-  return Estimate(state, wait_until);
+//==============================================================================
+auto Clean::Model::make_kernel(
+  const State& initial_state,
+  const Constraints& task_planning_constraints,
+  const TravelEstimator& travel_estimator) const -> ConstKernelPtr
+{
+  return make_fixed_request_kernel(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
 }
 
 //==============================================================================
-rmf_traffic::Duration Clean::Model::invariant_duration() const
+FixedRequest Clean::Model::_fixed_request() const
 {
-  return _invariant_duration;
+  return FixedRequest{
+    _start_waypoint,
+    _end_waypoint,
+    _earliest_start_time,
+    _invariant_duration,
+    _invariant_battery_drain,
+    _drain
+  };
 }
 
 //==============================================================================
@@ -271,6 +229,12 @@ std::size_t Clean::Description::end_waypoint() const
   return _pimpl->end_waypoint;
 }
 
+//==============================================================================
+const rmf_traffic::Trajectory& Clean::Description::cleaning_path() const
+{
+  return _pimpl->cleaning_path;
+}
+
 //==============================================================================
 ConstRequestPtr Clean::make(
   std::size_t start_waypoint,
@@ -19,6 +19,9 @@
 
 #include <rmf_task/requests/Delivery.hpp>
 
+#include "../BatteryDrain.hpp"
+#include "../EstimateKernel.hpp"
+
 namespace rmf_task {
 namespace requests {
 
@@ -34,6 +37,13 @@ public:
 
   rmf_traffic::Duration invariant_duration() const final;
 
+  double min_battery_drain() const final;
+
+  ConstKernelPtr make_kernel(
+    const State& initial_state,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const final;
+
   Model(
     const rmf_traffic::Time earliest_start_time,
     const Parameters& parameters,
@@ -45,11 +55,14 @@ public:
 private:
   rmf_traffic::Time _earliest_start_time;
   Parameters _parameters;
+  BatteryDrain _drain;
   std::size_t _pickup_waypoint;
   std::size_t _dropoff_waypoint;
 
   rmf_traffic::Duration _invariant_duration;
   double _invariant_battery_drain;
+
+  FixedRequest _fixed_request() const;
 };
 
 //==============================================================================
@@ -62,14 +75,15 @@ Delivery::Model::Model(
   rmf_traffic::Duration dropoff_wait)
 : _earliest_start_time(earliest_start_time),
   _parameters(parameters),
+  _drain(parameters),
   _pickup_waypoint(pickup_waypoint),
   _dropoff_waypoint(dropoff_waypoint)
 {
   // Calculate duration of invariant component of task
   _invariant_duration = pickup_wait + dropoff_wait;
-  _invariant_battery_drain =
-    _parameters.ambient_sink()->compute_change_in_charge(
-    rmf_traffic::time::to_seconds(pickup_wait + dropoff_wait));
+  std::vector<double> device_seconds = {
+    rmf_traffic::time::to_seconds(pickup_wait + dropoff_wait)};
+  _invariant_battery_drain = 0.0;
 
   if (_pickup_waypoint != _dropoff_waypoint)
   {
@@ -81,26 +95,24 @@ Delivery::Model::Model(
     rmf_traffic::agv::Planner::Goal goal{_dropoff_waypoint};
     const auto result_to_dropoff = _parameters.planner()->plan(start, goal);
 
+    const auto& itinerary = result_to_dropoff->get_itinerary();
     auto itinerary_start_time = _earliest_start_time;
-    for (const auto& itinerary : result_to_dropoff->get_itinerary())
+    for (const auto& route : itinerary)
     {
-      const auto& trajectory = itinerary.trajectory();
-      const auto& finish_time = *trajectory.finish_time();
+      const auto& finish_time = *route.trajectory().finish_time();
       const auto itinerary_duration = finish_time - itinerary_start_time;
-
-      // Compute the invariant battery drain
-      const double dSOC_motion =
-        _parameters.motion_sink()->compute_change_in_charge(trajectory);
-      const double dSOC_device =
-        _parameters.ambient_sink()->compute_change_in_charge(
+      device_seconds.push_back(
         rmf_traffic::time::to_seconds(itinerary_duration));
-      _invariant_battery_drain += dSOC_motion + dSOC_device;
 
       _invariant_duration += itinerary_duration;
       itinerary_start_time = finish_time;
     }
+
+    _invariant_battery_drain += _drain.motion(itinerary);
   }
 
+  // Compute the invariant battery drain of the devices in one batch
+  _invariant_battery_drain += _drain.ambient(device_seconds);
 }
 
 //==============================================================================
@@ -109,98 +121,49 @@ std::optional<rmf_task::Estimate> Delivery::Model::estimate_finish(
   const Constraints& task_planning_constraints,
   const TravelEstimator& travel_estimator) const
 {
-  rmf_traffic::agv::Plan::Start final_plan_start{
-    initial_state.time().value(),
-    _dropoff_waypoint,
-    initial_state.orientation().value()};
-
-  auto state = State().load_basic(
-    std::move(final_plan_start),
-    initial_state.dedicated_charging_waypoint().value(),
-    initial_state.battery_soc().value());
-
-  rmf_traffic::Duration variant_duration(0);
-
-  double battery_soc = initial_state.battery_soc().value();
-  const bool drain_battery = task_planning_constraints.drain_battery();
-  const auto& ambient_sink = *_parameters.ambient_sink();
-  const double battery_threshold = task_planning_constraints.threshold_soc();
-
-  // Factor in battery drain while moving to start waypoint of task
-  if (initial_state.waypoint() != _pickup_waypoint)
-  {
-    const auto travel = travel_estimator.estimate(
-      initial_state.extract_plan_start().value(),
-      _pickup_waypoint);
-
-    if (!travel)
-      return std::nullopt;
-
-    variant_duration = travel->duration();
-    if (drain_battery)
-      battery_soc = battery_soc - travel->change_in_charge();
-
-    if (battery_soc <= battery_threshold)
-      return std::nullopt;
-  }
-
-  const rmf_traffic::Time ideal_start = _earliest_start_time - variant_duration;
-  const rmf_traffic::Time wait_until =
-    initial_state.time().value() > ideal_start ?
-    initial_state.time().value() : ideal_start;
-
-  // Factor in battery drain while waiting to move to start waypoint. If a robot
-  // is initially at a charging waypoint, it is assumed to be continually charging
-  if (drain_battery && wait_until > initial_state.time().value() &&
-    initial_state.waypoint() != initial_state.dedicated_charging_waypoint())
-  {
-    const rmf_traffic::Duration wait_duration(
-      wait_until - initial_state.time().value());
-
-    const double dSOC_device = ambient_sink.compute_change_in_charge(
-      rmf_traffic::time::to_seconds(wait_duration));
-
-    battery_soc = battery_soc - dSOC_device;
-
-    if (battery_soc <= battery_threshold)
-      return std::nullopt;
-  }
-
-  // Factor in invariants
-  state.time(wait_until + variant_duration + _invariant_duration);
-
-  if (drain_battery)
-  {
-    // Calculate how much battery is drained while waiting for the pickup and
-    // waiting for the dropoff
-    battery_soc -= _invariant_battery_drain;
-    if (battery_soc <= battery_threshold)
-      return std::nullopt;
-
-    // Check if the robot has enough charge to head back to nearest charger
-    if (_dropoff_waypoint != state.dedicated_charging_waypoint().value())
-    {
-      const auto travel = travel_estimator.estimate(
-        state.extract_plan_start().value(),
-        state.dedicated_charging_waypoint().value());
-
-      if (!travel.has_value())
-        return std::nullopt;
+  return estimate_fixed_request(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
+}
 
-      if (battery_soc - travel->change_in_charge() <= battery_threshold)
-        return std::nullopt;
-    }
+//==============================================================================
+rmf_traffic::Duration Delivery::Model::invariant_duration() const
+{
+  return _invariant_duration;
+}
 
-    state.battery_soc(battery_soc);
-  }
+//==============================================================================
+double Delivery::Model::min_battery_drain() const
+{
+  return _invariant_battery_drain;
+}
 
-  return Estimate(state, wait_until);
+//==============================================================================
+auto Delivery::Model::make_kernel(
+  const State& initial_state,
+  const Constraints& task_planning_constraints,
+  const TravelEstimator& travel_estimator) const -> ConstKernelPtr
+{
+  return make_fixed_request_kernel(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
 }
 
 //==============================================================================
-rmf_traffic::Duration Delivery::Model::invariant_duration() const
+FixedRequest Delivery::Model::_fixed_request() const
 {
-  return _invariant_duration;
+  return FixedRequest{
+    _pickup_waypoint,
+    _dropoff_waypoint,
+    _earliest_start_time,
+    _invariant_duration,
+    _invariant_battery_drain,
+    _drain
+  };
 }
 
 //==============================================================================
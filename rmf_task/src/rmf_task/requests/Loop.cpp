@@ -17,6 +17,12 @@
 
 #include <rmf_task/requests/Loop.hpp>
 
+#include <algorithm>
+#include <cmath>
+
+#include "../BatteryDrain.hpp"
+#include "../EstimateKernel.hpp"
+
 namespace rmf_task {
 namespace requests {
 
@@ -32,19 +38,43 @@ public:
 
   rmf_traffic::Duration invariant_duration() const final;
 
+  double min_battery_drain() const final;
+
   Model(
     const rmf_traffic::Time earliest_start_time,
     const Parameters& parameters,
     std::size_t start_waypoint,
     std::size_t finish_waypoint,
-    std::size_t num_loops);
+    std::size_t num_loops,
+    bool charge_between_loops);
 
 private:
+
+  struct Charging
+  {
+    rmf_traffic::Duration duration;
+    double battery_soc;
+  };
+
+  std::optional<Charging> charge_between_loops(
+    double battery_soc,
+    const rmf_traffic::agv::Plan::Start& loop_start,
+    std::size_t charging_waypoint,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const;
+
   rmf_traffic::Time _earliest_start_time;
   Parameters _parameters;
+  BatteryDrain _drain;
   std::size_t _start_waypoint;
   std::size_t _finish_waypoint;
+  std::size_t _num_loops;
+  bool _charge_between_loops;
 
+  rmf_traffic::Duration _forward_duration;
+  double _forward_battery_drain;
+  rmf_traffic::Duration _return_duration;
+  double _return_battery_drain;
   rmf_traffic::Duration _invariant_duration;
   double _invariant_battery_drain;
 };
@@ -55,13 +85,21 @@ Loop::Model::Model(
   const Parameters& parameters,
   std::size_t start_waypoint,
   std::size_t finish_waypoint,
-  std::size_t num_loops)
+  std::size_t num_loops,
+  bool charge_between_loops)
 : _earliest_start_time(earliest_start_time),
   _parameters(parameters),
+  _drain(parameters),
   _start_waypoint(start_waypoint),
-  _finish_waypoint(finish_waypoint)
+  _finish_waypoint(finish_waypoint),
+  _num_loops(num_loops),
+  _charge_between_loops(charge_between_loops)
 {
   // Calculate the invariant duration and battery drain for this task
+  _forward_duration = rmf_traffic::Duration{0};
+  _forward_battery_drain = 0.0;
+  _return_duration = rmf_traffic::Duration{0};
+  _return_battery_drain = 0.0;
   _invariant_duration = rmf_traffic::Duration{0};
   _invariant_battery_drain = 0.0;
   if (_start_waypoint != _finish_waypoint)
@@ -75,30 +113,65 @@ Loop::Model::Model(
     const auto forward_loop_plan = _parameters.planner()->plan(
       loop_start, loop_end_goal);
 
+    const auto& itinerary = forward_loop_plan->get_itinerary();
     auto itinerary_start_time = _earliest_start_time;
-    double forward_battery_drain = 0.0;
-    rmf_traffic::Duration forward_duration(0);
-    for (const auto& itinerary : forward_loop_plan->get_itinerary())
+    std::vector<double> device_seconds;
+    device_seconds.reserve(itinerary.size());
+    for (const auto& route : itinerary)
     {
-      const auto& trajectory = itinerary.trajectory();
-      const auto& finish_time = *trajectory.finish_time();
+      const auto& finish_time = *route.trajectory().finish_time();
       const auto itinerary_duration = finish_time - itinerary_start_time;
-
-      // Compute the invariant battery drain
-      const double dSOC_motion =
-        _parameters.motion_sink()->compute_change_in_charge(trajectory);
-      const double dSOC_device =
-        _parameters.ambient_sink()->compute_change_in_charge(
+      device_seconds.push_back(
         rmf_traffic::time::to_seconds(itinerary_duration));
-      forward_battery_drain += dSOC_motion + dSOC_device;
 
-      forward_duration += itinerary_duration;
+      _forward_duration += itinerary_duration;
       itinerary_start_time = finish_time;
     }
-    _invariant_duration =
-      (2 * num_loops - 1) * forward_duration;
-    _invariant_battery_drain =
-      (2 * num_loops - 1) * forward_battery_drain;
+
+    _forward_battery_drain =
+      _drain.motion(itinerary) + _drain.ambient(device_seconds);
+
+    // Every loop but the last one comes back from the finish waypoint. The
+    // way back is assumed to mirror the way there, unless the robot may
+    // charge between loops. Then the energy that it uses between loops
+    // decides when it has to leave for its charger, so the way back is
+    // planned on its own.
+    _return_duration = _forward_duration;
+    _return_battery_drain = _forward_battery_drain;
+    if (_charge_between_loops && !itinerary.empty())
+    {
+      const auto& arrival = itinerary.back().trajectory().back();
+      const rmf_traffic::agv::Planner::Start return_start{
+        itinerary_start_time, _finish_waypoint, arrival.position()[2]};
+      const auto return_plan = _parameters.planner()->plan(
+        return_start, rmf_traffic::agv::Planner::Goal{_start_waypoint});
+
+      if (return_plan.success())
+      {
+        const auto& return_itinerary = return_plan->get_itinerary();
+        rmf_traffic::Duration duration(0);
+        std::vector<double> return_seconds;
+        auto return_start_time = itinerary_start_time;
+        for (const auto& route : return_itinerary)
+        {
+          const auto& finish_time = *route.trajectory().finish_time();
+          duration += finish_time - return_start_time;
+          return_seconds.push_back(
+            rmf_traffic::time::to_seconds(finish_time - return_start_time));
+          return_start_time = finish_time;
+        }
+
+        _return_duration = duration;
+        _return_battery_drain = _drain.motion(return_itinerary)
+          + _drain.ambient(return_seconds);
+      }
+    }
+
+    // Both are closed-form in the number of loops
+    _invariant_duration = num_loops * _forward_duration
+      + (num_loops - 1) * _return_duration;
+    _invariant_battery_drain = num_loops * _forward_battery_drain
+      + (num_loops - 1) * _return_battery_drain;
   }
 }
 
@@ -108,19 +181,18 @@ std::optional<rmf_task::Estimate> Loop::Model::estimate_finish(
   const Constraints& task_planning_constraints,
   const TravelEstimator& travel_estimator) const
 {
+  const auto initial = BasicState::read(initial_state);
   rmf_traffic::Duration variant_duration(0);
 
-  double battery_soc = initial_state.battery_soc().value();
+  double battery_soc = initial.battery_soc;
   const bool drain_battery = task_planning_constraints.drain_battery();
-  const auto& ambient_sink = *_parameters.ambient_sink();
   const auto battery_threshold = task_planning_constraints.threshold_soc();
 
   // Check if a plan has to be generated from finish location to start_waypoint
-  if (initial_state.waypoint() != _start_waypoint)
+  if (initial.waypoint != _start_waypoint)
   {
     const auto travel = travel_estimator.estimate(
-      initial_state.extract_plan_start().value(),
-      _start_waypoint);
+      initial.plan_start(), _start_waypoint);
 
     if (!travel.has_value())
       return std::nullopt;
@@ -135,58 +207,86 @@ std::optional<rmf_task::Estimate> Loop::Model::estimate_finish(
 
   // Compute wait_until
   const rmf_traffic::Time ideal_start = _earliest_start_time - variant_duration;
-  const rmf_traffic::Time wait_until =
-    initial_state.time().value() > ideal_start ?
-    initial_state.time().value() : ideal_start;
+  const rmf_traffic::Time wait_until = std::max(initial.time, ideal_start);
 
   // Factor in battery drain while waiting to move to start waypoint. If a robot
   // is initially at a charging waypoint, it is assumed to be continually charging
-  if (drain_battery && wait_until > initial_state.time().value() &&
-    initial_state.waypoint().value() !=
-    initial_state.dedicated_charging_waypoint().value())
+  if (drain_battery && wait_until > initial.time &&
+    initial.waypoint != initial.charging_waypoint)
   {
-    rmf_traffic::Duration wait_duration(
-      wait_until - initial_state.time().value());
+    rmf_traffic::Duration wait_duration(wait_until - initial.time);
 
-    const auto dSOC_device = ambient_sink.compute_change_in_charge(
-      rmf_traffic::time::to_seconds(wait_duration));
+    const auto dSOC_device =
+      _drain.ambient(rmf_traffic::time::to_seconds(wait_duration));
 
     battery_soc = battery_soc - dSOC_device;
     if (battery_soc <= battery_threshold)
       return std::nullopt;
   }
 
-  // Compute finish time
-  const rmf_traffic::Time state_finish_time =
-    wait_until + variant_duration + _invariant_duration;
-
   // Subtract invariant battery drain
+  rmf_traffic::Duration charging_duration(0);
   if (drain_battery)
   {
-    battery_soc -= _invariant_battery_drain;
+    // A loop that would not fit on a full battery may stop to charge between
+    // its loops, if its request allows it
+    const bool exceeds_capacity =
+      task_planning_constraints.recharge_soc() - _invariant_battery_drain
+      <= battery_threshold;
+
+    if (_charge_between_loops && exceeds_capacity
+      && battery_soc - _invariant_battery_drain <= battery_threshold)
+    {
+      // A robot without a charger cannot charge between loops either
+      if (!initial.charging_waypoint.has_value())
+        return std::nullopt;
+
+      const rmf_traffic::agv::Plan::Start loop_start{
+        wait_until + variant_duration,
+        _start_waypoint,
+        initial.orientation};
+
+      const auto charging = charge_between_loops(
+        battery_soc,
+        loop_start,
+        *initial.charging_waypoint,
+        task_planning_constraints,
+        travel_estimator);
+
+      if (!charging.has_value())
+        return std::nullopt;
+
+      charging_duration = charging->duration;
+      battery_soc = charging->battery_soc;
+    }
+    else
+    {
+      battery_soc -= _invariant_battery_drain;
+    }
+
     if (battery_soc <= battery_threshold)
       return std::nullopt;
   }
 
+  // Compute finish time
+  const rmf_traffic::Time state_finish_time =
+    wait_until + variant_duration + _invariant_duration + charging_duration;
+
   // Return Estimate
-  rmf_traffic::agv::Planner::Start location{
+  const rmf_traffic::agv::Planner::Start location{
     state_finish_time,
     _finish_waypoint,
-    initial_state.orientation().value()};
+    initial.orientation};
 
-  auto finish_state = State().load_basic(
-    std::move(location),
-    initial_state.dedicated_charging_waypoint().value(),
-    battery_soc);
+  auto finish_state = initial.moved_to(location, battery_soc);
 
   // Check if robot can return to its charger
-  if (drain_battery)
+  const auto& charger = initial.charging_waypoint;
+  if (drain_battery && charger.has_value())
   {
-    if (_finish_waypoint != initial_state.dedicated_charging_waypoint().value())
+    if (_finish_waypoint != *charger)
     {
-      const auto travel = travel_estimator.estimate(
-        finish_state.extract_plan_start().value(),
-        finish_state.dedicated_charging_waypoint().value());
+      const auto travel = travel_estimator.estimate(location, *charger);
 
       if (!travel.has_value())
         return std::nullopt;
@@ -206,6 +306,128 @@ rmf_traffic::Duration Loop::Model::invariant_duration() const
   return _invariant_duration;
 }
 
+//==============================================================================
+double Loop::Model::min_battery_drain() const
+{
+  // A loop that may charge between its loops can start with less battery than
+  // the loops drain
+  if (_charge_between_loops)
+    return 0.0;
+
+  return _invariant_battery_drain;
+}
+
+//==============================================================================
+auto Loop::Model::charge_between_loops(
+  const double battery_soc,
+  const rmf_traffic::agv::Plan::Start& loop_start,
+  const std::size_t charging_waypoint,
+  const Constraints& task_planning_constraints,
+  const TravelEstimator& travel_estimator) const -> std::optional<Charging>
+{
+  // The robot only leaves to charge from the start waypoint, after it has
+  // come back from a loop. The last loop does not come back, so at least two
+  // loops are needed.
+  if (_num_loops < 2 || _start_waypoint == _finish_waypoint)
+    return std::nullopt;
+
+  if (charging_waypoint == _start_waypoint)
+    return std::nullopt;
+
+  const auto to_charger = travel_estimator.estimate(
+    loop_start, charging_waypoint);
+  const auto from_charger = travel_estimator.estimate(
+    rmf_traffic::agv::Plan::Start(
+      loop_start.time(), charging_waypoint, loop_start.orientation()),
+    _start_waypoint);
+  if (!to_charger.has_value() || !from_charger.has_value())
+    return std::nullopt;
+
+  // The robot must still be able to return to its charger after the last loop
+  double retreat_drain = 0.0;
+  if (_finish_waypoint != charging_waypoint)
+  {
+    const auto retreat = travel_estimator.estimate(
+      rmf_traffic::agv::Plan::Start(
+        loop_start.time(), _finish_waypoint, loop_start.orientation()),
+      charging_waypoint);
+    if (!retreat.has_value())
+      return std::nullopt;
+
+    retreat_drain = retreat->change_in_charge();
+  }
+
+  const double threshold = task_planning_constraints.threshold_soc();
+  const double recharge_soc = task_planning_constraints.recharge_soc();
+  const double round_drain = _forward_battery_drain + _return_battery_drain;
+  if (round_drain <= 0.0)
+    return std::nullopt;
+
+  // The most round trips that can be made from a battery level while keeping
+  // more than the threshold for the trip that follows them. Every check of the
+  // battery level is strict, so an exact fit does not count.
+  const auto most_rounds = [&](double soc, double reserve)
+    -> std::optional<std::size_t>
+    {
+      const double spare = (soc - threshold - reserve) / round_drain;
+      if (spare <= 0.0)
+        return std::nullopt;
+
+      // No segment needs more rounds than the whole loop has
+      const double bounded = std::min(spare, static_cast<double>(_num_loops));
+      return static_cast<std::size_t>(std::ceil(bounded)) - 1;
+    };
+
+  const double out_drain = to_charger->change_in_charge();
+  const double after_charging = recharge_soc - from_charger->change_in_charge();
+  const std::size_t rounds = _num_loops - 1;
+
+  const auto first_rounds = most_rounds(battery_soc, out_drain);
+  const auto last_rounds =
+    most_rounds(after_charging, _forward_battery_drain + retreat_drain);
+  if (!first_rounds.has_value() || !last_rounds.has_value())
+    return std::nullopt;
+
+  // Charge as late as possible each time, so the robot leaves the loop the
+  // fewest times. Every charge after the first one starts from the same
+  // battery level, so the number of charges is closed-form.
+  const std::size_t k1 = std::min(*first_rounds, rounds);
+  const std::size_t remaining = rounds - k1;
+  std::size_t charges = 1;
+  std::size_t final_rounds = remaining;
+  if (remaining > *last_rounds)
+  {
+    const auto middle_rounds = most_rounds(after_charging, out_drain);
+    if (!middle_rounds.has_value() || *middle_rounds == 0)
+      return std::nullopt;
+
+    const std::size_t k = *middle_rounds;
+    const std::size_t middle_charges = (remaining - *last_rounds + k - 1) / k;
+    charges += middle_charges;
+    final_rounds = remaining > middle_charges * k ?
+      remaining - middle_charges * k : 0;
+  }
+
+  // Each charge tops the battery up to the recharge level. Charging time is
+  // proportional to the charge that is added.
+  const std::size_t middle_rounds_total = remaining - final_rounds;
+  const double added_soc =
+    (recharge_soc - (battery_soc - k1 * round_drain - out_drain))
+    + (charges - 1) * (recharge_soc - after_charging + out_drain)
+    + middle_rounds_total * round_drain;
+
+  const auto& battery_system = _parameters.battery_system();
+  const double time_to_charge =
+    (3600 * std::max(added_soc, 0.0) * battery_system.capacity())
+    / battery_system.charging_current();
+
+  const auto detour = to_charger->duration() + from_charger->duration();
+  return Charging{
+    charges * detour + rmf_traffic::time::from_seconds(time_to_charge),
+    after_charging - final_rounds * round_drain - _forward_battery_drain
+  };
+}
+
 //==============================================================================
 class Loop::Description::Implementation
 {
@@ -217,18 +439,21 @@ public:
   std::size_t start_waypoint;
   std::size_t finish_waypoint;
   std::size_t num_loops;
+  bool charge_between_loops = false;
 };
 
 //==============================================================================
 Task::ConstDescriptionPtr Loop::Description::make(
   std::size_t start_waypoint,
   std::size_t finish_waypoint,
-  std::size_t num_loops)
+  std::size_t num_loops,
+  bool charge_between_loops)
 {
   std::shared_ptr<Description> loop(new Description());
   loop->_pimpl->start_waypoint = start_waypoint;
   loop->_pimpl->finish_waypoint = finish_waypoint;
   loop->_pimpl->num_loops = num_loops;
+  loop->_pimpl->charge_between_loops = charge_between_loops;
 
   return loop;
 }
@@ -250,7 +475,8 @@ Task::ConstModelPtr Loop::Description::make_model(
     parameters,
     _pimpl->start_waypoint,
     _pimpl->finish_waypoint,
-    _pimpl->num_loops);
+    _pimpl->num_loops,
+    _pimpl->charge_between_loops);
 }
 
 //==============================================================================
@@ -284,6 +510,12 @@ std::size_t Loop::Description::num_loops() const
   return _pimpl->num_loops;
 }
 
+//==============================================================================
+bool Loop::Description::charge_between_loops() const
+{
+  return _pimpl->charge_between_loops;
+}
+
 //==============================================================================
 ConstRequestPtr Loop::make(
   std::size_t start_waypoint,
@@ -292,7 +524,8 @@ ConstRequestPtr Loop::make(
   const std::string& id,
   rmf_traffic::Time earliest_start_time,
   ConstPriorityPtr priority,
-  bool automatic)
+  bool automatic,
+  bool charge_between_loops)
 {
   Task::ConstBookingPtr booking =
     std::make_shared<const rmf_task::Task::Booking>(
@@ -303,7 +536,8 @@ ConstRequestPtr Loop::make(
   const auto description = Description::make(
     start_waypoint,
     finish_waypoint,
-    num_loops);
+    num_loops,
+    charge_between_loops);
   return std::make_shared<Request>(
     std::move(booking),
     std::move(description));
@@ -319,7 +553,8 @@ ConstRequestPtr Loop::make(
   const std::string& requester,
   rmf_traffic::Time request_time,
   ConstPriorityPtr priority,
-  bool automatic)
+  bool automatic,
+  bool charge_between_loops)
 {
   Task::ConstBookingPtr booking =
     std::make_shared<const rmf_task::Task::Booking>(
@@ -332,7 +567,8 @@ ConstRequestPtr Loop::make(
   const auto description = Description::make(
     start_waypoint,
     finish_waypoint,
-    num_loops);
+    num_loops,
+    charge_between_loops);
   return std::make_shared<Request>(
     std::move(booking),
     std::move(description));
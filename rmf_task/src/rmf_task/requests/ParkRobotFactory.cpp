@@ -73,6 +73,12 @@ ParkRobotFactory::ParkRobotFactory(
   // Do nothing
 }
 
+//==============================================================================
+std::optional<std::size_t> ParkRobotFactory::parking_waypoint() const
+{
+  return _pimpl->parking_waypoint;
+}
+
 //==============================================================================
 ConstRequestPtr ParkRobotFactory::make_request(const State& state) const
 {
@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <stdexcept>
+
+#include <rmf_task/requests/PooledDelivery.hpp>
+
+#include "../BatteryDrain.hpp"
+#include "../EstimateKernel.hpp"
+
+namespace rmf_task {
+namespace requests {
+
+namespace {
+//==============================================================================
+struct Stop
+{
+  std::size_t waypoint;
+  rmf_traffic::Duration wait;
+};
+
+//==============================================================================
+const Delivery::Description& get_delivery(const ConstRequestPtr& request)
+{
+  const auto* delivery = request ?
+    dynamic_cast<const Delivery::Description*>(
+    request->description().get()) : nullptr;
+
+  if (!delivery)
+  {
+    // *INDENT-OFF* (prevent uncrustify from making unnecessary indents here)
+    throw std::invalid_argument(
+      "[rmf_task::requests::PooledDelivery] Only Delivery requests can be "
+      "pooled");
+    // *INDENT-ON*
+  }
+
+  return *delivery;
+}
+} // anonymous namespace
+
+//==============================================================================
+class PooledDelivery::Model : public Task::Model
+{
+public:
+
+  std::optional<Estimate> estimate_finish(
+    const State& initial_state,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const final;
+
+  rmf_traffic::Duration invariant_duration() const final;
+
+  double min_battery_drain() const final;
+
+  ConstKernelPtr make_kernel(
+    const State& initial_state,
+    const Constraints& task_planning_constraints,
+    const TravelEstimator& travel_estimator) const final;
+
+  Model(
+    const rmf_traffic::Time earliest_start_time,
+    const Parameters& parameters,
+    const std::vector<Stop>& stops);
+
+private:
+  rmf_traffic::Time _earliest_start_time;
+  Parameters _parameters;
+  BatteryDrain _drain;
+  std::size_t _first_waypoint;
+  std::size_t _last_waypoint;
+
+  rmf_traffic::Duration _invariant_duration;
+  double _invariant_battery_drain;
+
+  FixedRequest _fixed_request() const;
+};
+
+//==============================================================================
+PooledDelivery::Model::Model(
+  const rmf_traffic::Time earliest_start_time,
+  const Parameters& parameters,
+  const std::vector<Stop>& stops)
+: _earliest_start_time(earliest_start_time),
+  _parameters(parameters),
+  _drain(parameters),
+  _first_waypoint(stops.front().waypoint),
+  _last_waypoint(stops.back().waypoint),
+  _invariant_duration(rmf_traffic::Duration(0)),
+  _invariant_battery_drain(0.0)
+{
+  // Calculate duration of invariant component of task, one leg at a time
+  std::vector<double> device_seconds;
+  auto time = _earliest_start_time;
+  for (std::size_t i = 0; i < stops.size(); ++i)
+  {
+    const auto& stop = stops[i];
+    if (i > 0 && stops[i-1].waypoint != stop.waypoint)
+    {
+      rmf_traffic::agv::Planner::Start start{time, stops[i-1].waypoint, 0.0};
+      rmf_traffic::agv::Planner::Goal goal{stop.waypoint};
+      const auto result = _parameters.planner()->plan(start, goal);
+
+      const auto& itinerary = result->get_itinerary();
+      for (const auto& route : itinerary)
+      {
+        const auto& finish_time = *route.trajectory().finish_time();
+        const auto itinerary_duration = finish_time - time;
+        device_seconds.push_back(
+          rmf_traffic::time::to_seconds(itinerary_duration));
+
+        _invariant_duration += itinerary_duration;
+        time = finish_time;
+      }
+
+      _invariant_battery_drain += _drain.motion(itinerary);
+    }
+
+    device_seconds.push_back(rmf_traffic::time::to_seconds(stop.wait));
+    _invariant_duration += stop.wait;
+    time += stop.wait;
+  }
+
+  // Compute the invariant battery drain of the devices in one batch
+  _invariant_battery_drain += _drain.ambient(device_seconds);
+}
+
+//==============================================================================
+std::optional<rmf_task::Estimate> PooledDelivery::Model::estimate_finish(
+  const State& initial_state,
+  const Constraints& task_planning_constraints,
+  const TravelEstimator& travel_estimator) const
+{
+  return estimate_fixed_request(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
+}
+
+//==============================================================================
+rmf_traffic::Duration PooledDelivery::Model::invariant_duration() const
+{
+  return _invariant_duration;
+}
+
+//==============================================================================
+double PooledDelivery::Model::min_battery_drain() const
+{
+  return _invariant_battery_drain;
+}
+
+//==============================================================================
+auto PooledDelivery::Model::make_kernel(
+  const State& initial_state,
+  const Constraints& task_planning_constraints,
+  const TravelEstimator& travel_estimator) const -> ConstKernelPtr
+{
+  return make_fixed_request_kernel(
+    _fixed_request(),
+    initial_state,
+    task_planning_constraints,
+    travel_estimator);
+}
+
+//==============================================================================
+FixedRequest PooledDelivery::Model::_fixed_request() const
+{
+  return FixedRequest{
+    _first_waypoint,
+    _last_waypoint,
+    _earliest_start_time,
+    _invariant_duration,
+    _invariant_battery_drain,
+    _drain
+  };
+}
+
+//==============================================================================
+class PooledDelivery::Description::Implementation
+{
+public:
+
+  std::vector<ConstRequestPtr> deliveries;
+
+  // Every pickup in order, followed by every dropoff in order
+  std::vector<Stop> stops;
+};
+
+//==============================================================================
+Task::ConstDescriptionPtr PooledDelivery::Description::make(
+  std::vector<ConstRequestPtr> deliveries)
+{
+  if (deliveries.empty())
+  {
+    // *INDENT-OFF* (prevent uncrustify from making unnecessary indents here)
+    throw std::invalid_argument(
+      "[rmf_task::requests::PooledDelivery] At least one delivery is needed");
+    // *INDENT-ON*
+  }
+
+  std::vector<Stop> stops;
+  stops.reserve(2 * deliveries.size());
+  for (const auto& request : deliveries)
+  {
+    const auto& delivery = get_delivery(request);
+    stops.push_back({delivery.pickup_waypoint(), delivery.pickup_wait()});
+  }
+
+  for (const auto& request : deliveries)
+  {
+    const auto& delivery = get_delivery(request);
+    stops.push_back({delivery.dropoff_waypoint(), delivery.dropoff_wait()});
+  }
+
+  std::shared_ptr<Description> pooled(new Description());
+  pooled->_pimpl = rmf_utils::make_impl<Implementation>(
+    Implementation{
+      std::move(deliveries),
+      std::move(stops)
+    });
+
+  return pooled;
+}
+
+//==============================================================================
+PooledDelivery::Description::Description()
+{
+  // Do nothing
+}
+
+//==============================================================================
+Task::ConstModelPtr PooledDelivery::Description::make_model(
+  rmf_traffic::Time earliest_start_time,
+  const Parameters& parameters) const
+{
+  return std::make_shared<PooledDelivery::Model>(
+    earliest_start_time,
+    parameters,
+    _pimpl->stops);
+}
+
+//==============================================================================
+auto PooledDelivery::Description::generate_info(
+  const State&,
+  const Parameters& parameters) const -> Info
+{
+  const auto& graph = parameters.planner()->get_configuration().graph();
+  const auto& stops = _pimpl->stops;
+  const std::size_t n = _pimpl->deliveries.size();
+  std::string category =
+    "Pooled delivery of " + std::to_string(n) + " requests";
+  std::string detail;
+  for (std::size_t i = 0; i < n; ++i)
+  {
+    if (i > 0)
+      detail += ", ";
+
+    detail += standard_waypoint_name(graph, stops[i].waypoint) + " to "
+      + standard_waypoint_name(graph, stops[n + i].waypoint);
+  }
+
+  return Info{std::move(category), std::move(detail)};
+}
+
+//==============================================================================
+const std::vector<ConstRequestPtr>&
+PooledDelivery::Description::deliveries() const
+{
+  return _pimpl->deliveries;
+}
+
+//==============================================================================
+ConstRequestPtr PooledDelivery::make(std::vector<ConstRequestPtr> deliveries)
+{
+  auto description = Description::make(deliveries);
+
+  std::string id;
+  auto earliest_start_time = rmf_traffic::Time::min();
+  ConstPriorityPtr priority;
+  bool automatic = true;
+  for (const auto& request : deliveries)
+  {
+    const auto& booking = *request->booking();
+    if (!id.empty())
+      id += "+";
+
+    id += booking.id();
+    earliest_start_time =
+      std::max(earliest_start_time, booking.earliest_start_time());
+    if (!priority)
+      priority = booking.priority();
+
+    automatic = automatic && booking.automatic();
+  }
+
+  Task::ConstBookingPtr booking =
+    std::make_shared<const rmf_task::Task::Booking>(
+    std::move(id),
+    earliest_start_time,
+    std::move(priority),
+    automatic);
+  return std::make_shared<Request>(
+    std::move(booking),
+    std::move(description));
+}
+
+} // namespace requests
+} // namespace rmf_task
@@ -17,8 +17,12 @@
 
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <sstream>
 #include <rmf_task/BackupFileManager.hpp>
 
+#include <nlohmann/json.hpp>
+
 #include "../mock/MockDelivery.hpp"
 
 #include <rmf_utils/catch.hpp>
@@ -215,3 +219,297 @@ SCENARIO("Back up to file")
   CHECK(restored_snapshot->tag()->header().detail()
     == phase_snapshot->tag()->header().detail());
 }
+
+SCENARIO("Back up to file asynchronously")
+{
+  cleanup();
+
+  rmf_task::BackupFileManager backup(backup_root_dir);
+  backup.asynchronous();
+
+  const auto robot_dir = backup_root_dir / "group" / "robot";
+  auto robot_backup = backup.make_group("group")->make_robot("robot");
+  for (std::size_t i = 1; i <= 100; ++i)
+  {
+    robot_backup->write(
+      rmf_task::detail::Backup::make(i, "state " + std::to_string(i)));
+  }
+
+  // An older backup should be ignored even while newer ones are waiting
+  robot_backup->write(rmf_task::detail::Backup::make(50, "state 50"));
+
+  backup.flush();
+  CHECK(std::filesystem::exists(robot_dir / "backup"));
+  CHECK_FALSE(std::filesystem::exists(robot_dir / ".backup"));
+
+  const auto state = robot_backup->read();
+  REQUIRE(state.has_value());
+  CHECK(*state == "state 100");
+
+  // Reading should wait for a backup that has not been written yet
+  robot_backup->write(rmf_task::detail::Backup::make(101, "state 101"));
+  CHECK(robot_backup->read() == std::optional<std::string>("state 101"));
+
+  // Backups that are still waiting should not be left behind on shutdown
+  robot_backup->write(rmf_task::detail::Backup::make(102, "state 102"));
+  robot_backup.reset();
+  CHECK_FALSE(std::filesystem::exists(robot_dir / "backup"));
+  CHECK_FALSE(std::filesystem::exists(robot_dir / ".backup"));
+}
+
+SCENARIO("Back up to file with a durability policy")
+{
+  using Durability = rmf_task::BackupFileManager::Durability;
+  using namespace std::chrono_literals;
+
+  for (const auto policy :
+    {Durability::None, Durability::EveryWrite, Durability::Periodic})
+  {
+    cleanup();
+
+    rmf_task::BackupFileManager backup(backup_root_dir);
+    backup.durability(policy, 10ms);
+
+    const auto robot_dir = backup_root_dir / "group" / "robot";
+    auto robot_backup = backup.make_group("group")->make_robot("robot");
+    for (std::size_t i = 1; i <= 10; ++i)
+    {
+      robot_backup->write(
+        rmf_task::detail::Backup::make(i, "state " + std::to_string(i)));
+      CHECK_FALSE(std::filesystem::exists(robot_dir / ".backup"));
+      CHECK(robot_backup->read() ==
+        std::optional<std::string>("state " + std::to_string(i)));
+    }
+  }
+}
+
+SCENARIO("Back up a group of robots to a journal")
+{
+  cleanup();
+
+  const auto group_dir = backup_root_dir / "group";
+  const auto journal_path = group_dir / "journal";
+  const std::string big_state(1000, 'x');
+  {
+    rmf_task::BackupFileManager backup(backup_root_dir);
+    backup.journal().clear_on_shutdown(false);
+
+    auto group_backup = backup.make_group("group");
+    CHECK(std::filesystem::exists(journal_path));
+
+    auto robot_a = group_backup->make_robot("robot_a");
+    auto robot_b = group_backup->make_robot("robot_b");
+    auto robot_c = group_backup->make_robot("robot_c");
+    CHECK_FALSE(robot_a->read().has_value());
+    CHECK_FALSE(std::filesystem::exists(group_dir / "robot_a"));
+
+    // Writing thousands of backups should compact the journal along the way
+    for (std::size_t i = 1; i <= 5000; ++i)
+    {
+      robot_a->write(rmf_task::detail::Backup::make(i, big_state));
+      robot_b->write(
+        rmf_task::detail::Backup::make(i, "b " + std::to_string(i)));
+    }
+
+    robot_c->write(rmf_task::detail::Backup::make(1, "c"));
+    CHECK(robot_a->read() == std::optional<std::string>(big_state));
+    CHECK(robot_b->read() == std::optional<std::string>("b 5000"));
+    CHECK(std::filesystem::file_size(journal_path) < 4 * 1024 * 1024);
+  }
+
+  // Simulate a backup that was torn apart by a crash
+  {
+    std::stringstream contents;
+    contents << std::ifstream(journal_path, std::ios::binary).rdbuf();
+    const auto end = contents.str().find_last_not_of('\0') + 1;
+
+    // Records are padded to 8 bytes, so this is where the next one would go
+    std::fstream journal(
+      journal_path, std::ios::in | std::ios::out | std::ios::binary);
+    journal.seekp(static_cast<std::streamoff>((end + 7) / 8 * 8));
+    const uint32_t record_magic = 0x524A4D52;
+    journal.write(
+      reinterpret_cast<const char*>(&record_magic), sizeof(record_magic));
+    journal << "torn";
+  }
+
+  rmf_task::BackupFileManager restore(backup_root_dir);
+  restore.journal();
+  auto group_restore = restore.make_group("group");
+  auto robot_a = group_restore->make_robot("robot_a");
+  auto robot_b = group_restore->make_robot("robot_b");
+  CHECK(robot_a->read() == std::optional<std::string>(big_state));
+  CHECK(robot_b->read() == std::optional<std::string>("b 5000"));
+
+  // The journal should still accept backups after recovering from the crash
+  robot_b->write(rmf_task::detail::Backup::make(1, "b restored"));
+  CHECK(robot_b->read() == std::optional<std::string>("b restored"));
+
+  // Clearing on shutdown should remove the backup of a robot from the journal
+  robot_a.reset();
+  CHECK_FALSE(group_restore->make_robot("robot_a")->read().has_value());
+
+  auto robot_c = group_restore->make_robot("robot_c");
+  CHECK(robot_c->read() == std::optional<std::string>("c"));
+}
+
+SCENARIO("Back up delta backups")
+{
+  using Backup = rmf_task::detail::Backup;
+
+  const nlohmann::json base = {
+    {"phase", 1},
+    {"event", {{"index", 0}, {"state", {{"progress", 0}}}}}
+  };
+
+  const auto state_at = [&](std::size_t progress)
+    {
+      auto state = base;
+      state["event"]["state"]["progress"] = progress;
+      return state;
+    };
+
+  const auto delta_at = [&](uint64_t seq, std::size_t progress)
+    {
+      return Backup::make_delta(
+        seq, 1, nlohmann::json::diff(base, state_at(progress)).dump());
+    };
+
+  for (const bool use_journal : {false, true})
+  {
+    cleanup();
+
+    rmf_task::BackupFileManager backup(backup_root_dir);
+    backup.journal(use_journal).clear_on_shutdown(false);
+    auto robot_backup = backup.make_group("group")->make_robot("robot");
+
+    // A delta without its full backup cannot be used
+    robot_backup->write(delta_at(0, 1));
+    CHECK_FALSE(robot_backup->read().has_value());
+
+    // Enough deltas to make the journal compact them into the full backup
+    const std::size_t count = use_journal ? 20000 : 100;
+    robot_backup->write(Backup::make(1, base.dump()));
+    for (std::size_t i = 1; i <= count; ++i)
+      robot_backup->write(delta_at(i + 1, i));
+
+    REQUIRE(robot_backup->read().has_value());
+    CHECK(nlohmann::json::parse(*robot_backup->read()) == state_at(count));
+
+    // A delta for a full backup that was replaced is ignored
+    robot_backup->write(Backup::make(count + 2, state_at(0).dump()));
+    robot_backup->write(delta_at(count + 3, 1));
+    CHECK(nlohmann::json::parse(*robot_backup->read()) == state_at(0));
+
+    if (use_journal)
+    {
+      robot_backup.reset();
+
+      // Recovering the journal should apply the latest delta too
+      rmf_task::BackupFileManager restore(backup_root_dir);
+      restore.journal().clear_on_shutdown(false);
+      auto robot_restore = restore.make_group("group")->make_robot("robot");
+      robot_restore->write(Backup::make(1, base.dump()));
+      robot_restore->write(delta_at(2, 42));
+      robot_restore.reset();
+
+      rmf_task::BackupFileManager reopen(backup_root_dir);
+      reopen.journal().clear_on_shutdown(false);
+      auto robot_reopen = reopen.make_group("group")->make_robot("robot");
+      REQUIRE(robot_reopen->read().has_value());
+      CHECK(nlohmann::json::parse(*robot_reopen->read()) == state_at(42));
+    }
+  }
+}
+
+SCENARIO("Restore every robot of a group at once")
+{
+  cleanup();
+
+  for (const bool journal : {false, true})
+  {
+    {
+      rmf_task::BackupFileManager backup(backup_root_dir);
+      backup.journal(journal).clear_on_shutdown(false);
+      auto group = backup.make_group("group");
+      std::vector<std::shared_ptr<rmf_task::BackupFileManager::Robot>> robots;
+      for (std::size_t i = 0; i < 20; ++i)
+      {
+        robots.push_back(group->make_robot("robot_" + std::to_string(i)));
+        if (i % 4 != 0)
+        {
+          robots.back()->write(
+            rmf_task::detail::Backup::make(1, std::to_string(i)));
+        }
+      }
+    }
+
+    rmf_task::BackupFileManager restore(backup_root_dir);
+    restore.journal(journal).clear_on_shutdown(false);
+    const auto group = restore.make_group("group");
+
+    const auto backups = group->restore_all();
+    CHECK(backups.size() == 15);
+    CHECK(backups.count("robot_0") == 0);
+    REQUIRE(backups.count("robot_7") == 1);
+    CHECK(backups.at("robot_7") == "7");
+    CHECK(group->make_robot("robot_7")->read() == backups.at("robot_7"));
+
+    const auto decoded = group->restore_all(
+      [](const std::string& robot, std::string backup)
+      {
+        return robot + ": " + std::to_string(std::stoi(backup) * 2);
+      });
+    CHECK(decoded.size() == 15);
+    CHECK(decoded.at("robot_7") == "robot_7: 14");
+
+    CHECK_THROWS(group->restore_all(
+        [](const std::string&, std::string) -> int
+        {
+          throw std::runtime_error("Cannot decode");
+        }));
+
+    cleanup();
+  }
+}
+
+SCENARIO("Back up compressed backups")
+{
+  using Backup = rmf_task::detail::Backup;
+  cleanup();
+
+  std::string big_state;
+  for (std::size_t i = 0; i < 1000; ++i)
+    big_state += "{\"phase\": " + std::to_string(i % 10) + ", \"log\": []}";
+
+  const bool supported = rmf_task::BackupFileManager::compression_supported();
+  for (const bool journal : {false, true})
+  {
+    {
+      rmf_task::BackupFileManager backup(backup_root_dir);
+      backup.journal(journal).compression().clear_on_shutdown(false);
+      auto robot = backup.make_group("group")->make_robot("robot");
+      robot->write(Backup::make(1, big_state));
+      robot->write(Backup::make(2, "tiny"));
+      CHECK(robot->read() == std::optional<std::string>("tiny"));
+      robot->write(Backup::make(3, big_state));
+      CHECK(robot->read() == std::optional<std::string>(big_state));
+
+      if (supported && !journal)
+      {
+        const auto file = backup_root_dir / "group" / "robot" / "backup";
+        CHECK(std::filesystem::file_size(file) < big_state.size() / 10);
+      }
+    }
+
+    // A manager that does not compress can still read compressed backups
+    rmf_task::BackupFileManager restore(backup_root_dir);
+    restore.journal(journal);
+    auto group = restore.make_group("group");
+    CHECK(group->restore_all().at("robot") == big_state);
+    CHECK(group->make_robot("robot")->read() ==
+      std::optional<std::string>(big_state));
+
+    cleanup();
+  }
+}
@@ -15,8 +15,10 @@
  *
 */
 
+#include <array>
 #include <chrono>
 #include <memory>
+#include <string>
 
 #include <rmf_task/State.hpp>
 
@@ -71,4 +73,47 @@ SCENARIO("Robot States")
         0,
         0.0 - 1e-4));
   }
+
+  WHEN("Built-in and custom components are mixed")
+  {
+    RMF_TASK_DEFINE_COMPONENT(std::string, Label);
+
+    rmf_task::State state;
+    state.load_basic(basic_start, 3, 0.5);
+    CHECK_FALSE(state.get<Label>());
+    state.with<Label>(std::string("cart"));
+
+    auto copy = state;
+    copy.waypoint(7);
+    copy.get<Label>()->value = "trolley";
+    CHECK(state.waypoint() == 0);
+    CHECK(copy.waypoint() == 7);
+    CHECK(state.get<Label>()->value == "cart");
+    CHECK(copy.dedicated_charging_waypoint() == 3);
+    CHECK(copy.battery_soc() == 0.5);
+
+    CHECK_FALSE(copy.insert(rmf_task::State::CurrentWaypoint(9)).inserted);
+    CHECK(copy.waypoint() == 7);
+    CHECK(copy.erase<rmf_task::State::CurrentOrientation>());
+    CHECK_FALSE(copy.erase<rmf_task::State::CurrentOrientation>());
+    CHECK_FALSE(copy.orientation().has_value());
+    CHECK(state.orientation().has_value());
+
+    // Components too large for the inline buffer of the holder
+    using Labels = std::array<std::string, 4>;
+    RMF_TASK_DEFINE_COMPONENT(Labels, AllLabels);
+    copy.with<AllLabels>(Labels{"a", "b", "c", "d"});
+    auto other = copy;
+    other.get<AllLabels>()->value[0] = "z";
+    CHECK(copy.get<AllLabels>()->value[0] == "a");
+    CHECK(other.erase<AllLabels>());
+    CHECK_FALSE(other.get<AllLabels>());
+    CHECK(other.get<Label>()->value == "trolley");
+
+    copy.clear();
+    CHECK_FALSE(copy.waypoint().has_value());
+    CHECK_FALSE(copy.get<Label>());
+    CHECK_FALSE(copy.get<AllLabels>());
+    CHECK(state.time() == basic_start.time());
+  }
 }
@@ -16,17 +16,21 @@
 */
 
 #include <rmf_task/TaskPlanner.hpp>
+#include <rmf_task/MultiFleetPlanner.hpp>
+#include <rmf_task/Estimate.hpp>
 #include <rmf_task/State.hpp>
 #include <rmf_task/Constraints.hpp>
 #include <rmf_task/Parameters.hpp>
 #include <rmf_task/requests/Delivery.hpp>
 #include <rmf_task/requests/ChargeBattery.hpp>
 #include <rmf_task/requests/Loop.hpp>
+#include <rmf_task/requests/PooledDelivery.hpp>
 
 #include <rmf_task/requests/ChargeBatteryFactory.hpp>
 #include <rmf_task/requests/ParkRobotFactory.hpp>
 
 #include <rmf_task/BinaryPriorityScheme.hpp>
+#include <rmf_task/MultiLevelPriorityScheme.hpp>
 
 #include <rmf_traffic/agv/Graph.hpp>
 #include <rmf_traffic/Trajectory.hpp>
@@ -44,7 +48,17 @@
 
 #include <rmf_utils/catch.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
 #include <iostream>
+#include <map>
+#include <memory_resource>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <utility>
 
 using TaskPlanner = rmf_task::TaskPlanner;
 
@@ -133,6 +147,34 @@ inline void display_solution(
   std::cout << " ----------------------" << std::endl;
 }
 
+//==============================================================================
+// Counts what is allocated from it, and takes the memory from the global heap
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+  std::atomic_size_t allocations = 0;
+  std::atomic_size_t deallocations = 0;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) final
+  {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) final
+  {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+  noexcept final
+  {
+    return this == &other;
+  }
+};
+
 //==============================================================================
 SCENARIO("Grid World")
 {
@@ -318,6 +360,240 @@ SCENARIO("Grid World")
     }
 
     REQUIRE(optimal_cost <= greedy_cost);
+    CHECK_FALSE(task_planner.statistics().interrupted());
+    CHECK(task_planner.statistics().suboptimality_bound() == Approx(1.0));
+
+    // The search statistics describe the plan that was just found
+    const auto& search = task_planner.statistics();
+    CHECK(search.segments() >= 1);
+    CHECK(search.nodes_expanded() > 0);
+    CHECK(search.peak_open_nodes() > 0);
+
+    // The greedy incumbent keeps the children that cannot beat it out of the
+    // open list
+    CHECK(search.nodes_bounded() > 0);
+    CHECK(search.finish_estimates() >=
+      requests.size() * initial_states.size());
+    CHECK(search.search_time() > rmf_traffic::Duration(0));
+    CHECK(search.infeasible_requests().empty());
+
+    // The phases never overlap, even where the candidates of a later segment
+    // are estimated while a segment is being finished
+    CHECK(search.initialization_time() + search.search_time()
+      + search.finishing_time() <= finish_time - start_time);
+
+    // A new planner starts with a cold travel estimator
+    const auto cold = task_planner.statistics().travel_estimates();
+    CHECK(cold.misses() > 0);
+    CHECK(cold.total_miss_latency() > rmf_traffic::Duration(0));
+    CHECK(cold.p99_miss_latency() > rmf_traffic::Duration(0));
+    CHECK(cold.entries() == cold.misses());
+
+    // Planning the same problem again should find every trip in the cache
+    task_planner.plan(now, initial_states, requests);
+    const auto warm = task_planner.statistics().travel_estimates();
+    CHECK(warm.misses() == 0);
+    CHECK(warm.hits() > 0);
+    CHECK(warm.total_miss_latency() == rmf_traffic::Duration(0));
+
+    // Profiled estimates are grouped by the type of their model, and every
+    // finish estimate is profiled
+    CHECK(task_planner.statistics().estimate_profiles().empty());
+    auto profiled_options = default_options;
+    profiled_options.profile_estimates(true);
+    task_planner.plan(now, initial_states, requests, profiled_options);
+    const auto& profiled = task_planner.statistics();
+    REQUIRE_FALSE(profiled.estimate_profiles().empty());
+    CHECK_FALSE(profiled.cached());
+    std::size_t profiled_calls = 0;
+    bool found_delivery = false;
+    for (const auto& profile : profiled.estimate_profiles())
+    {
+      profiled_calls += profile.calls();
+      found_delivery = found_delivery
+        || profile.type().find("Delivery") != std::string::npos;
+
+      std::size_t histogram_calls = 0;
+      for (const auto n : profile.histogram())
+        histogram_calls += n;
+      CHECK(histogram_calls == profile.calls());
+      CHECK(profile.percentile(0.5) <= profile.percentile(0.99));
+      CHECK(profile.percentile(1.0) <= profile.bucket_limit(
+          profile.histogram().size() - 1));
+    }
+    CHECK(found_delivery);
+    CHECK(profiled_calls == profiled.finish_estimates());
+
+    // The parallel best-first solver should also find an optimal plan
+    task_planner = TaskPlanner(task_config, default_options);
+    auto parallel_options = default_options;
+    parallel_options.search_threads(4);
+    const auto parallel_result = task_planner.plan(
+      now, initial_states, requests, parallel_options);
+    const auto parallel_assignments = std::get_if<
+      TaskPlanner::Assignments>(&parallel_result);
+    REQUIRE(parallel_assignments);
+    CHECK_TIMES(*parallel_assignments, now);
+    CHECK(task_planner.compute_cost(*parallel_assignments)
+      == Approx(optimal_cost));
+    CHECK_FALSE(task_planner.statistics().interrupted());
+    CHECK(task_planner.statistics().suboptimality_bound() == Approx(1.0));
+
+    // Several threads may plan with the same planner at once
+    std::vector<double> concurrent_costs(4, 0.0);
+    std::vector<std::thread> planning_threads;
+    for (std::size_t i = 0; i < concurrent_costs.size(); ++i)
+    {
+      planning_threads.emplace_back(
+        [&, i]()
+        {
+          const auto result = task_planner.plan(
+            now, initial_states, requests);
+          if (const auto a = std::get_if<TaskPlanner::Assignments>(&result))
+            concurrent_costs[i] = task_planner.compute_cost(*a);
+        });
+    }
+
+    for (auto& thread : planning_threads)
+      thread.join();
+
+    for (const double cost : concurrent_costs)
+      CHECK(cost == Approx(optimal_cost));
+
+    // The anytime planner should report improving solutions and finish with
+    // a proven optimal one
+    std::vector<double> reported_costs;
+    double reported_lower_bound = 0.0;
+    auto anytime_options = default_options;
+    anytime_options.anytime(true).improvement_callback(
+      [&](const TaskPlanner::Assignments&, double cost, double lower_bound)
+      {
+        reported_costs.push_back(cost);
+        reported_lower_bound = lower_bound;
+      });
+    const auto anytime_result = task_planner.plan(
+      now, initial_states, requests, anytime_options);
+    const auto anytime_assignments = std::get_if<
+      TaskPlanner::Assignments>(&anytime_result);
+    REQUIRE(anytime_assignments);
+    CHECK_TIMES(*anytime_assignments, now);
+    CHECK(task_planner.compute_cost(*anytime_assignments)
+      == Approx(optimal_cost));
+    REQUIRE_FALSE(reported_costs.empty());
+    CHECK(reported_costs.front() == Approx(greedy_cost));
+    for (std::size_t i = 1; i < reported_costs.size(); ++i)
+      CHECK(reported_costs[i] <= reported_costs[i-1]);
+    CHECK(reported_lower_bound == Approx(optimal_cost));
+    CHECK_FALSE(task_planner.statistics().interrupted());
+    CHECK(task_planner.statistics().suboptimality_bound() == Approx(1.0));
+
+    // Randomized greedy restarts are never worse than the greedy solution,
+    // and a seed makes them repeatable on any number of threads
+    {
+      auto restart_options = greedy_options;
+      restart_options.greedy_restarts(8, 0.5).deterministic_seed(7);
+      std::optional<double> restart_cost;
+      for (const std::size_t threads : {1, 4})
+      {
+        restart_options.expansion_threads(threads);
+        const auto result = task_planner.plan(
+          now, initial_states, requests, restart_options);
+        const auto assignments =
+          std::get_if<TaskPlanner::Assignments>(&result);
+        REQUIRE(assignments);
+        CHECK_TIMES(*assignments, now);
+
+        const double cost = task_planner.compute_cost(*assignments);
+        CHECK(cost <= greedy_cost + 1e-6);
+        CHECK(optimal_cost <= cost + 1e-6);
+        if (restart_cost.has_value())
+          CHECK(cost == Approx(*restart_cost));
+
+        restart_cost = cost;
+      }
+    }
+
+    // A session that receives the same problem incrementally should find the
+    // same optimal plan as planning from scratch
+    auto session = task_planner.start_session(
+      initial_states, {requests[0], requests[1]});
+    session.add_request(requests[2]);
+    const auto session_result = session.replan(now);
+    const auto session_assignments = std::get_if<
+      TaskPlanner::Assignments>(&session_result);
+    REQUIRE(session_assignments);
+    CHECK_TIMES(*session_assignments, now);
+    CHECK(task_planner.compute_cost(*session_assignments)
+      == Approx(optimal_cost));
+
+    session.update_agent(1, initial_states[1]);
+    const auto updated_result = session.replan(now);
+    const auto updated_assignments = std::get_if<
+      TaskPlanner::Assignments>(&updated_result);
+    REQUIRE(updated_assignments);
+    CHECK(task_planner.compute_cost(*updated_assignments)
+      == Approx(optimal_cost));
+
+    CHECK_FALSE(session.cancel_request("unknown"));
+    REQUIRE(session.cancel_request("3"));
+    REQUIRE(session.requests().size() == 2);
+    const auto cancelled_result = session.replan(now);
+    const auto cancelled_assignments = std::get_if<
+      TaskPlanner::Assignments>(&cancelled_result);
+    REQUIRE(cancelled_assignments);
+
+    const auto fresh_result = TaskPlanner(task_config, default_options).plan(
+      now, initial_states, {requests[0], requests[1]});
+    const auto fresh_assignments = std::get_if<
+      TaskPlanner::Assignments>(&fresh_result);
+    REQUIRE(fresh_assignments);
+    CHECK(task_planner.compute_cost(*cancelled_assignments)
+      == Approx(task_planner.compute_cost(*fresh_assignments)));
+
+    CHECK_THROWS_AS(
+      session.update_agent(2, initial_states[0]), std::out_of_range);
+
+    // Estimates that were prepared in the background for the same time do
+    // not need to be estimated again when replanning
+    auto unprepared = task_planner.start_session(initial_states, requests);
+    const auto unprepared_result = unprepared.replan(now);
+    REQUIRE(std::get_if<TaskPlanner::Assignments>(&unprepared_result));
+
+    auto prepared = task_planner.start_session(initial_states, {});
+    prepared.prepare_in_background([&]() { return now; });
+    for (const auto& request : requests)
+      prepared.add_request(request);
+    prepared.update_agent(0, initial_states[0]);
+    const auto prepared_result = prepared.replan(now);
+    const auto prepared_assignments = std::get_if<
+      TaskPlanner::Assignments>(&prepared_result);
+    REQUIRE(prepared_assignments);
+    CHECK(task_planner.compute_cost(*prepared_assignments)
+      == Approx(optimal_cost));
+    CHECK(prepared.statistics().finish_estimates()
+      + requests.size() * initial_states.size()
+      <= unprepared.statistics().finish_estimates());
+
+    // Bidding on the third request with the plan of the other two can never
+    // beat planning all three together, and the bid must add up
+    const auto insertion = task_planner.evaluate_insertion(
+      now, initial_states, *fresh_assignments, requests[2]);
+    REQUIRE(insertion.has_value());
+    const double inserted_cost =
+      task_planner.compute_cost(insertion->assignments);
+    CHECK(inserted_cost >= optimal_cost - 1e-6);
+    CHECK(insertion->cost_delta == Approx(
+        inserted_cost - task_planner.compute_cost(*fresh_assignments)));
+
+    const auto& agent = insertion->assignments[insertion->agent];
+    REQUIRE(insertion->position < agent.size());
+    CHECK(agent[insertion->position].request()->booking()->id() == "3");
+    CHECK_TIMES(insertion->assignments, now);
+
+    CHECK_THROWS_AS(
+      task_planner.evaluate_insertion(
+        now, {initial_states[0]}, *fresh_assignments, requests[2]),
+      std::invalid_argument);
   }
 
   WHEN("Planning for 11 requests and 2 agents")
@@ -475,6 +751,204 @@ SCENARIO("Grid World")
     }
 
     REQUIRE(optimal_cost <= greedy_cost);
+
+    // Expanding nodes in parallel should not change the solution
+    task_planner = TaskPlanner(task_config, default_options);
+    auto parallel_options = default_options;
+    parallel_options.expansion_threads(4);
+    const auto parallel_result = task_planner.plan(
+      now, initial_states, requests, parallel_options);
+    const auto parallel_assignments = std::get_if<
+      TaskPlanner::Assignments>(&parallel_result);
+    REQUIRE(parallel_assignments);
+    CHECK_TIMES(*parallel_assignments, now);
+    CHECK(task_planner.compute_cost(*parallel_assignments)
+      == Approx(optimal_cost));
+    REQUIRE(parallel_assignments->size() == optimal_assignments->size());
+    for (std::size_t i = 0; i < optimal_assignments->size(); ++i)
+    {
+      const auto& parallel_agent = (*parallel_assignments)[i];
+      const auto& optimal_agent = (*optimal_assignments)[i];
+      REQUIRE(parallel_agent.size() == optimal_agent.size());
+      for (std::size_t j = 0; j < optimal_agent.size(); ++j)
+      {
+        // Automatic charging requests get a fresh id in every plan
+        if (parallel_agent[j].request()->booking()->automatic())
+        {
+          CHECK(optimal_agent[j].request()->booking()->automatic());
+          continue;
+        }
+
+        CHECK(parallel_agent[j].request()->booking()->id()
+          == optimal_agent[j].request()->booking()->id());
+      }
+    }
+
+    // Pinning the planner and reserving its arena should not change the
+    // solution either
+    auto pinned_options = parallel_options;
+    pinned_options.cpu_affinity({0}).arena_reserve(1 << 20);
+    const auto pinned_result = task_planner.plan(
+      now, initial_states, requests, pinned_options);
+    const auto pinned_assignments = std::get_if<
+      TaskPlanner::Assignments>(&pinned_result);
+    REQUIRE(pinned_assignments);
+    CHECK(task_planner.compute_cost(*pinned_assignments)
+      == Approx(optimal_cost));
+
+    // Nodes that come from a memory resource of the caller should not affect
+    // the solution either
+    CountingResource counting;
+    auto resource_options = default_options;
+    resource_options.memory_resource(&counting);
+    const auto resource_result = task_planner.plan(
+      now, initial_states, requests, resource_options);
+    const auto resource_assignments = std::get_if<
+      TaskPlanner::Assignments>(&resource_result);
+    REQUIRE(resource_assignments);
+    CHECK(task_planner.compute_cost(*resource_assignments)
+      == Approx(optimal_cost));
+
+    // The nodes really did come from the resource, and were all given back
+    CHECK(counting.allocations > 0);
+    CHECK(counting.allocations == counting.deallocations);
+
+    // A node budget that is never reached should not affect the solution
+    auto bounded_options = default_options;
+    bounded_options.max_open_nodes(1000000);
+    const auto bounded_result = task_planner.plan(
+      now, initial_states, requests, bounded_options);
+    const auto bounded_assignments = std::get_if<
+      TaskPlanner::Assignments>(&bounded_result);
+    REQUIRE(bounded_assignments);
+    CHECK(task_planner.compute_cost(*bounded_assignments)
+      == Approx(optimal_cost));
+    CHECK_FALSE(task_planner.statistics().pruned());
+
+    // The problem is big enough that the tight budget below has to be
+    // enforced
+    const std::size_t tight_budget = 8;
+    REQUIRE(task_planner.statistics().peak_open_nodes() > tight_budget);
+
+    // A tight node budget may lose optimality, but it must say so
+    bounded_options.max_open_nodes(tight_budget);
+    const auto tight_result = task_planner.plan(
+      now, initial_states, requests, bounded_options);
+    const auto tight_assignments = std::get_if<
+      TaskPlanner::Assignments>(&tight_result);
+    REQUIRE(tight_assignments);
+    CHECK(task_planner.statistics().peak_open_nodes() <= tight_budget);
+    if (!tight_assignments->empty())
+    {
+      const double tight_cost = task_planner.compute_cost(*tight_assignments);
+      CHECK(tight_cost >= optimal_cost - 1e-6);
+      if (tight_cost > optimal_cost + 1e-6)
+      {
+        CHECK(task_planner.statistics().pruned());
+        CHECK(task_planner.statistics().suboptimality_bound() > 1.0);
+      }
+    }
+
+    // Local search may only improve on the greedy plan, and it can never do
+    // better than the optimal plan
+    for (const std::size_t threads : {1, 4})
+    {
+      auto local_options = greedy_options;
+      local_options
+      .local_search_budget(rmf_traffic::time::from_seconds(10.0))
+      .expansion_threads(threads);
+      const auto local_result = task_planner.plan(
+        now, initial_states, requests, local_options);
+      const auto local_assignments = std::get_if<
+        TaskPlanner::Assignments>(&local_result);
+      REQUIRE(local_assignments);
+      CHECK_TIMES(*local_assignments, now);
+      const double local_cost = task_planner.compute_cost(*local_assignments);
+      CHECK(local_cost <= greedy_cost + 1e-6);
+      CHECK(local_cost >= optimal_cost - 1e-6);
+
+      std::size_t planned = 0;
+      for (const auto& agent : *local_assignments)
+      {
+        for (const auto& assignment : agent)
+        {
+          if (!assignment.request()->booking()->automatic())
+            ++planned;
+        }
+      }
+      CHECK(planned == requests.size());
+    }
+
+    // The large neighborhood search only keeps plans that are cheaper than
+    // the greedy one, and it plans every request. Local search makes the
+    // repairs finalize their own charges, which must not take the ids of the
+    // charges that were kept.
+    for (const std::size_t parallel : {1, 3})
+    {
+      auto neighborhood_options = default_options;
+      neighborhood_options
+      .neighborhood_search(rmf_traffic::time::from_seconds(0.5), 4, parallel)
+      .local_search_budget(rmf_traffic::time::from_seconds(0.01))
+      .deterministic_seed(3);
+      const auto neighborhood_result = task_planner.plan(
+        now, initial_states, requests, neighborhood_options);
+      const auto neighborhood_assignments = std::get_if<
+        TaskPlanner::Assignments>(&neighborhood_result);
+      REQUIRE(neighborhood_assignments);
+      CHECK_TIMES(*neighborhood_assignments, now);
+      const double neighborhood_cost =
+        task_planner.compute_cost(*neighborhood_assignments);
+      CHECK(neighborhood_cost <= greedy_cost + 1e-6);
+      CHECK(neighborhood_cost >= optimal_cost - 1e-6);
+
+      std::size_t planned = 0;
+      std::set<std::string> ids;
+      std::size_t assignments = 0;
+      for (const auto& agent : *neighborhood_assignments)
+      {
+        for (const auto& assignment : agent)
+        {
+          if (!assignment.request()->booking()->automatic())
+            ++planned;
+
+          ids.insert(assignment.request()->booking()->id());
+          ++assignments;
+        }
+      }
+      CHECK(planned == requests.size());
+      CHECK(ids.size() == assignments);
+    }
+
+    // With nothing to tear out, the search stops long before its budget
+    auto empty_options = default_options;
+    empty_options.neighborhood_search(rmf_traffic::time::from_seconds(30.0));
+    const std::vector<rmf_task::ConstRequestPtr> no_requests;
+    const auto empty_start = std::chrono::steady_clock::now();
+    const auto empty_result = task_planner.plan(
+      now, initial_states, no_requests, empty_options);
+    REQUIRE(std::get_if<TaskPlanner::Assignments>(&empty_result));
+    CHECK(std::chrono::steady_clock::now() - empty_start
+      < std::chrono::seconds(10));
+
+    // The stronger heuristic is still a lower bound, so the plan stays optimal
+    auto bound_config = task_config;
+    bound_config.cost_calculator(
+      rmf_task::BinaryPriorityScheme::make_cost_calculator(0.0, true));
+    TaskPlanner bound_planner(bound_config, default_options);
+    const auto bound_result = bound_planner.plan(
+      now, initial_states, requests);
+    const auto bound_assignments = std::get_if<
+      TaskPlanner::Assignments>(&bound_result);
+    REQUIRE(bound_assignments);
+    CHECK_TIMES(*bound_assignments, now);
+    CHECK(bound_planner.compute_cost(*bound_assignments)
+      == Approx(optimal_cost));
+
+    if (display_solutions)
+    {
+      std::cout << "Nodes expanded with the assignment bound: "
+                << bound_planner.statistics().nodes_expanded() << std::endl;
+    }
   }
 
   WHEN("Initial charge is low")
@@ -580,6 +1054,137 @@ SCENARIO("Grid World")
     implicit_charging_task_added = check_implicit_charging_task_start(
       *optimal_assignments, initial_soc);
     CHECK(implicit_charging_task_added);
+
+    // Charges are only inserted in front of the tasks that need them, so a
+    // plan never charges twice in a row or lets the battery run below its
+    // threshold
+    for (const auto* assignments : {greedy_assignments, optimal_assignments})
+    {
+      for (const auto& agent : *assignments)
+      {
+        for (std::size_t i = 0; i < agent.size(); ++i)
+        {
+          CHECK(agent[i].finish_state().battery_soc().value() > 0.2);
+          if (i > 0)
+            CHECK_FALSE(agent[i-1].is_charging() && agent[i].is_charging());
+
+          // The planner only makes full charging requests for the charges
+          // that it returns
+          if (agent[i].is_charging())
+          {
+            CHECK(agent[i].request()->booking()->requester() == "task_planner");
+            CHECK(agent[i].request()->booking()->request_time() == now);
+          }
+        }
+      }
+    }
+
+    // The greedy solver that assigns the earliest finish at each step also
+    // charges when it has to, and never beats the optimal plan
+    auto earliest_options = greedy_options;
+    earliest_options.greedy_by_finish_time(true);
+    const auto earliest_result = task_planner.plan(
+      now, initial_states, requests, earliest_options);
+    const auto earliest_assignments = std::get_if<
+      TaskPlanner::Assignments>(&earliest_result);
+    REQUIRE(earliest_assignments);
+    CHECK_TIMES(*earliest_assignments, now);
+    CHECK(optimal_cost <= task_planner.compute_cost(*earliest_assignments));
+    CHECK(check_implicit_charging_task_start(
+        *earliest_assignments, initial_soc));
+
+    std::size_t earliest_requests = 0;
+    for (const auto& agent : *earliest_assignments)
+    {
+      for (const auto& assignment : agent)
+      {
+        CHECK(assignment.finish_state().battery_soc().value() > 0.2);
+        if (!assignment.is_charging())
+          ++earliest_requests;
+      }
+    }
+    CHECK(earliest_requests == requests.size());
+
+    // Deterministic plans from planners that were given the same calls agree
+    // on everything, including the ids of the charges that they insert, even
+    // when several workers search at once
+    auto deterministic_options = default_options;
+    deterministic_options.deterministic_seed(42).search_threads(4);
+    std::optional<TaskPlanner::Assignments> first_plan;
+    for (std::size_t attempt = 0; attempt < 3; ++attempt)
+    {
+      TaskPlanner deterministic_planner(task_config, default_options);
+      const auto result = deterministic_planner.plan(
+        now, initial_states, requests, deterministic_options);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      CHECK(task_planner.compute_cost(*assignments) == Approx(optimal_cost));
+      if (!first_plan.has_value())
+      {
+        first_plan = *assignments;
+        continue;
+      }
+
+      REQUIRE(assignments->size() == first_plan->size());
+      for (std::size_t i = 0; i < assignments->size(); ++i)
+      {
+        const auto& agent = (*assignments)[i];
+        const auto& first_agent = (*first_plan)[i];
+        REQUIRE(agent.size() == first_agent.size());
+        for (std::size_t j = 0; j < agent.size(); ++j)
+        {
+          CHECK(agent[j].request()->booking()->id()
+            == first_agent[j].request()->booking()->id());
+          CHECK(agent[j].deployment_time() == first_agent[j].deployment_time());
+        }
+      }
+    }
+
+    // The charges of later plans from the same planner get new ids, so they
+    // cannot be mistaken for the charges of plans that were already given out
+    const auto collect_charge_ids = [](const TaskPlanner::Result& result)
+      {
+        std::set<std::string> ids;
+        const auto* assignments =
+          std::get_if<TaskPlanner::Assignments>(&result);
+        REQUIRE(assignments);
+        for (const auto& agent : *assignments)
+        {
+          for (const auto& assignment : agent)
+          {
+            if (assignment.is_charging())
+              ids.insert(assignment.request()->booking()->id());
+          }
+        }
+
+        return ids;
+      };
+
+    TaskPlanner seeded_planner(task_config, default_options);
+    const auto first_ids = collect_charge_ids(seeded_planner.plan(
+        now, initial_states, requests, deterministic_options));
+    const auto second_ids = collect_charge_ids(seeded_planner.plan(
+        now, initial_states, requests, deterministic_options));
+    REQUIRE_FALSE(first_ids.empty());
+    for (const auto& id : second_ids)
+      CHECK(first_ids.count(id) == 0);
+
+    // The battery drain that the planner uses to skip estimates is a lower
+    // bound on the drain that the estimates find
+    const rmf_task::TravelEstimator travel_estimator(parameters);
+    for (const auto& request : requests)
+    {
+      const auto model = request->description()->make_model(
+        request->booking()->earliest_start_time(), parameters);
+      const double bound = model->min_battery_drain();
+      CHECK(bound > 0.0);
+
+      const auto full = model->estimate_finish(
+        rmf_task::State().load_basic(first_location, 13, 1.0),
+        constraints, travel_estimator);
+      REQUIRE(full.has_value());
+      CHECK(1.0 - full->finish_state().battery_soc().value() >= bound);
+    }
   }
 
   WHEN("Planning for 11 requests and 2 agents no.2")
@@ -785,6 +1390,149 @@ SCENARIO("Grid World")
     CHECK(*error == TaskPlanner::TaskPlannerError::limited_capacity);
   }
 
+  WHEN("A long loop request may charge between its loops")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0)
+    };
+
+    const auto make_loop = [&](std::size_t num_loops, const std::string& id)
+      {
+        return rmf_task::requests::Loop::make(
+          0, 15, num_loops, id, now, nullptr, false, true);
+      };
+
+    // The flag is passed on to the description of the request
+    const auto description = std::dynamic_pointer_cast<
+      const rmf_task::requests::Loop::Description>(
+      make_loop(1000, "Loop1")->description());
+    REQUIRE(description);
+    CHECK(description->charge_between_loops());
+
+    std::optional<rmf_traffic::Time> previous_finish;
+    for (const std::size_t num_loops : {1000, 2000})
+    {
+      std::vector<rmf_task::ConstRequestPtr> requests =
+      {
+        make_loop(num_loops, "Loop1")
+      };
+
+      TaskPlanner task_planner(task_config, default_options);
+      const auto result = task_planner.plan(now, initial_states, requests);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      REQUIRE(assignments->size() == 1);
+
+      const auto loop = std::find_if(
+        assignments->front().begin(), assignments->front().end(),
+        [](const auto& a) { return a.request()->booking()->id() == "Loop1"; });
+      REQUIRE(loop != assignments->front().end());
+
+      // The robot must never be planned to drop below its threshold
+      const auto& finish = loop->finish_state();
+      CHECK(finish.battery_soc().value() > 0.2);
+      CHECK(finish.waypoint().value() == 15);
+
+      // Twice the loops need more charging, so they finish later
+      if (previous_finish.has_value())
+        CHECK(*previous_finish < finish.time().value());
+
+      previous_finish = finish.time().value();
+    }
+
+    // The robot has to charge more often when its devices use more energy
+    // between loops, even though the loops themselves take just as long
+    const auto hungry_power_system = PowerSystem::make(200.0);
+    REQUIRE(hungry_power_system);
+    auto hungry_parameters = parameters;
+    hungry_parameters.ambient_sink(
+      std::make_shared<SimpleDevicePowerSink>(
+        battery_system, *hungry_power_system));
+
+    const rmf_task::TravelEstimator estimator(parameters);
+    const rmf_task::TravelEstimator hungry_estimator(hungry_parameters);
+    const auto model = description->make_model(now, parameters);
+    const auto hungry_model = description->make_model(now, hungry_parameters);
+    CHECK(model->invariant_duration() == hungry_model->invariant_duration());
+
+    const auto estimate = model->estimate_finish(
+      initial_states.front(), constraints, estimator);
+    const auto hungry_estimate = hungry_model->estimate_finish(
+      initial_states.front(), constraints, hungry_estimator);
+    REQUIRE(estimate.has_value());
+    REQUIRE(hungry_estimate.has_value());
+    CHECK(estimate->finish_state().time().value()
+      < hungry_estimate->finish_state().time().value());
+
+    // A robot without a charger can still do the loops when its battery is
+    // not drained
+    const auto uncharged_state = rmf_task::State()
+      .load(first_location).battery_soc(1.0);
+    REQUIRE_FALSE(uncharged_state.dedicated_charging_waypoint().has_value());
+    std::optional<rmf_task::Estimate> uncharged;
+    REQUIRE_NOTHROW(
+      uncharged = model->estimate_finish(
+        uncharged_state, rmf_task::Constraints{0.2, 1.0, false}, estimator));
+    REQUIRE(uncharged.has_value());
+    CHECK(uncharged->finish_state().waypoint().value() == 15);
+    CHECK_FALSE(
+      uncharged->finish_state().dedicated_charging_waypoint().has_value());
+  }
+
+  WHEN("Several requests are impossible to fulfil")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Loop::make(
+        0,
+        15,
+        1000,
+        "Loop1",
+        now),
+      rmf_task::requests::Loop::make(
+        15,
+        0,
+        1000,
+        "Loop2",
+        now)
+    };
+
+    auto threaded_options = default_options;
+    threaded_options.expansion_threads(4);
+    for (const auto& options : {default_options, threaded_options})
+    {
+      TaskPlanner task_planner(task_config, options);
+      const auto result = task_planner.plan(now, initial_states, requests);
+      const auto error = std::get_if<TaskPlanner::TaskPlannerError>(&result);
+      REQUIRE(error);
+      CHECK(*error == TaskPlanner::TaskPlannerError::limited_capacity);
+
+      const auto& infeasible =
+        task_planner.statistics().infeasible_requests();
+      REQUIRE(infeasible.size() == 2);
+      CHECK(infeasible[0].request->booking()->id() == "Loop1");
+      CHECK(infeasible[1].request->booking()->id() == "Loop2");
+      for (const auto& r : infeasible)
+        CHECK(r.error == TaskPlanner::TaskPlannerError::limited_capacity);
+    }
+  }
+
   WHEN("A loop request is impossible to fulfil due to low initial battery")
   {
     const auto now = std::chrono::steady_clock::now();
@@ -1005,6 +1753,92 @@ SCENARIO("Grid World")
     CHECK(optimal_assignments.front().back().request()->booking()->id() == "3");
   }
 
+  WHEN("Planning for one robot with several priority levels")
+  {
+    using rmf_task::MultiLevelPriorityScheme;
+    CHECK(MultiLevelPriorityScheme::make_priority(0) == nullptr);
+    CHECK(MultiLevelPriorityScheme::level(
+        MultiLevelPriorityScheme::make_priority(5)) == 5);
+    CHECK(MultiLevelPriorityScheme::level(
+        rmf_task::BinaryPriorityScheme::make_high_priority()) == 1);
+    CHECK_THROWS(MultiLevelPriorityScheme::make_cost_calculator(0));
+    CHECK_THROWS(MultiLevelPriorityScheme::make_cost_calculator(4, 0.5));
+
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0)
+    };
+
+    // Without priorities, request 3 ends up at the back of the queue
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0,
+        delivery_wait,
+        3,
+        delivery_wait,
+        {{}},
+        "1",
+        now + rmf_traffic::time::from_seconds(0)),
+
+      rmf_task::requests::Delivery::make(
+        15,
+        delivery_wait,
+        2,
+        delivery_wait,
+        {{}},
+        "2",
+        now + rmf_traffic::time::from_seconds(0),
+        MultiLevelPriorityScheme::make_priority(1)),
+
+      rmf_task::requests::Delivery::make(
+        7,
+        delivery_wait,
+        9,
+        delivery_wait,
+        {{}},
+        "3",
+        now + rmf_traffic::time::from_seconds(0),
+        MultiLevelPriorityScheme::make_priority(3))
+    };
+
+    auto levels_config = task_config;
+    levels_config.cost_calculator(
+      MultiLevelPriorityScheme::make_cost_calculator(4, 1000.0));
+
+    TaskPlanner task_planner(levels_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    CHECK_TIMES(*assignments, now);
+
+    // The requests are done from the highest level to the lowest
+    std::vector<std::string> order;
+    for (const auto& a : assignments->front())
+    {
+      if (!a.is_charging())
+        order.push_back(a.request()->booking()->id());
+    }
+    const std::vector<std::string> expected_order = {"3", "2", "1"};
+    CHECK(order == expected_order);
+
+    // The heuristic of each level is a lower bound, so the greedy planner
+    // cannot find anything cheaper than the optimal plan
+    auto greedy_planner = TaskPlanner(levels_config, greedy_options);
+    const auto greedy_result = greedy_planner.plan(
+      now, initial_states, requests);
+    const auto greedy_assignments = std::get_if<
+      TaskPlanner::Assignments>(&greedy_result);
+    REQUIRE(greedy_assignments);
+    CHECK(task_planner.compute_cost(*greedy_assignments)
+      >= task_planner.compute_cost(*assignments) - 1e-6);
+  }
+
   WHEN("Planning for 1 robot, two high priority and two low priority tasks")
   {
     const auto now = std::chrono::steady_clock::now();
@@ -1826,6 +2660,7 @@ SCENARIO("Grid World")
           const rmf_task::requests::ChargeBattery::Description>(
           last_assignment.request()->description());
         CHECK_FALSE(is_charge_request);
+        CHECK_FALSE(last_assignment.is_charging());
       }
     }
 
@@ -1864,6 +2699,7 @@ SCENARIO("Grid World")
           const rmf_task::requests::ChargeBattery::Description>(
           last_assignment.request()->description());
         CHECK(is_charge_request);
+        CHECK(last_assignment.is_charging());
       }
     }
   }
@@ -1974,4 +2810,2182 @@ SCENARIO("Grid World")
     }
   }
 
+  WHEN("The planner is interrupted")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}, {10, 0}, {4, 8}, {6, 1}, {3, 12}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now));
+    }
+
+    auto parallel_options = default_options;
+    parallel_options.search_threads(4);
+    auto anytime_options = default_options;
+    anytime_options.anytime(true);
+
+    for (auto options : {default_options, parallel_options, anytime_options})
+    {
+      // Let the planner poll a few times so it is interrupted mid-search
+      std::size_t polls = 0;
+      options.interrupter([&polls]() { return ++polls > 20; });
+
+      TaskPlanner task_planner(task_config, options);
+      const auto result = task_planner.plan(now, initial_states, requests);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      CHECK(task_planner.statistics().interrupted());
+      CHECK(polls == 21);
+
+      // The best partial node is finished, so every request is assigned
+      std::size_t num_assigned = 0;
+      for (const auto& agent : *assignments)
+      {
+        for (const auto& a : agent)
+        {
+          if (!a.is_charging())
+            ++num_assigned;
+        }
+      }
+
+      CHECK(num_assigned == requests.size());
+      CHECK_TIMES(*assignments, now);
+
+      // An interrupter that fires right away leaves nothing to finish, except
+      // for the anytime planner which always has its greedy solution
+      options.interrupter([]() { return true; });
+      const auto early_result =
+        task_planner.plan(now, initial_states, requests, options);
+      const auto early_assignments =
+        std::get_if<TaskPlanner::Assignments>(&early_result);
+      REQUIRE(early_assignments);
+      CHECK(task_planner.statistics().interrupted());
+      CHECK(early_assignments->empty() == !options.anytime());
+    }
+
+    // A planner with a deadline always returns a complete plan
+    const auto optimal_result =
+      TaskPlanner(task_config, default_options).plan(
+      now, initial_states, requests);
+    const auto optimal_assignments =
+      std::get_if<TaskPlanner::Assignments>(&optimal_result);
+    REQUIRE(optimal_assignments);
+
+    for (const auto& base : {default_options, parallel_options})
+    {
+      auto options = base;
+      options.time_budget(rmf_traffic::Duration(0));
+      TaskPlanner task_planner(task_config, options);
+      const auto rushed_result =
+        task_planner.plan(now, initial_states, requests);
+      const auto rushed_assignments =
+        std::get_if<TaskPlanner::Assignments>(&rushed_result);
+      REQUIRE(rushed_assignments);
+      CHECK(task_planner.statistics().interrupted());
+      CHECK_TIMES(*rushed_assignments, now);
+      CHECK(TaskPlanner::compute_objectives(*rushed_assignments).num_requests
+        == requests.size());
+
+      // With plenty of time the optimal plan is found
+      options.time_budget(std::nullopt)
+      .deadline(now + rmf_traffic::time::from_seconds(3600));
+      const auto relaxed_result =
+        task_planner.plan(now, initial_states, requests, options);
+      const auto relaxed_assignments =
+        std::get_if<TaskPlanner::Assignments>(&relaxed_result);
+      REQUIRE(relaxed_assignments);
+      CHECK_FALSE(task_planner.statistics().interrupted());
+      CHECK(task_planner.statistics().suboptimality_bound() == Approx(1.0));
+      CHECK(task_planner.compute_cost(*relaxed_assignments)
+        == Approx(task_planner.compute_cost(*optimal_assignments)));
+    }
+  }
+
+  WHEN("Planning with a rolling horizon")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}, {10, 0}, {4, 8}, {6, 1}, {3, 12},
+      {5, 14}, {1, 6}, {12, 7}, {9, 4}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now + rmf_traffic::time::from_seconds(
+            100.0*i)));
+    }
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto optimal_result =
+      task_planner.plan(now, initial_states, requests);
+    const auto optimal_assignments =
+      std::get_if<TaskPlanner::Assignments>(&optimal_result);
+    REQUIRE(optimal_assignments);
+    const double optimal_cost = task_planner.compute_cost(*optimal_assignments);
+
+    for (const auto& [horizon, commit] :
+      std::vector<std::pair<std::size_t, std::size_t>>{{3, 1}, {4, 2}, {5, 9}})
+    {
+      auto options = default_options;
+      options.rolling_horizon(horizon, commit);
+      CHECK(options.horizon() == horizon);
+      CHECK(options.commit_window() == commit);
+
+      const auto result = task_planner.plan(
+        now, initial_states, requests, options);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      CHECK_TIMES(*assignments, now);
+      CHECK(TaskPlanner::compute_objectives(*assignments).num_requests
+        == requests.size());
+      CHECK(task_planner.compute_cost(*assignments) >= optimal_cost - 1e-6);
+      CHECK(std::isinf(task_planner.statistics().suboptimality_bound()));
+
+      // Each request is assigned exactly once
+      std::set<std::string> ids;
+      for (const auto& agent : *assignments)
+      {
+        for (const auto& a : agent)
+        {
+          if (!a.is_charging())
+            CHECK(ids.insert(a.request()->booking()->id()).second);
+        }
+      }
+      CHECK(ids.size() == requests.size());
+    }
+
+    // A horizon that holds every request plans them all at once
+    auto whole_options = default_options;
+    whole_options.rolling_horizon(requests.size(), requests.size());
+    const auto whole_result = task_planner.plan(
+      now, initial_states, requests, whole_options);
+    const auto whole_assignments =
+      std::get_if<TaskPlanner::Assignments>(&whole_result);
+    REQUIRE(whole_assignments);
+    CHECK(task_planner.compute_cost(*whole_assignments)
+      == Approx(optimal_cost));
+  }
+
+  WHEN("First assignments are reported as soon as they are fixed")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}, {10, 0}, {4, 8}, {6, 1}, {3, 12},
+      {5, 14}, {1, 6}, {12, 7}, {9, 4}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now + rmf_traffic::time::from_seconds(
+            100.0*i)));
+    }
+
+    auto rolling_options = default_options;
+    rolling_options.rolling_horizon(3, 1);
+
+    TaskPlanner task_planner(task_config, default_options);
+    for (auto options : {default_options, rolling_options})
+    {
+      std::map<std::size_t, std::vector<TaskPlanner::Assignment>> reports;
+      bool reported_while_planning = false;
+      options.commitment_callback(
+        [&](std::size_t agent, const TaskPlanner::Assignment& assignment)
+        {
+          reports[agent].push_back(assignment);
+        });
+      options.interrupter(
+        [&]()
+        {
+          reported_while_planning = reported_while_planning
+          || !reports.empty();
+          return false;
+        });
+
+      const auto result = task_planner.plan(
+        now, initial_states, requests, options);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      CHECK(reported_while_planning);
+
+      // Each agent is reported once, with the first assignment of the plan
+      for (std::size_t i = 0; i < assignments->size(); ++i)
+      {
+        const auto& agent = (*assignments)[i];
+        if (agent.empty())
+        {
+          CHECK(reports.count(i) == 0);
+          continue;
+        }
+
+        REQUIRE(reports[i].size() == 1);
+        const auto& reported = reports[i].front();
+        CHECK(reported.request()->booking()->id()
+          == agent.front().request()->booking()->id());
+        CHECK(reported.deployment_time() == agent.front().deployment_time());
+        CHECK(reported.finish_state().time()
+          == agent.front().finish_state().time());
+      }
+    }
+  }
+
+  WHEN("The caller interrupts a rolling horizon plan once")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          i, delivery_wait, (i + 5) % 16, delivery_wait, {{}},
+          std::to_string(i), now + rmf_traffic::time::from_seconds(
+            100.0*i)));
+    }
+
+    auto options = default_options;
+    options.rolling_horizon(3, 1);
+
+    // The interrupter only reports the request to stop once, the first time
+    // it is polled after the first window was committed
+    bool stop = false;
+    options.commitment_callback(
+      [&](std::size_t, const TaskPlanner::Assignment&) { stop = true; });
+    options.interrupter([&]() { return std::exchange(stop, false); });
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    CHECK(task_planner.statistics().interrupted());
+
+    // Later windows do not forget that the caller asked to stop, so only what
+    // was committed before then is planned
+    std::size_t planned = 0;
+    for (const auto& agent : *assignments)
+    {
+      for (const auto& a : agent)
+      {
+        if (!a.is_charging())
+          ++planned;
+      }
+    }
+    CHECK(planned > 0);
+    CHECK(planned < requests.size());
+  }
+
+  WHEN("A plan is returned as a flat table")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}, {10, 0}, {4, 8}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now + rmf_traffic::time::from_seconds(
+            100.0*i)));
+    }
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+
+    const auto flat_result = task_planner.plan_flat(
+      now, initial_states, requests, default_options);
+    const auto flat = std::get_if<TaskPlanner::FlatAssignments>(&flat_result);
+    REQUIRE(flat);
+    REQUIRE(flat->num_agents() == assignments->size());
+    REQUIRE(flat->offsets().size() == assignments->size() + 1);
+    CHECK(flat->offsets().back() == flat->size());
+
+    const auto rebuilt = flat->to_assignments(initial_states);
+    REQUIRE(rebuilt.size() == assignments->size());
+    for (std::size_t i = 0; i < assignments->size(); ++i)
+    {
+      const auto& agent = (*assignments)[i];
+      REQUIRE(std::size_t(flat->end(i) - flat->begin(i)) == agent.size());
+      REQUIRE(rebuilt[i].size() == agent.size());
+      for (std::size_t j = 0; j < agent.size(); ++j)
+      {
+        const auto& record = flat->begin(i)[j];
+        const auto& state = agent[j].finish_state();
+        CHECK(record.agent == i);
+        CHECK(record.request->booking()->id()
+          == agent[j].request()->booking()->id());
+        CHECK(record.deployment_time == agent[j].deployment_time());
+        CHECK(record.finish_time == state.time().value());
+        CHECK(record.finish_soc == Approx(state.battery_soc().value()));
+        CHECK(record.finish_waypoint == state.waypoint().value());
+
+        CHECK(rebuilt[i][j].request() == record.request);
+        CHECK(rebuilt[i][j].deployment_time() == record.deployment_time);
+        CHECK(rebuilt[i][j].finish_state().time() == record.finish_time);
+        CHECK(rebuilt[i][j].finish_state().waypoint() == state.waypoint());
+        CHECK(rebuilt[i][j].is_charging() == agent[j].is_charging());
+      }
+    }
+
+    // Copies share the same table
+    const auto copy = *flat;
+    CHECK(copy.records().data() == flat->records().data());
+
+    CHECK(TaskPlanner::FlatAssignments().num_agents() == 0);
+    CHECK_THROWS(flat->to_assignments({initial_states.front()}));
+  }
+
+  WHEN("The problem is partitioned into clusters")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    // Requests on the left half of the grid belong to cluster 0, the ones on
+    // the right half belong to cluster 1, and the last one belongs to a
+    // cluster without any agents
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 4}, {8, 13}, {12, 1}, {2, 7}, {11, 3}, {15, 6}, {5, 10}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    std::vector<std::size_t> request_clusters;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now));
+      request_clusters.push_back(
+        i + 1 == trips.size() ? 7 : (trips[i].first % 4 < 2 ? 0 : 1));
+    }
+
+    // The first agent starts on the left and the second on the right
+    auto partitioned_config = task_config;
+    partitioned_config.partitioner(
+      [&](const std::vector<rmf_task::State>& agents,
+      const std::vector<rmf_task::ConstRequestPtr>& r)
+      {
+        CHECK(agents.size() == initial_states.size());
+        CHECK(r.size() == requests.size());
+        return TaskPlanner::Partition{{0, 1}, request_clusters};
+      });
+    CHECK(partitioned_config.partitioner());
+
+    auto parallel_options = default_options;
+    parallel_options.search_threads(2);
+    for (const auto& options : {default_options, parallel_options})
+    {
+      TaskPlanner task_planner(partitioned_config, options);
+      const auto result = task_planner.plan(now, initial_states, requests);
+      const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+      REQUIRE(assignments->size() == initial_states.size());
+      CHECK_TIMES(*assignments, now);
+      CHECK(std::isinf(task_planner.statistics().suboptimality_bound()));
+      CHECK(task_planner.statistics().nodes_expanded() > 0);
+
+      std::size_t num_assigned = 0;
+      for (std::size_t agent = 0; agent < assignments->size(); ++agent)
+      {
+        for (const auto& a : (*assignments)[agent])
+        {
+          if (a.is_charging())
+            continue;
+
+          ++num_assigned;
+          const auto id = std::stoul(a.request()->booking()->id());
+          if (request_clusters[id] != 7)
+            CHECK(request_clusters[id] == agent);
+        }
+      }
+
+      CHECK(num_assigned == requests.size());
+    }
+
+    // A partition of the wrong size is rejected
+    auto broken_config = task_config;
+    broken_config.partitioner(
+      [](const auto&, const auto&)
+      {
+        return TaskPlanner::Partition{{0}, {}};
+      });
+    CHECK_THROWS(
+      TaskPlanner(broken_config, default_options).plan(
+        now, initial_states, requests));
+  }
+
+  WHEN("The same requests are planned repeatedly")
+  {
+    // Counts how many models get made from a delivery description
+    class CountingDescription : public rmf_task::Task::Description
+    {
+    public:
+
+      CountingDescription(
+        rmf_task::Task::ConstDescriptionPtr description,
+        std::shared_ptr<std::atomic_size_t> count)
+      : _description(std::move(description)),
+        _count(std::move(count))
+      {
+        // Do nothing
+      }
+
+      rmf_task::Task::ConstModelPtr make_model(
+        rmf_traffic::Time earliest_start_time,
+        const rmf_task::Parameters& parameters) const final
+      {
+        ++*_count;
+        return _description->make_model(earliest_start_time, parameters);
+      }
+
+      Info generate_info(
+        const rmf_task::State& initial_state,
+        const rmf_task::Parameters& parameters) const final
+      {
+        return _description->generate_info(initial_state, parameters);
+      }
+
+    private:
+      rmf_task::Task::ConstDescriptionPtr _description;
+      std::shared_ptr<std::atomic_size_t> _count;
+    };
+
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const auto count = std::make_shared<std::atomic_size_t>(0);
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+      {{0, 3}, {15, 2}, {7, 9}};
+
+    // The requests begin in the future, so their models are made for the
+    // same earliest start time every time they are planned
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        std::make_shared<rmf_task::Request>(
+          std::to_string(i),
+          now + rmf_traffic::time::from_seconds(600),
+          nullptr,
+          std::make_shared<CountingDescription>(
+            rmf_task::requests::Delivery::Description::make(
+              trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+              {{}}),
+            count)));
+    }
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto first_result = task_planner.plan(now, initial_states, requests);
+    const auto first_assignments =
+      std::get_if<TaskPlanner::Assignments>(&first_result);
+    REQUIRE(first_assignments);
+    CHECK(*count == requests.size());
+
+    for (std::size_t i = 1; i <= 3; ++i)
+    {
+      const auto later = now + rmf_traffic::time::from_seconds(10.0*i);
+      const auto result = task_planner.plan(later, initial_states, requests);
+      REQUIRE(std::get_if<TaskPlanner::Assignments>(&result));
+      CHECK(*count == requests.size());
+    }
+
+    // Once a request is due, its model is made for the time of the plan
+    const auto due = now + rmf_traffic::time::from_seconds(1200);
+    task_planner.plan(due, initial_states, requests);
+    CHECK(*count == 2*requests.size());
+
+    // A new planner keeps its own models
+    TaskPlanner(task_config, default_options).plan(
+      now, initial_states, requests);
+    CHECK(*count == 3*requests.size());
+  }
+
+  WHEN("Identical problems are planned with a result cache")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+      {{0, 3}, {15, 2}, {7, 9}};
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now));
+    }
+
+    const auto travel_estimator =
+      std::make_shared<rmf_task::TravelEstimator>(parameters);
+    auto cache_config = task_config;
+    cache_config.result_cache_size(2).travel_estimator(travel_estimator);
+    CHECK(cache_config.result_cache_size() == 2);
+    TaskPlanner task_planner(cache_config, default_options);
+
+    const auto first_result = task_planner.plan(now, initial_states, requests);
+    const auto first_assignments =
+      std::get_if<TaskPlanner::Assignments>(&first_result);
+    REQUIRE(first_assignments);
+    CHECK_FALSE(task_planner.statistics().cached());
+    const auto nodes_expanded = task_planner.statistics().nodes_expanded();
+
+    // The same problem gets the same result without searching again
+    const auto second_result = task_planner.plan(now, initial_states, requests);
+    const auto second_assignments =
+      std::get_if<TaskPlanner::Assignments>(&second_result);
+    REQUIRE(second_assignments);
+    CHECK(task_planner.statistics().cached());
+    CHECK(task_planner.statistics().nodes_expanded() == nodes_expanded);
+    CHECK(task_planner.compute_cost(*second_assignments)
+      == Approx(task_planner.compute_cost(*first_assignments)));
+
+    // Any change to the problem is planned again
+    auto moved_states = initial_states;
+    moved_states[0].battery_soc(0.9);
+    task_planner.plan(now, moved_states, requests);
+    CHECK_FALSE(task_planner.statistics().cached());
+
+    auto later = now + rmf_traffic::time::from_seconds(1.0);
+    task_planner.plan(later, initial_states, requests);
+    CHECK_FALSE(task_planner.statistics().cached());
+
+    // A request that is made again is not the same request
+    auto remade_requests = requests;
+    remade_requests[0] = rmf_task::requests::Delivery::make(
+      trips[0].first, delivery_wait, trips[0].second, delivery_wait,
+      {{}}, "0", now);
+    task_planner.plan(now, initial_states, remade_requests);
+    CHECK_FALSE(task_planner.statistics().cached());
+
+    // The two most recent problems are still remembered, but the first one
+    // has been dropped
+    task_planner.plan(later, initial_states, requests);
+    CHECK(task_planner.statistics().cached());
+    task_planner.plan(now, initial_states, requests);
+    CHECK_FALSE(task_planner.statistics().cached());
+
+    // Plans with a time budget are not remembered
+    auto budget_options = default_options;
+    budget_options.time_budget(rmf_traffic::time::from_seconds(10.0));
+    task_planner.plan(now, moved_states, requests, budget_options);
+    task_planner.plan(now, moved_states, requests, budget_options);
+    CHECK_FALSE(task_planner.statistics().cached());
+
+    // The options that shape the search are part of the problem
+    task_planner.plan(now, initial_states, requests, default_options);
+    CHECK(task_planner.statistics().cached());
+    const auto check_changed_options =
+      [&](const TaskPlanner::Options& changed_options)
+      {
+        task_planner.plan(now, initial_states, requests, changed_options);
+        CHECK_FALSE(task_planner.statistics().cached());
+      };
+
+    auto finish_time_options = default_options;
+    finish_time_options.greedy_by_finish_time(
+      !default_options.greedy_by_finish_time());
+    check_changed_options(finish_time_options);
+
+    auto restart_options = default_options;
+    restart_options.greedy_restarts(default_options.greedy_restarts() + 2);
+    check_changed_options(restart_options);
+    restart_options.greedy_restarts(
+      restart_options.greedy_restarts(),
+      restart_options.greedy_restart_alpha() / 2.0);
+    check_changed_options(restart_options);
+
+    auto neighborhood_options = default_options;
+    neighborhood_options.neighborhood_search(
+      rmf_traffic::time::from_seconds(0.05), 2);
+    check_changed_options(neighborhood_options);
+    neighborhood_options.neighborhood_search(
+      rmf_traffic::time::from_seconds(0.05), 3);
+    check_changed_options(neighborhood_options);
+    neighborhood_options.neighborhood_search(
+      rmf_traffic::time::from_seconds(0.05), 3, 2);
+    check_changed_options(neighborhood_options);
+
+    // So is the congestion that slows down the travel estimates
+    using Congestion = rmf_task::TravelEstimator::Congestion;
+    Congestion congestion(now, std::chrono::hours(1), 24);
+    congestion.zone_multipliers(0, {2.0});
+    travel_estimator->congestion(congestion);
+    check_changed_options(default_options);
+    task_planner.plan(now, initial_states, requests, default_options);
+    CHECK(task_planner.statistics().cached());
+
+    congestion.zone_multipliers(0, {3.0});
+    travel_estimator->congestion(congestion);
+    check_changed_options(default_options);
+
+    // And so is the calibration of the travel estimates
+    const auto calibration = std::make_shared<rmf_task::Calibration>();
+    travel_estimator->calibration(calibration);
+    check_changed_options(default_options);
+    task_planner.plan(now, initial_states, requests, default_options);
+    CHECK(task_planner.statistics().cached());
+
+    CHECK(calibration->report(
+        rmf_task::Calibration::travel_type(), 0, 3,
+        std::chrono::seconds(10), std::chrono::seconds(20)));
+    check_changed_options(default_options);
+
+    // And so are the lanes that the travel estimates are planned on. Closing
+    // every lane of waypoint 13 strands the first agent.
+    const auto before_closure =
+      task_planner.plan(now, initial_states, requests, default_options);
+    const auto before_assignments =
+      std::get_if<TaskPlanner::Assignments>(&before_closure);
+    REQUIRE(before_assignments);
+    CHECK(task_planner.statistics().cached());
+
+    rmf_traffic::agv::Graph closed_graph;
+    for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+      closed_graph.add_waypoint(map_name, graph.get_waypoint(i).get_location());
+
+    std::vector<std::size_t> affected_waypoints;
+    for (std::size_t i = 0; i < graph.num_waypoints(); ++i)
+      affected_waypoints.push_back(i);
+
+    for (std::size_t i = 0; i < graph.num_lanes(); ++i)
+    {
+      const auto& lane = graph.get_lane(i);
+      const auto entry = lane.entry().waypoint_index();
+      const auto exit = lane.exit().waypoint_index();
+      if (entry != 13 && exit != 13)
+        closed_graph.add_lane(entry, exit);
+    }
+
+    travel_estimator->update_planner(
+      std::make_shared<rmf_traffic::agv::Planner>(
+        rmf_traffic::agv::Planner::Configuration{closed_graph, traits},
+        default_planner_options),
+      affected_waypoints);
+
+    const auto after_closure =
+      task_planner.plan(now, initial_states, requests, default_options);
+    const auto after_assignments =
+      std::get_if<TaskPlanner::Assignments>(&after_closure);
+    REQUIRE(after_assignments);
+    CHECK_FALSE(task_planner.statistics().cached());
+    CHECK(task_planner.compute_cost(*after_assignments)
+      != Approx(task_planner.compute_cost(*before_assignments)));
+  }
+
+  WHEN("The configuration of a planner changes")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "0", now),
+      rmf_task::requests::Delivery::make(
+        15, delivery_wait, 2, delivery_wait, {{}}, "1", now)
+    };
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto estimator = task_planner.travel_estimator();
+    REQUIRE(estimator);
+    CHECK(estimator->serves(parameters));
+    const auto first_result = task_planner.plan(now, initial_states, requests);
+    REQUIRE(std::get_if<TaskPlanner::Assignments>(&first_result));
+    CHECK(task_planner.statistics().travel_estimates().misses() > 0);
+
+    // New battery thresholds and cost calculator do not change any travel, so
+    // the warm cache is kept
+    auto new_config = task_config;
+    new_config.constraints(rmf_task::Constraints{0.3, 0.9, drain_battery});
+    new_config.cost_calculator(
+      rmf_task::BinaryPriorityScheme::make_cost_calculator());
+    task_planner.configuration(new_config);
+    CHECK(task_planner.travel_estimator() == estimator);
+    CHECK(task_planner.configuration().constraints().threshold_soc() == 0.3);
+    const auto warm_result = task_planner.plan(now, initial_states, requests);
+    REQUIRE(std::get_if<TaskPlanner::Assignments>(&warm_result));
+
+    TaskPlanner fresh_planner(new_config, default_options);
+    const auto cold_result =
+      fresh_planner.plan(now, initial_states, requests);
+    REQUIRE(std::get_if<TaskPlanner::Assignments>(&cold_result));
+    CHECK(task_planner.statistics().travel_estimates().misses()
+      < fresh_planner.statistics().travel_estimates().misses());
+
+    // A new planner can start with the cache of the old one
+    auto shared_config = new_config;
+    shared_config.travel_estimator(task_planner.travel_estimator());
+    TaskPlanner other_planner(shared_config, default_options);
+    CHECK(other_planner.travel_estimator() == estimator);
+
+    // A different motion sink changes the drain of every trip
+    auto other_parameters = parameters;
+    other_parameters.motion_sink(
+      std::make_shared<SimpleMotionPowerSink>(
+        battery_system, mechanical_system));
+    CHECK_FALSE(estimator->serves(other_parameters));
+    new_config.parameters(other_parameters);
+    task_planner.configuration(new_config);
+    CHECK(task_planner.travel_estimator() != estimator);
+    CHECK(task_planner.travel_estimator()->serves(other_parameters));
+  }
+
+  WHEN("Requests are planned for several fleets at once")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    const std::vector<std::vector<rmf_task::State>> agents =
+    {
+      {rmf_task::State().load_basic(first_location, 13, 1.0)},
+      {rmf_task::State().load_basic(second_location, 2, 1.0)},
+      {}
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+      {{0, 3}, {15, 2}, {7, 9}, {8, 11}, {6, 0}, {12, 5}};
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now));
+    }
+
+    rmf_task::MultiFleetPlanner planner(
+      "multi_fleet", {task_config, task_config, task_config},
+      default_options);
+    REQUIRE(planner.num_fleets() == 3);
+    CHECK_THROWS_AS(
+      planner.plan(now, {agents[0], agents[1]}, requests),
+      std::invalid_argument);
+
+    const auto result = planner.plan(now, agents, requests);
+    const auto* assignments =
+      std::get_if<rmf_task::MultiFleetPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    REQUIRE(assignments->size() == 3);
+    CHECK(assignments->at(2).empty());
+
+    // Every request is performed by exactly one fleet
+    std::multiset<std::string> assigned;
+    std::size_t fleets_used = 0;
+    for (std::size_t f = 0; f < 2; ++f)
+    {
+      REQUIRE(assignments->at(f).size() == agents[f].size());
+      bool used = false;
+      for (const auto& agent : assignments->at(f))
+      {
+        for (const auto& assignment : agent)
+        {
+          const auto is_charge_request =
+            std::dynamic_pointer_cast<
+            const rmf_task::requests::ChargeBattery::Description>(
+            assignment.request()->description());
+          if (is_charge_request)
+            continue;
+
+          assigned.insert(assignment.request()->booking()->id());
+          used = true;
+        }
+      }
+
+      if (used)
+        ++fleets_used;
+    }
+
+    CHECK(assigned.size() == requests.size());
+    for (const auto& request : requests)
+      CHECK(assigned.count(request->booking()->id()) == 1);
+
+    // Neither fleet is left idle while the other does all of the work
+    CHECK(fleets_used == 2);
+    CHECK(planner.fleet(0).statistics().travel_estimates().misses() > 0);
+  }
+
+  WHEN("Requests with a priority are allocated between fleets")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    rmf_traffic::agv::Plan::Start start{now, 13, 0.0};
+
+    // The fleets are the same, so whichever request is allocated first goes
+    // to the first fleet, and the other one goes to the agent that has not
+    // moved on yet
+    const std::vector<std::vector<rmf_task::State>> agents =
+    {
+      {rmf_task::State().load_basic(start, 13, 1.0)},
+      {rmf_task::State().load_basic(start, 13, 1.0)}
+    };
+
+    const std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "plain", now),
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "urgent", now,
+        rmf_task::BinaryPriorityScheme::make_high_priority())
+    };
+
+    rmf_task::MultiFleetPlanner planner(
+      "multi_fleet", {task_config, task_config}, default_options);
+    const auto result = planner.plan(now, agents, requests);
+    const auto* assignments =
+      std::get_if<rmf_task::MultiFleetPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    REQUIRE(assignments->size() == 2);
+
+    const auto fleet_of =
+      [&](const std::string& id) -> std::optional<std::size_t>
+      {
+        for (std::size_t f = 0; f < assignments->size(); ++f)
+        {
+          for (const auto& agent : assignments->at(f))
+          {
+            for (const auto& assignment : agent)
+            {
+              if (assignment.request()->booking()->id() == id)
+                return f;
+            }
+          }
+        }
+
+        return std::nullopt;
+      };
+
+    CHECK(fleet_of("urgent") == 0);
+    CHECK(fleet_of("plain") == 1);
+  }
+
+  WHEN("A fleet fails to plan its share of the requests")
+  {
+    // The models of a broken fleet cannot be performed by any agent, except
+    // for the first one of each request, which the allocation estimates
+    class BrokenDescription : public rmf_task::Task::Description
+    {
+    public:
+
+      class BrokenModel : public rmf_task::Task::Model
+      {
+      public:
+
+        std::optional<rmf_task::Estimate> estimate_finish(
+          const rmf_task::State&,
+          const rmf_task::Constraints&,
+          const rmf_task::TravelEstimator&) const final
+        {
+          return std::nullopt;
+        }
+
+        rmf_traffic::Duration invariant_duration() const final
+        {
+          return rmf_traffic::Duration(0);
+        }
+      };
+
+      BrokenDescription(
+        rmf_task::Task::ConstDescriptionPtr description,
+        rmf_battery::ConstMotionPowerSinkPtr broken)
+      : _description(std::move(description)),
+        _broken(std::move(broken))
+      {
+        // Do nothing
+      }
+
+      rmf_task::Task::ConstModelPtr make_model(
+        rmf_traffic::Time earliest_start_time,
+        const rmf_task::Parameters& parameters) const final
+      {
+        if (parameters.motion_sink() == _broken && _calls++ > 0)
+          return std::make_shared<BrokenModel>();
+
+        return _description->make_model(earliest_start_time, parameters);
+      }
+
+      Info generate_info(
+        const rmf_task::State& initial_state,
+        const rmf_task::Parameters& parameters) const final
+      {
+        return _description->generate_info(initial_state, parameters);
+      }
+
+    private:
+      rmf_task::Task::ConstDescriptionPtr _description;
+      rmf_battery::ConstMotionPowerSinkPtr _broken;
+      mutable std::atomic_size_t _calls = 0;
+    };
+
+    const auto now = std::chrono::steady_clock::now();
+    rmf_traffic::agv::Plan::Start first_start{now, 13, 0.0};
+    rmf_traffic::agv::Plan::Start second_start{now, 0, 0.0};
+
+    // The second fleet has an agent right where the first request begins, so
+    // the allocation gives that request to it
+    const std::vector<std::vector<rmf_task::State>> agents =
+    {
+      {rmf_task::State().load_basic(first_start, 13, 1.0)},
+      {rmf_task::State().load_basic(second_start, 0, 1.0)}
+    };
+
+    auto broken_parameters = parameters;
+    broken_parameters.motion_sink(
+      std::make_shared<SimpleMotionPowerSink>(
+        battery_system, mechanical_system));
+    auto broken_config = task_config;
+    broken_config.parameters(broken_parameters);
+
+    const auto make_requests = [&]()
+      {
+        const std::vector<std::pair<std::size_t, std::size_t>> trips =
+          {{0, 3}, {12, 15}};
+
+        std::vector<rmf_task::ConstRequestPtr> requests;
+        for (std::size_t i = 0; i < trips.size(); ++i)
+        {
+          requests.push_back(
+            std::make_shared<rmf_task::Request>(
+              std::to_string(i), now, nullptr,
+              std::make_shared<BrokenDescription>(
+                rmf_task::requests::Delivery::Description::make(
+                  trips[i].first, delivery_wait, trips[i].second,
+                  delivery_wait, {{}}),
+                broken_parameters.motion_sink())));
+        }
+
+        return requests;
+      };
+
+    // The broken fleet is left out, and the other one does all of the work
+    rmf_task::MultiFleetPlanner planner(
+      "multi_fleet", {task_config, broken_config}, default_options);
+    const auto result = planner.plan(now, agents, make_requests());
+    const auto* assignments =
+      std::get_if<rmf_task::MultiFleetPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    REQUIRE(assignments->size() == 2);
+    REQUIRE(assignments->at(1).size() == 1);
+    CHECK(assignments->at(1).front().empty());
+
+    std::set<std::string> assigned;
+    for (const auto& agent : assignments->at(0))
+    {
+      for (const auto& assignment : agent)
+        assigned.insert(assignment.request()->booking()->id());
+    }
+    CHECK(assigned.count("0") == 1);
+    CHECK(assigned.count("1") == 1);
+
+    // Without another fleet to fall back on, the error is returned
+    rmf_task::MultiFleetPlanner broken_planner(
+      "multi_fleet", {broken_config}, default_options);
+    const auto broken_result =
+      broken_planner.plan(now, {agents[1]}, make_requests());
+    CHECK(std::holds_alternative<TaskPlanner::TaskPlannerError>(
+        broken_result));
+  }
+
+  WHEN("Estimates are finished from kernels")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+      {{0, 3}, {15, 2}, {7, 9}, {8, 11}, {6, 0}, {12, 5}};
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i),
+          now + rmf_traffic::time::from_seconds(300.0*i)));
+    }
+
+    // A kernel gives the same estimates as its model for every time
+    const rmf_task::TravelEstimator travel_estimator(parameters);
+    for (const auto& request : requests)
+    {
+      const auto model = request->description()->make_model(
+        request->booking()->earliest_start_time(), parameters);
+      const auto kernel = model->make_kernel(
+        initial_states[0], constraints, travel_estimator);
+      REQUIRE(kernel);
+
+      for (const double offset : {0.0, 100.0, 900.0, 5000.0})
+      {
+        auto state = initial_states[0];
+        state.time(now + rmf_traffic::time::from_seconds(offset));
+        const auto expected = model->estimate_finish(
+          state, constraints, travel_estimator);
+        const auto estimate = kernel->estimate_finish(state);
+        REQUIRE(expected.has_value() == estimate.has_value());
+        if (!expected.has_value())
+          continue;
+
+        CHECK(estimate->wait_until() == expected->wait_until());
+        CHECK(estimate->finish_state().time() ==
+          expected->finish_state().time());
+        CHECK(estimate->finish_state().waypoint() ==
+          expected->finish_state().waypoint());
+        CHECK(estimate->finish_state().battery_soc().value() ==
+          Approx(expected->finish_state().battery_soc().value()));
+      }
+    }
+
+    // The planner reuses the kernels of states that it reaches again
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    CHECK_TIMES(*assignments, now);
+    CHECK(task_planner.statistics().kernel_reuses() > 0);
+    CHECK(task_planner.statistics().kernel_reuses()
+      < task_planner.statistics().finish_estimates());
+  }
+
+  WHEN("Makespan is weighed against total delay")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "1", now),
+      rmf_task::requests::Delivery::make(
+        15, delivery_wait, 2, delivery_wait, {{}}, "2", now),
+      rmf_task::requests::Delivery::make(
+        7, delivery_wait, 9, delivery_wait, {{}}, "3", now),
+      rmf_task::requests::Loop::make(
+        12, 3, 1, "4", now + rmf_traffic::time::from_seconds(50000))
+    };
+
+    TaskPlanner delay_planner(task_config, default_options);
+    const auto delay_result =
+      delay_planner.plan(now, initial_states, requests);
+    const auto delay_assignments =
+      std::get_if<TaskPlanner::Assignments>(&delay_result);
+    REQUIRE(delay_assignments);
+
+    const auto delay_objectives =
+      TaskPlanner::compute_objectives(*delay_assignments);
+    CHECK(delay_objectives.num_requests == requests.size());
+    CHECK(delay_objectives.total_delay
+      == Approx(delay_planner.compute_cost(*delay_assignments)));
+    CHECK(delay_objectives.priority_delay == 0.0);
+    CHECK(delay_objectives.max_delay <= delay_objectives.total_delay);
+    CHECK(delay_objectives.makespan
+      >= rmf_traffic::time::from_seconds(50000));
+
+    const double makespan_weight = 100.0;
+    auto makespan_config = task_config;
+    makespan_config.cost_calculator(
+      rmf_task::BinaryPriorityScheme::make_cost_calculator(makespan_weight));
+
+    TaskPlanner makespan_planner(makespan_config, default_options);
+    const auto makespan_result =
+      makespan_planner.plan(now, initial_states, requests);
+    const auto makespan_assignments =
+      std::get_if<TaskPlanner::Assignments>(&makespan_result);
+    REQUIRE(makespan_assignments);
+
+    const auto makespan_objectives =
+      TaskPlanner::compute_objectives(*makespan_assignments);
+    CHECK(makespan_objectives.num_requests == requests.size());
+    CHECK(makespan_planner.compute_cost(*makespan_assignments)
+      == Approx(makespan_objectives.total_delay + makespan_weight
+      * rmf_traffic::time::to_seconds(makespan_objectives.makespan)));
+
+    // Each plan is optimal for its own objective
+    CHECK(makespan_objectives.makespan <= delay_objectives.makespan);
+    CHECK(delay_objectives.total_delay
+      <= makespan_objectives.total_delay + 1e-6);
+    CHECK(makespan_planner.compute_cost(*makespan_assignments)
+      <= makespan_planner.compute_cost(*delay_assignments) + 1e-6);
+
+    // A weight of zero gives the original costs
+    auto zero_weight_config = task_config;
+    zero_weight_config.cost_calculator(
+      rmf_task::BinaryPriorityScheme::make_cost_calculator(0.0));
+    CHECK(TaskPlanner(zero_weight_config, default_options).compute_cost(
+        *delay_assignments)
+      == Approx(delay_planner.compute_cost(*delay_assignments)));
+  }
+
+  WHEN("Several agents are interchangeable")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start other_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(location, 13, 1.0),
+      rmf_task::State().load_basic(other_location, 2, 1.0),
+      rmf_task::State().load_basic(location, 13, 1.0),
+      rmf_task::State().load_basic(location, 13, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now + rmf_traffic::time::from_seconds(
+            50.0*i)));
+    }
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    const double cost = task_planner.compute_cost(*assignments);
+    const auto nodes_expanded = task_planner.statistics().nodes_expanded();
+    CHECK(task_planner.statistics().nodes_symmetric() == 0);
+
+    auto options = default_options;
+    options.break_agent_symmetry(true);
+    CHECK(options.break_agent_symmetry());
+    CHECK(options.agent_symmetry_soc_tolerance() == 0.0);
+
+    const auto symmetric_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto symmetric_assignments =
+      std::get_if<TaskPlanner::Assignments>(&symmetric_result);
+    REQUIRE(symmetric_assignments);
+    CHECK_TIMES(*symmetric_assignments, now);
+
+    // Breaking exact symmetries does not change the cost of the plan
+    const auto& stats = task_planner.statistics();
+    CHECK(task_planner.compute_cost(*symmetric_assignments) == Approx(cost));
+    CHECK(stats.nodes_symmetric() > 0);
+    CHECK(stats.nodes_expanded() <= nodes_expanded);
+
+    // Agents within the tolerances are grouped too, and every request is
+    // still assigned exactly once
+    initial_states[3] = rmf_task::State().load_basic(
+      {now + std::chrono::seconds(1), 13, default_orientation}, 13, 0.98);
+    options.break_agent_symmetry(true, 0.05, std::chrono::seconds(5));
+    const auto tolerant_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto tolerant_assignments =
+      std::get_if<TaskPlanner::Assignments>(&tolerant_result);
+    REQUIRE(tolerant_assignments);
+    CHECK(task_planner.statistics().nodes_symmetric() > 0);
+    CHECK(TaskPlanner::compute_objectives(*tolerant_assignments).num_requests
+      == requests.size());
+  }
+
+  WHEN("Interchangeable requests are assigned in a canonical order")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    // Two groups of identical requests and one request of its own
+    const auto second_start = now + rmf_traffic::time::from_seconds(50.0);
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < 3; ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Loop::make(
+          0, 3, 1, "loop_" + std::to_string(i), now));
+    }
+
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          7, delivery_wait, 9, delivery_wait, {{}},
+          "delivery_" + std::to_string(i), second_start));
+    }
+
+    requests.push_back(
+      rmf_task::requests::Delivery::make(
+        15, delivery_wait, 2, delivery_wait, {{}}, "delivery_2", now));
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    const double cost = task_planner.compute_cost(*assignments);
+    const auto nodes_expanded = task_planner.statistics().nodes_expanded();
+    CHECK(task_planner.statistics().nodes_symmetric() == 0);
+
+    auto options = default_options;
+    options.break_request_symmetry(true);
+    CHECK(options.break_request_symmetry());
+
+    const auto symmetric_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto symmetric_assignments =
+      std::get_if<TaskPlanner::Assignments>(&symmetric_result);
+    REQUIRE(symmetric_assignments);
+    CHECK_TIMES(*symmetric_assignments, now);
+
+    // The requests of a group are only swapped around, so the cost of the
+    // plan is unchanged while fewer orderings are searched
+    const auto& stats = task_planner.statistics();
+    CHECK(task_planner.compute_cost(*symmetric_assignments) == Approx(cost));
+    CHECK(stats.nodes_symmetric() > 0);
+    CHECK(stats.nodes_expanded() < nodes_expanded);
+    CHECK(TaskPlanner::compute_objectives(*symmetric_assignments).num_requests
+      == requests.size());
+
+    // Charges are only interchangeable when they stop at the same target
+    std::vector<rmf_task::State> low_states = initial_states;
+    for (auto& state : low_states)
+      state.battery_soc(0.5);
+
+    const auto plan_charges =
+      [&](const double first_target, const double second_target)
+      {
+        const std::vector<rmf_task::ConstRequestPtr> charges =
+        {
+          rmf_task::requests::ChargeBattery::make(
+            now, nullptr, false, first_target),
+          rmf_task::requests::ChargeBattery::make(
+            now, nullptr, false, second_target)
+        };
+
+        const auto charge_result = task_planner.plan(
+          now, low_states, charges, options);
+        REQUIRE(std::get_if<TaskPlanner::Assignments>(&charge_result));
+        return task_planner.statistics().nodes_symmetric();
+      };
+
+    CHECK(plan_charges(0.8, 0.8) > 0);
+    CHECK(plan_charges(0.8, 0.9) == 0);
+  }
+
+  WHEN("Dominated search nodes are pruned")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 3}, {15, 2}, {7, 9}, {8, 11}, {10, 0}, {4, 8}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now + rmf_traffic::time::from_seconds(
+            60.0*i)));
+    }
+
+    TaskPlanner task_planner(task_config, default_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    const double cost = task_planner.compute_cost(*assignments);
+    const auto nodes_expanded = task_planner.statistics().nodes_expanded();
+
+    auto options = default_options;
+    options.prune_dominated_nodes(true);
+    CHECK(options.prune_dominated_nodes());
+
+    const auto pruned_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto pruned_assignments =
+      std::get_if<TaskPlanner::Assignments>(&pruned_result);
+    REQUIRE(pruned_assignments);
+    CHECK_TIMES(*pruned_assignments, now);
+    CHECK(task_planner.compute_cost(*pruned_assignments) == Approx(cost));
+    CHECK(task_planner.statistics().nodes_expanded() <= nodes_expanded);
+  }
+
+  WHEN("Charges may stop once the next task is covered")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start location{now, 13, default_orientation};
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(location, 13, 1.0)
+    };
+
+    const std::vector<std::pair<std::size_t, std::size_t>> trips =
+    {
+      {0, 15}, {3, 12}, {15, 0}, {12, 3}, {0, 15}, {3, 12}, {15, 0}, {12, 3}
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests;
+    for (std::size_t i = 0; i < trips.size(); ++i)
+    {
+      requests.push_back(
+        rmf_task::requests::Delivery::make(
+          trips[i].first, delivery_wait, trips[i].second, delivery_wait,
+          {{}}, std::to_string(i), now));
+    }
+
+    // The margin also has to cover the trip from each dropoff back to the
+    // charger, which is a third of the length of a trip
+    auto options = greedy_options;
+    options.partial_charging(0.2);
+    REQUIRE(options.partial_charging_margin().has_value());
+    CHECK(*options.partial_charging_margin() == Approx(0.2));
+
+    TaskPlanner task_planner(task_config, options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    CHECK_TIMES(*assignments, now);
+    CHECK(TaskPlanner::compute_objectives(*assignments).num_requests
+      == requests.size());
+
+    // Charges never go past the recharge level, and every task still begins
+    // with enough charge to finish above the threshold. The charges that stop
+    // early carry their target, so they are carried out as planned.
+    std::size_t partial_charges = 0;
+    for (const auto& a : assignments->front())
+    {
+      const double soc = a.finish_state().battery_soc().value();
+      CHECK(soc <= constraints.recharge_soc() + 1e-6);
+      if (!a.is_charging())
+      {
+        CHECK(soc > constraints.threshold_soc());
+        continue;
+      }
+
+      const auto* charge = dynamic_cast<
+        const rmf_task::requests::ChargeBattery::Description*>(
+        a.request()->description().get());
+      REQUIRE(charge);
+      if (soc < constraints.recharge_soc() - 1e-3)
+      {
+        ++partial_charges;
+        REQUIRE(charge->target_soc().has_value());
+        CHECK(*charge->target_soc() == Approx(soc));
+      }
+      else
+      {
+        CHECK_FALSE(charge->target_soc().has_value());
+      }
+    }
+    CHECK(partial_charges > 0);
+  }
+
+  WHEN("An agent waits for a task next to its charger")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start location{now, 13, default_orientation};
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(location, 13, 0.5)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        12, delivery_wait, 3, delivery_wait, {{}}, "1",
+        now + std::chrono::hours(2))
+    };
+
+    TaskPlanner task_planner(task_config, greedy_options);
+    const auto result = task_planner.plan(now, initial_states, requests);
+    const auto assignments = std::get_if<TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    REQUIRE(assignments->front().size() == 1);
+    const auto& delivery = assignments->front().back();
+
+    auto options = greedy_options;
+    options.opportunistic_charging(std::chrono::minutes(10));
+    REQUIRE(options.opportunistic_charging_detour().has_value());
+
+    const auto charged_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto charged_assignments =
+      std::get_if<TaskPlanner::Assignments>(&charged_result);
+    REQUIRE(charged_assignments);
+    CHECK_TIMES(*charged_assignments, now);
+
+    // The agent charges while it waits and still finishes on time
+    const auto& agent = charged_assignments->front();
+    REQUIRE(agent.size() == 2);
+    CHECK(agent.front().is_charging());
+    const auto& charged_delivery = agent.back();
+    CHECK(charged_delivery.finish_state().time().value()
+      <= delivery.finish_state().time().value());
+    CHECK(charged_delivery.finish_state().battery_soc().value()
+      > delivery.finish_state().battery_soc().value());
+
+    // There is not enough time to charge fully, so the charge carries the
+    // level that it was planned to stop at
+    const auto& charge = agent.front();
+    const double charged_soc = charge.finish_state().battery_soc().value();
+    CHECK(charged_soc < constraints.recharge_soc());
+    const auto* charge_description = dynamic_cast<
+      const rmf_task::requests::ChargeBattery::Description*>(
+      charge.request()->description().get());
+    REQUIRE(charge_description);
+    REQUIRE(charge_description->target_soc().has_value());
+    CHECK(*charge_description->target_soc() == Approx(charged_soc));
+
+    // A charger that is too far away is not used
+    options.opportunistic_charging(std::chrono::seconds(0));
+    initial_states.front() = rmf_task::State().load_basic(
+      {now, 0, default_orientation}, 13, 0.5);
+    const auto far_result = task_planner.plan(
+      now, initial_states, requests, options);
+    const auto far_assignments =
+      std::get_if<TaskPlanner::Assignments>(&far_result);
+    REQUIRE(far_assignments);
+    CHECK(far_assignments->front().size() == 1);
+  }
+
+  WHEN("A trace sink is given to the planner")
+  {
+    class RecordingSink : public rmf_task::TraceSink
+    {
+    public:
+
+      void begin(const char* name) final
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++depth[std::this_thread::get_id()];
+        ++begun[name];
+      }
+
+      void end(const char* name) final
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Catch assertions are not thread-safe, so only count mismatches here
+        auto& d = depth[std::this_thread::get_id()];
+        if (d == 0)
+          ++unmatched;
+        else
+          --d;
+
+        ++ended[name];
+      }
+
+      std::mutex mutex;
+      std::map<std::thread::id, std::size_t> depth;
+      std::map<std::string, std::size_t> begun;
+      std::map<std::string, std::size_t> ended;
+      std::size_t unmatched = 0;
+    };
+
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 13, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 2, default_orientation};
+
+    std::vector<rmf_task::State> initial_states =
+    {
+      rmf_task::State().load_basic(first_location, 13, 1.0),
+      rmf_task::State().load_basic(second_location, 2, 1.0)
+    };
+
+    std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "1", now),
+      rmf_task::requests::Delivery::make(
+        15, delivery_wait, 2, delivery_wait, {{}}, "2", now),
+      rmf_task::requests::Delivery::make(
+        7, delivery_wait, 9, delivery_wait, {{}}, "3", now)
+    };
+
+    const auto untraced_result =
+      TaskPlanner(task_config, default_options).plan(
+      now, initial_states, requests);
+    const auto untraced_assignments =
+      std::get_if<TaskPlanner::Assignments>(&untraced_result);
+    REQUIRE(untraced_assignments);
+
+    auto threaded_options = default_options;
+    threaded_options.expansion_threads(4);
+    for (const auto& options : {default_options, threaded_options})
+    {
+      const auto sink = std::make_shared<RecordingSink>();
+      auto traced_config = task_config;
+      traced_config.trace_sink(sink);
+      CHECK(traced_config.trace_sink() == sink);
+      CHECK_FALSE(task_config.trace_sink());
+
+      TaskPlanner task_planner(traced_config, options);
+      const auto result = task_planner.plan(now, initial_states, requests);
+      const auto assignments =
+        std::get_if<TaskPlanner::Assignments>(&result);
+      REQUIRE(assignments);
+
+      // Tracing must not change the outcome of planning
+      CHECK(task_planner.compute_cost(*assignments)
+        == Approx(task_planner.compute_cost(*untraced_assignments)));
+
+      CHECK(sink->begun == sink->ended);
+      CHECK(sink->begun["make_initial_node"] == 1);
+      CHECK(sink->begun["expand"] > 0);
+      CHECK(sink->begun["TravelEstimator::miss"] > 0);
+      CHECK(sink->begun["solve"] + sink->begun["parallel_solve"]
+        == task_planner.statistics().segments());
+
+      CHECK(sink->unmatched == 0);
+      for (const auto& [thread, depth] : sink->depth)
+        CHECK(depth == 0);
+
+      // The greedy solver reports its own section
+      sink->begun.clear();
+      sink->ended.clear();
+      task_planner.plan(now, initial_states, requests, greedy_options);
+      CHECK(sink->begun == sink->ended);
+      CHECK(sink->begun["greedy_solve"]
+        == task_planner.statistics().segments());
+      CHECK(sink->begun["solve"] == 0);
+    }
+  }
+
+  WHEN("Travel is estimated from several threads at once")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const std::size_t N = graph.num_waypoints();
+    using Durations = std::vector<std::optional<rmf_traffic::Duration>>;
+
+    // Estimate every trip in the graph, beginning from a different trip for
+    // each offset so that the threads do not move in lockstep
+    const auto estimate_all =
+      [&](const rmf_task::TravelEstimator& estimator, std::size_t offset)
+      {
+        Durations durations(N*N);
+        for (std::size_t k = 0; k < N*N; ++k)
+        {
+          const std::size_t trip = (k + offset) % (N*N);
+          const auto result = estimator.estimate(
+            rmf_traffic::agv::Plan::Start{now, trip / N, 0.0},
+            rmf_traffic::agv::Plan::Goal{trip % N});
+
+          if (result.has_value())
+            durations[trip] = result->duration();
+        }
+
+        return durations;
+      };
+
+    const auto expected =
+      estimate_all(rmf_task::TravelEstimator(parameters), 0);
+
+    for (const std::size_t num_threads : {1, 2, 4, 8})
+    {
+      rmf_task::TravelEstimator estimator(parameters);
+      std::vector<Durations> results(num_threads);
+      std::vector<std::thread> threads;
+
+      const auto start_time = std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < num_threads; ++i)
+      {
+        threads.emplace_back(
+          [&, i]()
+          {
+            results[i] = estimate_all(estimator, i*N*N/num_threads);
+          });
+      }
+
+      for (auto& thread : threads)
+        thread.join();
+      const auto finish_time = std::chrono::steady_clock::now();
+
+      for (const auto& result : results)
+        CHECK(result == expected);
+
+      if (display_solutions)
+      {
+        std::cout << num_threads << " threads estimated "
+                  << num_threads*N*N << " trips in: "
+                  << (finish_time - start_time).count() / 1e9 << std::endl;
+      }
+    }
+
+    // Batches of goals should agree with estimating one trip at a time
+    {
+      rmf_task::TravelEstimator batched(parameters);
+      std::vector<rmf_traffic::agv::Plan::Start> starts;
+      std::vector<rmf_traffic::agv::Plan::Goal> goals;
+      for (std::size_t wp = 0; wp < N; ++wp)
+      {
+        starts.emplace_back(now, wp, 0.0);
+        goals.emplace_back(wp);
+      }
+
+      // Estimate one row first so the matrix mixes cached and new trips
+      const auto row = batched.estimate(starts[1], goals);
+      const auto matrix = batched.estimate(starts, goals);
+      REQUIRE(matrix.size() == N);
+      REQUIRE(row.size() == N);
+
+      Durations durations(N*N);
+      for (std::size_t i = 0; i < N; ++i)
+      {
+        REQUIRE(matrix[i].size() == N);
+        for (std::size_t j = 0; j < N; ++j)
+        {
+          if (matrix[i][j].has_value())
+            durations[i*N + j] = matrix[i][j]->duration();
+        }
+      }
+      CHECK(durations == expected);
+
+      for (std::size_t j = 0; j < N; ++j)
+      {
+        CHECK(row[j].has_value() == expected[N + j].has_value());
+        if (row[j].has_value())
+          CHECK(row[j]->duration() == *expected[N + j]);
+      }
+    }
+
+    // Orientation bins should tell apart trips that start facing different
+    // ways, but share the trips that round to the same bins
+    {
+      const rmf_traffic::agv::Plan::Start east{now, 0, 0.0};
+      const rmf_traffic::agv::Plan::Start nearly_east{now, 0, 0.1};
+      const rmf_traffic::agv::Plan::Start west{now, 0, M_PI};
+      const rmf_traffic::agv::Plan::Goal goal{N-1};
+      const rmf_traffic::agv::Plan::Goal goal_facing_west{N-1, M_PI};
+
+      rmf_task::TravelEstimator plain(parameters);
+      plain.estimate(east, goal);
+      plain.estimate(west, goal);
+      CHECK(plain.statistics().entries() == 1);
+
+      rmf_task::TravelEstimator oriented(parameters);
+      oriented.orientation_bins(8);
+      CHECK(oriented.orientation_bins() == 8);
+      const auto from_east = oriented.estimate(east, goal);
+      const auto from_nearly_east = oriented.estimate(nearly_east, goal);
+      CHECK(oriented.statistics().entries() == 1);
+      oriented.estimate(west, goal);
+      CHECK(oriented.statistics().entries() == 2);
+      oriented.estimate(east, goal_facing_west);
+      CHECK(oriented.statistics().entries() == 3);
+
+      REQUIRE(from_east.has_value());
+      REQUIRE(from_nearly_east.has_value());
+      CHECK(from_east->duration() == from_nearly_east->duration());
+      CHECK(from_east->duration() == *expected[N-1]);
+    }
+
+    // A cache with a capacity should give the same estimates while staying
+    // within its capacity
+    {
+      rmf_task::TravelEstimator unbounded(parameters);
+      CHECK(estimate_all(unbounded, 0) == expected);
+      CHECK(estimate_all(unbounded, 0) == expected);
+      const auto stats = unbounded.statistics();
+      CHECK(stats.misses() == N*N);
+      CHECK(stats.hits() == N*N);
+      CHECK(stats.evictions() == 0);
+      CHECK(stats.entries() == N*N);
+
+      rmf_task::TravelEstimator bounded(parameters);
+      bounded.capacity(N*N/4);
+      CHECK(bounded.capacity() == N*N/4);
+      CHECK(estimate_all(bounded, 0) == expected);
+      CHECK(estimate_all(bounded, 0) == expected);
+      const auto bounded_stats = bounded.statistics();
+      CHECK(bounded_stats.hits() + bounded_stats.misses() == 2*N*N);
+      CHECK(bounded_stats.evictions() > 0);
+      CHECK(bounded_stats.entries() <= N*N/4 + 32);
+
+      // Shrinking the capacity evicts right away
+      unbounded.capacity(1);
+      CHECK(unbounded.statistics().entries() <= 32);
+    }
+
+    // A miss should fill the rest of its row, and the filled rows should give
+    // the same estimates
+    {
+      std::vector<std::size_t> every_waypoint;
+      for (std::size_t wp = 0; wp < N; ++wp)
+        every_waypoint.push_back(wp);
+
+      rmf_task::TravelEstimator rows(parameters);
+      rows.row_goals(every_waypoint);
+      CHECK(rows.row_goals() == every_waypoint);
+      rows.estimate(
+        rmf_traffic::agv::Plan::Start{now, 0, 0.0},
+        rmf_traffic::agv::Plan::Goal{1});
+      CHECK(rows.statistics().entries() == N);
+      CHECK(estimate_all(rows, 0) == expected);
+      CHECK(rows.statistics().misses() == N*N);
+    }
+
+    // Approximate estimates should agree about which trips can be made, and
+    // switching modes should forget the estimates of the other mode
+    {
+      rmf_task::TravelEstimator approximate(parameters);
+      CHECK(approximate.mode() == rmf_task::TravelEstimator::Mode::Exact);
+      approximate.estimate(
+        rmf_traffic::agv::Plan::Start{now, 0, 0.0},
+        rmf_traffic::agv::Plan::Goal{1});
+      approximate.mode(rmf_task::TravelEstimator::Mode::Approximate);
+      CHECK(approximate.statistics().entries() == 0);
+
+      const auto durations = estimate_all(approximate, 0);
+      for (std::size_t trip = 0; trip < N*N; ++trip)
+      {
+        CHECK(durations[trip].has_value() == expected[trip].has_value());
+        if (durations[trip].has_value() && trip / N != trip % N)
+          CHECK(durations[trip]->count() > 0);
+      }
+    }
+
+    // Prefetched trips should be cached by the time that the prefetch is done
+    {
+      rmf_task::TravelEstimator estimator(parameters);
+      std::vector<std::pair<std::size_t, std::size_t>> trips;
+      for (std::size_t goal = 0; goal < N; ++goal)
+        trips.emplace_back(0, goal);
+      trips.emplace_back(N, 0);
+
+      estimator.prefetch(trips).wait();
+      CHECK(estimator.statistics().entries() == N);
+      const auto before = estimator.statistics();
+      for (std::size_t goal = 0; goal < N; ++goal)
+      {
+        const auto result = estimator.estimate(
+          rmf_traffic::agv::Plan::Start{now, 0, 0.0},
+          rmf_traffic::agv::Plan::Goal{goal});
+        CHECK(result.has_value() == expected[goal].has_value());
+      }
+      CHECK(estimator.statistics().since(before).misses() == 0);
+    }
+
+    // Forgetting the trips of a waypoint should keep the rest of the cache,
+    // apart from the trips that could not be planned
+    {
+      rmf_task::TravelEstimator estimator(parameters);
+      CHECK(estimate_all(estimator, 0) == expected);
+      std::size_t kept = 0;
+      for (std::size_t trip = 0; trip < N*N; ++trip)
+      {
+        if (trip / N != 0 && trip % N != 0 && expected[trip].has_value())
+          ++kept;
+      }
+
+      estimator.forget({0}, {});
+      CHECK(estimator.statistics().entries() == kept);
+      CHECK(estimate_all(estimator, 0) == expected);
+
+      // Unreachable trips get planned again once their lifetime is over
+      CHECK_FALSE(estimator.failed_plan_lifetime().has_value());
+      estimator.failed_plan_lifetime(rmf_traffic::Duration(0));
+      REQUIRE(estimator.failed_plan_lifetime().has_value());
+      const auto before = estimator.statistics();
+      CHECK(estimate_all(estimator, 0) == expected);
+      CHECK(estimator.statistics().since(before).misses()
+        == estimator.statistics().since(before).failed_plans());
+    }
+
+    // Congestion should scale the trips that start during its peak buckets
+    // without adding anything to the cache
+    {
+      using namespace std::chrono_literals;
+      using Congestion = rmf_task::TravelEstimator::Congestion;
+      Congestion congestion(now, 1h, 4);
+      congestion.waypoint_zone(0, 1).zone_multipliers(1, {1.0, 2.0});
+      CHECK(congestion.multiplier(0, 1, now) == 1.0);
+      CHECK(congestion.multiplier(1, 0, now + 90min) == 2.0);
+      CHECK(congestion.multiplier(1, 2, now + 90min) == 1.0);
+      CHECK(congestion.multiplier(0, 1, now + 5h + 30min) == 2.0);
+      CHECK(congestion.multiplier(0, 1, now - 2h - 30min) == 2.0);
+
+      rmf_task::TravelEstimator estimator(parameters);
+      CHECK_FALSE(estimator.congestion().has_value());
+      estimator.congestion(congestion);
+      REQUIRE(estimator.congestion().has_value());
+
+      const rmf_traffic::agv::Plan::Goal goal{N-1};
+      const auto off_peak = estimator.estimate(
+        rmf_traffic::agv::Plan::Start{now, 0, 0.0}, goal);
+      const auto peak = estimator.estimate(
+        rmf_traffic::agv::Plan::Start{now + 90min, 0, 0.0}, goal);
+      CHECK(estimator.statistics().misses() == 1);
+      CHECK(estimator.statistics().hits() == 1);
+      CHECK(estimator.statistics().entries() == 1);
+
+      REQUIRE(off_peak.has_value());
+      REQUIRE(peak.has_value());
+      CHECK(off_peak->duration() == *expected[N-1]);
+      CHECK(peak->duration() == 2 * *expected[N-1]);
+      CHECK(peak->change_in_charge() == off_peak->change_in_charge());
+
+      // Trips that stay out of the congested zone are unchanged
+      const auto elsewhere = estimator.estimate(
+        rmf_traffic::agv::Plan::Start{now + 90min, 1, 0.0}, goal);
+      REQUIRE(elsewhere.has_value());
+      CHECK(elsewhere->duration() == *expected[2*N-1]);
+
+      // A calibration corrects the trips that it has learned about
+      auto calibration = std::make_shared<rmf_task::Calibration>();
+      calibration->report(
+        rmf_task::Calibration::travel_type(), 1, N-1, 10s, 15s);
+      estimator.calibration(calibration);
+      const auto calibrated = estimator.estimate(
+        rmf_traffic::agv::Plan::Start{now, 1, 0.0}, goal);
+      REQUIRE(calibrated.has_value());
+      CHECK(calibrated->duration() == 3 * *expected[2*N-1] / 2);
+      CHECK(estimator.statistics().entries() == 2);
+    }
+
+    // Trips between floors should be combined from the trips to and from the
+    // portals instead of being cached for every pair of waypoints
+    {
+      auto floors_graph = graph;
+      for (std::size_t i = 0; i < N; ++i)
+      {
+        const Eigen::Vector2d p = graph.get_waypoint(i).get_location();
+        floors_graph.add_waypoint(
+          "upper_map", {p.x() + edge_length/2.0, p.y()});
+      }
+
+      for (std::size_t l = 0; l < graph.num_lanes(); ++l)
+      {
+        const auto& lane = graph.get_lane(l);
+        floors_graph.add_lane(
+          N + lane.entry().waypoint_index(), N + lane.exit().waypoint_index());
+      }
+
+      const std::size_t lower_portal = N-1;
+      const std::size_t upper_portal = 2*N-1;
+      floors_graph.add_lane(lower_portal, upper_portal);
+      floors_graph.add_lane(upper_portal, lower_portal);
+
+      auto floors_parameters = parameters;
+      floors_parameters.planner(
+        std::make_shared<rmf_traffic::agv::Planner>(
+          rmf_traffic::agv::Planner::Configuration{floors_graph, traits},
+          default_planner_options));
+
+      rmf_task::TravelEstimator plain(floors_parameters);
+      rmf_task::TravelEstimator split(floors_parameters);
+      CHECK_FALSE(split.split_by_floor());
+      split.split_by_floor(true);
+      CHECK(split.split_by_floor());
+
+      const auto leg = [&](std::size_t from, std::size_t to)
+        {
+          const auto result = plain.estimate(
+            rmf_traffic::agv::Plan::Start{now, from, 0.0},
+            rmf_traffic::agv::Plan::Goal{to});
+          REQUIRE(result.has_value());
+          return result->duration();
+        };
+
+      const auto across = split.estimate(
+        rmf_traffic::agv::Plan::Start{now, 0, 0.0},
+        rmf_traffic::agv::Plan::Goal{N});
+      REQUIRE(across.has_value());
+      CHECK(across->duration()
+        == leg(0, lower_portal) + leg(lower_portal, upper_portal)
+        + leg(upper_portal, N));
+
+      // Only the trips to, between and from the portals are cached
+      CHECK(split.statistics().entries() == 4);
+
+      // A batch gives the same estimates, and trips within a floor are
+      // estimated as usual
+      const std::vector<rmf_traffic::agv::Plan::Goal> goals = {
+        rmf_traffic::agv::Plan::Goal{N},
+        rmf_traffic::agv::Plan::Goal{1}
+      };
+      const auto batch = split.estimate(
+        rmf_traffic::agv::Plan::Start{now, 0, 0.0}, goals);
+      REQUIRE(batch.size() == 2);
+      REQUIRE(batch[0].has_value());
+      REQUIRE(batch[1].has_value());
+      CHECK(batch[0]->duration() == across->duration());
+      CHECK(batch[1]->duration() == leg(0, 1));
+    }
+
+    // A precomputed table should agree with the lazy estimates
+    rmf_task::TravelEstimator precomputed(parameters);
+    precomputed.precompute(4);
+    CHECK(estimate_all(precomputed, 0) == expected);
+
+    // Replanning some rows with an unchanged planner should change nothing
+    precomputed.update_planner(planner, {0, 5}, 2);
+    CHECK(estimate_all(precomputed, 0) == expected);
+
+    // Estimates that are saved to disk should load back into a cold estimator
+    const auto cache_file =
+      (std::filesystem::temp_directory_path() / "test_travel_estimates.bin")
+      .string();
+    precomputed.save(cache_file);
+    rmf_task::TravelEstimator warm(parameters);
+    REQUIRE(warm.load(cache_file));
+    CHECK(estimate_all(warm, 0) == expected);
+
+    // A cache that was saved for a different graph must be rejected
+    auto other_graph = graph;
+    other_graph.add_waypoint(map_name, {-edge_length, 0.0});
+    auto other_parameters = parameters;
+    other_parameters.planner(
+      std::make_shared<rmf_traffic::agv::Planner>(
+        rmf_traffic::agv::Planner::Configuration{other_graph, traits},
+        default_planner_options));
+    rmf_task::TravelEstimator stale(other_parameters);
+    CHECK_FALSE(stale.load(cache_file));
+    CHECK_FALSE(stale.load(cache_file + ".missing"));
+    std::filesystem::remove(cache_file);
+
+#ifdef __linux__
+    // A table that is shared through a file should be reused by the next
+    // estimator, and replaced for a different graph
+    const auto shared_file =
+      (std::filesystem::temp_directory_path() / "test_travel_table.bin")
+      .string();
+    std::filesystem::remove(shared_file);
+    rmf_task::TravelEstimator writer(parameters);
+    REQUIRE(writer.precompute_shared(shared_file, 2));
+    CHECK(estimate_all(writer, 0) == expected);
+
+    rmf_task::TravelEstimator reader(parameters);
+    REQUIRE(reader.precompute_shared(shared_file));
+    CHECK(reader.statistics().misses() == 0);
+    CHECK(estimate_all(reader, 0) == expected);
+
+    rmf_task::TravelEstimator other(other_parameters);
+    REQUIRE(other.precompute_shared(shared_file));
+    CHECK(estimate_all(reader, 0) == expected);
+    std::filesystem::remove(shared_file);
+    std::filesystem::remove(shared_file + ".lock");
+#endif
+  }
+
+  WHEN("Deliveries are pooled")
+  {
+    const auto now = std::chrono::steady_clock::now();
+    const double default_orientation = 0.0;
+
+    rmf_traffic::agv::Plan::Start first_location{now, 12, default_orientation};
+    rmf_traffic::agv::Plan::Start second_location{now, 15, default_orientation};
+
+    // Both deliveries end at the same dropoff and their pickups are next to
+    // each other, so one trip travels less than two
+    const std::vector<rmf_task::ConstRequestPtr> requests =
+    {
+      rmf_task::requests::Delivery::make(
+        0, delivery_wait, 3, delivery_wait, {{}}, "a", now),
+      rmf_task::requests::Delivery::make(
+        1, delivery_wait, 3, delivery_wait, {{}}, "b", now)
+    };
+
+    const auto plan = [&](uint32_t capacity)
+      {
+        const std::vector<rmf_task::State> initial_states =
+        {
+          rmf_task::State().load_basic(first_location, 12, 1.0)
+          .payload_capacity(capacity),
+          rmf_task::State().load_basic(second_location, 15, 1.0)
+          .payload_capacity(capacity)
+        };
+
+        auto options = default_options;
+        options.pool_deliveries(rmf_traffic::time::from_seconds(60.0));
+        TaskPlanner task_planner(task_config, options);
+        const auto result = task_planner.plan(now, initial_states, requests);
+        const auto* assignments =
+          std::get_if<TaskPlanner::Assignments>(&result);
+        REQUIRE(assignments);
+        CHECK_TIMES(*assignments, now);
+
+        std::vector<rmf_task::ConstRequestPtr> planned;
+        for (const auto& agent : *assignments)
+        {
+          for (const auto& assignment : agent)
+          {
+            if (!assignment.is_charging())
+              planned.push_back(assignment.request());
+          }
+        }
+
+        return planned;
+      };
+
+    const auto pooled = plan(2);
+    REQUIRE(pooled.size() == 1);
+    const auto* trip = dynamic_cast<
+      const rmf_task::requests::PooledDelivery::Description*>(
+      pooled.front()->description().get());
+    REQUIRE(trip);
+    CHECK(trip->deliveries() == requests);
+    CHECK(pooled.front()->booking()->id() == "a+b");
+
+    // Agents that can only carry one delivery make two trips
+    const auto separate = plan(1);
+    CHECK(separate.size() == 2);
+  }
 }
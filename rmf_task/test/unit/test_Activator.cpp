@@ -17,6 +17,8 @@
 
 #include <rmf_utils/catch.hpp>
 
+#include <rmf_task/requests/Clean.hpp>
+
 #include "../mock/MockDelivery.hpp"
 
 SCENARIO("Activate fresh task")
@@ -83,3 +85,137 @@ SCENARIO("Activate fresh task")
   REQUIRE(mock_restored->_restored_state.has_value());
   CHECK(mock_restored->_restored_state == backup->state());
 }
+
+SCENARIO("Dispatch by registered type")
+{
+  rmf_task::Activator activator;
+  activator.add_activator(test_rmf_task::MockDelivery::make_activator());
+
+  using namespace std::chrono_literals;
+  const auto delivery = rmf_task::requests::Delivery::make(
+    0, 1min, 1, 1min, {{}}, "request_0", rmf_traffic::Time());
+  const auto clean = rmf_task::requests::Clean::make(
+    0, 1, rmf_traffic::Trajectory(), "request_1", rmf_traffic::Time());
+
+  // Each type gets its own index, which stays the same once it is assigned
+  const auto delivery_index = delivery->description()->dispatch_index();
+  const auto clean_index = clean->description()->dispatch_index();
+  CHECK(delivery_index != clean_index);
+  CHECK(delivery->description()->dispatch_index() == delivery_index);
+  CHECK(
+    rmf_task::detail::DispatchIndex::of(
+      typeid(rmf_task::requests::Delivery::Description)) == delivery_index);
+
+  // A type that has no activator is not dispatched to any other
+  const auto active = activator.activate(
+    nullptr,
+    nullptr,
+    *clean,
+    [](auto) {},
+    [](auto) {},
+    [](auto) {},
+    []() {});
+  CHECK_FALSE(active);
+}
+
+SCENARIO("Activate a batch of tasks")
+{
+  rmf_task::Activator activator;
+  activator.add_activator(test_rmf_task::MockDelivery::make_activator());
+
+  using namespace std::chrono_literals;
+  const std::vector<rmf_task::ConstRequestPtr> requests = {
+    rmf_task::requests::Delivery::make(
+      0, 1min, 1, 1min, {{}}, "request_0", rmf_traffic::Time()),
+    rmf_task::requests::Clean::make(
+      0, 1, rmf_traffic::Trajectory(), "request_1", rmf_traffic::Time()),
+    rmf_task::requests::Delivery::make(
+      1, 1min, 0, 1min, {{}}, "request_2", rmf_traffic::Time())
+  };
+
+  std::vector<std::size_t> updated;
+  const auto actives = activator.activate_batch(
+    nullptr,
+    nullptr,
+    requests,
+    [&updated](std::size_t index, auto) { updated.push_back(index); },
+    [](std::size_t, auto) {},
+    [](std::size_t, auto) {},
+    [](std::size_t) {});
+
+  REQUIRE(actives.size() == 3);
+  CHECK(actives[0]);
+  CHECK_FALSE(actives[1]);
+  REQUIRE(actives[2]);
+
+  // Each task tells the shared callbacks which request it belongs to
+  auto mock_active =
+    std::dynamic_pointer_cast<test_rmf_task::MockDelivery::Active>(actives[2]);
+  REQUIRE(mock_active);
+  mock_active->_active_phase->send_update();
+  REQUIRE(updated.size() == 1);
+  CHECK(updated.front() == 2);
+}
+
+namespace {
+class PlannedModel : public rmf_task::Task::Model
+{
+public:
+  std::optional<rmf_task::Estimate> estimate_finish(
+    const rmf_task::State&,
+    const rmf_task::Constraints&,
+    const rmf_task::TravelEstimator&) const final
+  {
+    return std::nullopt;
+  }
+
+  rmf_traffic::Duration invariant_duration() const final
+  {
+    return std::chrono::minutes(5);
+  }
+};
+} // anonymous namespace
+
+SCENARIO("Activate a task with a planned model")
+{
+  using namespace std::chrono_literals;
+  const auto request = rmf_task::requests::Delivery::make(
+    0, 1min, 1, 1min, {{}}, "request_0", rmf_traffic::Time());
+
+  rmf_task::Task::ConstModelPtr offered;
+  const auto mock_activator = test_rmf_task::MockDelivery::make_activator();
+  rmf_task::Activator activator;
+  activator.add_activator<rmf_task::requests::Delivery::Description>(
+    [&](
+      const auto& get_state,
+      const auto& parameters,
+      const auto& booking,
+      const auto& description,
+      rmf_task::Task::ConstModelPtr model,
+      auto backup_state,
+      auto update,
+      auto checkpoint,
+      auto phase_finished,
+      auto task_finished)
+    {
+      offered = std::move(model);
+      return mock_activator(
+        get_state, parameters, booking, description, std::move(backup_state),
+        std::move(update), std::move(checkpoint), std::move(phase_finished),
+        std::move(task_finished));
+    });
+
+  const rmf_task::Task::ConstModelPtr model =
+    std::make_shared<PlannedModel>();
+
+  const auto active = activator.activate(
+    nullptr, nullptr, *request, model,
+    [](auto) {}, [](auto) {}, [](auto) {}, []() {});
+  REQUIRE(active);
+  CHECK(offered == model);
+
+  activator.activate(
+    nullptr, nullptr, *request,
+    [](auto) {}, [](auto) {}, [](auto) {}, []() {});
+  CHECK_FALSE(offered);
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/AllocationCounter.hpp>
+
+#include <memory>
+
+#include <rmf_utils/catch.hpp>
+
+using AllocationCounter = rmf_task::AllocationCounter;
+using Subsystem = AllocationCounter::Subsystem;
+
+//==============================================================================
+SCENARIO("Allocation counter")
+{
+  WHEN("Scopes are nested")
+  {
+    CHECK(AllocationCounter::current() == Subsystem::Other);
+    {
+      const AllocationCounter::Scope planner(Subsystem::Planner);
+      CHECK(AllocationCounter::current() == Subsystem::Planner);
+      {
+        const AllocationCounter::Scope log(Subsystem::Log);
+        CHECK(AllocationCounter::current() == Subsystem::Log);
+      }
+      CHECK(AllocationCounter::current() == Subsystem::Planner);
+    }
+    CHECK(AllocationCounter::current() == Subsystem::Other);
+  }
+
+  WHEN("Allocations are made inside a scope")
+  {
+    const auto before = AllocationCounter::this_thread();
+    const auto all_before = AllocationCounter::all_threads();
+    {
+      const AllocationCounter::Scope scope(Subsystem::Estimator);
+      const auto value = std::make_unique<double>(1.0);
+      CHECK(*value == 1.0);
+    }
+
+    const auto counts = AllocationCounter::this_thread().since(before);
+    const auto all = AllocationCounter::all_threads().since(all_before);
+    if (AllocationCounter::enabled())
+    {
+      CHECK(counts.allocations(Subsystem::Estimator) == 1);
+      CHECK(counts.bytes(Subsystem::Estimator) == sizeof(double));
+      CHECK(counts.allocations(Subsystem::Planner) == 0);
+      CHECK(all.allocations(Subsystem::Estimator) >= 1);
+    }
+    else
+    {
+      CHECK(counts.total_allocations() == 0);
+      CHECK(all.total_allocations() == 0);
+    }
+  }
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <src/rmf_task/AssignmentHeuristic.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <rmf_utils/catch.hpp>
+
+namespace {
+
+//==============================================================================
+struct Task
+{
+  double earliest_start_time;
+  double invariant_duration;
+  std::vector<rmf_task::AssignmentHeuristic::Finish> finish_times;
+};
+
+//==============================================================================
+std::vector<Task> make_tasks(
+  std::mt19937& rng,
+  const std::size_t num_agents,
+  const std::size_t num_tasks)
+{
+  std::uniform_real_distribution<double> start(0.0, 3600.0);
+  std::uniform_real_distribution<double> duration(10.0, 900.0);
+  std::uniform_real_distribution<double> travel(0.0, 600.0);
+  std::bernoulli_distribution capable(0.8);
+
+  std::vector<Task> tasks;
+  for (std::size_t i = 0; i < num_tasks; ++i)
+  {
+    Task task{start(rng), duration(rng), {}};
+    for (std::size_t a = 0; a < num_agents; ++a)
+    {
+      if (a == 0 || capable(rng))
+      {
+        const double earliest_finish =
+          task.earliest_start_time + task.invariant_duration;
+        task.finish_times.push_back({a, earliest_finish + travel(rng)});
+      }
+    }
+
+    tasks.push_back(std::move(task));
+  }
+
+  return tasks;
+}
+
+//==============================================================================
+// The same bound, found by trying every order of the tasks in every queue
+double brute_force(const std::vector<Task>& tasks, std::size_t num_agents)
+{
+  const std::size_t n = tasks.size();
+  std::vector<double> deployment(
+    num_agents, std::numeric_limits<double>::infinity());
+  std::vector<double> shortest;
+  for (const auto& task : tasks)
+  {
+    shortest.push_back(task.invariant_duration);
+    for (const auto& [a, finish] : task.finish_times)
+      deployment[a] = std::min(deployment[a], finish - task.invariant_duration);
+  }
+
+  std::sort(shortest.begin(), shortest.end());
+  std::vector<double> in_front(n, 0.0);
+  for (std::size_t k = 1; k < n; ++k)
+    in_front[k] = in_front[k-1] + shortest[k-1];
+
+  std::vector<std::size_t> order(n);
+  for (std::size_t i = 0; i < n; ++i)
+    order[i] = i;
+
+  std::vector<std::size_t> queue_size(num_agents, 0);
+  double best = std::numeric_limits<double>::infinity();
+  const auto recurse = [&](const auto& self, std::size_t i, double cost)
+    {
+      if (i == n)
+      {
+        best = std::min(best, cost);
+        return;
+      }
+
+      const auto& task = tasks[order[i]];
+      for (const auto& [a, finish] : task.finish_times)
+      {
+        const std::size_t k = queue_size[a]++;
+        const double queued =
+          deployment[a] + in_front[k] + task.invariant_duration;
+        self(self, i + 1,
+          cost + std::max(finish, queued) - task.earliest_start_time);
+        --queue_size[a];
+      }
+    };
+
+  do
+  {
+    recurse(recurse, 0, 0.0);
+  } while (std::next_permutation(order.begin(), order.end()));
+
+  return best;
+}
+
+//==============================================================================
+double solve(const std::vector<Task>& tasks, std::size_t num_agents)
+{
+  rmf_task::AssignmentHeuristic heuristic(num_agents);
+  for (const auto& task : tasks)
+  {
+    heuristic.add(
+      task.earliest_start_time, task.invariant_duration, task.finish_times);
+  }
+
+  return heuristic.compute_cost();
+}
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Assignment heuristic")
+{
+  std::mt19937 rng(42);
+
+  WHEN("There are no tasks")
+  {
+    CHECK(solve({}, 3) == Approx(0.0));
+  }
+
+  WHEN("There is one task")
+  {
+    // The bound is exact when the task only has to wait for itself
+    const std::vector<Task> tasks = {{100.0, 50.0, {{0, 400.0}, {1, 250.0}}}};
+    CHECK(solve(tasks, 2) == Approx(150.0));
+  }
+
+  WHEN("Two tasks can only be done by the same agent")
+  {
+    // The second task has to wait until the first one is done
+    const std::vector<Task> tasks = {
+      {0.0, 100.0, {{0, 100.0}}},
+      {0.0, 100.0, {{0, 100.0}}}
+    };
+    CHECK(solve(tasks, 2) == Approx(100.0 + 200.0));
+  }
+
+  WHEN("Compared against trying every queue order")
+  {
+    for (const std::size_t num_agents : {1, 2, 3})
+    {
+      for (const std::size_t num_tasks : {1, 2, 4, 6})
+      {
+        const auto tasks = make_tasks(rng, num_agents, num_tasks);
+        CHECK(solve(tasks, num_agents)
+          == Approx(brute_force(tasks, num_agents)));
+      }
+    }
+  }
+
+  WHEN("Tasks are given as dense rows of finish times")
+  {
+    const std::size_t num_agents = 3;
+    const auto tasks = make_tasks(rng, num_agents, 8);
+    rmf_task::AssignmentHeuristic dense(num_agents);
+    for (const auto& task : tasks)
+    {
+      std::vector<double> row(
+        num_agents, std::numeric_limits<double>::infinity());
+      for (const auto& [a, finish] : task.finish_times)
+        row[a] = finish;
+
+      dense.add_row(
+        task.earliest_start_time, task.invariant_duration, row.data());
+    }
+
+    CHECK(dense.compute_cost() == Approx(solve(tasks, num_agents)));
+  }
+
+  WHEN("Compared against the invariant durations alone")
+  {
+    const auto tasks = make_tasks(rng, 4, 20);
+    double invariants = 0.0;
+    for (const auto& task : tasks)
+      invariants += task.invariant_duration;
+
+    CHECK(invariants <= solve(tasks, 4) + 1e-6);
+  }
+}
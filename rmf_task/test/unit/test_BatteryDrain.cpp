@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <src/rmf_task/BatteryDrain.hpp>
+
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+
+#include <vector>
+
+#include <rmf_utils/catch.hpp>
+
+namespace {
+
+//==============================================================================
+// A device whose drain grows faster than its run time
+class QuadraticDevicePowerSink : public rmf_battery::DevicePowerSink
+{
+public:
+
+  double compute_change_in_charge(const double run_time) const final
+  {
+    return 1e-8 * run_time * run_time;
+  }
+};
+
+//==============================================================================
+// A device that draws a constant power for short and very long run times, but
+// twice that power in between
+class SteppedDevicePowerSink : public rmf_battery::DevicePowerSink
+{
+public:
+
+  double compute_change_in_charge(const double run_time) const final
+  {
+    if (1.0 < run_time && run_time < 3600.0)
+      return 2e-6 * run_time;
+
+    return 1e-6 * run_time;
+  }
+};
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Battery drain is evaluated in batches")
+{
+  const std::vector<double> durations = {0.0, 12.5, 60.0, 3600.0, 7211.0};
+
+  WHEN("The ambient sink draws a constant power")
+  {
+    using namespace rmf_battery::agv;
+    auto battery_system = BatterySystem::make(24.0, 40.0, 8.8);
+    REQUIRE(battery_system);
+    auto power_system = PowerSystem::make(20.0);
+    REQUIRE(power_system);
+
+    const auto sink = std::make_shared<SimpleDevicePowerSink>(
+      *battery_system, *power_system);
+    CHECK(rmf_task::BatteryDrain::is_linear(*sink));
+
+    const rmf_task::BatteryDrain drain(nullptr, sink);
+
+    double expected_total = 0.0;
+    for (const double d : durations)
+    {
+      const double expected = sink->compute_change_in_charge(d);
+      CHECK(drain.ambient(d) == Approx(expected).epsilon(1e-12));
+      expected_total += expected;
+    }
+
+    CHECK(drain.ambient(durations) == Approx(expected_total).epsilon(1e-12));
+  }
+
+  WHEN("The ambient sink is not linear in time")
+  {
+    const auto sink = std::make_shared<QuadraticDevicePowerSink>();
+    const rmf_task::BatteryDrain drain(nullptr, sink);
+
+    // Summing the durations first would give a larger drain, so the sink must
+    // be asked about each duration separately
+    double expected_total = 0.0;
+    for (const double d : durations)
+    {
+      CHECK(drain.ambient(d) == sink->compute_change_in_charge(d));
+      expected_total += sink->compute_change_in_charge(d);
+    }
+
+    CHECK(drain.ambient(durations) == Approx(expected_total));
+  }
+
+  WHEN("The ambient sink agrees with a constant power at a few run times")
+  {
+    const auto sink = std::make_shared<SteppedDevicePowerSink>();
+    CHECK_FALSE(rmf_task::BatteryDrain::is_linear(*sink));
+    const rmf_task::BatteryDrain drain(nullptr, sink);
+
+    // Only the sink types that are known to be linear get the shortcut, no
+    // matter how the sink behaves at the run times that one might check
+    double expected_total = 0.0;
+    for (const double d : durations)
+    {
+      CHECK(drain.ambient(d) == sink->compute_change_in_charge(d));
+      expected_total += sink->compute_change_in_charge(d);
+    }
+
+    CHECK(drain.ambient(durations) == Approx(expected_total));
+  }
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/Calibration.hpp>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <rmf_utils/catch.hpp>
+
+using namespace std::chrono_literals;
+
+//==============================================================================
+SCENARIO("Calibrate estimates from completed work")
+{
+  rmf_task::Calibration calibration(64, 0.5);
+  const auto& travel = rmf_task::Calibration::travel_type();
+
+  WHEN("Nothing has been reported")
+  {
+    CHECK(calibration.factor(travel, 0, 1) == 1.0);
+    CHECK(calibration.samples(travel, 0, 1) == 0);
+    CHECK(calibration.version() == 0);
+  }
+
+  WHEN("Work is reported")
+  {
+    CHECK(calibration.report(travel, 0, 1, 10s, 20s));
+    CHECK(calibration.factor(travel, 0, 1) == Approx(2.0));
+
+    // Later reports are blended into a moving average
+    CHECK(calibration.report(travel, 0, 1, 10s, 10s));
+    CHECK(calibration.factor(travel, 0, 1) == Approx(1.5));
+    CHECK(calibration.samples(travel, 0, 1) == 2);
+    CHECK(calibration.version() == 2);
+
+    // Other types and directions are calibrated separately
+    CHECK(calibration.factor(travel, 1, 0) == 1.0);
+    CHECK(calibration.factor("open_door", 0, 1) == 1.0);
+  }
+
+  WHEN("Reports are out of bounds")
+  {
+    CHECK(calibration.report(travel, 0, 1, 10s, 1h));
+    CHECK(calibration.factor(travel, 0, 1) == Approx(4.0));
+    CHECK(calibration.report(travel, 2, 3, 10s, 0s));
+    CHECK(calibration.factor(travel, 2, 3) == Approx(0.5));
+
+    CHECK_FALSE(calibration.report(travel, 4, 5, 0s, 10s));
+    CHECK_FALSE(calibration.report(travel, 4, 5, 10s, -1s));
+    CHECK(calibration.samples(travel, 4, 5) == 0);
+
+    // Rejected reports leave the calibration unchanged
+    CHECK(calibration.version() == 2);
+  }
+
+  WHEN("The table is full")
+  {
+    std::size_t accepted = 0;
+    for (std::size_t wp = 0; wp < 1000; ++wp)
+    {
+      if (calibration.report(travel, wp, wp, 10s, 20s))
+        ++accepted;
+    }
+
+    CHECK(accepted <= 64);
+    CHECK(calibration.dropped() == 1000 - accepted);
+  }
+
+  WHEN("Work is reported from several threads at once")
+  {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+      threads.emplace_back(
+        [&]()
+        {
+          for (std::size_t wp = 0; wp < 16; ++wp)
+          {
+            for (std::size_t k = 0; k < 100; ++k)
+              calibration.report(travel, wp, wp + 1, 10s, 30s);
+          }
+        });
+    }
+
+    for (auto& thread : threads)
+      thread.join();
+
+    for (std::size_t wp = 0; wp < 16; ++wp)
+    {
+      CHECK(calibration.samples(travel, wp, wp + 1) == 400);
+      CHECK(calibration.factor(travel, wp, wp + 1) == Approx(3.0));
+    }
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/CompositeDataCodec.hpp>
+#include <rmf_task/State.hpp>
+
+#include <rmf_utils/catch.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <string>
+
+SCENARIO("Encoding and decoding composite data")
+{
+  rmf_task::CompositeDataCodec codec;
+
+  const auto now = std::chrono::steady_clock::now();
+  rmf_task::State state;
+  state.load_basic({now, 7, 1.5}, 3, 0.75);
+  state.payload_capacity(4);
+
+  WHEN("A state is passed through a buffer")
+  {
+    std::string buffer;
+    const std::size_t written = codec.encode(state, buffer);
+    CHECK(written == buffer.size());
+
+    rmf_task::State decoded;
+    CHECK(codec.decode(buffer, decoded) == written);
+    CHECK(decoded.waypoint() == 7);
+    CHECK(decoded.orientation() == 1.5);
+    CHECK(decoded.time() == now);
+    CHECK(decoded.dedicated_charging_waypoint() == 3);
+    CHECK(decoded.battery_soc() == 0.75);
+    CHECK(decoded.payload_capacity() == 4);
+  }
+
+  WHEN("Several records are written one after another")
+  {
+    rmf_task::State other;
+    other.waypoint(11);
+
+    std::string buffer;
+    codec.encode(state, buffer);
+    codec.encode(other, buffer);
+
+    rmf_task::State first;
+    rmf_task::State second;
+    const std::size_t used = codec.decode(buffer, first);
+    CHECK(codec.decode(std::string_view(buffer).substr(used), second)
+      == buffer.size() - used);
+    CHECK(first.waypoint() == 7);
+    CHECK(second.waypoint() == 11);
+    CHECK_FALSE(second.battery_soc().has_value());
+  }
+
+  WHEN("A custom component is registered")
+  {
+    RMF_TASK_DEFINE_COMPONENT(std::string, Label);
+    codec.add<Label>(
+      1000, 2,
+      [](const Label& label, std::string& buffer)
+      {
+        buffer.append(label.value);
+      },
+      [](std::string_view data, std::uint16_t version)
+      -> std::optional<Label>
+      {
+        if (version != 2)
+          return std::nullopt;
+        return Label(std::string(data));
+      });
+
+    state.insert_or_assign(Label("cart"));
+    std::string buffer;
+    codec.encode(state, buffer);
+
+    rmf_task::State decoded;
+    codec.decode(buffer, decoded);
+    REQUIRE(decoded.get<Label>());
+    CHECK(decoded.get<Label>()->value == "cart");
+    CHECK(decoded.waypoint() == 7);
+
+    // A codec that does not know the component skips it
+    rmf_task::State skipped;
+    rmf_task::CompositeDataCodec().decode(buffer, skipped);
+    CHECK_FALSE(skipped.get<Label>());
+    CHECK(skipped.waypoint() == 7);
+
+    // Tags cannot be shared by different kinds of components
+    CHECK_THROWS_AS(
+      codec.add<Label>(
+        1, 1,
+        [](const Label&, std::string&) {},
+        [](std::string_view, std::uint16_t) { return std::nullopt; }),
+      std::invalid_argument);
+  }
+
+  WHEN("A record is cut off")
+  {
+    std::string buffer;
+    codec.encode(state, buffer);
+
+    rmf_task::State decoded;
+    CHECK_THROWS_AS(
+      codec.decode(std::string_view(buffer).substr(0, buffer.size() - 1),
+      decoded),
+      std::runtime_error);
+    CHECK_THROWS_AS(
+      codec.decode(std::string_view(buffer).substr(0, 3), decoded),
+      std::runtime_error);
+  }
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <src/rmf_task/DeliveryPooling.hpp>
+
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/PooledDelivery.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <rmf_utils/catch.hpp>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+//==============================================================================
+// The waypoints are spread along a line, ten seconds apart
+std::optional<rmf_traffic::Duration> travel(
+  std::size_t from, std::size_t to, rmf_traffic::Time)
+{
+  const auto distance = from < to ? to - from : from - to;
+  return std::chrono::seconds(10 * distance);
+}
+
+//==============================================================================
+rmf_task::ConstRequestPtr make_delivery(
+  const std::string& id,
+  std::size_t pickup,
+  std::size_t dropoff,
+  rmf_traffic::Time start,
+  std::vector<std::string> compartments = {"bin"})
+{
+  std::vector<rmf_task::Payload::Component> components;
+  for (auto& compartment : compartments)
+    components.emplace_back("sku", 1, std::move(compartment));
+
+  return rmf_task::requests::Delivery::make(
+    pickup, 10s, dropoff, 10s, rmf_task::Payload(std::move(components)),
+    id, start);
+}
+
+//==============================================================================
+const rmf_task::requests::PooledDelivery::Description* get_pooled(
+  const rmf_task::ConstRequestPtr& request)
+{
+  return dynamic_cast<const rmf_task::requests::PooledDelivery::Description*>(
+    request->description().get());
+}
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Pool deliveries")
+{
+  const auto now = std::chrono::steady_clock::now();
+  const auto a = make_delivery("a", 0, 10, now);
+  const auto b = make_delivery("b", 1, 11, now + 1min);
+  const std::vector<rmf_task::ConstRequestPtr> requests = {a, b};
+
+  WHEN("The agents can only carry one delivery")
+  {
+    const auto pooled = rmf_task::pool_deliveries(requests, 1, 1h, travel);
+    CHECK(pooled == requests);
+  }
+
+  WHEN("Deliveries go the same way")
+  {
+    const auto pooled = rmf_task::pool_deliveries(requests, 2, 1h, travel);
+    REQUIRE(pooled.size() == 1);
+    CHECK(pooled[0]->booking()->id() == "a+b");
+    CHECK(pooled[0]->booking()->earliest_start_time() == now + 1min);
+
+    const auto* description = get_pooled(pooled[0]);
+    REQUIRE(description);
+    CHECK(description->deliveries() == requests);
+  }
+
+  WHEN("Deliveries go opposite ways")
+  {
+    const auto back = make_delivery("back", 10, 0, now);
+    const auto pooled =
+      rmf_task::pool_deliveries({a, back}, 2, 1h, travel);
+    CHECK(pooled.size() == 2);
+  }
+
+  WHEN("Deliveries begin too far apart")
+  {
+    const auto pooled =
+      rmf_task::pool_deliveries(requests, 2, 30s, travel);
+    CHECK(pooled == requests);
+  }
+
+  WHEN("Deliveries need more compartments than there are")
+  {
+    const auto big = make_delivery("big", 1, 11, now, {"left", "right"});
+    CHECK(rmf_task::compartments(*big) == 2);
+
+    CHECK(rmf_task::pool_deliveries({a, big}, 2, 1h, travel).size() == 2);
+    CHECK(rmf_task::pool_deliveries({a, big}, 3, 1h, travel).size() == 1);
+  }
+
+  WHEN("Only some of the deliveries can be pooled")
+  {
+    const auto c = make_delivery("c", 20, 30, now + 2h);
+    const auto d = make_delivery("d", 2, 12, now + 2min);
+    const auto pooled =
+      rmf_task::pool_deliveries({c, a, b, d}, 2, 1h, travel);
+
+    // The pool takes the place of its first delivery
+    REQUIRE(pooled.size() == 3);
+    CHECK(pooled[0] == c);
+    CHECK(pooled[1]->booking()->id() == "a+b");
+    CHECK(pooled[2] == d);
+  }
+}
+
+//==============================================================================
+SCENARIO("Payload capacity of a fleet")
+{
+  std::vector<rmf_task::State> agents(2);
+  CHECK(rmf_task::payload_capacity(agents) == 1);
+
+  agents[0].payload_capacity(4);
+  CHECK(rmf_task::payload_capacity(agents) == 1);
+
+  agents[1].payload_capacity(3);
+  CHECK(rmf_task::payload_capacity(agents) == 3);
+}
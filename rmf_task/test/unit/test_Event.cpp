@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/events/SimpleEventState.hpp>
+
+using rmf_task::Event;
+using rmf_task::events::SimpleEventState;
+
+SCENARIO("Tracking changes in a tree of events")
+{
+  const auto leaf_a = SimpleEventState::make(
+    1, "Go to place 12", "", Event::Status::Underway);
+  const auto leaf_b = SimpleEventState::make(
+    2, "Wait", "", Event::Status::Standby);
+  const auto root = SimpleEventState::make(
+    0, "Sequence", "", Event::Status::Underway, {leaf_a, leaf_b});
+
+  auto version = root->version();
+  CHECK(root->version() == version);
+
+  const auto snapshot = Event::Snapshot::make(*root);
+  CHECK(snapshot->version() == version);
+  CHECK(Event::Snapshot::make(*root, snapshot) == snapshot);
+
+  WHEN("A leaf changes")
+  {
+    leaf_b->update_status(Event::Status::Underway);
+    CHECK(root->version() > version);
+    CHECK(leaf_b->version() == root->version());
+
+    const auto next = Event::Snapshot::make(*root, snapshot);
+    REQUIRE(next != snapshot);
+    CHECK(next->status() == Event::Status::Underway);
+
+    // The unchanged leaf is reused, while the changed one is made anew
+    const auto old_deps = snapshot->dependencies();
+    const auto new_deps = next->dependencies();
+    REQUIRE(new_deps.size() == 2);
+    CHECK(new_deps[0] == old_deps[0]);
+    CHECK(new_deps[1] != old_deps[1]);
+    CHECK(new_deps[1]->status() == Event::Status::Underway);
+  }
+
+  WHEN("Setting a status that it already has")
+  {
+    leaf_a->update_status(Event::Status::Underway);
+    CHECK(root->version() == version);
+  }
+
+  WHEN("A leaf logs something")
+  {
+    leaf_a->update_log().info("Arrived");
+    CHECK(root->version() > version);
+    version = root->version();
+    CHECK(root->version() == version);
+  }
+
+  WHEN("The dependencies change")
+  {
+    root->update_dependencies({leaf_a});
+    CHECK(root->version() > version);
+    REQUIRE(root->current_dependencies().size() == 1);
+    CHECK(root->current_dependencies()[0] == leaf_a);
+
+    const auto next = Event::Snapshot::make(*root, snapshot);
+    REQUIRE(next->dependencies().size() == 1);
+    CHECK(next->dependencies()[0] == snapshot->dependencies()[0]);
+  }
+
+  WHEN("The dependencies are reordered")
+  {
+    root->update_dependencies({leaf_b, leaf_a});
+
+    // Unchanged events are still reused after they move
+    const auto next = Event::Snapshot::make(*root, snapshot);
+    REQUIRE(next->dependencies().size() == 2);
+    CHECK(next->dependencies()[0] == snapshot->dependencies()[1]);
+    CHECK(next->dependencies()[1] == snapshot->dependencies()[0]);
+  }
+
+  WHEN("The name changes")
+  {
+    root->update_name("Renamed");
+    CHECK(root->version() > version);
+  }
+}
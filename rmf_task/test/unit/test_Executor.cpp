@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/Executor.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+SCENARIO("Running jobs on a work-stealing pool")
+{
+  const auto pool = rmf_task::Executor::make_thread_pool(3);
+  CHECK(pool->concurrency() == 3);
+
+  WHEN("Jobs are posted")
+  {
+    std::atomic_size_t count = 0;
+    std::promise<void> all_done;
+    for (std::size_t i = 0; i < 100; ++i)
+    {
+      pool->post([&]()
+        {
+          if (++count == 100)
+            all_done.set_value();
+        });
+    }
+
+    CHECK(all_done.get_future().wait_for(std::chrono::seconds(10))
+      == std::future_status::ready);
+  }
+
+  WHEN("A batch is run")
+  {
+    std::vector<std::atomic_size_t> visits(1000);
+    pool->parallel_for(
+      visits.size(), [&](std::size_t i) { ++visits[i]; });
+
+    for (const auto& v : visits)
+      CHECK(v == 1);
+  }
+
+  WHEN("Batches are nested inside the jobs of a single worker")
+  {
+    // Every thread that waits on a batch runs the batch itself, so this
+    // finishes even though the only worker is busy with the outer batch
+    const auto single = rmf_task::Executor::make_thread_pool(1);
+    std::atomic_size_t count = 0;
+    single->parallel_for(
+      4, [&](std::size_t)
+      {
+        single->parallel_for(8, [&](std::size_t) { ++count; });
+      });
+
+    CHECK(count == 32);
+  }
+
+  WHEN("A job throws")
+  {
+    CHECK_THROWS_AS(
+      pool->parallel_for(
+        50, [](std::size_t i)
+        {
+          if (i == 10)
+            throw std::runtime_error("failed");
+        }),
+      std::runtime_error);
+
+    // The pool keeps working afterwards
+    std::atomic_size_t count = 0;
+    pool->parallel_for(20, [&](std::size_t) { ++count; });
+    CHECK(count == 20);
+  }
+}
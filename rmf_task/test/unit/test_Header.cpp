@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/Header.hpp>
+
+//==============================================================================
+SCENARIO("Header details can be formatted lazily")
+{
+  std::size_t formatted = 0;
+  const rmf_task::Header header(
+    "Waiting",
+    [&]()
+    {
+      ++formatted;
+      return std::string("Waiting for [5] seconds to elapse");
+    },
+    std::chrono::seconds(5));
+
+  CHECK(header.category() == "Waiting");
+  CHECK(header.original_duration_estimate() == std::chrono::seconds(5));
+  CHECK(formatted == 0);
+
+  WHEN("The detail is read more than once")
+  {
+    CHECK(header.detail() == "Waiting for [5] seconds to elapse");
+    CHECK(header.detail() == "Waiting for [5] seconds to elapse");
+    CHECK(formatted == 1);
+
+    // A copy of a formatted header does not format the detail again
+    const auto copy = header;
+    CHECK(copy.detail() == header.detail());
+    CHECK(formatted == 1);
+  }
+
+  WHEN("A copy is made before the detail is read")
+  {
+    const auto copy = header;
+    CHECK(copy.detail() == "Waiting for [5] seconds to elapse");
+    CHECK(header.detail() == copy.detail());
+    CHECK(formatted == 2);
+  }
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <src/rmf_task/InvariantHeuristicQueue.hpp>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <rmf_utils/catch.hpp>
+
+namespace {
+
+//==============================================================================
+// The original implementation of InvariantHeuristicQueue, which keeps every
+// stack and moves the front stack into place with a linear scan. It is kept
+// here as a reference for the cost of the heap-based queue.
+class LinearInvariantQueue
+{
+public:
+
+  LinearInvariantQueue(std::vector<double> initial_values)
+  {
+    std::sort(initial_values.begin(), initial_values.end());
+    for (const auto value : initial_values)
+      _stacks.push_back({{0, value}});
+  }
+
+  void add(const double earliest_start_time, const double earliest_finish_time)
+  {
+    const double new_end_value = _stacks[0].back().end +
+      (earliest_finish_time - earliest_start_time);
+    _stacks[0].push_back({earliest_start_time, new_end_value});
+
+    const auto next_it = _stacks.begin() + 1;
+    auto end_it = next_it;
+    for (; end_it != _stacks.end(); ++end_it)
+    {
+      if (new_end_value <= end_it->back().end)
+        break;
+    }
+
+    if (next_it != end_it)
+      std::rotate(_stacks.begin(), next_it, end_it);
+  }
+
+  double compute_cost() const
+  {
+    double total_cost = 0.0;
+    for (const auto& stack : _stacks)
+    {
+      for (std::size_t i = 1; i < stack.size(); ++i)
+        total_cost += std::max(0.0, (stack[i].end - stack[i].start));
+    }
+
+    return total_cost;
+  }
+
+private:
+  struct element { double start; double end; };
+  std::vector<std::vector<element>> _stacks;
+};
+
+//==============================================================================
+struct Problem
+{
+  std::vector<double> initial_values;
+  std::vector<std::pair<double, double>> invariants;
+};
+
+//==============================================================================
+Problem make_problem(
+  std::mt19937& rng,
+  const std::size_t num_agents,
+  const std::size_t num_tasks)
+{
+  std::uniform_real_distribution<double> initial(0.0, 600.0);
+  std::uniform_real_distribution<double> start(0.0, 3600.0);
+  std::uniform_real_distribution<double> duration(10.0, 900.0);
+
+  Problem problem;
+  for (std::size_t i = 0; i < num_agents; ++i)
+    problem.initial_values.push_back(initial(rng));
+
+  for (std::size_t i = 0; i < num_tasks; ++i)
+  {
+    const double s = start(rng);
+    problem.invariants.push_back({s, s + duration(rng)});
+  }
+
+  // The planner always adds the invariants in order of their finish times
+  std::sort(problem.invariants.begin(), problem.invariants.end(),
+    [](const auto& a, const auto& b) { return a.second < b.second; });
+
+  return problem;
+}
+
+//==============================================================================
+template<typename Queue>
+double solve(const Problem& problem)
+{
+  Queue queue(problem.initial_values);
+  for (const auto& [s, f] : problem.invariants)
+    queue.add(s, f);
+
+  return queue.compute_cost();
+}
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Invariant heuristic queue")
+{
+  std::mt19937 rng(42);
+
+  WHEN("Compared against the linear implementation")
+  {
+    for (const std::size_t num_agents : {1, 2, 5, 17, 64})
+    {
+      for (const std::size_t num_tasks : {0, 1, 10, 100})
+      {
+        const auto problem = make_problem(rng, num_agents, num_tasks);
+        CHECK(solve<rmf_task::InvariantHeuristicQueue>(problem)
+          == Approx(solve<LinearInvariantQueue>(problem)));
+      }
+    }
+  }
+
+  WHEN("Tasks finish before they start")
+  {
+    rmf_task::InvariantHeuristicQueue queue({100.0, 0.0});
+    queue.add(50.0, 60.0);
+    queue.add(500.0, 510.0);
+    CHECK(queue.compute_cost() == Approx(0.0));
+  }
+}
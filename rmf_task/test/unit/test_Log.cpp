@@ -19,13 +19,18 @@
 
 #include <rmf_task/Log.hpp>
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <random>
 #include <iostream>
+#include <memory_resource>
 #include <thread>
 #include <mutex>
 #include <atomic>
 #include <condition_variable>
 #include <optional>
+#include <vector>
 
 SCENARIO("Writing and reading logs")
 {
@@ -67,6 +72,44 @@ SCENARIO("Writing and reading logs")
   CHECK(count == expected_count);
 }
 
+//==============================================================================
+SCENARIO("Reading a long log in pieces")
+{
+  rmf_task::Log log;
+  rmf_task::Log::Reader reader;
+
+  // Views that end right before, on, and right after the boundaries between
+  // chunks of entries must all pick up exactly where the last one stopped
+  const std::vector<std::size_t> view_sizes =
+  {1, 63, 64, 65, 127, 128, 129, 500, 1000};
+
+  std::size_t pushed = 0;
+  std::size_t read = 0;
+  for (const std::size_t size : view_sizes)
+  {
+    for (; pushed < size; ++pushed)
+      log.info(std::string(pushed % 40, 'x'));
+
+    for (const auto& entry : reader.read(log.view()))
+    {
+      CHECK(entry.seq() == read);
+      CHECK(entry.text().size() == read % 40);
+      ++read;
+    }
+
+    CHECK(read == size);
+  }
+
+  std::size_t count = 0;
+  for (const auto& entry : rmf_task::Log::Reader().read(log.view()))
+  {
+    CHECK(entry.seq() == count);
+    ++count;
+  }
+
+  CHECK(count == view_sizes.back());
+}
+
 struct SyncView
 {
   bool ready_for_new_view = false;
@@ -247,3 +290,562 @@ SCENARIO("Multi-threaded read/write without syncing")
     ++index;
   }
 }
+
+//==============================================================================
+SCENARIO("Many producers pushing and inserting at once")
+{
+  rmf_task::Log log;
+
+  const std::size_t num_producers = 4;
+  const std::size_t entries_per_producer = 5000;
+
+  std::vector<std::thread> producers;
+  for (std::size_t p = 0; p < num_producers; ++p)
+  {
+    producers.emplace_back(
+      [&log, p, entries_per_producer]()
+      {
+        rmf_task::Log other;
+        rmf_task::Log::Reader other_reader;
+        for (std::size_t i = 0; i < entries_per_producer; ++i)
+        {
+          const std::string text =
+            std::to_string(p) + ":" + std::to_string(i);
+
+          // Half of the entries arrive through insert() to make sure it is
+          // as safe to use concurrently as push()
+          if (i % 2 == 0)
+          {
+            log.info(text);
+          }
+          else
+          {
+            other.info(text);
+            for (const auto& entry : other_reader.read(other.view()))
+              log.insert(entry);
+          }
+        }
+      });
+  }
+
+  std::size_t read = 0;
+  std::thread consumer(
+    [&log, &read, total = num_producers * entries_per_producer]()
+    {
+      rmf_task::Log::Reader reader;
+      while (read < total)
+      {
+        for (const auto& entry : reader.read(log.view()))
+        {
+          (void)entry;
+          ++read;
+        }
+      }
+    });
+
+  for (auto& producer : producers)
+    producer.join();
+
+  consumer.join();
+  CHECK(read == num_producers * entries_per_producer);
+
+  // Pushed entries are numbered in the order they appear in the log, while
+  // inserted entries keep the seq they were given by their original log. Each
+  // producer's own entries must come out in the order it wrote them.
+  std::optional<uint32_t> last_pushed_seq;
+  std::vector<std::size_t> next(num_producers, 0);
+  for (const auto& entry : rmf_task::Log::Reader().read(log.view()))
+  {
+    const auto split = entry.text().find(':');
+    const std::size_t p = std::stoul(entry.text().substr(0, split));
+    const std::size_t i = std::stoul(entry.text().substr(split + 1));
+    CHECK(i == next[p]);
+    next[p] = i + 1;
+
+    if (i % 2 == 0)
+    {
+      if (last_pushed_seq.has_value())
+        CHECK(*last_pushed_seq < entry.seq());
+
+      last_pushed_seq = entry.seq();
+    }
+  }
+
+  for (const auto n : next)
+    CHECK(n == entries_per_producer);
+}
+
+//==============================================================================
+SCENARIO("Logs with a retention policy")
+{
+  auto now = rmf_traffic::Time(std::chrono::seconds(0));
+  rmf_task::Log log([&now]() { return now; });
+  CHECK_FALSE(log.retention().max_entries().has_value());
+  CHECK_FALSE(log.retention().max_bytes().has_value());
+  CHECK_FALSE(log.retention().max_age().has_value());
+
+  WHEN("The number of entries is limited")
+  {
+    log.retention(rmf_task::Log::Retention().max_entries(100));
+    REQUIRE(log.retention().max_entries().has_value());
+    CHECK(*log.retention().max_entries() == 100);
+
+    rmf_task::Log::Reader reader;
+    std::size_t pushed = 0;
+    for (; pushed < 50; ++pushed)
+      log.info(std::to_string(pushed));
+
+    std::size_t read = 0;
+    auto iterable = reader.read(log.view());
+    CHECK(iterable.dropped() == 0);
+    for (const auto& entry : iterable)
+    {
+      CHECK(entry.seq() == read);
+      ++read;
+    }
+    CHECK(read == pushed);
+
+    // Hold on to a view while the log drops its old entries
+    const auto old_view = log.view();
+
+    for (; pushed < 10000; ++pushed)
+      log.info(std::to_string(pushed));
+
+    iterable = reader.read(log.view());
+    const std::size_t dropped = iterable.dropped();
+    CHECK(dropped > 0);
+
+    std::size_t kept = 0;
+    std::size_t expected_seq = read + dropped;
+    for (const auto& entry : iterable)
+    {
+      CHECK(entry.seq() == expected_seq);
+      CHECK(entry.text() == std::to_string(expected_seq));
+      ++expected_seq;
+      ++kept;
+    }
+
+    CHECK(expected_seq == pushed);
+    CHECK(kept >= 100);
+    CHECK(kept < 200);
+
+    // The old view can still be read in full by a fresh reader
+    std::size_t old_count = 0;
+    for (const auto& entry : rmf_task::Log::Reader().read(old_view))
+    {
+      CHECK(entry.seq() == old_count);
+      ++old_count;
+    }
+    CHECK(old_count == 50);
+
+    // Nothing new has been pushed, so nothing more was dropped
+    iterable = reader.read(log.view());
+    CHECK(iterable.dropped() == 0);
+    CHECK(iterable.begin() == iterable.end());
+  }
+
+  WHEN("The size of the text is limited")
+  {
+    log.retention(rmf_task::Log::Retention().max_bytes(1000));
+    for (std::size_t i = 0; i < 1000; ++i)
+      log.info(std::string(10, 'x'));
+
+    std::size_t bytes = 0;
+    rmf_task::Log::Reader reader;
+    auto iterable = reader.read(log.view());
+    CHECK(iterable.dropped() > 0);
+    for (const auto& entry : iterable)
+      bytes += entry.text().size();
+
+    CHECK(bytes <= 1000);
+    CHECK(bytes > 0);
+  }
+
+  WHEN("The age of entries is limited")
+  {
+    log.retention(
+      rmf_task::Log::Retention().max_age(std::chrono::seconds(10)));
+
+    for (std::size_t i = 0; i < 1000; ++i)
+    {
+      now += std::chrono::seconds(1);
+      log.info(std::to_string(i));
+    }
+
+    std::size_t count = 0;
+    rmf_task::Log::Reader reader;
+    auto iterable = reader.read(log.view());
+    CHECK(iterable.dropped() > 0);
+    for (const auto& entry : iterable)
+    {
+      // Old entries are dropped a whole chunk at a time, so the oldest kept
+      // entry may be older than the limit, but not older than a chunk of
+      // entries beyond it
+      CHECK(now - entry.time() <= std::chrono::seconds(10 + 2*64));
+      ++count;
+    }
+
+    CHECK(count > 0);
+    CHECK(count < 1000);
+  }
+
+  WHEN("Dropped entries are archived")
+  {
+    // Tests may run side by side, so each run gets a file of its own
+    std::string path;
+    std::random_device device;
+    do
+    {
+      path = (std::filesystem::temp_directory_path()
+        / ("test_log_archive_" + std::to_string(device()) + ".bin")).string();
+    } while (std::filesystem::exists(path));
+
+    log.retention(
+      rmf_task::Log::Retention().max_entries(100).archive(path));
+    REQUIRE(log.retention().archive().has_value());
+    CHECK(*log.retention().archive() == path);
+
+    for (std::size_t i = 0; i < 1000; ++i)
+      log.info(std::to_string(i));
+
+    rmf_task::Log::Reader reader;
+    auto iterable = reader.read(log.view());
+    const std::size_t dropped = iterable.dropped();
+    CHECK(dropped > 0);
+
+    // The dropped entries can be paged back in, oldest first, once they have
+    // been written in the background
+    std::size_t expected_seq = 0;
+    while (true)
+    {
+      const auto page = reader.read_archived(log.view(), 100);
+      if (page.empty())
+        break;
+
+      CHECK(page.size() <= 100);
+      for (const auto& entry : page)
+      {
+        CHECK(entry.seq() == expected_seq);
+        CHECK(entry.text() == std::to_string(expected_seq));
+        CHECK(entry.time() == now);
+        ++expected_seq;
+      }
+    }
+    CHECK(expected_seq == dropped);
+    CHECK(std::filesystem::file_size(path) > 0);
+
+    // Entries that are dropped after the next read are paged in from where
+    // the reader left off
+    for (std::size_t i = 1000; i < 2000; ++i)
+      log.info(std::to_string(i));
+
+    const std::size_t first_kept = dropped;
+    std::size_t read = 0;
+    for (const auto& entry : iterable)
+    {
+      CHECK(entry.seq() == first_kept + read);
+      ++read;
+    }
+
+    iterable = reader.read(log.view());
+    CHECK(iterable.dropped() > 0);
+    expected_seq = first_kept + read;
+    for (const auto& entry : reader.read_archived(log.view(), 10000))
+    {
+      CHECK(entry.seq() == expected_seq);
+      ++expected_seq;
+    }
+    CHECK(expected_seq == first_kept + read + iterable.dropped());
+    CHECK(reader.read_archived(log.view(), 10000).empty());
+
+    // A reader that never fell behind has nothing to page in
+    CHECK(rmf_task::Log::Reader().read_archived(log.view(), 10).empty());
+
+    std::filesystem::remove(path);
+  }
+
+  WHEN("The archive cannot be opened")
+  {
+    CHECK_THROWS_AS(
+      log.retention(
+        rmf_task::Log::Retention().archive("/nonexistent/directory/log.bin")),
+      std::runtime_error);
+  }
+
+  WHEN("The archive stops taking entries")
+  {
+    // Writing to /dev/full always fails because the device is out of space
+    if (std::filesystem::exists("/dev/full"))
+    {
+      log.retention(
+        rmf_task::Log::Retention().max_entries(100).archive("/dev/full"));
+
+      // Few enough entries that the report of the failure is not dropped too
+      for (std::size_t i = 0; i < 200; ++i)
+        log.info(std::to_string(i));
+
+      rmf_task::Log::Reader reader;
+      CHECK(reader.read(log.view()).dropped() > 0);
+
+      // Nothing can be paged in, and the failure is reported in the log
+      CHECK(reader.read_archived(log.view(), 1000).empty());
+
+      // The failure may have been reported before the first read, so look
+      // through everything that the log still keeps
+      std::size_t errors = 0;
+      rmf_task::Log::Reader all;
+      for (const auto& entry : all.read(log.view()))
+      {
+        if (entry.tier() == rmf_task::Log::Tier::Error
+          && entry.text().find("/dev/full") != std::string::npos)
+        {
+          ++errors;
+        }
+      }
+      CHECK(errors == 1);
+    }
+  }
+}
+
+//==============================================================================
+SCENARIO("Memory usage of logs")
+{
+  rmf_task::Log log;
+  CHECK(log.memory_usage() == 0);
+
+  for (std::size_t i = 0; i < 100; ++i)
+    log.info(std::string(100, 'x'));
+
+  const auto full = log.memory_usage();
+  CHECK(full >= 100*100);
+
+  // A view that is held on to keeps its entries in memory
+  const auto old_view = log.view();
+  CHECK(old_view.memory_usage() == full);
+
+  log.retention(rmf_task::Log::Retention().max_entries(10));
+  for (std::size_t i = 0; i < 1000; ++i)
+    log.info(std::string(100, 'x'));
+
+  CHECK(log.memory_usage() < full);
+  CHECK(old_view.memory_usage() == full);
+}
+
+//==============================================================================
+namespace {
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+  std::atomic_size_t allocations = 0;
+  std::atomic_size_t deallocations = 0;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) final
+  {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) final
+  {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const
+  noexcept final
+  {
+    return this == &other;
+  }
+};
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Logs with a memory resource")
+{
+  CountingResource resource;
+  {
+    rmf_task::Log log(nullptr, &resource);
+    const auto first = resource.allocations.load();
+    CHECK(first > 0);
+
+    for (std::size_t i = 0; i < 1000; ++i)
+      log.info("entry " + std::to_string(i));
+
+    // Chunks beyond the first one come from the resource
+    CHECK(resource.allocations > first);
+
+    rmf_task::Log::Reader reader;
+    std::size_t count = 0;
+    std::size_t last = 0;
+    for (const auto& entry : reader.read(log.view()))
+    {
+      CHECK(entry.text() == "entry " + std::to_string(count));
+      last = entry.seq();
+      ++count;
+    }
+    CHECK(count == 1000);
+    CHECK(last == 999);
+  }
+
+  // Everything is given back to the resource once the log is gone
+  CHECK(resource.allocations == resource.deallocations);
+}
+
+//==============================================================================
+SCENARIO("Reading logs into a buffer")
+{
+  const auto time = rmf_traffic::Time(std::chrono::milliseconds(1234));
+  rmf_task::Log log([time]() { return time; });
+  log.info("plain");
+  log.warn("with \"quotes\"\nand\ta \\ backslash");
+  log.error(std::string("control\x01"));
+
+  rmf_task::Log::Reader reader;
+
+  WHEN("Writing JSON lines")
+  {
+    std::string buffer = "existing\n";
+    CHECK(reader.read_into(log.view(), buffer) == 3);
+
+    const std::string expected =
+      "existing\n"
+      "{\"seq\":0,\"tier\":\"info\",\"unix_millis_time\":1234,"
+      "\"text\":\"plain\"}\n"
+      "{\"seq\":1,\"tier\":\"warning\",\"unix_millis_time\":1234,"
+      "\"text\":\"with \\\"quotes\\\"\\nand\\ta \\\\ backslash\"}\n"
+      "{\"seq\":2,\"tier\":\"error\",\"unix_millis_time\":1234,"
+      "\"text\":\"control\\u0001\"}\n";
+    CHECK(buffer == expected);
+
+    // Everything has been read now
+    CHECK(reader.read_into(log.view(), buffer) == 0);
+    CHECK(buffer == expected);
+    CHECK(reader.read(log.view()).begin() == reader.read(log.view()).end());
+  }
+
+  WHEN("Writing binary records")
+  {
+    std::string buffer;
+    CHECK(reader.read_into(
+        log.view(), buffer, rmf_task::Log::Reader::Format::Binary) == 3);
+
+    std::size_t offset = 0;
+    const auto take = [&](auto& value)
+      {
+        REQUIRE(offset + sizeof(value) <= buffer.size());
+        std::memcpy(&value, buffer.data() + offset, sizeof(value));
+        offset += sizeof(value);
+      };
+
+    std::vector<std::string> texts;
+    for (uint32_t expected_seq = 0; expected_seq < 3; ++expected_seq)
+    {
+      uint32_t seq;
+      uint32_t tier;
+      int64_t nanos;
+      uint32_t size;
+      take(seq);
+      take(tier);
+      take(nanos);
+      take(size);
+      CHECK(seq == expected_seq);
+      CHECK(tier == expected_seq + 1);
+      CHECK(nanos == 1234000000);
+      REQUIRE(offset + size <= buffer.size());
+      texts.push_back(buffer.substr(offset, size));
+      offset += size;
+    }
+
+    CHECK(offset == buffer.size());
+    CHECK(texts[0] == "plain");
+    CHECK(texts[1] == "with \"quotes\"\nand\ta \\ backslash");
+    CHECK(texts[2] == std::string("control\x01"));
+  }
+
+  WHEN("Writing many logs at once")
+  {
+    rmf_task::Log other;
+    other.info("first");
+    other.info("second");
+
+    std::string buffer;
+    auto counts = reader.read_into({log.view(), other.view()}, buffer);
+    REQUIRE(counts.size() == 2);
+    CHECK(counts[0] == 3);
+    CHECK(counts[1] == 2);
+    CHECK(std::count(buffer.begin(), buffer.end(), '\n') == 5);
+    CHECK(buffer.find("\"text\":\"second\"}\n") == buffer.size() - 17);
+
+    other.info("third");
+    buffer.clear();
+    counts = reader.read_into({log.view(), other.view()}, buffer);
+    REQUIRE(counts.size() == 2);
+    CHECK(counts[0] == 0);
+    CHECK(counts[1] == 1);
+    CHECK(buffer.find("\"seq\":2") != std::string::npos);
+    CHECK(buffer.find("third") != std::string::npos);
+  }
+}
+
+//==============================================================================
+SCENARIO("Logs with a tier threshold")
+{
+  rmf_task::Log log;
+  rmf_task::Log::Reader reader;
+  std::size_t formatted = 0;
+  const auto format = [&formatted](const std::string& name, int value)
+    {
+      ++formatted;
+      return name + " = " + std::to_string(value);
+    };
+
+  WHEN("Nothing is set")
+  {
+    CHECK(log.threshold() == rmf_task::Log::Tier::Info);
+    log.debug("hidden");
+    log.push_deferred(rmf_task::Log::Tier::Debug, format, "x", 1);
+    log.push_deferred(rmf_task::Log::Tier::Info, format, "y", 2);
+    log.info("shown");
+
+    CHECK(formatted == 1);
+    CHECK(log.entry_count() == 2);
+
+    std::vector<std::string> texts;
+    for (const auto& entry : reader.read(log.view()))
+      texts.push_back(entry.text());
+
+    REQUIRE(texts.size() == 2);
+    CHECK(texts[0] == "y = 2");
+    CHECK(texts[1] == "shown");
+  }
+
+  WHEN("Debugging entries are asked for")
+  {
+    log.threshold(rmf_task::Log::Tier::Debug);
+    CHECK(log.enabled(rmf_task::Log::Tier::Debug));
+    log.push_deferred(rmf_task::Log::Tier::Debug, format, "x", 1);
+    CHECK(formatted == 1);
+
+    std::string buffer;
+    CHECK(reader.read_into(log.view(), buffer) == 1);
+    CHECK(buffer.find("\"tier\":\"debug\"") != std::string::npos);
+  }
+
+  WHEN("Only errors are kept")
+  {
+    log.threshold(rmf_task::Log::Tier::Error);
+    CHECK_FALSE(log.enabled(rmf_task::Log::Tier::Warning));
+    log.info("info");
+    log.warn("warning");
+    log.error("error");
+    CHECK(log.entry_count() == 1);
+  }
+
+  WHEN("The tier is uninitialized")
+  {
+    CHECK_THROWS(log.push_deferred(
+        rmf_task::Log::Tier::Uninitialized, format, "x", 1));
+    CHECK(formatted == 0);
+  }
+}
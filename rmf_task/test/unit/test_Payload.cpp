@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/Payload.hpp>
+
+using rmf_task::Payload;
+
+//==============================================================================
+SCENARIO("Describe payloads")
+{
+  WHEN("The payload is empty")
+  {
+    CHECK(Payload({}).brief() == "nothing");
+  }
+
+  WHEN("There is one type of item in one compartment")
+  {
+    const Payload payload({
+      Payload::Component("soda", 2, "left"),
+      Payload::Component("soda", 3, "left")
+    });
+
+    CHECK(payload.brief() == "5 of [soda] in [left]");
+    CHECK(payload.brief("into") == "5 of [soda] into [left]");
+  }
+
+  WHEN("There are several types of items in several compartments")
+  {
+    const Payload payload({
+      Payload::Component("soda", 2, "left"),
+      Payload::Component("chips", 1, "right"),
+      Payload::Component("soda", 4, "right")
+    });
+
+    CHECK(payload.brief()
+      == "2 types of items (7 total units) in 2 compartments");
+  }
+
+  WHEN("Components share names")
+  {
+    const Payload::Component first("soda", 1, "left");
+    const Payload::Component second("soda", 2, "right");
+
+    // Names are only stored once
+    CHECK(&first.sku() == &second.sku());
+    CHECK(&first.compartment() != &second.compartment());
+    CHECK(second.compartment() == "right");
+
+    const Payload payload({first, second});
+    const auto copy = payload;
+    CHECK(&copy.components() == &payload.components());
+    CHECK(copy.components().at(1).quantity() == 2);
+  }
+}
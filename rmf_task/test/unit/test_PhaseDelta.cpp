@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/PhaseDelta.hpp>
+#include <rmf_task/events/SimpleEventState.hpp>
+
+#include <string>
+
+using rmf_task::Event;
+using rmf_task::Phase;
+using rmf_task::PhaseDelta;
+using rmf_task::events::SimpleEventState;
+
+namespace {
+
+//==============================================================================
+class MockPhase : public Phase::Active
+{
+public:
+
+  MockPhase(Phase::ConstTagPtr tag, Event::ConstStatePtr event)
+  : _tag(std::move(tag)),
+    _event(std::move(event))
+  {
+    // Do nothing
+  }
+
+  Phase::ConstTagPtr tag() const final
+  {
+    return _tag;
+  }
+
+  Event::ConstStatePtr final_event() const final
+  {
+    return _event;
+  }
+
+  rmf_traffic::Duration estimate_remaining_time() const final
+  {
+    return rmf_traffic::Duration(0);
+  }
+
+private:
+  Phase::ConstTagPtr _tag;
+  Event::ConstStatePtr _event;
+};
+
+//==============================================================================
+std::size_t count_lines(const std::string& buffer)
+{
+  std::size_t lines = 0;
+  for (const char c : buffer)
+  {
+    if (c == '\n')
+      ++lines;
+  }
+
+  return lines;
+}
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Encode the changes between snapshots of a phase")
+{
+  const auto leaf_a = SimpleEventState::make(
+    1, "Go to place 12", "", Event::Status::Underway);
+  const auto leaf_b = SimpleEventState::make(
+    2, "Wait", "", Event::Status::Standby);
+  const auto root = SimpleEventState::make(
+    0, "Sequence", "", Event::Status::Underway, {leaf_a, leaf_b});
+
+  const MockPhase phase(
+    std::make_shared<Phase::Tag>(
+      7, rmf_task::Header("Phase", "", rmf_traffic::Duration(0))),
+    root);
+
+  PhaseDelta delta;
+  std::string buffer;
+
+  // The first snapshot is written in full
+  CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 3);
+  CHECK(count_lines(buffer) == 3);
+  CHECK(buffer.find("\"name\":\"Go to place 12\"") != std::string::npos);
+  CHECK(buffer.find("\"dependencies\":[1,2]") != std::string::npos);
+
+  // Nothing is written while nothing changes
+  buffer.clear();
+  CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 0);
+  CHECK(buffer.empty());
+
+  WHEN("A leaf logs something and changes its status")
+  {
+    leaf_a->update_log().info("Arrived");
+    leaf_a->update_status(Event::Status::Completed);
+
+    buffer.clear();
+    CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 1);
+    CHECK(count_lines(buffer) == 2);
+    CHECK(buffer.find("\"event\":1") != std::string::npos);
+    CHECK(buffer.find("\"status\":\"completed\"") != std::string::npos);
+    CHECK(buffer.find("\"log\":1") != std::string::npos);
+    CHECK(buffer.find("\"text\":\"Arrived\"") != std::string::npos);
+    CHECK(buffer.find("\"name\"") == std::string::npos);
+  }
+
+  WHEN("A name changes")
+  {
+    leaf_b->update_name("Wait for the lift");
+
+    buffer.clear();
+    CHECK(delta.encode(
+        *Phase::Snapshot::make(phase), buffer,
+        PhaseDelta::Format::Binary) == 1);
+
+    // The phase, event and version, the bits of the changes, and the name
+    const std::string name = "Wait for the lift";
+    CHECK(buffer.size() == 3*8 + 4 + 4 + name.size());
+    CHECK(buffer.substr(buffer.size() - name.size()) == name);
+  }
+
+  WHEN("The dependencies change")
+  {
+    root->update_dependencies({leaf_b});
+
+    buffer.clear();
+    CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 1);
+    CHECK(buffer.find("\"dependencies\":[2]") != std::string::npos);
+  }
+
+  WHEN("The phase is forgotten")
+  {
+    delta.forget(7);
+    buffer.clear();
+    CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 3);
+
+    delta.reset();
+    buffer.clear();
+    CHECK(delta.encode(*Phase::Snapshot::make(phase), buffer) == 3);
+  }
+}
@@ -0,0 +1,416 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/PlanningProblem.hpp>
+#include <rmf_task/PlanningService.hpp>
+#include <rmf_task/BinaryPriorityScheme.hpp>
+#include <rmf_task/requests/ChargeBattery.hpp>
+#include <rmf_task/requests/ChargeBatteryFactory.hpp>
+#include <rmf_task/requests/Clean.hpp>
+#include <rmf_task/requests/Delivery.hpp>
+#include <rmf_task/requests/Loop.hpp>
+#include <rmf_task/requests/PooledDelivery.hpp>
+
+#include <rmf_traffic/agv/Graph.hpp>
+#include <rmf_traffic/agv/Planner.hpp>
+#include <rmf_traffic/agv/VehicleTraits.hpp>
+#include <rmf_traffic/geometry/Circle.hpp>
+#include <rmf_traffic/Profile.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+
+#include <rmf_utils/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+
+namespace {
+
+using namespace std::chrono_literals;
+
+//==============================================================================
+rmf_task::TaskPlanner::Configuration make_configuration(
+  const rmf_traffic::agv::Graph& graph)
+{
+  using namespace rmf_battery::agv;
+
+  const auto shape = rmf_traffic::geometry::make_final_convex<
+    rmf_traffic::geometry::Circle>(1.0);
+  const rmf_traffic::Profile profile{shape, shape};
+  const rmf_traffic::agv::VehicleTraits traits(
+    {1.0, 0.7}, {0.6, 0.5}, profile);
+
+  auto planner = std::make_shared<rmf_traffic::agv::Planner>(
+    rmf_traffic::agv::Planner::Configuration{graph, traits},
+    rmf_traffic::agv::Planner::Options{nullptr});
+
+  const auto battery_system = *BatterySystem::make(24.0, 40.0, 8.8);
+  const auto mechanical_system = *MechanicalSystem::make(70.0, 40.0, 0.22);
+  const auto power_system = *PowerSystem::make(20.0);
+
+  const rmf_task::Parameters parameters{
+    planner,
+    battery_system,
+    std::make_shared<SimpleMotionPowerSink>(
+      battery_system, mechanical_system),
+    std::make_shared<SimpleDevicePowerSink>(
+      battery_system, power_system)};
+
+  return rmf_task::TaskPlanner::Configuration{
+    parameters,
+    rmf_task::Constraints{0.2, 0.9, true},
+    rmf_task::BinaryPriorityScheme::make_cost_calculator(2.0)};
+}
+
+//==============================================================================
+// Plans each cluster in this process, but reports that every search was
+// interrupted and pruned
+class FlaggingSolver : public rmf_task::TaskPlanner::ClusterSolver
+{
+public:
+
+  FlaggingSolver(rmf_task::TaskPlanner::Configuration config_)
+  : config(std::move(config_))
+  {
+    // Do nothing
+  }
+
+  Solution solve(
+    rmf_traffic::Time time_now,
+    const std::vector<rmf_task::State>& agents,
+    const std::vector<rmf_task::ConstRequestPtr>& requests,
+    const rmf_task::TaskPlanner::Options& options) const final
+  {
+    rmf_task::TaskPlanner planner(config, options);
+    return Solution{planner.plan(time_now, agents, requests), true, true};
+  }
+
+  std::size_t concurrency() const final
+  {
+    return 1;
+  }
+
+  rmf_task::TaskPlanner::Configuration config;
+};
+
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Capture and replay a planning problem")
+{
+  using namespace rmf_task::requests;
+
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint("L1", {0.0, 0.0}).set_charger(true);
+  graph.add_waypoint("L1", {10.0, 0.0});
+  graph.add_waypoint("L1", {10.0, 10.0});
+  graph.add_key("corner", 2);
+  graph.add_lane(0, 1);
+  graph.add_lane(1, 0);
+  graph.add_lane(1, 2);
+  graph.add_lane(2, 1);
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto config = make_configuration(graph);
+
+  std::vector<rmf_task::State> agents(2);
+  agents[0].load_basic({now, 0, 0.0}, 0, 0.8);
+  agents[1].load_basic({now + 5s, 2, 1.5}, 0, 0.5).payload_capacity(3);
+
+  rmf_traffic::Trajectory path;
+  path.insert(now + 10s, {10.0, 0.0, 0.0}, Eigen::Vector3d::Zero());
+  path.insert(now + 30s, {10.0, 10.0, 0.0}, Eigen::Vector3d::Zero());
+
+  const auto a = Delivery::make(
+    0, 10s, 2, 20s,
+    rmf_task::Payload({{"soda", 2, "left"}, {"chips", 1, "right"}}),
+    "a", now + 1min,
+    rmf_task::BinaryPriorityScheme::make_high_priority());
+  const auto b = Delivery::make(
+    1, 10s, 2, 10s, {{}}, "b", now + 2min, "dispatcher", now - 1min);
+  const std::vector<rmf_task::ConstRequestPtr> requests = {
+    a,
+    Clean::make(1, 2, path, "clean", now),
+    Loop::make(0, 2, 3, "loop", now + 30s, nullptr, true),
+    ChargeBattery::make(now + 1h),
+    PooledDelivery::make({a, b}),
+    ChargeBattery::make(now + 2h, nullptr, true, 0.6)
+  };
+
+  auto options = rmf_task::TaskPlanner::Options(
+    true, nullptr, std::make_shared<ChargeBatteryFactory>());
+  options.deterministic_seed(7).time_budget(2s).pool_deliveries(5min);
+
+  const rmf_task::PlanningProblem problem(
+    config, options, now, agents, requests);
+  const auto json = problem.serialize();
+  CHECK(json["graph_hash"].get<std::string>().size() == 16);
+
+  WHEN("The problem is replayed at a later time")
+  {
+    const auto later = now + 24h;
+    const auto replay = rmf_task::PlanningProblem::deserialize(
+      nlohmann::json::parse(json.dump()), later);
+
+    THEN("It serializes the same way")
+    {
+      CHECK(replay.serialize() == json);
+      CHECK(replay.graph_hash() == problem.graph_hash());
+    }
+
+    THEN("Its times keep their offsets")
+    {
+      CHECK(replay.time_now() == later);
+      REQUIRE(replay.agents().size() == 2);
+      CHECK(replay.agents()[1].time() == later + 5s);
+      CHECK(replay.agents()[1].payload_capacity() == 3u);
+      CHECK(replay.options().deadline() == std::nullopt);
+      CHECK(replay.options().deterministic_seed() == 7u);
+
+      REQUIRE(replay.requests().size() == requests.size());
+      const auto& booking = *replay.requests()[1]->booking();
+      CHECK(booking.id() == "clean");
+      CHECK(booking.earliest_start_time() == later);
+
+      const auto& delivery = *replay.requests()[0]->booking();
+      CHECK(delivery.earliest_start_time() == later + 1min);
+      CHECK(delivery.priority() != nullptr);
+
+      const auto* charge = dynamic_cast<const ChargeBattery::Description*>(
+        replay.requests().back()->description().get());
+      REQUIRE(charge);
+      CHECK(charge->target_soc() == 0.6);
+    }
+  }
+
+  WHEN("The capture is from before some options were added")
+  {
+    auto older = json;
+    for (const auto* key : {
+        "break_agent_symmetry", "agent_symmetry_soc_tolerance",
+        "agent_symmetry_time_tolerance", "break_request_symmetry",
+        "prune_dominated_nodes", "partial_charging_margin",
+        "opportunistic_charging_detour"})
+    {
+      REQUIRE(older["options"].contains(key));
+      older["options"].erase(key);
+    }
+
+    const auto replay = rmf_task::PlanningProblem::deserialize(older, now);
+    CHECK(replay.serialize() == json);
+  }
+
+  WHEN("The graph was changed")
+  {
+    auto changed = json;
+    changed["parameters"]["graph"]["waypoints"][1][1] = 11.0;
+    CHECK_THROWS_AS(
+      rmf_task::PlanningProblem::deserialize(changed, now),
+      std::runtime_error);
+  }
+
+  WHEN("The capture is malformed")
+  {
+    auto changed = json;
+    changed["requests"][0].erase("pickup");
+    CHECK_THROWS_AS(
+      rmf_task::PlanningProblem::deserialize(changed, now),
+      std::runtime_error);
+    CHECK_THROWS_AS(
+      rmf_task::PlanningProblem::deserialize(nlohmann::json::array(), now),
+      std::runtime_error);
+  }
+
+  WHEN("A request cannot be captured")
+  {
+    class Custom : public rmf_task::Task::Description
+    {
+    public:
+      rmf_task::Task::ConstModelPtr make_model(
+        rmf_traffic::Time, const rmf_task::Parameters&) const final
+      {
+        return nullptr;
+      }
+
+      Info generate_info(
+        const rmf_task::State&, const rmf_task::Parameters&) const final
+      {
+        return {};
+      }
+    };
+
+    const rmf_task::PlanningProblem custom(
+      config, options, now, agents,
+      {std::make_shared<rmf_task::Request>(
+          "custom", now, nullptr, std::make_shared<Custom>())});
+    CHECK_THROWS_AS(custom.serialize(), std::invalid_argument);
+  }
+}
+
+//==============================================================================
+SCENARIO("Plan a captured problem across several workers")
+{
+  using namespace rmf_task::requests;
+
+  rmf_traffic::agv::Graph graph;
+  graph.add_waypoint("L1", {0.0, 0.0}).set_charger(true);
+  graph.add_waypoint("L1", {10.0, 0.0});
+  graph.add_waypoint("L1", {10.0, 10.0});
+  graph.add_waypoint("L1", {0.0, 10.0}).set_charger(true);
+  for (std::size_t i = 0; i < 4; ++i)
+  {
+    graph.add_lane(i, (i + 1) % 4);
+    graph.add_lane((i + 1) % 4, i);
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto config = make_configuration(graph);
+
+  std::vector<rmf_task::State> agents(4);
+  agents[0].load_basic({now, 0, 0.0}, 0, 0.9);
+  agents[1].load_basic({now, 1, 0.0}, 0, 0.6);
+  agents[2].load_basic({now, 2, 0.0}, 3, 0.8);
+  agents[3].load_basic({now, 3, 0.0}, 3, 0.7);
+
+  std::vector<rmf_task::ConstRequestPtr> requests;
+  for (std::size_t i = 0; i < 9; ++i)
+  {
+    requests.push_back(
+      Delivery::make(
+        i % 4, 10s, (i + 2) % 4, 10s, {{}}, "delivery" + std::to_string(i),
+        now + std::chrono::minutes(i)));
+  }
+
+  auto options = rmf_task::TaskPlanner::Options(
+    true, nullptr, std::make_shared<ChargeBatteryFactory>());
+  options.deterministic_seed(11);
+
+  // Two clusters of agents, and a third cluster of requests without any
+  // agents that are planned for everyone once the clusters are merged
+  const rmf_task::TaskPlanner::Partitioner partitioner =
+    [](
+    const std::vector<rmf_task::State>& agents,
+    const std::vector<rmf_task::ConstRequestPtr>& requests)
+    {
+      rmf_task::TaskPlanner::Partition partition;
+      for (std::size_t a = 0; a < agents.size(); ++a)
+        partition.agent_clusters.push_back(a % 2);
+      for (std::size_t r = 0; r < requests.size(); ++r)
+        partition.request_clusters.push_back(r % 3);
+      return partition;
+    };
+
+  const rmf_task::PlanningProblem problem(
+    config, options, now, agents, requests);
+
+  auto local_config = config;
+  local_config.partitioner(partitioner);
+  rmf_task::TaskPlanner planner(local_config, options);
+  const auto local = planner.plan(now, agents, requests);
+  REQUIRE(std::holds_alternative<rmf_task::TaskPlanner::Assignments>(local));
+  const auto expected = problem.serialize_result(local);
+
+  // The result of a problem can be sent back and forth
+  CHECK(problem.serialize_result(problem.deserialize_result(expected))
+    == expected);
+
+  std::atomic_size_t calls = 0;
+  const rmf_task::PlanningService::Worker worker =
+    [&calls](const nlohmann::json& subproblem)
+    {
+      ++calls;
+      const auto result = rmf_task::PlanningService::work(
+        nlohmann::json::parse(subproblem.dump()));
+      return nlohmann::json::parse(result.dump());
+    };
+
+  WHEN("There is one worker")
+  {
+    const rmf_task::PlanningService service(partitioner, {worker});
+    CHECK(problem.serialize_result(service.plan(problem)) == expected);
+    CHECK(calls == 2);
+  }
+
+  WHEN("There are more workers than clusters")
+  {
+    const rmf_task::PlanningService service(
+      partitioner, {worker, worker, worker});
+    CHECK(problem.serialize_result(service.plan(problem)) == expected);
+    CHECK(calls == 2);
+  }
+
+  WHEN("The service plans the clusters itself")
+  {
+    const rmf_task::PlanningService service(partitioner, {});
+    CHECK(problem.serialize_result(service.plan(problem)) == expected);
+  }
+
+  WHEN("The problem is given serialized")
+  {
+    const rmf_task::PlanningService service(partitioner, {worker, worker});
+    const auto result = service.plan(problem.serialize(), now);
+    const auto* assignments =
+      std::get_if<rmf_task::TaskPlanner::Assignments>(&result);
+    REQUIRE(assignments);
+    REQUIRE(assignments->size() == agents.size());
+
+    const auto& local_assignments =
+      std::get<rmf_task::TaskPlanner::Assignments>(local);
+    for (std::size_t a = 0; a < agents.size(); ++a)
+    {
+      REQUIRE((*assignments)[a].size() == local_assignments[a].size());
+      for (std::size_t i = 0; i < (*assignments)[a].size(); ++i)
+      {
+        const auto& assignment = (*assignments)[a][i];
+        const auto& local_assignment = local_assignments[a][i];
+        CHECK(assignment.request()->booking()->id()
+          == local_assignment.request()->booking()->id());
+        CHECK(assignment.deployment_time()
+          == local_assignment.deployment_time());
+      }
+    }
+  }
+
+  WHEN("The solver of a cluster reports how its search went")
+  {
+    const auto output = rmf_task::PlanningService::work(problem.serialize());
+    CHECK_FALSE(output.at("interrupted").get<bool>());
+    CHECK_FALSE(output.at("pruned").get<bool>());
+    CHECK_FALSE(planner.statistics().interrupted());
+
+    auto flagging_config = local_config;
+    flagging_config.cluster_solver(std::make_shared<FlaggingSolver>(config));
+    rmf_task::TaskPlanner flagging_planner(flagging_config, options);
+    const auto result = flagging_planner.plan(now, agents, requests);
+    CHECK(std::holds_alternative<rmf_task::TaskPlanner::Assignments>(result));
+    CHECK(flagging_planner.statistics().interrupted());
+    CHECK(flagging_planner.statistics().pruned());
+  }
+
+  WHEN("A worker fails")
+  {
+    const rmf_task::PlanningService service(
+      partitioner,
+      {[](const nlohmann::json&) -> nlohmann::json
+        {
+          throw std::runtime_error("unreachable");
+        }});
+    CHECK_THROWS_AS(service.plan(problem), std::runtime_error);
+  }
+}
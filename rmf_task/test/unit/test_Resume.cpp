@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/detail/Resume.hpp>
+
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using rmf_task::detail::Resume;
+
+//==============================================================================
+SCENARIO("Resume callbacks are triggered once")
+{
+  std::size_t counter = 0;
+
+  WHEN("A Resume is triggered many times")
+  {
+    const auto resume = Resume::make([&]() { ++counter; });
+    resume();
+    resume();
+    CHECK(counter == 1);
+  }
+
+  WHEN("A Resume is destroyed without being triggered")
+  {
+    {
+      const auto resume = Resume::make([&]() { ++counter; });
+    }
+
+    CHECK(counter == 1);
+  }
+
+  WHEN("A Resume is destroyed after being triggered")
+  {
+    {
+      const auto resume = Resume::make([&]() { ++counter; });
+      resume();
+    }
+
+    CHECK(counter == 1);
+  }
+
+  WHEN("The callback triggers the Resume again")
+  {
+    std::optional<Resume> resume;
+    resume = Resume::make(
+      [&]()
+      {
+        ++counter;
+        (*resume)();
+      });
+
+    (*resume)();
+    CHECK(counter == 1);
+    resume.reset();
+    CHECK(counter == 1);
+  }
+
+  WHEN("Many threads trigger the Resume at once")
+  {
+    std::atomic_size_t concurrent_counter = 0;
+    const auto resume = Resume::make([&]() { ++concurrent_counter; });
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < 8; ++i)
+      threads.emplace_back([&]() { resume(); });
+
+    for (auto& t : threads)
+      t.join();
+
+    CHECK(concurrent_counter == 1);
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_utils/catch.hpp>
+
+#include <rmf_task/VersionedString.hpp>
+
+#include <optional>
+#include <string>
+
+SCENARIO("Reading versioned strings")
+{
+  rmf_task::VersionedString first("Go to place 12");
+  rmf_task::VersionedString second("Go to place 12");
+  rmf_task::VersionedString::Reader reader;
+
+  const auto first_value = reader.read(first.view());
+  REQUIRE(first_value);
+  CHECK(*first_value == "Go to place 12");
+  CHECK_FALSE(reader.read(first.view()));
+
+  // Both strings share one copy of their initial value, but the reader still
+  // tells them apart
+  const auto second_value = reader.read(second.view());
+  REQUIRE(second_value);
+  CHECK(second_value == first_value);
+  CHECK_FALSE(reader.read(second.view()));
+
+  const auto old_view = first.view();
+  first.update("Go to place 13");
+  const auto updated = reader.read(first.view());
+  REQUIRE(updated);
+  CHECK(*updated == "Go to place 13");
+  CHECK_FALSE(reader.read(first.view()));
+  CHECK_FALSE(reader.read(second.view()));
+
+  // Going back to an older view counts as a change too
+  const auto old_value = reader.read(old_view);
+  REQUIRE(old_value);
+  CHECK(*old_value == "Go to place 12");
+
+  // A new reader sees everything once
+  rmf_task::VersionedString::Reader other_reader;
+  CHECK(other_reader.read(first.view()));
+  CHECK(other_reader.read(second.view()));
+
+  // A string that is constructed again after every copy of its text is gone
+  // still reads correctly
+  std::optional<rmf_task::VersionedString> temporary;
+  temporary.emplace("temporary");
+  CHECK(*reader.read(temporary->view()) == "temporary");
+  temporary.reset();
+  temporary.emplace("temporary");
+  const auto fresh = reader.read(temporary->view());
+  REQUIRE(fresh);
+  CHECK(*fresh == "temporary");
+}
+
+SCENARIO("A reader forgets strings that can no longer be read")
+{
+  rmf_task::VersionedString::Reader reader;
+  rmf_task::VersionedString lasting("lasting");
+  CHECK(reader.read(lasting.view()));
+
+  std::optional<rmf_task::VersionedString> held;
+  held.emplace("held");
+  const auto held_view = held->view();
+  CHECK(reader.read(held_view));
+  held.reset();
+
+  // Enough short-lived strings pass through the reader that it has to sweep
+  // its memories many times over
+  for (std::size_t i = 0; i < 10000; ++i)
+  {
+    rmf_task::VersionedString temporary("temporary " + std::to_string(i));
+    CHECK(reader.read(temporary.view()));
+  }
+
+  // Strings that can still be read are never forgotten, even if only a view
+  // of them is left
+  CHECK_FALSE(reader.read(lasting.view()));
+  CHECK_FALSE(reader.read(held_view));
+}
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include <rmf_task/Activator.hpp>
+
+#include <rmf_task_sequence/Task.hpp>
+#include <rmf_task_sequence/events/Bundle.hpp>
+#include <rmf_task_sequence/phases/SimplePhase.hpp>
+
+#include <rmf_battery/agv/BatterySystem.hpp>
+#include <rmf_battery/agv/MechanicalSystem.hpp>
+#include <rmf_battery/agv/PowerSystem.hpp>
+#include <rmf_battery/agv/SimpleDevicePowerSink.hpp>
+#include <rmf_battery/agv/SimpleMotionPowerSink.hpp>
+
+#include "../test/mock/MockActivity.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Measures how long a phase sequence task takes to generate a backup of
+// itself and to be restored from that backup, for event trees of different
+// depths. The leaves of the trees are the mock activities of the unit tests,
+// so only the cost of the task and its bundles is measured.
+
+using test_rmf_task_sequence::MockActivity;
+
+namespace {
+
+//==============================================================================
+/// What was measured for one depth of the event tree
+struct Measurement
+{
+  std::size_t backup_bytes = 0;
+  double p50_backup_us = 0.0;
+  double p99_backup_us = 0.0;
+  double p50_restore_us = 0.0;
+  double p99_restore_us = 0.0;
+};
+
+//==============================================================================
+double percentile(std::vector<double> values, const double p)
+{
+  if (values.empty())
+    return 0.0;
+
+  std::sort(values.begin(), values.end());
+  const auto index = static_cast<std::size_t>(p * (values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+//==============================================================================
+/// Make a sequence whose first event is the sequence of the next level down,
+/// followed by more leaves. The first leaf of the deepest level is the event
+/// that is active when the task begins.
+rmf_task_sequence::Event::ConstDescriptionPtr make_tree(
+  const std::size_t depth,
+  const std::size_t leaves_per_level,
+  std::vector<std::shared_ptr<MockActivity::Controller>>& ctrls)
+{
+  const auto make_leaf = [&ctrls]()
+    {
+      ctrls.push_back(std::make_shared<MockActivity::Controller>());
+      return std::make_shared<MockActivity::Description>(ctrls.back());
+    };
+
+  std::vector<rmf_task_sequence::Event::ConstDescriptionPtr> events;
+  events.push_back(
+    depth <= 1 ? make_leaf() : make_tree(depth - 1, leaves_per_level, ctrls));
+
+  for (std::size_t i = 1; i < leaves_per_level; ++i)
+    events.push_back(make_leaf());
+
+  return std::make_shared<rmf_task_sequence::events::Bundle::Description>(
+    std::move(events), rmf_task_sequence::events::Bundle::Type::Sequence);
+}
+
+//==============================================================================
+rmf_task::ConstParametersPtr make_parameters()
+{
+  const auto battery = rmf_battery::agv::BatterySystem::make(24.0, 40.0, 8.8);
+  const auto mechanical =
+    rmf_battery::agv::MechanicalSystem::make(70.0, 40.0, 0.22);
+  const auto power = rmf_battery::agv::PowerSystem::make(20.0);
+
+  return std::make_shared<rmf_task::Parameters>(
+    nullptr,
+    *battery,
+    std::make_shared<rmf_battery::agv::SimpleMotionPowerSink>(
+      *battery, *mechanical),
+    std::make_shared<rmf_battery::agv::SimpleDevicePowerSink>(
+      *battery, *power));
+}
+
+//==============================================================================
+Measurement run(
+  const std::size_t depth,
+  const std::size_t leaves_per_level,
+  const std::size_t repetitions)
+{
+  const auto event_initializer =
+    std::make_shared<rmf_task_sequence::Event::Initializer>();
+  rmf_task_sequence::events::Bundle::add(event_initializer);
+  MockActivity::add(event_initializer);
+
+  const auto phase_activator =
+    std::make_shared<rmf_task_sequence::Phase::Activator>();
+  rmf_task_sequence::phases::SimplePhase::add(
+    *phase_activator, event_initializer);
+
+  rmf_task::Activator activator;
+  rmf_task_sequence::Task::add(
+    activator,
+    phase_activator,
+    []() { return std::chrono::steady_clock::now(); });
+
+  std::vector<std::shared_ptr<MockActivity::Controller>> ctrls;
+  rmf_task_sequence::Task::Builder builder;
+  builder.add_phase(
+    rmf_task_sequence::phases::SimplePhase::Description::make(
+      make_tree(depth, leaves_per_level, ctrls)),
+    {});
+
+  const auto get_state = []()
+    {
+      return rmf_task::State().time(std::chrono::steady_clock::now());
+    };
+  const auto parameters = make_parameters();
+  const rmf_task::Request request(
+    "benchmark_request",
+    std::chrono::steady_clock::now(),
+    nullptr,
+    builder.build("Nested Task", "A task with a deep event tree"));
+
+  const auto task = activator.activate(
+    get_state,
+    parameters,
+    request,
+    [](rmf_task::Phase::ConstSnapshotPtr) {},
+    [](rmf_task::Task::Active::Backup) {},
+    [](rmf_task::Phase::ConstCompletedPtr) {},
+    []() {});
+
+  if (!task)
+  {
+    std::cerr << "Failed to activate a task of depth " << depth << std::endl;
+    std::exit(1);
+  }
+
+  Measurement m;
+  std::vector<double> backup_us;
+  std::vector<double> restore_us;
+  for (std::size_t i = 0; i < repetitions; ++i)
+  {
+    const auto before_backup = std::chrono::steady_clock::now();
+    const auto backup = task->backup();
+    const auto after_backup = std::chrono::steady_clock::now();
+    backup_us.push_back(
+      std::chrono::duration<double, std::micro>(
+        after_backup - before_backup).count());
+    m.backup_bytes = backup.state().size();
+
+    const auto before_restore = std::chrono::steady_clock::now();
+    const auto restored = activator.restore(
+      get_state,
+      parameters,
+      request,
+      backup.state(),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    const auto after_restore = std::chrono::steady_clock::now();
+    restore_us.push_back(
+      std::chrono::duration<double, std::micro>(
+        after_restore - before_restore).count());
+
+    if (!restored)
+    {
+      std::cerr << "Failed to restore a task of depth " << depth << std::endl;
+      std::exit(1);
+    }
+  }
+
+  m.p50_backup_us = percentile(backup_us, 0.50);
+  m.p99_backup_us = percentile(backup_us, 0.99);
+  m.p50_restore_us = percentile(restore_us, 0.50);
+  m.p99_restore_us = percentile(restore_us, 0.99);
+  return m;
+}
+
+//==============================================================================
+/// Write one measurement as a JSON object on a single line
+std::string to_json(
+  const std::size_t depth,
+  const std::size_t leaves_per_level,
+  const Measurement& m)
+{
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(3)
+       << "{\"depth\": " << depth
+       << ", \"leaves_per_level\": " << leaves_per_level
+       << ", \"backup_bytes\": " << m.backup_bytes
+       << ", \"p50_backup_us\": " << m.p50_backup_us
+       << ", \"p99_backup_us\": " << m.p99_backup_us
+       << ", \"p50_restore_us\": " << m.p50_restore_us
+       << ", \"p99_restore_us\": " << m.p99_restore_us << "}";
+  return json.str();
+}
+
+//==============================================================================
+std::vector<std::size_t> parse_list(const std::string& text)
+{
+  std::vector<std::size_t> values;
+  std::istringstream list(text);
+  std::string item;
+  while (std::getline(list, item, ','))
+    values.push_back(std::stoul(item));
+
+  return values;
+}
+
+//==============================================================================
+void print_usage(const char* program)
+{
+  std::cout
+    << "Usage: " << program << " [options]\n"
+    << "  --depths <list>       Comma-separated depths of the event tree\n"
+    << "                        (default 1,2,4,8,16)\n"
+    << "  --leaves <n>          Events in each level of the tree (default 3)\n"
+    << "  --repetitions <n>     Backups and restores per depth (default 100)\n"
+    << "  --json <path>         Also write the measurements to a JSON file\n";
+}
+
+} // anonymous namespace
+
+//==============================================================================
+int main(int argc, char* argv[])
+{
+  std::vector<std::size_t> depths = {1, 2, 4, 8, 16};
+  std::size_t leaves_per_level = 3;
+  std::size_t repetitions = 100;
+  std::string json_path;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const std::string arg = argv[i];
+    const auto value = [&]() -> std::string
+      {
+        if (i + 1 >= argc)
+        {
+          std::cerr << "Missing value for " << arg << std::endl;
+          std::exit(1);
+        }
+        return argv[++i];
+      };
+
+    if (arg == "--depths")
+      depths = parse_list(value());
+    else if (arg == "--leaves")
+      leaves_per_level = std::max<std::size_t>(1, std::stoul(value()));
+    else if (arg == "--repetitions")
+      repetitions = std::max<std::size_t>(1, std::stoul(value()));
+    else if (arg == "--json")
+      json_path = value();
+    else
+    {
+      print_usage(argv[0]);
+      return arg == "--help" ? 0 : 1;
+    }
+  }
+
+  std::vector<std::string> json_lines;
+  std::cout << std::right << std::setw(6) << "depth"
+            << std::setw(14) << "backup_bytes"
+            << std::setw(15) << "p50_backup_us"
+            << std::setw(15) << "p99_backup_us"
+            << std::setw(16) << "p50_restore_us"
+            << std::setw(16) << "p99_restore_us" << std::endl;
+
+  for (const auto depth : depths)
+  {
+    const auto m = run(
+      std::max<std::size_t>(1, depth), leaves_per_level, repetitions);
+    json_lines.push_back(to_json(depth, leaves_per_level, m));
+
+    std::cout << std::right << std::setw(6) << depth
+              << std::setw(14) << m.backup_bytes
+              << std::fixed << std::setprecision(1)
+              << std::setw(15) << m.p50_backup_us
+              << std::setw(15) << m.p99_backup_us
+              << std::setw(16) << m.p50_restore_us
+              << std::setw(16) << m.p99_restore_us << std::endl;
+  }
+
+  if (!json_path.empty())
+  {
+    std::ofstream json(json_path);
+    json << "[\n";
+    for (std::size_t i = 0; i < json_lines.size(); ++i)
+    {
+      json << "  " << json_lines[i]
+           << (i + 1 < json_lines.size() ? ",\n" : "\n");
+    }
+    json << "]\n";
+  }
+
+  return 0;
+}
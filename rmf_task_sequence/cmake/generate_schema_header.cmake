@@ -1,16 +1,31 @@
 #################################################
-# generate_schema_header(<file_name>)
+# generate_schema_header(<file_name> <sources_var>)
 #
-# This function takes a schema file and generates a C++ header
-# file that hardcodes the schema into it as a const string.
-function(generate_schema_header file_name)
+# This function takes a schema file and generates a C++ header that declares
+# accessors for the schema and for a validator of it, along with one source
+# file that hardcodes the schema as a string and defines the accessors. The
+# schema is only parsed and compiled the first time that it is needed. The
+# path of the generated source file is appended to <sources_var>.
+function(generate_schema_header file_name sources_var)
   get_filename_component(schema_name ${file_name} NAME_WE)
   string(TOUPPER ${schema_name} upper_schema_name)
   file(READ ${file_name} schema_text)
 
+  set(output_dir ${CMAKE_BINARY_DIR}/rmf_task_sequence_schemas)
   configure_file(
-    ../templates/schemas_template.hpp.in
-    ${CMAKE_BINARY_DIR}/include/rmf_task_sequence/schemas/${schema_name}.hpp
+    ${PROJECT_SOURCE_DIR}/templates/schemas_template.hpp.in
+    ${output_dir}/include/rmf_task_sequence/schemas/${schema_name}.hpp
     @ONLY
   )
+
+  configure_file(
+    ${PROJECT_SOURCE_DIR}/templates/schemas_template.cpp.in
+    ${output_dir}/src/${schema_name}.cpp
+    @ONLY
+  )
+
+  set(${sources_var}
+    ${${sources_var}} ${output_dir}/src/${schema_name}.cpp
+    PARENT_SCOPE
+  )
 endfunction()
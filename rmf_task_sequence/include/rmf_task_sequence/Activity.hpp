@@ -18,12 +18,16 @@
 #ifndef RMF_TASK_SEQUENCE__ACTIVITY_HPP
 #define RMF_TASK_SEQUENCE__ACTIVITY_HPP
 
+#include <rmf_task/detail/DispatchIndex.hpp>
 #include <rmf_task/detail/Resume.hpp>
 #include <rmf_task/Header.hpp>
 
 #include <rmf_task_sequence/detail/Backup.hpp>
 #include <rmf_task_sequence/typedefs.hpp>
 
+#include <optional>
+#include <string>
+
 namespace rmf_task_sequence {
 
 //==============================================================================
@@ -42,6 +46,8 @@ public:
   using ConstModelPtr = std::shared_ptr<const Model>;
 
   class SequenceModel;
+
+  class ModelCache;
 };
 
 //==============================================================================
@@ -128,8 +134,24 @@ public:
     const State& initial_state,
     const Parameters& parameters) const = 0;
 
+  /// Get a key for everything besides its arguments that make_model(~)
+  /// depends on. Two descriptions with the same key must make equivalent
+  /// models when they are given the same initial state and parameters, which
+  /// allows ModelCache to reuse their models. The default implementation
+  /// returns std::nullopt, which means the models of this description are
+  /// never reused.
+  virtual std::optional<std::string> model_key() const;
+
+  /// Get the dispatch index of the dynamic type of this description. Phase
+  /// activators and event initializers use this to find the callbacks for
+  /// this description.
+  std::size_t dispatch_index() const;
+
   // Virtual destructor
   virtual ~Description() = default;
+
+private:
+  rmf_task::detail::DispatchIndex::Cache _dispatch_index;
 };
 
 //==============================================================================
@@ -192,6 +214,11 @@ public:
     State invariant_initial_state,
     const Parameters& parameters);
 
+  /// Get a model key for a SequenceModel of these descriptions. This is
+  /// std::nullopt if any of the descriptions do not have a model key.
+  static std::optional<std::string> model_key(
+    const std::vector<ConstDescriptionPtr>& descriptions);
+
   // Documentation inherited
   std::optional<rmf_task::Estimate> estimate_finish(
     State initial_state,
@@ -211,6 +238,44 @@ private:
   rmf_utils::unique_impl_ptr<Implementation> _pimpl;
 };
 
+//==============================================================================
+/// A memo of the models of activity descriptions, which is shared by the whole
+/// process. Task planning makes models for the same activities over and over,
+/// both within one task and across the tasks of different requests. Every
+/// SequenceModel makes the models of its descriptions through this memo, so a
+/// description that has a model key only has its model made once for each
+/// invariant initial state and set of parameters.
+///
+/// The invariant initial state is compared by its waypoint, orientation, time,
+/// dedicated charging waypoint, and battery state of charge. The parameters
+/// are compared by their battery system and by the identity of their planner
+/// and power sinks, so copies of the same parameters share their models.
+class Activity::ModelCache
+{
+public:
+
+  /// Make a model for a description, or reuse the one that was made before
+  /// for the same model key, invariant initial state, and parameters.
+  static ConstModelPtr make_model(
+    const Description& description,
+    State invariant_initial_state,
+    const Parameters& parameters);
+
+  /// Set the greatest number of models to keep. The least recently used
+  /// models are dropped first. A capacity of zero turns the memo off. The
+  /// default capacity is 4096.
+  static void capacity(std::size_t value);
+
+  /// Get the greatest number of models to keep.
+  static std::size_t capacity();
+
+  /// Get the number of models that are being kept.
+  static std::size_t size();
+
+  /// Drop all the models that are being kept.
+  static void clear();
+};
+
 } // namespace rmf_task_sequence
 
 #endif // RMF_TASK_SEQUENCE__ACTIVITY_HPP
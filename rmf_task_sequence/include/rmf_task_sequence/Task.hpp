@@ -18,6 +18,7 @@
 #ifndef RMF_TASK_SEQUENCE__TASK_HPP
 #define RMF_TASK_SEQUENCE__TASK_HPP
 
+#include <rmf_task/AllocationCounter.hpp>
 #include <rmf_task/Request.hpp>
 #include <rmf_task/Task.hpp>
 #include <rmf_task/Activator.hpp>
@@ -35,6 +36,9 @@ public:
   // Declaration
   class Builder;
 
+  // Declaration
+  class Template;
+
   // Declaration
   class Active;
 
@@ -49,6 +53,127 @@ public:
   using PhaseFinished = std::function<void(Phase::ConstCompletedPtr)>;
   using TaskFinished = std::function<void()>;
 
+  /// The encodings that a phase sequence task can use for its backups
+  enum class BackupEncoding : uint8_t
+  {
+    /// JSON text, which is easy for humans to read
+    Json,
+
+    /// Concise Binary Object Representation (RFC 8949)
+    Cbor,
+
+    /// MessagePack
+    MessagePack
+  };
+
+  /// Options for the backups that phase sequence tasks issue
+  class BackupOptions
+  {
+  public:
+
+    /// Default constructor. Tasks will issue full JSON backups.
+    BackupOptions();
+
+    /// Set the encoding of the backups that tasks will issue. Binary encodings
+    /// are more compact and faster to parse than JSON text. Tasks can be
+    /// restored from a backup in any of these encodings, no matter which one
+    /// is chosen here.
+    BackupOptions& encoding(BackupEncoding value);
+
+    /// Get the encoding of the backups that tasks will issue.
+    BackupEncoding encoding() const;
+
+    /// Turn delta checkpoints on or off. When this is on, the checkpoints of a
+    /// task will describe how its state has changed since the latest full
+    /// backup that it gave out, as long as that is smaller than the full
+    /// state. Every full backup that the task gives out, including those from
+    /// rmf_task::Task::Active::backup(), becomes the base of the deltas that
+    /// follow it. This only applies to the JSON encoding.
+    BackupOptions& delta(bool value = true);
+
+    /// Check whether delta checkpoints are turned on.
+    bool delta() const;
+
+    /// Set the minimum time between the checkpoints of a task. Within that
+    /// time the task holds on to the latest state instead of generating a
+    /// backup for every change, and issues it with the first update or backup
+    /// of the task after the interval has passed.
+    /// A task always issues a checkpoint when it begins a new phase, so phase
+    /// transitions are never delayed. The default of zero issues a checkpoint
+    /// for every change.
+    BackupOptions& checkpoint_interval(rmf_traffic::Duration value);
+
+    /// Get the minimum time between the checkpoints of a task.
+    rmf_traffic::Duration checkpoint_interval() const;
+
+    class Implementation;
+  private:
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
+  /// Options for the updates that phase sequence tasks issue. Every change
+  /// anywhere in the event tree of a task normally produces its own update,
+  /// so a burst of changes, like a burst of log entries, produces as many
+  /// snapshots. These options let a task merge such bursts into one update.
+  class UpdateOptions
+  {
+  public:
+
+    /// Signature for running a callback later on the executor of a task
+    using Schedule = std::function<void(std::function<void()> callback)>;
+
+    /// Default constructor. Tasks will issue an update for every change.
+    UpdateOptions();
+
+    /// Give tasks a way to run a callback on their executor, e.g. on the next
+    /// tick of an event loop. When this is set, a change in the event tree of
+    /// a task only marks the task as changed and schedules a flush. All the
+    /// changes that happen before the flush runs are issued in one update.
+    UpdateOptions& schedule(Schedule value);
+
+    /// Get the callback that tasks use to schedule their updates.
+    const Schedule& schedule() const;
+
+    /// Set the minimum time between the updates of a task. Within that time
+    /// the task holds on to its latest change and issues it with the first
+    /// change or scheduled flush after the interval has passed. When a
+    /// schedule is set, a task keeps scheduling flushes while it holds a
+    /// change, so the change is issued even if nothing else changes.
+    /// A task always issues an update when it begins a new phase, so phase
+    /// transitions are never delayed. The default of zero does not limit the
+    /// rate of updates.
+    UpdateOptions& interval(rmf_traffic::Duration value);
+
+    /// Get the minimum time between the updates of a task.
+    rmf_traffic::Duration interval() const;
+
+    /// Signature for receiving the allocations behind each update
+    using AllocationReport =
+      std::function<void(const rmf_task::AllocationCounter::Counts& counts)>;
+
+    /// Receive the heap allocations that were made for each update that a
+    /// task issues, broken down by subsystem. This is called right after the
+    /// update, on the same thread.
+    ///
+    /// The counts cover the time since the task issued its previous update
+    /// from the same thread, so they include the log entries and snapshots
+    /// behind the update as well as the update callback. Anything else that
+    /// the thread did in between, e.g. for other tasks, is included too. The
+    /// first update, or an update issued from a different thread than the
+    /// previous one, only covers the time spent issuing it.
+    ///
+    /// Allocations are only counted when
+    /// rmf_task::AllocationCounter::enabled() is true.
+    UpdateOptions& allocation_report(AllocationReport value);
+
+    /// Get the callback that receives the allocations behind each update.
+    const AllocationReport& allocation_report() const;
+
+    class Implementation;
+  private:
+    rmf_utils::impl_ptr<Implementation> _pimpl;
+  };
+
   /// Make an activator for a phase sequence task. This activator can be given
   /// to the rmf_task::Activator class to activate phase sequence tasks from
   /// phase sequence descriptions.
@@ -62,9 +187,17 @@ public:
   ///
   /// \param[in] clock
   ///   A callback that gives the current time when called.
-  static rmf_task::Activator::Activate<Description> make_activator(
+  ///
+  /// \param[in] backup_options
+  ///   Options for the backups that tasks will issue.
+  ///
+  /// \param[in] update_options
+  ///   Options for the updates that tasks will issue.
+  static rmf_task::Activator::ActivatePlanned<Description> make_activator(
     Phase::ConstActivatorPtr phase_activator,
-    std::function<rmf_traffic::Time()> clock);
+    std::function<rmf_traffic::Time()> clock,
+    BackupOptions backup_options = BackupOptions(),
+    UpdateOptions update_options = UpdateOptions());
 
   /// Add this task type to an Activator. This is an alternative to using
   /// make_activator(~).
@@ -81,10 +214,18 @@ public:
   ///
   /// \param[in] clock
   ///   A callback that gives the current time when called.
+  ///
+  /// \param[in] backup_options
+  ///   Options for the backups that tasks will issue.
+  ///
+  /// \param[in] update_options
+  ///   Options for the updates that tasks will issue.
   static void add(
     rmf_task::Activator& activator,
     Phase::ConstActivatorPtr phase_activator,
-    std::function<rmf_traffic::Time()> clock);
+    std::function<rmf_traffic::Time()> clock,
+    BackupOptions backup_options = BackupOptions(),
+    UpdateOptions update_options = UpdateOptions());
 
   /// Give an initializer the ability to build a sequence task for some other
   /// task description.
@@ -105,12 +246,20 @@ public:
   ///
   /// \param[in] clock
   ///   A callback that gives the current time when called
+  ///
+  /// \param[in] backup_options
+  ///   Options for the backups that tasks will issue.
+  ///
+  /// \param[in] update_options
+  ///   Options for the updates that tasks will issue.
   template<typename OtherDesc>
   static void unfold(
     std::function<Description(const OtherDesc&)> unfold_description,
     rmf_task::Activator& activator,
     Phase::ConstActivatorPtr phase_activator,
-    std::function<rmf_traffic::Time()> clock);
+    std::function<rmf_traffic::Time()> clock,
+    BackupOptions backup_options = BackupOptions(),
+    UpdateOptions update_options = UpdateOptions());
 
 };
 
@@ -151,6 +300,70 @@ private:
   rmf_utils::impl_ptr<Implementation> _pimpl;
 };
 
+//==============================================================================
+/// A reusable layout for phase sequence tasks that get submitted many times
+/// with different details, e.g. a delivery that always goes to a pickup place
+/// and then to a dropoff place. The phases that never change are built once
+/// and shared by every task made from the template. The rest are made for each
+/// task by substituting its arguments into a callback.
+class Task::Template
+{
+public:
+
+  /// Signature for making the description of a phase from the arguments of a
+  /// task. Return a nullptr if the arguments cannot be used.
+  using Substitute =
+    std::function<Phase::ConstDescriptionPtr(const nlohmann::json& arguments)>;
+
+  /// Get the template ready.
+  Template();
+
+  /// Add a phase that is the same for every task made from this template.
+  ///
+  /// \param[in] description
+  ///   A description of the phase
+  ///
+  /// \param[in] cancellation_sequence
+  ///   This phase sequence will be run if the task is cancelled during this
+  ///   phase.
+  Template& add_phase(
+    Phase::ConstDescriptionPtr description,
+    std::vector<Phase::ConstDescriptionPtr> cancellation_sequence);
+
+  /// Add a phase that gets made from the arguments of each task.
+  ///
+  /// \param[in] substitute
+  ///   This will be called to make the description of the phase for each task
+  ///
+  /// \param[in] cancellation_sequence
+  ///   This phase sequence will be run if the task is cancelled during this
+  ///   phase.
+  Template& add_phase(
+    Substitute substitute,
+    std::vector<Phase::ConstDescriptionPtr> cancellation_sequence);
+
+  /// Generate a TaskDescription instance for one task.
+  ///
+  /// \param[in] arguments
+  ///   The arguments that will be given to each Substitute callback
+  ///
+  /// \param[in] category
+  ///   Task category information that will go into the Task::Tag
+  ///
+  /// \param[in] detail
+  ///   Any detailed information that will go into the Task::Tag
+  ///
+  /// \return a nullptr if any Substitute callback returned a nullptr.
+  std::shared_ptr<Description> instantiate(
+    const nlohmann::json& arguments,
+    std::string category,
+    std::string detail) const;
+
+  class Implementation;
+private:
+  rmf_utils::impl_ptr<Implementation> _pimpl;
+};
+
 //==============================================================================
 class Task::Description : public rmf_task::Task::Description
 {
@@ -178,9 +391,22 @@ public:
   /// Change the details for this task
   Description& detail(std::string new_detail);
 
+  /// Generate the header of a task of this description.
+  ///
+  /// \param[in] initial_state
+  ///   The state of the robot when the task begins
+  ///
+  /// \param[in] parameters
+  ///   The parameters of the robot
+  ///
+  /// \param[in] model
+  ///   A model that was already made for this description, e.g. by a task
+  ///   planner, which is used instead of making it again. The estimated
+  ///   duration of the header is the invariant duration of the model.
   Header generate_header(
     const State& initial_state,
-    const Parameters& parameters) const;
+    const Parameters& parameters,
+    rmf_task::Task::ConstModelPtr model = nullptr) const;
 
   class Implementation;
 private:
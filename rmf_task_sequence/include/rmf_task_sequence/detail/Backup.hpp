@@ -55,6 +55,12 @@ public:
   /// Get the YAML representation of the backed up state
   const nlohmann::json& state() const;
 
+  /// Move the backed up state out of this Backup. This lets a parent phase or
+  /// event nest the state of a child inside its own backup without copying
+  /// it, so the whole tree only gets serialized once, at the top. The state of
+  /// this Backup will be null afterwards.
+  nlohmann::json release_state();
+
   class Implementation;
 private:
   Backup();
@@ -33,7 +33,7 @@ void Phase::Activator::add_activator(Activate<Desc> activator)
       const ConstParametersPtr& parameters,
       ConstTagPtr tag,
       const Phase::Description& description,
-      std::optional<std::string> backup_state,
+      std::optional<nlohmann::json> backup_state,
       std::function<void(rmf_task::Phase::ConstSnapshotPtr)> phase_update,
       std::function<void(Active::Backup)> phase_checkpoint,
       std::function<void()> phase_finished)
@@ -28,10 +28,15 @@ void Task::unfold(
   std::function<Description(const OtherDesc&)> unfold_description,
   rmf_task::Activator& task_activator,
   Phase::ConstActivatorPtr phase_activator,
-  std::function<rmf_traffic::Time()> clock)
+  std::function<rmf_traffic::Time()> clock,
+  BackupOptions backup_options,
+  UpdateOptions update_options)
 {
-  auto sequence_activator =
-    make_activator(std::move(phase_activator), std::move(clock));
+  auto sequence_activator = make_activator(
+    std::move(phase_activator),
+    std::move(clock),
+    std::move(backup_options),
+    std::move(update_options));
 
   task_activator.add_activator<OtherDesc>(
     [
@@ -53,6 +58,7 @@ void Task::unfold(
         parameters,
         booking,
         unfold(other_desc),
+        nullptr,
         std::move(backup_state),
         std::move(update),
         std::move(checkpoint),
@@ -40,14 +40,16 @@ public:
     Sequence,
 
     /// The bundle will execute its dependencies in parallel and will finish
-    /// when all of its dependencies are finished.
-    // (Not implemented yet)
-//    ParallelAll,
-
-    /// The bundle will execute its dependencies in parallel and will finished
-    /// when any (one or more) of its dependencies finishes.
-    // (Not implemented yet)
-//    ParallelAny
+    /// when all of its dependencies are finished. Its duration is estimated by
+    /// its longest dependency.
+    ParallelAll,
+
+    /// The bundle will execute its dependencies in parallel and will finish
+    /// when any (one or more) of its dependencies finishes. The dependencies
+    /// that are still running at that point will be canceled, and the bundle
+    /// finishes once they have wrapped up. Its duration is estimated by its
+    /// shortest dependency.
+    ParallelAny
   };
 
   class Description;
@@ -148,13 +150,47 @@ public:
   ///
   /// \warning It is not recommended to use this function directly. You should
   /// consider using add(~) or unfold(~) with an initializer instead.
+  ///
+  /// \param[in] backup
+  ///   The state of a backup that was issued by the bundle. The state is used
+  ///   as it is, without being parsed again. A state that was serialized into
+  ///   a string is also accepted.
   static Event::ActivePtr restore(
     const Event::Initializer& initializer,
     const Event::AssignIDPtr& id,
     const std::function<rmf_task::State()>& get_state,
     const ConstParametersPtr& parameters,
     const Bundle::Description& description,
-    const std::string& backup,
+    const nlohmann::json& backup,
+    std::function<void()> update,
+    std::function<void()> checkpoint,
+    std::function<void()> finished);
+
+  /// Initiate a Bundle in Standby mode from an initializer that the bundle may
+  /// keep alive. For advanced use only.
+  ///
+  /// A sequence that is initiated this way only initializes its later events
+  /// once it reaches them, so long scripts of events are cheap to set up.
+  static Event::StandbyPtr initiate(
+    const Event::ConstInitializerPtr& initializer,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    std::function<void()> update);
+
+  /// Restore a Bundle into Active mode from an initializer that the bundle may
+  /// keep alive. For advanced use only.
+  ///
+  /// A sequence that is restored this way only initializes the events after
+  /// its current one once it reaches them.
+  static Event::ActivePtr restore(
+    const Event::ConstInitializerPtr& initializer,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    const nlohmann::json& backup,
     std::function<void()> update,
     std::function<void()> checkpoint,
     std::function<void()> finished);
@@ -222,6 +258,9 @@ public:
     const rmf_task::State& initial_state,
     const Parameters& parameters) const final;
 
+  // Documentation inherited
+  std::optional<std::string> model_key() const final;
+
   class Implementation;
 private:
   rmf_utils::impl_ptr<Implementation> _pimpl;
@@ -101,6 +101,9 @@ public:
     const State& initial_state,
     const Parameters& parameters) const final;
 
+  // Documentation inherited
+  std::optional<std::string> model_key() const final;
+
   class Implementation;
 private:
   Description();
@@ -75,6 +75,9 @@ public:
     const rmf_task::State& initial_state,
     const rmf_task::Parameters& parameters) const final;
 
+  // Documentation inherited
+  std::optional<std::string> model_key() const final;
+
   class Implementation;
 private:
   rmf_utils::impl_ptr<Implementation> _pimpl;
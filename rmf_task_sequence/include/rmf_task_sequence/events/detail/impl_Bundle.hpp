@@ -39,7 +39,7 @@ void Bundle::unfold(
       std::function<void()> update)
     {
       return initiate(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -57,7 +57,7 @@ void Bundle::unfold(
       std::function<void()> finished)
     {
       return restore(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -46,7 +46,7 @@ public:
 
   static std::optional<Info> has_error(
     const nlohmann::json_schema::json_validator& validator,
-    const nlohmann::json json);
+    const nlohmann::json& json);
 };
 
 } // namespace schemas
@@ -17,29 +17,254 @@
 
 #include <rmf_task_sequence/Activity.hpp>
 
+#include <rmf_traffic/agv/Planner.hpp>
+
+#include "internal_Activity.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
 namespace rmf_task_sequence {
 
+namespace {
+//==============================================================================
+template<typename T>
+void append_bytes(std::string& key, char tag, const T& value)
+{
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  key.push_back(tag);
+  key.append(bytes, sizeof(T));
+}
+
+//==============================================================================
+class ModelMemo
+{
+public:
+
+  // The parts of the parameters that models are made from. They are kept as
+  // weak references so that an entry whose parts have been destroyed cannot
+  // be mistaken for new parts that were given the same addresses.
+  struct Sources
+  {
+    std::weak_ptr<const rmf_traffic::agv::Planner> planner;
+    std::weak_ptr<const rmf_battery::MotionPowerSink> motion_sink;
+    std::weak_ptr<const rmf_battery::DevicePowerSink> ambient_sink;
+    std::weak_ptr<const rmf_battery::DevicePowerSink> tool_sink;
+
+    static Sources of(const rmf_task::Parameters& parameters)
+    {
+      return Sources{
+        parameters.planner(),
+        parameters.motion_sink(),
+        parameters.ambient_sink(),
+        parameters.tool_sink()
+      };
+    }
+
+    bool match(const rmf_task::Parameters& parameters) const
+    {
+      return planner.lock() == parameters.planner()
+        && motion_sink.lock() == parameters.motion_sink()
+        && ambient_sink.lock() == parameters.ambient_sink()
+        && tool_sink.lock() == parameters.tool_sink();
+    }
+  };
+
+  struct Entry
+  {
+    std::string key;
+    Activity::ConstModelPtr model;
+    Sources sources;
+  };
+
+  static ModelMemo& get()
+  {
+    static ModelMemo memo;
+    return memo;
+  }
+
+  std::mutex mutex;
+  std::size_t capacity = 4096;
+
+  // Ordered from the most recently used to the least recently used
+  std::list<Entry> entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+  void trim()
+  {
+    while (entries.size() > capacity)
+    {
+      index.erase(entries.back().key);
+      entries.pop_back();
+    }
+  }
+};
+
+//==============================================================================
+std::string memo_key(
+  const std::string& model_key,
+  const rmf_task::State& state,
+  const rmf_task::Parameters& parameters)
+{
+  std::string key = model_key;
+  key.push_back('\0');
+  if (const auto wp = state.waypoint())
+    append_bytes(key, 'w', *wp);
+  if (const auto orientation = state.orientation())
+    append_bytes(key, 'o', *orientation);
+  if (const auto time = state.time())
+    append_bytes(key, 't', time->time_since_epoch().count());
+  if (const auto charger = state.dedicated_charging_waypoint())
+    append_bytes(key, 'c', *charger);
+  if (const auto soc = state.battery_soc())
+    append_bytes(key, 'b', *soc);
+
+  // The parameters are compared by the parts that models are made from, so
+  // that copies of the same parameters share their models
+  append_bytes(key, 'p', parameters.planner().get());
+  append_bytes(key, 'm', parameters.motion_sink().get());
+  append_bytes(key, 'a', parameters.ambient_sink().get());
+  append_bytes(key, 'l', parameters.tool_sink().get());
+
+  const auto& battery = parameters.battery_system();
+  append_bytes(key, 'B', battery.capacity());
+  append_bytes(key, 'V', battery.nominal_voltage());
+  append_bytes(key, 'I', battery.charging_current());
+  return key;
+}
+} // anonymous namespace
+
+//==============================================================================
+std::optional<std::string> Activity::Description::model_key() const
+{
+  return std::nullopt;
+}
+
+//==============================================================================
+std::size_t Activity::Description::dispatch_index() const
+{
+  return _dispatch_index.get(typeid(*this));
+}
+
 //==============================================================================
 class Activity::SequenceModel::Implementation
 {
 public:
-  std::vector<Activity::ConstModelPtr> models;
+
+  // Either a model that needs to be asked for its estimate, or a run of
+  // invariant models that have been folded into one offset
+  struct Step
+  {
+    Activity::ConstModelPtr model;
+    internal::InvariantOffset offset;
+
+    // The most battery that had been drained by the end of any model in the
+    // run. A run fails its battery check if any one of its models would.
+    double peak_battery_drain = std::numeric_limits<double>::lowest();
+
+    // The parts of the duration that a calibration corrects, along with the
+    // waypoints that the correction is looked up for. A start of nullopt
+    // means the waypoint that the run starts from.
+    struct Calibrated
+    {
+      std::string type;
+      rmf_traffic::Duration duration;
+      std::optional<std::size_t> start;
+      std::optional<std::size_t> finish;
+    };
+    std::vector<Calibrated> calibrated;
+
+    void fold(const internal::InvariantOffset& next)
+    {
+      if (next.calibration_type.has_value())
+      {
+        calibrated.push_back(
+          {*next.calibration_type, next.duration, offset.waypoint,
+            next.waypoint});
+      }
+
+      offset.duration += next.duration;
+      offset.battery_drain += next.battery_drain;
+      peak_battery_drain = std::max(peak_battery_drain, offset.battery_drain);
+      if (next.waypoint.has_value())
+        offset.waypoint = next.waypoint;
+      if (next.orientation.has_value())
+        offset.orientation = next.orientation;
+    }
+
+    bool apply(
+      rmf_task::State& state,
+      const rmf_task::Constraints& constraints,
+      const rmf_task::ConstCalibrationPtr& calibration) const
+    {
+      auto duration = offset.duration;
+      const auto initial_waypoint = state.waypoint();
+      for (const auto& part : calibrated)
+      {
+        const auto start = part.start.has_value() ?
+          part.start : initial_waypoint;
+        if (!calibration || !start.has_value())
+          continue;
+
+        // Correct each part the same way as the model that it came from
+        const double factor = calibration->factor(
+          part.type, *start, part.finish.value_or(*start));
+        duration += std::chrono::duration_cast<rmf_traffic::Duration>(
+          part.duration * factor) - part.duration;
+      }
+
+      state.time(state.time().value() + duration);
+      if (offset.waypoint.has_value())
+        state.waypoint(*offset.waypoint);
+      if (offset.orientation.has_value())
+        state.orientation(*offset.orientation);
+
+      const double battery_soc = state.battery_soc().value();
+      if (!constraints.drain_battery())
+        return battery_soc > constraints.threshold_soc();
+
+      if (battery_soc - peak_battery_drain <= constraints.threshold_soc())
+        return false;
+
+      state.battery_soc(battery_soc - offset.battery_drain);
+      return true;
+    }
+  };
+
+  std::vector<Step> steps;
   rmf_task::State invariant_finish_state;
   rmf_traffic::Duration invariant_duration;
+
+  static const Implementation& get(const SequenceModel& model)
+  {
+    return *model._pimpl;
+  }
 };
 
+//==============================================================================
+std::size_t internal::count_steps(const Activity::SequenceModel& model)
+{
+  return Activity::SequenceModel::Implementation::get(model).steps.size();
+}
+
 //==============================================================================
 Activity::ConstModelPtr Activity::SequenceModel::make(
   const std::vector<ConstDescriptionPtr>& descriptions,
   rmf_task::State invariant_initial_state,
   const rmf_task::Parameters& parameters)
 {
-  std::vector<Activity::ConstModelPtr> models;
+  std::vector<Implementation::Step> steps;
   rmf_task::State invariant_finish_state = invariant_initial_state;
   rmf_traffic::Duration invariant_duration = rmf_traffic::Duration(0);
   for (const auto& desc : descriptions)
   {
-    auto next_model = desc->make_model(invariant_finish_state, parameters);
+    auto next_model =
+      ModelCache::make_model(*desc, invariant_finish_state, parameters);
     if (!next_model)
     {
       // TODO: Should we throw an error here?
@@ -48,13 +273,25 @@ Activity::ConstModelPtr Activity::SequenceModel::make(
     invariant_finish_state = next_model->invariant_finish_state();
     invariant_duration += next_model->invariant_duration();
 
-    models.emplace_back(std::move(next_model));
+    const auto* invariant =
+      dynamic_cast<const internal::InvariantModel*>(next_model.get());
+    if (!invariant)
+    {
+      steps.emplace_back();
+      steps.back().model = std::move(next_model);
+      continue;
+    }
+
+    if (steps.empty() || steps.back().model)
+      steps.emplace_back();
+
+    steps.back().fold(invariant->offset());
   }
 
   auto output = std::shared_ptr<SequenceModel>(new SequenceModel);
   output->_pimpl = rmf_utils::make_unique_impl<Implementation>(
     Implementation{
-      std::move(models),
+      std::move(steps),
       std::move(invariant_finish_state),
       invariant_duration
     });
@@ -62,6 +299,26 @@ Activity::ConstModelPtr Activity::SequenceModel::make(
   return output;
 }
 
+//==============================================================================
+std::optional<std::string> Activity::SequenceModel::model_key(
+  const std::vector<ConstDescriptionPtr>& descriptions)
+{
+  // Each key is prefixed by its size so that the keys of different sequences
+  // cannot run together into the same key
+  std::string key = "Sequence[";
+  for (const auto& desc : descriptions)
+  {
+    auto desc_key = desc->model_key();
+    if (!desc_key.has_value())
+      return std::nullopt;
+
+    key += std::to_string(desc_key->size()) + ":" + *desc_key;
+  }
+
+  key += "]";
+  return key;
+}
+
 //==============================================================================
 std::optional<Estimate> Activity::SequenceModel::estimate_finish(
   rmf_task::State initial_state,
@@ -71,9 +328,21 @@ std::optional<Estimate> Activity::SequenceModel::estimate_finish(
 {
   rmf_task::State finish_state = std::move(initial_state);
   std::optional<rmf_traffic::Time> wait_until;
-  for (const auto& model : _pimpl->models)
+  for (const auto& step : _pimpl->steps)
   {
-    const auto estimate = model->estimate_finish(
+    if (!step.model)
+    {
+      if (!step.apply(
+          finish_state, constraints, travel_estimator.calibration()))
+        return std::nullopt;
+
+      if (!wait_until.has_value())
+        wait_until = earliest_arrival_time;
+
+      continue;
+    }
+
+    auto estimate = step.model->estimate_finish(
       std::move(finish_state),
       earliest_arrival_time,
       constraints,
@@ -82,7 +351,7 @@ std::optional<Estimate> Activity::SequenceModel::estimate_finish(
     if (!estimate.has_value())
       return std::nullopt;
 
-    finish_state = estimate->finish_state();
+    finish_state = std::move(*estimate).finish_state();
     if (!wait_until.has_value())
       wait_until = estimate->wait_until();
   }
@@ -114,5 +383,96 @@ Activity::SequenceModel::SequenceModel()
   // Do nothing
 }
 
+//==============================================================================
+Activity::ConstModelPtr Activity::ModelCache::make_model(
+  const Description& description,
+  State invariant_initial_state,
+  const Parameters& parameters)
+{
+  auto& memo = ModelMemo::get();
+  const auto model_key = description.model_key();
+  if (!model_key.has_value() || capacity() == 0)
+  {
+    return description.make_model(
+      std::move(invariant_initial_state), parameters);
+  }
+
+  auto key = memo_key(*model_key, invariant_initial_state, parameters);
+  {
+    std::lock_guard<std::mutex> lock(memo.mutex);
+    const auto it = memo.index.find(key);
+    if (it != memo.index.end())
+    {
+      // The planner or sinks might have been replaced by new ones at the
+      // same addresses, so make sure they are still the same objects
+      const auto entry = it->second;
+      if (entry->sources.match(parameters))
+      {
+        memo.entries.splice(memo.entries.begin(), memo.entries, entry);
+        return entry->model;
+      }
+
+      memo.entries.erase(entry);
+      memo.index.erase(it);
+    }
+  }
+
+  // The model is made without holding the lock, because making it may need
+  // the models of the descriptions that it depends on
+  auto model = description.make_model(
+    std::move(invariant_initial_state), parameters);
+  if (!model)
+    return model;
+
+  std::lock_guard<std::mutex> lock(memo.mutex);
+  const auto it = memo.index.find(key);
+  if (it != memo.index.end())
+  {
+    memo.entries.erase(it->second);
+    memo.index.erase(it);
+  }
+
+  memo.entries.push_front(
+    ModelMemo::Entry{key, model, ModelMemo::Sources::of(parameters)});
+  memo.index.insert({std::move(key), memo.entries.begin()});
+  memo.trim();
+
+  return model;
+}
+
+//==============================================================================
+void Activity::ModelCache::capacity(std::size_t value)
+{
+  auto& memo = ModelMemo::get();
+  std::lock_guard<std::mutex> lock(memo.mutex);
+  memo.capacity = value;
+  memo.trim();
+}
+
+//==============================================================================
+std::size_t Activity::ModelCache::capacity()
+{
+  auto& memo = ModelMemo::get();
+  std::lock_guard<std::mutex> lock(memo.mutex);
+  return memo.capacity;
+}
+
+//==============================================================================
+std::size_t Activity::ModelCache::size()
+{
+  auto& memo = ModelMemo::get();
+  std::lock_guard<std::mutex> lock(memo.mutex);
+  return memo.entries.size();
+}
+
+//==============================================================================
+void Activity::ModelCache::clear()
+{
+  auto& memo = ModelMemo::get();
+  std::lock_guard<std::mutex> lock(memo.mutex);
+  memo.entries.clear();
+  memo.index.clear();
+}
+
 
 } // namespace rmf_task_sequence
@@ -17,6 +17,8 @@
 
 #include <rmf_task_sequence/Event.hpp>
 
+#include <vector>
+
 namespace rmf_task_sequence {
 
 //==============================================================================
@@ -24,8 +26,9 @@ class Event::Initializer::Implementation
 {
 public:
 
-  std::unordered_map<std::type_index, Initialize<Description>> initializers;
-  std::unordered_map<std::type_index, Restore<Description>> restorers;
+  // Both are indexed by rmf_task::detail::DispatchIndex
+  std::vector<Initialize<Description>> initializers;
+  std::vector<Restore<Description>> restorers;
 
 };
 
@@ -44,12 +47,12 @@ Event::StandbyPtr Event::Initializer::initialize(
   const Event::Description& description,
   std::function<void()> update) const
 {
-  const auto& type = typeid(description);
-  const auto it = _pimpl->initializers.find(type);
-  if (it == _pimpl->initializers.end())
+  const auto index = description.dispatch_index();
+  const auto& initializers = _pimpl->initializers;
+  if (initializers.size() <= index || !initializers[index])
     return nullptr;
 
-  return it->second(
+  return initializers[index](
     id,
     get_state,
     parameters,
@@ -68,12 +71,12 @@ Event::ActivePtr Event::Initializer::restore(
   std::function<void()> checkpoint,
   std::function<void()> finished) const
 {
-  const auto& type = typeid(description);
-  const auto it = _pimpl->restorers.find(type);
-  if (it == _pimpl->restorers.end())
+  const auto index = description.dispatch_index();
+  const auto& restorers = _pimpl->restorers;
+  if (restorers.size() <= index || !restorers[index])
     return nullptr;
 
-  return it->second(
+  return restorers[index](
     id,
     get_state,
     parameters,
@@ -90,8 +93,15 @@ void Event::Initializer::_add(
   Initialize<Event::Description> initializer,
   Restore<Event::Description> restorer)
 {
-  _pimpl->initializers.insert_or_assign(type, std::move(initializer));
-  _pimpl->restorers.insert_or_assign(type, std::move(restorer));
+  const auto index = rmf_task::detail::DispatchIndex::of(type);
+  if (_pimpl->initializers.size() <= index)
+  {
+    _pimpl->initializers.resize(index + 1);
+    _pimpl->restorers.resize(index + 1);
+  }
+
+  _pimpl->initializers[index] = std::move(initializer);
+  _pimpl->restorers[index] = std::move(restorer);
 }
 
 } // namespace rmf_task_sequence
@@ -17,6 +17,8 @@
 
 #include <rmf_task_sequence/Phase.hpp>
 
+#include <vector>
+
 namespace rmf_task_sequence {
 
 //==============================================================================
@@ -24,7 +26,8 @@ class Phase::Activator::Implementation
 {
 public:
 
-  std::unordered_map<std::type_index, Activate<Phase::Description>> activators;
+  // Indexed by rmf_task::detail::DispatchIndex
+  std::vector<Activate<Phase::Description>> activators;
 
 };
 
@@ -46,12 +49,12 @@ Phase::ActivePtr Phase::Activator::activate(
   std::function<void(Active::Backup)> checkpoint,
   std::function<void()> finished) const
 {
-  const auto& type = typeid(description);
-  const auto it = _pimpl->activators.find(type);
-  if (it == _pimpl->activators.end())
+  const auto index = description.dispatch_index();
+  const auto& activators = _pimpl->activators;
+  if (activators.size() <= index || !activators[index])
     return nullptr;
 
-  return it->second(
+  return activators[index](
     get_state,
     parameters,
     std::move(tag),
@@ -66,7 +69,11 @@ Phase::ActivePtr Phase::Activator::activate(
 void Phase::Activator::_add_activator(
   std::type_index type, Activate<Phase::Description> activator)
 {
-  _pimpl->activators.insert_or_assign(type, std::move(activator));
+  const auto index = rmf_task::detail::DispatchIndex::of(type);
+  if (_pimpl->activators.size() <= index)
+    _pimpl->activators.resize(index + 1);
+
+  _pimpl->activators[index] = std::move(activator);
 }
 
 } // namespace rmf_task_sequence
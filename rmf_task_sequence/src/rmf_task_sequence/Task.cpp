@@ -16,6 +16,7 @@
 */
 
 #include "phases/internal_CancellationPhase.hpp"
+#include "schemas/internal_TrustedBackup.hpp"
 
 #include <list>
 
@@ -29,8 +30,11 @@
 
 #include <rmf_utils/Modular.hpp>
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <mutex>
+#include <thread>
 
 namespace rmf_task_sequence {
 
@@ -44,8 +48,117 @@ struct Stage
   std::vector<Phase::ConstDescriptionPtr> cancellation_sequence;
 };
 using ConstStagePtr = std::shared_ptr<const Stage>;
+
+//==============================================================================
+// A binary backup starts with a null character, which JSON text never does,
+// followed by a marker, a code for its encoding, and the version of this
+// layout. The encoded state comes after that.
+constexpr char BinaryBackupMarker = 'B';
+constexpr char BinaryBackupVersion = 1;
+constexpr std::size_t BinaryBackupHeaderSize = 4;
+constexpr char CborCode = 'C';
+constexpr char MessagePackCode = 'M';
+
+//==============================================================================
+bool is_binary_backup(const std::string& backup)
+{
+  return !backup.empty() && backup.front() == '\0';
+}
+
+//==============================================================================
+std::string encode_backup(
+  const nlohmann::json& state,
+  Task::BackupEncoding encoding)
+{
+  if (encoding == Task::BackupEncoding::Json)
+    return state.dump();
+
+  const bool cbor = encoding == Task::BackupEncoding::Cbor;
+  std::string output = {
+    '\0',
+    BinaryBackupMarker,
+    cbor ? CborCode : MessagePackCode,
+    BinaryBackupVersion
+  };
+
+  if (cbor)
+    nlohmann::json::to_cbor(state, output);
+  else
+    nlohmann::json::to_msgpack(state, output);
+
+  return output;
+}
+
+//==============================================================================
+nlohmann::json decode_backup(const std::string& backup)
+{
+  if (!is_binary_backup(backup))
+    return nlohmann::json::parse(backup);
+
+  if (backup.size() < BinaryBackupHeaderSize
+    || backup[1] != BinaryBackupMarker)
+    throw std::runtime_error("Unrecognized binary backup format");
+
+  if (backup[3] != BinaryBackupVersion)
+  {
+    throw std::runtime_error(
+            "Unsupported binary backup version ["
+            + std::to_string(static_cast<int>(backup[3])) + "]");
+  }
+
+  const auto begin = backup.begin() + BinaryBackupHeaderSize;
+  if (backup[2] == CborCode)
+    return nlohmann::json::from_cbor(begin, backup.end());
+
+  if (backup[2] == MessagePackCode)
+    return nlohmann::json::from_msgpack(begin, backup.end());
+
+  throw std::runtime_error(
+          "Unrecognized binary backup encoding [" + backup.substr(2, 1) + "]");
+}
+
+//==============================================================================
+// Roughly how many bytes a JSON value holds on to
+std::size_t json_memory_usage(const nlohmann::json& json)
+{
+  std::size_t bytes = sizeof(nlohmann::json);
+  if (json.is_string())
+  {
+    bytes += json.get_ref<const std::string&>().capacity();
+  }
+  else if (json.is_object())
+  {
+    for (auto it = json.begin(); it != json.end(); ++it)
+      bytes += it.key().capacity() + json_memory_usage(it.value());
+  }
+  else if (json.is_array())
+  {
+    for (const auto& value : json)
+      bytes += json_memory_usage(value);
+  }
+
+  return bytes;
+}
 } // anonymous namespace
 
+//==============================================================================
+class Task::BackupOptions::Implementation
+{
+public:
+  BackupEncoding encoding = BackupEncoding::Json;
+  bool delta = false;
+  rmf_traffic::Duration checkpoint_interval = rmf_traffic::Duration(0);
+};
+
+//==============================================================================
+class Task::UpdateOptions::Implementation
+{
+public:
+  Schedule schedule;
+  rmf_traffic::Duration interval = rmf_traffic::Duration(0);
+  AllocationReport allocation_report;
+};
+
 //==============================================================================
 class Task::Builder::Implementation
 {
@@ -53,6 +166,22 @@ public:
   std::vector<ConstStagePtr> stages;
 };
 
+//==============================================================================
+class Task::Template::Implementation
+{
+public:
+
+  // Each phase of the template has either a fixed stage or a way to make one
+  struct Slot
+  {
+    ConstStagePtr stage;
+    Substitute substitute;
+    std::vector<Phase::ConstDescriptionPtr> cancellation_sequence;
+  };
+
+  std::vector<Slot> slots;
+};
+
 //==============================================================================
 class Task::Description::Implementation
 {
@@ -138,10 +267,13 @@ public:
   static Task::ActivePtr make(
     Phase::ConstActivatorPtr phase_activator,
     std::function<rmf_traffic::Time()> clock,
+    BackupOptions backup_options,
+    UpdateOptions update_options,
     std::function<State()> get_state,
     const ConstParametersPtr& parameters,
     const ConstBookingPtr& booking,
     const Description& description,
+    rmf_task::Task::ConstModelPtr model,
     std::optional<std::string> backup_state,
     std::function<void(Phase::ConstSnapshotPtr)> update,
     std::function<void(Task::Active::Backup)> checkpoint,
@@ -152,10 +284,13 @@ public:
       new Active(
         std::move(phase_activator),
         std::move(clock),
+        std::move(backup_options),
+        std::move(update_options),
         std::move(get_state),
         parameters,
         booking,
         description,
+        std::move(model),
         std::move(update),
         std::move(checkpoint),
         std::move(phase_finished),
@@ -167,7 +302,7 @@ public:
       return task;
     }
 
-    task->_generate_pending_phases();
+    task->_reset_pending_phases();
     task->_begin_next_stage();
 
     return task;
@@ -215,7 +350,10 @@ public:
   // Documentation inherited
   void rewind(uint64_t phase_id) final;
 
-  static const nlohmann::json_schema::json_validator backup_schema_validator;
+  // Documentation inherited
+  rmf_task::MemoryUsage memory_usage() const final;
+
+  ~Active();
 
 private:
 
@@ -226,7 +364,13 @@ private:
   /// \return false if the task needs to be aborted due to a bad backup_state,
   /// otherwise return true.
   void _load_backup(std::string backup_state);
-  void _generate_pending_phases();
+
+  /// Forget the pending phases that have been generated so far. They will be
+  /// generated again from the current state as they are needed.
+  void _reset_pending_phases();
+
+  /// Make sure that the first count pending phases have been generated.
+  void _generate_pending_phases(std::size_t count) const;
 
   void _finish_phase(Phase::Tag::Id id);
   void _begin_next_stage(std::optional<nlohmann::json> restore = std::nullopt);
@@ -236,14 +380,41 @@ private:
     std::vector<Phase::ConstDescriptionPtr> sequence);
 
   void _issue_backup(
+    Phase::Tag::Id source_phase_id,
+    Phase::Active::Backup phase_backup,
+    bool force = false) const;
+
+  bool _checkpoint_is_due() const;
+
+  void _send_checkpoint(
     Phase::Tag::Id source_phase_id,
     Phase::Active::Backup phase_backup) const;
 
-  Backup _generate_backup(
+  /// Send the checkpoint that is being held back, if there is one, once the
+  /// checkpoint interval has passed, or right away if force is true.
+  void _flush_held_checkpoint(bool force = false) const;
+
+  void _request_update(Phase::ConstSnapshotPtr snapshot) const;
+
+  bool _update_is_due() const;
+
+  void _send_update(Phase::ConstSnapshotPtr snapshot) const;
+
+  void _flush_held_update() const;
+
+  /// Schedule a flush of the held update, unless one is already scheduled.
+  void _schedule_update_flush() const;
+
+  nlohmann::json _generate_backup_state(
     Phase::Tag::Id current_phase_id,
     Phase::Active::Backup phase_backup) const;
 
-  Backup _empty_backup() const;
+  nlohmann::json _empty_backup_state() const;
+
+  // Checkpoints may be deltas, and a full checkpoint becomes the base of the
+  // deltas that follow it. Any other backup is always full and never becomes
+  // the base, because it might never be written where the checkpoints go.
+  Backup _make_backup(nlohmann::json state, bool checkpoint) const;
 
   std::string _task_id() const
   {
@@ -267,21 +438,27 @@ private:
   Active(
     Phase::ConstActivatorPtr phase_activator,
     std::function<rmf_traffic::Time()> clock,
+    BackupOptions backup_options,
+    UpdateOptions update_options,
     std::function<State()> get_state,
     const ConstParametersPtr& parameters,
     const ConstBookingPtr& booking,
     const Description& description,
+    rmf_task::Task::ConstModelPtr model,
     std::function<void(Phase::ConstSnapshotPtr)> update,
     std::function<void(Backup)> checkpoint,
     std::function<void(Phase::ConstCompletedPtr)> phase_finished,
     std::function<void()> task_finished)
   : _phase_activator(std::move(phase_activator)),
     _clock(std::move(clock)),
+    _backup_options(std::move(backup_options)),
+    _update_options(std::move(update_options)),
     _get_state(std::move(get_state)),
     _parameters(parameters),
     _tag(std::make_shared<Tag>(
         booking,
-        description.generate_header(_get_state(), *parameters))),
+        description.generate_header(
+          _get_state(), *parameters, std::move(model)))),
     _update(std::move(update)),
     _checkpoint(std::move(checkpoint)),
     _phase_finished(std::move(phase_finished)),
@@ -295,6 +472,8 @@ private:
 
   Phase::ConstActivatorPtr _phase_activator;
   std::function<rmf_traffic::Time()> _clock;
+  BackupOptions _backup_options;
+  UpdateOptions _update_options;
   std::function<State()> _get_state;
   ConstParametersPtr _parameters;
   ConstTagPtr _tag;
@@ -307,7 +486,13 @@ private:
   std::optional<Resume> _resume_phase;
 
   std::list<ConstStagePtr> _pending_stages;
-  std::vector<Phase::Pending> _pending_phases;
+
+  // Generating the header of a pending phase can be expensive, so the pending
+  // phases are only generated as they are needed, in the order of
+  // _pending_stages. _next_pending_state is the state that the next phase to
+  // be generated is predicted to start from.
+  mutable std::vector<Phase::Pending> _pending_phases;
+  mutable std::optional<State> _next_pending_state;
 
   ConstStagePtr _active_stage;
   Phase::ActivePtr _active_phase;
@@ -315,7 +500,7 @@ private:
 
   std::list<ConstStagePtr> _completed_stages;
   std::vector<Phase::ConstCompletedPtr> _completed_phases;
-  std::recursive_mutex _next_phase_mutex;
+  mutable std::recursive_mutex _next_phase_mutex;
 
   std::optional<Resume> _resume_interrupted_phase;
   std::optional<Phase::Tag::Id> _cancelled_on_phase = std::nullopt;
@@ -325,14 +510,143 @@ private:
   mutable std::optional<uint64_t> _last_phase_backup_sequence_number;
   mutable uint64_t _next_task_backup_sequence_number = 0;
 
+  // The latest full backup that was given out, which delta checkpoints are
+  // generated against
+  struct DeltaBase
+  {
+    uint64_t sequence;
+    nlohmann::json state;
+  };
+  mutable std::optional<DeltaBase> _delta_base;
+
+  // The latest phase backup that arrived before the checkpoint interval
+  // passed. It gets replaced by any newer phase backup.
+  struct HeldCheckpoint
+  {
+    Phase::Tag::Id phase_id;
+    Phase::Active::Backup backup;
+  };
+  mutable std::optional<HeldCheckpoint> _held_checkpoint;
+  mutable std::optional<rmf_traffic::Time> _last_checkpoint_time;
+
+  // Whether a change in the event tree is waiting to be issued as an update.
+  // The held snapshot is the latest one that the phase gave for it, or a
+  // nullptr if the snapshot should be made when the update is issued.
+  mutable bool _update_held = false;
+  mutable Phase::ConstSnapshotPtr _held_snapshot;
+
+  // The latest snapshot of the active phase, which the next snapshot of the
+  // phase can share its unchanged events with
+  mutable Phase::ConstSnapshotPtr _last_snapshot;
+  mutable bool _update_scheduled = false;
+  mutable std::optional<rmf_traffic::Time> _last_update_time;
+
+  // The allocation counters of the thread that issued the previous update,
+  // taken right after it was reported
+  struct AllocationMark
+  {
+    std::thread::id thread;
+    rmf_task::AllocationCounter::Counts counts;
+  };
+  mutable std::optional<AllocationMark> _last_update_allocations;
+
   const uint64_t _cancel_sequence_initial_id;
 };
 
 //==============================================================================
-const nlohmann::json_schema::json_validator
-Task::Active::backup_schema_validator =
-  nlohmann::json_schema::json_validator(
-  schemas::backup_PhaseSequenceTask_v0_1);
+Task::BackupOptions::BackupOptions()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto Task::BackupOptions::encoding(BackupEncoding value) -> BackupOptions&
+{
+  _pimpl->encoding = value;
+  return *this;
+}
+
+//==============================================================================
+auto Task::BackupOptions::encoding() const -> BackupEncoding
+{
+  return _pimpl->encoding;
+}
+
+//==============================================================================
+auto Task::BackupOptions::delta(bool value) -> BackupOptions&
+{
+  _pimpl->delta = value;
+  return *this;
+}
+
+//==============================================================================
+bool Task::BackupOptions::delta() const
+{
+  return _pimpl->delta;
+}
+
+//==============================================================================
+auto Task::BackupOptions::checkpoint_interval(rmf_traffic::Duration value)
+-> BackupOptions&
+{
+  _pimpl->checkpoint_interval = value;
+  return *this;
+}
+
+//==============================================================================
+rmf_traffic::Duration Task::BackupOptions::checkpoint_interval() const
+{
+  return _pimpl->checkpoint_interval;
+}
+
+//==============================================================================
+Task::UpdateOptions::UpdateOptions()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto Task::UpdateOptions::schedule(Schedule value) -> UpdateOptions&
+{
+  _pimpl->schedule = std::move(value);
+  return *this;
+}
+
+//==============================================================================
+auto Task::UpdateOptions::schedule() const -> const Schedule&
+{
+  return _pimpl->schedule;
+}
+
+//==============================================================================
+auto Task::UpdateOptions::interval(rmf_traffic::Duration value)
+-> UpdateOptions&
+{
+  _pimpl->interval = value;
+  return *this;
+}
+
+//==============================================================================
+rmf_traffic::Duration Task::UpdateOptions::interval() const
+{
+  return _pimpl->interval;
+}
+
+//==============================================================================
+auto Task::UpdateOptions::allocation_report(AllocationReport value)
+-> UpdateOptions&
+{
+  _pimpl->allocation_report = std::move(value);
+  return *this;
+}
+
+//==============================================================================
+auto Task::UpdateOptions::allocation_report() const -> const AllocationReport&
+{
+  return _pimpl->allocation_report;
+}
 
 //==============================================================================
 Task::Builder::Builder()
@@ -371,6 +685,84 @@ auto Task::Builder::build(
     _pimpl->stages);
 }
 
+//==============================================================================
+Task::Template::Template()
+: _pimpl(rmf_utils::make_impl<Implementation>())
+{
+  // Do nothing
+}
+
+//==============================================================================
+auto Task::Template::add_phase(
+  Phase::ConstDescriptionPtr description,
+  std::vector<Phase::ConstDescriptionPtr> cancellation_sequence) -> Template&
+{
+  // Phase IDs are assigned the same way as Task::Builder::add_phase(~)
+  _pimpl->slots.push_back(
+    Implementation::Slot{
+      std::make_shared<Stage>(
+        Stage{
+          _pimpl->slots.size()+1,
+          std::move(description),
+          std::move(cancellation_sequence)
+        }),
+      nullptr,
+      {}
+    });
+
+  return *this;
+}
+
+//==============================================================================
+auto Task::Template::add_phase(
+  Substitute substitute,
+  std::vector<Phase::ConstDescriptionPtr> cancellation_sequence) -> Template&
+{
+  _pimpl->slots.push_back(
+    Implementation::Slot{
+      nullptr,
+      std::move(substitute),
+      std::move(cancellation_sequence)
+    });
+
+  return *this;
+}
+
+//==============================================================================
+auto Task::Template::instantiate(
+  const nlohmann::json& arguments,
+  std::string category,
+  std::string detail) const -> std::shared_ptr<Description>
+{
+  std::vector<ConstStagePtr> stages;
+  stages.reserve(_pimpl->slots.size());
+  for (const auto& slot : _pimpl->slots)
+  {
+    if (slot.stage)
+    {
+      stages.push_back(slot.stage);
+      continue;
+    }
+
+    auto description = slot.substitute(arguments);
+    if (!description)
+      return nullptr;
+
+    stages.push_back(
+      std::make_shared<Stage>(
+        Stage{
+          stages.size()+1,
+          std::move(description),
+          slot.cancellation_sequence
+        }));
+  }
+
+  return Description::Implementation::make(
+    std::move(category),
+    std::move(detail),
+    std::move(stages));
+}
+
 //==============================================================================
 Task::ConstModelPtr Task::Description::make_model(
   rmf_traffic::Time earliest_start_time,
@@ -429,11 +821,13 @@ Task::Description& Task::Description::detail(std::string new_category)
 //==============================================================================
 Header Task::Description::generate_header(
   const State& initial_state,
-  const Parameters& parameters) const
+  const Parameters& parameters,
+  rmf_task::Task::ConstModelPtr model) const
 {
-  const auto model = make_model(
-    initial_state.time().value(),
-    parameters);
+  // The invariant duration does not depend on the start time, so a model that
+  // the planner already made for this description can be used as it is
+  if (!model)
+    model = make_model(initial_state.time().value(), parameters);
 
   return Header(
     _pimpl->category,
@@ -453,13 +847,13 @@ rmf_task::Event::Status Task::Active::status_overview() const
   if (_active_phase)
     return _active_phase->final_event()->status();
 
-  if (_completed_phases.empty() && _pending_phases.empty())
+  if (_completed_phases.empty() && _pending_stages.empty())
   {
     // This means the task had no phases..? So it's completed by default.
     return Event::Status::Completed;
   }
 
-  if (_pending_phases.empty())
+  if (_pending_stages.empty())
   {
     // There are no pending phases, so the status of this task should be
     // reflected by the status of the last phase.
@@ -502,6 +896,7 @@ std::optional<rmf_traffic::Time> Task::Active::active_phase_start_time() const
 //==============================================================================
 const std::vector<Phase::Pending>& Task::Active::pending_phases() const
 {
+  _generate_pending_phases(_pending_stages.size());
   return _pending_phases;
 }
 
@@ -520,7 +915,7 @@ rmf_traffic::Duration Task::Active::estimate_remaining_time() const
   auto remaining_time =
     _active_phase ? _active_phase->estimate_remaining_time() :
     rmf_traffic::Duration(0);
-  for (const auto& p : _pending_phases)
+  for (const auto& p : pending_phases())
     remaining_time += p.tag()->header().original_duration_estimate();
 
   return remaining_time;
@@ -529,12 +924,21 @@ rmf_traffic::Duration Task::Active::estimate_remaining_time() const
 //==============================================================================
 auto Task::Active::backup() const -> Backup
 {
+  std::lock_guard lock(_next_phase_mutex);
+
+  // The checkpoint that was held back is older than this backup, but it is
+  // sent anyway, since this backup might never be written where the
+  // checkpoints go
+  _flush_held_checkpoint(true);
+
   if (!_active_phase || _finished)
-    return _empty_backup();
+    return _make_backup(_empty_backup_state(), false);
 
-  return _generate_backup(
-    _active_phase->tag()->id(),
-    _active_phase->backup());
+  return _make_backup(
+    _generate_backup_state(
+      _active_phase->tag()->id(),
+      _active_phase->backup()),
+    false);
 }
 
 //==============================================================================
@@ -603,6 +1007,7 @@ void Task::Active::skip(uint64_t phase_id, bool value)
     return;
   }
 
+  _generate_pending_phases(_pending_stages.size());
   for (auto& p : _pending_phases)
   {
     if (phase_id == p.tag()->id())
@@ -642,19 +1047,80 @@ void Task::Active::rewind(uint64_t phase_id)
 
   // The currently active stage should also be put back into pending
   _pending_stages.push_back(_active_stage);
-  _generate_pending_phases();
+  _reset_pending_phases();
 
   // If we are supposed to rewind to an earlier stage, then we should cancel
   // the currently active one.
   _active_phase->cancel();
 }
 
+//==============================================================================
+rmf_task::MemoryUsage Task::Active::memory_usage() const
+{
+  using Component = rmf_task::MemoryUsage::Component;
+
+  // The phases, snapshots and backups are replaced while the task makes
+  // progress, so they are all measured under the same lock
+  std::lock_guard lock(_next_phase_mutex);
+  auto usage = rmf_task::Task::Active::memory_usage();
+
+  if (_last_snapshot)
+  {
+    if (const auto event = _last_snapshot->final_event())
+      usage.add(event->memory_usage());
+  }
+
+  if (_held_snapshot && _held_snapshot != _last_snapshot)
+  {
+    if (const auto event = _held_snapshot->final_event())
+      usage.add(event->memory_usage());
+  }
+
+  if (_held_checkpoint.has_value())
+  {
+    usage.add(
+      Component::Backup, json_memory_usage(_held_checkpoint->backup.state()));
+  }
+
+  if (_delta_base.has_value())
+    usage.add(Component::Backup, json_memory_usage(_delta_base->state));
+
+  return usage;
+}
+
+//==============================================================================
+Task::Active::~Active()
+{
+  // Do not lose the latest progress of the task just because the checkpoint
+  // interval had not passed yet
+  std::lock_guard lock(_next_phase_mutex);
+  _flush_held_checkpoint(true);
+}
+
 //==============================================================================
 void Task::Active::_load_backup(std::string backup_state_str)
 {
   std::lock_guard lock(_next_phase_mutex);
+
+  std::optional<nlohmann::json> decoded;
+  std::string decode_error;
+  try
+  {
+    decoded = decode_backup(backup_state_str);
+  }
+  catch (const std::exception& e)
+  {
+    decode_error = e.what();
+  }
+
+  // Binary backups are logged as JSON so that people can read them
+  const bool binary = is_binary_backup(backup_state_str);
   const auto restore_phase = rmf_task::phases::RestoreBackup::Active::make(
-    backup_state_str, rmf_traffic::Duration(0));
+    !binary ? backup_state_str :
+    decoded ? decoded->dump() :
+    "[binary backup of " + std::to_string(backup_state_str.size())
+    + " bytes]",
+    rmf_traffic::Duration(0));
 
   const auto start_time = _clock();
 
@@ -671,14 +1137,30 @@ void Task::Active::_load_backup(std::string backup_state_str)
       _finish_task();
     };
 
-  const auto backup_state = nlohmann::json::parse(backup_state_str);
-  if (const auto result =
-    schemas::ErrorHandler::has_error(backup_schema_validator, backup_state))
+  if (!decoded.has_value())
   {
-    restore_phase->parsing_failed(result->message);
+    restore_phase->parsing_failed(decode_error);
     return failed_to_restore();
   }
 
+  // A backup that was written by this same version of the library and has
+  // not been altered since does not need to be validated. That also goes for
+  // the backups of its phases and events, which get restored within this
+  // scope.
+  const nlohmann::json& backup_state = *decoded;
+  const bool trusted = schemas::TrustedBackup::check(backup_state);
+  const schemas::TrustedBackup::Scope trusted_scope(trusted);
+  if (!trusted)
+  {
+    if (const auto result =
+      schemas::ErrorHandler::has_error(
+        schemas::backup_PhaseSequenceTask_v0_1_validator(), backup_state))
+    {
+      restore_phase->parsing_failed(result->message);
+      return failed_to_restore();
+    }
+  }
+
   const auto finished_it = backup_state.find("finished");
   if (finished_it != backup_state.end())
   {
@@ -689,7 +1171,7 @@ void Task::Active::_load_backup(std::string backup_state_str)
       return;
     }
 
-    _generate_pending_phases();
+    _reset_pending_phases();
     _begin_next_stage();
     return;
   }
@@ -744,10 +1226,14 @@ void Task::Active::_load_backup(std::string backup_state_str)
     return failed_to_restore();
   }
 
+  _reset_pending_phases();
   const auto& skip_phases_json = backup_state["skip_phases"];
   if (skip_phases_json)
   {
     const auto skip_phases = skip_phases_json.get<std::vector<uint64_t>>();
+    if (!skip_phases.empty())
+      _generate_pending_phases(_pending_stages.size());
+
     auto pending_it = _pending_phases.begin();
     const auto pending_end = _pending_phases.end();
     for (const auto& id : skip_phases)
@@ -777,18 +1263,30 @@ void Task::Active::_load_backup(std::string backup_state_str)
     }
   }
 
-  _generate_pending_phases();
   _begin_next_stage(std::optional<nlohmann::json>(current_phase_json["state"]));
 }
 
 //==============================================================================
-void Task::Active::_generate_pending_phases()
+void Task::Active::_reset_pending_phases()
 {
-  auto state = _get_state();
   _pending_phases.clear();
+  _next_pending_state = _get_state();
+}
+
+//==============================================================================
+void Task::Active::_generate_pending_phases(std::size_t count) const
+{
+  std::lock_guard lock(_next_phase_mutex);
+  count = std::min(count, _pending_stages.size());
+  if (count <= _pending_phases.size())
+    return;
+
   _pending_phases.reserve(_pending_stages.size());
-  for (const auto& s : _pending_stages)
+  auto& state = _next_pending_state.value();
+  auto stage_it = std::next(_pending_stages.begin(), _pending_phases.size());
+  for (; _pending_phases.size() < count; ++stage_it)
   {
+    const auto& s = *stage_it;
     _pending_phases.emplace_back(
       std::make_shared<Phase::Tag>(
         s->id,
@@ -820,7 +1318,7 @@ void Task::Active::_finish_phase(Phase::Tag::Id id)
 
   const auto phase_finish_time = _clock();
   const auto completed_phase = std::make_shared<Phase::Completed>(
-    rmf_task::Phase::Snapshot::make(*_active_phase),
+    rmf_task::Phase::Snapshot::make(*_active_phase, _last_snapshot),
     _current_phase_start_time.value(),
     phase_finish_time);
 
@@ -863,8 +1361,9 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
       return _finish_task();
     }
 
+    _generate_pending_phases(1);
     bool stage_and_phase_consistency = true;
-    if (_pending_stages.size() != _pending_phases.size())
+    if (_pending_stages.size() < _pending_phases.size())
     {
       stage_and_phase_consistency = false;
     }
@@ -897,8 +1396,9 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
 
     if (!stage_and_phase_consistency)
     {
-      // These containers are always supposed to have the same size, so this
-      // indicates a serious logic error or race condition has taken place.
+      // The generated pending phases are always supposed to match the front of
+      // the pending stages, so this indicates a serious logic error or race
+      // condition has taken place.
       std::stringstream ss;
       ss << "Mismatch between _pending_stages [";
       for (const auto& p : _pending_stages)
@@ -1039,9 +1539,10 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
         {
           if (const auto self = me.lock())
           {
-            const auto active_phase = self->_active_phase;
-            if (active_phase)
-              self->_update(Phase::Snapshot::make(*active_phase));
+            // The snapshot of the cancellation phase is made when the update
+            // gets issued
+            self->_request_update(nullptr);
+            self->_flush_held_checkpoint();
           }
         },
         [me = weak_from_this(), id = phase_id](
@@ -1069,7 +1570,10 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
         [me = weak_from_this()](Phase::ConstSnapshotPtr snapshot)
         {
           if (const auto self = me.lock())
-            self->_update(snapshot);
+          {
+            self->_request_update(std::move(snapshot));
+            self->_flush_held_checkpoint();
+          }
         },
         [me = weak_from_this(), id = phase_id](
           Phase::Active::Backup backup)
@@ -1084,8 +1588,11 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
         });
     }
 
-    _update(Phase::Snapshot::make(*_active_phase));
-    _issue_backup(phase_id, _active_phase->backup());
+    // Whatever was held for the previous phase is out of date now, and the
+    // first backup of a phase is never delayed
+    _held_checkpoint = std::nullopt;
+    _send_update(Phase::Snapshot::make(*_active_phase, nullptr));
+    _issue_backup(phase_id, _active_phase->backup(), true);
     return;
   }
 }
@@ -1094,13 +1601,18 @@ void Task::Active::_begin_next_stage(std::optional<nlohmann::json> restore)
 void Task::Active::_finish_task()
 {
   _finished = true;
+  _held_checkpoint = std::nullopt;
+  _update_held = false;
+  _held_snapshot = nullptr;
+  _last_snapshot = nullptr;
   _task_finished();
 }
 
 //==============================================================================
 void Task::Active::_issue_backup(
   Phase::Tag::Id source_phase_id,
-  Phase::Active::Backup phase_backup) const
+  Phase::Active::Backup phase_backup,
+  bool force) const
 {
   if (source_phase_id != _active_phase->tag()->id())
   {
@@ -1119,14 +1631,168 @@ void Task::Active::_issue_backup(
   }
 
   _last_phase_backup_sequence_number = phase_backup.sequence();
-  _checkpoint(_generate_backup(source_phase_id, std::move(phase_backup)));
+  if (!force && !_checkpoint_is_due())
+  {
+    // Hold on to the latest state without generating a backup for it yet
+    _held_checkpoint = HeldCheckpoint{source_phase_id, std::move(phase_backup)};
+    return;
+  }
+
+  _send_checkpoint(source_phase_id, std::move(phase_backup));
+}
+
+//==============================================================================
+bool Task::Active::_checkpoint_is_due() const
+{
+  const auto interval = _backup_options.checkpoint_interval();
+  if (interval <= rmf_traffic::Duration(0) || !_last_checkpoint_time)
+    return true;
+
+  return _clock() - *_last_checkpoint_time >= interval;
+}
+
+//==============================================================================
+void Task::Active::_send_checkpoint(
+  Phase::Tag::Id source_phase_id,
+  Phase::Active::Backup phase_backup) const
+{
+  _held_checkpoint = std::nullopt;
+  if (_backup_options.checkpoint_interval() > rmf_traffic::Duration(0))
+    _last_checkpoint_time = _clock();
+
+  _checkpoint(
+    _make_backup(
+      _generate_backup_state(source_phase_id, std::move(phase_backup)),
+      true));
+}
+
+//==============================================================================
+void Task::Active::_flush_held_checkpoint(bool force) const
+{
+  if (!_held_checkpoint.has_value() || (!force && !_checkpoint_is_due()))
+    return;
+
+  auto held = std::move(*_held_checkpoint);
+  if (!_active_phase || held.phase_id != _active_phase->tag()->id())
+  {
+    _held_checkpoint = std::nullopt;
+    return;
+  }
+
+  _send_checkpoint(held.phase_id, std::move(held.backup));
+}
+
+//==============================================================================
+void Task::Active::_request_update(Phase::ConstSnapshotPtr snapshot) const
+{
+  std::lock_guard lock(_next_phase_mutex);
+  const auto& schedule = _update_options.schedule();
+  if (!schedule && _update_options.interval() <= rmf_traffic::Duration(0))
+  {
+    _send_update(std::move(snapshot));
+    return;
+  }
+
+  _update_held = true;
+  _held_snapshot = std::move(snapshot);
+
+  if (!schedule)
+  {
+    _flush_held_update();
+    return;
+  }
+
+  _schedule_update_flush();
+}
+
+//==============================================================================
+void Task::Active::_schedule_update_flush() const
+{
+  if (_update_scheduled)
+    return;
+
+  _update_scheduled = true;
+  _update_options.schedule()(
+    [me = weak_from_this()]()
+    {
+      if (const auto self = me.lock())
+      {
+        std::lock_guard lock(self->_next_phase_mutex);
+        self->_update_scheduled = false;
+        self->_flush_held_update();
+
+        // The interval has not passed yet, so try again on the next tick
+        // instead of waiting for another change that might never come
+        if (self->_update_held && !self->_finished)
+          self->_schedule_update_flush();
+      }
+    });
+}
+
+//==============================================================================
+bool Task::Active::_update_is_due() const
+{
+  const auto interval = _update_options.interval();
+  if (interval <= rmf_traffic::Duration(0) || !_last_update_time)
+    return true;
+
+  return _clock() - *_last_update_time >= interval;
+}
+
+//==============================================================================
+void Task::Active::_send_update(Phase::ConstSnapshotPtr snapshot) const
+{
+  const auto& report = _update_options.allocation_report();
+  std::optional<rmf_task::AllocationCounter::Counts> allocations_before;
+  if (report)
+  {
+    const auto thread = std::this_thread::get_id();
+    if (_last_update_allocations && _last_update_allocations->thread == thread)
+      allocations_before = _last_update_allocations->counts;
+    else
+      allocations_before = rmf_task::AllocationCounter::this_thread();
+  }
+
+  _update_held = false;
+  _held_snapshot = nullptr;
+  if (_update_options.interval() > rmf_traffic::Duration(0))
+    _last_update_time = _clock();
+
+  if (!snapshot)
+  {
+    if (!_active_phase)
+      return;
+
+    snapshot = Phase::Snapshot::make(*_active_phase, _last_snapshot);
+  }
+
+  _last_snapshot = snapshot;
+  _update(std::move(snapshot));
+
+  if (report)
+  {
+    report(
+      rmf_task::AllocationCounter::this_thread().since(*allocations_before));
+    _last_update_allocations = AllocationMark{
+      std::this_thread::get_id(),
+      rmf_task::AllocationCounter::this_thread()
+    };
+  }
+}
+
+//==============================================================================
+void Task::Active::_flush_held_update() const
+{
+  if (!_update_held || _finished || !_update_is_due())
+    return;
+
+  _send_update(std::move(_held_snapshot));
 }
 
 //==============================================================================
 void Task::Active::_prepare_cancellation_sequence(
   std::vector<Phase::ConstDescriptionPtr> sequence)
 {
-  _pending_phases.clear();
   _pending_stages.clear();
 
   uint64_t next_stage_id = _cancel_sequence_initial_id;
@@ -1141,20 +1807,20 @@ void Task::Active::_prepare_cancellation_sequence(
         }));
   }
 
-  _generate_pending_phases();
+  _reset_pending_phases();
 }
 
 //==============================================================================
-auto Task::Active::_generate_backup(
+nlohmann::json Task::Active::_generate_backup_state(
   Phase::Tag::Id current_phase_id,
-  Phase::Active::Backup phase_backup) const -> Backup
+  Phase::Active::Backup phase_backup) const
 {
   nlohmann::json current_phase;
   current_phase["id"] = current_phase_id;
   if (_cancelled_on_phase.has_value())
     current_phase["cancelled_from"] = *_cancelled_on_phase;
 
-  current_phase["state"] = phase_backup.state();
+  current_phase["state"] = phase_backup.release_state();
 
   std::vector<uint64_t> skipping_phases;
   for (const auto& p : _pending_phases)
@@ -1168,12 +1834,14 @@ auto Task::Active::_generate_backup(
   root["current_phase"] = std::move(current_phase);
   root["skip_phases"] = std::move(skipping_phases);
   // TODO(MXG): Is there anything else we need to consider as part of the state?
+  auto stamp = schemas::TrustedBackup::stamp(root);
+  root[schemas::TrustedBackup::StampKey] = std::move(stamp);
 
-  return Backup::make(_next_task_backup_sequence_number++, root.dump());
+  return root;
 }
 
 //==============================================================================
-auto Task::Active::_empty_backup() const -> Backup
+nlohmann::json Task::Active::_empty_backup_state() const
 {
   // Either the task is finished or the first phase has not started. Either way
   // there is no phase information to provide for the backup. This special case
@@ -1182,24 +1850,73 @@ auto Task::Active::_empty_backup() const -> Backup
   nlohmann::json root;
   root["schema_version"] = 1;
   root["finished"] = _finished;
+  auto stamp = schemas::TrustedBackup::stamp(root);
+  root[schemas::TrustedBackup::StampKey] = std::move(stamp);
+
+  return root;
+}
+
+//==============================================================================
+auto Task::Active::_make_backup(
+  nlohmann::json state,
+  bool checkpoint) const -> Backup
+{
+  const auto sequence = _next_task_backup_sequence_number++;
+  if (!_backup_options.delta()
+    || _backup_options.encoding() != BackupEncoding::Json)
+  {
+    return Backup::make(
+      sequence, encode_backup(state, _backup_options.encoding()));
+  }
+
+  auto full = state.dump();
+  if (!checkpoint)
+  {
+    // A delta checkpoint against the old base could reach the backup files
+    // after this backup has replaced that base there, and a delta against
+    // this backup could reach them without it. Either way it would be
+    // dropped, so the next checkpoint is a full one instead. Deltas that
+    // were already given out keep their own base.
+    _delta_base = std::nullopt;
+    return Backup::make(sequence, std::move(full));
+  }
+
+  if (_delta_base.has_value())
+  {
+    auto patch = nlohmann::json::diff(_delta_base->state, state).dump();
+
+    // Once the state has drifted far enough from the base that the patch is
+    // no smaller than the whole state, a new full backup becomes the base
+    if (patch.size() < full.size())
+    {
+      return rmf_task::detail::Backup::make_delta(
+        sequence, _delta_base->sequence, std::move(patch));
+    }
+  }
 
-  return Backup::make(_next_task_backup_sequence_number++, root.dump());
+  _delta_base = DeltaBase{sequence, std::move(state)};
+  return Backup::make(sequence, std::move(full));
 }
 
 //==============================================================================
 auto Task::make_activator(
   Phase::ConstActivatorPtr phase_activator,
-  std::function<rmf_traffic::Time()> clock)
--> rmf_task::Activator::Activate<Description>
+  std::function<rmf_traffic::Time()> clock,
+  BackupOptions backup_options,
+  UpdateOptions update_options)
+-> rmf_task::Activator::ActivatePlanned<Description>
 {
   return [
     phase_activator = std::move(phase_activator),
-    clock = std::move(clock)
+    clock = std::move(clock),
+    backup_options = std::move(backup_options),
+    update_options = std::move(update_options)
   ](
     const std::function<State()>& get_state,
     const ConstParametersPtr& parameters,
     const ConstBookingPtr& booking,
     const Description& description,
+    rmf_task::Task::ConstModelPtr model,
     std::optional<std::string> backup_state,
     std::function<void(Phase::ConstSnapshotPtr)> update,
     std::function<void(Task::Active::Backup)> checkpoint,
@@ -1209,10 +1926,13 @@ auto Task::make_activator(
       return Active::make(
         phase_activator,
         clock,
+        backup_options,
+        update_options,
         std::move(get_state),
         parameters,
         booking,
         description,
+        std::move(model),
         std::move(backup_state),
         std::move(update),
         std::move(checkpoint),
@@ -1225,10 +1945,16 @@ auto Task::make_activator(
 void Task::add(
   rmf_task::Activator& activator,
   Phase::ConstActivatorPtr phase_activator,
-  std::function<rmf_traffic::Time()> clock)
+  std::function<rmf_traffic::Time()> clock,
+  BackupOptions backup_options,
+  UpdateOptions update_options)
 {
   activator.add_activator<Task::Description>(
-    make_activator(std::move(phase_activator), std::move(clock)));
+    make_activator(
+      std::move(phase_activator),
+      std::move(clock),
+      std::move(backup_options),
+      std::move(update_options)));
 }
 
 } // namespace rmf_task_sequence
@@ -40,7 +40,7 @@ Backup Backup::make(uint64_t seq, nlohmann::json state)
 {
   Backup backup;
   backup._pimpl = rmf_utils::make_impl<Implementation>(
-    Implementation{seq, state});
+    Implementation{seq, std::move(state)});
   return backup;
 }
 
@@ -56,6 +56,12 @@ const nlohmann::json& Backup::state() const
   return _pimpl->state;
 }
 
+//==============================================================================
+nlohmann::json Backup::release_state()
+{
+  return std::move(_pimpl->state);
+}
+
 
 } // namespace detail
 } // namespace rmf_task_sequence
\ No newline at end of file
@@ -24,8 +24,10 @@
 #include <rmf_task_sequence/schemas/ErrorHandler.hpp>
 #include <rmf_task_sequence/schemas/backup_EventSequence_v0_1.hpp>
 
+#include "internal_Parallel.hpp"
 #include "internal_Sequence.hpp"
 
+#include <algorithm>
 #include <vector>
 
 namespace rmf_task_sequence {
@@ -33,20 +35,183 @@ namespace events {
 
 namespace {
 //==============================================================================
-nlohmann::json convert_to_json(const std::string& input)
+nlohmann::json convert_to_json(const Header& header)
 {
-  nlohmann::json output;
-  try
+  const auto& detail = header.detail();
+  if (!header.detail_is_json())
   {
-    output = nlohmann::json::parse(input);
-  }
-  catch (const std::exception&)
-  {
-    output = input;
+    // Details from events that do not flag their JSON are only worth parsing
+    // when they could hold a JSON object or array.
+    const auto first = detail.find_first_not_of(" \t\n\r");
+    if (first == std::string::npos
+      || (detail[first] != '{' && detail[first] != '['))
+      return detail;
   }
 
+  auto output = nlohmann::json::parse(detail, nullptr, false);
+  if (output.is_discarded())
+    return detail;
+
   return output;
 }
+
+//==============================================================================
+/// The model of a bundle whose dependencies run in parallel. Every dependency
+/// starts from the same state. The bundle ends when its slowest dependency
+/// ends (ParallelAll) or when its quickest dependency ends (ParallelAny).
+class ParallelModel : public Activity::Model
+{
+public:
+
+  static Activity::ConstModelPtr make(
+    Bundle::Type type,
+    const Bundle::Description::Dependencies& dependencies,
+    rmf_task::State invariant_initial_state,
+    const Parameters& parameters)
+  {
+    std::vector<Activity::ConstModelPtr> models;
+    std::vector<rmf_task::State> finish_states;
+    std::vector<rmf_traffic::Duration> durations;
+    std::optional<rmf_traffic::Duration> duration;
+    models.reserve(dependencies.size());
+    for (const auto& desc : dependencies)
+    {
+      auto model = Activity::ModelCache::make_model(
+        *desc, invariant_initial_state, parameters);
+      if (!model)
+        return nullptr;
+
+      duration = internal::Parallel::combine(
+        type, duration, model->invariant_duration());
+      durations.push_back(model->invariant_duration());
+      finish_states.push_back(model->invariant_finish_state());
+      models.emplace_back(std::move(model));
+    }
+
+    auto finish_state = merge(
+      type, invariant_initial_state, finish_states, durations);
+
+    return std::make_shared<ParallelModel>(
+      type,
+      std::move(models),
+      std::move(finish_state),
+      duration.value_or(rmf_traffic::Duration(0)));
+  }
+
+  ParallelModel(
+    Bundle::Type type,
+    std::vector<Activity::ConstModelPtr> models,
+    rmf_task::State invariant_finish_state,
+    rmf_traffic::Duration invariant_duration)
+  : _type(type),
+    _models(std::move(models)),
+    _invariant_finish_state(std::move(invariant_finish_state)),
+    _invariant_duration(invariant_duration)
+  {
+    // Do nothing
+  }
+
+  std::optional<Estimate> estimate_finish(
+    rmf_task::State initial_state,
+    rmf_traffic::Time earliest_arrival_time,
+    const rmf_task::Constraints& constraints,
+    const rmf_task::TravelEstimator& travel_estimator) const final
+  {
+    if (_models.empty())
+      return Estimate(std::move(initial_state), earliest_arrival_time);
+
+    std::vector<rmf_task::State> finish_states;
+    std::vector<rmf_traffic::Duration> durations;
+    std::optional<rmf_traffic::Time> wait_until;
+    const auto start_time = initial_state.time().value();
+    for (const auto& model : _models)
+    {
+      auto estimate = model->estimate_finish(
+        initial_state, earliest_arrival_time, constraints, travel_estimator);
+
+      if (!estimate.has_value())
+        return std::nullopt;
+
+      if (!wait_until.has_value() || estimate->wait_until() < *wait_until)
+        wait_until = estimate->wait_until();
+
+      durations.push_back(
+        estimate->finish_state().time().value() - start_time);
+      finish_states.push_back(std::move(*estimate).finish_state());
+    }
+
+    auto finish_state = merge(_type, initial_state, finish_states, durations);
+    if (constraints.drain_battery() && finish_state.battery_soc().has_value())
+    {
+      // Branches that drain the battery together can go below the threshold
+      // even when none of them would on its own
+      const auto soc = *finish_state.battery_soc();
+      if (soc < 0.0 || soc <= constraints.threshold_soc())
+        return std::nullopt;
+    }
+
+    return Estimate(std::move(finish_state), *wait_until);
+  }
+
+  rmf_traffic::Duration invariant_duration() const final
+  {
+    return _invariant_duration;
+  }
+
+  rmf_task::State invariant_finish_state() const final
+  {
+    return _invariant_finish_state;
+  }
+
+private:
+
+  /// Merge the finish states of the dependencies into the finish state of the
+  /// bundle.
+  static rmf_task::State merge(
+    Bundle::Type type,
+    const rmf_task::State& initial_state,
+    const std::vector<rmf_task::State>& finish_states,
+    const std::vector<rmf_traffic::Duration>& durations)
+  {
+    if (finish_states.empty())
+      return initial_state;
+
+    std::size_t decider = 0;
+    for (std::size_t i = 1; i < durations.size(); ++i)
+    {
+      const bool better = type == Bundle::Type::ParallelAny ?
+        durations[i] < durations[decider] :
+        durations[decider] < durations[i];
+
+      if (better)
+        decider = i;
+    }
+
+    auto output = finish_states[decider];
+
+    // The branches of a ParallelAll bundle all run to the end, so each of them
+    // drains its own share of the battery.
+    const auto initial_soc = initial_state.battery_soc();
+    if (type == Bundle::Type::ParallelAll && initial_soc.has_value())
+    {
+      double soc = *initial_soc;
+      for (const auto& state : finish_states)
+      {
+        if (const auto branch_soc = state.battery_soc())
+          soc -= *initial_soc - *branch_soc;
+      }
+
+      output.battery_soc(soc);
+    }
+
+    return output;
+  }
+
+  Bundle::Type _type;
+  std::vector<Activity::ConstModelPtr> _models;
+  rmf_task::State _invariant_finish_state;
+  rmf_traffic::Duration _invariant_duration;
+};
 } // anonymous namespace
 
 //==============================================================================
@@ -69,6 +234,18 @@ Event::StandbyPtr Bundle::initiate(
       std::move(parent_update));
   }
 
+  if (description.type() == Bundle::Type::ParallelAll
+    || description.type() == Bundle::Type::ParallelAny)
+  {
+    return internal::Parallel::Standby::initiate(
+      initializer,
+      id,
+      get_state,
+      parameters,
+      description,
+      std::move(parent_update));
+  }
+
   // *INDENT-OFF*
   throw std::runtime_error(
     "[rmf_task_sequence::events::Bundle::initiate] "
@@ -84,7 +261,7 @@ Event::ActivePtr Bundle::restore(
   const std::function<rmf_task::State()>& get_state,
   const ConstParametersPtr& parameters,
   const Bundle::Description& description,
-  const std::string& backup,
+  const nlohmann::json& backup,
   std::function<void()> parent_update,
   std::function<void()> checkpoint,
   std::function<void()> finished)
@@ -103,12 +280,73 @@ Event::ActivePtr Bundle::restore(
       finished);
   }
 
+  if (description.type() == Bundle::Type::ParallelAll
+    || description.type() == Bundle::Type::ParallelAny)
+  {
+    return internal::Parallel::Active::restore(
+      initializer,
+      id,
+      get_state,
+      parameters,
+      description,
+      backup,
+      std::move(parent_update),
+      std::move(checkpoint),
+      std::move(finished));
+  }
+
   // *INDENT-OFF*
   throw std::runtime_error(
     "Bundle type not yet implemented: " + std::to_string(description.type()));
   // *INDENT-ON*
 }
 
+//==============================================================================
+Event::StandbyPtr Bundle::initiate(
+  const Event::ConstInitializerPtr& initializer,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  std::function<void()> update)
+{
+  // Sequences can defer their later elements because the initializer can be
+  // kept alive until those elements are reached
+  if (description.type() == Bundle::Type::Sequence)
+  {
+    return internal::Sequence::Standby::initiate(
+      initializer, id, get_state, parameters, description, std::move(update));
+  }
+
+  return initiate(
+    *initializer, id, get_state, parameters, description, std::move(update));
+}
+
+//==============================================================================
+Event::ActivePtr Bundle::restore(
+  const Event::ConstInitializerPtr& initializer,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  const nlohmann::json& backup,
+  std::function<void()> update,
+  std::function<void()> checkpoint,
+  std::function<void()> finished)
+{
+  if (description.type() == Bundle::Type::Sequence)
+  {
+    return internal::Sequence::Active::restore(
+      *initializer, id, get_state, parameters, description, backup,
+      std::move(update), std::move(checkpoint), std::move(finished),
+      initializer);
+  }
+
+  return restore(
+    *initializer, id, get_state, parameters, description, backup,
+    std::move(update), std::move(checkpoint), std::move(finished));
+}
+
 //==============================================================================
 class Bundle::Description::Implementation
 {
@@ -128,11 +366,10 @@ public:
     {
       case Type::Sequence:
         return "Sequence";
-        // TODO(MXG): Bring back this code when we want to support other types
-//      case Type::ParallelAll:
-//        return "All of";
-//      case Type::ParallelAny:
-//        return "One of";
+      case Type::ParallelAll:
+        return "All of";
+      case Type::ParallelAny:
+        return "One of";
     }
 
     return "<?Undefined Bundle?>";
@@ -142,19 +379,11 @@ public:
     std::optional<rmf_traffic::Duration> current_estimate,
     rmf_traffic::Duration next_dependency_estimate) const
   {
-    // TODO(MXG): Bring back this code when we want to support other types
-//    if (current_estimate.has_value())
-//    {
-//      if (Type::ParallelAll == type)
-//        return std::max(*current_estimate, next_dependency_estimate);
-//      else if (Type::ParallelAny == type)
-//        return std::min(*current_estimate, next_dependency_estimate);
-//    }
-//    else
-//    {
-//      if (Type::ParallelAll == type || Type::ParallelAny == type)
-//        return next_dependency_estimate;
-//    }
+    if (Type::ParallelAll == type || Type::ParallelAny == type)
+    {
+      return internal::Parallel::combine(
+        type, current_estimate, next_dependency_estimate);
+    }
 
     return current_estimate.value_or(rmf_traffic::Duration(0))
       + next_dependency_estimate;
@@ -164,43 +393,58 @@ public:
     rmf_task::State initial_state,
     const Parameters& parameters) const
   {
-    std::optional<std::vector<nlohmann::json>> detail_json;
+    // The headers of the elements are only folded into the detail of the
+    // bundle if that detail is read
+    std::vector<Header> element_headers;
     if (!detail.has_value())
-      detail_json = std::vector<nlohmann::json>();
+      element_headers.reserve(dependencies.size());
 
     std::optional<rmf_traffic::Duration> duration_estimate;
 
     for (const auto& element : dependencies)
     {
-      const auto element_header =
+      auto element_header =
         element->generate_header(initial_state, parameters);
 
       duration_estimate = adjust_estimate(
         duration_estimate, element_header.original_duration_estimate());
 
-      auto model = element->make_model(initial_state, parameters);
-      if (model)
-        initial_state = model->invariant_finish_state();
-
-      if (detail_json.has_value())
+      // The dependencies of a parallel bundle all start from the same state.
+      // The models come from the same memo that make_model() uses, so they
+      // are only computed once.
+      if (type == Type::Sequence)
       {
-        nlohmann::json element_output;
-        element_output["category"] = element_header.category();
-        element_output["detail"] = convert_to_json(element_header.detail());
-        detail_json->emplace_back(std::move(element_output));
+        auto model = Activity::ModelCache::make_model(
+          *element, initial_state, parameters);
+        if (model)
+          initial_state = model->invariant_finish_state();
       }
+
+      if (!detail.has_value())
+        element_headers.push_back(std::move(element_header));
     }
 
-    std::string output_detail;
+    const auto duration = duration_estimate.value_or(rmf_traffic::Duration(0));
     if (detail.has_value())
-      output_detail = *detail;
-    else
-      output_detail = nlohmann::json(*detail_json).dump();
+      return Header(generate_category(), *detail, duration);
 
     return Header(
       generate_category(),
-      std::move(output_detail),
-      duration_estimate.value_or(rmf_traffic::Duration(0)));
+      [element_headers = std::move(element_headers)]()
+      {
+        std::vector<nlohmann::json> detail_json;
+        detail_json.reserve(element_headers.size());
+        for (const auto& element_header : element_headers)
+        {
+          nlohmann::json element_output;
+          element_output["category"] = element_header.category();
+          element_output["detail"] = convert_to_json(element_header);
+          detail_json.emplace_back(std::move(element_output));
+        }
+
+        return nlohmann::json(std::move(detail_json)).dump();
+      },
+      duration).detail_is_json(true);
   }
 };
 
@@ -281,6 +525,15 @@ Activity::ConstModelPtr Bundle::Description::make_model(
   rmf_task::State invariant_initial_state,
   const Parameters& parameters) const
 {
+  if (_pimpl->type == Type::ParallelAll || _pimpl->type == Type::ParallelAny)
+  {
+    return ParallelModel::make(
+      _pimpl->type,
+      _pimpl->dependencies,
+      std::move(invariant_initial_state),
+      parameters);
+  }
+
   return Activity::SequenceModel::make(
     _pimpl->dependencies,
     std::move(invariant_initial_state),
@@ -295,6 +548,19 @@ Header Bundle::Description::generate_header(
   return _pimpl->generate_header(initial_state, parameters);
 }
 
+//==============================================================================
+std::optional<std::string> Bundle::Description::model_key() const
+{
+  auto key = Activity::SequenceModel::model_key(_pimpl->dependencies);
+  if (!key.has_value() || _pimpl->type == Type::Sequence)
+    return key;
+
+  // Parallel bundles of the same dependencies have different models
+  const std::string prefix =
+    _pimpl->type == Type::ParallelAll ? "ParallelAll|" : "ParallelAny|";
+  return prefix + *key;
+}
+
 //==============================================================================
 void Bundle::add(const Event::InitializerPtr& initializer)
 {
@@ -318,7 +584,7 @@ void Bundle::add(const Event::InitializerPtr& initializer)
       }
 
       return initiate(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -347,7 +613,7 @@ void Bundle::add(const Event::InitializerPtr& initializer)
       }
 
       return restore(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -373,7 +639,7 @@ void Bundle::add(
       std::function<void()> update)
     {
       return initiate(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -391,7 +657,7 @@ void Bundle::add(
       std::function<void()> finished)
     {
       return restore(
-        *initialize_from,
+        initialize_from,
         id,
         get_state,
         parameters,
@@ -420,6 +686,15 @@ Event::StandbyPtr Bundle::standby(
     return sequence;
   }
 
+  if (type == Bundle::Type::ParallelAll || type == Bundle::Type::ParallelAny)
+  {
+    return internal::Parallel::Standby::initiate(
+      type,
+      dependencies,
+      std::move(state),
+      std::move(update));
+  }
+
   // *INDENT-OFF*
   throw std::runtime_error(
     "[rmf_task_sequence::events::Bundle::activate] "
@@ -122,6 +122,12 @@ Header DropOff::Description::generate_header(
     .generate_header("Drop off", initial_state, parameters);
 }
 
+//==============================================================================
+std::optional<std::string> DropOff::Description::model_key() const
+{
+  return _pimpl->transfer.model_key();
+}
+
 //==============================================================================
 DropOff::Description::Description()
 {
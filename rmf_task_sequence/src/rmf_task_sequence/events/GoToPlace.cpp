@@ -19,27 +19,54 @@
 
 #include "utils.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace rmf_task_sequence {
 namespace events {
 
 namespace {
 //==============================================================================
-std::optional<rmf_traffic::Duration> estimate_duration(
-  const std::shared_ptr<const rmf_traffic::agv::Planner>& planner,
+std::vector<std::optional<rmf_traffic::Duration>> estimate_durations(
+  const Parameters& parameters,
   const State& initial_state,
-  const GoToPlace::Goal& goal)
+  const std::vector<GoToPlace::Goal>& goals)
 {
-  const auto result =
-    planner->setup(initial_state.project_plan_start().value(), goal);
+  const auto start = initial_state.project_plan_start().value();
+  std::vector<std::optional<rmf_traffic::Duration>> durations;
+  durations.reserve(goals.size());
+
+  // A shared travel estimator remembers the trips that were already planned,
+  // so prefer it over a fresh query to the planner. Asking for all the goals
+  // at once lets it look them up as one batch.
+  if (const auto& estimator = parameters.travel_estimator())
+  {
+    for (const auto& estimate : estimator->estimate(start, goals))
+    {
+      if (estimate.has_value())
+        durations.push_back(estimate->duration());
+      else
+        durations.push_back(std::nullopt);
+    }
 
-  // TODO(MXG): Perhaps print errors/warnings about these failure conditions
-  if (result.disconnected())
-    return std::nullopt;
+    return durations;
+  }
 
-  if (!result.ideal_cost().has_value())
-    return std::nullopt;
+  for (const auto& goal : goals)
+  {
+    const auto result = parameters.planner()->setup(start, goal);
 
-  return rmf_traffic::time::from_seconds(*result.ideal_cost());
+    // TODO(MXG): Perhaps print errors/warnings about these failure conditions
+    if (result.disconnected() || !result.ideal_cost().has_value())
+    {
+      durations.push_back(std::nullopt);
+      continue;
+    }
+
+    durations.push_back(rmf_traffic::time::from_seconds(*result.ideal_cost()));
+  }
+
+  return durations;
 }
 } // anonymous namespace
 
@@ -68,14 +95,35 @@ public:
 
 private:
 
+  struct Candidate
+  {
+    Goal goal;
+    Eigen::Vector2d location;
+    std::string map;
+  };
+
   Model(
     State invariant_finish_state,
     rmf_traffic::Duration invariant_duration,
-    Goal goal);
+    Goal goal,
+    std::vector<Candidate> candidates,
+    std::weak_ptr<const rmf_traffic::agv::Planner> planner,
+    double max_speed);
+
+  /// Pick the goal with the shortest travel from the plan start.
+  std::optional<std::pair<Goal, TravelEstimator::Result>> _best_goal(
+    const rmf_traffic::agv::Plan::Start& start,
+    const TravelEstimator& estimator) const;
 
   State _invariant_finish_state;
   rmf_traffic::Duration _invariant_duration;
   Goal _goal;
+
+  // Every goal that the model may choose from, along with its location and map
+  // on the graph. This stays empty when there is only one goal to choose from.
+  std::vector<Candidate> _candidates;
+  std::weak_ptr<const rmf_traffic::agv::Planner> _planner;
+  double _max_speed;
 };
 
 //==============================================================================
@@ -95,22 +143,20 @@ Activity::ConstModelPtr GoToPlace::Model::make(
   std::optional<rmf_traffic::Duration> shortest_travel_time = std::nullopt;
   if (invariant_initial_state.waypoint().has_value())
   {
-    for (const auto& goal: goals)
+    // Goals that cannot be reached are never selected
+    const auto durations =
+      estimate_durations(parameters, invariant_initial_state, goals);
+    for (std::size_t i = 0; i < goals.size(); ++i)
     {
-      const auto invariant_duration_opt = estimate_duration(
-        parameters.planner(),
-        invariant_initial_state,
-        goal);
+      const auto& duration = durations[i];
+      if (!duration.has_value())
+        continue;
 
-      if (!shortest_travel_time.has_value())
+      if (!shortest_travel_time.has_value()
+        || *duration < *shortest_travel_time)
       {
-        shortest_travel_time = invariant_duration_opt;
-        selected_goal = goal;
-      }
-      else if (shortest_travel_time.value() > invariant_duration_opt.value())
-      {
-        shortest_travel_time = invariant_duration_opt;
-        selected_goal = goal;
+        shortest_travel_time = duration;
+        selected_goal = goals[i];
       }
     }
 
@@ -125,11 +171,32 @@ Activity::ConstModelPtr GoToPlace::Model::make(
   else
     invariant_finish_state.erase<State::CurrentOrientation>();
 
+  // No distance over the graph can be travelled faster than the nominal
+  // speed, so the straight line distance to each goal gives a cheap lower
+  // bound on its travel time.
+  const auto& config = parameters.planner()->get_configuration();
+  const double max_speed = config.vehicle_traits().linear()
+    .get_nominal_velocity();
+  std::vector<Candidate> candidates;
+  if (goals.size() > 1 && max_speed > 0.0)
+  {
+    candidates.reserve(goals.size());
+    for (const auto& goal : goals)
+    {
+      const auto& wp = config.graph().get_waypoint(goal.waypoint());
+      candidates.push_back(
+        Candidate{goal, wp.get_location(), wp.get_map_name()});
+    }
+  }
+
   return std::shared_ptr<Model>(
     new Model(
       std::move(invariant_finish_state),
       shortest_travel_time.value_or(rmf_traffic::Duration(0)),
-      std::move(selected_goal)));
+      std::move(selected_goal),
+      std::move(candidates),
+      parameters.planner(),
+      max_speed));
 }
 
 //==============================================================================
@@ -139,28 +206,33 @@ std::optional<Estimate> GoToPlace::Model::estimate_finish(
   const Constraints& constraints,
   const TravelEstimator& travel_estimator) const
 {
-  auto finish = initial_state;
-  finish.waypoint(_goal.waypoint());
+  const auto best = _best_goal(
+    initial_state.extract_plan_start().value(), travel_estimator);
 
-  const auto travel = travel_estimator.estimate(
-    initial_state.extract_plan_start().value(),
-    _goal);
-
-  if (!travel.has_value())
+  if (!best.has_value())
     return std::nullopt;
 
+  const auto& [goal, travel] = *best;
+
+  auto finish = initial_state;
+  finish.waypoint(goal.waypoint());
+  if (goal.orientation())
+    finish.orientation(*goal.orientation());
+  else
+    finish.erase<State::CurrentOrientation>();
+
   const auto arrival_time =
     std::max(
-    initial_state.time().value() + travel->duration(),
+    initial_state.time().value() + travel.duration(),
     earliest_arrival_time);
 
-  const auto wait_until_time = arrival_time - travel->duration();
-  finish.time(wait_until_time + travel->duration());
+  const auto wait_until_time = arrival_time - travel.duration();
+  finish.time(wait_until_time + travel.duration());
 
   if (constraints.drain_battery())
   {
     const auto new_battery_soc =
-      finish.battery_soc().value() - travel->change_in_charge();
+      finish.battery_soc().value() - travel.change_in_charge();
     if (new_battery_soc < 0.0)
     {
       return std::nullopt;
@@ -176,6 +248,66 @@ std::optional<Estimate> GoToPlace::Model::estimate_finish(
   return Estimate(finish, wait_until_time);
 }
 
+//==============================================================================
+auto GoToPlace::Model::_best_goal(
+  const rmf_traffic::agv::Plan::Start& start,
+  const TravelEstimator& estimator) const
+-> std::optional<std::pair<Goal, TravelEstimator::Result>>
+{
+  const auto planner = _planner.lock();
+  if (_candidates.empty() || !planner)
+  {
+    auto travel = estimator.estimate(start, _goal);
+    if (!travel.has_value())
+      return std::nullopt;
+
+    return std::make_pair(_goal, std::move(*travel));
+  }
+
+  const auto& start_wp =
+    planner->get_configuration().graph().get_waypoint(start.waypoint());
+  const auto& start_map = start_wp.get_map_name();
+  Eigen::Vector2d p = start.location().value_or(start_wp.get_location());
+
+  // Visit the goals in order of their lower bound, and stop once no remaining
+  // goal could beat the best travel estimate that has been found so far.
+  // Coordinates of different maps cannot be compared, so goals on another map
+  // than the start get no bound besides zero.
+  std::vector<std::pair<rmf_traffic::Duration, std::size_t>> shortlist;
+  shortlist.reserve(_candidates.size());
+  for (std::size_t i = 0; i < _candidates.size(); ++i)
+  {
+    const auto& candidate = _candidates[i];
+    if (candidate.map != start_map)
+    {
+      shortlist.emplace_back(rmf_traffic::Duration(0), i);
+      continue;
+    }
+
+    const double distance = (candidate.location - p).norm();
+    shortlist.emplace_back(
+      rmf_traffic::time::from_seconds(distance / _max_speed), i);
+  }
+  std::sort(shortlist.begin(), shortlist.end());
+
+  std::optional<std::pair<Goal, TravelEstimator::Result>> best;
+  for (const auto& [bound, i] : shortlist)
+  {
+    if (best.has_value() && best->second.duration() <= bound)
+      break;
+
+    const auto& goal = _candidates[i].goal;
+    auto travel = estimator.estimate(start, goal);
+    if (!travel.has_value())
+      continue;
+
+    if (!best.has_value() || travel->duration() < best->second.duration())
+      best = std::make_pair(goal, std::move(*travel));
+  }
+
+  return best;
+}
+
 //==============================================================================
 rmf_traffic::Duration GoToPlace::Model::invariant_duration() const
 {
@@ -192,10 +324,16 @@ State GoToPlace::Model::invariant_finish_state() const
 GoToPlace::Model::Model(
   State invariant_finish_state,
   rmf_traffic::Duration invariant_duration,
-  Goal goal)
+  Goal goal,
+  std::vector<Candidate> candidates,
+  std::weak_ptr<const rmf_traffic::agv::Planner> planner,
+  double max_speed)
 : _invariant_finish_state(std::move(invariant_finish_state)),
   _invariant_duration(invariant_duration),
-  _goal(std::move(goal))
+  _goal(std::move(goal)),
+  _candidates(std::move(candidates)),
+  _planner(std::move(planner)),
+  _max_speed(max_speed)
 {
   // Do nothing
 }
@@ -287,12 +425,8 @@ Header GoToPlace::Description::generate_header(
 
   const auto start_name = rmf_task::standard_waypoint_name(graph, start_wp);
 
-  std::optional<rmf_traffic::Duration> estimate = std::nullopt;
-  std::size_t selected_index = 0;
-  for (std::size_t i = 0; i < _pimpl->one_of.size(); i ++)
+  for (const auto& dest : _pimpl->one_of)
   {
-    auto dest = _pimpl->one_of[i];
-
     if (graph.num_waypoints() <= dest.waypoint())
     {
       utils::fail(fail_header, "Destination waypoint ["
@@ -300,28 +434,29 @@ Header GoToPlace::Description::generate_header(
         + "] is outside the graph [" + std::to_string(graph.num_waypoints())
         + "]");
     }
+  }
 
-    if (estimate.has_value())
-    {
-      auto curr_est = estimate_duration(
-        parameters.planner(), initial_state, dest);
-      if (curr_est.has_value() && curr_est.value() < estimate)
-      {
-        estimate = curr_est;
-        selected_index = i;
-      }
-    }
-    else
+  const auto durations =
+    estimate_durations(parameters, initial_state, _pimpl->one_of);
+
+  std::optional<rmf_traffic::Duration> estimate = std::nullopt;
+  std::size_t selected_index = 0;
+  for (std::size_t i = 0; i < durations.size(); ++i)
+  {
+    const auto& duration = durations[i];
+    if (!duration.has_value())
+      continue;
+
+    if (!estimate.has_value() || *duration < *estimate)
     {
-      estimate = estimate_duration(
-        parameters.planner(), initial_state, dest);
+      estimate = duration;
       selected_index = i;
     }
   }
 
   if (!estimate.has_value())
   {
-    Header(
+    return Header(
       "Go to one of [" + destination_name(parameters) + "]",
       "Waiting for path to open up",
       rmf_traffic::Duration(0));
@@ -343,6 +478,26 @@ Header GoToPlace::Description::generate_header(
     *estimate);
 }
 
+//==============================================================================
+std::optional<std::string> GoToPlace::Description::model_key() const
+{
+  // The model only depends on the goals and the map preference
+  std::string key =
+    _pimpl->prefer_same_map ? "GoToPlace|same_map" : "GoToPlace|";
+  for (const auto& goal : _pimpl->one_of)
+  {
+    key += "|" + std::to_string(goal.waypoint());
+    if (const auto* orientation = goal.orientation())
+    {
+      uint64_t bits;
+      std::memcpy(&bits, orientation, sizeof(bits));
+      key += "@" + std::to_string(bits);
+    }
+  }
+
+  return key;
+}
+
 //==============================================================================
 auto GoToPlace::Description::destination() const -> const Goal&
 {
@@ -0,0 +1,615 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_Parallel.hpp"
+#include "internal_Sequence.hpp"
+#include "../schemas/internal_TrustedBackup.hpp"
+
+#include <algorithm>
+
+namespace rmf_task_sequence {
+namespace events {
+namespace internal {
+
+namespace {
+//==============================================================================
+// Only the statuses of finished events need names, since only the branch that
+// won a ParallelAny bundle is backed up after it has finished.
+const std::vector<std::pair<Event::Status, std::string>> FinishedStatusNames =
+{
+  {Event::Status::Completed, "completed"},
+  {Event::Status::Skipped, "skipped"},
+  {Event::Status::Canceled, "canceled"},
+  {Event::Status::Killed, "killed"}
+};
+
+//==============================================================================
+std::optional<std::string> finished_status_name(Event::Status status)
+{
+  for (const auto& [value, name] : FinishedStatusNames)
+  {
+    if (value == status)
+      return name;
+  }
+
+  return std::nullopt;
+}
+
+//==============================================================================
+std::optional<Event::Status> finished_status_from_name(const std::string& name)
+{
+  for (const auto& [value, value_name] : FinishedStatusNames)
+  {
+    if (value_name == name)
+      return value;
+  }
+
+  return std::nullopt;
+}
+} // anonymous namespace
+
+//==============================================================================
+rmf_traffic::Duration Parallel::combine(
+  Bundle::Type type,
+  std::optional<rmf_traffic::Duration> current,
+  rmf_traffic::Duration next)
+{
+  if (!current.has_value())
+    return next;
+
+  if (type == Bundle::Type::ParallelAny)
+    return std::min(*current, next);
+
+  return std::max(*current, next);
+}
+
+//==============================================================================
+void Parallel::update_status(
+  Bundle::Type type,
+  rmf_task::events::SimpleEventState& state)
+{
+  if (state.status() == Event::Status::Canceled
+    || state.status() == Event::Status::Killed
+    || state.status() == Event::Status::Skipped)
+    return;
+
+  // A ParallelAny bundle is complete as soon as any of its branches completes,
+  // even while the remaining branches are still wrapping up their
+  // cancellation.
+  if (type == Bundle::Type::ParallelAny)
+  {
+    for (const auto& dep : state.current_dependencies())
+    {
+      if (dep->status() == Event::Status::Completed)
+      {
+        state.update_status(Event::Status::Completed);
+        return;
+      }
+    }
+  }
+
+  // Finished branches pass along the status of the branches that are still
+  // running, and any branch that needs attention raises it for the bundle.
+  Event::Status status = Event::Status::Completed;
+  for (const auto& dep : state.current_dependencies())
+    status = Event::sequence_status(status, dep->status());
+
+  state.update_status(status);
+}
+
+//==============================================================================
+Event::StandbyPtr Parallel::Standby::initiate(
+  const Event::Initializer& initializer,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  std::function<void()> parent_update)
+{
+  const auto type = description.type();
+  auto state = make_state(id, description);
+  const auto update =
+    [parent_update, state, type]()
+    {
+      update_status(type, *state);
+      parent_update();
+    };
+
+  std::vector<Event::StandbyPtr> dependencies;
+  dependencies.reserve(description.dependencies().size());
+  for (const auto& desc : description.dependencies())
+  {
+    dependencies.emplace_back(
+      initializer.initialize(id, get_state, parameters, *desc, update));
+  }
+
+  return std::make_shared<Parallel::Standby>(
+    type, std::move(dependencies), std::move(state),
+    std::move(parent_update));
+}
+
+//==============================================================================
+Event::StandbyPtr Parallel::Standby::initiate(
+  Bundle::Type type,
+  const std::vector<MakeStandby>& dependencies_fn,
+  rmf_task::events::SimpleEventStatePtr state,
+  std::function<void()> parent_update)
+{
+  const auto update =
+    [parent_update, state, type]()
+    {
+      update_status(type, *state);
+      parent_update();
+    };
+
+  std::vector<Event::StandbyPtr> dependencies;
+  dependencies.reserve(dependencies_fn.size());
+  for (const auto& fn : dependencies_fn)
+    dependencies.push_back(fn(update));
+
+  return std::make_shared<Parallel::Standby>(
+    type, std::move(dependencies), std::move(state),
+    std::move(parent_update));
+}
+
+//==============================================================================
+Event::ConstStatePtr Parallel::Standby::state() const
+{
+  return _state;
+}
+
+//==============================================================================
+rmf_traffic::Duration Parallel::Standby::duration_estimate() const
+{
+  std::optional<rmf_traffic::Duration> estimate;
+  for (const auto& element : _dependencies)
+    estimate = combine(_type, estimate, element->duration_estimate());
+
+  return estimate.value_or(rmf_traffic::Duration(0));
+}
+
+//==============================================================================
+Parallel::Standby::Standby(
+  Bundle::Type type,
+  std::vector<Event::StandbyPtr> dependencies,
+  rmf_task::events::SimpleEventStatePtr state,
+  std::function<void()> parent_update)
+: _type(type),
+  _dependencies(std::move(dependencies)),
+  _state(std::move(state)),
+  _parent_update(std::move(parent_update))
+{
+  std::vector<rmf_task::Event::ConstStatePtr> state_deps;
+  state_deps.reserve(_dependencies.size());
+  for (const auto& dep : _dependencies)
+    state_deps.push_back(dep->state());
+
+  _state->update_dependencies(std::move(state_deps));
+  update_status(_type, *_state);
+}
+
+//==============================================================================
+Event::ActivePtr Parallel::Standby::begin(
+  std::function<void()> checkpoint,
+  std::function<void()> finish)
+{
+  if (_active)
+    return _active;
+
+  _active = std::make_shared<Parallel::Active>(
+    _type, _state, _parent_update, std::move(checkpoint), std::move(finish));
+
+  std::vector<std::pair<uint64_t, Event::StandbyPtr>> branches;
+  branches.reserve(_dependencies.size());
+  for (std::size_t i = 0; i < _dependencies.size(); ++i)
+    branches.emplace_back(i, std::move(_dependencies[i]));
+
+  _dependencies.clear();
+  _active->begin(std::move(branches));
+  return _active;
+}
+
+//==============================================================================
+rmf_task::events::SimpleEventStatePtr Parallel::Standby::make_state(
+  const Event::AssignIDPtr& id,
+  const Bundle::Description& description)
+{
+  const char* default_category =
+    description.type() == Bundle::Type::ParallelAny ? "One of" : "All of";
+
+  return rmf_task::events::SimpleEventState::make(
+    id->assign(),
+    description.category().value_or(default_category),
+    description.detail().value_or(""),
+    rmf_task::Event::Status::Standby);
+}
+
+//==============================================================================
+Event::ActivePtr Parallel::Active::restore(
+  const Event::Initializer& initializer,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  const nlohmann::json& backup,
+  std::function<void()> parent_update,
+  std::function<void()> checkpoint,
+  std::function<void()> finished)
+{
+  const auto type = description.type();
+  auto state = Parallel::Standby::make_state(id, description);
+  const auto update =
+    [parent_update, state, type]()
+    {
+      update_status(type, *state);
+      parent_update();
+    };
+
+  // The backup of a bundle is normally nested inside the backup of its
+  // parent, but it may also arrive as a serialized string
+  const nlohmann::json parsed_backup =
+    backup.is_string() ?
+    nlohmann::json::parse(backup.get_ref<const std::string&>()) :
+    nlohmann::json();
+  const auto& backup_state = backup.is_string() ? parsed_backup : backup;
+
+  // There is no need to validate a part of a backup that is already trusted
+  const auto result = schemas::TrustedBackup::Scope::active() ?
+    std::nullopt :
+    schemas::ErrorHandler::has_error(
+      schemas::backup_EventParallel_v0_1_validator(), backup_state);
+  if (result)
+  {
+    state->update_log().error(
+      "Parsing failed while restoring backup: " + result->message
+      + "\nOriginal backup state:\n```" + backup_state.dump() + "\n```");
+    state->update_status(Event::Status::Error);
+    return std::make_shared<Parallel::Active>(
+      type, std::move(state), nullptr, nullptr, nullptr);
+  }
+
+  const auto& element_descriptions = description.dependencies();
+  std::optional<uint64_t> winner;
+  std::optional<Event::Status> winner_status;
+  if (backup_state.contains("winner"))
+  {
+    const auto& winner_json = backup_state["winner"];
+    winner = winner_json["index"].get<uint64_t>();
+    winner_status = finished_status_from_name(
+      winner_json["status"].get<std::string>());
+    if (element_descriptions.size() <= *winner || !winner_status.has_value())
+    {
+      state->update_log().error(
+        "Failed to restore backup. The winner [" + winner_json.dump()
+        + "] does not match the [" + std::to_string(element_descriptions.size())
+        + "] event dependencies. Original text:\n```\n" + backup_state.dump()
+        + "\n```");
+      state->update_status(Event::Status::Error);
+      return std::make_shared<Parallel::Active>(
+        type, std::move(state), nullptr, nullptr, nullptr);
+    }
+  }
+
+  for (const auto& event_json : backup_state["active_events"])
+  {
+    const auto index = event_json["index"].get<uint64_t>();
+    if (element_descriptions.size() <= index)
+    {
+      state->update_log().error(
+        "Failed to restore backup. Index [" + std::to_string(index)
+        + "] is too high for [" + std::to_string(element_descriptions.size())
+        + "] event dependencies. Original text:\n```\n" + backup_state.dump()
+        + "\n```");
+      state->update_status(Event::Status::Error);
+      return std::make_shared<Parallel::Active>(
+        type, std::move(state), nullptr, nullptr, nullptr);
+    }
+  }
+
+  auto active = std::make_shared<Parallel::Active>(
+    type,
+    state,
+    std::move(parent_update),
+    checkpoint,
+    std::move(finished));
+
+  if (winner.has_value())
+  {
+    // The winner already finished, so it only needs a state that tells the
+    // bundle how it finished
+    const auto winner_state = initializer.initialize(
+      id, get_state, parameters, *element_descriptions.at(*winner),
+      []() {})->state();
+    rmf_task::VersionedString::Reader reader;
+    const auto name = reader.read(winner_state->name());
+    const auto detail = reader.read(winner_state->detail());
+    state->add_dependency(
+      rmf_task::events::SimpleEventState::make(
+        winner_state->id(),
+        name ? *name : "",
+        detail ? *detail : "",
+        *winner_status));
+
+    active->_winner = winner;
+  }
+
+  bool any_finished = winner.has_value();
+  {
+    BoolGuard guard(active->_beginning);
+    for (const auto& event_json : backup_state["active_events"])
+    {
+      const auto index = event_json["index"].get<uint64_t>();
+      auto restored = initializer.restore(
+        id,
+        get_state,
+        parameters,
+        *element_descriptions.at(index),
+        event_json["state"],
+        update,
+        checkpoint,
+        active->_branch_finished());
+
+      any_finished = any_finished || restored->state()->finished();
+      state->add_dependency(restored->state());
+      active->_branches.push_back(Branch{index, std::move(restored)});
+    }
+  }
+
+  // Bundles whose branches are all still running are resumed quietly, just
+  // like a restored sequence.
+  if (any_finished || active->_branches.empty())
+    active->check_finished();
+  else
+    update_status(type, *state);
+
+  return active;
+}
+
+//==============================================================================
+Event::ConstStatePtr Parallel::Active::state() const
+{
+  return _state;
+}
+
+//==============================================================================
+rmf_traffic::Duration Parallel::Active::remaining_time_estimate() const
+{
+  std::optional<rmf_traffic::Duration> estimate;
+  for (const auto& branch : _branches)
+  {
+    if (branch.active->state()->finished())
+      continue;
+
+    estimate = combine(
+      _type, estimate, branch.active->remaining_time_estimate());
+  }
+
+  return estimate.value_or(rmf_traffic::Duration(0));
+}
+
+//==============================================================================
+Event::Active::Backup Parallel::Active::backup() const
+{
+  auto active_events = nlohmann::json::array();
+  for (const auto& branch : _branches)
+  {
+    if (branch.active->state()->finished())
+      continue;
+
+    nlohmann::json event_json;
+    event_json["index"] = branch.index;
+    event_json["state"] = branch.active->backup().release_state();
+    active_events.push_back(std::move(event_json));
+  }
+
+  nlohmann::json backup_json;
+  backup_json["schema_version"] = "0.1";
+  backup_json["active_events"] = std::move(active_events);
+
+  // The other branches of a ParallelAny bundle may still be wrapping up their
+  // cancellation, so remember which branch won and how it finished
+  if (_winner.has_value())
+  {
+    for (const auto& branch : _branches)
+    {
+      if (branch.index != *_winner)
+        continue;
+
+      const auto status =
+        finished_status_name(branch.active->state()->status());
+      if (status.has_value())
+        backup_json["winner"] = {{"index", *_winner}, {"status", *status}};
+    }
+  }
+
+  return Backup::make(_next_backup_sequence_number++, std::move(backup_json));
+}
+
+//==============================================================================
+Event::Active::Resume Parallel::Active::interrupt(
+  std::function<void()> task_is_interrupted)
+{
+  // The bundle is only interrupted once every running branch is
+  auto remaining = std::make_shared<std::size_t>(0);
+  for (const auto& branch : _branches)
+  {
+    if (!branch.active->state()->finished())
+      ++(*remaining);
+  }
+
+  if (*remaining == 0)
+  {
+    task_is_interrupted();
+    return Resume::make([]() {});
+  }
+
+  const auto interrupted =
+    [remaining, task_is_interrupted = std::move(task_is_interrupted)]()
+    {
+      if (*remaining > 0 && --(*remaining) == 0)
+        task_is_interrupted();
+    };
+
+  auto resumes = std::make_shared<std::vector<Resume>>();
+  for (const auto& branch : _branches)
+  {
+    if (branch.active->state()->finished())
+      continue;
+
+    resumes->push_back(branch.active->interrupt(interrupted));
+  }
+
+  return Resume::make(
+    [resumes]()
+    {
+      for (const auto& resume : *resumes)
+        resume();
+    });
+}
+
+//==============================================================================
+void Parallel::Active::cancel()
+{
+  _state->update_status(Event::Status::Canceled);
+  {
+    BoolGuard guard(_beginning);
+    for (const auto& branch : _branches)
+    {
+      if (!branch.active->state()->finished())
+        branch.active->cancel();
+    }
+  }
+
+  check_finished();
+}
+
+//==============================================================================
+void Parallel::Active::kill()
+{
+  _state->update_status(Event::Status::Killed);
+  {
+    BoolGuard guard(_beginning);
+    for (const auto& branch : _branches)
+    {
+      if (!branch.active->state()->finished())
+        branch.active->kill();
+    }
+  }
+
+  check_finished();
+}
+
+//==============================================================================
+Parallel::Active::Active(
+  Bundle::Type type,
+  rmf_task::events::SimpleEventStatePtr state,
+  std::function<void()> parent_update,
+  std::function<void()> checkpoint,
+  std::function<void()> finished)
+: _type(type),
+  _state(std::move(state)),
+  _parent_update(std::move(parent_update)),
+  _checkpoint(std::move(checkpoint)),
+  _bundle_finished(std::move(finished))
+{
+  // Do nothing
+}
+
+//==============================================================================
+void Parallel::Active::begin(
+  std::vector<std::pair<uint64_t, Event::StandbyPtr>> branches)
+{
+  {
+    BoolGuard guard(_beginning);
+    _branches.reserve(branches.size());
+    for (auto& [index, standby] : branches)
+    {
+      _branches.push_back(
+        Branch{index, standby->begin(_checkpoint, _branch_finished())});
+    }
+  }
+
+  check_finished();
+}
+
+//==============================================================================
+void Parallel::Active::check_finished()
+{
+  if (_beginning || _finished)
+    return;
+
+  {
+    const auto is_finished = [](const Branch& branch)
+      {
+        return branch.active->state()->finished();
+      };
+
+    BoolGuard guard(_beginning);
+    if (_type == Bundle::Type::ParallelAny && !_winner.has_value())
+    {
+      const auto first = std::find_if(
+        _branches.begin(), _branches.end(), is_finished);
+      if (first != _branches.end())
+        _winner = first->index;
+    }
+
+    if (_winner.has_value() && !_dismissed_others
+      && _state->status() != Event::Status::Canceled
+      && _state->status() != Event::Status::Killed)
+    {
+      // The first branch to finish decides the outcome, so the others are no
+      // longer needed.
+      _dismissed_others = true;
+      for (const auto& branch : _branches)
+      {
+        if (!is_finished(branch))
+          branch.active->cancel();
+      }
+    }
+
+    if (!std::all_of(_branches.begin(), _branches.end(), is_finished))
+    {
+      update_status(_type, *_state);
+      if (_parent_update)
+        _parent_update();
+
+      if (_checkpoint)
+        _checkpoint();
+
+      return;
+    }
+  }
+
+  _finished = true;
+  update_status(_type, *_state);
+  if (_bundle_finished)
+    _bundle_finished();
+}
+
+//==============================================================================
+std::function<void()> Parallel::Active::_branch_finished()
+{
+  return [me = weak_from_this()]()
+    {
+      if (const auto self = me.lock())
+        self->check_finished();
+    };
+}
+
+} // namespace internal
+} // namespace events
+} // namespace rmf_task_sequence
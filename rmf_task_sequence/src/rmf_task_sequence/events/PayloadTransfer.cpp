@@ -45,6 +45,12 @@ Activity::ConstModelPtr PayloadTransfer::make_model(
     parameters);
 }
 
+//==============================================================================
+std::optional<std::string> PayloadTransfer::model_key() const
+{
+  return Activity::SequenceModel::model_key(descriptions);
+}
+
 //==============================================================================
 Header PayloadTransfer::generate_header(
   const std::string& type,
@@ -53,10 +59,14 @@ Header PayloadTransfer::generate_header(
 {
   const auto model = make_model(initial_state, parameters);
 
+  // The brief of the payload is only put together if the detail is read
   return Header(
     type,
-    type + " " + payload.brief("into") + " at "
-    + go_to_place->destination_name(parameters),
+    [type, payload = payload,
+    destination = go_to_place->destination_name(parameters)]()
+    {
+      return type + " " + payload.brief("into") + " at " + destination;
+    },
     model->invariant_duration());
 }
 
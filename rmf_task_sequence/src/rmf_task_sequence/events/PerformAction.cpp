@@ -18,12 +18,13 @@
 #include <rmf_task_sequence/events/PerformAction.hpp>
 
 #include "utils.hpp"
+#include "../internal_Activity.hpp"
 
 namespace rmf_task_sequence {
 namespace events {
 
 //==============================================================================
-class PerformAction::Model : public Activity::Model
+class PerformAction::Model : public internal::InvariantModel
 {
 public:
 
@@ -31,6 +32,7 @@ public:
     rmf_task::State invariant_finish_state,
     rmf_traffic::Duration invariant_duration,
     bool use_tool_sink,
+    const std::string& category,
     const Parameters& parameters);
 
   std::optional<rmf_task::Estimate> estimate_finish(
@@ -43,10 +45,11 @@ public:
 
   State invariant_finish_state() const final;
 
+  const internal::InvariantOffset& offset() const final;
+
 private:
   rmf_task::State _invariant_finish_state;
-  double _invariant_battery_drain;
-  rmf_traffic::Duration _invariant_duration;
+  internal::InvariantOffset _offset;
   bool _use_tool_sink;
 };
 
@@ -55,23 +58,28 @@ PerformAction::Model::Model(
   rmf_task::State invariant_finish_state,
   rmf_traffic::Duration invariant_duration,
   bool use_tool_sink,
+  const std::string& category,
   const Parameters& parameters)
 : _invariant_finish_state(invariant_finish_state),
-  _invariant_duration(invariant_duration),
   _use_tool_sink(use_tool_sink)
 {
+  _offset.duration = invariant_duration;
+  _offset.waypoint = _invariant_finish_state.waypoint();
+  _offset.orientation = _invariant_finish_state.orientation();
+  _offset.calibration_type = category;
+
   if (parameters.ambient_sink() != nullptr)
   {
-    _invariant_battery_drain =
+    _offset.battery_drain =
       parameters.ambient_sink()->compute_change_in_charge(
-      rmf_traffic::time::to_seconds(_invariant_duration));
+      rmf_traffic::time::to_seconds(invariant_duration));
   }
 
   if (_use_tool_sink && parameters.tool_sink() != nullptr)
   {
-    _invariant_battery_drain +=
+    _offset.battery_drain +=
       parameters.tool_sink()->compute_change_in_charge(
-      rmf_traffic::time::to_seconds(_invariant_duration));
+      rmf_traffic::time::to_seconds(invariant_duration));
   }
 }
 
@@ -82,16 +90,28 @@ std::optional<rmf_task::Estimate> PerformAction::Model::estimate_finish(
   const Constraints& constraints,
   const TravelEstimator& travel_estimator) const
 {
-  initial_state.time(initial_state.time().value() + _invariant_duration);
-  if (_invariant_finish_state.waypoint().has_value())
-    initial_state.waypoint(_invariant_finish_state.waypoint().value());
-  if (_invariant_finish_state.orientation().has_value())
-    initial_state.orientation(_invariant_finish_state.orientation().value());
+  // Correct the duration of the action by how long it has actually been
+  // taking between the same waypoints
+  auto duration = _offset.duration;
+  const auto& calibration = travel_estimator.calibration();
+  const auto start = initial_state.waypoint();
+  if (calibration && start.has_value())
+  {
+    const double factor = calibration->factor(
+      *_offset.calibration_type, *start, _offset.waypoint.value_or(*start));
+    duration = std::chrono::duration_cast<rmf_traffic::Duration>(
+      duration * factor);
+  }
+
+  initial_state.time(initial_state.time().value() + duration);
+  if (_offset.waypoint.has_value())
+    initial_state.waypoint(*_offset.waypoint);
+  if (_offset.orientation.has_value())
+    initial_state.orientation(*_offset.orientation);
 
   if (constraints.drain_battery())
     initial_state.battery_soc(std::max(0.0,
-      initial_state.battery_soc().value() - _invariant_battery_drain));
-
+      initial_state.battery_soc().value() - _offset.battery_drain));
 
   if (initial_state.battery_soc().value() <= constraints.threshold_soc())
     return std::nullopt;
@@ -102,7 +122,7 @@ std::optional<rmf_task::Estimate> PerformAction::Model::estimate_finish(
 //==============================================================================
 rmf_traffic::Duration PerformAction::Model::invariant_duration() const
 {
-  return _invariant_duration;
+  return _offset.duration;
 }
 
 //==============================================================================
@@ -111,6 +131,12 @@ State PerformAction::Model::invariant_finish_state() const
   return _invariant_finish_state;
 }
 
+//==============================================================================
+const internal::InvariantOffset& PerformAction::Model::offset() const
+{
+  return _offset;
+}
+
 //==============================================================================
 class PerformAction::Description::Implementation
 {
@@ -244,6 +270,7 @@ Activity::ConstModelPtr PerformAction::Description::make_model(
     invariant_finish_state,
     _pimpl->action_duration_estimate,
     _pimpl->use_tool_sink,
+    _pimpl->category,
     parameters);
 }
 
@@ -120,6 +120,12 @@ Header PickUp::Description::generate_header(
   return _pimpl->transfer.generate_header("Pick up", initial_state, parameters);
 }
 
+//==============================================================================
+std::optional<std::string> PickUp::Description::model_key() const
+{
+  return _pimpl->transfer.model_key();
+}
+
 //==============================================================================
 PickUp::Description::Description()
 {
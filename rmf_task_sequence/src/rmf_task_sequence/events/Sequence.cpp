@@ -16,11 +16,56 @@
 */
 
 #include "internal_Sequence.hpp"
+#include "../schemas/internal_TrustedBackup.hpp"
 
 namespace rmf_task_sequence {
 namespace events {
 namespace internal {
 
+namespace {
+//==============================================================================
+// What the deferred elements of one sequence report until they begin. The
+// models of the elements are chained together from the initial state of the
+// sequence, and each element gets the header of its description at the state
+// that the models before it finish in.
+class ElementPreviews
+{
+public:
+
+  struct Preview
+  {
+    std::string name;
+    std::string detail;
+    rmf_traffic::Duration duration;
+  };
+
+  ElementPreviews(
+    const std::function<rmf_task::State()>& get_state,
+    const rmf_task::Parameters& parameters,
+    const Bundle::Description::Dependencies& descriptions)
+  {
+    auto state = get_state();
+    _previews.reserve(descriptions.size());
+    for (const auto& desc : descriptions)
+    {
+      const auto header = desc->generate_header(state, parameters);
+      const auto model = desc->make_model(state, parameters);
+      _previews.push_back(
+        {header.category(), header.detail(), model->invariant_duration()});
+      state = model->invariant_finish_state();
+    }
+  }
+
+  const Preview& get(std::size_t index) const
+  {
+    return _previews.at(index);
+  }
+
+private:
+  std::vector<Preview> _previews;
+};
+} // anonymous namespace
+
 //==============================================================================
 Event::StandbyPtr Sequence::Standby::initiate(
   const Event::Initializer& initializer,
@@ -38,19 +83,33 @@ Event::StandbyPtr Sequence::Standby::initiate(
       parent_update();
     };
 
-  std::vector<Event::StandbyPtr> dependencies;
-  dependencies.reserve(description.dependencies().size());
-  for (const auto& desc : description.dependencies())
-  {
-    auto element = initializer.initialize(
-      id, get_state, parameters, *desc, update);
+  auto dependencies = make_reverse_elements(
+    initializer, nullptr, id, get_state, parameters, description, 0, update);
 
-    dependencies.emplace_back(std::move(element));
-  }
+  return std::make_shared<Sequence::Standby>(
+    std::move(dependencies), std::move(state), std::move(parent_update));
+}
 
-  // We reverse the dependencies so we can always pop them off the back of the
-  // queue.
-  std::reverse(dependencies.begin(), dependencies.end());
+//==============================================================================
+Event::StandbyPtr Sequence::Standby::initiate(
+  const Event::ConstInitializerPtr& initializer,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  std::function<void()> parent_update)
+{
+  auto state = make_state(id, description);
+  const auto update =
+    [parent_update, state]()
+    {
+      update_status(*state);
+      parent_update();
+    };
+
+  auto dependencies = make_reverse_elements(
+    *initializer, initializer, id, get_state, parameters, description, 0,
+    update);
 
   return std::make_shared<Sequence::Standby>(
     std::move(dependencies), std::move(state), std::move(parent_update));
@@ -146,6 +205,68 @@ rmf_task::events::SimpleEventStatePtr Sequence::Standby::make_state(
     rmf_task::Event::Status::Standby);
 }
 
+//==============================================================================
+std::vector<Event::StandbyPtr> Sequence::Standby::make_reverse_elements(
+  const Event::Initializer& initializer,
+  const Event::ConstInitializerPtr& keep_alive,
+  const Event::AssignIDPtr& id,
+  const std::function<rmf_task::State()>& get_state,
+  const ConstParametersPtr& parameters,
+  const Bundle::Description& description,
+  const std::size_t first,
+  const std::function<void()>& update)
+{
+  const auto& descriptions = description.dependencies();
+  std::vector<Event::StandbyPtr> elements;
+  if (descriptions.size() <= first)
+    return elements;
+
+  elements.reserve(descriptions.size() - first);
+  std::shared_ptr<const ElementPreviews> previews;
+  for (std::size_t i = first; i < descriptions.size(); ++i)
+  {
+    const auto& desc = descriptions[i];
+    if (!keep_alive || i < first + EagerElements)
+    {
+      elements.push_back(
+        initializer.initialize(id, get_state, parameters, *desc, update));
+      continue;
+    }
+
+    if (!previews)
+    {
+      previews = std::make_shared<const ElementPreviews>(
+        get_state, *parameters, descriptions);
+    }
+
+    const auto& preview = previews->get(i);
+    auto placeholder = rmf_task::events::SimpleEventState::make(
+      id->assign(), preview.name, preview.detail, Event::Status::Standby);
+
+    // The element takes the id of its placeholder, so observers can tell
+    // that its state is the one that was waiting
+    auto make =
+      [keep_alive, id, placeholder_id = placeholder->id(), get_state,
+        parameters, desc, update]()
+      {
+        return keep_alive->initialize(
+          Event::AssignID::reuse(placeholder_id, id),
+          get_state, parameters, *desc, update);
+      };
+
+    elements.push_back(
+      std::make_shared<Sequence::Deferred>(
+        std::move(make),
+        std::move(placeholder),
+        preview.duration));
+  }
+
+  // We reverse the elements so we can always pop them off the back of the
+  // queue.
+  std::reverse(elements.begin(), elements.end());
+  return elements;
+}
+
 //==============================================================================
 void Sequence::Standby::update_status(rmf_task::events::SimpleEventState& state)
 {
@@ -155,7 +276,7 @@ void Sequence::Standby::update_status(rmf_task::events::SimpleEventState& state)
     return;
 
   Event::Status status = Event::Status::Completed;
-  for (const auto& dep : state.dependencies())
+  for (const auto& dep : state.current_dependencies())
     status = Event::sequence_status(status, dep->status());
 
   state.update_status(status);
@@ -168,14 +289,15 @@ Event::ActivePtr Sequence::Active::restore(
   const std::function<rmf_task::State()>& get_state,
   const ConstParametersPtr& parameters,
   const Bundle::Description& description,
-  const std::string& backup,
+  const nlohmann::json& backup,
   std::function<void()> parent_update,
   std::function<void()> checkpoint,
-  std::function<void()> finished)
+  std::function<void()> finished,
+  const Event::ConstInitializerPtr& keep_alive)
 {
   auto state = Sequence::Standby::make_state(id, description);
   const auto update =
-    [parent_update = std::move(parent_update), state]()
+    [parent_update, state]()
     {
       Sequence::Standby::update_status(*state);
       parent_update();
@@ -183,13 +305,24 @@ Event::ActivePtr Sequence::Active::restore(
 
   std::vector<Event::StandbyPtr> dependencies;
 
-  const auto backup_state = nlohmann::json::parse(backup);
-  if (const auto result =
-    schemas::ErrorHandler::has_error(backup_schema_validator, backup_state))
+  // The backup of a sequence is normally nested inside the backup of its
+  // parent, but older backups carried it as a serialized string
+  const nlohmann::json parsed_backup =
+    backup.is_string() ?
+    nlohmann::json::parse(backup.get_ref<const std::string&>()) :
+    nlohmann::json();
+  const auto& backup_state = backup.is_string() ? parsed_backup : backup;
+
+  // There is no need to validate a part of a backup that is already trusted
+  const auto result = schemas::TrustedBackup::Scope::active() ?
+    std::nullopt :
+    schemas::ErrorHandler::has_error(
+      schemas::backup_EventSequence_v0_1_validator(), backup_state);
+  if (result)
   {
     state->update_log().error(
       "Parsing failed while restoring backup: " + result->message
-      + "\nOriginal backup state:\n```" + backup + "\n```");
+      + "\nOriginal backup state:\n```" + backup_state.dump() + "\n```");
     state->update_status(Event::Status::Error);
     return std::make_shared<Sequence::Active>(
       dependencies, std::move(state), nullptr, nullptr, nullptr);
@@ -206,7 +339,8 @@ Event::ActivePtr Sequence::Active::restore(
       "Failed to restore backup. Index ["
       + std::to_string(current_event_index) + "] is too high for ["
       + std::to_string(description.dependencies().size())
-      + "] event dependencies. Original text:\n```\n" + backup + "\n```");
+      + "] event dependencies. Original text:\n```\n" + backup_state.dump()
+      + "\n```");
     state->update_status(Event::Status::Error);
     return std::make_shared<Sequence::Active>(
       dependencies, std::move(state), nullptr, nullptr, nullptr);
@@ -214,9 +348,9 @@ Event::ActivePtr Sequence::Active::restore(
 
   auto active = std::make_shared<Sequence::Active>(
     current_event_index,
-    std::move(state),
+    state,
     parent_update,
-    std::move(checkpoint),
+    checkpoint,
     std::move(finished));
 
   const auto event_finished =
@@ -236,20 +370,14 @@ Event::ActivePtr Sequence::Active::restore(
     update,
     checkpoint,
     event_finished);
-  state->add_dependency(active->state());
+  state->add_dependency(active->_current->state());
 
-  const std::size_t num_elements = element_descriptions.size();
-  for (std::size_t i = current_event_index + 1; i < num_elements; ++i)
-  {
-    const auto& desc = element_descriptions[i];
-    auto element = initializer.initialize(
-      id, get_state, parameters, *desc, update);
-
-    active->_state->add_dependency(element->state());
-    dependencies.emplace_back(std::move(element));
-  }
+  dependencies = Sequence::Standby::make_reverse_elements(
+    initializer, keep_alive, id, get_state, parameters, description,
+    current_event_index + 1, update);
 
-  std::reverse(dependencies.begin(), dependencies.end());
+  for (auto rit = dependencies.rbegin(); rit != dependencies.rend(); ++rit)
+    active->_state->add_dependency((*rit)->state());
 
   active->_reverse_remaining = std::move(dependencies);
 
@@ -265,7 +393,7 @@ Event::ActivePtr Sequence::Active::restore(
     ++active->_current_event_index_plus_one;
     const auto next_event = active->_reverse_remaining.back();
     active->_reverse_remaining.pop_back();
-    active->_current = next_event->begin(active->_checkpoint, event_finished);
+    active->_current = active->_begin(next_event, event_finished);
   }
 
   Sequence::Standby::update_status(*active->_state);
@@ -296,13 +424,13 @@ Event::Active::Backup Sequence::Active::backup() const
 {
   nlohmann::json current_event_json;
   current_event_json["index"] = _current_event_index_plus_one - 1;
-  current_event_json["state"] = _current->backup().state();
+  current_event_json["state"] = _current->backup().release_state();
 
   nlohmann::json backup_json;
   backup_json["schema_version"] = "0.1";
   backup_json["current_event"] = std::move(current_event_json);
 
-  return Backup::make(_next_backup_sequence_number++, backup_json);
+  return Backup::make(_next_backup_sequence_number++, std::move(backup_json));
 }
 
 //==============================================================================
@@ -394,7 +522,7 @@ void Sequence::Active::next()
         }
       };
 
-    _current = next_event->begin(_checkpoint, event_finished);
+    _current = _begin(next_event, event_finished);
   } while (_current->state()->finished());
 
   Sequence::Standby::update_status(*_state);
@@ -403,10 +531,71 @@ void Sequence::Active::next()
 }
 
 //==============================================================================
-const nlohmann::json_schema::json_validator
-Sequence::Active::backup_schema_validator =
-  nlohmann::json_schema::json_validator(
-  schemas::backup_EventSequence_v0_1);
+Event::ActivePtr Sequence::Active::_begin(
+  const Event::StandbyPtr& element,
+  std::function<void()> finished)
+{
+  const auto placeholder = element->state();
+  auto active = element->begin(_checkpoint, std::move(finished));
+  const auto actual = element->state();
+  if (actual != placeholder)
+  {
+    auto dependencies = _state->dependencies();
+    for (auto& dep : dependencies)
+    {
+      if (dep == placeholder)
+        dep = actual;
+    }
+
+    _state->update_dependencies(std::move(dependencies));
+  }
+
+  return active;
+}
+
+//==============================================================================
+Sequence::Deferred::Deferred(
+  Make make,
+  Event::ConstStatePtr placeholder,
+  rmf_traffic::Duration estimate)
+: _make(std::move(make)),
+  _placeholder(std::move(placeholder)),
+  _estimate(estimate)
+{
+  // Do nothing
+}
+
+//==============================================================================
+Event::ConstStatePtr Sequence::Deferred::state() const
+{
+  if (_standby)
+    return _standby->state();
+
+  return _placeholder;
+}
+
+//==============================================================================
+rmf_traffic::Duration Sequence::Deferred::duration_estimate() const
+{
+  if (_standby)
+    return _standby->duration_estimate();
+
+  return _estimate;
+}
+
+//==============================================================================
+Event::ActivePtr Sequence::Deferred::begin(
+  std::function<void()> checkpoint,
+  std::function<void()> finish)
+{
+  if (!_standby)
+  {
+    _standby = _make();
+    _make = nullptr;
+  }
+
+  return _standby->begin(std::move(checkpoint), std::move(finish));
+}
 
 } // namespace internal
 } // namespace events
@@ -17,11 +17,13 @@
 
 #include <rmf_task_sequence/events/WaitFor.hpp>
 
+#include "../internal_Activity.hpp"
+
 namespace rmf_task_sequence {
 namespace events {
 
 //==============================================================================
-class WaitFor::Model : public Activity::Model
+class WaitFor::Model : public internal::InvariantModel
 {
 public:
 
@@ -40,10 +42,11 @@ public:
 
   State invariant_finish_state() const final;
 
+  const internal::InvariantOffset& offset() const final;
+
 private:
   rmf_task::State _invariant_finish_state;
-  double _invariant_battery_drain;
-  rmf_traffic::Duration _duration;
+  internal::InvariantOffset _offset;
 };
 
 //==============================================================================
@@ -101,32 +104,38 @@ Header WaitFor::Description::generate_header(
 
   return Header(
     "Waiting",
-    "Waiting for [" + std::to_string(seconds.count()) + "] seconds to elapse",
+    [seconds]()
+    {
+      return "Waiting for [" + std::to_string(seconds.count())
+      + "] seconds to elapse";
+    },
     _pimpl->duration);
 }
 
+//==============================================================================
+std::optional<std::string> WaitFor::Description::model_key() const
+{
+  return "WaitFor|" + std::to_string(_pimpl->duration.count());
+}
+
 //==============================================================================
 WaitFor::Model::Model(
   State invariant_initial_state,
   rmf_traffic::Duration duration,
   const Parameters& parameters)
-: _invariant_finish_state(std::move(invariant_initial_state)),
-  _duration(duration)
+: _invariant_finish_state(std::move(invariant_initial_state))
 {
+  _offset.duration = duration;
   if (parameters.ambient_sink())
   {
     // Handle cases where duration is invalid.
-    const auto duration =
-      _duration.count() < 0 ? rmf_traffic::Duration(0) : _duration;
+    if (duration.count() < 0)
+      duration = rmf_traffic::Duration(0);
 
-    _invariant_battery_drain =
+    _offset.battery_drain =
       parameters.ambient_sink()->compute_change_in_charge(
       rmf_traffic::time::to_seconds(duration));
   }
-  else
-  {
-    _invariant_battery_drain = 0.0;
-  }
 }
 
 //==============================================================================
@@ -136,12 +145,12 @@ std::optional<Estimate> WaitFor::Model::estimate_finish(
   const Constraints& constraints,
   const TravelEstimator&) const
 {
-  state.time(state.time().value() + _duration);
+  state.time(state.time().value() + _offset.duration);
 
   if (constraints.drain_battery())
   {
     const auto new_battery_soc =
-      state.battery_soc().value() - _invariant_battery_drain;
+      state.battery_soc().value() - _offset.battery_drain;
     if (new_battery_soc < 0.0)
     {
       return std::nullopt;
@@ -158,7 +167,7 @@ std::optional<Estimate> WaitFor::Model::estimate_finish(
 //==============================================================================
 rmf_traffic::Duration WaitFor::Model::invariant_duration() const
 {
-  return _duration;
+  return _offset.duration;
 }
 
 //==============================================================================
@@ -167,5 +176,11 @@ State WaitFor::Model::invariant_finish_state() const
   return _invariant_finish_state;
 }
 
+//==============================================================================
+const internal::InvariantOffset& WaitFor::Model::offset() const
+{
+  return _offset;
+}
+
 } // namespace phases
 } // namespace rmf_task_sequence
@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK_SEQUENCE__EVENTS__INTERNAL_PARALLEL_HPP
+#define SRC__RMF_TASK_SEQUENCE__EVENTS__INTERNAL_PARALLEL_HPP
+
+#include <rmf_task_sequence/events/Bundle.hpp>
+#include <rmf_task/events/SimpleEventState.hpp>
+
+#include <rmf_task_sequence/schemas/ErrorHandler.hpp>
+#include <rmf_task_sequence/schemas/backup_EventParallel_v0_1.hpp>
+
+namespace rmf_task_sequence {
+namespace events {
+namespace internal {
+
+//==============================================================================
+/// Runs the dependencies of a ParallelAll or ParallelAny bundle at the same
+/// time.
+class Parallel
+{
+public:
+
+  class Standby;
+  class Active;
+
+  /// Combine the durations of two branches according to the bundle type.
+  static rmf_traffic::Duration combine(
+    Bundle::Type type,
+    std::optional<rmf_traffic::Duration> current,
+    rmf_traffic::Duration next);
+
+  static void update_status(
+    Bundle::Type type,
+    rmf_task::events::SimpleEventState& state);
+};
+
+//==============================================================================
+class Parallel::Standby : public Event::Standby
+{
+public:
+
+  static Event::StandbyPtr initiate(
+    const Event::Initializer& initializer,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    std::function<void()> parent_update);
+
+  using MakeStandby = std::function<Event::StandbyPtr(Bundle::UpdateFn)>;
+
+  static Event::StandbyPtr initiate(
+    Bundle::Type type,
+    const std::vector<MakeStandby>& dependencies,
+    rmf_task::events::SimpleEventStatePtr state,
+    std::function<void()> update);
+
+  Event::ConstStatePtr state() const final;
+
+  rmf_traffic::Duration duration_estimate() const final;
+
+  Event::ActivePtr begin(
+    std::function<void()> checkpoint,
+    std::function<void()> finish) final;
+
+  Standby(
+    Bundle::Type type,
+    std::vector<Event::StandbyPtr> dependencies,
+    rmf_task::events::SimpleEventStatePtr state,
+    std::function<void()> parent_update);
+
+  static rmf_task::events::SimpleEventStatePtr make_state(
+    const Event::AssignIDPtr& id,
+    const Bundle::Description& description);
+
+private:
+
+  Bundle::Type _type;
+  std::vector<Event::StandbyPtr> _dependencies;
+  rmf_task::events::SimpleEventStatePtr _state;
+  std::function<void()> _parent_update;
+  std::shared_ptr<Parallel::Active> _active;
+};
+
+//==============================================================================
+class Parallel::Active
+  : public Event::Active,
+  public std::enable_shared_from_this<Parallel::Active>
+{
+public:
+
+  static Event::ActivePtr restore(
+    const Event::Initializer& initializer,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    const nlohmann::json& backup,
+    std::function<void()> parent_update,
+    std::function<void()> checkpoint,
+    std::function<void()> finished);
+
+  Event::ConstStatePtr state() const final;
+
+  rmf_traffic::Duration remaining_time_estimate() const final;
+
+  Backup backup() const final;
+
+  Resume interrupt(std::function<void()> task_is_interrupted) final;
+
+  void cancel() final;
+
+  void kill() final;
+
+  Active(
+    Bundle::Type type,
+    rmf_task::events::SimpleEventStatePtr state,
+    std::function<void()> parent_update,
+    std::function<void()> checkpoint,
+    std::function<void()> finished);
+
+  /// Begin every branch that is still on standby
+  void begin(std::vector<std::pair<uint64_t, Event::StandbyPtr>> branches);
+
+  /// Check whether the bundle has finished after one of its branches finished
+  void check_finished();
+
+private:
+
+  struct Branch
+  {
+    uint64_t index;
+    Event::ActivePtr active;
+  };
+
+  std::function<void()> _branch_finished();
+
+  Bundle::Type _type;
+  std::vector<Branch> _branches;
+  rmf_task::events::SimpleEventStatePtr _state;
+  std::function<void()> _parent_update;
+  std::function<void()> _checkpoint;
+  std::function<void()> _bundle_finished;
+
+  // Branches may finish as soon as they begin, so check_finished() must not
+  // do anything until every branch has begun.
+  bool _beginning = false;
+  bool _finished = false;
+
+  // The index of the first branch of a ParallelAny bundle to finish
+  std::optional<uint64_t> _winner;
+
+  // A ParallelAny bundle cancels its remaining branches only once
+  bool _dismissed_others = false;
+  mutable uint64_t _next_backup_sequence_number = 0;
+};
+
+} // namespace internal
+} // namespace events
+} // namespace rmf_task_sequence
+
+#endif // SRC__RMF_TASK_SEQUENCE__EVENTS__INTERNAL_PARALLEL_HPP
@@ -51,6 +51,8 @@ public:
     State invariant_initial_state,
     const Parameters& parameters) const;
 
+  std::optional<std::string> model_key() const;
+
   Header generate_header(
     const std::string& type,
     const State& initial_state,
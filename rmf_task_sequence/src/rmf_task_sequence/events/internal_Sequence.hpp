@@ -54,6 +54,11 @@ public:
 
   class Standby;
   class Active;
+  class Deferred;
+
+  // The elements of a sequence after this many are only initialized once the
+  // sequence reaches them, if the initializer can be kept alive until then
+  static constexpr std::size_t EagerElements = 1;
 
 };
 
@@ -70,6 +75,17 @@ public:
     const Bundle::Description& description,
     std::function<void()> parent_update);
 
+  // Initialize the first EagerElements elements right away and defer the
+  // rest until the sequence reaches them. The initializer is kept alive by
+  // the deferred elements.
+  static Event::StandbyPtr initiate(
+    const Event::ConstInitializerPtr& initializer,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    std::function<void()> parent_update);
+
   using MakeStandby = std::function<Event::StandbyPtr(Bundle::UpdateFn)>;
 
   static Event::StandbyPtr initiate(
@@ -96,6 +112,19 @@ public:
 
   static void update_status(rmf_task::events::SimpleEventState& state);
 
+  // Make the elements of a sequence in reverse order, starting from the
+  // element at index first. If keep_alive is not null, the elements after the
+  // first EagerElements are deferred.
+  static std::vector<Event::StandbyPtr> make_reverse_elements(
+    const Event::Initializer& initializer,
+    const Event::ConstInitializerPtr& keep_alive,
+    const Event::AssignIDPtr& id,
+    const std::function<rmf_task::State()>& get_state,
+    const ConstParametersPtr& parameters,
+    const Bundle::Description& description,
+    std::size_t first,
+    const std::function<void()>& update);
+
 private:
 
   std::vector<Event::StandbyPtr> _reverse_dependencies;
@@ -111,16 +140,19 @@ class Sequence::Active
 {
 public:
 
+  // If keep_alive is not null, the elements after the current one are
+  // deferred the same way as with Standby::initiate
   static Event::ActivePtr restore(
     const Event::Initializer& initializer,
     const Event::AssignIDPtr& id,
     const std::function<rmf_task::State()>& get_state,
     const ConstParametersPtr& parameters,
     const Bundle::Description& description,
-    const std::string& backup,
+    const nlohmann::json& backup,
     std::function<void()> parent_update,
     std::function<void()> checkpoint,
-    std::function<void()> finished);
+    std::function<void()> finished,
+    const Event::ConstInitializerPtr& keep_alive = nullptr);
 
   Event::ConstStatePtr state() const final;
 
@@ -152,7 +184,11 @@ public:
 
 private:
 
-  static const nlohmann::json_schema::json_validator backup_schema_validator;
+  // Begin an element and put its state in place of the placeholder state
+  // that it had if it was deferred
+  Event::ActivePtr _begin(
+    const Event::StandbyPtr& element,
+    std::function<void()> finished);
 
   Event::ActivePtr _current;
   uint64_t _current_event_index_plus_one = 0;
@@ -168,6 +204,38 @@ private:
   mutable uint64_t _next_backup_sequence_number = 0;
 };
 
+//==============================================================================
+// An element of a sequence that is only initialized once it begins. Until
+// then it reports a placeholder state in the Standby status, with the name
+// and detail of the header of its description, and its duration is estimated
+// from the model of its description. The element is given the id of the
+// placeholder when it is initialized.
+class Sequence::Deferred : public Event::Standby
+{
+public:
+
+  using Make = std::function<Event::StandbyPtr()>;
+
+  Deferred(
+    Make make,
+    Event::ConstStatePtr placeholder,
+    rmf_traffic::Duration estimate);
+
+  Event::ConstStatePtr state() const final;
+
+  rmf_traffic::Duration duration_estimate() const final;
+
+  Event::ActivePtr begin(
+    std::function<void()> checkpoint,
+    std::function<void()> finish) final;
+
+private:
+  Make _make;
+  Event::ConstStatePtr _placeholder;
+  rmf_traffic::Duration _estimate;
+  Event::StandbyPtr _standby;
+};
+
 } // namespace internal
 } // namespace events
 } // namespace rmf_task_sequence
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK_SEQUENCE__INTERNAL_ACTIVITY_HPP
+#define SRC__RMF_TASK_SEQUENCE__INTERNAL_ACTIVITY_HPP
+
+#include <rmf_task_sequence/Activity.hpp>
+
+#include <optional>
+#include <string>
+
+namespace rmf_task_sequence {
+namespace internal {
+
+//==============================================================================
+// The change that a model makes to the state of a robot when that change does
+// not depend on the state that the robot starts from.
+struct InvariantOffset
+{
+  // Added to the time of the state
+  rmf_traffic::Duration duration = rmf_traffic::Duration(0);
+
+  // Subtracted from the battery state of charge when the battery is drained
+  double battery_drain = 0.0;
+
+  // Replaces the waypoint and orientation of the state when they are set
+  std::optional<std::size_t> waypoint;
+  std::optional<double> orientation;
+
+  // The type that the duration is corrected for by the Calibration of the
+  // travel estimator, if any. The correction depends on where the robot
+  // starts from, so a folded offset keeps it aside until it is applied.
+  std::optional<std::string> calibration_type;
+};
+
+//==============================================================================
+// A model whose estimate is nothing more than an InvariantOffset, followed by
+// a check that the battery state of charge is still above the threshold. The
+// estimate must have a wait_until of the earliest arrival time. A
+// SequenceModel folds runs of these models into a single offset instead of
+// asking each of them for an estimate.
+class InvariantModel : public Activity::Model
+{
+public:
+
+  virtual const InvariantOffset& offset() const = 0;
+};
+
+//==============================================================================
+// The number of steps that a SequenceModel evaluates, where each run of folded
+// InvariantModels counts as one step
+std::size_t count_steps(const Activity::SequenceModel& model);
+
+} // namespace internal
+} // namespace rmf_task_sequence
+
+#endif // SRC__RMF_TASK_SEQUENCE__INTERNAL_ACTIVITY_HPP
@@ -42,12 +42,20 @@ public:
       return Header(*category, *detail, duration);
 
     auto event_header = final_event->generate_header(initial_state, parameters);
-    const std::string& c = category.has_value() ?
+    std::string c = category.has_value() ?
       *category : event_header.category();
-    const std::string& d = detail.has_value() ?
-      *detail : event_header.detail();
 
-    return Header(c, d, duration);
+    if (detail.has_value())
+      return Header(std::move(c), *detail, duration);
+
+    const bool detail_is_json = event_header.detail_is_json();
+    return Header(
+      std::move(c),
+      [event_header = std::move(event_header)]()
+      {
+        return event_header.detail();
+      },
+      duration).detail_is_json(detail_is_json);
   }
 };
 
@@ -95,6 +103,10 @@ public:
 
   ConstTagPtr _tag;
   Event::ActivePtr _final_event;
+
+  // The last snapshot that was sent out, so parts of the event tree that have
+  // not changed can be reused in the next one
+  Phase::ConstSnapshotPtr _last_snapshot;
 };
 
 //==============================================================================
@@ -126,7 +138,11 @@ void SimplePhase::add(
         if (const auto phase = weak.lock())
         {
           if (phase->_final_event)
-            phase_update(Phase::Snapshot::make(*phase));
+          {
+            phase->_last_snapshot =
+              Phase::Snapshot::make(*phase, phase->_last_snapshot);
+            phase_update(phase->_last_snapshot);
+          }
         }
       };
 
@@ -251,6 +267,12 @@ Header SimplePhase::Description::generate_header(
   return _pimpl->generate_header(initial_state, parameters);
 }
 
+//==============================================================================
+std::optional<std::string> SimplePhase::Description::model_key() const
+{
+  return _pimpl->final_event->model_key();
+}
+
 //==============================================================================
 SimplePhase::Description::Description()
 {
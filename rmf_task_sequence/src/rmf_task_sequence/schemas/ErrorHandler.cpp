@@ -32,7 +32,7 @@ void ErrorHandler::error(
 //==============================================================================
 auto ErrorHandler::has_error(
   const nlohmann::json_schema::json_validator& validator,
-  const nlohmann::json json) -> std::optional<Info>
+  const nlohmann::json& json) -> std::optional<Info>
 {
   ErrorHandler handler;
   validator.validate(json, handler);
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#include "internal_TrustedBackup.hpp"
+
+#include <cstring>
+
+namespace rmf_task_sequence {
+namespace schemas {
+
+namespace {
+//==============================================================================
+thread_local bool restoring_trusted_backup = false;
+
+//==============================================================================
+// FNV-1a, so that the checksum is the same on every platform and build
+class Checksum
+{
+public:
+
+  void add(const void* data, std::size_t size)
+  {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      _hash ^= bytes[i];
+      _hash *= 1099511628211ull;
+    }
+  }
+
+  template<typename T>
+  void add(const T& value)
+  {
+    add(&value, sizeof(T));
+  }
+
+  void add(const std::string& value)
+  {
+    add(static_cast<uint64_t>(value.size()));
+    add(value.data(), value.size());
+  }
+
+  // Add a json value. Keys of the root object that match skip_key are left
+  // out, so the stamp of a backup does not need to cover itself.
+  void add(const nlohmann::json& json, const std::string* skip_key = nullptr)
+  {
+    using value_t = nlohmann::json::value_t;
+    switch (json.type())
+    {
+      case value_t::object:
+      {
+        add('{');
+        for (auto it = json.begin(); it != json.end(); ++it)
+        {
+          if (skip_key && it.key() == *skip_key)
+            continue;
+
+          add(it.key());
+          add(it.value());
+        }
+        add('}');
+        return;
+      }
+      case value_t::array:
+      {
+        add('[');
+        add(static_cast<uint64_t>(json.size()));
+        for (const auto& value : json)
+          add(value);
+        return;
+      }
+      case value_t::string:
+      {
+        add('"');
+        add(json.get_ref<const std::string&>());
+        return;
+      }
+      case value_t::boolean:
+      {
+        add(json.get<bool>() ? 't' : 'f');
+        return;
+      }
+      case value_t::number_integer:
+      case value_t::number_unsigned:
+      {
+        // Parsing gives non-negative integers the unsigned type no matter how
+        // they were written, so both types must give the same checksum
+        if (json.is_number_unsigned() || json.get<int64_t>() >= 0)
+        {
+          add('u');
+          add(json.get<uint64_t>());
+        }
+        else
+        {
+          add('i');
+          add(json.get<int64_t>());
+        }
+        return;
+      }
+      case value_t::number_float:
+      {
+        add('d');
+        add(json.get<double>());
+        return;
+      }
+      case value_t::binary:
+      {
+        add('b');
+        const auto& binary = json.get_binary();
+        add(static_cast<uint64_t>(binary.size()));
+        add(binary.data(), binary.size());
+        return;
+      }
+      default:
+      {
+        add('n');
+        return;
+      }
+    }
+  }
+
+  uint64_t value() const
+  {
+    return _hash;
+  }
+
+private:
+  uint64_t _hash = 14695981039346656037ull;
+};
+
+//==============================================================================
+uint64_t checksum(const nlohmann::json& backup)
+{
+  Checksum checksum;
+  checksum.add(backup, &TrustedBackup::StampKey);
+  return checksum.value();
+}
+
+//==============================================================================
+const std::string LibraryVersion =
+  std::string("rmf_task_sequence ") + RMF_TASK_SEQUENCE_VERSION;
+} // anonymous namespace
+
+//==============================================================================
+const std::string TrustedBackup::StampKey = "stamp";
+
+//==============================================================================
+nlohmann::json TrustedBackup::stamp(const nlohmann::json& backup)
+{
+  return nlohmann::json{
+    {"library", LibraryVersion},
+    {"checksum", checksum(backup)}
+  };
+}
+
+//==============================================================================
+bool TrustedBackup::check(const nlohmann::json& backup)
+{
+  if (!backup.is_object())
+    return false;
+
+  const auto stamp_it = backup.find(StampKey);
+  if (stamp_it == backup.end() || !stamp_it->is_object())
+    return false;
+
+  const auto library_it = stamp_it->find("library");
+  if (library_it == stamp_it->end() || *library_it != LibraryVersion)
+    return false;
+
+  const auto checksum_it = stamp_it->find("checksum");
+  if (checksum_it == stamp_it->end() || !checksum_it->is_number_unsigned())
+    return false;
+
+  return checksum_it->get<uint64_t>() == checksum(backup);
+}
+
+//==============================================================================
+TrustedBackup::Scope::Scope(bool trusted)
+: _previous(restoring_trusted_backup)
+{
+  restoring_trusted_backup = trusted;
+}
+
+//==============================================================================
+TrustedBackup::Scope::~Scope()
+{
+  restoring_trusted_backup = _previous;
+}
+
+//==============================================================================
+bool TrustedBackup::Scope::active()
+{
+  return restoring_trusted_backup;
+}
+
+} // namespace schemas
+} // namespace rmf_task_sequence
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 Open Source Robotics Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+*/
+
+#ifndef SRC__RMF_TASK_SEQUENCE__SCHEMAS__INTERNAL_TRUSTEDBACKUP_HPP
+#define SRC__RMF_TASK_SEQUENCE__SCHEMAS__INTERNAL_TRUSTEDBACKUP_HPP
+
+#include <nlohmann/json.hpp>
+
+namespace rmf_task_sequence {
+namespace schemas {
+
+//==============================================================================
+// Backups that this version of the library writes are stamped with the
+// library version and a checksum of their content. A backup whose stamp still
+// matches was produced by this same code and has not been altered since, so
+// restoring it can skip validating it against the backup schemas.
+class TrustedBackup
+{
+public:
+
+  // The key of the stamp within the root of a backup
+  static const std::string StampKey;
+
+  // Make the stamp for a backup. The backup must not have a stamp yet.
+  static nlohmann::json stamp(const nlohmann::json& backup);
+
+  // Check whether a backup carries a stamp that matches its content and the
+  // version of this library
+  static bool check(const nlohmann::json& backup);
+
+  // While a Scope is alive, restoring a part of a backup on this thread can
+  // rely on the whole backup being trusted
+  class Scope
+  {
+  public:
+    Scope(bool trusted);
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope();
+
+    // Check whether a backup that is being restored on this thread is trusted
+    static bool active();
+
+  private:
+    bool _previous;
+  };
+};
+
+} // namespace schemas
+} // namespace rmf_task_sequence
+
+#endif // SRC__RMF_TASK_SEQUENCE__SCHEMAS__INTERNAL_TRUSTEDBACKUP_HPP
@@ -69,4 +69,124 @@ SCENARIO("Test GoToPlace")
     REQUIRE(finish.has_value());
     CHECK(finish->finish_state().waypoint() == 8);
   }
+
+  WHEN("The robot starts closer to a different goal")
+  {
+    auto description = GoToPlace::Description::make_for_one_of({0, 8, 12});
+    const auto model = description->make_model(initial_state, *parameters);
+    REQUIRE(model);
+    CHECK(model->invariant_finish_state().waypoint() == 0);
+
+    // Goals whose straight line bound cannot beat the best trip are skipped
+    const rmf_task::TravelEstimator estimator(*parameters);
+    auto moved_state = initial_state;
+    moved_state.waypoint(3);
+    const auto finish =
+      model->estimate_finish(moved_state, now, *constraints, estimator);
+    REQUIRE(finish.has_value());
+    CHECK(finish->finish_state().waypoint() == 8);
+
+    const auto stats = estimator.statistics();
+    CHECK(stats.hits() + stats.misses() < 3);
+
+    // Goals on another map than the start are never skipped by the straight
+    // line bound, because their coordinates cannot be compared
+    const rmf_task::TravelEstimator other_estimator(*parameters);
+    auto other_map_state = initial_state;
+    other_map_state.waypoint(0);
+    const auto other_model = GoToPlace::Description::make_for_one_of({1, 12})
+      ->make_model(other_map_state, *parameters);
+    REQUIRE(other_model);
+    const auto other_finish = other_model->estimate_finish(
+      other_map_state, now, *constraints, other_estimator);
+    REQUIRE(other_finish.has_value());
+    CHECK(other_finish->finish_state().waypoint() == 1);
+
+    const auto other_stats = other_estimator.statistics();
+    CHECK(other_stats.hits() + other_stats.misses() == 2);
+  }
+
+  WHEN("A travel estimator is shared through the parameters")
+  {
+    auto shared_parameters = *parameters;
+    const auto shared_estimator =
+      std::make_shared<rmf_task::TravelEstimator>(shared_parameters);
+    shared_parameters.travel_estimator(shared_estimator);
+
+    auto description = GoToPlace::Description::make_for_one_of({0, 8, 12});
+    const auto model =
+      description->make_model(initial_state, shared_parameters);
+    REQUIRE(model);
+    CHECK(shared_estimator->statistics().misses() > 0);
+
+    const auto finish = model->estimate_finish(
+      initial_state, now, *constraints, *shared_estimator);
+    REQUIRE(finish.has_value());
+    CHECK(finish->finish_state().waypoint() == 0);
+
+    // Making the same model again should only use cached trips
+    const auto before = shared_estimator->statistics();
+    description->make_model(initial_state, shared_parameters);
+    const auto after = shared_estimator->statistics().since(before);
+    CHECK(after.misses() == 0);
+    CHECK(after.hits() > 0);
+
+    // The header scores every goal with the same cached trips
+    const auto header_before = shared_estimator->statistics();
+    const auto header =
+      description->generate_header(initial_state, shared_parameters);
+    const auto header_stats =
+      shared_estimator->statistics().since(header_before);
+    CHECK(header_stats.misses() == 0);
+    CHECK(header_stats.hits() >= 3);
+    CHECK(header.original_duration_estimate() > rmf_traffic::Duration(0));
+  }
+
+  WHEN("Models are memoized")
+  {
+    using ModelCache = rmf_task_sequence::Activity::ModelCache;
+    ModelCache::clear();
+
+    const auto description = GoToPlace::Description::make_for_one_of({0, 8});
+    const auto same = GoToPlace::Description::make_for_one_of({0, 8});
+    const auto other = GoToPlace::Description::make_for_one_of({0, 12});
+    CHECK(description->model_key() == same->model_key());
+    CHECK(description->model_key() != other->model_key());
+
+    const auto model =
+      ModelCache::make_model(*description, initial_state, *parameters);
+    REQUIRE(model);
+    CHECK(ModelCache::size() == 1);
+
+    // Identical descriptions reuse the model
+    CHECK(ModelCache::make_model(*same, initial_state, *parameters) == model);
+    CHECK(ModelCache::size() == 1);
+
+    // Different descriptions or initial states get their own models
+    CHECK(ModelCache::make_model(*other, initial_state, *parameters) != model);
+    auto moved_state = initial_state;
+    moved_state.waypoint(2);
+    CHECK(ModelCache::make_model(*description, moved_state, *parameters)
+      != model);
+    CHECK(ModelCache::size() == 3);
+
+    // Copies of the parameters share the models, but parameters with other
+    // power sinks do not
+    const auto copied = *parameters;
+    CHECK(ModelCache::make_model(*description, initial_state, copied)
+      == model);
+    auto changed = *parameters;
+    REQUIRE(parameters->ambient_sink());
+    changed.tool_sink(
+      parameters->tool_sink() ? nullptr : parameters->ambient_sink());
+    CHECK(ModelCache::make_model(*description, initial_state, changed)
+      != model);
+    CHECK(ModelCache::size() == 4);
+
+    // The least recently used models are dropped first
+    ModelCache::capacity(1);
+    CHECK(ModelCache::size() == 1);
+    ModelCache::capacity(4096);
+    ModelCache::clear();
+  }
 }
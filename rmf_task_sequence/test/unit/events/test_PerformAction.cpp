@@ -18,9 +18,12 @@
 #include <rmf_utils/catch.hpp>
 
 #include <rmf_task_sequence/events/PerformAction.hpp>
+#include <rmf_task_sequence/events/WaitFor.hpp>
 
 #include "../utils.hpp"
 
+#include <src/rmf_task_sequence/internal_Activity.hpp>
+
 using namespace std::chrono_literals;
 
 SCENARIO("Test PerformAction")
@@ -95,6 +98,116 @@ SCENARIO("Test PerformAction")
       expected_finish_state);
   }
 
+  WHEN("Testing a sequence of actions and waits")
+  {
+    // The sequence folds the waits into steps of their own, which must give
+    // the same estimate as asking each of the models in turn
+    using WaitFor = rmf_task_sequence::events::WaitFor;
+    const std::vector<rmf_task_sequence::Activity::ConstDescriptionPtr>
+    descriptions = {
+      description,
+      WaitFor::Description::make(30s),
+      PerformAction::Description::make(
+        category, desc, 20s, true, rmf_traffic::agv::Planner::Goal{3}),
+      WaitFor::Description::make(15s)
+    };
+
+    const auto sequence = rmf_task_sequence::Activity::SequenceModel::make(
+      descriptions, initial_state, *parameters);
+    REQUIRE(sequence);
+    CHECK(sequence->invariant_duration() == 75s);
+
+    // The actions are folded along with the waits, even though a calibration
+    // could correct their duration
+    const auto* sequence_model =
+      dynamic_cast<const rmf_task_sequence::Activity::SequenceModel*>(
+      sequence.get());
+    REQUIRE(sequence_model);
+    CHECK(rmf_task_sequence::internal::count_steps(*sequence_model) == 1);
+
+    const auto travel_estimator = rmf_task::TravelEstimator(*parameters);
+    rmf_task::State expected_finish_state = initial_state;
+    rmf_task::State invariant_state = initial_state;
+    for (const auto& d : descriptions)
+    {
+      const auto model = d->make_model(invariant_state, *parameters);
+      invariant_state = model->invariant_finish_state();
+      const auto estimate = model->estimate_finish(
+        expected_finish_state, now, *constraints, travel_estimator);
+      REQUIRE(estimate.has_value());
+      expected_finish_state = estimate->finish_state();
+    }
+
+    const auto estimate = sequence->estimate_finish(
+      initial_state, now, *constraints, travel_estimator);
+    REQUIRE(estimate.has_value());
+    CHECK(estimate->wait_until() == now);
+    CHECK_STATE(estimate->finish_state(), expected_finish_state);
+    CHECK(estimate->finish_state().waypoint() == 3);
+    CHECK(estimate->finish_state().battery_soc().value()
+      == Approx(expected_finish_state.battery_soc().value()));
+
+    // Without enough battery for the whole sequence, the estimate fails
+    rmf_task::State low_battery = initial_state;
+    low_battery.battery_soc(
+      constraints->threshold_soc()
+      + 0.5 * (1.0 - expected_finish_state.battery_soc().value()));
+    CHECK_FALSE(sequence->estimate_finish(
+        low_battery, now, *constraints, travel_estimator).has_value());
+  }
+
+  WHEN("Testing a calibrated model")
+  {
+    // The action has been taking twice as long as its estimate when it
+    // starts from waypoint 0 and finishes at waypoint 1
+    auto calibration = std::make_shared<rmf_task::Calibration>();
+    CHECK(calibration->report(category, 0, 1, duration, 2*duration));
+
+    const auto model = description->make_model(initial_state, *parameters);
+    auto travel_estimator = rmf_task::TravelEstimator(*parameters);
+    travel_estimator.calibration(calibration);
+
+    const auto estimate = model->estimate_finish(
+      initial_state, now, *constraints, travel_estimator);
+    REQUIRE(estimate.has_value());
+    CHECK(estimate->finish_state().time() == now + 2*duration);
+    CHECK(model->invariant_duration() == duration);
+
+    // Starting from elsewhere is not corrected
+    rmf_task::State elsewhere = initial_state;
+    elsewhere.waypoint(2);
+    const auto uncorrected = model->estimate_finish(
+      elsewhere, now, *constraints, travel_estimator);
+    REQUIRE(uncorrected.has_value());
+    CHECK(uncorrected->finish_state().time() == now + duration);
+
+    // Sequences keep the correction of their actions
+    const auto sequence = rmf_task_sequence::Activity::SequenceModel::make(
+      {description}, initial_state, *parameters);
+    REQUIRE(sequence);
+    const auto sequence_estimate = sequence->estimate_finish(
+      initial_state, now, *constraints, travel_estimator);
+    REQUIRE(sequence_estimate.has_value());
+    CHECK(sequence_estimate->finish_state().time() == now + 2*duration);
+
+    // The correction of a folded action is looked up from where the action
+    // starts, which the actions and waits before it may have moved
+    using WaitFor = rmf_task_sequence::events::WaitFor;
+    const auto folded = rmf_task_sequence::Activity::SequenceModel::make(
+      {
+        WaitFor::Description::make(30s),
+        PerformAction::Description::make(
+          category, desc, duration, false, rmf_traffic::agv::Planner::Goal{0}),
+        description
+      }, elsewhere, *parameters);
+    REQUIRE(folded);
+    const auto folded_estimate = folded->estimate_finish(
+      elsewhere, now, *constraints, travel_estimator);
+    REQUIRE(folded_estimate.has_value());
+    CHECK(folded_estimate->finish_state().time() == now + 30s + 3*duration);
+    CHECK(folded_estimate->finish_state().waypoint() == 1);
+  }
+
   WHEN("Testing header")
   {
     const auto header = description->generate_header(
@@ -16,6 +16,7 @@
 */
 
 #include <rmf_task/Activator.hpp>
+#include <rmf_task/AllocationCounter.hpp>
 
 #include <rmf_task_sequence/Event.hpp>
 #include <rmf_task_sequence/events/Bundle.hpp>
@@ -214,6 +215,15 @@ SCENARIO("Test Event Sequences")
         rmf_task::Event::Status::Standby
       });
 
+    // The second element is only initialized once it begins. Until then its
+    // placeholder already has its name.
+    const auto waiting = last_snapshot->final_event()->dependencies()[1];
+    const auto waiting_name =
+      rmf_task::VersionedString::Reader().read(waiting->name());
+    REQUIRE(waiting_name);
+    CHECK(*waiting_name == "Mock Activity");
+    const auto waiting_id = waiting->id();
+
     CHECK(task->completed_phases().size() == 0);
     CHECK(task->pending_phases().size() == 2);
     last_snapshot = nullptr;
@@ -237,6 +247,12 @@ SCENARIO("Test Event Sequences")
         rmf_task::Event::Status::Standby
       });
 
+    // Once the second element begins, its state takes the place of the one
+    // it had while it was waiting, and it keeps the same id
+    CHECK(last_snapshot->final_event()->dependencies()[1]->id()
+      == ctrl_1_1->active->state()->id());
+    CHECK(ctrl_1_1->active->state()->id() == waiting_id);
+
     CHECK(last_backup.has_value());
 
     CHECK(task->completed_phases().size() == 0);
@@ -420,4 +436,768 @@ SCENARIO("Test Event Sequences")
     CHECK(task->completed_phases().size() == 3);
     CHECK(task->pending_phases().size() == 0);
   }
+
+  WHEN("Restore the task from a backup")
+  {
+    ctrl_1_0->active->complete();
+    ctrl_1_1->active->complete();
+    check_active({ctrl_1_2});
+
+    // The backup of the sequence is nested as it is, not as a string that was
+    // serialized separately
+    const auto backup = task->backup();
+    const auto backup_json = nlohmann::json::parse(backup.state());
+    const auto& sequence_json = backup_json["current_phase"]["state"];
+    REQUIRE(sequence_json.is_object());
+    CHECK(sequence_json["current_event"]["index"] == 2);
+
+    const auto original_active = ctrl_1_2->active;
+    auto restored = task_activator.restore(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      backup.state(),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(restored);
+
+    // The restored task should pick up at the third event of the sequence
+    REQUIRE(ctrl_1_2->active);
+    CHECK(ctrl_1_2->active != original_active);
+    CHECK(restored->active_phase()->tag()->id() == 1);
+
+    ctrl_1_2->active->complete();
+    check_active({ctrl_1_3});
+  }
+
+  WHEN("Restore a task with skipped phases from a backup")
+  {
+    task->skip(3, true);
+    const auto backup = task->backup();
+
+    auto restored = task_activator.restore(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      backup.state(),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(restored);
+
+    const auto& pending = restored->pending_phases();
+    REQUIRE(pending.size() == 2);
+    CHECK(pending[0].tag()->id() == 2);
+    CHECK_FALSE(pending[0].will_be_skipped());
+    CHECK(pending[1].tag()->id() == 3);
+    CHECK(pending[1].will_be_skipped());
+  }
+
+  WHEN("Make tasks from a template")
+  {
+    std::vector<std::shared_ptr<MockActivity::Controller>> ctrls = {
+      ctrl_2_0, ctrl_3_0
+    };
+
+    rmf_task_sequence::Task::Template task_template;
+    task_template
+    .add_phase(make_phase(ctrl_1_0), {})
+    .add_phase(
+      [&ctrls](const nlohmann::json& arguments)
+      -> rmf_task_sequence::Phase::ConstDescriptionPtr
+      {
+        const auto index = arguments["ctrl"].get<std::size_t>();
+        if (index >= ctrls.size())
+          return nullptr;
+
+        return make_phase(ctrls[index]);
+      }, {});
+
+    CHECK_FALSE(task_template.instantiate({{"ctrl", 2}}, "Mock Task", ""));
+
+    const auto description =
+      task_template.instantiate({{"ctrl", 1}}, "Mock Task", "Template");
+    REQUIRE(description);
+    CHECK(description->detail() == "Template");
+
+    auto templated_task = task_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_02",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        description),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(templated_task);
+
+    const auto& pending = templated_task->pending_phases();
+    REQUIRE(pending.size() == 1);
+    CHECK(pending.front().tag()->id() == 2);
+
+    ctrl_1_0->active->complete();
+    check_active({ctrl_3_0});
+    CHECK(templated_task->active_phase()->tag()->id() == 2);
+  }
+
+  WHEN("Back up the task in a binary encoding")
+  {
+    using BackupEncoding = rmf_task_sequence::Task::BackupEncoding;
+    const auto get_state = []()
+      {
+        return rmf_task::State().time(std::chrono::steady_clock::now());
+      };
+
+    for (const auto encoding :
+      {BackupEncoding::Cbor, BackupEncoding::MessagePack})
+    {
+      rmf_task::Activator binary_activator;
+      rmf_task_sequence::Task::add(
+        binary_activator,
+        phase_activator,
+        []() { return std::chrono::steady_clock::now(); },
+        rmf_task_sequence::Task::BackupOptions().encoding(encoding));
+
+      const auto request = rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task"));
+
+      auto binary_task = binary_activator.activate(
+        get_state,
+        params,
+        request,
+        [](rmf_task::Phase::ConstSnapshotPtr) {},
+        [](rmf_task::Task::Active::Backup) {},
+        [](rmf_task::Phase::ConstCompletedPtr) {},
+        []() {});
+      REQUIRE(binary_task);
+
+      ctrl_1_0->active->complete();
+      check_active({ctrl_1_1});
+
+      const auto backup = binary_task->backup();
+      REQUIRE_FALSE(backup.state().empty());
+      CHECK(backup.state().front() == '\0');
+
+      // A task that issues JSON backups can still restore binary backups
+      const auto original_active = ctrl_1_1->active;
+      auto restored = task_activator.restore(
+        get_state,
+        params,
+        request,
+        backup.state(),
+        [](rmf_task::Phase::ConstSnapshotPtr) {},
+        [](rmf_task::Task::Active::Backup) {},
+        [](rmf_task::Phase::ConstCompletedPtr) {},
+        []() {});
+      REQUIRE(restored);
+      REQUIRE(ctrl_1_1->active);
+      CHECK(ctrl_1_1->active != original_active);
+      CHECK(restored->active_phase()->tag()->id() == 1);
+
+      // The binary backup should be smaller than the same backup as JSON
+      const auto json_backup = restored->backup().state();
+      CHECK(json_backup.front() == '{');
+      CHECK(backup.state().size() < json_backup.size());
+    }
+  }
+
+  WHEN("Issue delta checkpoints")
+  {
+    rmf_task::Activator delta_activator;
+    rmf_task_sequence::Task::add(
+      delta_activator,
+      phase_activator,
+      []() { return std::chrono::steady_clock::now(); },
+      rmf_task_sequence::Task::BackupOptions().delta());
+
+    std::vector<rmf_task::Task::Active::Backup> checkpoints;
+    auto delta_task = delta_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [&checkpoints](rmf_task::Task::Active::Backup backup)
+      {
+        checkpoints.push_back(std::move(backup));
+      },
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(delta_task);
+
+    // The first checkpoint that the task gives out is always a full backup
+    REQUIRE_FALSE(checkpoints.empty());
+    const auto full = checkpoints.front();
+    CHECK_FALSE(full.base_sequence().has_value());
+
+    ctrl_1_0->active->complete();
+    ctrl_1_1->active->complete();
+    check_active({ctrl_1_2});
+
+    const auto delta = checkpoints.back();
+    REQUIRE(delta.base_sequence().has_value());
+    CHECK(*delta.base_sequence() == full.sequence());
+    CHECK(delta.state().size() < full.state().size());
+
+    const auto state = nlohmann::json::parse(
+      rmf_task::detail::Backup::apply_delta(full.state(), delta.state()));
+    CHECK(state["current_phase"]["state"]["current_event"]["index"] == 2);
+
+    // A backup that is asked for is always full, and it does not become the
+    // base of later checkpoints, since it might never be written with them.
+    // The next checkpoint is full instead.
+    const auto requested = delta_task->backup();
+    CHECK_FALSE(requested.base_sequence().has_value());
+    CHECK(state == nlohmann::json::parse(requested.state()));
+
+    const std::size_t before = checkpoints.size();
+    ctrl_1_2->active->complete();
+    REQUIRE(checkpoints.size() > before);
+    CHECK_FALSE(checkpoints[before].base_sequence().has_value());
+    CHECK(checkpoints[before].sequence() > requested.sequence());
+  }
+
+  WHEN("Throttle checkpoints")
+  {
+    auto now = std::make_shared<rmf_traffic::Time>(
+      std::chrono::steady_clock::now());
+
+    rmf_task::Activator throttled_activator;
+    rmf_task_sequence::Task::add(
+      throttled_activator,
+      phase_activator,
+      [now]() { return *now; },
+      rmf_task_sequence::Task::BackupOptions()
+      .checkpoint_interval(std::chrono::seconds(10)));
+
+    std::vector<rmf_task::Task::Active::Backup> checkpoints;
+    auto throttled_task = throttled_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      [](rmf_task::Phase::ConstSnapshotPtr) {},
+      [&checkpoints](rmf_task::Task::Active::Backup backup)
+      {
+        checkpoints.push_back(std::move(backup));
+      },
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(throttled_task);
+
+    // Beginning the first phase always issues a checkpoint
+    REQUIRE(checkpoints.size() == 1);
+
+    ctrl_1_0->active->complete();
+    ctrl_1_1->active->complete();
+    check_active({ctrl_1_2});
+    CHECK(checkpoints.size() == 1);
+
+    // The latest state is issued with the first update after the interval
+    *now += std::chrono::seconds(11);
+    ctrl_1_2->active->update(rmf_task::Event::Status::Underway, "Moving");
+    REQUIRE(checkpoints.size() == 2);
+    const auto held_state = nlohmann::json::parse(checkpoints.back().state());
+    CHECK(held_state["current_phase"]["state"]["current_event"]["index"] == 2);
+
+    // Phase transitions are never delayed
+    ctrl_1_2->active->complete();
+    ctrl_1_3->active->complete();
+    REQUIRE(checkpoints.size() == 3);
+    const auto next_state = nlohmann::json::parse(checkpoints.back().state());
+    CHECK(next_state["current_phase"]["id"] == 2);
+
+    // A checkpoint that is held back gets sent when a backup is asked for
+    check_active({ctrl_2_0});
+    ctrl_2_0->active->update(rmf_task::Event::Status::Underway, "Moving");
+    CHECK(checkpoints.size() == 3);
+    throttled_task->backup();
+    CHECK(checkpoints.size() == 4);
+
+    // ... and when the task goes away before the interval has passed
+    ctrl_2_0->active->update(rmf_task::Event::Status::Underway, "Still moving");
+    CHECK(checkpoints.size() == 4);
+    throttled_task.reset();
+    CHECK(checkpoints.size() == 5);
+  }
+
+  WHEN("Coalesce updates")
+  {
+    std::vector<std::function<void()>> scheduled;
+    rmf_task::Activator coalescing_activator;
+    rmf_task_sequence::Task::add(
+      coalescing_activator,
+      phase_activator,
+      []() { return std::chrono::steady_clock::now(); },
+      rmf_task_sequence::Task::BackupOptions(),
+      rmf_task_sequence::Task::UpdateOptions().schedule(
+        [&scheduled](std::function<void()> callback)
+        {
+          scheduled.push_back(std::move(callback));
+        }));
+
+    std::vector<rmf_task::Phase::ConstSnapshotPtr> updates;
+    auto coalescing_task = coalescing_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      [&updates](rmf_task::Phase::ConstSnapshotPtr snapshot)
+      {
+        updates.push_back(std::move(snapshot));
+      },
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(coalescing_task);
+
+    // Beginning the first phase always issues an update
+    REQUIRE(updates.size() == 1);
+    const auto updates_before = updates.size();
+    const auto scheduled_before = scheduled.size();
+
+    for (std::size_t i = 0; i < 5; ++i)
+      ctrl_1_0->active->update(rmf_task::Event::Status::Underway, "Moving");
+
+    // The burst of changes only schedules one flush
+    CHECK(updates.size() == updates_before);
+    REQUIRE(scheduled.size() == scheduled_before + 1);
+
+    scheduled.back()();
+    CHECK(updates.size() == updates_before + 1);
+
+    // Nothing has changed since the last flush, so there is nothing to issue
+    scheduled.back()();
+    CHECK(updates.size() == updates_before + 1);
+
+    // The next change schedules a new flush
+    ctrl_1_0->active->update(rmf_task::Event::Status::Underway, "Still moving");
+    REQUIRE(scheduled.size() == scheduled_before + 2);
+    scheduled.back()();
+    CHECK(updates.size() == updates_before + 2);
+  }
+
+  WHEN("Coalesce updates within an interval")
+  {
+    auto now = std::make_shared<rmf_traffic::Time>(
+      std::chrono::steady_clock::now());
+    std::vector<std::function<void()>> scheduled;
+    rmf_task::Activator coalescing_activator;
+    rmf_task_sequence::Task::add(
+      coalescing_activator,
+      phase_activator,
+      [now]() { return *now; },
+      rmf_task_sequence::Task::BackupOptions(),
+      rmf_task_sequence::Task::UpdateOptions()
+      .schedule(
+        [&scheduled](std::function<void()> callback)
+        {
+          scheduled.push_back(std::move(callback));
+        })
+      .interval(std::chrono::seconds(10)));
+
+    std::size_t updates = 0;
+    auto coalescing_task = coalescing_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      [&updates](rmf_task::Phase::ConstSnapshotPtr) { ++updates; },
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(coalescing_task);
+    REQUIRE(updates == 1);
+
+    ctrl_1_0->active->update(rmf_task::Event::Status::Underway, "Moving");
+    REQUIRE(scheduled.size() == 1);
+
+    // The flush comes before the interval has passed, so it holds on to the
+    // change and schedules another flush
+    auto flush = scheduled.back();
+    flush();
+    CHECK(updates == 1);
+    REQUIRE(scheduled.size() == 2);
+
+    // The held change is issued by a scheduled flush without any new change
+    *now += std::chrono::seconds(11);
+    flush = scheduled.back();
+    flush();
+    CHECK(updates == 2);
+    CHECK(scheduled.size() == 2);
+  }
+
+  WHEN("Report the allocations behind each update")
+  {
+    using Subsystem = rmf_task::AllocationCounter::Subsystem;
+    std::vector<rmf_task::AllocationCounter::Counts> reports;
+    rmf_task::Activator reporting_activator;
+    rmf_task_sequence::Task::add(
+      reporting_activator,
+      phase_activator,
+      []() { return std::chrono::steady_clock::now(); },
+      rmf_task_sequence::Task::BackupOptions(),
+      rmf_task_sequence::Task::UpdateOptions().allocation_report(
+        [&reports](const rmf_task::AllocationCounter::Counts& counts)
+        {
+          reports.push_back(counts);
+        }));
+
+    std::size_t updates = 0;
+    auto reporting_task = reporting_activator.activate(
+      []() { return rmf_task::State().time(std::chrono::steady_clock::now()); },
+      params,
+      rmf_task::Request(
+        "mock_request_01",
+        std::chrono::steady_clock::now(),
+        nullptr,
+        builder.build("Mock Task", "Mocking a task")),
+      [&updates](rmf_task::Phase::ConstSnapshotPtr) { ++updates; },
+      [](rmf_task::Task::Active::Backup) {},
+      [](rmf_task::Phase::ConstCompletedPtr) {},
+      []() {});
+    REQUIRE(reporting_task);
+
+    for (std::size_t i = 0; i < 3; ++i)
+      ctrl_1_0->active->update(rmf_task::Event::Status::Underway, "Moving");
+
+    // Every update gets exactly one report
+    REQUIRE(updates == 4);
+    REQUIRE(reports.size() == updates);
+
+    if (rmf_task::AllocationCounter::enabled())
+    {
+      // Each change logs an entry and makes a new snapshot of the event
+      CHECK(reports.back().allocations(Subsystem::Log) > 0);
+      CHECK(reports.back().allocations(Subsystem::Snapshot) > 0);
+    }
+    else
+    {
+      for (const auto& report : reports)
+        CHECK(report.total_allocations() == 0);
+    }
+  }
+
+  WHEN("Restore from a backup that was altered")
+  {
+    const auto request = rmf_task::Request(
+      "mock_request_01",
+      std::chrono::steady_clock::now(),
+      nullptr,
+      builder.build("Mock Task", "Mocking a task"));
+
+    const auto get_state = []()
+      {
+        return rmf_task::State().time(std::chrono::steady_clock::now());
+      };
+
+    const auto restore = [&](const nlohmann::json& backup_json)
+      {
+        return task_activator.restore(
+          get_state,
+          params,
+          request,
+          backup_json.dump(),
+          [](rmf_task::Phase::ConstSnapshotPtr) {},
+          [](rmf_task::Task::Active::Backup) {},
+          [](rmf_task::Phase::ConstCompletedPtr) {},
+          []() {});
+      };
+
+    // Backups from this library are stamped so that restoring them can skip
+    // validation
+    auto backup_json = nlohmann::json::parse(task->backup().state());
+    REQUIRE(backup_json.contains("stamp"));
+    auto trusted = restore(backup_json);
+    REQUIRE(trusted);
+    CHECK_FALSE(trusted->finished());
+
+    // A valid backup whose stamp no longer matches is validated and restored
+    backup_json["skip_phases"] = std::vector<uint64_t>();
+    auto altered = restore(backup_json);
+    REQUIRE(altered);
+    CHECK_FALSE(altered->finished());
+
+    // An invalid backup whose stamp no longer matches still fails validation
+    backup_json["current_phase"].erase("state");
+    auto invalid = restore(backup_json);
+    REQUIRE(invalid);
+    CHECK(invalid->finished());
+  }
+}
+
+//==============================================================================
+SCENARIO("Test Parallel Event Bundles")
+{
+  using Bundle = rmf_task_sequence::events::Bundle;
+  using Status = rmf_task::Event::Status;
+
+  const auto event_initializer =
+    std::make_shared<rmf_task_sequence::Event::Initializer>();
+  Bundle::add(event_initializer);
+  MockActivity::add(event_initializer);
+
+  auto ctrl_0 = std::make_shared<MockActivity::Controller>();
+  auto ctrl_1 = std::make_shared<MockActivity::Controller>();
+
+  const auto make_description =
+    [&](Bundle::Type type)
+    {
+      return Bundle::Description(
+        {
+          std::make_shared<MockActivity::Description>(ctrl_0),
+          std::make_shared<MockActivity::Description>(ctrl_1)
+        }, type);
+    };
+
+  const auto get_state = []() { return rmf_task::State(); };
+  const auto id = rmf_task::Event::AssignID::make();
+  std::size_t finished_counter = 0;
+
+  WHEN("All of the events must finish")
+  {
+    const auto description = make_description(Bundle::Type::ParallelAll);
+    const auto active = event_initializer->initialize(
+      id, get_state, nullptr, description, []() {})->begin(
+      []() {}, [&]() { ++finished_counter; });
+
+    // Both events begin right away
+    check_status({ctrl_0, ctrl_1}, Status::Underway);
+    CHECK(active->state()->status() == Status::Underway);
+
+    const auto backup = active->backup().release_state();
+    CHECK(backup["active_events"].size() == 2);
+
+    ctrl_0->active->complete();
+    CHECK(finished_counter == 0);
+    CHECK(active->state()->status() == Status::Underway);
+
+    // Only the branch that is still running gets restored
+    std::size_t restored_finished_counter = 0;
+    const auto restored = event_initializer->restore(
+      id, get_state, nullptr, description,
+      active->backup().release_state(),
+      []() {}, []() {}, [&]() { ++restored_finished_counter; });
+    CHECK(restored->state()->dependencies().size() == 1);
+    CHECK(restored->state()->status() == Status::Underway);
+
+    ctrl_1->active->complete();
+    CHECK(restored_finished_counter == 1);
+    CHECK(restored->state()->status() == Status::Completed);
+  }
+
+  WHEN("Any of the events may finish")
+  {
+    const auto description = make_description(Bundle::Type::ParallelAny);
+    const auto active = event_initializer->initialize(
+      id, get_state, nullptr, description,
+      []() {})->begin([]() {}, [&]() { ++finished_counter; });
+
+    check_status({ctrl_0, ctrl_1}, Status::Underway);
+    auto backup = active->backup().release_state();
+    CHECK_FALSE(backup.contains("winner"));
+
+    // The remaining event is canceled once the first one finishes
+    ctrl_1->active->complete();
+    CHECK(ctrl_0->active->state()->status() == Status::Canceled);
+    CHECK(finished_counter == 1);
+    CHECK(active->state()->status() == Status::Completed);
+
+    const auto finished_backup = active->backup().release_state();
+    REQUIRE(finished_backup.contains("winner"));
+    CHECK(finished_backup["winner"]["index"] == 1);
+    CHECK(finished_backup["winner"]["status"] == "completed");
+
+    // A bundle that is restored while its other branches are still being
+    // canceled keeps the outcome of the winner
+    backup["winner"] = finished_backup["winner"];
+    backup["active_events"].erase(1);
+    std::size_t restored_finished_counter = 0;
+    const auto restored = event_initializer->restore(
+      id, get_state, nullptr, description, backup,
+      []() {}, []() {}, [&]() { ++restored_finished_counter; });
+    CHECK(ctrl_0->active->state()->status() == Status::Canceled);
+    CHECK(restored_finished_counter == 1);
+    CHECK(restored->state()->status() == Status::Completed);
+  }
+
+  WHEN("The bundle is interrupted and canceled")
+  {
+    const auto active = event_initializer->initialize(
+      id, get_state, nullptr, make_description(Bundle::Type::ParallelAll),
+      []() {})->begin([]() {}, [&]() { ++finished_counter; });
+
+    std::size_t interrupted_counter = 0;
+    const auto resume = active->interrupt([&]() { ++interrupted_counter; });
+    CHECK(interrupted_counter == 1);
+    check_status({ctrl_0, ctrl_1}, Status::Standby);
+
+    resume();
+    check_status({ctrl_0, ctrl_1}, Status::Underway);
+
+    active->cancel();
+    check_status({ctrl_0, ctrl_1}, Status::Canceled);
+    CHECK(finished_counter == 1);
+    CHECK(active->state()->status() == Status::Canceled);
+  }
+}
+
+//==============================================================================
+namespace {
+// An event that is written as a script of other events
+class MockScript : public MockActivity::Description
+{
+public:
+
+  MockScript(std::vector<std::shared_ptr<MockActivity::Controller>> steps_)
+  : MockActivity::Description(steps_.front()),
+    steps(std::move(steps_))
+  {
+    // Do nothing
+  }
+
+  std::vector<std::shared_ptr<MockActivity::Controller>> steps;
+};
+} // anonymous namespace
+
+//==============================================================================
+SCENARIO("Test Unfolded Event Scripts")
+{
+  using Bundle = rmf_task_sequence::events::Bundle;
+  using Status = rmf_task::Event::Status;
+
+  const auto event_initializer =
+    std::make_shared<rmf_task_sequence::Event::Initializer>();
+  Bundle::add(event_initializer);
+  MockActivity::add(event_initializer);
+  Bundle::unfold<MockScript>(
+    [](const MockScript& script)
+    {
+      Bundle::Description::Dependencies steps;
+      for (const auto& ctrl : script.steps)
+        steps.push_back(std::make_shared<MockActivity::Description>(ctrl));
+
+      return Bundle::Description(std::move(steps), Bundle::Type::Sequence);
+    }, *event_initializer, event_initializer);
+
+  auto ctrl_0 = std::make_shared<MockActivity::Controller>();
+  auto ctrl_1 = std::make_shared<MockActivity::Controller>();
+  auto ctrl_2 = std::make_shared<MockActivity::Controller>();
+  const MockScript script({ctrl_0, ctrl_1, ctrl_2});
+
+  const auto get_state = []() { return rmf_task::State(); };
+  const auto id = rmf_task::Event::AssignID::make();
+  std::size_t finished_counter = 0;
+
+  const auto standby = event_initializer->initialize(
+    id, get_state, nullptr, script, []() {});
+  CHECK(standby->state()->dependencies().size() == 3);
+  CHECK(standby->state()->status() == Status::Standby);
+
+  const auto active = standby->begin([]() {}, [&]() { ++finished_counter; });
+  check_status({ctrl_0}, Status::Underway);
+  check_inactive({ctrl_1, ctrl_2});
+
+  ctrl_0->active->complete();
+  check_status({ctrl_1}, Status::Underway);
+  check_inactive({ctrl_2});
+  check_statuses(
+    active->state()->dependencies(),
+    {Status::Completed, Status::Underway, Status::Standby});
+
+  // The script resumes from the step that it was on
+  std::size_t restored_finished_counter = 0;
+  const auto restored = event_initializer->restore(
+    id, get_state, nullptr, script, active->backup().release_state(),
+    []() {}, []() {}, [&]() { ++restored_finished_counter; });
+  check_inactive({ctrl_2});
+  check_statuses(
+    restored->state()->dependencies(),
+    {Status::Underway, Status::Standby});
+
+  ctrl_1->active->complete();
+  check_status({ctrl_2}, Status::Underway);
+  ctrl_2->active->complete();
+  CHECK(restored_finished_counter == 1);
+  CHECK(restored->state()->status() == Status::Completed);
+}
+
+//==============================================================================
+SCENARIO("Test Bundle Headers")
+{
+  using Bundle = rmf_task_sequence::events::Bundle;
+
+  auto battery_system = rmf_battery::agv::BatterySystem::make(24.0, 40.0, 8.8);
+  auto mechanical_system =
+    rmf_battery::agv::MechanicalSystem::make(70.0, 40.0, 0.22);
+  auto power_system = rmf_battery::agv::PowerSystem::make(20.0);
+
+  const rmf_task::Parameters parameters(
+    nullptr,
+    *battery_system,
+    std::make_shared<rmf_battery::agv::SimpleMotionPowerSink>(
+      *battery_system, *mechanical_system),
+    std::make_shared<rmf_battery::agv::SimpleDevicePowerSink>(
+      *battery_system, *power_system));
+
+  const auto ctrl = std::make_shared<MockActivity::Controller>();
+  const auto inner = std::make_shared<Bundle::Description>(
+    Bundle::Description::Dependencies{
+      std::make_shared<MockActivity::Description>(ctrl),
+      std::make_shared<MockActivity::Description>(ctrl)
+    }, Bundle::Type::Sequence);
+
+  const Bundle::Description outer(
+    {inner, std::make_shared<MockActivity::Description>(ctrl)},
+    Bundle::Type::Sequence);
+
+  const auto state = rmf_task::State().time(std::chrono::steady_clock::now());
+
+  const auto inner_header = inner->generate_header(state, parameters);
+  CHECK(inner_header.detail_is_json());
+
+  // The detail of the inner bundle is nested as JSON instead of as a string
+  const auto header = outer.generate_header(state, parameters);
+  REQUIRE(header.detail_is_json());
+  const auto detail = nlohmann::json::parse(header.detail());
+  REQUIRE(detail.size() == 2);
+  CHECK(detail[0]["detail"].is_array());
+  CHECK(detail[0]["detail"].size() == 2);
+  CHECK(detail[1]["detail"] == "Mocking an activity");
+
+  // An explicit detail is passed along as a plain string
+  const Bundle::Description custom(
+    {inner}, Bundle::Type::Sequence, std::nullopt, "Custom detail");
+  const auto custom_header = custom.generate_header(state, parameters);
+  CHECK_FALSE(custom_header.detail_is_json());
+  CHECK(custom_header.detail() == "Custom detail");
 }